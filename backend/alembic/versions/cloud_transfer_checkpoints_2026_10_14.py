@@ -0,0 +1,42 @@
+"""add cloud_transfer_checkpoints (resume journal for cloud import/export)
+
+Revision ID: cloud_transfer_checkpoints_2026_10_14
+Revises: workload_benchmarks_2026_10_14
+Create Date: 2026-10-14
+
+Per-file checkpoints of the parallel cloud transfer engine
+(services/cloud/transfer.py): completed files and, for large files, the
+parts already written, so an interrupted job resumes where it stopped.
+"""
+from typing import Sequence, Union
+
+from alembic import op
+import sqlalchemy as sa
+
+
+revision: str = 'cloud_transfer_checkpoints_2026_10_14'
+down_revision: Union[str, Sequence[str], None] = 'workload_benchmarks_2026_10_14'
+branch_labels: Union[str, Sequence[str], None] = None
+depends_on: Union[str, Sequence[str], None] = None
+
+
+def upgrade() -> None:
+    op.create_table(
+        'cloud_transfer_checkpoints',
+        sa.Column('id', sa.Integer(), nullable=False),
+        sa.Column('job_kind', sa.String(10), nullable=False),
+        sa.Column('job_id', sa.Integer(), nullable=False),
+        sa.Column('rel_path', sa.String(1000), nullable=False),
+        sa.Column('size_bytes', sa.BigInteger(), nullable=False, server_default='0'),
+        sa.Column('completed', sa.Boolean(), nullable=False, server_default=sa.false()),
+        sa.Column('parts_done', sa.Text(), nullable=True),
+        sa.Column('updated_at', sa.DateTime(timezone=True), server_default=sa.func.now(), nullable=False),
+        sa.PrimaryKeyConstraint('id'),
+        sa.UniqueConstraint('job_kind', 'job_id', 'rel_path', name='uq_cloud_checkpoint_job_path'),
+    )
+    op.create_index('ix_cloud_transfer_checkpoints_id', 'cloud_transfer_checkpoints', ['id'])
+
+
+def downgrade() -> None:
+    op.drop_index('ix_cloud_transfer_checkpoints_id', table_name='cloud_transfer_checkpoints')
+    op.drop_table('cloud_transfer_checkpoints')
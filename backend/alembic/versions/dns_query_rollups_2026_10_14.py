@@ -0,0 +1,76 @@
+"""add per-hour dns query rollups (domain/client) and hourly stat weight
+
+Revision ID: dns_query_rollups_2026_10_14
+Revises: monitoring_rollups_2026_10_14
+Create Date: 2026-10-14
+
+The collector now maintains these incrementally per batch
+(services/pihole/query_ingest.py); existing dns_queries rows are folded in
+once here so the top-N endpoints keep their history.
+"""
+from typing import Sequence, Union
+
+from alembic import op
+import sqlalchemy as sa
+
+
+revision: str = 'dns_query_rollups_2026_10_14'
+down_revision: Union[str, Sequence[str], None] = 'monitoring_rollups_2026_10_14'
+branch_labels: Union[str, Sequence[str], None] = None
+depends_on: Union[str, Sequence[str], None] = None
+
+ROLLUPS = (
+    ('dns_query_domain_hourly', 'domain', 253),
+    ('dns_query_client_hourly', 'client', 45),
+)
+
+
+def upgrade() -> None:
+    bind = op.get_bind()
+    if bind.dialect.name == 'postgresql':
+        hour_expr = "date_trunc('hour', \"timestamp\")"
+    else:
+        hour_expr = "strftime('%Y-%m-%d %H:00:00.000000', \"timestamp\")"
+
+    for table, key, length in ROLLUPS:
+        op.create_table(
+            table,
+            sa.Column('hour', sa.DateTime(), nullable=False),
+            sa.Column(key, sa.String(length=length), nullable=False),
+            sa.Column('total_queries', sa.Integer(), nullable=False),
+            sa.Column('blocked_queries', sa.Integer(), nullable=False),
+            sa.PrimaryKeyConstraint('hour', key),
+        )
+        op.execute(
+            f"""
+            INSERT INTO {table} (hour, {key}, total_queries, blocked_queries)
+            SELECT {hour_expr}, {key}, COUNT(*),
+                   SUM(CASE WHEN status = 'BLOCKED' THEN 1 ELSE 0 END)
+            FROM dns_queries
+            GROUP BY 1, 2
+            """
+        )
+
+    op.add_column(
+        'dns_query_hourly_stats',
+        sa.Column('timed_queries', sa.Integer(), nullable=False, server_default='0'),
+    )
+    if bind.dialect.name == 'postgresql':
+        op.execute(
+            """
+            UPDATE dns_query_hourly_stats s
+            SET timed_queries = q.n
+            FROM (
+                SELECT date_trunc('hour', "timestamp") AS hour, COUNT(response_time_ms) AS n
+                FROM dns_queries
+                GROUP BY 1
+            ) q
+            WHERE s.hour = q.hour
+            """
+        )
+
+
+def downgrade() -> None:
+    op.drop_column('dns_query_hourly_stats', 'timed_queries')
+    for table, _key, _length in reversed(ROLLUPS):
+        op.drop_table(table)
@@ -0,0 +1,131 @@
+"""add file search index (file_search_index)
+
+Revision ID: file_search_index_2026_10_14
+Revises: dns_query_rollups_2026_10_14
+Create Date: 2026-10-14
+
+One row per file_metadata row (services/files/search.py). PostgreSQL gets
+pg_trgm GIN indexes for substring/fuzzy name and path matches and a GIN
+full-text index on the extracted text; existing metadata is copied in.
+"""
+from typing import Sequence, Union
+
+from alembic import op
+import sqlalchemy as sa
+
+
+revision: str = 'file_search_index_2026_10_14'
+down_revision: Union[str, Sequence[str], None] = 'dns_query_rollups_2026_10_14'
+branch_labels: Union[str, Sequence[str], None] = None
+depends_on: Union[str, Sequence[str], None] = None
+
+BATCH = 5000
+MAX_EXTENSION_LENGTH = 32
+
+
+def _extension(name: str, is_directory: bool):
+    dot = name.rfind('.')
+    if is_directory or dot <= 0 or dot == len(name) - 1:
+        return None
+    ext = name[dot + 1:].casefold()
+    return ext if len(ext) <= MAX_EXTENSION_LENGTH else None
+
+
+def upgrade() -> None:
+    bind = op.get_bind()
+    postgres = bind.dialect.name == 'postgresql'
+
+    index = op.create_table(
+        'file_search_index',
+        sa.Column('file_id', sa.Integer(), nullable=False),
+        sa.Column('owner_id', sa.Integer(), nullable=False),
+        sa.Column('path', sa.String(length=1000), nullable=False),
+        sa.Column('name', sa.String(length=255), nullable=False),
+        sa.Column('path_folded', sa.String(length=1000), nullable=False),
+        sa.Column('name_folded', sa.String(length=255), nullable=False),
+        sa.Column('extension', sa.String(length=32), nullable=True),
+        sa.Column('is_directory', sa.Boolean(), nullable=False, server_default=sa.false()),
+        sa.Column('size_bytes', sa.BigInteger(), nullable=False, server_default='0'),
+        sa.Column('mime_type', sa.String(length=100), nullable=True),
+        sa.Column('modified_at', sa.DateTime(timezone=True), nullable=True),
+        sa.Column('content', sa.Text(), nullable=True),
+        sa.ForeignKeyConstraint(['file_id'], ['file_metadata.id'], ondelete='CASCADE'),
+        sa.ForeignKeyConstraint(['owner_id'], ['users.id'], ondelete='CASCADE'),
+        sa.PrimaryKeyConstraint('file_id'),
+    )
+
+    # Copy before indexing: bulk inserts into an unindexed table are cheaper
+    metadata = sa.table(
+        'file_metadata',
+        sa.column('id', sa.Integer()), sa.column('owner_id', sa.Integer()),
+        sa.column('path', sa.String()), sa.column('name', sa.String()),
+        sa.column('is_directory', sa.Boolean()), sa.column('size_bytes', sa.BigInteger()),
+        sa.column('mime_type', sa.String()), sa.column('created_at', sa.DateTime()),
+        sa.column('updated_at', sa.DateTime()),
+    )
+    last_id = 0
+    while True:
+        rows = bind.execute(
+            sa.select(metadata).where(metadata.c.id > last_id).order_by(metadata.c.id).limit(BATCH)
+        ).all()
+        if not rows:
+            break
+        op.bulk_insert(index, [
+            {
+                'file_id': r.id,
+                'owner_id': r.owner_id,
+                'path': r.path,
+                'name': r.name,
+                'path_folded': r.path.casefold(),
+                'name_folded': r.name.casefold(),
+                'extension': _extension(r.name, r.is_directory),
+                'is_directory': bool(r.is_directory),
+                'size_bytes': r.size_bytes or 0,
+                'mime_type': r.mime_type,
+                'modified_at': r.updated_at or r.created_at,
+            }
+            for r in rows
+        ])
+        last_id = rows[-1].id
+
+    if postgres:
+        op.create_index('ix_file_search_name_prefix', 'file_search_index', ['name_folded'],
+                        postgresql_ops={'name_folded': 'text_pattern_ops'})
+        op.create_index('ix_file_search_path_prefix', 'file_search_index', ['path_folded'],
+                        postgresql_ops={'path_folded': 'text_pattern_ops'})
+    else:
+        op.create_index('ix_file_search_name_prefix', 'file_search_index', ['name_folded'])
+        op.create_index('ix_file_search_path_prefix', 'file_search_index', ['path_folded'])
+    op.create_index('ix_file_search_owner_name', 'file_search_index', ['owner_id', 'name_folded'])
+    op.create_index('ix_file_search_extension', 'file_search_index', ['extension'])
+    op.create_index('ix_file_search_modified', 'file_search_index', ['modified_at'])
+    op.create_index('ix_file_search_size', 'file_search_index', ['size_bytes'])
+
+    if postgres:
+        op.execute('CREATE EXTENSION IF NOT EXISTS pg_trgm')
+        op.execute(
+            'CREATE INDEX ix_file_search_name_trgm ON file_search_index '
+            'USING gin (name_folded gin_trgm_ops)'
+        )
+        op.execute(
+            'CREATE INDEX ix_file_search_path_trgm ON file_search_index '
+            'USING gin (path_folded gin_trgm_ops)'
+        )
+        # Expression must match services/files/search.py exactly to be used
+        op.execute(
+            'CREATE INDEX ix_file_search_content_fts ON file_search_index '
+            "USING gin (to_tsvector('simple'::regconfig, coalesce(content, '')))"
+        )
+
+
+def downgrade() -> None:
+    if op.get_bind().dialect.name == 'postgresql':
+        op.execute('DROP INDEX IF EXISTS ix_file_search_content_fts')
+        op.execute('DROP INDEX IF EXISTS ix_file_search_path_trgm')
+        op.execute('DROP INDEX IF EXISTS ix_file_search_name_trgm')
+    for name in (
+        'ix_file_search_size', 'ix_file_search_modified', 'ix_file_search_extension',
+        'ix_file_search_owner_name', 'ix_file_search_path_prefix', 'ix_file_search_name_prefix',
+    ):
+        op.drop_index(name, table_name='file_search_index')
+    op.drop_table('file_search_index')
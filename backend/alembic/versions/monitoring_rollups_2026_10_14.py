@@ -0,0 +1,73 @@
+"""add monitoring rollup tiers (metric_rollups_1m/15m/1h)
+
+Revision ID: monitoring_rollups_2026_10_14
+Revises: sync_change_journal_2026_10_14
+Create Date: 2026-10-14
+
+On PostgreSQL the tables are range-partitioned on bucket_start; partitions
+are created on demand by services/monitoring/rollups.py and dropped by its
+retention. SQLite gets plain tables.
+"""
+from typing import Sequence, Union
+
+from alembic import op
+import sqlalchemy as sa
+
+
+revision: str = 'monitoring_rollups_2026_10_14'
+down_revision: Union[str, Sequence[str], None] = 'sync_change_journal_2026_10_14'
+branch_labels: Union[str, Sequence[str], None] = None
+depends_on: Union[str, Sequence[str], None] = None
+
+TIERS = ('1m', '15m', '1h')
+
+
+def upgrade() -> None:
+    bind = op.get_bind()
+    for tier in TIERS:
+        table = f'metric_rollups_{tier}'
+        if bind.dialect.name == 'postgresql':
+            op.execute(
+                f"""
+                CREATE TABLE {table} (
+                    metric VARCHAR(16) NOT NULL,
+                    series VARCHAR(64) NOT NULL,
+                    field VARCHAR(32) NOT NULL,
+                    bucket_start TIMESTAMP WITHOUT TIME ZONE NOT NULL,
+                    sample_count INTEGER NOT NULL,
+                    value_min DOUBLE PRECISION NOT NULL,
+                    value_max DOUBLE PRECISION NOT NULL,
+                    value_sum DOUBLE PRECISION NOT NULL,
+                    value_p95 DOUBLE PRECISION NOT NULL,
+                    PRIMARY KEY (metric, series, field, bucket_start)
+                ) PARTITION BY RANGE (bucket_start)
+                """
+            )
+            op.execute(f'CREATE INDEX ix_{table}_bucket_brin ON {table} USING brin (bucket_start)')
+        else:
+            op.create_table(
+                table,
+                sa.Column('metric', sa.String(length=16), nullable=False),
+                sa.Column('series', sa.String(length=64), nullable=False),
+                sa.Column('field', sa.String(length=32), nullable=False),
+                sa.Column('bucket_start', sa.DateTime(), nullable=False),
+                sa.Column('sample_count', sa.Integer(), nullable=False),
+                sa.Column('value_min', sa.Float(), nullable=False),
+                sa.Column('value_max', sa.Float(), nullable=False),
+                sa.Column('value_sum', sa.Float(), nullable=False),
+                sa.Column('value_p95', sa.Float(), nullable=False),
+                sa.PrimaryKeyConstraint('metric', 'series', 'field', 'bucket_start'),
+            )
+            op.create_index(f'ix_{table}_bucket_brin', table, ['bucket_start'])
+
+
+def downgrade() -> None:
+    bind = op.get_bind()
+    for tier in reversed(TIERS):
+        table = f'metric_rollups_{tier}'
+        if bind.dialect.name == 'postgresql':
+            # Dropping the parent drops all its partitions
+            op.execute(f'DROP TABLE IF EXISTS {table} CASCADE')
+        else:
+            op.drop_index(f'ix_{table}_bucket_brin', table_name=table)
+            op.drop_table(table)
@@ -0,0 +1,65 @@
+"""add ownership_transfer_jobs and a prefix index on file_metadata.path
+
+Revision ID: ownership_transfer_jobs_2026_10_15
+Revises: cloud_transfer_checkpoints_2026_10_14
+Create Date: 2026-10-15
+
+Bulk ownership transfers (services/files/ownership_jobs.py) rewrite a
+subtree in resumable batches tracked in ownership_transfer_jobs. Their
+``path LIKE 'prefix/%'`` selects need a text_pattern_ops index on
+PostgreSQL; the existing unique index uses the database collation and
+cannot serve prefix matches.
+"""
+from typing import Sequence, Union
+
+from alembic import op
+import sqlalchemy as sa
+
+
+revision: str = 'ownership_transfer_jobs_2026_10_15'
+down_revision: Union[str, Sequence[str], None] = 'cloud_transfer_checkpoints_2026_10_14'
+branch_labels: Union[str, Sequence[str], None] = None
+depends_on: Union[str, Sequence[str], None] = None
+
+
+def upgrade() -> None:
+    op.create_table(
+        'ownership_transfer_jobs',
+        sa.Column('id', sa.Integer(), nullable=False),
+        sa.Column('file_id', sa.Integer(), nullable=False),
+        sa.Column('source_path', sa.String(1000), nullable=False),
+        sa.Column('target_path', sa.String(1000), nullable=False),
+        sa.Column('old_owner_id', sa.Integer(), nullable=False),
+        sa.Column('new_owner_id', sa.Integer(), nullable=False),
+        sa.Column('requested_by', sa.Integer(), nullable=False),
+        sa.Column('physical_move', sa.Boolean(), nullable=False, server_default=sa.true()),
+        sa.Column('status', sa.String(20), nullable=False, server_default='pending'),
+        sa.Column('total_items', sa.Integer(), nullable=False, server_default='0'),
+        sa.Column('processed_items', sa.Integer(), nullable=False, server_default='0'),
+        sa.Column('last_file_id', sa.Integer(), nullable=False, server_default='0'),
+        sa.Column('max_file_id', sa.Integer(), nullable=False, server_default='0'),
+        sa.Column('error_message', sa.Text(), nullable=True),
+        sa.Column('created_at', sa.DateTime(timezone=True), server_default=sa.func.now(), nullable=False),
+        sa.Column('started_at', sa.DateTime(timezone=True), nullable=True),
+        sa.Column('completed_at', sa.DateTime(timezone=True), nullable=True),
+        sa.ForeignKeyConstraint(['file_id'], ['file_metadata.id'], ondelete='CASCADE'),
+        sa.ForeignKeyConstraint(['old_owner_id'], ['users.id']),
+        sa.ForeignKeyConstraint(['new_owner_id'], ['users.id']),
+        sa.ForeignKeyConstraint(['requested_by'], ['users.id']),
+        sa.PrimaryKeyConstraint('id'),
+    )
+    op.create_index('ix_ownership_transfer_jobs_id', 'ownership_transfer_jobs', ['id'])
+    op.create_index('ix_ownership_transfer_jobs_status', 'ownership_transfer_jobs', ['status'])
+
+    if op.get_bind().dialect.name == 'postgresql':
+        op.create_index('ix_file_metadata_path_prefix', 'file_metadata', ['path'],
+                        postgresql_ops={'path': 'text_pattern_ops'})
+    else:
+        op.create_index('ix_file_metadata_path_prefix', 'file_metadata', ['path'])
+
+
+def downgrade() -> None:
+    op.drop_index('ix_file_metadata_path_prefix', table_name='file_metadata')
+    op.drop_index('ix_ownership_transfer_jobs_status', table_name='ownership_transfer_jobs')
+    op.drop_index('ix_ownership_transfer_jobs_id', table_name='ownership_transfer_jobs')
+    op.drop_table('ownership_transfer_jobs')
@@ -0,0 +1,65 @@
+"""add ssd_cache_entries.eviction_priority + ordered eviction indexes
+
+Revision ID: ssd_cache_lfru_2026_10_14
+Revises: dcabe4cc2ebc
+Create Date: 2026-10-14
+
+"""
+import math
+from datetime import timezone
+from typing import Sequence, Union
+
+from alembic import op
+import sqlalchemy as sa
+
+
+revision: str = 'ssd_cache_lfru_2026_10_14'
+down_revision: Union[str, Sequence[str], None] = 'dcabe4cc2ebc'
+branch_labels: Union[str, Sequence[str], None] = None
+depends_on: Union[str, Sequence[str], None] = None
+
+# Frozen copy of app.models.ssd_file_cache.LFRU_HALF_LIFE_SECONDS
+_HALF_LIFE_SECONDS = 6 * 3600
+
+
+def upgrade() -> None:
+    op.add_column(
+        'ssd_cache_entries',
+        sa.Column('eviction_priority', sa.Float(), nullable=False, server_default='0'),
+    )
+
+    bind = op.get_bind()
+    rows = bind.execute(
+        sa.text("SELECT id, access_count, last_accessed FROM ssd_cache_entries")
+    ).fetchall()
+    params = []
+    for row_id, count, last in rows:
+        if last is not None and last.tzinfo is None:
+            last = last.replace(tzinfo=timezone.utc)
+        stamp = last.timestamp() if last is not None else 0.0
+        params.append({
+            "id": row_id,
+            "p": math.log2(1 + max(int(count or 0), 0)) + stamp / _HALF_LIFE_SECONDS,
+        })
+    if params:
+        bind.execute(
+            sa.text("UPDATE ssd_cache_entries SET eviction_priority = :p WHERE id = :id"),
+            params,
+        )
+
+    op.create_index(
+        'idx_ssd_cache_lfru',
+        'ssd_cache_entries',
+        ['array_name', 'is_valid', 'eviction_priority'],
+    )
+    op.create_index(
+        'idx_ssd_cache_lru',
+        'ssd_cache_entries',
+        ['array_name', 'is_valid', 'last_accessed'],
+    )
+
+
+def downgrade() -> None:
+    op.drop_index('idx_ssd_cache_lru', table_name='ssd_cache_entries')
+    op.drop_index('idx_ssd_cache_lfru', table_name='ssd_cache_entries')
+    op.drop_column('ssd_cache_entries', 'eviction_priority')
@@ -0,0 +1,42 @@
+"""add sync change journal (sync_changes)
+
+Revision ID: sync_change_journal_2026_10_14
+Revises: vcl_chunk_codec_2026_10_14
+Create Date: 2026-10-14
+
+"""
+from typing import Sequence, Union
+
+from alembic import op
+import sqlalchemy as sa
+
+
+revision: str = 'sync_change_journal_2026_10_14'
+down_revision: Union[str, Sequence[str], None] = 'vcl_chunk_codec_2026_10_14'
+branch_labels: Union[str, Sequence[str], None] = None
+depends_on: Union[str, Sequence[str], None] = None
+
+
+def upgrade() -> None:
+    op.create_table(
+        'sync_changes',
+        sa.Column('id', sa.BigInteger().with_variant(sa.Integer(), 'sqlite'), autoincrement=True, nullable=False),
+        sa.Column('owner_id', sa.Integer(), nullable=False),
+        sa.Column('action', sa.String(length=16), nullable=False),
+        sa.Column('path', sa.String(length=1000), nullable=False),
+        sa.Column('old_path', sa.String(length=1000), nullable=True),
+        sa.Column('is_directory', sa.Boolean(), nullable=False, server_default=sa.false()),
+        sa.Column('size_bytes', sa.BigInteger(), nullable=True),
+        sa.Column('checksum', sa.String(length=64), nullable=True),
+        sa.Column('created_at', sa.DateTime(timezone=True), server_default=sa.text('CURRENT_TIMESTAMP'), nullable=False),
+        sa.ForeignKeyConstraint(['owner_id'], ['users.id'], ondelete='CASCADE'),
+        sa.PrimaryKeyConstraint('id'),
+    )
+    op.create_index('idx_sync_changes_owner_cursor', 'sync_changes', ['owner_id', 'id'])
+    op.create_index('ix_sync_changes_created_at', 'sync_changes', ['created_at'])
+
+
+def downgrade() -> None:
+    op.drop_index('ix_sync_changes_created_at', table_name='sync_changes')
+    op.drop_index('idx_sync_changes_owner_cursor', table_name='sync_changes')
+    op.drop_table('sync_changes')
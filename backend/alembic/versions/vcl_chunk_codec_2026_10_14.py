@@ -0,0 +1,29 @@
+"""add vcl_chunks.codec (per-chunk compression codec)
+
+Revision ID: vcl_chunk_codec_2026_10_14
+Revises: vcl_chunk_store_2026_10_14
+Create Date: 2026-10-14
+
+"""
+from typing import Sequence, Union
+
+from alembic import op
+import sqlalchemy as sa
+
+
+revision: str = 'vcl_chunk_codec_2026_10_14'
+down_revision: Union[str, Sequence[str], None] = 'vcl_chunk_store_2026_10_14'
+branch_labels: Union[str, Sequence[str], None] = None
+depends_on: Union[str, Sequence[str], None] = None
+
+
+def upgrade() -> None:
+    # Existing chunks (and version_blobs.storage_format rows) are gzip
+    op.add_column(
+        'vcl_chunks',
+        sa.Column('codec', sa.String(length=16), nullable=False, server_default='gzip'),
+    )
+
+
+def downgrade() -> None:
+    op.drop_column('vcl_chunks', 'codec')
@@ -0,0 +1,55 @@
+"""add VCL content-defined chunk store (vcl_chunks, vcl_blob_chunks)
+
+Revision ID: vcl_chunk_store_2026_10_14
+Revises: ssd_cache_lfru_2026_10_14
+Create Date: 2026-10-14
+
+"""
+from typing import Sequence, Union
+
+from alembic import op
+import sqlalchemy as sa
+
+
+revision: str = 'vcl_chunk_store_2026_10_14'
+down_revision: Union[str, Sequence[str], None] = 'ssd_cache_lfru_2026_10_14'
+branch_labels: Union[str, Sequence[str], None] = None
+depends_on: Union[str, Sequence[str], None] = None
+
+
+def upgrade() -> None:
+    op.add_column(
+        'version_blobs',
+        sa.Column('storage_format', sa.String(length=16), nullable=False, server_default='gzip'),
+    )
+
+    op.create_table(
+        'vcl_chunks',
+        sa.Column('id', sa.Integer(), nullable=False),
+        sa.Column('checksum', sa.String(length=64), nullable=False),
+        sa.Column('original_size', sa.Integer(), nullable=False),
+        sa.Column('compressed_size', sa.Integer(), nullable=False),
+        sa.Column('reference_count', sa.Integer(), nullable=False, server_default='0'),
+        sa.Column('created_at', sa.DateTime(), nullable=False),
+        sa.PrimaryKeyConstraint('id'),
+    )
+    op.create_index('ix_vcl_chunks_checksum', 'vcl_chunks', ['checksum'], unique=True)
+
+    op.create_table(
+        'vcl_blob_chunks',
+        sa.Column('blob_id', sa.Integer(), nullable=False),
+        sa.Column('seq', sa.Integer(), nullable=False),
+        sa.Column('chunk_id', sa.Integer(), nullable=False),
+        sa.ForeignKeyConstraint(['blob_id'], ['version_blobs.id'], ondelete='CASCADE'),
+        sa.ForeignKeyConstraint(['chunk_id'], ['vcl_chunks.id']),
+        sa.PrimaryKeyConstraint('blob_id', 'seq'),
+    )
+    op.create_index('ix_vcl_blob_chunks_chunk_id', 'vcl_blob_chunks', ['chunk_id'])
+
+
+def downgrade() -> None:
+    op.drop_index('ix_vcl_blob_chunks_chunk_id', table_name='vcl_blob_chunks')
+    op.drop_table('vcl_blob_chunks')
+    op.drop_index('ix_vcl_chunks_checksum', table_name='vcl_chunks')
+    op.drop_table('vcl_chunks')
+    op.drop_column('version_blobs', 'storage_format')
@@ -0,0 +1,91 @@
+"""add workload benchmark tables (workload_benchmarks, workload_results)
+
+Revision ID: workload_benchmarks_2026_10_14
+Revises: file_search_index_2026_10_14
+Create Date: 2026-10-14
+
+End-to-end benchmark runs (services/benchmark/suite.py) with version and
+hardware fingerprints, plus one result row per workload. The status column
+reuses the benchmarkstatus enum type created for disk_benchmarks.
+"""
+from typing import Sequence, Union
+
+from alembic import op
+import sqlalchemy as sa
+from sqlalchemy.dialects import postgresql
+
+
+revision: str = 'workload_benchmarks_2026_10_14'
+down_revision: Union[str, Sequence[str], None] = 'file_search_index_2026_10_14'
+branch_labels: Union[str, Sequence[str], None] = None
+depends_on: Union[str, Sequence[str], None] = None
+
+
+def upgrade() -> None:
+    benchmark_status = postgresql.ENUM(
+        'pending', 'running', 'completed', 'failed', 'cancelled',
+        name='benchmarkstatus', create_type=False,
+    )
+
+    op.create_table(
+        'workload_benchmarks',
+        sa.Column('id', sa.Integer(), nullable=False),
+        sa.Column('profile', sa.String(32), nullable=False),
+        sa.Column('status', benchmark_status, nullable=False),
+        sa.Column('progress_percent', sa.Float(), nullable=False, server_default='0.0'),
+        sa.Column('current_workload', sa.String(64), nullable=True),
+        sa.Column('error_message', sa.String(1024), nullable=True),
+        sa.Column('created_at', sa.DateTime(), nullable=False),
+        sa.Column('started_at', sa.DateTime(), nullable=True),
+        sa.Column('completed_at', sa.DateTime(), nullable=True),
+        sa.Column('duration_seconds', sa.Float(), nullable=True),
+        sa.Column('app_version', sa.String(64), nullable=True),
+        sa.Column('app_commit', sa.String(64), nullable=True),
+        sa.Column('hardware_fingerprint', sa.String(64), nullable=True),
+        sa.Column('environment_json', sa.Text(), nullable=True),
+        sa.Column('baseline_id', sa.Integer(), nullable=True),
+        sa.Column('regressions', sa.Integer(), nullable=True),
+        sa.Column('user_id', sa.Integer(), nullable=True),
+        sa.ForeignKeyConstraint(['baseline_id'], ['workload_benchmarks.id'], ondelete='SET NULL'),
+        sa.ForeignKeyConstraint(['user_id'], ['users.id']),
+        sa.PrimaryKeyConstraint('id'),
+    )
+    op.create_index('ix_workload_benchmarks_id', 'workload_benchmarks', ['id'])
+    op.create_index('ix_workload_benchmarks_status', 'workload_benchmarks', ['status'])
+    op.create_index(
+        'ix_workload_benchmarks_hardware_fingerprint', 'workload_benchmarks', ['hardware_fingerprint']
+    )
+
+    op.create_table(
+        'workload_results',
+        sa.Column('id', sa.Integer(), nullable=False),
+        sa.Column('benchmark_id', sa.Integer(), nullable=False),
+        sa.Column('workload', sa.String(64), nullable=False),
+        sa.Column('status', sa.String(16), nullable=False),
+        sa.Column('detail', sa.String(512), nullable=True),
+        sa.Column('samples', sa.Integer(), nullable=False, server_default='0'),
+        sa.Column('errors', sa.Integer(), nullable=False, server_default='0'),
+        sa.Column('bytes_total', sa.BigInteger(), nullable=True),
+        sa.Column('elapsed_seconds', sa.Float(), nullable=True),
+        sa.Column('throughput_mbps', sa.Float(), nullable=True),
+        sa.Column('ops_per_second', sa.Float(), nullable=True),
+        sa.Column('latency_p50_ms', sa.Float(), nullable=True),
+        sa.Column('latency_p95_ms', sa.Float(), nullable=True),
+        sa.Column('latency_p99_ms', sa.Float(), nullable=True),
+        sa.Column('latency_max_ms', sa.Float(), nullable=True),
+        sa.ForeignKeyConstraint(['benchmark_id'], ['workload_benchmarks.id'], ondelete='CASCADE'),
+        sa.PrimaryKeyConstraint('id'),
+    )
+    op.create_index('ix_workload_results_id', 'workload_results', ['id'])
+    op.create_index('ix_workload_results_benchmark_id', 'workload_results', ['benchmark_id'])
+
+
+def downgrade() -> None:
+    op.drop_index('ix_workload_results_benchmark_id', table_name='workload_results')
+    op.drop_index('ix_workload_results_id', table_name='workload_results')
+    op.drop_table('workload_results')
+    op.drop_index('ix_workload_benchmarks_hardware_fingerprint', table_name='workload_benchmarks')
+    op.drop_index('ix_workload_benchmarks_status', table_name='workload_benchmarks')
+    op.drop_index('ix_workload_benchmarks_id', table_name='workload_benchmarks')
+    op.drop_table('workload_benchmarks')
+    # benchmarkstatus belongs to disk_benchmarks and is left in place
@@ -9,6 +9,7 @@ from sqlalchemy.orm import Session
 
 from app.core.config import settings
 from app.core.database import get_db
+from app.core.decision_cache import get_decision_cache
 from app.schemas.auth import TokenPayload
 from app.schemas.user import UserPublic
 from app.services import auth as auth_service
@@ -28,6 +29,21 @@ def get_audit_logger():
     return get_audit_logger_db()
 
 
+def _resolve_active_user(user_id: int | str, db: Session) -> Optional[UserPublic]:
+    """The active user *user_id*, through the per-worker decision cache.
+
+    None if the user does not exist or is inactive; callers that need to know
+    which (for the audit log) look the row up themselves.
+    """
+    def load() -> Optional[UserPublic]:
+        user = user_service.get_user(user_id, db=db)
+        if not user or not user.is_active:
+            return None
+        return user_service.serialize_user(user)
+
+    return get_decision_cache().get_or_load("user", user_id, load)
+
+
 async def get_current_user(
     request: Request,
     token: Optional[str] = Depends(oauth2_scheme),
@@ -47,8 +63,8 @@ async def get_current_user(
     if token.startswith("balu_"):
         from app.services.api_key_service import ApiKeyService
 
-        api_key = ApiKeyService.validate_api_key(db, token)
-        if not api_key:
+        grant = ApiKeyService.resolve_api_key(db, token)
+        if not grant:
             audit_logger.log_security_event(
                 action="invalid_api_key",
                 user="unknown",
@@ -61,8 +77,8 @@ async def get_current_user(
                 detail="Invalid API key",
             )
 
-        user = user_service.get_user(api_key.target_user_id, db=db)
-        if not user or not user.is_active:
+        user = _resolve_active_user(grant.target_user_id, db)
+        if user is None:
             raise HTTPException(
                 status_code=status.HTTP_401_UNAUTHORIZED,
                 detail="API key target user inactive",
@@ -70,12 +86,12 @@ async def get_current_user(
 
         # Record usage with client IP
         client_ip = request.client.host if request.client else None
-        ApiKeyService.record_usage(db, api_key, ip=client_ip)
+        ApiKeyService.record_grant_usage(db, grant, ip=client_ip)
 
         # Store metadata for audit trail
         request.state.auth_method = "api_key"
-        request.state.api_key_id = api_key.id
-        return user_service.serialize_user(user)
+        request.state.api_key_id = grant.id
+        return user
 
     # --- JWT path (existing logic) ---
     try:
@@ -95,6 +111,10 @@ async def get_current_user(
             detail="Could not validate credentials",
         ) from exc
 
+    cached = _resolve_active_user(payload.sub, db)
+    if cached is not None:
+        return cached
+
     user = user_service.get_user(payload.sub, db=db)
     logger.debug(f"Retrieved user from database: {user.username if user else 'None'}")
     if not user:
@@ -140,25 +160,22 @@ async def get_current_user_optional(
     if token.startswith("balu_"):
         from app.services.api_key_service import ApiKeyService
 
-        api_key = ApiKeyService.validate_api_key(db, token)
-        if not api_key:
+        grant = ApiKeyService.resolve_api_key(db, token)
+        if not grant:
             return None
-        user = user_service.get_user(api_key.target_user_id, db=db)
-        if not user or not user.is_active:
+        user = _resolve_active_user(grant.target_user_id, db)
+        if user is None:
             return None
         client_ip = request.client.host if request.client else None
-        ApiKeyService.record_usage(db, api_key, ip=client_ip)
+        ApiKeyService.record_grant_usage(db, grant, ip=client_ip)
         request.state.auth_method = "api_key"
-        request.state.api_key_id = api_key.id
-        return user_service.serialize_user(user)
+        request.state.api_key_id = grant.id
+        return user
 
     # --- JWT path ---
     try:
         payload: TokenPayload = auth_service.decode_token(token)
-        user = user_service.get_user(payload.sub, db=db)
-        if not user or not user.is_active:
-            return None
-        return user_service.serialize_user(user)
+        return _resolve_active_user(payload.sub, db)
     except auth_service.InvalidTokenError:
         return None
 
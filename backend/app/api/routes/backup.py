@@ -1,8 +1,10 @@
 """Backup API routes."""
 import logging
 
-from fastapi import APIRouter, Depends, HTTPException, Request, Response, status
-from fastapi.responses import FileResponse
+from pathlib import PurePosixPath
+
+from fastapi import APIRouter, Depends, HTTPException, Query, Request, Response, status
+from fastapi.responses import FileResponse, StreamingResponse
 from sqlalchemy.orm import Session
 
 from app.api import deps
@@ -12,12 +14,15 @@ from app.schemas.power import ServicePowerProperty
 from app.schemas.user import UserPublic
 from app.schemas.backup import (
     BackupCreate,
+    BackupFileListResponse,
+    BackupFileRestoreRequest,
     BackupResponse,
     BackupListResponse,
     BackupRestoreRequest,
     BackupRestoreResponse
 )
 from app.services.backup import get_backup_service
+from app.services.backup.archive import MANIFEST_SUFFIX, is_chunked_archive
 from app.plugins.emit import emit_hook
 from app.core.rate_limiter import user_limiter, get_limit
 
@@ -256,7 +261,8 @@ async def download_backup(
     """
     Download a backup file (Admin only).
     
-    Returns the backup as a tar.gz file for download.
+    Legacy backups are returned as their tar.gz file; chunked backups are
+    streamed as an uncompressed tar assembled from the chunk store.
     """
     service = get_backup_service(db)
     filepath = service.download_backup(backup_id)
@@ -266,9 +272,104 @@ async def download_backup(
             status_code=status.HTTP_404_NOT_FOUND,
             detail="Backup not found or not available for download"
         )
+
+    if is_chunked_archive(filepath):
+        tar_name = filepath.name[: -len(MANIFEST_SUFFIX)] + ".tar"
+        return StreamingResponse(
+            service.iter_backup_tar(filepath),
+            media_type="application/x-tar",
+            headers={"Content-Disposition": f'attachment; filename="{tar_name}"'},
+        )
     
     return FileResponse(
         path=str(filepath),
         filename=filepath.name,
         media_type="application/gzip"
     )
+
+
+@router.get("/{backup_id}/files", response_model=BackupFileListResponse)
+@user_limiter.limit(get_limit("backup_operations"))
+async def list_backup_files(
+    request: Request,
+    response: Response,
+    backup_id: int,
+    prefix: str = Query("", description="Only entries below this path, e.g. files/alice/"),
+    limit: int = Query(1000, ge=1, le=10000),
+    _: UserPublic = Depends(deps.get_current_admin),
+    db: Session = Depends(get_db)
+):
+    """List the entries of a chunked backup (Admin only)."""
+    service = get_backup_service(db)
+    entries = service.list_backup_files(backup_id, prefix=prefix, limit=limit)
+    if entries is None:
+        raise HTTPException(
+            status_code=status.HTTP_404_NOT_FOUND,
+            detail="Backup not found or not browsable"
+        )
+    return BackupFileListResponse(backup_id=backup_id, entries=entries)
+
+
+@router.get("/{backup_id}/files/content")
+@user_limiter.limit(get_limit("backup_operations"))
+async def download_backup_file(
+    request: Request,
+    response: Response,
+    backup_id: int,
+    path: str = Query(..., description="Entry path, e.g. files/alice/report.pdf"),
+    _: UserPublic = Depends(deps.get_current_admin),
+    db: Session = Depends(get_db)
+):
+    """Download a single file from a chunked backup (Admin only)."""
+    service = get_backup_service(db)
+    opened = service.open_backup_file(backup_id, path)
+    if opened is None:
+        raise HTTPException(
+            status_code=status.HTTP_404_NOT_FOUND,
+            detail="File not found in backup"
+        )
+    entry, content = opened
+    return StreamingResponse(
+        content,
+        media_type="application/octet-stream",
+        headers={
+            "Content-Disposition": f'attachment; filename="{PurePosixPath(entry["path"]).name}"',
+            "Content-Length": str(entry["size"]),
+        },
+    )
+
+
+@router.post("/{backup_id}/files/restore", status_code=status.HTTP_204_NO_CONTENT)
+@user_limiter.limit(get_limit("backup_operations"))
+async def restore_backup_file(
+    request: Request,
+    response: Response,
+    backup_id: int,
+    restore_request: BackupFileRestoreRequest,
+    current_user: UserPublic = Depends(deps.get_current_admin),
+    db: Session = Depends(get_db)
+):
+    """
+    Restore a single file from a chunked backup to its original place (Admin only).
+
+    ⚠️ Overwrites the current version of that file.
+    """
+    if not restore_request.confirm:
+        raise HTTPException(
+            status_code=status.HTTP_400_BAD_REQUEST,
+            detail="Restore operation must be confirmed (confirm=true)"
+        )
+    service = get_backup_service(db)
+    try:
+        restored = service.restore_backup_file(backup_id, restore_request.path, current_user.username)
+    except ValueError:
+        raise HTTPException(
+            status_code=status.HTTP_400_BAD_REQUEST,
+            detail="Invalid path"
+        )
+    if not restored:
+        raise HTTPException(
+            status_code=status.HTTP_404_NOT_FOUND,
+            detail="File not found in backup"
+        )
+    return None
@@ -5,6 +5,7 @@ Provides CrystalDiskMark-style disk performance benchmarks using fio.
 """
 
 from typing import Any, Optional
+import json
 import math
 
 from fastapi import APIRouter, Depends, HTTPException, Request, Response, status
@@ -28,6 +29,13 @@ from app.schemas.benchmark import (
     BenchmarkTargetTypeEnum,
     ProfileListResponse,
     TestResultSchema,
+    WORKLOAD_PROFILES,
+    WorkloadBenchmarkListResponse,
+    WorkloadBenchmarkResponse,
+    WorkloadComparisonResponse,
+    WorkloadProfileListResponse,
+    WorkloadResultSchema,
+    WorkloadStartRequest,
 )
 from app.schemas.user import UserPublic
 from app.services import benchmark as benchmark_service
@@ -230,6 +238,169 @@ async def start_confirmed_benchmark(
         )
 
 
+# ===== Workload suite (end-to-end, admin only) =====
+# Registered before /{benchmark_id} so "workloads" is not parsed as an ID.
+
+def _workload_to_response(run: Any) -> WorkloadBenchmarkResponse:
+    """Convert WorkloadBenchmark model to WorkloadBenchmarkResponse schema."""
+    try:
+        environment = json.loads(run.environment_json) if run.environment_json else {}
+    except ValueError:
+        environment = {}
+    return WorkloadBenchmarkResponse(
+        id=run.id,
+        profile=run.profile,
+        status=BenchmarkStatusEnum(run.status.value),
+        progress_percent=run.progress_percent,
+        current_workload=run.current_workload,
+        error_message=run.error_message,
+        created_at=run.created_at,
+        started_at=run.started_at,
+        completed_at=run.completed_at,
+        duration_seconds=run.duration_seconds,
+        app_version=run.app_version,
+        app_commit=run.app_commit,
+        hardware_fingerprint=run.hardware_fingerprint,
+        environment=environment,
+        baseline_id=run.baseline_id,
+        regressions=run.regressions,
+        results=[WorkloadResultSchema.model_validate(r) for r in run.results],
+    )
+
+
+@router.get("/workloads/profiles", response_model=WorkloadProfileListResponse)
+@user_limiter.limit(get_limit("admin_operations"))
+async def get_workload_profiles(
+    request: Request,
+    response: Response,
+    current_admin: UserPublic = Depends(get_current_admin),
+) -> WorkloadProfileListResponse:
+    """Get workload suite profiles and the workloads each run executes."""
+    return WorkloadProfileListResponse(
+        profiles=list(WORKLOAD_PROFILES.values()),
+        workloads=list(benchmark_service.WORKLOADS),
+    )
+
+
+@router.post("/workloads/start", response_model=WorkloadBenchmarkResponse)
+@user_limiter.limit(get_limit("admin_benchmark"))
+async def start_workload_benchmark(
+    request: Request,
+    response: Response,
+    payload: WorkloadStartRequest,
+    db: Session = Depends(get_db),
+    current_admin: UserPublic = Depends(get_current_admin),
+) -> WorkloadBenchmarkResponse:
+    """
+    Start an end-to-end workload benchmark (admin only).
+
+    Runs uploads, downloads, listings, versioning, SSD cache and WebDAV
+    workloads through the live API in a scratch folder of the admin's home.
+    """
+    try:
+        run = await benchmark_service.start_workload_benchmark(
+            db=db,
+            user_id=current_admin.id,
+            profile=payload.profile,
+            workloads=payload.workloads,
+            webdav_password=payload.webdav_password,
+        )
+    except ValueError as e:
+        raise HTTPException(
+            status_code=status.HTTP_400_BAD_REQUEST,
+            detail=str(e),
+        )
+    return _workload_to_response(run)
+
+
+@router.get("/workloads", response_model=WorkloadBenchmarkListResponse)
+@user_limiter.limit(get_limit("admin_operations"))
+async def list_workload_benchmarks(
+    request: Request,
+    response: Response,
+    page: int = 1,
+    page_size: int = 10,
+    profile: Optional[str] = None,
+    db: Session = Depends(get_db),
+    current_admin: UserPublic = Depends(get_current_admin),
+) -> WorkloadBenchmarkListResponse:
+    """Get paginated workload benchmark history, newest first."""
+    page = max(page, 1)
+    page_size = min(max(page_size, 1), 100)
+
+    runs, total = benchmark_service.get_workload_history(
+        db=db, page=page, page_size=page_size, profile=profile,
+    )
+    return WorkloadBenchmarkListResponse(
+        items=[_workload_to_response(r) for r in runs],
+        total=total,
+        page=page,
+        page_size=page_size,
+        total_pages=math.ceil(total / page_size) if total > 0 else 1,
+    )
+
+
+@router.get("/workloads/{run_id}", response_model=WorkloadBenchmarkResponse)
+@user_limiter.limit(get_limit("admin_operations"))
+async def get_workload_benchmark(
+    request: Request,
+    response: Response,
+    run_id: int,
+    db: Session = Depends(get_db),
+    current_admin: UserPublic = Depends(get_current_admin),
+) -> WorkloadBenchmarkResponse:
+    """Get a workload benchmark run with all workload results."""
+    run = benchmark_service.get_workload_benchmark(db, run_id)
+    if run is None:
+        raise HTTPException(
+            status_code=status.HTTP_404_NOT_FOUND,
+            detail=f"Workload benchmark {run_id} not found",
+        )
+    return _workload_to_response(run)
+
+
+@router.get("/workloads/{run_id}/compare", response_model=WorkloadComparisonResponse)
+@user_limiter.limit(get_limit("admin_operations"))
+async def compare_workload_benchmark(
+    request: Request,
+    response: Response,
+    run_id: int,
+    baseline_id: Optional[int] = None,
+    db: Session = Depends(get_db),
+    current_admin: UserPublic = Depends(get_current_admin),
+) -> WorkloadComparisonResponse:
+    """
+    Compare a run against a baseline.
+
+    Defaults to the previous completed run of the same profile on the same
+    hardware; pass ``baseline_id`` to compare against a specific run.
+    """
+    comparison = benchmark_service.get_comparison(db, run_id, baseline_id)
+    if comparison is None:
+        raise HTTPException(
+            status_code=status.HTTP_404_NOT_FOUND,
+            detail=f"Workload benchmark {run_id} not found",
+        )
+    return WorkloadComparisonResponse(**comparison)
+
+
+@router.post("/workloads/{run_id}/cancel")
+@user_limiter.limit(get_limit("admin_operations"))
+async def cancel_workload_benchmark(
+    request: Request,
+    response: Response,
+    run_id: int,
+    current_admin: UserPublic = Depends(get_current_admin),
+) -> dict:
+    """Cancel a running workload benchmark after its current operation."""
+    if not benchmark_service.cancel_workload_benchmark(run_id):
+        raise HTTPException(
+            status_code=status.HTTP_400_BAD_REQUEST,
+            detail=f"Workload benchmark {run_id} is not running",
+        )
+    return {"message": "Workload benchmark cancellation requested", "benchmark_id": run_id}
+
+
 @router.get("/{benchmark_id}", response_model=BenchmarkResponse)
 @user_limiter.limit(get_limit("admin_operations"))
 async def get_benchmark(
@@ -10,6 +10,10 @@ Protocol
 2. ``POST /{id}/chunk``   — send one chunk (sequential, 0-indexed)
 3. ``POST /{id}/complete`` — finalise (move temp → target, metadata, audit)
 4. ``DELETE /{id}``       — abort and clean up
+
+Sessions initialised with ``parallel: true`` accept chunks in any order and
+several at once; ``GET /{id}`` reports which chunks are still missing so an
+interrupted upload can be resumed.
 """
 
 import asyncio
@@ -18,6 +22,8 @@ import shutil
 from pathlib import PurePosixPath
 
 from fastapi import APIRouter, Depends, HTTPException, Query, Request, Response, status
+from typing import List, Optional
+
 from pydantic import BaseModel
 from sqlalchemy.orm import Session
 
@@ -25,6 +31,7 @@ from app.api import deps
 from app.core.database import get_db
 from app.schemas.user import UserPublic
 from app.services.files.chunked_upload import get_chunked_upload_manager
+from app.services.files.folder_size import folder_size_token, record_file_size_change
 from app.services.files.operations import (
     ROOT_DIR,
     FileAccessError,
@@ -55,15 +62,29 @@ class ChunkedInitRequest(BaseModel):
     filename: str
     total_size: int
     target_path: str = ""          # relative directory inside storage root
+    parallel: bool = False         # out-of-order / concurrent chunk mode
 
 
 class ChunkedInitResponse(BaseModel):
     upload_id: str
     chunk_size: int
+    parallel: bool = False
+    total_chunks: int = 0
 
 
 class ChunkedChunkResponse(BaseModel):
     received_bytes: int
+    chunk_sha256: Optional[str] = None   # parallel mode only
+
+
+class ChunkedStatusResponse(BaseModel):
+    upload_id: str
+    parallel: bool
+    chunk_size: int
+    total_chunks: int
+    received_bytes: int
+    total_size: int
+    missing_chunks: List[int]
 
 
 class ChunkedCompleteResponse(BaseModel):
@@ -138,6 +159,7 @@ async def chunked_init(
         total_size=payload.total_size,
         user_id=user.id,
         username=user.username,
+        parallel=payload.parallel,
     )
 
     # Also create an SSE progress session so the modal can track it
@@ -151,6 +173,40 @@ async def chunked_init(
     return ChunkedInitResponse(
         upload_id=session.upload_id,
         chunk_size=session.chunk_size,
+        parallel=session.parallel,
+        total_chunks=session.total_chunks,
+    )
+
+
+@router.get("/upload/chunked/{upload_id}", response_model=ChunkedStatusResponse)
+@user_limiter.limit(get_limit("file_chunked"))
+async def chunked_status(
+    request: Request,
+    response: Response,
+    upload_id: str,
+    user: UserPublic = Depends(deps.get_current_user),
+) -> ChunkedStatusResponse:
+    """Report upload progress, including the chunks still missing (resume)."""
+    mgr = get_chunked_upload_manager()
+    session = mgr.get_session(upload_id)
+    if session is None:
+        raise HTTPException(status.HTTP_404_NOT_FOUND, detail="Upload session not found")
+    if session.user_id != user.id:
+        raise HTTPException(status.HTTP_403_FORBIDDEN, detail="Not your upload session")
+
+    if session.parallel:
+        missing = session.missing_chunks()
+    else:
+        missing = list(range(session.next_chunk_index, session.total_chunks))
+
+    return ChunkedStatusResponse(
+        upload_id=session.upload_id,
+        parallel=session.parallel,
+        chunk_size=session.chunk_size,
+        total_chunks=session.total_chunks,
+        received_bytes=session.received_bytes,
+        total_size=session.total_size,
+        missing_chunks=missing,
     )
 
 
@@ -189,7 +245,10 @@ async def chunked_chunk(
     if progress is not None:
         await progress_mgr.update_progress(upload_id, received)
 
-    return ChunkedChunkResponse(received_bytes=received)
+    return ChunkedChunkResponse(
+        received_bytes=received,
+        chunk_sha256=session.chunk_digests.get(chunk_index) if session.parallel else None,
+    )
 
 
 @router.post("/upload/chunked/{upload_id}/complete", response_model=ChunkedCompleteResponse)
@@ -235,8 +294,10 @@ async def chunked_complete(
             detail=f"Not enough space. Need {needed} bytes, available {available}.",
         )
 
+    size_token = await asyncio.to_thread(folder_size_token)
     await asyncio.to_thread(shutil.move, str(temp_path), str(destination))
     await asyncio.to_thread(set_storage_file_permissions, destination)
+    await asyncio.to_thread(record_file_size_change, destination, file_size - existing_size, size_token)
 
     relative_destination = str(destination.relative_to(ROOT_DIR).as_posix())
 
@@ -1,19 +1,29 @@
-from typing import Optional
+import asyncio
+import json
+import os
+from datetime import datetime, timezone
+from typing import Iterator, Optional
 from pathlib import Path, PurePosixPath
 
-from fastapi import APIRouter, Depends, File, Form, HTTPException, Request, Response, UploadFile, status
+import jwt
+from fastapi import APIRouter, BackgroundTasks, Depends, File, Form, HTTPException, Query, Request, Response, UploadFile, status
+from fastapi.responses import StreamingResponse
 from pydantic import BaseModel
-from fastapi.responses import FileResponse
 from sqlalchemy.orm import Session
+from sse_starlette.sse import EventSourceResponse
 
 from app.api import deps
+from app.core import security
+from app.core.config import settings
 from app.core.database import get_db
 from app.core.power_rating import requires_power
-from app.core.rate_limiter import user_limiter, get_limit
+from app.core.rate_limiter import limiter, user_limiter, get_limit
 from app.schemas.power import ServicePowerProperty
 from app.schemas.files import (
     FileListResponse,
     FileOperationResponse,
+    FileSearchFacets,
+    FileSearchResponse,
     FileUploadResponse,
     UserRootUsageResponse,
     FolderCreateRequest,
@@ -25,6 +35,8 @@ from app.schemas.files import (
     FileItem,
     OwnershipTransferRequest,
     OwnershipTransferResponse,
+    OwnershipTransferJobStatus,
+    BulkOwnershipTransferResponse,
     ConflictInfo,
     EnforceResidencyRequest,
     EnforceResidencyResponse,
@@ -44,14 +56,28 @@ from app.models.file_metadata import FileMetadata
 from app.plugins.emit import emit_hook
 
 from app.models.desktop_sync_folder import DesktopSyncFolder
+from app.services.cache.fill import get_cache_fill_pipeline
 from app.services.cache.ssd_file_cache import SSDFileCacheService
+from app.services.files.download import build_download_response, is_initial_request
 from app.services.file_activity import track_activity
+from app.services.files.listing import (
+    DEFAULT_PAGE_SIZE,
+    MAX_PAGE_SIZE,
+    DirectoryListing,
+    EntryType,
+    InvalidCursorError,
+    SortKey,
+    SortOrder,
+    iter_directory_pages,
+    next_page,
+    open_directory_listing,
+)
+from app.services.files import search as file_search
 from app.schemas.sync import SyncDeviceInfo
 
 SHARED_DIR_NAME = "Shared"
-
-import logging as _logging
-_cache_logger = _logging.getLogger(__name__)
+_TRANSFER_PROGRESS_POLL_SECONDS = 0.5
+_EPOCH = datetime.fromtimestamp(0, tz=timezone.utc)
 
 
 def _schedule_cache_file(
@@ -60,28 +86,8 @@ def _schedule_cache_file(
     file_path: Path,
     file_id: Optional[int] = None,
 ) -> None:
-    """Schedule background caching of a file to SSD."""
-    import asyncio
-    from pathlib import Path as _Path
-
-    async def _do_cache() -> None:
-        from app.core.database import SessionLocal
-        _db = SessionLocal()
-        try:
-            svc = SSDFileCacheService(_db)
-            svc.cache_file(resource_path, _Path(str(file_path)), file_id=file_id)
-            _db.commit()
-        except Exception:
-            _cache_logger.debug("Background cache failed for %s", resource_path, exc_info=True)
-            _db.rollback()
-        finally:
-            _db.close()
-
-    try:
-        loop = asyncio.get_running_loop()
-        loop.create_task(_do_cache())
-    except RuntimeError:
-        pass
+    """Queue background caching of a file to SSD (see services/cache/fill.py)."""
+    get_cache_fill_pipeline().submit(resource_path, file_path, file_id=file_id)
 
 
 async def _handle_delete(
@@ -115,25 +121,31 @@ _MIN_CACHEABLE_SIZE = 1024 * 1024  # files smaller than this skip the SSD cache
 
 
 def _try_serve_from_cache(
+    request: Request,
     db: Session,
     resource_path: str,
     file_path: Path,
     response_filename: str,
     file_id: Optional[int] = None,
-) -> Optional[FileResponse]:
-    """Return a FileResponse from SSD cache if available; otherwise schedule
-    background caching for eligible files. Cache failures never block delivery.
+    file_metadata: Optional[FileMetadata] = None,
+) -> Optional[Response]:
+    """Return a download response from SSD cache if available; otherwise
+    schedule background caching for eligible files. Cache failures never
+    block delivery.
     """
     try:
         cache_svc = SSDFileCacheService(db)
         if not cache_svc.is_cache_enabled():
             return None
-        source_mtime = file_path.stat().st_mtime
-        cached = cache_svc.get_cached_path(resource_path, source_mtime)
+        source_stat = file_path.stat()
+        if settings.ssd_file_cache_readahead and is_initial_request(request.headers):
+            get_cache_fill_pipeline().submit_readahead(resource_path, file_path)
+        cached = cache_svc.get_cached_path(resource_path, source_stat.st_mtime)
         if cached and cached.exists():
-            db.commit()
-            return FileResponse(path=cached, filename=response_filename)
-        if file_path.stat().st_size >= _MIN_CACHEABLE_SIZE:
+            return _download_response(
+                request, cached, response_filename, file_metadata, source_stat=source_stat,
+            )
+        if source_stat.st_size >= _MIN_CACHEABLE_SIZE:
             _schedule_cache_file(db, resource_path, file_path, file_id=file_id)
         db.commit()
     except Exception:
@@ -141,6 +153,28 @@ def _try_serve_from_cache(
     return None
 
 
+def _download_response(
+    request: Request,
+    serve_path: Path,
+    filename: str,
+    file_metadata: Optional[FileMetadata],
+    source_stat: Optional[os.stat_result] = None,
+) -> Response:
+    """Range/conditional-aware download response (see services/files/download.py)."""
+    return build_download_response(
+        request.headers,
+        serve_path,
+        filename,
+        method=request.method,
+        source_stat=source_stat,
+        checksum=file_metadata.checksum if file_metadata else None,
+        metadata_size=file_metadata.size_bytes if file_metadata else None,
+        metadata_timestamp=(
+            (file_metadata.updated_at or file_metadata.created_at) if file_metadata else None
+        ),
+    )
+
+
 def _enrich_with_sync_info(
     entries: list[FileItem],
     user_id: int,
@@ -557,33 +591,90 @@ async def get_user_root_usage(
     return UserRootUsageResponse(**usage)
 
 
+def _virtual_listing(path: str, user: UserPublic, db: Session) -> Optional[list[FileItem]]:
+    """Entries of the non-admin virtual folders, or None for a real path."""
+    if is_privileged(user):
+        return None
+    # ── Non-admin root listing: show only Shared + user's home dir + Shared with me ──
+    if not path.strip("/"):
+        return _enrich_with_sync_info(list_user_root(user, db), user.id, False, db)
+    # ── "Shared with me" virtual listing ──
+    if path.strip("/") == SHARED_WITH_ME_DIR:
+        return _enrich_with_sync_info(list_shared_with_me(user, db), user.id, False, db)
+    return None
+
+
+def _open_listing(
+    jailed_path: str,
+    user: UserPublic,
+    db: Session,
+    *,
+    cursor: Optional[str],
+    sort: SortKey,
+    order: SortOrder,
+    q: Optional[str],
+    entry_type: Optional[EntryType],
+) -> DirectoryListing:
+    try:
+        return open_directory_listing(
+            jailed_path, user, db,
+            cursor=cursor, sort=sort, order=order, query=q, entry_type=entry_type,
+        )
+    except InvalidCursorError as exc:
+        raise HTTPException(status_code=status.HTTP_400_BAD_REQUEST, detail=str(exc)) from exc
+    except PermissionDeniedError as exc:
+        get_audit_logger_db().log_authorization_failure(
+            user=user.username,
+            action="list_directory",
+            resource=jailed_path,
+            required_permission="read",
+            db=db
+        )
+        raise HTTPException(status_code=status.HTTP_403_FORBIDDEN, detail=str(exc)) from exc
+    except file_service.FileAccessError as exc:
+        raise HTTPException(status_code=403, detail=str(exc)) from exc
+
+
 @router.get("/list", response_model=FileListResponse)
 @user_limiter.limit(get_limit("file_list"))
 def list_files(
     request: Request,
     response: Response,
     path: str = "",
+    limit: Optional[int] = Query(None, ge=1, le=MAX_PAGE_SIZE),
+    cursor: Optional[str] = None,
+    sort: SortKey = "name",
+    order: SortOrder = "asc",
+    q: Optional[str] = None,
+    entry_type: Optional[EntryType] = Query(None, alias="type"),
     user: UserPublic = Depends(deps.get_current_user),
     db: Session = Depends(get_db),
 ) -> FileListResponse:
-    audit_logger = get_audit_logger_db()
-    original_path = path
+    """List a directory.
 
-    # ── Non-admin root listing: show only Shared + user's home dir + Shared with me ──
-    if not is_privileged(user) and not original_path.strip("/"):
-        entries = list_user_root(user, db)
-        entries = _enrich_with_sync_info(entries, user.id, False, db)
-        return FileListResponse(files=entries)
+    Without ``limit``/``cursor``/filters the whole directory is returned as
+    before. With them the listing is keyset-paginated: pass the returned
+    ``next_cursor`` back (with the same sort and filters) for the next page.
+    """
+    audit_logger = get_audit_logger_db()
 
-    # ── "Shared with me" virtual listing ──
-    if not is_privileged(user) and original_path.strip("/") == SHARED_WITH_ME_DIR:
-        entries = list_shared_with_me(user, db)
-        entries = _enrich_with_sync_info(entries, user.id, False, db)
-        return FileListResponse(files=entries)
+    virtual = _virtual_listing(path, user, db)
+    if virtual is not None:
+        return FileListResponse(files=virtual)
 
     # ── Admin or non-root path: normal behavior ──
     jailed_path = _jail_path(path, user, db)
 
+    paged = limit is not None or cursor is not None or q or entry_type or sort != "name" or order != "asc"
+    if paged:
+        listing = _open_listing(
+            jailed_path, user, db,
+            cursor=cursor, sort=sort, order=order, q=q, entry_type=entry_type,
+        )
+        entries, next_cursor = next_page(listing, user, db, limit or DEFAULT_PAGE_SIZE)
+        entries = _enrich_with_sync_info(entries, user.id, is_privileged(user), db)
+        return FileListResponse(files=entries, next_cursor=next_cursor, total=listing.total)
+
     try:
         entries = list(file_service.list_directory(jailed_path, user=user, db=db))
     except PermissionDeniedError as exc:
@@ -602,6 +693,128 @@ def list_files(
     return FileListResponse(files=entries)
 
 
+@router.get("/list/stream")
+@user_limiter.limit(get_limit("file_list"))
+def stream_files(
+    request: Request,
+    response: Response,
+    path: str = "",
+    limit: Optional[int] = Query(None, ge=1),
+    page_size: int = Query(DEFAULT_PAGE_SIZE, ge=1, le=MAX_PAGE_SIZE),
+    cursor: Optional[str] = None,
+    sort: SortKey = "name",
+    order: SortOrder = "asc",
+    q: Optional[str] = None,
+    entry_type: Optional[EntryType] = Query(None, alias="type"),
+    user: UserPublic = Depends(deps.get_current_user),
+    db: Session = Depends(get_db),
+) -> StreamingResponse:
+    """Stream a directory listing as NDJSON.
+
+    One ``FileItem`` JSON object per line, written page by page so the first
+    entries arrive before the directory has been fully processed. The last
+    line is ``{"next_cursor": ..., "total": ...}``; ``next_cursor`` is set
+    when ``limit`` stopped the stream early.
+    """
+    virtual = _virtual_listing(path, user, db)
+    if virtual is not None:
+        def _virtual_lines() -> Iterator[str]:
+            for item in virtual:
+                yield item.model_dump_json() + "\n"
+            yield json.dumps({"next_cursor": None, "total": len(virtual)}) + "\n"
+        return StreamingResponse(_virtual_lines(), media_type="application/x-ndjson")
+
+    jailed_path = _jail_path(path, user, db)
+    listing = _open_listing(
+        jailed_path, user, db,
+        cursor=cursor, sort=sort, order=order, q=q, entry_type=entry_type,
+    )
+    privileged = is_privileged(user)
+
+    def _lines() -> Iterator[str]:
+        from app.core.database import SessionLocal
+
+        # The request session is closed once streaming starts; use our own
+        with SessionLocal() as stream_db:
+            next_cursor = None
+            for items, next_cursor in iter_directory_pages(
+                listing, user, stream_db, page_size=page_size, limit=limit,
+            ):
+                items = _enrich_with_sync_info(items, user.id, privileged, stream_db)
+                yield "".join(item.model_dump_json() + "\n" for item in items)
+            yield json.dumps({"next_cursor": next_cursor, "total": listing.total}) + "\n"
+
+    return StreamingResponse(_lines(), media_type="application/x-ndjson")
+
+
+@router.get("/search", response_model=FileSearchResponse)
+@user_limiter.limit(get_limit("file_list"))
+def search_files(
+    request: Request,
+    response: Response,
+    q: str = "",
+    mode: file_search.SearchMode = "contains",
+    scope: file_search.SearchScope = "name",
+    content: bool = False,
+    folder: Optional[str] = None,
+    ext: Optional[list[str]] = Query(None),
+    entry_type: Optional[EntryType] = Query(None, alias="type"),
+    min_size: Optional[int] = Query(None, ge=0),
+    max_size: Optional[int] = Query(None, ge=0),
+    modified_after: Optional[datetime] = None,
+    modified_before: Optional[datetime] = None,
+    owner_id: Optional[int] = None,
+    sort: file_search.SearchSort = "relevance",
+    limit: int = Query(file_search.DEFAULT_LIMIT, ge=1, le=file_search.MAX_LIMIT),
+    offset: int = Query(0, ge=0, le=file_search.MAX_OFFSET),
+    facets: bool = False,
+    user: UserPublic = Depends(deps.get_current_user),
+    db: Session = Depends(get_db),
+) -> FileSearchResponse:
+    """Search names, paths, attributes and (``content``) extracted text.
+
+    Only entries the caller may view are returned; see
+    ``services/files/search.py`` for the match modes.
+    """
+    result = file_search.search_files(db, user, file_search.SearchQuery(
+        text=q, mode=mode, scope=scope, content=content, folder=folder,
+        extensions=ext or (), entry_type=entry_type,
+        min_size=min_size, max_size=max_size,
+        modified_after=modified_after, modified_before=modified_before,
+        owner_id=owner_id, sort=sort, limit=limit, offset=offset, facets=facets,
+    ))
+    files = [
+        FileItem(
+            name=hit.name,
+            path=hit.path,
+            size=hit.size_bytes,
+            type="directory" if hit.is_directory else "file",
+            modified_at=hit.modified_at or _EPOCH,
+            owner_id=str(hit.owner_id),
+            mime_type=hit.mime_type,
+            file_id=hit.file_id,
+        )
+        for hit in result.hits
+    ]
+    return FileSearchResponse(
+        files=files,
+        has_more=result.has_more,
+        facets=FileSearchFacets(**result.facets) if result.facets is not None else None,
+    )
+
+
+@router.post("/search/reindex")
+@user_limiter.limit(get_limit("admin_operations"))
+def rebuild_search_index(
+    request: Request,
+    response: Response,
+    user: UserPublic = Depends(deps.get_current_admin),
+    db: Session = Depends(get_db),
+) -> dict:
+    """Rewrite the search index from file metadata (Admin only)."""
+    return {"indexed": file_search.rebuild_index(db)}
+
+
 @router.get("/download/{resource_path:path}")
 @user_limiter.limit(get_limit("file_download"))
 async def download_file(
@@ -610,8 +823,12 @@ async def download_file(
     resource_path: str,
     user: UserPublic = Depends(deps.get_current_user),
     db: Session = Depends(get_db),
-) -> FileResponse:
-    """Legacy download endpoint using file path."""
+) -> Response:
+    """Legacy download endpoint using file path.
+
+    Supports Range (incl. multi-range), If-None-Match/If-Modified-Since and
+    zero-copy delivery via nginx when configured.
+    """
     resource_path = _jail_path(resource_path, user, db)
     audit_logger = get_audit_logger_db()
     try:
@@ -633,12 +850,18 @@ async def download_file(
     if not file_path.exists() or not file_path.is_file():
         raise HTTPException(status_code=404, detail="File not found")
 
-    cached_response = _try_serve_from_cache(db, resource_path, file_path, file_path.name)
+    from app.services.files import metadata_db as file_metadata_db
+    file_metadata = file_metadata_db.get_metadata(resource_path, db=db)
+
+    cached_response = _try_serve_from_cache(
+        request, db, resource_path, file_path, file_path.name, file_metadata=file_metadata,
+    )
     if cached_response is not None:
         return cached_response
 
-    track_activity(user.id, "file.download", resource_path)
-    return FileResponse(path=file_path, filename=file_path.name)
+    if is_initial_request(request.headers):
+        track_activity(user.id, "file.download", resource_path)
+    return _download_response(request, file_path, file_path.name, file_metadata)
 
 
 @router.get("/download/{file_id}")
@@ -649,8 +872,11 @@ async def download_file_by_id(
     response: Response,
     user: UserPublic = Depends(deps.get_current_user),
     db: Session = Depends(get_db),
-) -> FileResponse:
-    """Download a file by ID (authenticated access only)."""
+) -> Response:
+    """Download a file by ID (authenticated access only).
+
+    Same Range/conditional semantics as the path-based endpoint.
+    """
     audit_logger = get_audit_logger_db()
 
     # Get file metadata
@@ -679,13 +905,15 @@ async def download_file_by_id(
         raise HTTPException(status_code=404, detail="File not found on disk")
 
     cached_response = _try_serve_from_cache(
-        db, file_metadata.path, file_path, file_metadata.name, file_id=file_metadata.id
+        request, db, file_metadata.path, file_path, file_metadata.name,
+        file_id=file_metadata.id, file_metadata=file_metadata,
     )
     if cached_response is not None:
         return cached_response
 
-    track_activity(user.id, "file.download", file_metadata.path, file_name=file_metadata.name)
-    return FileResponse(path=file_path, filename=file_metadata.name)
+    if is_initial_request(request.headers):
+        track_activity(user.id, "file.download", file_metadata.path, file_name=file_metadata.name)
+    return _download_response(request, file_path, file_metadata.name, file_metadata)
 
 
 @router.post("/upload", response_model=FileUploadResponse)
@@ -1002,6 +1230,12 @@ async def transfer_ownership(
         conflict_strategy=payload.conflict_strategy,
     )
     
+    _raise_for_transfer_error(result)
+    return OwnershipTransferResponse(**_transfer_result_fields(result))
+
+
+def _raise_for_transfer_error(result) -> None:
+    """Map a failed OwnershipTransferResult to its HTTP status."""
     if not result.success and result.error in ("NOT_FOUND", "DISK_NOT_FOUND"):
         raise HTTPException(status_code=404, detail=result.message)
     elif not result.success and result.error == "UNAUTHORIZED":
@@ -1010,8 +1244,12 @@ async def transfer_ownership(
         raise HTTPException(status_code=400, detail=result.message)
     elif not result.success and result.error == "HOME_DIRECTORY":
         raise HTTPException(status_code=400, detail=result.message)
-    
-    return OwnershipTransferResponse(
+    elif not result.success and result.error == "TRANSFER_IN_PROGRESS":
+        raise HTTPException(status_code=409, detail=result.message)
+
+
+def _transfer_result_fields(result) -> dict:
+    return dict(
         success=result.success,
         message=result.message,
         transferred_count=result.transferred_count,
@@ -1029,6 +1267,170 @@ async def transfer_ownership(
     )
 
 
+def _job_status(job) -> OwnershipTransferJobStatus:
+    return OwnershipTransferJobStatus(
+        id=job.id,
+        status=job.status,
+        source_path=job.source_path,
+        target_path=job.target_path,
+        old_owner_id=job.old_owner_id,
+        new_owner_id=job.new_owner_id,
+        total_items=job.total_items,
+        processed_items=job.processed_items,
+        error_message=job.error_message,
+        created_at=job.created_at,
+        started_at=job.started_at,
+        completed_at=job.completed_at,
+    )
+
+
+def _get_visible_job(db: Session, job_id: int, user: UserPublic):
+    """The job if *user* started it or is privileged; 404 otherwise."""
+    from app.services.files.ownership_jobs import get_job
+
+    job = get_job(db, job_id)
+    if job is None or (job.requested_by != user.id and not is_privileged(user)):
+        raise HTTPException(status_code=404, detail="Transfer job not found")
+    return job
+
+
+@router.post("/transfer-ownership/bulk")
+@user_limiter.limit(get_limit("file_delete"))  # Use stricter rate limit
+async def transfer_ownership_bulk(
+    request: Request,
+    response: Response,
+    payload: OwnershipTransferRequest,
+    background_tasks: BackgroundTasks,
+    user: UserPublic = Depends(deps.get_current_user),
+    db: Session = Depends(get_db),
+) -> BulkOwnershipTransferResponse:
+    """
+    Recursively transfer a large directory in resumable batches.
+
+    Same rules as ``/transfer-ownership``. Directories with more than
+    ``OWNERSHIP_TRANSFER_BATCH_SIZE`` entries return a ``job`` at once and
+    are rewritten in the background; follow it with
+    ``/transfer-ownership/jobs/{id}`` or its SSE ``progress`` stream.
+    Smaller transfers complete inline (``job`` is null).
+    """
+    from app.services.files.ownership_jobs import run_bulk_transfer, start_bulk_transfer
+
+    payload.path = _jail_path(payload.path, user, db)
+    result, job = start_bulk_transfer(
+        path=payload.path,
+        new_owner_id=payload.new_owner_id,
+        requesting_user_id=user.id,
+        requesting_user_is_admin=is_privileged(user),
+        db=db,
+        conflict_strategy=payload.conflict_strategy,
+    )
+    _raise_for_transfer_error(result)
+
+    if job is not None:
+        background_tasks.add_task(run_bulk_transfer, job.id)
+    return BulkOwnershipTransferResponse(
+        **_transfer_result_fields(result),
+        job=_job_status(job) if job is not None else None,
+    )
+
+
+@router.get("/transfer-ownership/jobs/{job_id}", response_model=OwnershipTransferJobStatus)
+@user_limiter.limit(get_limit("file_list"))
+async def get_transfer_job(
+    request: Request,
+    response: Response,
+    job_id: int,
+    user: UserPublic = Depends(deps.get_current_user),
+    db: Session = Depends(get_db),
+) -> OwnershipTransferJobStatus:
+    """Progress of a bulk ownership transfer."""
+    return _job_status(_get_visible_job(db, job_id, user))
+
+
+@router.post("/transfer-ownership/jobs/{job_id}/resume", response_model=OwnershipTransferJobStatus)
+@user_limiter.limit(get_limit("file_delete"))
+async def resume_transfer_job(
+    request: Request,
+    response: Response,
+    job_id: int,
+    background_tasks: BackgroundTasks,
+    user: UserPublic = Depends(deps.get_current_user),
+    db: Session = Depends(get_db),
+) -> OwnershipTransferJobStatus:
+    """Continue a failed or interrupted bulk transfer from its last batch."""
+    from app.services.files.ownership_jobs import ACTIVE_STATUSES, resume_job, run_bulk_transfer
+
+    _get_visible_job(db, job_id, user)
+    job = resume_job(db, job_id)
+    if job is None or job.status not in ACTIVE_STATUSES:
+        raise HTTPException(status_code=409, detail="Transfer job has already completed")
+    background_tasks.add_task(run_bulk_transfer, job.id)
+    return _job_status(job)
+
+
+@router.post("/transfer-ownership/jobs/{job_id}/progress-token")
+@user_limiter.limit(get_limit("file_list"))
+async def create_transfer_progress_token(
+    request: Request,
+    response: Response,
+    job_id: int,
+    user: UserPublic = Depends(deps.get_current_user),
+    db: Session = Depends(get_db),
+) -> dict:
+    """Short-lived token for the job's SSE ``progress`` stream (60 s TTL)."""
+    _get_visible_job(db, job_id, user)
+    return {"token": security.create_sse_token(user_id=user.id, upload_id=f"ownership-{job_id}")}
+
+
+@router.get("/transfer-ownership/jobs/{job_id}/progress")
+@limiter.limit(get_limit("file_list"))
+async def transfer_progress_stream(
+    request: Request,
+    response: Response,
+    job_id: int,
+    token: str = Query(..., description="Scoped SSE token from POST .../progress-token"),
+) -> EventSourceResponse:
+    """
+    Server-Sent Events stream of a bulk transfer's progress.
+
+    Emits a ``progress`` event (the job status) whenever a batch commits,
+    and closes after ``completed`` or ``failed``.
+    """
+    from app.core.database import SessionLocal
+    from app.services.files.ownership_jobs import get_job
+
+    try:
+        payload = security.decode_token(token, token_type="sse")
+    except (jwt.PyJWTError, jwt.InvalidTokenError):
+        raise HTTPException(status_code=401, detail="Invalid or expired SSE token")
+    if payload.get("upload_id") != f"ownership-{job_id}":
+        raise HTTPException(status_code=403, detail="Token not valid for this job")
+
+    def _read() -> Optional[OwnershipTransferJobStatus]:
+        job_db = SessionLocal()
+        try:
+            job = get_job(job_db, job_id)
+            return _job_status(job) if job is not None else None
+        finally:
+            job_db.close()
+
+    async def event_generator():
+        last = None
+        while True:
+            job_status = await asyncio.to_thread(_read)
+            if job_status is None:
+                break
+            key = (job_status.status, job_status.processed_items)
+            if key != last:
+                last = key
+                yield {"event": "progress", "data": job_status.model_dump_json()}
+            if job_status.status in ("completed", "failed"):
+                break
+            await asyncio.sleep(_TRANSFER_PROGRESS_POLL_SECONDS)
+
+    return EventSourceResponse(event_generator())
+
+
 @router.post("/enforce-residency")
 @user_limiter.limit(get_limit("admin"))  # Admin-only rate limit
 async def enforce_residency_endpoint(
@@ -8,6 +8,8 @@ Exposes custom metrics for:
 - Application performance
 - Database statistics
 - User activity
+- Request, DB query and hot-path latency histograms (core/tracing.py),
+  summed over all Uvicorn workers
 
 Metrics are exposed in Prometheus format at /api/metrics
 """
@@ -18,16 +20,17 @@ from prometheus_client import (
     CollectorRegistry,
     Gauge,
     Counter,
-    Histogram,
     generate_latest,
     CONTENT_TYPE_LATEST,
 )
+from prometheus_client.core import CounterMetricFamily, HistogramMetricFamily
 import logging
 import psutil
 import time
 
 from app.api import deps
 from app.core.config import settings
+from app.core.tracing import get_tracer, iter_series
 from app.services.hardware.sensors import get_cpu_sensor_data
 from app.core.rate_limiter import limiter, get_limit
 
@@ -214,13 +217,6 @@ http_requests_total = Counter(
     registry=registry
 )
 
-http_request_duration_seconds = Histogram(
-    'baluhost_http_request_duration_seconds',
-    'HTTP request duration in seconds',
-    ['method', 'endpoint'],
-    registry=registry
-)
-
 # File Operations
 file_uploads_total = Counter(
     'baluhost_file_uploads_total',
@@ -258,13 +254,6 @@ database_connections = Gauge(
     registry=registry
 )
 
-database_query_duration_seconds = Histogram(
-    'baluhost_database_query_duration_seconds',
-    'Database query duration in seconds',
-    ['operation'],
-    registry=registry
-)
-
 # ===================================
 # User Metrics
 # ===================================
@@ -484,6 +473,71 @@ def collect_app_metrics():
         logger.warning("Error collecting app metrics: %s", e)
 
 
+# ===================================
+# Latency Histograms (all workers)
+# ===================================
+
+def _histogram(family: HistogramMetricFamily, labels: list[str], series) -> None:
+    buckets = [
+        ("+Inf" if le == float("inf") else repr(le), count)
+        for le, count in series.cumulative()
+    ]
+    family.add_metric(labels, buckets, series.total)
+
+
+class LatencyCollector:
+    """Prometheus view of the tracer's histograms, read at scrape time."""
+
+    def collect(self):
+        try:
+            series = get_tracer().collect()
+        except Exception as e:
+            logger.warning("Error collecting latency histograms: %s", e)
+            return
+
+        http = HistogramMetricFamily(
+            'baluhost_http_request_duration_seconds',
+            'HTTP request duration in seconds',
+            labels=['method', 'endpoint'],
+        )
+        db_queries = CounterMetricFamily(
+            'baluhost_http_request_db_queries',
+            'Database queries run by sampled HTTP requests',
+            labels=['method', 'endpoint'],
+        )
+        db_seconds = CounterMetricFamily(
+            'baluhost_http_request_db_seconds',
+            'Database time of sampled HTTP requests in seconds',
+            labels=['method', 'endpoint'],
+        )
+        for name, s in iter_series("http", series):
+            method, _, endpoint = name.partition(" ")
+            _histogram(http, [method, endpoint], s)
+            db_queries.add_metric([method, endpoint], s.db_queries)
+            db_seconds.add_metric([method, endpoint], s.db_seconds)
+
+        queries = HistogramMetricFamily(
+            'baluhost_database_query_duration_seconds',
+            'Database query duration in seconds (sampled)',
+            labels=['operation'],
+        )
+        for name, s in iter_series("db", series):
+            _histogram(queries, [name], s)
+
+        spans = HistogramMetricFamily(
+            'baluhost_span_duration_seconds',
+            'Duration of instrumented service paths in seconds (sampled)',
+            labels=['span'],
+        )
+        for name, s in iter_series("span", series):
+            _histogram(spans, [name], s)
+
+        yield from (http, db_queries, db_seconds, queries, spans)
+
+
+registry.register(LatencyCollector())
+
+
 # ===================================
 # Metrics Endpoint
 # ===================================
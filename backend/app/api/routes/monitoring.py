@@ -32,6 +32,8 @@ from app.schemas.monitoring import (
     NetworkHistoryResponse,
     DiskIoHistoryResponse,
     ProcessHistoryResponse,
+    RollupBucketSchema,
+    RollupHistoryResponse,
     UptimeHistoryResponse,
     UptimeSampleSchema,
     SleepEventSchema,
@@ -43,6 +45,7 @@ from app.schemas.monitoring import (
     MonitoringStatusResponse,
 )
 from app.models.sleep import SleepStateLog
+from app.services.monitoring import rollups
 from app.services.monitoring.orchestrator import get_monitoring_orchestrator
 from app.services.monitoring.retention_manager import METRIC_MODELS
 
@@ -120,10 +123,33 @@ def _parse_time_range(time_range: TimeRangeEnum) -> timedelta:
         TimeRangeEnum.ONE_HOUR: timedelta(hours=1),
         TimeRangeEnum.TWENTY_FOUR_HOURS: timedelta(hours=24),
         TimeRangeEnum.SEVEN_DAYS: timedelta(days=7),
+        TimeRangeEnum.THIRTY_DAYS: timedelta(days=30),
+        TimeRangeEnum.ONE_YEAR: timedelta(days=365),
     }
     return mapping.get(time_range, timedelta(hours=1))
 
 
+# Up to this range charts read raw samples (full detail, e.g. per-thread CPU);
+# longer ranges read the rollup tier picked for the range.
+RAW_HISTORY_MAX_DURATION = timedelta(hours=1)
+
+
+def _db_history(db: Session, metric: str, collector, duration: timedelta, limit: int):
+    """DB-backed history as (samples_by_series, source): rollups, raw rows as fallback."""
+    start = datetime.now(timezone.utc) - duration
+    if duration > RAW_HISTORY_MAX_DURATION:
+        resolution, by_series = rollups.history_samples(db, metric, start, max_points=limit)
+        if by_series:
+            return by_series, f"database ({rollups.RESOLUTION_LABELS[resolution]} rollup)"
+    samples = collector.get_history_db(db, start=start, limit=limit)
+    if metric != "disk_io":
+        return ({"": samples} if samples else {}), "database"
+    by_disk: Dict[str, list] = {}
+    for sample in samples:
+        by_disk.setdefault(sample.disk_name, []).append(sample)
+    return by_disk, "database"
+
+
 # ===== CPU Endpoints =====
 
 @router.get("/cpu/current", response_model=CurrentCpuResponse)
@@ -174,13 +200,12 @@ async def get_cpu_history(
         source_str = "memory"
         # Fallback to DB when memory buffer is empty (e.g. secondary worker)
         if not samples:
-            start = datetime.now(timezone.utc) - duration
-            samples = orchestrator.cpu_collector.get_history_db(db, start=start, limit=limit)
-            source_str = "database (fallback)"
+            by_series, source_str = _db_history(db, "cpu", orchestrator.cpu_collector, duration, limit)
+            samples = by_series.get("", [])
+            source_str += " (fallback)"
     else:
-        start = datetime.now(timezone.utc) - duration
-        samples = orchestrator.cpu_collector.get_history_db(db, start=start, limit=limit)
-        source_str = "database"
+        by_series, source_str = _db_history(db, "cpu", orchestrator.cpu_collector, duration, limit)
+        samples = by_series.get("", [])
         # Fallback to memory buffer if database is empty
         if not samples:
             samples = orchestrator.get_cpu_history(limit)
@@ -241,13 +266,12 @@ async def get_memory_history(
         source_str = "memory"
         # Fallback to DB when memory buffer is empty (e.g. secondary worker)
         if not samples:
-            start = datetime.now(timezone.utc) - duration
-            samples = orchestrator.memory_collector.get_history_db(db, start=start, limit=limit)
-            source_str = "database (fallback)"
+            by_series, source_str = _db_history(db, "memory", orchestrator.memory_collector, duration, limit)
+            samples = by_series.get("", [])
+            source_str += " (fallback)"
     else:
-        start = datetime.now(timezone.utc) - duration
-        samples = orchestrator.memory_collector.get_history_db(db, start=start, limit=limit)
-        source_str = "database"
+        by_series, source_str = _db_history(db, "memory", orchestrator.memory_collector, duration, limit)
+        samples = by_series.get("", [])
         # Fallback to memory buffer if database is empty
         if not samples:
             samples = orchestrator.get_memory_history(limit)
@@ -308,13 +332,12 @@ async def get_network_history(
         source_str = "memory"
         # Fallback to DB when memory buffer is empty (e.g. secondary worker)
         if not samples:
-            start = datetime.now(timezone.utc) - duration
-            samples = orchestrator.network_collector.get_history_db(db, start=start, limit=limit)
-            source_str = "database (fallback)"
+            by_series, source_str = _db_history(db, "network", orchestrator.network_collector, duration, limit)
+            samples = by_series.get("", [])
+            source_str += " (fallback)"
     else:
-        start = datetime.now(timezone.utc) - duration
-        samples = orchestrator.network_collector.get_history_db(db, start=start, limit=limit)
-        source_str = "database"
+        by_series, source_str = _db_history(db, "network", orchestrator.network_collector, duration, limit)
+        samples = by_series.get("", [])
         # Fallback to memory buffer if database is empty
         if not samples:
             samples = orchestrator.get_network_history(limit)
@@ -371,24 +394,16 @@ async def get_disk_io_history(
         source_str = "memory"
         # Fallback to DB when memory buffer is empty (e.g. secondary worker)
         if not any(disks.values()):
-            start = datetime.now(timezone.utc) - duration
-            samples = orchestrator.disk_io_collector.get_history_db(db, start=start, limit=limit)
-            if samples:
-                disks = {}
-                for sample in samples:
-                    if disk_name and sample.disk_name != disk_name:
-                        continue
-                    if sample.disk_name not in disks:
-                        disks[sample.disk_name] = []
-                    disks[sample.disk_name].append(sample)
-                source_str = "database (fallback)"
+            by_disk, db_source = _db_history(db, "disk_io", orchestrator.disk_io_collector, duration, limit)
+            if by_disk:
+                disks = {d: s for d, s in by_disk.items() if not disk_name or d == disk_name}
+                source_str = f"{db_source} (fallback)"
     else:
         # Get from database
-        start = datetime.now(timezone.utc) - duration
-        samples = orchestrator.disk_io_collector.get_history_db(db, start=start, limit=limit)
+        by_disk, source_str = _db_history(db, "disk_io", orchestrator.disk_io_collector, duration, limit)
 
         # Fallback to memory buffer if database query returned no results at all
-        if not samples:
+        if not by_disk:
             hist = orchestrator.get_disk_io_history(disk_name)
             if disk_name:
                 disks = {disk_name: hist} if isinstance(hist, list) else {disk_name: []}
@@ -396,15 +411,7 @@ async def get_disk_io_history(
                 disks = hist if isinstance(hist, dict) else {}
             source_str = "memory (fallback)"
         else:
-            # Group by disk name
-            disks = {}
-            for sample in samples:
-                if disk_name and sample.disk_name != disk_name:
-                    continue
-                if sample.disk_name not in disks:
-                    disks[sample.disk_name] = []
-                disks[sample.disk_name].append(sample)
-            source_str = "database"
+            disks = {d: s for d, s in by_disk.items() if not disk_name or d == disk_name}
 
     total_samples = sum(len(s) for s in disks.values())
 
@@ -421,6 +428,50 @@ async def get_disk_io_history(
     )
 
 
+# ===== Rollup Endpoints =====
+
+@router.get("/rollups", response_model=RollupHistoryResponse)
+@user_limiter.limit(get_limit("system_monitor"))
+async def get_rollup_history(
+    request: Request,
+    response: Response,
+    metric: str = Query(..., description="cpu, memory, network, disk_io or gpu"),
+    field: str = Query(..., description="Sample field, e.g. usage_percent"),
+    series: str = Query(default="", description="Disk name for disk_io"),
+    time_range: TimeRangeEnum = Query(default=TimeRangeEnum.TWENTY_FOUR_HOURS),
+    max_points: int = Query(default=rollups.DEFAULT_MAX_POINTS, ge=1, le=10000),
+    db: Session = Depends(get_db),
+    current_user: User = Depends(get_current_user),
+):
+    """Get min/max/avg/p95 buckets of one metric field at the tier fitting the range."""
+    if field not in rollups.ROLLUP_FIELDS.get(metric, ()):
+        raise HTTPException(status_code=400, detail=f"No rollups for {metric}.{field}")
+
+    start = datetime.now(timezone.utc) - _parse_time_range(time_range)
+    resolution, rows = rollups.query_rollups(
+        db, metric, start, fields=(field,), series=series, max_points=max_points,
+    )
+    buckets = [
+        RollupBucketSchema(
+            timestamp=row.bucket_start.replace(tzinfo=timezone.utc),
+            min=row.value_min,
+            max=row.value_max,
+            avg=row.value_sum / row.sample_count,
+            p95=row.value_p95,
+            count=row.sample_count,
+        )
+        for row in rows
+    ]
+
+    return RollupHistoryResponse(
+        metric=metric,
+        field=field,
+        series=series,
+        resolution_seconds=resolution,
+        buckets=buckets,
+    )
+
+
 # ===== Process Endpoints =====
 
 @router.get("/processes/current", response_model=CurrentProcessResponse)
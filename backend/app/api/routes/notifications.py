@@ -604,7 +604,7 @@ async def notification_websocket(
     from app.services.websocket_manager import ConnectionLimitExceeded
     manager = get_websocket_manager()
     try:
-        await manager.connect(websocket, user_id, is_admin=is_admin)
+        connection = await manager.connect(websocket, user_id, is_admin=is_admin)
     except ConnectionLimitExceeded as e:
         logger.warning(f"WebSocket: connection cap reached - {e}")
         await websocket.close(code=status.WS_1008_POLICY_VIOLATION)
@@ -616,10 +616,9 @@ async def notification_websocket(
         db = SessionLocal()
         try:
             unread_count = service.get_unread_count(db, user_id, is_admin=is_admin)
-            await websocket.send_json({
-                "type": "unread_count",
-                "payload": {"count": unread_count},
-            })
+            # Everything goes through the connection's send queue so the
+            # writer task stays the only sender on this socket.
+            connection.send_typed("unread_count", {"count": unread_count})
         except Exception as e:
             logger.error(f"WebSocket: Failed to send initial unread count - {e}")
         finally:
@@ -631,7 +630,7 @@ async def notification_websocket(
                 data = await websocket.receive_json()
 
                 if data.get("type") == "ping":
-                    await websocket.send_json({"type": "pong", "payload": {}})
+                    connection.send_typed("pong", {})
                 elif data.get("type") == "mark_read":
                     notification_id = data.get("payload", {}).get("notification_id")
                     if notification_id:
@@ -640,10 +639,7 @@ async def notification_websocket(
                         try:
                             service.mark_as_read(db, notification_id, user_id, is_admin=is_admin)
                             unread_count = service.get_unread_count(db, user_id, is_admin=is_admin)
-                            await websocket.send_json({
-                                "type": "unread_count",
-                                "payload": {"count": unread_count},
-                            })
+                            connection.send_typed("unread_count", {"count": unread_count})
                         except Exception as e:
                             logger.error(f"WebSocket: Failed to mark_read - {e}")
                         finally:
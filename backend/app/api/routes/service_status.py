@@ -12,6 +12,7 @@ from starlette import status
 
 from app.api import deps
 from app.core.rate_limiter import user_limiter, get_limit
+from app.core.startup import get_startup_engine
 from app.schemas.service_status import (
     ServiceStatusResponse,
     DependencyStatusResponse,
@@ -23,6 +24,7 @@ from app.schemas.service_status import (
     ServiceStopResponse,
     ServiceStartRequest,
     ServiceStartResponse,
+    StartupReportResponse,
 )
 from app.services.service_status import get_service_status_collector
 
@@ -270,6 +272,33 @@ async def get_dependencies(
     return collector.get_dependencies()
 
 
+@router.get(
+    "/admin/startup",
+    response_model=StartupReportResponse,
+    tags=["admin"],
+    summary="Get startup timings"
+)
+@user_limiter.limit(get_limit("admin_operations"))
+async def get_startup_timings(
+    request: Request,
+    response: Response,
+    current_user=Depends(deps.get_current_admin)
+) -> StartupReportResponse:
+    """
+    Get per-step startup timings of the worker that answered.
+
+    Admin only. Shows when each step started, how long it took, whether it
+    blocked serving or ran deferred, and any step that failed.
+    """
+    engine = get_startup_engine()
+    if engine is None:
+        raise HTTPException(
+            status_code=status.HTTP_404_NOT_FOUND,
+            detail="Startup timings are not available (startup was skipped)",
+        )
+    return StartupReportResponse(**engine.report())
+
+
 @router.get(
     "/admin/metrics",
     response_model=ApplicationMetricsResponse,
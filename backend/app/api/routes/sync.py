@@ -1,20 +1,34 @@
 """Sync API endpoints for local network file synchronization."""
 
-from fastapi import APIRouter, Depends, HTTPException, Request, Response, status
-from sqlalchemy.orm import Session
+import asyncio
 import logging
+import uuid
+from typing import Optional
+
+from fastapi import APIRouter, Depends, HTTPException, Query, Request, Response, status
+from fastapi.responses import StreamingResponse
+from sqlalchemy.orm import Session
+from starlette.concurrency import iterate_in_threadpool
 
 from app.api import deps
 from app.api.deps import require_sync_allowed
 from app.core.database import get_db
 from app.models.user import User
 from app.services.sync import FileSyncService
+from app.services.sync.delta import BaseMismatchError, DeltaError
+from app.services.sync.file_sync import DELTA_TMP_DIR, FileBusyError
+from app.services.files.path_utils import QuotaExceededError
+from app.core.config import settings
 from app.services.permissions import is_privileged
 from app.core.rate_limiter import user_limiter, get_limit
 from app.schemas.sync import (
     RegisterDeviceRequest,
     SyncChangesRequest,
     SyncChangesResponse,
+    ChangesSinceResponse,
+    DeltaSignatureResponse,
+    DeltaComputeRequest,
+    DeltaApplyResponse,
     SyncStatusResponse,
     ResolveConflictRequest,
     ResolveConflictResponse,
@@ -248,6 +262,147 @@ async def detect_changes(
     return changes
 
 
+@router.get("/changes/since", response_model=ChangesSinceResponse)
+@user_limiter.limit(get_limit("sync_operations"))
+async def get_changes_since(
+    request: Request,
+    response: Response,
+    device_id: str = Query(..., description="Device identifier"),
+    cursor: Optional[str] = Query(default=None, description="Cursor from the previous sync round"),
+    limit: int = Query(default=1000, ge=1, le=10000),
+    current_user: User = Depends(deps.get_current_user),
+    sync_service: FileSyncService = Depends(get_sync_service),
+    _guard=Depends(require_sync_allowed),
+):
+    """
+    Return journaled changes after *cursor*.
+
+    Pass the ``change_token`` of the last ``/sync/changes`` round, then the
+    returned ``cursor`` of each call. Repeat while ``has_more`` is set. When
+    ``reset_required`` is set the journal no longer covers the cursor and the
+    client has to run a full ``/sync/changes`` round.
+    """
+    result = sync_service.get_changes_since(current_user.id, device_id, cursor, limit)
+    if "error" in result:
+        raise HTTPException(
+            status_code=status.HTTP_400_BAD_REQUEST,
+            detail=result["error"]
+        )
+    return result
+
+
+@router.get("/delta/signature", response_model=DeltaSignatureResponse)
+@user_limiter.limit(get_limit("sync_operations"))
+async def get_delta_signature(
+    request: Request,
+    response: Response,
+    path: str = Query(..., description="File path"),
+    current_user: User = Depends(deps.get_current_user),
+    sync_service: FileSyncService = Depends(get_sync_service),
+    _guard=Depends(require_sync_allowed),
+):
+    """Block signature of the server copy, the first step of a delta upload."""
+    try:
+        return await asyncio.to_thread(sync_service.get_signature, current_user.id, path)
+    except FileNotFoundError:
+        raise HTTPException(status_code=status.HTTP_404_NOT_FOUND, detail="File not found")
+
+
+@router.post("/delta/compute")
+@user_limiter.limit(get_limit("sync_operations"))
+async def compute_download_delta(
+    request: Request,
+    response: Response,
+    payload: DeltaComputeRequest,
+    current_user: User = Depends(deps.get_current_user),
+    sync_service: FileSyncService = Depends(get_sync_service),
+    _guard=Depends(require_sync_allowed),
+) -> StreamingResponse:
+    """
+    Stream a delta that turns the client's copy into the server copy.
+
+    The client sends the signature of its copy; the response body is a binary
+    delta (see ``services/sync/delta.py``) for the client to apply locally.
+    """
+    try:
+        blocks = await asyncio.to_thread(
+            sync_service.iter_download_delta,
+            current_user.id,
+            payload.path,
+            payload.signature.model_dump(),
+        )
+    except FileNotFoundError:
+        raise HTTPException(status_code=status.HTTP_404_NOT_FOUND, detail="File not found")
+    except DeltaError as exc:
+        raise HTTPException(status_code=status.HTTP_400_BAD_REQUEST, detail=str(exc))
+    return StreamingResponse(iterate_in_threadpool(blocks), media_type="application/octet-stream")
+
+
+@router.post("/delta/apply", response_model=DeltaApplyResponse)
+@user_limiter.limit(get_limit("sync_operations"))
+async def apply_upload_delta(
+    request: Request,
+    response: Response,
+    path: str = Query(..., description="File path"),
+    base_checksum: Optional[str] = Query(
+        default=None, description="SHA256 of the server copy the delta was computed against"
+    ),
+    current_user: User = Depends(deps.get_current_user),
+    sync_service: FileSyncService = Depends(get_sync_service),
+    _guard=Depends(require_sync_allowed),
+):
+    """
+    Update a file from a binary delta against the server copy.
+
+    The request body (``application/octet-stream``) is the delta computed from
+    ``/sync/delta/signature``. It is spooled to disk, applied to a temp copy
+    and swapped in atomically once its checksum verifies. 409 means the server
+    copy changed in the meantime (fetch a new signature and retry) or another
+    delta for the same file is in progress. Deltas above
+    ``sync_delta_max_bytes`` get 413; upload the whole file instead.
+    """
+    max_bytes = settings.sync_delta_max_bytes
+    too_large = HTTPException(
+        status_code=status.HTTP_413_REQUEST_ENTITY_TOO_LARGE,
+        detail=f"Delta larger than {max_bytes} bytes, upload the whole file",
+    )
+    declared = request.headers.get("content-length")
+    if declared and declared.isdigit() and int(declared) > max_bytes:
+        raise too_large
+
+    DELTA_TMP_DIR.mkdir(parents=True, exist_ok=True)
+    delta_path = DELTA_TMP_DIR / f"{uuid.uuid4().hex}.delta"
+    try:
+        f = await asyncio.to_thread(open, delta_path, "wb")
+        try:
+            received = 0
+            async for piece in request.stream():
+                received += len(piece)
+                if received > max_bytes:
+                    raise too_large
+                await asyncio.to_thread(f.write, piece)
+        finally:
+            await asyncio.to_thread(f.close)
+
+        return await asyncio.to_thread(
+            sync_service.apply_upload_delta, current_user.id, path, delta_path, base_checksum
+        )
+    except FileNotFoundError:
+        raise HTTPException(status_code=status.HTTP_404_NOT_FOUND, detail="File not found")
+    except BaseMismatchError as exc:
+        raise HTTPException(status_code=status.HTTP_409_CONFLICT, detail=str(exc))
+    except FileBusyError:
+        raise HTTPException(
+            status_code=status.HTTP_409_CONFLICT, detail="File is being updated by another request"
+        )
+    except QuotaExceededError as exc:
+        raise HTTPException(status_code=status.HTTP_507_INSUFFICIENT_STORAGE, detail=str(exc))
+    except DeltaError as exc:
+        raise HTTPException(status_code=status.HTTP_400_BAD_REQUEST, detail=str(exc))
+    finally:
+        delta_path.unlink(missing_ok=True)
+
+
 @router.post("/conflicts/{file_path}/resolve", response_model=ResolveConflictResponse)
 @user_limiter.limit(get_limit("sync_operations"))
 async def resolve_conflict(
@@ -316,7 +471,6 @@ async def get_sync_state(
 
     Provides a list of files with paths and SHA256 hashes for client sync.
     """
-    import asyncio
     from pathlib import Path
     from app.core.config import settings
 
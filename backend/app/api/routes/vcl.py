@@ -2,7 +2,9 @@
 import logging
 from typing import Optional
 from fastapi import APIRouter, Depends, HTTPException, Request, Response, status
+from fastapi.responses import StreamingResponse
 from sqlalchemy.orm import Session
+from starlette.concurrency import iterate_in_threadpool
 
 from app.api import deps
 from app.core.database import get_db
@@ -143,6 +145,7 @@ async def restore_file_version(
         404: Version not found or user has no access
         500: Restore operation failed
     """
+    import os
     from pathlib import Path
     from app.core.config import settings
 
@@ -174,55 +177,53 @@ async def restore_file_version(
     try:
         vcl_service = VCLService(db)
 
+        file_meta_path: str = str(file_meta.path)  # type: ignore
+        file_path = Path(settings.nas_storage_path) / file_meta_path
+
         # Get version content (decompress if needed)
         blob_id_val: int = int(version.blob_id) if version.blob_id else 0  # type: ignore
         if blob_id_val:
-            blob = version.blob
-            if not blob:
+            if not version.blob:
                 raise HTTPException(
                     status_code=status.HTTP_404_NOT_FOUND,
                     detail="Version blob not found"
                 )
-
-            # Read and decompress content
-            blob_storage_path: str = str(blob.storage_path)  # type: ignore
-            blob_path = Path(blob_storage_path)
-            if not blob_path.exists():
+            try:
+                blocks = vcl_service.iter_version_content(version)
+            except FileNotFoundError:
                 raise HTTPException(
                     status_code=status.HTTP_404_NOT_FOUND,
                     detail="Version content not found on disk"
                 )
-
-            with open(blob_path, 'rb') as f:
-                compressed_content = f.read()
-
-            content = vcl_service.decompress_content(compressed_content)
         else:
-            # Direct storage - read from file path
-            version_path = Path(settings.nas_storage_path) / file_meta.path
-            if not version_path.exists():
+            # Direct storage - the file itself is the version
+            if not file_path.exists():
                 raise HTTPException(
                     status_code=status.HTTP_404_NOT_FOUND,
                     detail="Version file not found on disk"
                 )
-
-            with open(version_path, 'rb') as f:
-                content = f.read()
-
-        # Write restored content to file
-        file_meta_path: str = str(file_meta.path)  # type: ignore
-        file_path = Path(settings.nas_storage_path) / file_meta_path
-        file_path.parent.mkdir(parents=True, exist_ok=True)
-
-        with open(file_path, 'wb') as f:
-            f.write(content)
+            blocks = None
+
+        # Stream restored content next to the file, then swap it in
+        restored_size = file_path.stat().st_size if blocks is None else 0
+        if blocks is not None:
+            file_path.parent.mkdir(parents=True, exist_ok=True)
+            tmp_path = file_path.with_name(f".{file_path.name}.restore")
+            try:
+                with open(tmp_path, 'wb') as f:
+                    for block in blocks:
+                        f.write(block)
+                        restored_size += len(block)
+                os.replace(tmp_path, file_path)
+            finally:
+                tmp_path.unlink(missing_ok=True)
 
         # Update file metadata - use SQL update to avoid Column assignment
         from sqlalchemy import update as sql_update
         db.execute(
             sql_update(FileMetadata).
             where(FileMetadata.id == file_meta.id).
-            values(size_bytes=len(content))
+            values(size_bytes=restored_size)
         )
         db.commit()
 
@@ -238,7 +239,7 @@ async def restore_file_version(
             metadata={
                 "version_id": vers_id,
                 "version_number": vers_number,
-                "file_size": len(content),
+                "file_size": restored_size,
             },
             db=db
         )
@@ -251,7 +252,7 @@ async def restore_file_version(
             file_id=file_meta_id,
             file_path=file_meta_path,
             restored_version=vers_number,
-            file_size=len(content),
+            file_size=restored_size,
         )
 
     except Exception as e:
@@ -270,6 +271,57 @@ async def restore_file_version(
         )
 
 
+@router.get("/versions/{version_id}/download")
+@user_limiter.limit(get_limit("file_list"))
+async def download_file_version(
+    request: Request,
+    response: Response,
+    version_id: int,
+    user: UserPublic = Depends(deps.get_current_user),
+    db: Session = Depends(get_db),
+) -> StreamingResponse:
+    """
+    Download the content of a file version without restoring it.
+
+    Content is streamed block by block (one chunk at a time for chunked
+    blobs), so large versions are never held in memory.
+
+    Raises:
+        404: Version not found, no access, or content missing on disk
+    """
+    from pathlib import Path
+    from urllib.parse import quote
+
+    version = db.query(FileVersion).filter(
+        FileVersion.id == version_id,
+        FileVersion.user_id == user.id
+    ).first()
+    if not version or not version.blob:
+        raise HTTPException(
+            status_code=status.HTTP_404_NOT_FOUND,
+            detail="Version not found or access denied"
+        )
+
+    try:
+        blocks = VCLService(db).iter_version_content(version)
+    except FileNotFoundError:
+        raise HTTPException(
+            status_code=status.HTTP_404_NOT_FOUND,
+            detail="Version content not found on disk"
+        )
+
+    file_meta = db.query(FileMetadata).filter(FileMetadata.id == version.file_id).first()
+    file_name = Path(file_meta.path).name if file_meta else f"version-{version_id}"
+    return StreamingResponse(
+        iterate_in_threadpool(blocks),
+        media_type="application/octet-stream",
+        headers={
+            "Content-Disposition": f"attachment; filename*=UTF-8''{quote(file_name)}",
+            "Content-Length": str(int(version.file_size)),  # type: ignore
+        },
+    )
+
+
 @router.get("/versions/diff", response_model=VersionDiffResponse)
 @user_limiter.limit(get_limit("file_list"))
 async def get_version_diff(
@@ -15,6 +15,7 @@ from app.schemas.vcl import (
     AdminStatsResponse,
     CleanupRequest,
     CleanupResponse,
+    DictionaryTrainResponse,
     VCLStorageInfo,
     VCLSettingsResponse,
     VCLSettingsUpdate,
@@ -480,6 +481,53 @@ async def trigger_manual_cleanup(
         )
 
 
+@router.post("/admin/dictionary/train", response_model=DictionaryTrainResponse)
+@user_limiter.limit(get_limit("admin_operations"))
+async def train_compression_dictionary(
+    request: Request,
+    response: Response,
+    admin: UserPublic = Depends(deps.get_current_admin),
+    db: Session = Depends(get_db),
+) -> DictionaryTrainResponse:
+    """
+    Train the zstd dictionary used for new small text versions (Admin only).
+
+    Returns:
+        Dictionary id and number of samples used
+
+    Raises:
+        409: zstd not available on this server
+    """
+    import asyncio
+
+    vcl_service = VCLService(db)
+    try:
+        dict_id, samples = await asyncio.to_thread(vcl_service.train_dictionary)
+    except ValueError as e:
+        raise HTTPException(status_code=status.HTTP_409_CONFLICT, detail=str(e))
+
+    get_audit_logger_db().log_system_config_change(
+        action="vcl_dictionary_train",
+        user=admin.username,
+        config_key="vcl_zstd_dictionary",
+        new_value={"dictionary_id": dict_id, "samples": samples},
+        db=db
+    )
+
+    if dict_id is None:
+        return DictionaryTrainResponse(
+            success=False,
+            message=f"Not enough small text versions to train on ({samples})",
+            samples=samples,
+        )
+    return DictionaryTrainResponse(
+        success=True,
+        message=f"Dictionary {dict_id} trained from {samples} versions",
+        dictionary_id=dict_id,
+        samples=samples,
+    )
+
+
 @router.get("/admin/stats", response_model=AdminStatsResponse)
 @user_limiter.limit(get_limit("admin_operations"))
 async def get_detailed_stats(
@@ -11,6 +11,7 @@ from wsgidav.dc.base_dc import BaseDomainController
 from app.core.config import settings
 from app.core.database import SessionLocal
 from app.models.user import User
+from app.compat.webdav_fastpath import with_fast_path
 from app.compat.webdav_provider import BaluHostDAVProvider
 
 _pwd_context = CryptContext(schemes=["bcrypt"], deprecated="auto")
@@ -87,6 +88,10 @@ def create_webdav_standalone_app():
     User isolation is handled inside BaluHostDAVProvider._loc_to_file_path():
     - Admin users see the entire storage root
     - Regular users see only their home directory
+
+    With ``webdav_fast_path`` the PROPFIND cache / zero-copy GET middleware
+    (webdav_fastpath.py) runs between authentication and WsgiDAV's request
+    handling.
     """
 
     verbose = 3 if settings.webdav_verbose_logging else 1
@@ -111,6 +116,8 @@ def create_webdav_standalone_app():
             "enable_loggers": ["wsgidav"] if verbose >= 3 else [],
         },
     })
+    if settings.webdav_fast_path:
+        config["middleware_stack"] = with_fast_path(DEFAULT_CONFIG["middleware_stack"])
 
     dav_app = WsgiDAVApp(config)
     return RequestLoggingMiddleware(dav_app, verbose=verbose)
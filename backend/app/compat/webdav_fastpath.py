@@ -0,0 +1,502 @@
+"""Fast paths of the WebDAV worker: PROPFIND cache, zero-copy GET, buffered PUT.
+
+Windows Explorer and macOS Finder re-PROPFIND the same folders many times a
+second. WsgiDAV answers every one by building a resource per member (a
+stat each) and looking up locks and dead properties for all of them. The
+middleware here sits behind WsgiDAV's authenticator and:
+
+- caches Depth 0/1 PROPFIND responses per user, path and request body. A
+  hit costs one stat of the requested path (its mtime covers members being
+  added, removed or renamed). Entries are dropped by this worker's own
+  write methods and by the folder-size index change log
+  (``FolderSizeIndex.changes_since``), which carries the same file-change
+  events the index gets from API operations and the inotify watcher
+  (SMB/NFS writes). A TTL bounds anything neither of those sees.
+- answers plain and single-range GETs itself with a ``FileRange`` body,
+  which ``webdav_service.SendfileGateway`` sends with ``sendfile()``.
+- feeds PUT bodies to WsgiDAV from large socket reads; the resource writes
+  them straight to the final path through a large buffer
+  (``BaluHostFileResource.begin_write``).
+
+Anything unusual (conditional headers, multiple ranges, chunked bodies,
+Depth: infinity) goes to WsgiDAV unchanged.
+"""
+
+from __future__ import annotations
+
+import hashlib
+import io
+import logging
+import os
+import sqlite3
+import threading
+import time
+from collections import OrderedDict
+from dataclasses import dataclass
+from email.utils import formatdate
+from pathlib import Path
+from typing import TYPE_CHECKING, Optional
+from urllib.parse import unquote, urlparse
+
+from wsgidav.mw.base_mw import BaseMiddleware
+
+from app.core.config import settings
+from app.services.files import path_utils
+from app.services.files.folder_size import (
+    FolderSizeIndex,
+    get_folder_size_index,
+    invalidate_folder_sizes_for_path,
+    move_folder_sizes,
+)
+
+if TYPE_CHECKING:
+    from app.compat.webdav_provider import BaluHostDAVProvider
+
+logger = logging.getLogger(__name__)
+
+MiB = 1024 * 1024
+# Read size for GET bodies that are not sent with sendfile()
+STREAM_BLOCK_SIZE = MiB
+# Socket read size for PUT bodies
+PUT_READ_SIZE = MiB
+
+MAX_PROPFIND_BODY = 64 * 1024
+MAX_CACHED_RESPONSE = 4 * MiB
+CACHE_MAX_ENTRIES = 2048
+# How often the folder-size change log is polled (seconds)
+CHANGE_SYNC_INTERVAL = 1.0
+
+# Write methods and whether they change the tree (folder sizes)
+_WRITE_METHODS = {
+    "PUT": True, "DELETE": True, "MKCOL": True, "MOVE": True, "COPY": True,
+    "PROPPATCH": False, "LOCK": False, "UNLOCK": False,
+}
+_CONDITIONAL_HEADERS = (
+    "HTTP_IF", "HTTP_IF_MATCH", "HTTP_IF_NONE_MATCH", "HTTP_IF_MODIFIED_SINCE",
+    "HTTP_IF_UNMODIFIED_SINCE", "HTTP_IF_RANGE",
+)
+
+
+# ─── Response bodies ──────────────────────────────────────────────
+
+class FileRange:
+    """WSGI response body: ``length`` bytes of an open file from ``offset``.
+
+    Servers that recognise it send it with ``sendfile()``; any other server
+    just iterates it in STREAM_BLOCK_SIZE blocks.
+    """
+
+    def __init__(self, file: io.BufferedReader, offset: int, length: int):
+        self.file = file
+        self.offset = offset
+        self.length = length
+
+    def __iter__(self):
+        self.file.seek(self.offset)
+        remaining = self.length
+        while remaining > 0:
+            chunk = self.file.read(min(STREAM_BLOCK_SIZE, remaining))
+            if not chunk:
+                return
+            remaining -= len(chunk)
+            yield chunk
+
+    def close(self) -> None:
+        self.file.close()
+
+
+class _ReadAheadInput:
+    """wsgi.input that reads the socket in PUT_READ_SIZE blocks.
+
+    WsgiDAV's PUT loop asks for a few KiB at a time; this turns that into
+    one large read per megabyte.
+    """
+
+    def __init__(self, raw, length: int):
+        self._raw = raw
+        self._remaining = length
+        self._buf = b""
+        self._pos = 0
+
+    def read(self, size: int = -1) -> bytes:
+        if self._pos >= len(self._buf):
+            if self._remaining <= 0:
+                return b""
+            self._buf = self._raw.read(min(PUT_READ_SIZE, self._remaining))
+            self._pos = 0
+            self._remaining -= len(self._buf)
+            if not self._buf:
+                self._remaining = 0
+                return b""
+        if size is None or size < 0:
+            parts = [self._buf[self._pos:]]
+            self._buf, self._pos = b"", 0
+            while self._remaining > 0:
+                block = self._raw.read(min(PUT_READ_SIZE, self._remaining))
+                if not block:
+                    break
+                self._remaining -= len(block)
+                parts.append(block)
+            return b"".join(parts)
+        chunk = self._buf[self._pos:self._pos + size]
+        self._pos += len(chunk)
+        return chunk
+
+
+# ─── PROPFIND cache ───────────────────────────────────────────────
+
+def _stamp(fs_path: str) -> tuple[int, int, int]:
+    st = os.stat(fs_path)
+    return st.st_mtime_ns, st.st_size, st.st_ino
+
+
+@dataclass
+class _Entry:
+    fs_path: str
+    stamp: tuple[int, int, int]
+    stored_at: float
+    status: str
+    headers: list[tuple[str, str]]
+    body: bytes
+
+
+class PropfindCache:
+    """PROPFIND responses keyed by (user, role, path, depth, body digest)."""
+
+    def __init__(
+        self,
+        ttl: float,
+        *,
+        index: Optional[FolderSizeIndex] = None,
+        max_entries: int = CACHE_MAX_ENTRIES,
+    ):
+        self.ttl = ttl
+        self.max_entries = max_entries
+        self.hits = 0
+        self.misses = 0
+        self._index = index
+        self._cursor: Optional[int] = None
+        self._last_sync = 0.0
+        self._sync_lock = threading.Lock()
+        self._entries: OrderedDict[tuple, _Entry] = OrderedDict()
+        self._lock = threading.Lock()
+        # Bumped by every invalidation; a response computed across one is not stored
+        self.generation = 0
+
+    def __len__(self) -> int:
+        return len(self._entries)
+
+    def get(self, key: tuple) -> Optional[_Entry]:
+        with self._lock:
+            entry = self._entries.get(key)
+        if entry is not None:
+            fresh = time.monotonic() - entry.stored_at < self.ttl
+            try:
+                fresh = fresh and _stamp(entry.fs_path) == entry.stamp
+            except OSError:
+                fresh = False
+            with self._lock:
+                if fresh and key in self._entries:
+                    self._entries.move_to_end(key)
+                    self.hits += 1
+                    return entry
+                self._entries.pop(key, None)
+        with self._lock:
+            self.misses += 1
+        return None
+
+    def put(self, key: tuple, entry: _Entry, generation: int) -> None:
+        with self._lock:
+            if generation != self.generation:
+                return
+            self._entries[key] = entry
+            self._entries.move_to_end(key)
+            while len(self._entries) > self.max_entries:
+                self._entries.popitem(last=False)
+
+    def invalidate(self, fs_path: str) -> None:
+        """``fs_path`` or something directly inside it changed."""
+        fs_path = fs_path.rstrip(os.sep) or os.sep
+        parent = os.path.dirname(fs_path)
+        prefix = fs_path if fs_path.endswith(os.sep) else fs_path + os.sep
+        with self._lock:
+            self.generation += 1
+            doomed = [
+                key for key, entry in self._entries.items()
+                if entry.fs_path in (fs_path, parent) or entry.fs_path.startswith(prefix)
+            ]
+            for key in doomed:
+                del self._entries[key]
+
+    def clear(self) -> None:
+        with self._lock:
+            self.generation += 1
+            self._entries.clear()
+
+    def sync(self) -> None:
+        """Apply the folder-size index change log (at most once a second)."""
+        if self._index is None:
+            return
+        if time.monotonic() - self._last_sync < CHANGE_SYNC_INTERVAL:
+            return
+        if not self._sync_lock.acquire(blocking=False):
+            return  # another request thread is syncing
+        try:
+            self._last_sync = time.monotonic()
+            if self._cursor is None:
+                self._cursor = self._index.change_cursor()
+                return
+            self._cursor, changed = self._index.changes_since(self._cursor)
+        except sqlite3.Error as exc:
+            logger.debug("Folder size change log unavailable: %s", exc)
+            self.clear()
+            return
+        finally:
+            self._sync_lock.release()
+        if changed is None or None in changed:
+            self.clear()
+            return
+        root = self._index.root
+        for rel in changed:
+            self.invalidate(str(root / rel) if rel else str(root))
+
+
+# ─── Middleware ───────────────────────────────────────────────────
+
+def _parse_range(header: str, size: int) -> Optional[tuple[int, int]]:
+    """(offset, length) of a single satisfiable byte range, else None."""
+    unit, _, spec = header.partition("=")
+    if unit.strip().lower() != "bytes" or "," in spec:
+        return None
+    first, sep, last = spec.strip().partition("-")
+    if not sep:
+        return None
+    try:
+        if first:
+            start = int(first)
+            end = int(last) if last else size - 1
+        else:
+            start = max(0, size - int(last))
+            end = size - 1
+    except ValueError:
+        return None
+    end = min(end, size - 1)
+    if start < 0 or start > end:
+        return None
+    return start, end - start + 1
+
+
+def _replay_headers(headers: list[tuple[str, str]]) -> list[tuple[str, str]]:
+    out = [(k, v) for k, v in headers if k.lower() != "date"]
+    if len(out) != len(headers):
+        out.append(("Date", formatdate(usegmt=True)))
+    return out
+
+
+class WebdavFastPath(BaseMiddleware):
+    """WsgiDAV middleware for the fast paths (see module docstring).
+
+    Inserted right before WsgiDAV's RequestResolver, so requests arrive
+    authenticated (``wsgidav.auth.user_name`` / ``baluhost.user_role``).
+    """
+
+    def __init__(self, wsgidav_app, next_app, config):
+        super().__init__(wsgidav_app, next_app, config)
+        self.provider: "BaluHostDAVProvider" = config["provider_mapping"]["/"]
+        index = None
+        try:
+            index = get_folder_size_index()
+        except Exception:
+            logger.warning("Folder size index unavailable; PROPFIND cache relies on TTL", exc_info=True)
+        self.cache = PropfindCache(settings.webdav_propfind_cache_ttl, index=index)
+
+    def is_disabled(self) -> bool:
+        return False
+
+    def __call__(self, environ, start_response):
+        method = environ.get("REQUEST_METHOD", "")
+        if method == "PROPFIND":
+            return self._propfind(environ, start_response)
+        if method in ("GET", "HEAD"):
+            response = self._get(environ, start_response)
+            if response is not None:
+                return response
+        elif method == "PUT":
+            self._buffer_input(environ)
+        if method in _WRITE_METHODS:
+            return self._write(environ, start_response)
+        return self.next_app(environ, start_response)
+
+    def _fs_path(self, path: str, environ) -> Optional[str]:
+        try:
+            return self.provider._loc_to_file_path(path, environ)
+        except (ValueError, RuntimeError):
+            return None  # traversal: WsgiDAV produces the error response
+
+    # --- PROPFIND ---------------------------------------------------------
+
+    def _propfind(self, environ, start_response):
+        self.cache.sync()
+        depth = environ.get("HTTP_DEPTH", "infinity")
+        if depth not in ("0", "1") or environ.get("HTTP_IF"):
+            return self.next_app(environ, start_response)
+        try:
+            length = int(environ.get("CONTENT_LENGTH") or 0)
+        except ValueError:
+            return self.next_app(environ, start_response)
+        if (
+            length > MAX_PROPFIND_BODY
+            or environ.get("HTTP_TRANSFER_ENCODING", "").lower() == "chunked"
+        ):
+            return self.next_app(environ, start_response)
+        fs_path = self._fs_path(environ.get("PATH_INFO", "/"), environ)
+        if fs_path is None:
+            return self.next_app(environ, start_response)
+
+        body = environ["wsgi.input"].read(length) if length else b""
+        environ["wsgi.input"] = io.BytesIO(body)
+        key = (
+            environ.get("wsgidav.auth.user_name", ""),
+            environ.get("baluhost.user_role", ""),
+            environ.get("PATH_INFO", "/"),
+            depth,
+            hashlib.sha1(body).digest(),
+        )
+        hit = self.cache.get(key)
+        if hit is not None:
+            start_response(hit.status, _replay_headers(hit.headers))
+            return [hit.body]
+
+        try:
+            stamp = _stamp(fs_path)
+        except OSError:
+            return self.next_app(environ, start_response)
+        generation = self.cache.generation
+        captured: dict = {}
+
+        def capture(status, headers, exc_info=None):
+            captured["status"], captured["headers"] = status, list(headers)
+            return start_response(status, headers, exc_info)
+
+        result = self.next_app(environ, capture)
+        try:
+            response = b"".join(result)
+        finally:
+            if hasattr(result, "close"):
+                result.close()
+        if (
+            captured.get("status", "").startswith("207")
+            and len(response) <= MAX_CACHED_RESPONSE
+            # Lock timeouts expire on their own; never replay an active lock
+            and b"activelock" not in response
+        ):
+            self.cache.put(
+                key,
+                _Entry(fs_path, stamp, time.monotonic(), captured["status"],
+                       captured["headers"], response),
+                generation,
+            )
+        return [response]
+
+    # --- GET --------------------------------------------------------------
+
+    def _get(self, environ, start_response):
+        if any(environ.get(h) for h in _CONDITIONAL_HEADERS):
+            return None
+        path = environ.get("PATH_INFO", "/")
+        fs_path = self._fs_path(path, environ)
+        if fs_path is None:
+            return None
+        # Normally set by the RequestResolver; resources read it on creation
+        environ.setdefault("wsgidav.provider", self.provider)
+        try:
+            res = self.provider.get_resource_inst(path, environ)
+        except (ValueError, RuntimeError, OSError):
+            return None
+        if res is None or res.is_collection:
+            return None
+
+        size = res.get_content_length()
+        offset, length = 0, size
+        status = "200 OK"
+        headers = [
+            ("Content-Type", res.get_content_type()),
+            ("Last-Modified", formatdate(res.get_last_modified(), usegmt=True)),
+            ("ETag", f'"{res.get_etag()}"'),
+            ("Accept-Ranges", "bytes"),
+            ("Date", formatdate(usegmt=True)),
+        ]
+        range_header = environ.get("HTTP_RANGE")
+        if range_header:
+            byte_range = _parse_range(range_header, size)
+            if byte_range is None:
+                return None  # multiple / unsatisfiable ranges: WsgiDAV answers
+            offset, length = byte_range
+            status = "206 Partial Content"
+            headers.append(("Content-Range", f"bytes {offset}-{offset + length - 1}/{size}"))
+        headers.append(("Content-Length", str(length)))
+
+        if environ["REQUEST_METHOD"] == "HEAD":
+            start_response(status, headers)
+            return [b""]
+        try:
+            fh = open(fs_path, "rb")
+        except OSError:
+            return None
+        start_response(status, headers)
+        return FileRange(fh, offset, length)
+
+    # --- writes -----------------------------------------------------------
+
+    @staticmethod
+    def _buffer_input(environ) -> None:
+        if environ.get("HTTP_TRANSFER_ENCODING", "").lower() == "chunked":
+            return
+        try:
+            length = int(environ.get("CONTENT_LENGTH") or 0)
+        except ValueError:
+            return
+        if length > PUT_READ_SIZE:
+            environ["wsgi.input"] = _ReadAheadInput(environ["wsgi.input"], length)
+
+    def _write(self, environ, start_response):
+        method = environ["REQUEST_METHOD"]
+        source = self._fs_path(environ.get("PATH_INFO", "/"), environ)
+        target = None
+        destination = environ.get("HTTP_DESTINATION")
+        if destination and method in ("MOVE", "COPY"):
+            target = self._fs_path(unquote(urlparse(destination).path), environ)
+        moved_dir = method == "MOVE" and source is not None and os.path.isdir(source)
+        captured: dict = {}
+
+        def capture(status, headers, exc_info=None):
+            captured["status"] = status
+            return start_response(status, headers, exc_info)
+
+        try:
+            return self.next_app(environ, capture)
+        finally:
+            for path in (source, target):
+                if path is not None:
+                    self.cache.invalidate(path)
+            if _WRITE_METHODS[method] and captured.get("status", "").startswith("2"):
+                self._update_folder_sizes(source, target, moved_dir)
+
+    @staticmethod
+    def _update_folder_sizes(source: Optional[str], target: Optional[str], moved_dir: bool) -> None:
+        """Keep folder sizes current without waiting for the inotify watcher."""
+        if moved_dir and source is not None and target is not None:
+            move_folder_sizes(Path(source), Path(target))
+        for path in (source, target):
+            if path is not None:
+                invalidate_folder_sizes_for_path(Path(path).parent, path_utils.ROOT_DIR)
+
+
+def with_fast_path(middleware_stack: list) -> list:
+    """``middleware_stack`` with WebdavFastPath inserted before the RequestResolver."""
+    stack = list(middleware_stack)
+    position = next(
+        (i for i, mw in enumerate(stack) if "RequestResolver" in str(mw)), len(stack)
+    )
+    stack.insert(position, WebdavFastPath)
+    return stack
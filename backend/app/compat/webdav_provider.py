@@ -4,6 +4,7 @@ from __future__ import annotations
 
 import os
 import shutil
+import sys
 from pathlib import Path
 from typing import TYPE_CHECKING, cast
 
@@ -13,6 +14,25 @@ from wsgidav.fs_dav_provider import FileResource, FilesystemProvider, FolderReso
 if TYPE_CHECKING:
     from wsgidav.dav_provider import _DAVResource
 
+# Write buffer for PUT bodies (WsgiDAV's default is 8 KiB)
+PUT_BUFFER_SIZE = 1024 * 1024
+
+
+class BaluHostFileResource(FileResource):
+    """File resource that reuses its stat and writes PUTs through a large buffer."""
+
+    def get_etag(self) -> str:
+        # Same value as util.get_file_etag() on POSIX, without stat-ing again
+        if sys.platform == "win32":
+            return super().get_etag()
+        st = self.file_stat
+        return f"{st.st_ino}-{int(st.st_mtime)}-{st.st_size}"
+
+    def begin_write(self, *, content_type=None):
+        if self.provider.readonly:
+            return super().begin_write(content_type=content_type)
+        return open(self._file_path, "wb", PUT_BUFFER_SIZE)
+
 
 class BaluHostFolderResource(FolderResource):
     """Folder resource that reports disk capacity from the storage root.
@@ -38,9 +58,29 @@ class BaluHostFolderResource(FolderResource):
         if os.path.isdir(fp):
             return BaluHostFolderResource(path, self.environ, fp)
         elif os.path.isfile(fp):
-            return FileResource(path, self.environ, fp)
+            return BaluHostFileResource(path, self.environ, fp)
         return None
 
+    def get_member_list(self) -> list[_DAVResource]:  # type: ignore[override]
+        """Members from one scandir pass: d_type picks the class, one stat each.
+
+        The default goes through get_member() per name (isdir + isfile +
+        the resource's own stat). Entries that vanish meanwhile, sockets and
+        broken symlinks are skipped.
+        """
+        members: list[_DAVResource] = []
+        with os.scandir(self._file_path) as it:
+            for entry in it:
+                path = util.join_uri(self.path, entry.name)
+                try:
+                    if entry.is_dir():
+                        members.append(BaluHostFolderResource(path, self.environ, entry.path))
+                    elif entry.is_file():
+                        members.append(BaluHostFileResource(path, self.environ, entry.path))
+                except OSError:
+                    continue
+        return members
+
 
 class BaluHostDAVProvider(FilesystemProvider):
     """WebDAV provider with per-user root isolation.
@@ -83,4 +123,4 @@ class BaluHostDAVProvider(FilesystemProvider):
             return None
         if os.path.isdir(fp):
             return BaluHostFolderResource(path, environ, fp)
-        return FileResource(path, environ, fp)
+        return BaluHostFileResource(path, environ, fp)
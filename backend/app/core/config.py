@@ -67,6 +67,8 @@ class Settings(BaseSettings):
     ACCESS_TOKEN_EXPIRE_MINUTES: int = 15  # Access token TTL (short)
     REFRESH_TOKEN_EXPIRE_DAYS: int = 7  # Refresh token TTL (long)
     privileged_roles: list[str] = ["admin"]
+    auth_cache_ttl_seconds: float = 30.0  # Per-worker cache of resolved users, API keys, share grants (0 = off)
+    auth_cache_max_entries: int = 4096
     
     # Registration control — defaults to False for security (production requires admin-created accounts)
     registration_enabled: bool = False
@@ -127,6 +129,10 @@ class Settings(BaseSettings):
     smart_scan_enabled: bool = True
     # Interval in minutes between automatic SMART scans when enabled (default: 60)
     smart_scan_interval_minutes: int = 60
+    # SMART engine (monitoring worker): seconds between reads of one disk and
+    # how many smartctl processes may run at once. Disks in standby are skipped.
+    smart_device_interval_seconds: int = 120
+    smart_max_parallel: int = 4
 
     # Storage paths
     nas_storage_path: str = "./storage"
@@ -134,11 +140,40 @@ class Settings(BaseSettings):
     nas_quota_bytes: int | None = 5 * 1024 * 1024 * 1024
     nas_backup_path: str = "./backups"
 
+    # Folder sizes: persistent index in nas_storage_path/.system; the primary
+    # worker watches indexed directories with inotify to catch SMB/NFS writes
+    folder_size_watch_enabled: bool = True
+    folder_size_watch_debounce_seconds: float = 2.0
+
+    # Bulk ownership transfers (services/files/ownership_jobs.py): rows per
+    # committed batch; smaller directories are transferred in one transaction
+    ownership_transfer_batch_size: int = 5000
+
     # Linux group for shared storage ownership (backend + Samba)
     storage_group: str = "baluhost"
 
+    # Zero-copy downloads via nginx: prefix of the internal locations
+    # "<prefix>/storage/" (alias = storage root) and "<prefix>/cache/" (alias =
+    # SSD file cache root), see deploy/nginx/baluhost.conf. Empty = the
+    # backend streams file bodies itself.
+    download_accel_redirect_prefix: str = ""
+
     # VCL storage path (empty = use nas_storage_path/.system/versions)
     vcl_storage_path: str = ""
+    # VCL blob codec: "zstd" (gzip if the zstandard package is missing) or "gzip"
+    vcl_codec: str = "zstd"
+    vcl_zstd_level: int = 3
+    vcl_compression_threads: int = 0  # 0 = auto (up to 4)
+
+    # Sync change journal: days of history kept for "changes since cursor".
+    # Devices whose cursor is older than this get reset_required and do a full
+    # detect_changes round.
+    sync_journal_retention_days: int = 30
+    # Delta sync limits: largest delta body /sync/delta/apply accepts, and
+    # byte-wise rolling-checksum steps /sync/delta/compute spends per request
+    # (~0.5 us each) before sending the rest of the file as literal data.
+    sync_delta_max_bytes: int = 256 * 1024 * 1024
+    sync_delta_max_rolled_bytes: int = 32 * 1024 * 1024
 
     # Managed SSH known_hosts for remote-server connections (TOFU host-key pinning).
     # Empty = use nas_storage_path/.system/ssh/known_hosts (persists across deploys;
@@ -146,6 +181,12 @@ class Settings(BaseSettings):
     ssh_known_hosts_path: str = ""
     nas_backup_retention_days: int = 30
     nas_backup_max_count: int = 10
+    # Backup archive format: "chunked" (content-addressed chunk packs plus a
+    # manifest per backup, services/backup/archive.py) or "tar" (legacy .tar.gz)
+    backup_format: str = "chunked"
+    backup_reader_threads: int = 0  # 0 = auto from the RAID layout
+    backup_compression_threads: int = 0  # 0 = auto (up to 4)
+    backup_zstd_level: int = 3
 
     # Backup scheduler options
     # Enable automatic periodic backups (recommended for production)
@@ -164,10 +205,29 @@ class Settings(BaseSettings):
     monitoring_db_persist_interval: int = 12  # Persist to DB every N samples (1 min at 5s)
     monitoring_default_retention_hours: int = 168  # 7 days default retention
     monitoring_cleanup_interval_hours: int = 6  # Run cleanup every N hours
+    # "events": netlink/pidfd process tracking where supported (falls back to
+    # scanning); "scan": psutil scan of all processes on every sample
+    monitoring_process_tracking: str = "events"
+    monitoring_rollup_retention_days_1m: int = 14  # 1-minute rollup buckets
+    monitoring_rollup_retention_days_15m: int = 180  # 15-minute rollup buckets
+    monitoring_rollup_retention_days_1h: int = 730  # Hourly rollup buckets (2 years)
+
+    # Latency histograms (core/tracing.py) exported at /api/metrics. Route
+    # latency is always recorded; the sample rate is the fraction of requests
+    # whose DB queries and hot-path spans are timed as well.
+    tracing_enabled: bool = True
+    tracing_sample_rate: float = 1.0
 
     # Scheduler worker service token (auto-generated if empty)
     scheduler_service_token: str = ""  # Service token for scheduler-worker -> backend API calls
 
+    # Scheduler worker job pool (services/scheduler/pool.py): concurrent jobs
+    # in total (one slot is kept for "run now" requests) and per resource class.
+    scheduler_max_concurrent_jobs: int = 4
+    scheduler_array_io_slots: int = 1
+    scheduler_cpu_slots: int = 1
+    scheduler_network_slots: int = 2
+
     # Power management configuration (CPU frequency scaling)
     power_management_enabled: bool = True  # Enable/disable power management
     power_force_dev_backend: bool = False  # Force dev backend even on Linux
@@ -189,6 +249,12 @@ class Settings(BaseSettings):
     ssd_cache_default_mode: str = "writethrough"  # Default cache mode (writethrough|writeback|writearound)
     ssd_cache_force_dev_backend: bool = False  # Force dev backend even on Linux
 
+    # SSD file cache fill pipeline (per worker, see services/cache/fill.py)
+    ssd_file_cache_fill_queue_size: int = 64  # Pending fills before new ones are dropped
+    ssd_file_cache_fill_concurrency: int = 1  # Parallel fills per worker
+    ssd_file_cache_fill_bandwidth_mb_s: float = 32.0  # HDD read budget per worker, 0 = unlimited
+    ssd_file_cache_readahead: bool = True  # Prefetch the next episode/track of a media folder
+
     # Sleep mode configuration
     sleep_mode_enabled: bool = True  # Enable/disable sleep mode service
 
@@ -205,6 +271,10 @@ class Settings(BaseSettings):
     webdav_port: int = 8080
     webdav_ssl_enabled: bool = True
     webdav_verbose_logging: bool = False
+    # PROPFIND response cache, sendfile() GETs, large-buffer PUTs (compat/webdav_fastpath.py)
+    webdav_fast_path: bool = True
+    webdav_propfind_cache_ttl: int = 60  # seconds; upper bound for changes no event reports
+    webdav_server_threads: int = 32  # Explorer/Finder keep many connections open
 
     # Samba (SMB/CIFS) configuration
     samba_shares_conf_path: str = "/etc/samba/baluhost-shares.conf"
@@ -219,6 +289,13 @@ class Settings(BaseSettings):
     microsoft_client_id: str = ""
     microsoft_client_secret: str = ""
 
+    # Cloud transfer engine (services/cloud/transfer.py): parallel streams per
+    # job (adaptive between 1 and the maximum) and multipart download sizing
+    cloud_transfer_max_streams: int = 8
+    cloud_transfer_initial_streams: int = 2
+    cloud_transfer_part_size_mb: int = 64
+    cloud_transfer_multipart_cutoff_mb: int = 256
+
     # Database configuration
     database_url: str | None = None
     database_type: str = "sqlite"
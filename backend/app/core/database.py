@@ -12,6 +12,7 @@ from sqlalchemy.orm import sessionmaker, Session
 from sqlalchemy.pool import QueuePool
 
 from app.core.config import settings
+from app.core.tracing import instrument_engine
 from app.models import Base
 
 logger = logging.getLogger(__name__)
@@ -125,6 +126,9 @@ else:
         echo=False
     )
 
+# Per-statement latency histograms (no-op until the tracer is started)
+instrument_engine(engine)
+
 # Session factory
 SessionLocal = sessionmaker(autocommit=False, autoflush=False, bind=engine)
 
@@ -0,0 +1,354 @@
+"""Per-worker cache of auth decisions with cross-worker invalidation.
+
+Every authenticated request resolves its user (JWT ``sub`` or API key), and
+file requests check share grants on top — each a database round trip in each
+Uvicorn worker, almost always returning what the previous request got.
+Resolved decisions are kept in a small in-process LRU per worker; the
+freshness across workers comes from generation counters in shared memory
+(``decision_cache.bin`` under the monitoring SHM directory):
+
+- every namespace (``NAMESPACES``) has ``SLOTS`` counters that keys hash
+  into, plus one namespace-wide counter;
+- a cached value remembers both counters as they were *before* its lookup
+  ran, so a change committed while it was loading still invalidates it;
+- a change bumps the counters after its transaction commits, and every
+  worker's next lookup of an affected key reloads.
+
+Changes are picked up from ORM events (``install_invalidation_hooks``):
+updates and deletes of ``User``, ``ApiKey`` and ``FileShare`` rows, new
+shares, renamed or deleted ``FileMetadata`` rows, and ORM bulk
+``update()``/``delete()`` on those tables. Writes that bypass the ORM are
+seen after ``ttl`` seconds at the latest.
+
+A lookup reads two counters from the mapping; a bump takes a ``lockf``
+lock (it is rare). Without the mapping (Windows dev mode, no /dev/shm) the
+counters are process-local, which is exact for a single process.
+
+Disabled until ``enable()`` (lifespan startup of a worker): while disabled
+every lookup goes straight to the loader, so tests and scripts always read
+the database. The other long-running processes (scheduler, monitoring and
+WebDAV workers) call ``enable_invalidation()`` instead: they cache nothing
+but still bump the shared counters for what they commit. Anything else
+writing these tables (one-off scripts) is seen after ``ttl`` at the latest.
+"""
+from __future__ import annotations
+
+import logging
+import mmap
+import os
+import struct
+import threading
+import time
+import zlib
+from collections import OrderedDict
+from functools import lru_cache
+from pathlib import Path
+from typing import Any, Callable, Optional, TypeVar
+
+from sqlalchemy import inspect as sa_inspect
+
+try:  # pragma: no cover - platform dependent
+    import fcntl
+except ImportError:  # Windows dev mode: single process
+    fcntl = None  # type: ignore[assignment]
+
+logger = logging.getLogger(__name__)
+
+T = TypeVar("T")
+
+NAMESPACES = ("user", "api_key", "shares")
+SLOTS = 4096
+
+_MAGIC = b"BHDC"
+_VERSION = 1
+_HEADER = struct.Struct("<4sIII")  # magic | version | namespaces | slots
+_HEADER_SIZE = 64
+_U64 = struct.Struct("<Q")
+
+TABLE_FILE = "decision_cache.bin"
+DEFAULT_TTL = 30.0
+DEFAULT_MAX_ENTRIES = 4096
+
+_PENDING = "decision_cache_pending"
+
+
+def _slot(key: str) -> int:
+    return zlib.crc32(key.encode("utf-8")) % SLOTS
+
+
+class GenerationTable:
+    """Shared invalidation counters (see module docstring)."""
+
+    def __init__(self, path: Optional[Path] = None) -> None:
+        self.path = path
+        self.shared = False
+        self._size = _HEADER_SIZE + len(NAMESPACES) * (SLOTS + 1) * _U64.size
+        self._fd: Optional[int] = None
+        self._mm: Optional[mmap.mmap] = None
+        self._lock = threading.Lock()
+        if path is not None:
+            self._open(path)
+        self._buf = self._mm if self._mm is not None else bytearray(self._size)
+
+    def _open(self, path: Path) -> None:
+        try:
+            path.parent.mkdir(parents=True, exist_ok=True)
+            self._fd = os.open(path, os.O_RDWR | os.O_CREAT, 0o600)
+            if fcntl is not None:
+                fcntl.lockf(self._fd, fcntl.LOCK_EX)
+            try:
+                if os.fstat(self._fd).st_size != self._size:
+                    os.ftruncate(self._fd, self._size)
+                self._mm = mmap.mmap(self._fd, self._size)
+                if _HEADER.unpack_from(self._mm, 0) != (_MAGIC, _VERSION, len(NAMESPACES), SLOTS):
+                    self._mm[:] = bytes(self._size)
+                    _HEADER.pack_into(self._mm, 0, _MAGIC, _VERSION, len(NAMESPACES), SLOTS)
+            finally:
+                if fcntl is not None:
+                    fcntl.lockf(self._fd, fcntl.LOCK_UN)
+            self.shared = fcntl is not None
+        except (OSError, ValueError) as exc:
+            logger.warning("Shared decision cache table unavailable, invalidation is per worker: %s", exc)
+            self.close()
+
+    def close(self) -> None:
+        if self._mm is not None:
+            try:
+                self._mm.close()
+            except (BufferError, ValueError):
+                pass
+            self._mm = None
+        if self._fd is not None:
+            os.close(self._fd)
+            self._fd = None
+
+    @staticmethod
+    def _offset(namespace: int, slot: int) -> int:
+        return _HEADER_SIZE + (namespace * (SLOTS + 1) + slot) * _U64.size
+
+    def read(self, namespace: int, slot: int) -> tuple[int, int]:
+        """(key slot counter, namespace-wide counter)."""
+        buf = self._buf
+        return (
+            _U64.unpack_from(buf, self._offset(namespace, slot))[0],
+            _U64.unpack_from(buf, self._offset(namespace, SLOTS))[0],
+        )
+
+    def bump(self, namespace: int, slot: Optional[int]) -> None:
+        """Advance one key slot (or, with ``slot=None``, the whole namespace)."""
+        offset = self._offset(namespace, SLOTS if slot is None else slot)
+        with self._lock:
+            if self.shared:
+                fcntl.lockf(self._fd, fcntl.LOCK_EX, _U64.size, offset)
+            try:
+                value = _U64.unpack_from(self._buf, offset)[0]
+                _U64.pack_into(self._buf, offset, (value + 1) & 0xFFFFFFFFFFFFFFFF)
+            finally:
+                if self.shared:
+                    fcntl.lockf(self._fd, fcntl.LOCK_UN, _U64.size, offset)
+
+
+class DecisionCache:
+    """In-process LRU of decisions, validated against a ``GenerationTable``."""
+
+    def __init__(self, ttl: float = DEFAULT_TTL, max_entries: int = DEFAULT_MAX_ENTRIES) -> None:
+        self.ttl = ttl
+        self.max_entries = max_entries
+        self.table: Optional[GenerationTable] = None
+        self._publish_table: Optional[GenerationTable] = None  # bumped, never read
+        self._entries: OrderedDict[tuple[str, str], tuple[Any, tuple[int, int], float]] = OrderedDict()
+        self._lock = threading.Lock()
+        self.hits = 0
+        self.misses = 0
+        self.invalidations = 0
+
+    @property
+    def enabled(self) -> bool:
+        return self.table is not None and self.ttl > 0
+
+    def enable(self, table: Optional[GenerationTable] = None) -> None:
+        """Start caching (per worker); *table* defaults to the shared one."""
+        if table is None:
+            from app.services.monitoring.shm import SHM_DIR
+            table = GenerationTable(SHM_DIR / TABLE_FILE)
+        self.table = table
+        install_invalidation_hooks()
+
+    def enable_invalidation(self, table: Optional[GenerationTable] = None) -> None:
+        """Publish this process's committed changes to the workers' caches, caching nothing."""
+        if table is None:
+            from app.services.monitoring.shm import SHM_DIR
+            table = GenerationTable(SHM_DIR / TABLE_FILE)
+        self._publish_table = table
+        install_invalidation_hooks()
+
+    def disable(self) -> None:
+        self.table = None
+        self._publish_table = None
+        with self._lock:
+            self._entries.clear()
+
+    def get_or_load(self, namespace: str, key: Any, loader: Callable[[], T]) -> T:
+        """Cached result of *loader* for *key*. ``None`` results are not cached."""
+        table = self.table
+        if table is None or self.ttl <= 0:
+            return loader()
+        key = str(key)
+        entry_key = (namespace, key)
+        generation = table.read(NAMESPACES.index(namespace), _slot(key))
+        now = time.monotonic()
+        with self._lock:
+            entry = self._entries.get(entry_key)
+            if entry is not None:
+                value, seen, expires = entry
+                if seen == generation and expires > now:
+                    self._entries.move_to_end(entry_key)
+                    self.hits += 1
+                    return value
+                del self._entries[entry_key]
+            self.misses += 1
+
+        value = loader()
+        if value is not None:
+            with self._lock:
+                self._entries[entry_key] = (value, generation, now + self.ttl)
+                self._entries.move_to_end(entry_key)
+                while len(self._entries) > self.max_entries:
+                    self._entries.popitem(last=False)
+        return value
+
+    def invalidate(self, namespace: str, key: Any = None) -> None:
+        """Drop *key* (or the whole namespace) in every worker."""
+        table = self.table or self._publish_table
+        if table is None:
+            return
+        ns = NAMESPACES.index(namespace)
+        if key is None:
+            table.bump(ns, None)
+            with self._lock:
+                for entry_key in [k for k in self._entries if k[0] == namespace]:
+                    del self._entries[entry_key]
+        else:
+            key = str(key)
+            table.bump(ns, _slot(key))
+            with self._lock:
+                self._entries.pop((namespace, key), None)
+        self.invalidations += 1
+
+    def get_stats(self) -> dict[str, Any]:
+        with self._lock:
+            size = len(self._entries)
+        return {
+            "enabled": self.enabled,
+            "shared": bool(self.table and self.table.shared),
+            "entries": size,
+            "hits": self.hits,
+            "misses": self.misses,
+            "invalidations": self.invalidations,
+        }
+
+
+# ── ORM invalidation hooks ───────────────────────────────────────────────────
+
+_hooks_installed = False
+
+
+@lru_cache(maxsize=1)
+def _models() -> tuple[type, type, type, type]:
+    from app.models.api_key import ApiKey
+    from app.models.file_metadata import FileMetadata
+    from app.models.file_share import FileShare
+    from app.models.user import User
+
+    return User, ApiKey, FileShare, FileMetadata
+
+
+def _changed_keys(obj: Any, deleted: bool) -> list[tuple[str, Any]]:
+    User, ApiKey, FileShare, FileMetadata = _models()
+    if isinstance(obj, User):
+        return [("user", obj.id)]
+    if isinstance(obj, ApiKey):
+        return [("api_key", obj.key_hash)]
+    if isinstance(obj, FileShare):
+        if sa_inspect(obj).attrs.shared_with_user_id.history.deleted:
+            return [("shares", None)]  # moved to another user
+        return [("shares", obj.shared_with_user_id)]
+    if isinstance(obj, FileMetadata):
+        # Grants are cached by path: a rename or delete may change any user's
+        if deleted or sa_inspect(obj).attrs.path.history.has_changes():
+            return [("shares", None)]
+    return []
+
+
+def _collect_flush(session, flush_context) -> None:
+    pending: set = session.info.setdefault(_PENDING, set())
+    FileShare = _models()[2]
+    for obj in session.new:
+        if isinstance(obj, FileShare):
+            pending.add(("shares", obj.shared_with_user_id))
+    for obj in session.dirty:
+        pending.update(_changed_keys(obj, deleted=False))
+    for obj in session.deleted:
+        pending.update(_changed_keys(obj, deleted=True))
+
+
+def _collect_bulk(orm_execute_state) -> None:
+    if not (orm_execute_state.is_update or orm_execute_state.is_delete):
+        return
+    if not orm_execute_state.is_orm_statement:
+        return  # Core table statements (e.g. API key usage counters)
+    mapper = orm_execute_state.bind_mapper
+    namespace = _BULK_NAMESPACES.get(mapper.class_.__name__) if mapper is not None else None
+    if namespace is not None:
+        orm_execute_state.session.info.setdefault(_PENDING, set()).add((namespace, None))
+
+
+_BULK_NAMESPACES = {
+    "User": "user",
+    "ApiKey": "api_key",
+    "FileShare": "shares",
+    "FileMetadata": "shares",
+}
+
+
+def _publish(session) -> None:
+    pending = session.info.pop(_PENDING, None)
+    if not pending:
+        return
+    cache = get_decision_cache()
+    for namespace, key in pending:
+        cache.invalidate(namespace, key)
+
+
+def _discard(session) -> None:
+    session.info.pop(_PENDING, None)
+
+
+def install_invalidation_hooks() -> None:
+    """Bump generations for committed changes (idempotent)."""
+    global _hooks_installed
+    if _hooks_installed:
+        return
+    from sqlalchemy import event
+    from sqlalchemy.orm import Session
+
+    event.listen(Session, "after_flush", _collect_flush)
+    event.listen(Session, "do_orm_execute", _collect_bulk)
+    event.listen(Session, "after_commit", _publish)
+    event.listen(Session, "after_rollback", _discard)
+    _hooks_installed = True
+
+
+_cache: Optional[DecisionCache] = None
+
+
+def get_decision_cache() -> DecisionCache:
+    """This worker's decision cache (created disabled)."""
+    global _cache
+    if _cache is None:
+        from app.core.config import settings
+        _cache = DecisionCache(
+            ttl=settings.auth_cache_ttl_seconds,
+            max_entries=settings.auth_cache_max_entries,
+        )
+    return _cache
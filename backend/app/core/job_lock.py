@@ -0,0 +1,40 @@
+"""Per-job advisory locks shared by all workers.
+
+Long-running background jobs (cloud import/export, bulk ownership transfers)
+hold ``job_lock(kind, id)`` while they execute; sync delta uploads hold
+``job_lock("file", file_id)`` while they rewrite a file. The lock is an ``flock`` on
+``job-<kind>-<id>.lock`` in the monitoring SHM directory, so it is released
+by the kernel when the holding process dies: startup recovery can tell an
+interrupted job (lock free) from one another worker is still running.
+"""
+from __future__ import annotations
+
+import os
+from contextlib import contextmanager
+from typing import Iterator
+
+try:  # pragma: no cover - platform dependent
+    import fcntl
+except ImportError:  # pragma: no cover - Windows dev mode
+    fcntl = None  # type: ignore[assignment]
+
+
+@contextmanager
+def job_lock(job_kind: str, job_id: int) -> Iterator[bool]:
+    """Non-blocking per-job lock across workers; yields False if held elsewhere."""
+    if fcntl is None:
+        yield True
+        return
+    from app.services.monitoring.shm import SHM_DIR
+
+    SHM_DIR.mkdir(parents=True, exist_ok=True)
+    fd = os.open(SHM_DIR / f"job-{job_kind}-{job_id}.lock", os.O_RDWR | os.O_CREAT, 0o600)
+    try:
+        try:
+            fcntl.flock(fd, fcntl.LOCK_EX | fcntl.LOCK_NB)
+        except BlockingIOError:
+            yield False
+            return
+        yield True
+    finally:
+        os.close(fd)
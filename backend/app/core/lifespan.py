@@ -17,6 +17,7 @@ from pathlib import Path
 from fastapi import FastAPI
 
 from app.core.config import settings
+from app.core.startup import StartupEngine, StartupStep, get_startup_engine, set_startup_engine
 from app.core.service_registry import (
     MONITORING_WORKER_SERVICES,
     register_all_services,
@@ -229,7 +230,7 @@ async def _smart_device_ws_bridge() -> None:
                 await ws.broadcast_to_all({
                     "type": "smart_device_update",
                     "payload": changes,
-                })
+                }, topic="smart_device_update")
             _last_broadcast_ts = ts
         except Exception as exc:
             logger.debug("SmartDevice WS bridge error: %s", exc)
@@ -414,14 +415,14 @@ async def _expiry_warning_catchup_on_startup() -> None:
         logger.warning("Startup expiration-warning catch-up failed: %s", exc)
 
 
-async def _startup(app: FastAPI) -> None:
-    """Run all startup initialization steps."""
-    global _discovery_service, _websocket_manager, _plugin_manager, IS_PRIMARY_WORKER, _smart_device_manager
-
-    from app.services.files.storage_permissions import STORAGE_UMASK
-    old_umask = os.umask(STORAGE_UMASK)
-    logger.info("Storage umask set to %04o (was %04o)", STORAGE_UMASK, old_umask)
+def _startup_steps(app: FastAPI) -> "list[StartupStep]":
+    """The startup graph: what runs, in which phase, after what.
 
+    Blocking steps are what a request may touch right away; everything else
+    is deferred and comes up while the worker already serves. Steps that
+    depend on a disabled setting stay in the graph as no-ops so the
+    ``after`` edges do not have to be conditional.
+    """
     from app.core.database import init_db, SessionLocal, engine
     from app.services.users import ensure_admin_user, ensure_user_home_directories
     from app.services import jobs, seed
@@ -430,163 +431,193 @@ async def _startup(app: FastAPI) -> None:
     from app.services.power import sleep as sleep_mode
     from app.services.power.gpu import manager as gpu_power_manager
     from app.services.network_discovery import NetworkDiscoveryService
-    from app.services.notifications.firebase import FirebaseService
     from app.services.websocket_manager import init_websocket_manager
     from app.services.notifications.events import init_event_emitter
     from app.services.update.api import register_update_service, finalize_pending_updates
     from app.plugins.manager import PluginManager
 
-    # Wire the log buffer handler to the running event loop for SSE streaming
-    from app.services.log_buffer import get_log_buffer_handler
-    get_log_buffer_handler().set_event_loop(asyncio.get_running_loop())
+    primary = IS_PRIMARY_WORKER
 
-    # Initialize database tables
-    init_db()
-    logger.info("Database initialized")
+    # -- blocking -----------------------------------------------------------
 
-    if settings.skip_setup:
-        ensure_admin_user(settings)
-        logger.info("Admin user ensured with username '%s' (SKIP_SETUP=true)", settings.admin_username)
-        seed.seed_dev_data()
-    else:
-        logger.info("Setup wizard mode — admin creation deferred to /api/setup/admin")
-        # Skip user seeding — setup wizard will create users.
-        # Still seed demo files so storage directories exist.
-        if settings.is_dev_mode:
-            seed.seed_dev_files_only()
+    def _database() -> None:
+        init_db()
+        logger.info("Database initialized")
 
-    # Record current version in database
-    from app.services.version_tracker import record_version_on_startup
-    with SessionLocal() as version_db:
-        record_version_on_startup(version_db)
+    def _admin_user() -> None:
+        if settings.skip_setup:
+            ensure_admin_user(settings)
+            logger.info("Admin user ensured with username '%s' (SKIP_SETUP=true)", settings.admin_username)
+            seed.seed_dev_data()
+        else:
+            logger.info("Setup wizard mode — admin creation deferred to /api/setup/admin")
+            # Skip user seeding — setup wizard will create users.
+            # Still seed demo files so storage directories exist.
+            if settings.is_dev_mode:
+                seed.seed_dev_files_only()
 
-    # Recover stale benchmarks and kill orphan fio processes from previous runs
-    from app.services.benchmark.lifecycle import recover_stale_benchmarks, kill_orphan_fio_processes
-    with SessionLocal() as bench_db:
-        recovered = recover_stale_benchmarks(bench_db)
-        if recovered:
-            logger.info("Recovered %d stale benchmark(s) from previous run", recovered)
-    kill_orphan_fio_processes()
+    def _home_directories() -> None:
+        ensure_user_home_directories()
+        logger.info("User home directories ensured")
 
-    # Ensure home directories for all users and Shared folder
-    ensure_user_home_directories()
-    logger.info("User home directories ensured")
+    def _notifications() -> None:
+        global _websocket_manager
+        try:
+            _websocket_manager = init_websocket_manager()
+            init_event_emitter(SessionLocal)
+            # Events are batched and coalesced per tick from here on
+            from app.services.notifications.dispatcher import get_notification_dispatcher
+            get_notification_dispatcher().start(SessionLocal)
+            logger.info("Notification system initialized")
+        except Exception as e:
+            logger.warning(f"Notification system could not initialize: {e}")
 
-    await jobs.start_health_monitor()
+    def _request_services() -> None:
+        # Set server start time for uptime tracking
+        set_server_start_time()
 
-    # Acquire primary-worker lock *after* fork (lifespan runs per-worker).
-    IS_PRIMARY_WORKER = _try_become_primary()
-    logger.info("Primary worker: %s (PID %d)", IS_PRIMARY_WORKER, os.getpid())
+        # Every worker batches its own routine audit events
+        from app.services.audit.writer import get_audit_writer
+        get_audit_writer().start()
 
-    # Lifecycle notification: emit startup with downtime context
-    await _emit_lifecycle_startup()
+        # Every worker records latency histograms into its own SHM file
+        from app.core.tracing import get_tracer
+        get_tracer().start()
 
-    # Hardware-controlling background tasks only run on the primary worker.
-    if IS_PRIMARY_WORKER:
-        logger.info("Monitoring managed by monitoring_worker process")
+        # Every worker caches resolved users, API keys and share grants;
+        # invalidation goes through shared memory to all workers
+        from app.core.decision_cache import get_decision_cache
+        get_decision_cache().enable()
+
+        # Every worker accumulates its own SSD cache hit/miss counts
+        from app.services.cache.access_stats import run_flush_loop as _ssd_stats_flush_loop
+        _spawn_background(_ssd_stats_flush_loop(), "ssd_cache_stats_flush")
+
+        # Set DB engine for pool monitoring
+        get_service_status_collector().set_db_engine(engine)
+        logger.info("Service status collector initialized")
+
+    # -- deferred -----------------------------------------------------------
 
-        if settings.power_management_enabled:
+    def _record_version() -> None:
+        from app.services.version_tracker import record_version_on_startup
+        with SessionLocal() as version_db:
+            record_version_on_startup(version_db)
+
+    def _benchmark_recovery() -> None:
+        # Recover stale benchmarks and kill orphan fio processes from previous runs
+        from app.services.benchmark.lifecycle import recover_stale_benchmarks, kill_orphan_fio_processes
+        with SessionLocal() as bench_db:
+            recovered = recover_stale_benchmarks(bench_db)
+            if recovered:
+                logger.info("Recovered %d stale benchmark(s) from previous run", recovered)
+        kill_orphan_fio_processes()
+
+    async def _power() -> None:
+        if not settings.power_management_enabled:
+            return
+        if primary:
             try:
                 await power_manager.start_power_manager(primary=True)
                 await power_manager.check_and_notify_permissions()
                 logger.info("CPU power management started")
             except Exception as e:
                 logger.warning(f"CPU power management could not start: {e}")
-
-        if settings.gpu_power_management_enabled:
+        else:
             try:
-                await gpu_power_manager.start_gpu_power_manager(primary=True)
-                logger.info("GPU power management started")
+                await power_manager.start_power_manager(primary=False)
+                logger.info("Power manager initialized (follower, secondary worker)")
             except Exception as e:
-                logger.warning(f"GPU power management could not start: {e}")
+                logger.warning("Power manager init failed on secondary worker: %s", e)
 
-        if settings.fan_control_enabled:
-            try:
+    async def _gpu_power() -> None:
+        if not settings.gpu_power_management_enabled:
+            return
+        try:
+            await gpu_power_manager.start_gpu_power_manager(primary=primary)
+            if primary:
+                logger.info("GPU power management started")
+            else:
+                logger.info("GPU power manager initialized (follower, secondary worker)")
+        except Exception as e:
+            logger.warning("GPU power management could not start: %s", e)
+
+    async def _fan_control() -> None:
+        if not settings.fan_control_enabled:
+            return
+        try:
+            if primary:
                 await fan_control.start_fan_control()
                 logger.info("Fan control started")
-            except Exception as e:
-                logger.warning(f"Fan control could not start: {e}")
+            else:
+                await fan_control.start_fan_control(monitoring=False)
+                logger.info("Fan control initialized (read-only, secondary worker)")
+        except Exception as e:
+            logger.warning("Fan control could not start: %s", e)
 
-        if settings.sleep_mode_enabled:
-            try:
+    async def _sleep_mode() -> None:
+        if not settings.sleep_mode_enabled:
+            return
+        try:
+            if primary:
                 await sleep_mode.start_sleep_manager()
                 logger.info("Sleep mode service started")
-            except Exception as e:
-                logger.warning(f"Sleep mode service could not start: {e}")
+            else:
+                await sleep_mode.start_sleep_manager(monitoring=False)
+                logger.info("Sleep manager initialized (read-only, secondary worker)")
+        except Exception as e:
+            logger.warning("Sleep mode service could not start: %s", e)
 
+    async def _folder_size_watcher() -> None:
+        if not (primary and settings.folder_size_watch_enabled):
+            return
         try:
-            _discovery_service = NetworkDiscoveryService(
+            from app.services.files.folder_size_watcher import start_folder_size_watcher
+            await asyncio.to_thread(
+                start_folder_size_watcher, settings.folder_size_watch_debounce_seconds,
+            )
+        except Exception as e:
+            logger.warning(f"Folder size watcher could not start: {e}")
+
+    def _discovery() -> None:
+        global _discovery_service
+        if not primary:
+            return
+        try:
+            service = NetworkDiscoveryService(
                 port=settings.port,
                 webdav_port=settings.webdav_port,
                 hostname=settings.mdns_hostname,
                 webdav_ssl_enabled=settings.webdav_ssl_enabled,
             )
-            _discovery_service.start()
+            service.start()
+            _discovery_service = service
         except Exception as e:
             logger.warning(f"Network discovery could not start: {e}")
-    else:
-        logger.info("Secondary worker — skipping hardware services")
-        if settings.power_management_enabled:
-            try:
-                await power_manager.start_power_manager(primary=False)
-                logger.info("Power manager initialized (follower, secondary worker)")
-            except Exception as e:
-                logger.warning("Power manager init failed on secondary worker: %s", e)
-        if settings.gpu_power_management_enabled:
-            try:
-                await gpu_power_manager.start_gpu_power_manager(primary=False)
-                logger.info("GPU power manager initialized (follower, secondary worker)")
-            except Exception as e:
-                logger.warning("GPU power manager init failed on secondary worker: %s", e)
-        if settings.fan_control_enabled:
-            try:
-                await fan_control.start_fan_control(monitoring=False)
-                logger.info("Fan control initialized (read-only, secondary worker)")
-            except Exception as e:
-                logger.warning("Fan control init failed on secondary worker: %s", e)
-        if settings.sleep_mode_enabled:
-            try:
-                await sleep_mode.start_sleep_manager(monitoring=False)
-                logger.info("Sleep manager initialized (read-only, secondary worker)")
-            except Exception as e:
-                logger.warning("Sleep manager init failed on secondary worker: %s", e)
 
-    # Initialize Firebase (optional)
-    FirebaseService.initialize()
-
-    # Initialize notification system services
-    try:
-        _websocket_manager = init_websocket_manager()
-        init_event_emitter(SessionLocal)
-        logger.info("Notification system initialized")
-    except Exception as e:
-        logger.warning(f"Notification system could not initialize: {e}")
-
-    # Set server start time for uptime tracking
-    set_server_start_time()
-
-    # Register all services with the service status collector
-    register_all_services(
-        is_primary_worker=IS_PRIMARY_WORKER,
-        discovery_service=_discovery_service,
-    )
-
-    _log_dev_mode_summary()
-
-    # Dev-only impersonation warning
-    if settings.is_dev_mode:
-        logger.warning(
-            "DEV IMPERSONATION ENDPOINT ENABLED at "
-            "%s/auth/dev/impersonate/{user_id} — do not run this in production",
-            settings.api_prefix,
+    def _service_registry_step() -> None:
+        # Register all services with the service status collector
+        register_all_services(
+            is_primary_worker=primary,
+            discovery_service=_discovery_service,
         )
+        _log_dev_mode_summary()
 
-    # Start heartbeat writer and background loops on primary worker
-    if IS_PRIMARY_WORKER:
+    async def _primary_loops() -> None:
+        if not primary:
+            return
         _spawn_background(_write_service_heartbeats(), "service_heartbeats")
         _spawn_background(_pihole_health_loop(), "pihole_health")
         _spawn_background(_expiry_warning_catchup_on_startup(), "expiry_warning_catchup")
 
+        # Cloud imports/exports interrupted by the restart pick up where they stopped
+        from app.services.cloud.recovery import resume_interrupted_jobs
+        _spawn_background(resume_interrupted_jobs(), "cloud_transfer_resume")
+
+        # Bulk ownership transfers continue from their last committed batch
+        from app.services.files import ownership_jobs
+        _spawn_background(ownership_jobs.resume_interrupted_jobs(), "ownership_transfer_resume")
+
         try:
             from app.services.pihole.query_collector import get_dns_query_collector
             get_dns_query_collector().start(SessionLocal)
@@ -601,11 +632,10 @@ async def _startup(app: FastAPI) -> None:
         except Exception as e:
             logger.warning("Ad Discovery background task could not start: %s", e)
 
-    # Register update service
-    register_update_service()
-
-    # Finalize any updates that were in progress when the backend last stopped
-    if not settings.is_dev_mode:
+    def _pending_updates() -> None:
+        # Finalize any updates that were in progress when the backend last stopped
+        if settings.is_dev_mode:
+            return
         try:
             with SessionLocal() as update_db:
                 finalized = finalize_pending_updates(update_db)
@@ -614,65 +644,150 @@ async def _startup(app: FastAPI) -> None:
         except Exception as e:
             logger.warning(f"Failed to finalize pending updates: {e}")
 
-    # Set DB engine for pool monitoring
-    collector = get_service_status_collector()
-    collector.set_db_engine(engine)
-    logger.info("Service status collector initialized")
-
-    # Initialize plugin system
-    try:
-        _plugin_manager = PluginManager.get_instance()
-        with SessionLocal() as plugin_db:
-            await _plugin_manager.load_enabled_plugins(
-                plugin_db,
-                start_background_tasks=IS_PRIMARY_WORKER,
-            )
-        plugin_router = _plugin_manager.get_router()
-        if plugin_router.routes:
-            app.include_router(plugin_router, prefix=settings.api_prefix)
-            logger.info(f"Mounted {len(plugin_router.routes)} plugin routes")
-        _plugin_manager.emit_hook("on_system_startup")
-        logger.info("Plugin system initialized")
-    except Exception as e:
-        logger.warning(f"Plugin system could not initialize: {e}")
+    async def _plugins() -> None:
+        global _plugin_manager
+        try:
+            _plugin_manager = PluginManager.get_instance()
+            with SessionLocal() as plugin_db:
+                await _plugin_manager.load_enabled_plugins(
+                    plugin_db,
+                    start_background_tasks=primary,
+                )
+            plugin_router = _plugin_manager.get_router()
+            if plugin_router.routes:
+                app.include_router(plugin_router, prefix=settings.api_prefix)
+                logger.info(f"Mounted {len(plugin_router.routes)} plugin routes")
+            _plugin_manager.emit_hook("on_system_startup")
+            logger.info("Plugin system initialized")
+        except Exception as e:
+            logger.warning(f"Plugin system could not initialize: {e}")
 
-    # Initialize SmartDeviceManager and register any loaded smart_device plugins
-    try:
-        from app.plugins.smart_device.manager import SmartDeviceManager
-        from app.plugins.smart_device.base import SmartDevicePlugin
-
-        _smart_device_manager = SmartDeviceManager.get_instance()
-        if _plugin_manager is not None:
-            for plugin_name in list(_plugin_manager._enabled):
-                plugin_obj = _plugin_manager.get_plugin(plugin_name)
-                if isinstance(plugin_obj, SmartDevicePlugin):
-                    _smart_device_manager.register_plugin(plugin_obj)
-        logger.info("SmartDeviceManager initialized")
-    except Exception as e:
-        logger.warning(f"SmartDeviceManager could not initialize: {e}")
+    def _smart_devices() -> None:
+        # Initialize SmartDeviceManager and register any loaded smart_device plugins
+        global _smart_device_manager
+        try:
+            from app.plugins.smart_device.manager import SmartDeviceManager
+            from app.plugins.smart_device.base import SmartDevicePlugin
+
+            _smart_device_manager = SmartDeviceManager.get_instance()
+            if _plugin_manager is not None:
+                for plugin_name in list(_plugin_manager._enabled):
+                    plugin_obj = _plugin_manager.get_plugin(plugin_name)
+                    if isinstance(plugin_obj, SmartDevicePlugin):
+                        _smart_device_manager.register_plugin(plugin_obj)
+            logger.info("SmartDeviceManager initialized")
+        except Exception as e:
+            logger.warning(f"SmartDeviceManager could not initialize: {e}")
 
-    # Start SmartDevice WebSocket bridge (primary worker only)
-    if IS_PRIMARY_WORKER:
+    def _ws_bridges() -> None:
+        if not primary:
+            return
         _spawn_background(_smart_device_ws_bridge(), "smart_device_ws_bridge")
 
-        # Start Dashboard panel WS bridge (primary worker only)
         from app.services.dashboard_panel_bridge import dashboard_panel_ws_bridge
         _spawn_background(dashboard_panel_ws_bridge(), "dashboard_panel_ws_bridge")
 
-    # Notify BaluPi companion device that NAS is online
-    if IS_PRIMARY_WORKER and settings.balupi_enabled:
+    async def _balupi() -> None:
+        # Notify BaluPi companion device that NAS is online
+        if not (primary and settings.balupi_enabled):
+            return
         try:
             from app.services.balupi_handshake import notify_balupi_startup
             await notify_balupi_startup()
         except Exception as exc:
             logger.warning("BaluPi startup notification failed: %s", exc)
 
+    hardware = ("power", "gpu_power", "fan_control", "sleep_mode")
+    return [
+        StartupStep("database", _database, critical=True, thread=True),
+        StartupStep("admin_user", _admin_user, after=("database",), critical=True, thread=True),
+        StartupStep("home_directories", _home_directories, after=("admin_user",), critical=True, thread=True),
+        StartupStep("notifications", _notifications),
+        StartupStep("request_services", _request_services, after=("database",)),
+        StartupStep("update_service", register_update_service),
+
+        StartupStep("record_version", _record_version, deferred=True, thread=True),
+        StartupStep("benchmark_recovery", _benchmark_recovery, deferred=True, thread=True),
+        StartupStep("health_monitor", jobs.start_health_monitor, deferred=True),
+        # Lifecycle notification: emit startup with downtime context
+        StartupStep("lifecycle_startup", _emit_lifecycle_startup, deferred=True),
+        StartupStep("power", _power, deferred=True),
+        StartupStep("gpu_power", _gpu_power, deferred=True),
+        StartupStep("fan_control", _fan_control, deferred=True),
+        StartupStep("sleep_mode", _sleep_mode, deferred=True),
+        StartupStep("folder_size_watcher", _folder_size_watcher, deferred=True),
+        StartupStep("discovery", _discovery, deferred=True, thread=True),
+        StartupStep("service_registry", _service_registry_step,
+                    after=hardware + ("discovery",), deferred=True),
+        # Heartbeats publish the registry to the secondary workers
+        StartupStep("primary_loops", _primary_loops, after=("service_registry",), deferred=True),
+        StartupStep("pending_updates", _pending_updates, deferred=True, thread=True),
+        StartupStep("plugins", _plugins, deferred=True),
+        StartupStep("smart_devices", _smart_devices, after=("plugins",), deferred=True),
+        StartupStep("ws_bridges", _ws_bridges, after=("smart_devices",), deferred=True),
+        StartupStep("balupi", _balupi, deferred=True),
+    ]
+
+
+async def _startup(app: FastAPI) -> None:
+    """Run the blocking startup steps, then start the deferred ones in the background."""
+    global IS_PRIMARY_WORKER
+
+    from app.services.files.storage_permissions import STORAGE_UMASK
+    old_umask = os.umask(STORAGE_UMASK)
+    logger.info("Storage umask set to %04o (was %04o)", STORAGE_UMASK, old_umask)
+
+    # Wire the log buffer handler to the running event loop for SSE streaming
+    from app.services.log_buffer import get_log_buffer_handler
+    get_log_buffer_handler().set_event_loop(asyncio.get_running_loop())
+
+    # Acquire primary-worker lock *after* fork (lifespan runs per-worker).
+    # Needed first: it decides which steps do anything.
+    IS_PRIMARY_WORKER = _try_become_primary()
+    logger.info("Primary worker: %s (PID %d)", IS_PRIMARY_WORKER, os.getpid())
+
+    if IS_PRIMARY_WORKER:
+        logger.info("Monitoring managed by monitoring_worker process")
+    else:
+        logger.info("Secondary worker — skipping hardware services")
+
+    # Dev-only impersonation warning
+    if settings.is_dev_mode:
+        logger.warning(
+            "DEV IMPERSONATION ENDPOINT ENABLED at "
+            "%s/auth/dev/impersonate/{user_id} — do not run this in production",
+            settings.api_prefix,
+        )
+
+    # Firebase is initialized on first use (FirebaseService.is_available)
+
+    engine = StartupEngine(_startup_steps(app))
+    set_startup_engine(engine)
+    await engine.run_blocking()
+    logger.info("Ready to serve after %.0f ms", engine.report()["ready_ms"] or 0.0)
+    engine.start_deferred()
+
 
 async def _shutdown() -> None:
     """Run all graceful shutdown steps."""
+    # Deferred startup steps still running would race the teardown below
+    startup_engine = get_startup_engine()
+    if startup_engine is not None:
+        await startup_engine.cancel_deferred()
+
     # ---- Lifecycle notification (best-effort, must run BEFORE app dies) ----
     await _emit_lifecycle_shutdown()
 
+    # Deliver queued notifications (including the shutdown one) while the
+    # database and WebSocket manager are still up; later events go direct
+    try:
+        from app.services.notifications.dispatcher import get_notification_dispatcher
+        handled = await asyncio.wait_for(get_notification_dispatcher().stop(), timeout=5.0)
+        if handled:
+            logger.info("Notification dispatcher delivered %d event(s) on shutdown", handled)
+    except Exception as exc:
+        logger.warning("Notification dispatcher shutdown failed: %s", exc)
+
     # Stop our own loops before the services they touch (DB, WebSocket manager,
     # plugins) are torn down below.
     await _cancel_background_tasks()
@@ -733,6 +848,13 @@ async def _shutdown() -> None:
     except Exception:
         logger.debug("Error while stopping background services")
 
+    # Leave the WebSocket bus and flush queued frames
+    try:
+        from app.services.websocket_manager import get_websocket_manager
+        await get_websocket_manager().shutdown()
+    except Exception:
+        logger.debug("WebSocket manager shutdown skipped or failed")
+
     # Shutdown upload managers
     try:
         from app.services.upload_progress import get_upload_progress_manager
@@ -746,6 +868,32 @@ async def _shutdown() -> None:
     except Exception:
         logger.debug("Chunked upload manager shutdown skipped or failed")
 
+    try:
+        from app.services.cache.fill import get_cache_fill_pipeline
+        await get_cache_fill_pipeline().shutdown()
+    except Exception:
+        logger.debug("SSD cache fill pipeline shutdown skipped or failed")
+
+    # Persist SSD cache hit/miss counts accumulated since the last flush
+    try:
+        from app.services.cache.access_stats import get_access_stats
+        await asyncio.to_thread(get_access_stats().flush)
+    except Exception:
+        logger.debug("SSD cache stats flush on shutdown failed")
+
+    # Write API key use counts accumulated since their last update
+    try:
+        from app.core.database import SessionLocal
+        from app.services.api_key_service import ApiKeyService
+
+        def _flush_api_key_usage() -> None:
+            with SessionLocal() as db:
+                ApiKeyService.flush_usage(db)
+
+        await asyncio.to_thread(_flush_api_key_usage)
+    except Exception:
+        logger.debug("API key usage flush on shutdown failed")
+
     # Stop DNS query collector
     try:
         from app.services.pihole.query_collector import get_dns_query_collector
@@ -760,6 +908,13 @@ async def _shutdown() -> None:
     except Exception:
         logger.debug("Ad Discovery background task shutdown skipped or failed")
 
+    # Stop folder size watcher
+    try:
+        from app.services.files.folder_size_watcher import stop_folder_size_watcher
+        await asyncio.to_thread(stop_folder_size_watcher)
+    except Exception:
+        logger.debug("Folder size watcher shutdown skipped or failed")
+
     # Stop network discovery
     if _discovery_service:
         _discovery_service.stop()
@@ -773,6 +928,22 @@ async def _shutdown() -> None:
         except Exception:
             logger.debug("Error while shutting down plugin system")
 
+    try:
+        from app.core.tracing import get_tracer
+        get_tracer().stop()
+    except Exception as exc:
+        logger.debug("Latency tracer stop failed: %s", exc)
+
+    # Last: write the audit events still queued (including any logged by the
+    # shutdown steps above)
+    try:
+        from app.services.audit.writer import get_audit_writer
+        written = await asyncio.to_thread(get_audit_writer().stop)
+        if written:
+            logger.info("Audit writer flushed %d event(s) on shutdown", written)
+    except Exception as exc:
+        logger.warning("Audit writer shutdown flush failed: %s", exc)
+
 
 # ---------------------------------------------------------------------------
 # Lifespan context manager
@@ -9,6 +9,8 @@ import logging
 import os
 from typing import Callable, Optional
 
+from app.core.token_bucket import TokenBucketRateLimiter, TokenBucketTable, open_bucket_table
+
 logger = logging.getLogger(__name__)
 
 # Cache for database rate limits (refreshed periodically)
@@ -17,13 +19,11 @@ _cache_initialized = False
 
 # Initialize rate limiter with identification function.
 #
-# NOTE: Multi-worker deployment uses in-memory storage (no shared state between
-# workers).  This is acceptable because:
-# 1. Nginx ip_hash ensures a client always hits the same worker, so per-client
-#    rate-limit counters are accurate.
-# 2. Nginx itself enforces rate-limits for auth endpoints (auth_limit zone,
-#    5r/m) as the primary brute-force defense.
-# 3. Counters reset on service restart — acceptable for a single-instance NAS.
+# NOTE: Counting is done in token buckets shared by all workers
+# (core/token_bucket.py), so a limit holds per client no matter which worker
+# serves it, and survives worker restarts. Nginx still enforces the auth
+# endpoints' limits (auth_limit zone, 5r/m) as the primary brute-force
+# defense. Test/dev mode keeps its buckets in process memory.
 #
 # In test or dev mode we relax/disable strict limits to avoid flakiness in automated tests.
 
@@ -71,6 +71,23 @@ def _select_key_func(test_mode: bool) -> Callable[[Request], str]:
     return _test_client_key_func if test_mode else get_remote_address
 
 
+class SharedLimiter(Limiter):
+    """slowapi ``Limiter`` that counts in ``TokenBucketTable`` buckets.
+
+    slowapi consults ``self._limiter`` (a ``limits`` strategy) for every
+    decorated request; it is replaced by the token-bucket strategy. The
+    ``memory://`` storage slowapi still creates stays unused.
+    """
+
+    def __init__(self, *args, buckets: TokenBucketTable, namespace: str, **kwargs) -> None:
+        super().__init__(*args, **kwargs)
+        self._limiter = TokenBucketRateLimiter(buckets, namespace)
+
+    def reset(self) -> None:
+        super().reset()
+        self._limiter.table.clear()
+
+
 def _build_limiter(test_mode: bool) -> Limiter:
     """Build the IP-keyed limiter for the given mode.
 
@@ -83,16 +100,21 @@ def _build_limiter(test_mode: bool) -> Limiter:
     `api_limit`/`auth_limit` zones. Introducing a real global floor means
     installing the middleware and choosing the numbers in the same change.
     """
-    return Limiter(
+    return SharedLimiter(
         key_func=_select_key_func(test_mode),
         default_limits=[],
         headers_enabled=False,
         storage_uri="memory://",
+        buckets=_buckets,
+        namespace="ip",
     )
 
 
 _init_test_mode = _is_test_mode()
 
+# One bucket table per process; both limiters count into it
+_buckets = open_bucket_table(shared=not _init_test_mode)
+
 limiter = _build_limiter(_init_test_mode)
 
 # Rate limit configurations for different endpoint types
@@ -309,9 +331,11 @@ def get_user_identifier(request: Request) -> str:
 # Alternative limiter with user-based identification.
 # default_limits stays empty for the same reason as in `_build_limiter`:
 # without SlowAPIMiddleware nothing applies them.
-user_limiter = Limiter(
+user_limiter = SharedLimiter(
     key_func=get_user_identifier,
     default_limits=[],
     headers_enabled=True,
-    storage_uri="memory://"
+    storage_uri="memory://",
+    buckets=_buckets,
+    namespace="user",
 )
@@ -388,6 +388,24 @@ def register_all_services(
         config_enabled_fn=lambda: True,
     )
 
+    # Batched audit writer (per worker; reports this worker's queue)
+    from app.services.audit.writer import get_audit_writer
+
+    register_service(
+        name="audit_writer",
+        display_name="Audit Log Writer",
+        get_status_fn=get_audit_writer().get_status,
+    )
+
+    # Batched notification dispatcher (per worker; reports this worker's queue)
+    from app.services.notifications.dispatcher import get_notification_dispatcher
+
+    register_service(
+        name="notification_dispatcher",
+        display_name="Notification Dispatcher",
+        get_status_fn=get_notification_dispatcher().get_status,
+    )
+
     # On secondary workers: replace in-process status functions for
     # primary-only services with DB readers so the dashboard shows
     # consistent data regardless of which worker handles the request.
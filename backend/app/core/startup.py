@@ -0,0 +1,241 @@
+"""
+Dependency-ordered, concurrent startup engine.
+
+``lifespan._startup`` used to bring every service up one after another, so a
+worker only answered once the slowest hardware probe, plugin import and
+network handshake had all finished. Startup is now a graph of ``StartupStep``
+objects (built in ``lifespan._startup_steps``):
+
+- a step starts as soon as every step named in ``after`` has finished, so
+  independent steps run concurrently; ``thread=True`` steps are blocking
+  functions run in a worker thread so they do not stall the loop;
+- *blocking* steps must finish before the worker accepts requests (database,
+  admin user, notification wiring, per-request services);
+- *deferred* steps run in the background while the worker already serves
+  (hardware managers, discovery, plugins, recovery jobs). Code that needs one
+  of them on first use awaits ``wait_for(name)`` (plugin routes do);
+- a ``critical`` step that fails aborts startup, any other failure is logged
+  and its dependents still run, as before.
+
+Every step records its start offset and duration; ``report()`` feeds the log
+summary and ``GET /api/admin/startup``.
+"""
+from __future__ import annotations
+
+import asyncio
+import logging
+import os
+import time
+from dataclasses import dataclass, field
+from typing import Any, Awaitable, Callable, Optional, Union
+
+logger = logging.getLogger(__name__)
+
+StepFn = Callable[[], Union[Awaitable[None], None]]
+
+# How long a request waits for a deferred step it depends on
+DEFAULT_WAIT_SECONDS = 30.0
+
+
+@dataclass
+class StartupStep:
+    """One unit of startup work."""
+    name: str
+    run: StepFn
+    after: tuple[str, ...] = ()
+    deferred: bool = False
+    critical: bool = False
+    thread: bool = False  # run a blocking *run* in a worker thread
+
+
+@dataclass
+class _StepState:
+    step: StartupStep
+    done: asyncio.Event = field(default_factory=asyncio.Event)
+    status: str = "pending"  # pending | running | ok | failed | cancelled
+    started_ms: Optional[float] = None
+    duration_ms: Optional[float] = None
+    error: Optional[str] = None
+
+
+class StartupEngine:
+    """Runs a graph of ``StartupStep``s and keeps their timings."""
+
+    def __init__(self, steps: list[StartupStep]) -> None:
+        self._states: dict[str, _StepState] = {}
+        for step in steps:
+            if step.name in self._states:
+                raise ValueError(f"Duplicate startup step: {step.name}")
+            self._states[step.name] = _StepState(step)
+        self._validate()
+        self._t0 = time.perf_counter()
+        self._ready_ms: Optional[float] = None
+        self._deferred_ms: Optional[float] = None
+        self._deferred_task: Optional[asyncio.Task] = None
+
+    def _validate(self) -> None:
+        for state in self._states.values():
+            for dep in state.step.after:
+                if dep not in self._states:
+                    raise ValueError(f"Startup step {state.step.name} depends on unknown {dep}")
+                if not state.step.deferred and self._states[dep].step.deferred:
+                    raise ValueError(
+                        f"Blocking startup step {state.step.name} cannot wait for deferred {dep}"
+                    )
+        # Cycle check (Kahn)
+        indegree = {name: len(s.step.after) for name, s in self._states.items()}
+        ready = [name for name, n in indegree.items() if n == 0]
+        seen = 0
+        while ready:
+            current = ready.pop()
+            seen += 1
+            for name, s in self._states.items():
+                if current in s.step.after:
+                    indegree[name] -= 1
+                    if indegree[name] == 0:
+                        ready.append(name)
+        if seen != len(self._states):
+            raise ValueError("Startup steps contain a dependency cycle")
+
+    def _elapsed_ms(self) -> float:
+        return (time.perf_counter() - self._t0) * 1000.0
+
+    async def _run_step(self, state: _StepState) -> None:
+        step = state.step
+        try:
+            for dep in step.after:
+                await self._states[dep].done.wait()
+            state.status = "running"
+            state.started_ms = self._elapsed_ms()
+            if step.thread:
+                await asyncio.to_thread(step.run)
+            else:
+                result = step.run()
+                if asyncio.iscoroutine(result):
+                    await result
+            state.status = "ok"
+        except asyncio.CancelledError:
+            state.status = "cancelled"
+            raise
+        except Exception as exc:
+            state.status = "failed"
+            state.error = str(exc)
+            if step.critical:
+                raise
+            logger.warning("Startup step %s failed: %s", step.name, exc)
+        finally:
+            if state.started_ms is not None:
+                state.duration_ms = self._elapsed_ms() - state.started_ms
+            state.done.set()
+
+    async def _run_phase(self, deferred: bool) -> None:
+        tasks = [
+            asyncio.create_task(self._run_step(s), name=f"startup:{s.step.name}")
+            for s in self._states.values() if s.step.deferred == deferred
+        ]
+        try:
+            await asyncio.gather(*tasks)
+        except BaseException:
+            for task in tasks:
+                task.cancel()
+            await asyncio.gather(*tasks, return_exceptions=True)
+            raise
+
+    async def run_blocking(self) -> None:
+        """Run every non-deferred step; raises if a critical one fails."""
+        await self._run_phase(deferred=False)
+        self._ready_ms = self._elapsed_ms()
+
+    def start_deferred(self) -> asyncio.Task:
+        """Run the deferred steps in the background (after ``run_blocking``)."""
+        async def _deferred() -> None:
+            try:
+                await self._run_phase(deferred=True)
+            finally:
+                self._deferred_ms = self._elapsed_ms()
+                self._log_summary()
+
+        self._deferred_task = asyncio.create_task(_deferred(), name="startup:deferred")
+        return self._deferred_task
+
+    async def cancel_deferred(self) -> None:
+        """Stop deferred steps still running (shutdown during startup)."""
+        task = self._deferred_task
+        if task is not None and not task.done():
+            task.cancel()
+            await asyncio.gather(task, return_exceptions=True)
+
+    def is_done(self, name: str) -> bool:
+        state = self._states.get(name)
+        return state is None or state.done.is_set()
+
+    async def wait_for(self, name: str, timeout: float = DEFAULT_WAIT_SECONDS) -> bool:
+        """Wait until step *name* has finished; True if it succeeded (or is unknown)."""
+        state = self._states.get(name)
+        if state is None:
+            return True
+        if not state.done.is_set():
+            try:
+                await asyncio.wait_for(state.done.wait(), timeout)
+            except asyncio.TimeoutError:
+                logger.warning("Timed out after %.0fs waiting for startup step %s", timeout, name)
+                return False
+        return state.status == "ok"
+
+    def report(self) -> dict[str, Any]:
+        steps = sorted(
+            self._states.values(),
+            key=lambda s: (s.started_ms is None, s.started_ms or 0.0),
+        )
+        return {
+            "pid": os.getpid(),
+            "ready_ms": _round(self._ready_ms),
+            "deferred_done_ms": _round(self._deferred_ms),
+            "steps": [
+                {
+                    "name": s.step.name,
+                    "phase": "deferred" if s.step.deferred else "blocking",
+                    "status": s.status,
+                    "after": list(s.step.after),
+                    "started_ms": _round(s.started_ms),
+                    "duration_ms": _round(s.duration_ms),
+                    "error": s.error,
+                }
+                for s in steps
+            ],
+        }
+
+    def _log_summary(self) -> None:
+        timed = [s for s in self._states.values() if s.duration_ms is not None]
+        slowest = sorted(timed, key=lambda s: s.duration_ms or 0.0, reverse=True)[:5]
+        failed = [s.step.name for s in self._states.values() if s.status == "failed"]
+        logger.info(
+            "Startup: serving after %.0f ms, all services after %.0f ms; slowest: %s%s",
+            self._ready_ms or 0.0,
+            self._deferred_ms or 0.0,
+            ", ".join(f"{s.step.name} {s.duration_ms:.0f} ms" for s in slowest) or "-",
+            f"; failed: {', '.join(failed)}" if failed else "",
+        )
+
+
+def _round(value: Optional[float]) -> Optional[float]:
+    return None if value is None else round(value, 1)
+
+
+_engine: Optional[StartupEngine] = None
+
+
+def set_startup_engine(engine: Optional[StartupEngine]) -> None:
+    global _engine
+    _engine = engine
+
+
+def get_startup_engine() -> Optional[StartupEngine]:
+    return _engine
+
+
+async def wait_for(name: str, timeout: float = DEFAULT_WAIT_SECONDS) -> bool:
+    """Wait for a deferred startup step on first use; no-op without an engine (tests)."""
+    if _engine is None:
+        return True
+    return await _engine.wait_for(name, timeout)
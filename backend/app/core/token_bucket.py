@@ -0,0 +1,223 @@
+"""Shared token buckets for the API rate limiters.
+
+slowapi's ``memory://`` storage gave each Uvicorn worker its own fixed-window
+counters: a client whose requests landed on several workers got up to
+workers × its limit, and a fixed window lets a burst of 2 × the limit through
+across a window boundary. The limiters now count in token buckets kept in
+one memory-mapped table under the monitoring SHM directory
+(``rate_limits.bin``), shared by all workers:
+
+- a limit ``N/period`` is a bucket of N tokens refilled at N / period per
+  second; a request takes ``cost`` tokens and is refused while fewer are left;
+- buckets are keyed by a 64-bit hash of slowapi's limit key and live in
+  ``WAYS``-way sets; a set is locked with an ``lockf`` byte-range lock (plus a
+  thread lock — POSIX record locks do not exclude threads of one process);
+- a full set recycles an idle (refilled) bucket first, otherwise the least
+  recently used one;
+- timestamps are ``time.monotonic()`` (CLOCK_MONOTONIC), which all
+  processes on the host share.
+
+A hit costs two ``fcntl`` calls and a few struct reads. Without a mapping
+(test/dev mode, Windows, no /dev/shm) the table is a process-local buffer
+with the same semantics.
+"""
+from __future__ import annotations
+
+import hashlib
+import logging
+import mmap
+import os
+import struct
+import threading
+import time
+from contextlib import contextmanager
+from pathlib import Path
+from typing import Iterator, NamedTuple, Optional
+
+try:  # pragma: no cover - platform dependent
+    import fcntl
+except ImportError:  # Windows dev mode: single process
+    fcntl = None  # type: ignore[assignment]
+
+logger = logging.getLogger(__name__)
+
+_MAGIC = b"BHTB"
+_VERSION = 1
+_HEADER = struct.Struct("<4sIII")  # magic | version | sets | ways
+_HEADER_SIZE = 64
+_SLOT = struct.Struct("<Qddff")  # key hash | tokens | updated | rate | capacity
+
+SETS = 2048
+WAYS = 8
+_SET_SIZE = WAYS * _SLOT.size
+_THREAD_LOCKS = 64
+
+TABLE_FILE = "rate_limits.bin"
+
+
+class WindowStats(NamedTuple):
+    """Same shape as ``limits.WindowStats`` (slowapi indexes it)."""
+
+    reset_time: float
+    remaining: int
+
+
+def _key_hash(key: str) -> int:
+    # Never 0: that marks an empty slot
+    return int.from_bytes(hashlib.blake2b(key.encode("utf-8"), digest_size=8).digest(), "little") | 1
+
+
+class TokenBucketTable:
+    """Fixed-size table of token buckets (see module docstring)."""
+
+    def __init__(self, path: Optional[Path] = None) -> None:
+        self.path = path
+        self.shared = False
+        self._size = _HEADER_SIZE + SETS * _SET_SIZE
+        self._fd: Optional[int] = None
+        self._mm: Optional[mmap.mmap] = None
+        self._locks = [threading.Lock() for _ in range(_THREAD_LOCKS)]
+        if path is not None:
+            self._open(path)
+        self._buf = self._mm if self._mm is not None else bytearray(self._size)
+
+    def _open(self, path: Path) -> None:
+        try:
+            path.parent.mkdir(parents=True, exist_ok=True)
+            self._fd = os.open(path, os.O_RDWR | os.O_CREAT, 0o600)
+            if fcntl is not None:
+                fcntl.lockf(self._fd, fcntl.LOCK_EX)
+            try:
+                if os.fstat(self._fd).st_size != self._size:
+                    os.ftruncate(self._fd, self._size)
+                self._mm = mmap.mmap(self._fd, self._size)
+                if _HEADER.unpack_from(self._mm, 0) != (_MAGIC, _VERSION, SETS, WAYS):
+                    self._mm[:] = bytes(self._size)
+                    _HEADER.pack_into(self._mm, 0, _MAGIC, _VERSION, SETS, WAYS)
+            finally:
+                if fcntl is not None:
+                    fcntl.lockf(self._fd, fcntl.LOCK_UN)
+            self.shared = fcntl is not None
+        except (OSError, ValueError) as exc:
+            logger.warning("Shared rate-limit table unavailable, limits are per worker: %s", exc)
+            self.close()
+
+    def close(self) -> None:
+        if self._mm is not None:
+            try:
+                self._mm.close()
+            except (BufferError, ValueError):
+                pass
+            self._mm = None
+        if self._fd is not None:
+            os.close(self._fd)
+            self._fd = None
+
+    @contextmanager
+    def _locked(self, base: int, length: int) -> Iterator[None]:
+        with self._locks[(base // _SET_SIZE) % _THREAD_LOCKS]:
+            if not self.shared:
+                yield
+                return
+            fcntl.lockf(self._fd, fcntl.LOCK_EX, length, base)
+            try:
+                yield
+            finally:
+                fcntl.lockf(self._fd, fcntl.LOCK_UN, length, base)
+
+    def take(
+        self, key: str, capacity: float, rate: float, cost: float = 1, *, consume: bool = True,
+    ) -> tuple[bool, float]:
+        """Refill, then take *cost* tokens if available.
+
+        Returns ``(allowed, tokens left)``. With ``consume=False`` only checks.
+        """
+        h = _key_hash(key)
+        base = _HEADER_SIZE + (h >> 8) % SETS * _SET_SIZE
+        buf = self._buf
+        now = time.monotonic()
+        with self._locked(base, _SET_SIZE):
+            slot = victim = -1
+            victim_rank = (2, 0.0)
+            tokens = float(capacity)
+            for way in range(WAYS):
+                offset = base + way * _SLOT.size
+                kh, t, updated, r, cap = _SLOT.unpack_from(buf, offset)
+                if kh == h:
+                    slot = offset
+                    tokens = min(float(capacity), t + (now - updated) * rate)
+                    break
+                # Recycling order: empty, then idle (would be full by now), then oldest
+                if kh == 0:
+                    rank = (-1, 0.0)
+                elif t + (now - updated) * r >= cap:
+                    rank = (0, updated)
+                else:
+                    rank = (1, updated)
+                if rank < victim_rank:
+                    victim, victim_rank = offset, rank
+            allowed = tokens >= cost
+            if consume and allowed:
+                tokens -= cost
+            if slot >= 0 or consume:
+                _SLOT.pack_into(buf, slot if slot >= 0 else victim, h, tokens, now, rate, capacity)
+        return allowed, tokens
+
+    def reset(self, key: str) -> None:
+        """Forget one bucket (it starts full again)."""
+        h = _key_hash(key)
+        base = _HEADER_SIZE + (h >> 8) % SETS * _SET_SIZE
+        with self._locked(base, _SET_SIZE):
+            for way in range(WAYS):
+                offset = base + way * _SLOT.size
+                if _SLOT.unpack_from(self._buf, offset)[0] == h:
+                    self._buf[offset:offset + _SLOT.size] = bytes(_SLOT.size)
+
+    def clear(self) -> None:
+        """Forget every bucket."""
+        with self._locked(0, 0):
+            self._buf[_HEADER_SIZE:] = bytes(self._size - _HEADER_SIZE)
+
+
+class TokenBucketRateLimiter:
+    """Token-bucket stand-in for the ``limits`` strategy slowapi calls.
+
+    slowapi only uses ``hit``, ``test``, ``get_window_stats`` and ``clear``
+    with ``limits.RateLimitItem`` arguments (``amount``, ``get_expiry()``,
+    ``key_for()``), all of which are stable across ``limits`` releases.
+    *namespace* keeps two limiters' buckets apart in one table.
+    """
+
+    def __init__(self, table: TokenBucketTable, namespace: str) -> None:
+        self.table = table
+        self.namespace = namespace
+
+    def _args(self, item, identifiers) -> tuple[str, float, float]:
+        capacity = float(item.amount)
+        return f"{self.namespace}/{item.key_for(*identifiers)}", capacity, capacity / item.get_expiry()
+
+    def hit(self, item, *identifiers, cost: int = 1) -> bool:
+        key, capacity, rate = self._args(item, identifiers)
+        return self.table.take(key, capacity, rate, cost)[0]
+
+    def test(self, item, *identifiers, cost: int = 1) -> bool:
+        key, capacity, rate = self._args(item, identifiers)
+        return self.table.take(key, capacity, rate, cost, consume=False)[0]
+
+    def get_window_stats(self, item, *identifiers) -> WindowStats:
+        """Remaining whole tokens, and when the next one (or a full bucket) is due."""
+        key, capacity, rate = self._args(item, identifiers)
+        _, tokens = self.table.take(key, capacity, rate, 0, consume=False)
+        missing = (1 - tokens) if tokens < 1 else (capacity - tokens)
+        return WindowStats(time.time() + missing / rate, int(tokens))
+
+    def clear(self, item, *identifiers) -> None:
+        self.table.reset(self._args(item, identifiers)[0])
+
+
+def open_bucket_table(shared: bool) -> TokenBucketTable:
+    """The host-wide table (``shared``) or a process-local one."""
+    if not shared:
+        return TokenBucketTable()
+    from app.services.monitoring.shm import SHM_DIR
+    return TokenBucketTable(SHM_DIR / TABLE_FILE)
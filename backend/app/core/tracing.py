@@ -0,0 +1,636 @@
+"""Low-overhead latency histograms for requests, DB queries and hot paths.
+
+Three kinds of series, each a log-linear histogram of seconds:
+
+- ``http``: every request, keyed by method and route template (set up by
+  ``RequestTimingMiddleware``), with the number of DB queries it ran and the
+  time they took;
+- ``db``: individual SQL statements by operation (``instrument_engine``);
+- ``span``: expensive service paths wrapped in ``span()`` / ``@traced``
+  (listing, uploads, SSD cache lookups, VCL versions, sync change detection).
+
+Buckets are HDR-style: ``SUB_BUCKETS`` linear steps per power of two between
+``2**MIN_EXP`` and ``2**MAX_EXP`` seconds, so the relative error is at most
+1/``SUB_BUCKETS`` anywhere in the range. Recording one value is a
+``frexp``, an index and three additions on a histogram owned by the calling
+thread — no lock and no shared write on the request path.
+
+Once per ``FLUSH_INTERVAL`` a flusher thread merges the thread histograms
+and writes the totals into this worker's file in the SHM directory
+(``latency-<instance>-<pid>.bin``, single writer, seqlock-guarded). The
+``/api/metrics`` scrape in any worker sums the files of all live workers
+plus its own in-memory state, so Prometheus sees one set of series for the
+whole server. Counters must never go down, so a worker that exits (or dies)
+is not simply dropped: like prometheus_client's multiprocess mode, its
+totals are folded into an archive file (``latency-<instance>-archive.bin``,
+same layout) before its own file is removed — on ``stop()``, or by the next
+scrape that finds its pid gone. Folding and reading take an ``flock`` on
+``latency-<instance>-archive.lock`` (exclusive/shared), so a scrape never
+sees a worker both in the archive and in its own file, or in neither.
+
+Sampling (``tracing_sample_rate``) applies to DB query timing and spans, the
+parts that add work inside a request: a request is sampled or not as a
+whole, and code outside a request samples each span on its own. Route
+latency is always recorded. Disabled until ``start()`` (lifespan startup of
+a web worker), so tests, scripts and the other processes record nothing.
+"""
+from __future__ import annotations
+
+import hashlib
+import logging
+import math
+import mmap
+import os
+import random
+import struct
+import threading
+import time
+import zlib
+from contextvars import ContextVar
+from functools import wraps
+from inspect import iscoroutinefunction
+from pathlib import Path
+from typing import Any, Callable, Iterator, Optional, TypeVar
+
+from sqlalchemy import event
+
+from app.core.config import settings
+
+try:  # pragma: no cover - platform dependent
+    import fcntl
+except ImportError:  # pragma: no cover - Windows dev mode
+    fcntl = None  # type: ignore[assignment]
+
+logger = logging.getLogger(__name__)
+
+F = TypeVar("F", bound=Callable[..., Any])
+SeriesKey = tuple[str, str]  # (kind, name)
+
+# ── Buckets ───────────────────────────────────────────────────────────────────
+
+MIN_EXP = -17  # 7.6 µs
+MAX_EXP = 7  # 128 s
+SUB_BUCKETS = 4
+# 0: below 2**MIN_EXP, last: 2**MAX_EXP and above
+BUCKETS = 2 + (MAX_EXP - MIN_EXP) * SUB_BUCKETS
+
+# Prometheus ``le`` bounds: each power of two and 1.5x it, 61 µs .. 64 s.
+# All of them are internal bucket edges, so the export is exact.
+EXPORT_MIN_EXP = -14
+EXPORT_MAX_EXP = 6
+
+
+def bucket_index(seconds: float) -> int:
+    """Histogram bucket of a duration."""
+    if seconds < 2.0 ** MIN_EXP:
+        return 0
+    mantissa, exponent = math.frexp(seconds)  # seconds = mantissa * 2**exponent, 0.5 <= m < 1
+    index = 1 + (exponent - 1 - MIN_EXP) * SUB_BUCKETS + int((mantissa * 2 - 1) * SUB_BUCKETS)
+    return min(index, BUCKETS - 1)
+
+
+def _export_bounds() -> list[tuple[float, int]]:
+    """(le, index of the last internal bucket at or below it)."""
+    bounds = []
+    for exp in range(EXPORT_MIN_EXP, EXPORT_MAX_EXP + 1):
+        last = (exp - MIN_EXP) * SUB_BUCKETS  # bucket ending at 2**exp
+        bounds.append((2.0 ** exp, last))
+        if exp < EXPORT_MAX_EXP:
+            bounds.append((1.5 * 2.0 ** exp, last + SUB_BUCKETS // 2))
+    return bounds
+
+
+EXPORT_BOUNDS = _export_bounds()
+
+
+class Series:
+    """One histogram plus the DB totals of ``http`` series."""
+
+    __slots__ = ("buckets", "total", "db_queries", "db_seconds")
+
+    def __init__(self) -> None:
+        self.buckets = [0] * BUCKETS
+        self.total = 0.0
+        self.db_queries = 0
+        self.db_seconds = 0.0
+
+    @property
+    def count(self) -> int:
+        return sum(self.buckets)
+
+    def merge(self, other: "Series") -> None:
+        self.buckets = [a + b for a, b in zip(self.buckets, other.buckets)]
+        self.total += other.total
+        self.db_queries += other.db_queries
+        self.db_seconds += other.db_seconds
+
+    def cumulative(self) -> list[tuple[float, int]]:
+        """Prometheus buckets: (le, count of values <= le), ending with +Inf."""
+        out = []
+        running = 0
+        position = 0
+        for le, last in EXPORT_BOUNDS:
+            while position <= last:
+                running += self.buckets[position]
+                position += 1
+            out.append((le, running))
+        out.append((math.inf, running + sum(self.buckets[position:])))
+        return out
+
+
+# ── Per-worker file ───────────────────────────────────────────────────────────
+
+_MAGIC = b"BHLT"
+_VERSION = 1
+_HEADER = struct.Struct("<4sIIIQII")  # magic | version | crc | pid | seq | series | dropped
+_HEADER_SIZE = 64
+_SEQ_OFFSET = 16
+MAX_SERIES = 1024
+NAME_BYTES = 128
+_ROW = struct.Struct(f"<dQd{BUCKETS}Q")  # total | db queries | db seconds | buckets
+_LAYOUT_CRC = zlib.crc32(f"{MIN_EXP}|{MAX_EXP}|{SUB_BUCKETS}|{MAX_SERIES}|{NAME_BYTES}".encode())
+_NAMES_OFFSET = _HEADER_SIZE
+_ROWS_OFFSET = _NAMES_OFFSET + MAX_SERIES * NAME_BYTES
+FILE_SIZE = _ROWS_OFFSET + MAX_SERIES * _ROW.size
+
+FLUSH_INTERVAL = 1.0  # seconds
+ARCHIVE_PID = 0  # writer pid recorded in the archive of exited workers
+
+
+def _encode_key(key: SeriesKey) -> bytes:
+    return f"{key[0]}\t{key[1]}".encode("utf-8", "replace")[:NAME_BYTES]
+
+
+def _decode_key(raw: bytes) -> Optional[SeriesKey]:
+    kind, sep, name = raw.rstrip(b"\x00").decode("utf-8", "replace").partition("\t")
+    return (kind, name) if sep else None
+
+
+class _HistogramFile:
+    """Writer for one worker's file; only the flusher writes it."""
+
+    def __init__(self, path: Path, pid: int) -> None:
+        self.path = path
+        self.pid = pid
+        self._fd: Optional[int] = None
+        self._mm: Optional[mmap.mmap] = None
+        self._slots: dict[SeriesKey, int] = {}
+        self._written: dict[SeriesKey, int] = {}  # count last written per series
+        self._seq = 0
+        self.failed = False
+
+    def _open(self) -> bool:
+        if self._mm is not None:
+            return True
+        if self.failed:
+            return False
+        try:
+            self.path.parent.mkdir(parents=True, exist_ok=True)
+            fd = os.open(self.path, os.O_RDWR | os.O_CREAT | os.O_TRUNC, 0o644)
+            try:
+                os.ftruncate(fd, FILE_SIZE)
+                mm = mmap.mmap(fd, FILE_SIZE)
+            except OSError:
+                os.close(fd)
+                raise
+        except OSError as exc:
+            logger.warning("Latency histograms are per worker only (%s): %s", self.path, exc)
+            self.failed = True
+            return False
+        _HEADER.pack_into(mm, 0, _MAGIC, _VERSION, _LAYOUT_CRC, self.pid, 0, 0, 0)
+        self._fd, self._mm = fd, mm
+        return True
+
+    def write(self, snapshot: dict[SeriesKey, Series], dropped: int) -> None:
+        if not self._open():
+            return
+        mm = self._mm
+        assert mm is not None
+        changed = [(k, s) for k, s in snapshot.items() if self._written.get(k) != s.count]
+        if not changed:
+            return
+        self._seq += 1  # odd: readers retry
+        struct.pack_into("<Q", mm, _SEQ_OFFSET, self._seq)
+        for key, series in changed:
+            slot = self._slots.get(key)
+            if slot is None:
+                if len(self._slots) >= MAX_SERIES:
+                    continue
+                slot = self._slots[key] = len(self._slots)
+                offset = _NAMES_OFFSET + slot * NAME_BYTES
+                mm[offset:offset + NAME_BYTES] = _encode_key(key).ljust(NAME_BYTES, b"\x00")
+            _ROW.pack_into(
+                mm, _ROWS_OFFSET + slot * _ROW.size,
+                series.total, series.db_queries, series.db_seconds, *series.buckets,
+            )
+            self._written[key] = series.count
+        _HEADER.pack_into(
+            mm, 0, _MAGIC, _VERSION, _LAYOUT_CRC, self.pid, self._seq + 1, len(self._slots), dropped,
+        )
+        self._seq += 1
+
+    def close(self, unlink: bool = True) -> None:
+        if self._mm is not None:
+            try:
+                self._mm.close()
+            except (BufferError, ValueError):
+                pass
+            self._mm = None
+        if self._fd is not None:
+            os.close(self._fd)
+            self._fd = None
+            if unlink:
+                try:
+                    self.path.unlink()
+                except OSError:
+                    pass
+        self._slots.clear()
+        self._written.clear()
+
+
+def read_histogram_file(path: Path) -> Optional[tuple[int, dict[SeriesKey, Series]]]:
+    """(writer pid, series) of a worker file, or None if unreadable."""
+    try:
+        with open(path, "rb") as f:
+            if os.fstat(f.fileno()).st_size != FILE_SIZE:
+                return None
+            with mmap.mmap(f.fileno(), FILE_SIZE, access=mmap.ACCESS_READ) as mm:
+                for _ in range(4):
+                    (seq1,) = struct.unpack_from("<Q", mm, _SEQ_OFFSET)
+                    if seq1 & 1:
+                        time.sleep(0.001)
+                        continue
+                    data = mm[:]
+                    (seq2,) = struct.unpack_from("<Q", mm, _SEQ_OFFSET)
+                    if seq1 == seq2:
+                        break
+                else:
+                    return None
+    except (OSError, ValueError):
+        return None
+    magic, version, crc, pid, _seq, count, _dropped = _HEADER.unpack_from(data, 0)
+    if (magic, version, crc) != (_MAGIC, _VERSION, _LAYOUT_CRC):
+        return None
+    series: dict[SeriesKey, Series] = {}
+    for slot in range(min(count, MAX_SERIES)):
+        offset = _NAMES_OFFSET + slot * NAME_BYTES
+        key = _decode_key(data[offset:offset + NAME_BYTES])
+        if key is None:
+            continue
+        row = _ROW.unpack_from(data, _ROWS_OFFSET + slot * _ROW.size)
+        s = Series()
+        s.total, s.db_queries, s.db_seconds = row[0], row[1], row[2]
+        s.buckets = list(row[3:])
+        series[key] = s
+    return pid, series
+
+
+def _merge_into(target: dict[SeriesKey, Series], series: dict[SeriesKey, Series]) -> None:
+    for key, s in series.items():
+        existing = target.get(key)
+        if existing is None:
+            target[key] = s
+        else:
+            existing.merge(s)
+
+
+class _ArchiveLock:
+    """``flock`` on the archive lock file: exclusive to fold, shared to read."""
+
+    def __init__(self, path: Path, exclusive: bool) -> None:
+        self.path = path
+        self.exclusive = exclusive
+        self._fd: Optional[int] = None
+
+    def __enter__(self) -> "_ArchiveLock":
+        try:
+            self._fd = os.open(self.path, os.O_RDWR | os.O_CREAT, 0o644)
+        except OSError:
+            return self  # unlocked; worst case a scrape reads mid-fold
+        if fcntl is not None:
+            fcntl.flock(self._fd, fcntl.LOCK_EX if self.exclusive else fcntl.LOCK_SH)
+        return self
+
+    def __exit__(self, *_exc: Any) -> None:
+        if self._fd is not None:
+            os.close(self._fd)  # releases the flock
+            self._fd = None
+
+
+def _pid_alive(pid: int) -> bool:
+    try:
+        os.kill(pid, 0)
+    except ProcessLookupError:
+        return False
+    except (PermissionError, OSError):
+        return True
+    return True
+
+
+# ── Tracer ────────────────────────────────────────────────────────────────────
+
+class RequestTrace:
+    """Per-request state shared by the request's task and its threads."""
+
+    __slots__ = ("sampled", "db_queries", "db_seconds")
+
+    def __init__(self, sampled: bool) -> None:
+        self.sampled = sampled
+        self.db_queries = 0
+        self.db_seconds = 0.0
+
+
+_current_request: ContextVar[Optional[RequestTrace]] = ContextVar("tracing_request", default=None)
+
+
+def _default_prefix() -> str:
+    # Keyed on the storage root like the metric rings, so separate instances
+    # (and test workers) sharing /dev/shm never count each other's requests.
+    root = str(Path(settings.nas_storage_path).expanduser().resolve())
+    return f"latency-{hashlib.sha1(root.encode('utf-8')).hexdigest()[:12]}"
+
+
+class Tracer:
+    """Thread-local histograms, their flusher and the cross-worker reader."""
+
+    def __init__(self, directory: Optional[Path] = None, pid: Optional[int] = None) -> None:
+        self.directory = directory
+        self.prefix: Optional[str] = None
+        self.pid = pid or os.getpid()
+        self.enabled = False
+        self.sample_rate = 1.0
+        self.dropped = 0
+        self._local = threading.local()
+        self._shards: list[dict[SeriesKey, Series]] = []
+        self._shards_lock = threading.Lock()
+        self._keys: set[SeriesKey] = set()
+        self._file: Optional[_HistogramFile] = None
+        self._flush_lock = threading.Lock()
+        self._thread: Optional[threading.Thread] = None
+        self._stop = threading.Event()
+
+    # -- recording (request path) --------------------------------------
+
+    def _shard(self) -> dict[SeriesKey, Series]:
+        shard = getattr(self._local, "shard", None)
+        if shard is None:
+            shard = self._local.shard = {}
+            with self._shards_lock:  # once per thread
+                self._shards.append(shard)
+        return shard
+
+    def record(self, key: SeriesKey, seconds: float, db_queries: int = 0, db_seconds: float = 0.0) -> None:
+        shard = self._shard()
+        series = shard.get(key)
+        if series is None:
+            if key not in self._keys:
+                if len(self._keys) >= MAX_SERIES:
+                    self.dropped += 1
+                    return
+                self._keys.add(key)
+            series = shard[key] = Series()
+        series.buckets[bucket_index(seconds)] += 1
+        series.total += seconds
+        if db_queries:
+            series.db_queries += db_queries
+            series.db_seconds += db_seconds
+
+    def sample(self) -> bool:
+        """Sampling decision for a new request or a span outside one."""
+        rate = self.sample_rate
+        return rate >= 1.0 or (rate > 0.0 and random.random() < rate)
+
+    def sampled(self) -> bool:
+        """Whether spans and DB queries of the current context are timed."""
+        if not self.enabled:
+            return False
+        trace = _current_request.get()
+        return trace.sampled if trace is not None else self.sample()
+
+    # -- merging, files ------------------------------------------------
+
+    def snapshot(self) -> dict[SeriesKey, Series]:
+        """This process's series, merged over all threads."""
+        with self._shards_lock:
+            shards = list(self._shards)
+        merged: dict[SeriesKey, Series] = {}
+        for shard in shards:
+            for key, series in shard.copy().items():  # copy is atomic under the GIL
+                target = merged.get(key)
+                if target is None:
+                    target = merged[key] = Series()
+                target.merge(series)
+        return merged
+
+    def _file_prefix(self) -> str:
+        if self.prefix is None:
+            self.prefix = _default_prefix()
+        return self.prefix
+
+    def _directory(self) -> Path:
+        if self.directory is None:
+            from app.services.monitoring.shm import SHM_DIR
+            self.directory = SHM_DIR
+        return self.directory
+
+    def _archive_lock(self, exclusive: bool) -> _ArchiveLock:
+        return _ArchiveLock(self._directory() / f"{self._file_prefix()}-archive.lock", exclusive)
+
+    def _fold_into_archive(self, path: Path, series: Optional[dict[SeriesKey, Series]] = None) -> None:
+        """Add an exited worker's totals to the archive, then remove its file.
+
+        *series* defaults to the file's content. Nothing happens if the file
+        is already gone: another worker folded it first.
+        """
+        directory = self._directory()
+        with self._archive_lock(exclusive=True):
+            if series is None:
+                parsed = read_histogram_file(path)
+                if parsed is None:
+                    return
+                series = parsed[1]
+            elif not path.exists():
+                return
+            archive_path = directory / f"{self._file_prefix()}-archive.bin"
+            archived = read_histogram_file(archive_path)
+            totals = archived[1] if archived is not None else {}
+            _merge_into(totals, series)
+            tmp_path = directory / f"{self._file_prefix()}.archive.tmp"
+            writer = _HistogramFile(tmp_path, ARCHIVE_PID)
+            writer.write(totals, 0)
+            writer.close(unlink=False)
+            if writer.failed:
+                return  # keep the worker file; the next scrape retries
+            os.replace(tmp_path, archive_path)
+            path.unlink(missing_ok=True)
+
+    def flush(self) -> None:
+        """Write this worker's totals to its file."""
+        with self._flush_lock:
+            if self._file is None:
+                path = self._directory() / f"{self._file_prefix()}-{self.pid}.bin"
+                if path.exists():
+                    # Left by an exited worker whose pid we reuse; opening truncates it
+                    self._fold_into_archive(path)
+                self._file = _HistogramFile(path, self.pid)
+            self._file.write(self.snapshot(), self.dropped)
+
+    def collect(self) -> dict[SeriesKey, Series]:
+        """Series summed over all workers, past ones via the archive (this one from memory)."""
+        directory = self._directory()
+        pattern = f"{self._file_prefix()}-*.bin"
+        for path in directory.glob(pattern):
+            parsed = read_histogram_file(path)
+            if parsed is not None and parsed[0] not in (self.pid, ARCHIVE_PID) and not _pid_alive(parsed[0]):
+                self._fold_into_archive(path)
+
+        merged = self.snapshot()
+        # Shared lock: no fold runs while the files are summed
+        with self._archive_lock(exclusive=False):
+            for path in directory.glob(pattern):
+                parsed = read_histogram_file(path)
+                if parsed is None or parsed[0] == self.pid:
+                    continue
+                _merge_into(merged, parsed[1])
+        return merged
+
+    # -- lifecycle -----------------------------------------------------
+
+    def _run(self) -> None:
+        while not self._stop.wait(FLUSH_INTERVAL):
+            try:
+                self.flush()
+            except Exception as exc:  # never let the flusher die
+                logger.debug("Latency histogram flush failed: %s", exc)
+
+    def start(self) -> None:
+        """Enable recording in this worker and start the flusher."""
+        if not settings.tracing_enabled or self._thread is not None:
+            return
+        self.sample_rate = max(0.0, min(1.0, settings.tracing_sample_rate))
+        self.enabled = True
+        self._stop.clear()
+        self._thread = threading.Thread(target=self._run, name="latency-flusher", daemon=True)
+        self._thread.start()
+
+    def stop(self) -> None:
+        """Stop recording; this worker's totals move into the archive."""
+        self.enabled = False
+        thread, self._thread = self._thread, None
+        if thread is not None:
+            self._stop.set()
+            thread.join(timeout=5)
+        with self._flush_lock:
+            if self._file is not None:
+                self._file.close(unlink=False)
+                try:
+                    self._fold_into_archive(self._file.path, self.snapshot())
+                except OSError as exc:
+                    logger.debug("Latency histogram archive failed: %s", exc)
+                    self._file.path.unlink(missing_ok=True)
+                self._file = None
+
+    def reset(self) -> None:
+        """Drop all recorded data (tests)."""
+        with self._shards_lock:
+            for shard in self._shards:
+                shard.clear()
+            self._keys.clear()
+            self.dropped = 0
+
+
+_tracer = Tracer()
+
+
+def get_tracer() -> Tracer:
+    """Process-wide tracer."""
+    return _tracer
+
+
+# ── Request, span and DB hooks ──────────────────────────────────────────────────
+
+def begin_request() -> tuple[RequestTrace, Any]:
+    """Start tracing a request; returns (trace, contextvar token)."""
+    trace = RequestTrace(_tracer.sample())
+    return trace, _current_request.set(trace)
+
+
+def end_request(token: Any) -> None:
+    _current_request.reset(token)
+
+
+class span:
+    """Time a block as a ``span`` series: ``with span("list_directory"): ...``."""
+
+    __slots__ = ("name", "_start")
+
+    def __init__(self, name: str) -> None:
+        self.name = name
+        self._start: Optional[float] = None
+
+    def __enter__(self) -> "span":
+        if _tracer.sampled():
+            self._start = time.perf_counter()
+        return self
+
+    def __exit__(self, *_exc: Any) -> None:
+        if self._start is not None:
+            _tracer.record(("span", self.name), time.perf_counter() - self._start)
+            self._start = None
+
+
+def traced(name: str) -> Callable[[F], F]:
+    """Decorator form of ``span`` for sync and async functions."""
+    def decorator(fn: F) -> F:
+        if iscoroutinefunction(fn):
+            @wraps(fn)
+            async def async_wrapper(*args: Any, **kwargs: Any) -> Any:
+                with span(name):
+                    return await fn(*args, **kwargs)
+            return async_wrapper  # type: ignore[return-value]
+
+        @wraps(fn)
+        def wrapper(*args: Any, **kwargs: Any) -> Any:
+            with span(name):
+                return fn(*args, **kwargs)
+        return wrapper  # type: ignore[return-value]
+    return decorator
+
+
+_SQL_OPERATIONS = frozenset({"SELECT", "INSERT", "UPDATE", "DELETE"})
+
+
+def _operation(statement: str) -> str:
+    head = statement.lstrip()[:8].split(None, 1)
+    op = head[0].upper() if head else ""
+    return op if op in _SQL_OPERATIONS else "OTHER"
+
+
+def _before_cursor_execute(conn, cursor, statement, parameters, context, executemany) -> None:
+    if context is not None and _tracer.sampled():
+        context._trace_start = time.perf_counter()
+
+
+def _after_cursor_execute(conn, cursor, statement, parameters, context, executemany) -> None:
+    start = getattr(context, "_trace_start", None)
+    if start is None:
+        return
+    elapsed = time.perf_counter() - start
+    _tracer.record(("db", _operation(statement)), elapsed)
+    trace = _current_request.get()
+    if trace is not None:
+        trace.db_queries += 1
+        trace.db_seconds += elapsed
+
+
+def instrument_engine(engine: Any) -> None:
+    """Time every statement executed through *engine* (when sampled)."""
+    event.listen(engine, "before_cursor_execute", _before_cursor_execute)
+    event.listen(engine, "after_cursor_execute", _after_cursor_execute)
+
+
+def iter_series(kind: str, series: dict[SeriesKey, Series]) -> Iterator[tuple[str, Series]]:
+    """(name, series) of one kind, sorted by name."""
+    for (k, name), s in sorted(series.items()):
+        if k == kind:
+            yield name, s
@@ -28,6 +28,7 @@ from app.middleware.error_counter import ErrorCounterMiddleware
 from app.middleware.plugin_gate import PluginGateMiddleware
 from app.middleware.sleep_auto_wake import SleepAutoWakeMiddleware
 from app.middleware.api_version import ApiVersionMiddleware
+from app.middleware.request_timing import RequestTimingMiddleware
 
 # Individual file size limit — class attribute, works correctly
 MultiPartParser.max_file_size = 10 * 1024 * 1024 * 1024  # 10 GB (matches nginx client_max_body_size)
@@ -153,6 +154,9 @@ def create_app() -> FastAPI:
         allow_headers=["Authorization", "Content-Type", "X-Device-ID", "X-Requested-With", "Accept", "Origin", "X-Chunk-Index"],
     )
 
+    # Outermost: route latency histograms include every middleware above
+    app.add_middleware(RequestTimingMiddleware)
+
     from app.api.versioned import create_versioned_router
     app.include_router(create_versioned_router(), prefix=settings.api_prefix)
 
@@ -15,6 +15,7 @@ from fastapi import Request
 from starlette.middleware.base import BaseHTTPMiddleware
 from starlette.responses import JSONResponse
 
+from app.core import startup
 from app.plugins.manager import PluginManager
 from app.services import plugin_enablement
 
@@ -95,6 +96,10 @@ class PluginGateMiddleware(BaseHTTPMiddleware):
         if _is_management_route(sub_path):
             return await call_next(request)
 
+        # Plugin routes are mounted by a deferred startup step; a request
+        # that arrives before it finished waits instead of getting a 404
+        await startup.wait_for("plugins")
+
         # --- Gate: check plugin status ---
         try:
             await plugin_enablement.refresh()
@@ -0,0 +1,38 @@
+"""Per-route latency histograms for every HTTP request (core/tracing.py).
+
+A plain ASGI middleware rather than ``BaseHTTPMiddleware``: the timing ends
+when the inner app returns, i.e. after the last body chunk of a streamed
+download was sent, and no extra task is spawned per request.
+
+The route label is the matched route template (``GET /api/files/list``), read
+from ``scope["route"]`` after the router ran, so path parameters never create
+new series; requests that match no route are counted as ``unmatched``.
+"""
+import time
+
+from starlette.types import ASGIApp, Receive, Scope, Send
+
+from app.core.tracing import begin_request, end_request, get_tracer
+
+
+class RequestTimingMiddleware:
+    def __init__(self, app: ASGIApp) -> None:
+        self.app = app
+
+    async def __call__(self, scope: Scope, receive: Receive, send: Send) -> None:
+        tracer = get_tracer()
+        if scope["type"] != "http" or not tracer.enabled:
+            await self.app(scope, receive, send)
+            return
+
+        trace, token = begin_request()
+        start = time.perf_counter()
+        try:
+            await self.app(scope, receive, send)
+        finally:
+            elapsed = time.perf_counter() - start
+            end_request(token)
+            route = getattr(scope.get("route"), "path", None) or "unmatched"
+            tracer.record(
+                ("http", f"{scope['method']} {route}"), elapsed, trace.db_queries, trace.db_seconds,
+            )
@@ -2,13 +2,14 @@
 from app.models.base import Base
 from app.models.user import User
 from app.models.file_metadata import FileMetadata
+from app.models.file_search import FileSearchEntry
 from app.models.audit_log import AuditLog
 from app.models.file_share import FileShare
 from app.models.backup import Backup
 from app.models.vpn import VPNConfig, VPNClient
 from app.models.mobile import MobileDevice
 from app.models.rate_limit_config import RateLimitConfig
-from app.models.vcl import FileVersion, VersionBlob, VCLSettings, VCLStats
+from app.models.vcl import FileVersion, VersionBlob, VersionBlobChunk, VersionChunk, VCLSettings, VCLStats
 from app.models.server_profile import ServerProfile
 from app.models.vpn_profile import VPNProfile, VPNType
 from app.models.refresh_token import RefreshToken
@@ -19,6 +20,9 @@ from app.models.monitoring import (
     NetworkSample,
     DiskIoSample,
     ProcessSample,
+    MetricRollup1m,
+    MetricRollup15m,
+    MetricRollup1h,
     MonitoringConfig,
 )
 from app.models.power import (
@@ -58,6 +62,8 @@ from app.models.benchmark import (
     BenchmarkStatus,
     BenchmarkProfile,
     BenchmarkTargetType,
+    WorkloadBenchmark,
+    WorkloadResult,
 )
 from app.models.notification import (
     Notification,
@@ -73,7 +79,7 @@ from app.models.update_history import (
 )
 from app.models.energy_price_config import EnergyPriceConfig
 from app.models.ssd_file_cache import SSDCacheConfig
-from app.models.cloud import CloudOAuthConfig, CloudConnection, CloudImportJob
+from app.models.cloud import CloudOAuthConfig, CloudConnection, CloudImportJob, CloudTransferCheckpoint
 from app.models.cloud_export import CloudExportJob
 from app.models.sleep import SleepConfig, SleepStateLog, CoreUptimeWindow, PresenceSession
 from app.models.system_lifecycle import SystemLifecycleEvent
@@ -83,8 +89,15 @@ from app.models.desktop_sync_folder import DesktopSyncFolder
 from app.models.service_heartbeat import ServiceHeartbeat
 from app.models.version_history import VersionHistory
 from app.models.migration_job import MigrationJob
+from app.models.ownership_transfer import OwnershipTransferJob
 from app.models.pihole import PiholeConfig
-from app.models.dns_queries import DnsQuery, DnsQueryHourlyStat, DnsQueryCollectorState
+from app.models.dns_queries import (
+    DnsQuery,
+    DnsQueryHourlyStat,
+    DnsQueryCollectorState,
+    DnsQueryDomainHourly,
+    DnsQueryClientHourly,
+)
 from app.models.ad_discovery import (
     AdDiscoveryPattern,
     AdDiscoveryReferenceList,
@@ -100,7 +113,7 @@ from app.models.power_permissions import UserPowerPermission
 from app.models.power_boost_rule import PowerBoostRule
 from app.models.notification_routing import UserNotificationRouting
 from app.models.sync_progress import ChunkedUpload, SyncBandwidthLimit, SyncSchedule, SelectiveSync
-from app.models.sync_state import SyncState, SyncMetadata, SyncFileVersion
+from app.models.sync_state import SyncState, SyncMetadata, SyncFileVersion, SyncChange
 from app.models.status_bar import StatusBarPillConfig, StatusBarSettings
 from app.models.steam_session import SteamSession
 from app.models.auth_policy import AuthPolicy
@@ -110,6 +123,7 @@ __all__ = [
     "User",
     "AuthPolicy",
     "FileMetadata",
+    "FileSearchEntry",
     "AuditLog",
     "FileShare",
     "Backup",
@@ -119,6 +133,8 @@ __all__ = [
     "RateLimitConfig",
     "FileVersion",
     "VersionBlob",
+    "VersionBlobChunk",
+    "VersionChunk",
     "VCLSettings",
     "VCLStats",
     "ServerProfile",
@@ -131,6 +147,9 @@ __all__ = [
     "NetworkSample",
     "DiskIoSample",
     "ProcessSample",
+    "MetricRollup1m",
+    "MetricRollup15m",
+    "MetricRollup1h",
     "MonitoringConfig",
     "PowerProfileLog",
     "PowerDemandLog",
@@ -165,6 +184,8 @@ __all__ = [
     "SmartDeviceSample",
     "DiskBenchmark",
     "BenchmarkTestResult",
+    "WorkloadBenchmark",
+    "WorkloadResult",
     "BenchmarkStatus",
     "BenchmarkProfile",
     "BenchmarkTargetType",
@@ -181,6 +202,7 @@ __all__ = [
     "CloudOAuthConfig",
     "CloudConnection",
     "CloudImportJob",
+    "CloudTransferCheckpoint",
     "CloudExportJob",
     "SleepConfig",
     "SleepStateLog",
@@ -193,10 +215,13 @@ __all__ = [
     "ServiceHeartbeat",
     "VersionHistory",
     "MigrationJob",
+    "OwnershipTransferJob",
     "PiholeConfig",
     "DnsQuery",
     "DnsQueryHourlyStat",
     "DnsQueryCollectorState",
+    "DnsQueryDomainHourly",
+    "DnsQueryClientHourly",
     "AdDiscoveryPattern",
     "AdDiscoveryReferenceList",
     "AdDiscoverySuspect",
@@ -216,6 +241,7 @@ __all__ = [
     "SyncState",
     "SyncMetadata",
     "SyncFileVersion",
+    "SyncChange",
     "StatusBarPillConfig",
     "StatusBarSettings",
     "SteamSession",
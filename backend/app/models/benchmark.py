@@ -4,6 +4,7 @@ SQLAlchemy models for disk benchmarking.
 Stores benchmark runs and individual test results for historical analysis:
 - DiskBenchmark: Main benchmark run with summary results
 - BenchmarkTestResult: Detailed results for each individual test
+- WorkloadBenchmark / WorkloadResult: End-to-end workload runs through the API
 """
 
 from __future__ import annotations
@@ -11,7 +12,7 @@ from __future__ import annotations
 from datetime import datetime
 from typing import Optional, List
 
-from sqlalchemy import Column, Integer, BigInteger, Float, DateTime, String, ForeignKey, Enum as SQLEnum
+from sqlalchemy import Column, Integer, BigInteger, Float, DateTime, String, Text, ForeignKey, Enum as SQLEnum
 from sqlalchemy.orm import relationship, Mapped
 import enum
 
@@ -154,3 +155,87 @@ class BenchmarkTestResult(Base):
 
     def __repr__(self) -> str:
         return f"<BenchmarkTestResult(test={self.test_name}, op={self.operation}, mbps={self.throughput_mbps})>"
+
+
+class WorkloadBenchmark(Base):
+    """
+    End-to-end workload benchmark run (services/benchmark/suite.py).
+
+    Measures what clients experience through the live API (uploads,
+    downloads, listings, versioning, SSD cache, WebDAV) rather than raw disks.
+    Runs are fingerprinted by app version and hardware so results can be
+    compared over time; ``baseline_id`` is the run this one was compared with.
+    """
+
+    __tablename__ = "workload_benchmarks"
+
+    id: Mapped[int] = Column(Integer, primary_key=True, index=True)
+    profile: Mapped[str] = Column(String(32), nullable=False)
+
+    status: Mapped[BenchmarkStatus] = Column(
+        SQLEnum(BenchmarkStatus, values_callable=lambda x: [e.value for e in x]),
+        nullable=False,
+        default=BenchmarkStatus.PENDING,
+        index=True
+    )
+    progress_percent: Mapped[float] = Column(Float, nullable=False, default=0.0)
+    current_workload: Mapped[Optional[str]] = Column(String(64), nullable=True)
+    error_message: Mapped[Optional[str]] = Column(String(1024), nullable=True)
+
+    created_at: Mapped[datetime] = Column(DateTime, nullable=False, default=datetime.utcnow)
+    started_at: Mapped[Optional[datetime]] = Column(DateTime, nullable=True)
+    completed_at: Mapped[Optional[datetime]] = Column(DateTime, nullable=True)
+    duration_seconds: Mapped[Optional[float]] = Column(Float, nullable=True)
+
+    # Fingerprints: runs are only compared on the same hardware
+    app_version: Mapped[Optional[str]] = Column(String(64), nullable=True)
+    app_commit: Mapped[Optional[str]] = Column(String(64), nullable=True)
+    hardware_fingerprint: Mapped[Optional[str]] = Column(String(64), nullable=True, index=True)
+    environment_json: Mapped[Optional[str]] = Column(Text, nullable=True)  # CPU, RAM, disks, kernel
+
+    # Comparison with the previous run (set on completion)
+    baseline_id: Mapped[Optional[int]] = Column(
+        Integer, ForeignKey("workload_benchmarks.id", ondelete="SET NULL"), nullable=True
+    )
+    regressions: Mapped[Optional[int]] = Column(Integer, nullable=True)
+
+    user_id: Mapped[Optional[int]] = Column(Integer, ForeignKey("users.id"), nullable=True)
+
+    results: Mapped[List[WorkloadResult]] = relationship(
+        "WorkloadResult", back_populates="benchmark", cascade="all, delete-orphan"
+    )
+
+    def __repr__(self) -> str:
+        return f"<WorkloadBenchmark(id={self.id}, profile={self.profile}, status={self.status.value})>"
+
+
+class WorkloadResult(Base):
+    """Measurements of one workload within a ``WorkloadBenchmark`` run."""
+
+    __tablename__ = "workload_results"
+
+    id: Mapped[int] = Column(Integer, primary_key=True, index=True)
+    benchmark_id: Mapped[int] = Column(
+        Integer, ForeignKey("workload_benchmarks.id", ondelete="CASCADE"), nullable=False, index=True
+    )
+
+    workload: Mapped[str] = Column(String(64), nullable=False)  # e.g. "upload_chunked"
+    status: Mapped[str] = Column(String(16), nullable=False)  # "ok", "skipped", "failed"
+    detail: Mapped[Optional[str]] = Column(String(512), nullable=True)  # skip/failure reason
+
+    samples: Mapped[int] = Column(Integer, nullable=False, default=0)
+    errors: Mapped[int] = Column(Integer, nullable=False, default=0)
+    bytes_total: Mapped[Optional[int]] = Column(BigInteger, nullable=True)
+    elapsed_seconds: Mapped[Optional[float]] = Column(Float, nullable=True)
+
+    throughput_mbps: Mapped[Optional[float]] = Column(Float, nullable=True)
+    ops_per_second: Mapped[Optional[float]] = Column(Float, nullable=True)
+    latency_p50_ms: Mapped[Optional[float]] = Column(Float, nullable=True)
+    latency_p95_ms: Mapped[Optional[float]] = Column(Float, nullable=True)
+    latency_p99_ms: Mapped[Optional[float]] = Column(Float, nullable=True)
+    latency_max_ms: Mapped[Optional[float]] = Column(Float, nullable=True)
+
+    benchmark: Mapped[WorkloadBenchmark] = relationship("WorkloadBenchmark", back_populates="results")
+
+    def __repr__(self) -> str:
+        return f"<WorkloadResult(workload={self.workload}, status={self.status})>"
@@ -75,3 +75,29 @@ class CloudImportJob(Base):
 
     def __repr__(self) -> str:
         return f"<CloudImportJob(id={self.id}, status='{self.status}', type='{self.job_type}')>"
+
+
+class CloudTransferCheckpoint(Base):
+    """Resume journal of a cloud import/export (services/cloud/transfer.py).
+
+    One row per file of a job; large files record the indices of the parts
+    already on disk. Rows are deleted once the job finished.
+    """
+    __tablename__ = "cloud_transfer_checkpoints"
+    __table_args__ = (
+        UniqueConstraint("job_kind", "job_id", "rel_path", name="uq_cloud_checkpoint_job_path"),
+    )
+
+    id: Mapped[int] = mapped_column(Integer, primary_key=True, index=True)
+    job_kind: Mapped[str] = mapped_column(String(10), nullable=False)  # import | export
+    job_id: Mapped[int] = mapped_column(Integer, nullable=False)
+    rel_path: Mapped[str] = mapped_column(String(1000), nullable=False)
+    size_bytes: Mapped[int] = mapped_column(BigInteger, nullable=False, default=0)
+    completed: Mapped[bool] = mapped_column(Boolean, nullable=False, default=False)
+    parts_done: Mapped[Optional[str]] = mapped_column(Text, nullable=True)  # comma-separated part indices
+    updated_at: Mapped[datetime] = mapped_column(
+        DateTime(timezone=True), server_default=func.now(), onupdate=func.now(), nullable=False
+    )
+
+    def __repr__(self) -> str:
+        return f"<CloudTransferCheckpoint(job={self.job_kind}:{self.job_id}, path='{self.rel_path}')>"
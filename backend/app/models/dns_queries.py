@@ -55,11 +55,42 @@ class DnsQueryHourlyStat(Base):
     unique_domains: Mapped[int] = mapped_column(Integer, default=0)
     unique_clients: Mapped[int] = mapped_column(Integer, default=0)
     avg_response_time_ms: Mapped[Optional[float]] = mapped_column(Float, nullable=True)
+    # Queries that reported a response time: the weight of avg_response_time_ms
+    # when the collector merges a new batch into the hour
+    timed_queries: Mapped[int] = mapped_column(Integer, default=0, server_default="0")
 
     def __repr__(self) -> str:
         return f"<DnsQueryHourlyStat(hour={self.hour}, total={self.total_queries})>"
 
 
+class DnsQueryDomainHourly(Base):
+    """Per-hour query counts for one domain (top domains / top blocked)."""
+
+    __tablename__ = "dns_query_domain_hourly"
+
+    hour: Mapped[datetime] = mapped_column(primary_key=True)
+    domain: Mapped[str] = mapped_column(String(253), primary_key=True)
+    total_queries: Mapped[int] = mapped_column(Integer, default=0)
+    blocked_queries: Mapped[int] = mapped_column(Integer, default=0)
+
+    def __repr__(self) -> str:
+        return f"<DnsQueryDomainHourly(hour={self.hour}, domain={self.domain}, total={self.total_queries})>"
+
+
+class DnsQueryClientHourly(Base):
+    """Per-hour query counts for one client (top clients)."""
+
+    __tablename__ = "dns_query_client_hourly"
+
+    hour: Mapped[datetime] = mapped_column(primary_key=True)
+    client: Mapped[str] = mapped_column(String(45), primary_key=True)
+    total_queries: Mapped[int] = mapped_column(Integer, default=0)
+    blocked_queries: Mapped[int] = mapped_column(Integer, default=0)
+
+    def __repr__(self) -> str:
+        return f"<DnsQueryClientHourly(hour={self.hour}, client={self.client}, total={self.total_queries})>"
+
+
 class DnsQueryCollectorState(Base):
     """Singleton (id=1) storing collector state and configuration."""
 
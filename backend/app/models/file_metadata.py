@@ -4,13 +4,14 @@ from __future__ import annotations
 from datetime import datetime
 from typing import TYPE_CHECKING, Optional, List
 
-from sqlalchemy import String, DateTime, Integer, BigInteger, Boolean, ForeignKey
+from sqlalchemy import String, DateTime, Integer, BigInteger, Boolean, ForeignKey, Index
 from sqlalchemy.orm import Mapped, mapped_column, relationship
 from sqlalchemy.sql import func
 
 from app.models.base import Base
 
 if TYPE_CHECKING:
+    from app.models.file_search import FileSearchEntry
     from app.models.vcl import FileVersion
 
 
@@ -47,6 +48,18 @@ class FileMetadata(Base):
         back_populates="file",
         cascade="all, delete-orphan"
     )
+    # Search index row, maintained by services/files/search
+    search_entry: Mapped[Optional["FileSearchEntry"]] = relationship(
+        "FileSearchEntry",
+        uselist=False,
+        cascade="all, delete-orphan",
+    )
+
+    __table_args__ = (
+        # Subtree selects (``path LIKE 'dir/%'``); the unique index above uses
+        # the database collation, which PostgreSQL cannot use for LIKE.
+        Index("ix_file_metadata_path_prefix", "path", postgresql_ops={"path": "text_pattern_ops"}),
+    )
     
     def __repr__(self) -> str:
         type_str = "dir" if self.is_directory else "file"
@@ -0,0 +1,54 @@
+"""Search index over file metadata."""
+from __future__ import annotations
+
+from datetime import datetime
+from typing import Optional
+
+from sqlalchemy import BigInteger, Boolean, DateTime, ForeignKey, Index, Integer, String, Text
+from sqlalchemy.orm import Mapped, mapped_column
+
+from app.models.base import Base
+
+
+class FileSearchEntry(Base):
+    """One searchable ``FileMetadata`` row, denormalized for the search queries.
+
+    Written in the same transaction as the metadata change it mirrors (see
+    ``services/files/search``). ``name_folded``/``path_folded`` are casefolded
+    copies so prefix and substring matches need no ``lower()`` per row.
+
+    PostgreSQL additionally gets trigram GIN indexes on both folded columns
+    and a full-text GIN index on ``content`` (migration
+    ``file_search_index_2026_10_14``); they need the pg_trgm extension and
+    are not declared here.
+    """
+
+    __tablename__ = "file_search_index"
+
+    file_id: Mapped[int] = mapped_column(
+        Integer, ForeignKey("file_metadata.id", ondelete="CASCADE"), primary_key=True
+    )
+    owner_id: Mapped[int] = mapped_column(Integer, ForeignKey("users.id", ondelete="CASCADE"), nullable=False)
+    path: Mapped[str] = mapped_column(String(1000), nullable=False)
+    name: Mapped[str] = mapped_column(String(255), nullable=False)
+    path_folded: Mapped[str] = mapped_column(String(1000), nullable=False)
+    name_folded: Mapped[str] = mapped_column(String(255), nullable=False)
+    extension: Mapped[Optional[str]] = mapped_column(String(32), nullable=True)  # lowercase, no dot
+    is_directory: Mapped[bool] = mapped_column(Boolean, nullable=False, default=False)
+    size_bytes: Mapped[int] = mapped_column(BigInteger, nullable=False, default=0)
+    mime_type: Mapped[Optional[str]] = mapped_column(String(100), nullable=True)
+    modified_at: Mapped[Optional[datetime]] = mapped_column(DateTime(timezone=True), nullable=True)
+    # Extracted text, optional (set_content); truncated to MAX_CONTENT_CHARS
+    content: Mapped[Optional[str]] = mapped_column(Text, nullable=True)
+
+    __table_args__ = (
+        Index("ix_file_search_name_prefix", "name_folded", postgresql_ops={"name_folded": "text_pattern_ops"}),
+        Index("ix_file_search_path_prefix", "path_folded", postgresql_ops={"path_folded": "text_pattern_ops"}),
+        Index("ix_file_search_owner_name", "owner_id", "name_folded"),
+        Index("ix_file_search_extension", "extension"),
+        Index("ix_file_search_modified", "modified_at"),
+        Index("ix_file_search_size", "size_bytes"),
+    )
+
+    def __repr__(self) -> str:
+        return f"<FileSearchEntry(file_id={self.file_id}, path='{self.path}')>"
@@ -7,13 +7,14 @@ Stores historical system metrics for long-term analysis and statistics:
 - Network samples (download/upload speed)
 - Disk I/O samples (read/write throughput, IOPS)
 - Process samples (BaluHost process tracking)
+- Rollups (1 min / 15 min / 1 h min/max/avg/p95 buckets per metric field)
 - Monitoring configuration (retention policies)
 """
 
 from datetime import datetime
 from typing import Optional
 
-from sqlalchemy import Column, Integer, BigInteger, Float, DateTime, String, Boolean, Enum as SQLEnum, JSON
+from sqlalchemy import Column, Integer, BigInteger, Float, DateTime, String, Boolean, Enum as SQLEnum, JSON, Index
 from sqlalchemy.orm import Mapped
 import enum
 
@@ -233,6 +234,52 @@ class GpuSample(Base):
         return f"<GpuSample(device={self.device_name}, usage={self.usage_percent}%, ts={self.timestamp})>"
 
 
+class _RollupColumns:
+    """
+    One aggregated bucket of one metric field.
+
+    ``series`` is the disk name for disk I/O and empty for system-wide
+    metrics. avg = value_sum / sample_count. On PostgreSQL the tables are
+    range-partitioned on ``bucket_start`` (see services/monitoring/rollups.py),
+    so retention drops whole partitions.
+    """
+
+    metric: Mapped[str] = Column(String(16), primary_key=True)
+    series: Mapped[str] = Column(String(64), primary_key=True, default="")
+    field: Mapped[str] = Column(String(32), primary_key=True)
+    bucket_start: Mapped[datetime] = Column(DateTime, primary_key=True)  # naive UTC
+
+    sample_count: Mapped[int] = Column(Integer, nullable=False)
+    value_min: Mapped[float] = Column(Float, nullable=False)
+    value_max: Mapped[float] = Column(Float, nullable=False)
+    value_sum: Mapped[float] = Column(Float, nullable=False)
+    value_p95: Mapped[float] = Column(Float, nullable=False)
+
+    def __repr__(self) -> str:
+        return f"<{type(self).__name__}({self.metric}/{self.series}/{self.field} @ {self.bucket_start})>"
+
+
+class MetricRollup1m(_RollupColumns, Base):
+    __tablename__ = "metric_rollups_1m"
+    __table_args__ = (
+        Index("ix_metric_rollups_1m_bucket_brin", "bucket_start", postgresql_using="brin"),
+    )
+
+
+class MetricRollup15m(_RollupColumns, Base):
+    __tablename__ = "metric_rollups_15m"
+    __table_args__ = (
+        Index("ix_metric_rollups_15m_bucket_brin", "bucket_start", postgresql_using="brin"),
+    )
+
+
+class MetricRollup1h(_RollupColumns, Base):
+    __tablename__ = "metric_rollups_1h"
+    __table_args__ = (
+        Index("ix_metric_rollups_1h_bucket_brin", "bucket_start", postgresql_using="brin"),
+    )
+
+
 class MonitoringConfig(Base):
     """
     Monitoring configuration per metric type.
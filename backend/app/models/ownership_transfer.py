@@ -0,0 +1,54 @@
+"""Database model for bulk ownership transfer jobs."""
+from datetime import datetime
+from typing import Optional
+
+from sqlalchemy import Boolean, DateTime, ForeignKey, Integer, String, Text
+from sqlalchemy.orm import Mapped, mapped_column
+from sqlalchemy.sql import func
+
+from app.models.base import Base
+
+
+class OwnershipTransferJob(Base):
+    """A directory transfer that rewrites its subtree in resumable batches.
+
+    ``last_file_id`` is the keyset cursor: every ``file_metadata`` row below
+    ``source_path`` with an id up to it has already been moved to
+    ``target_path`` and the new owner (see ``services/files/ownership_jobs``).
+    ``max_file_id`` is the highest id when the root was moved; rows created
+    at the old path afterwards are not part of the transfer.
+    """
+    __tablename__ = "ownership_transfer_jobs"
+
+    id: Mapped[int] = mapped_column(Integer, primary_key=True, index=True)
+    file_id: Mapped[int] = mapped_column(
+        Integer, ForeignKey("file_metadata.id", ondelete="CASCADE"), nullable=False
+    )
+    source_path: Mapped[str] = mapped_column(String(1000), nullable=False)
+    target_path: Mapped[str] = mapped_column(String(1000), nullable=False)
+    old_owner_id: Mapped[int] = mapped_column(Integer, ForeignKey("users.id"), nullable=False)
+    new_owner_id: Mapped[int] = mapped_column(Integer, ForeignKey("users.id"), nullable=False)
+    requested_by: Mapped[int] = mapped_column(Integer, ForeignKey("users.id"), nullable=False)
+    physical_move: Mapped[bool] = mapped_column(Boolean, nullable=False, default=True)
+    status: Mapped[str] = mapped_column(
+        String(20), nullable=False, default="pending", index=True
+    )  # pending | running | completed | failed
+
+    # Progress
+    total_items: Mapped[int] = mapped_column(Integer, default=0, nullable=False)
+    processed_items: Mapped[int] = mapped_column(Integer, default=0, nullable=False)
+    last_file_id: Mapped[int] = mapped_column(Integer, default=0, nullable=False)
+    max_file_id: Mapped[int] = mapped_column(Integer, default=0, nullable=False)
+    error_message: Mapped[Optional[str]] = mapped_column(Text, nullable=True)
+
+    created_at: Mapped[datetime] = mapped_column(
+        DateTime(timezone=True), server_default=func.now(), nullable=False
+    )
+    started_at: Mapped[Optional[datetime]] = mapped_column(DateTime(timezone=True), nullable=True)
+    completed_at: Mapped[Optional[datetime]] = mapped_column(DateTime(timezone=True), nullable=True)
+
+    def __repr__(self) -> str:
+        return (
+            f"<OwnershipTransferJob(id={self.id}, source='{self.source_path}', "
+            f"status='{self.status}', progress={self.processed_items}/{self.total_items})>"
+        )
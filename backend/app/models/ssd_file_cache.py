@@ -4,6 +4,7 @@ Application-layer file cache that copies hot files from HDD to SSD
 for faster read access. Write-through semantics: HDD is always authoritative.
 Per-array: each RAID array has its own cache config and entries.
 """
+import math
 from datetime import datetime, timezone
 from typing import Optional
 from sqlalchemy import (
@@ -13,6 +14,31 @@ from sqlalchemy import (
 from sqlalchemy.orm import Mapped, mapped_column
 from app.models.base import Base
 
+# LFRU half-life: an entry's frequency credit halves for every LFRU_HALF_LIFE
+# seconds it goes unread. The decay is the same for every entry, so the
+# relative order only changes when an entry is touched and can be stored.
+LFRU_HALF_LIFE_SECONDS = 6 * 3600
+
+
+def lfru_priority(access_count: int, last_accessed: Optional[datetime]) -> float:
+    """Time-invariant LFRU key: lowest value is evicted first.
+
+    ``log2(1 + hits) + t_last / half_life`` is ``log2`` of an exponentially
+    decayed hit count, shifted by a term common to all entries.
+    """
+    if last_accessed is None:
+        last_accessed = datetime.now(timezone.utc)
+    elif last_accessed.tzinfo is None:
+        last_accessed = last_accessed.replace(tzinfo=timezone.utc)
+    return math.log2(1 + max(int(access_count or 0), 0)) + (
+        last_accessed.timestamp() / LFRU_HALF_LIFE_SECONDS
+    )
+
+
+def _default_priority(context) -> float:
+    params = context.get_current_parameters()
+    return lfru_priority(params.get("access_count") or 0, params.get("last_accessed"))
+
 
 class SSDCacheEntry(Base):
     """Individual cached file entry on the SSD."""
@@ -48,6 +74,10 @@ class SSDCacheEntry(Base):
         DateTime, default=lambda: datetime.now(timezone.utc), index=True
     )
 
+    # Precomputed LFRU order (see lfru_priority); kept current on insert
+    # and on every access-stats flush so eviction is an index scan.
+    eviction_priority: Mapped[float] = mapped_column(Float, default=_default_priority)
+
     # State
     is_valid: Mapped[bool] = mapped_column(Boolean, default=True, index=True)
     # Tracks source file modification time to detect staleness
@@ -62,6 +92,18 @@ class SSDCacheEntry(Base):
             "access_count",
             "last_accessed",
         ),
+        Index(
+            "idx_ssd_cache_lfru",
+            "array_name",
+            "is_valid",
+            "eviction_priority",
+        ),
+        Index(
+            "idx_ssd_cache_lru",
+            "array_name",
+            "is_valid",
+            "last_accessed",
+        ),
     )
 
     def __repr__(self):
@@ -1,7 +1,7 @@
 """Database models for file sync state tracking."""
 
 from datetime import datetime
-from sqlalchemy import String, DateTime, Integer, Boolean, ForeignKey
+from sqlalchemy import BigInteger, String, DateTime, Integer, Boolean, ForeignKey, Index
 from sqlalchemy.orm import Mapped, mapped_column, relationship
 from sqlalchemy.sql import func
 
@@ -74,3 +74,32 @@ class SyncFileVersion(Base):
     created_at: Mapped[datetime] = mapped_column(DateTime(timezone=True), server_default=func.now())
     created_by_id: Mapped[int] = mapped_column(Integer, ForeignKey("users.id"), nullable=False)
     change_reason: Mapped[str | None] = mapped_column(String(255), nullable=True)
+
+
+class SyncChange(Base):
+    """Append-only journal of file changes, read by sync clients.
+
+    ``id`` is the sync cursor: a device asks for changes with ``id`` greater
+    than the last one it applied. Rows are written in the same transaction
+    as the ``FileMetadata`` change they describe.
+    """
+
+    __tablename__ = "sync_changes"
+
+    id: Mapped[int] = mapped_column(
+        BigInteger().with_variant(Integer, "sqlite"),
+        primary_key=True,
+        autoincrement=True,
+    )
+    owner_id: Mapped[int] = mapped_column(Integer, ForeignKey("users.id", ondelete="CASCADE"), nullable=False)
+    action: Mapped[str] = mapped_column(String(16), nullable=False)  # 'upsert', 'delete', 'move'
+    path: Mapped[str] = mapped_column(String(1000), nullable=False)
+    old_path: Mapped[str | None] = mapped_column(String(1000), nullable=True)  # moves only
+    is_directory: Mapped[bool] = mapped_column(Boolean, nullable=False, default=False)
+    size_bytes: Mapped[int | None] = mapped_column(BigInteger, nullable=True)
+    checksum: Mapped[str | None] = mapped_column(String(64), nullable=True)
+    created_at: Mapped[datetime] = mapped_column(DateTime(timezone=True), server_default=func.now(), nullable=False, index=True)
+
+    __table_args__ = (
+        Index("idx_sync_changes_owner_cursor", "owner_id", "id"),
+    )
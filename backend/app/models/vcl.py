@@ -16,6 +16,10 @@ class VersionBlob(Base):
     """Deduplicated storage blobs for file versions.
 
     Multiple file versions can reference the same blob via checksum.
+    A blob is either one file written with the codec named by
+    ``storage_format`` ('gzip', 'zstd', 'raw') or a manifest of
+    content-defined chunks (``'chunked'``, see ``VersionBlobChunk``); for
+    chunked blobs ``compressed_size`` counts only the chunks it added.
     """
     __tablename__ = "version_blobs"
 
@@ -28,6 +32,7 @@ class VersionBlob(Base):
     created_at: Mapped[datetime] = mapped_column(DateTime, default=datetime.utcnow)
     last_accessed: Mapped[Optional[datetime]] = mapped_column(DateTime, nullable=True)
     can_delete: Mapped[bool] = mapped_column(Boolean, default=False)
+    storage_format: Mapped[str] = mapped_column(String(16), default="gzip", server_default="gzip", nullable=False)
     
     # Relationships
     file_versions = relationship("FileVersion", back_populates="blob")
@@ -40,6 +45,39 @@ class VersionBlob(Base):
         return f"<VersionBlob(id={self.id}, checksum={self.checksum[:8]}..., refs={self.reference_count})>"
 
 
+class VersionChunk(Base):
+    """Content-defined chunk shared by chunked blobs.
+
+    ``reference_count`` is the number of manifest entries pointing at it.
+    """
+    __tablename__ = "vcl_chunks"
+
+    id: Mapped[int] = mapped_column(Integer, primary_key=True)
+    checksum: Mapped[str] = mapped_column(String(64), unique=True, index=True)  # SHA256 of raw chunk
+    original_size: Mapped[int] = mapped_column(Integer, nullable=False)
+    compressed_size: Mapped[int] = mapped_column(Integer, nullable=False)
+    reference_count: Mapped[int] = mapped_column(Integer, default=0, nullable=False)
+    codec: Mapped[str] = mapped_column(String(16), default="gzip", server_default="gzip", nullable=False)
+    created_at: Mapped[datetime] = mapped_column(DateTime, default=datetime.utcnow, nullable=False)
+
+    def __repr__(self):
+        return f"<VersionChunk(id={self.id}, checksum={self.checksum[:8]}..., refs={self.reference_count})>"
+
+
+class VersionBlobChunk(Base):
+    """Manifest entry: chunk ``seq`` of a chunked blob."""
+    __tablename__ = "vcl_blob_chunks"
+
+    blob_id: Mapped[int] = mapped_column(Integer, ForeignKey("version_blobs.id", ondelete="CASCADE"), primary_key=True)
+    seq: Mapped[int] = mapped_column(Integer, primary_key=True)
+    chunk_id: Mapped[int] = mapped_column(Integer, ForeignKey("vcl_chunks.id"), nullable=False, index=True)
+
+    chunk = relationship("VersionChunk")
+
+    def __repr__(self):
+        return f"<VersionBlobChunk(blob_id={self.blob_id}, seq={self.seq}, chunk_id={self.chunk_id})>"
+
+
 class FileVersion(Base):
     """File version metadata and storage information.
     
@@ -609,7 +609,7 @@ class TapoSmartPlugPlugin(SmartDevicePlugin):
         """Lazily create and return the real TapoService."""
         if self._service is None:
             from app.plugins.installed.tapo_smart_plug.service import TapoService
-            self._service = TapoService()
+            self._service = TapoService(self.sessions)
         return self._service
 
     def _get_mock_service(self) -> Any:
@@ -2,16 +2,18 @@
 
 Migrated from ``app.services.power.monitor._sample_device()`` into the
 smart-device plugin framework.  Uses plugp100 v5.x API for device
-communication, with client caching to avoid repeated authentication.
+communication over the shared smart-device HTTP pool, with clients cached in
+the plugin's session cache to avoid repeated authentication.
 """
 from __future__ import annotations
 
 import asyncio
 import logging
 from datetime import datetime, timezone
-from typing import TYPE_CHECKING, Any, Dict
+from typing import TYPE_CHECKING, Any, Dict, Optional
 
 from app.plugins.smart_device.capabilities import PowerReading, SwitchState
+from app.plugins.smart_device.connections import DeviceSessionCache, get_device_connections
 
 if TYPE_CHECKING:
     from plugp100.new.tapodevice import TapoDevice
@@ -34,14 +36,15 @@ def _is_auth_error(exc: Exception) -> bool:
 class TapoService:
     """Handles real plugp100 communication for Tapo smart plugs.
 
-    Maintains a per-device client cache to avoid repeated authentication.
-    On timeout or error, the cached client is evicted so the next call
-    reconnects from scratch.
+    Keeps connected clients in a ``DeviceSessionCache`` (the plugin's) to
+    avoid repeated authentication; concurrent calls for one device share a
+    single login. On timeout or error, the cached client is evicted so the
+    next call reconnects from scratch.
     """
 
-    def __init__(self) -> None:
+    def __init__(self, sessions: Optional[DeviceSessionCache] = None) -> None:
         # cache_key (device_id:ip) -> connected plugp100 device object
-        self._client_cache: Dict[str, TapoDevice] = {}
+        self._sessions = sessions if sessions is not None else DeviceSessionCache()
 
     # ------------------------------------------------------------------
     # Internal helpers
@@ -70,26 +73,28 @@ class TapoService:
 
         cache_key = f"{device_id}:{ip}"
 
-        if cache_key not in self._client_cache:
+        device = self._sessions.get(cache_key)
+        if device is not None:
+            await asyncio.wait_for(device.update(), timeout=_DEVICE_TIMEOUT)
+            return device
+
+        async def connect() -> TapoDevice:
             credentials = device_factory.AuthCredential(email, password)
             config = device_factory.DeviceConnectConfiguration(
                 host=ip, credentials=credentials
             )
-            device = await asyncio.wait_for(
-                device_factory.connect(config), timeout=_DEVICE_TIMEOUT
+            session = await get_device_connections().http_session()
+            connected = await asyncio.wait_for(
+                device_factory.connect(config, session=session), timeout=_DEVICE_TIMEOUT
             )
-            await device.update()
-            self._client_cache[cache_key] = device
-        else:
-            device = self._client_cache[cache_key]
-            await asyncio.wait_for(device.update(), timeout=_DEVICE_TIMEOUT)
+            await asyncio.wait_for(connected.update(), timeout=_DEVICE_TIMEOUT)
+            return connected
 
-        return device
+        return await self._sessions.get_or_create(cache_key, connect)
 
     def _evict(self, device_id: str, ip: str) -> None:
         """Remove a cached client so the next call reconnects."""
-        cache_key = f"{device_id}:{ip}"
-        self._client_cache.pop(cache_key, None)
+        self._sessions.evict(f"{device_id}:{ip}")
 
     def _extract_power(self, device: TapoDevice) -> PowerReading:
         """Extract power reading from a connected plugp100 device.
@@ -380,15 +385,12 @@ class TapoService:
         Args:
             device_id: Logical device identifier.
         """
-        keys_to_remove = [k for k in self._client_cache if k.startswith(f"{device_id}:")]
-        for key in keys_to_remove:
-            del self._client_cache[key]
-        if keys_to_remove:
-            logger.debug("Disconnected Tapo device %s (cleared %d cached clients)", device_id, len(keys_to_remove))
+        removed = self._sessions.evict_prefix(f"{device_id}:")
+        if removed:
+            logger.debug("Disconnected Tapo device %s (cleared %d cached clients)", device_id, removed)
 
     def clear_cache(self) -> None:
         """Clear all cached clients (used during shutdown)."""
-        count = len(self._client_cache)
-        self._client_cache.clear()
+        count = self._sessions.clear()
         if count:
             logger.debug("Cleared %d cached Tapo clients", count)
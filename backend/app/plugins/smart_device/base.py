@@ -8,6 +8,7 @@ from pydantic import BaseModel, Field
 
 from app.plugins.base import PluginBase
 from app.plugins.smart_device.capabilities import DeviceCapability
+from app.plugins.smart_device.connections import DeviceSessionCache, get_device_connections
 
 
 class DeviceTypeInfo(BaseModel):
@@ -66,6 +67,22 @@ class SmartDevicePlugin(PluginBase):
         """Override to set custom polling interval. Default 5s."""
         return 5.0
 
+    def get_max_concurrent_polls(self) -> int:
+        """Devices of this plugin the poller polls at once. Default 8."""
+        return 8
+
+    async def http_session(self) -> Any:
+        """Shared keep-alive ``aiohttp.ClientSession`` (see ``connections``).
+
+        Do not close it; it is shared with every other plugin.
+        """
+        return await get_device_connections().http_session()
+
+    @property
+    def sessions(self) -> DeviceSessionCache:
+        """This plugin's cache of authenticated device clients."""
+        return get_device_connections().sessions(self.metadata.name)
+
     async def poll_device_mock(self, device_id: str) -> Dict[str, Any]:
         """Return mock data for dev mode. Override for Windows compatibility."""
         return {}
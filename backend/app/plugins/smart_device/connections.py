@@ -0,0 +1,145 @@
+"""Shared HTTP connection pool and device session cache for smart-device plugins.
+
+Plugins used to keep their own clients per device: every Tapo plug opened
+its own aiohttp session (one TCP connection pool each), and a client that
+was being re-authenticated by one poll could be authenticated a second time
+by a concurrent command. Plugins now reach both through their base class:
+
+- ``SmartDevicePlugin.http_session()`` — one keep-alive ``aiohttp`` session
+  per process (the library plugp100 and most LAN device APIs speak aiohttp),
+  bounded to ``POOL_LIMIT`` connections, ``POOL_LIMIT_PER_HOST`` per device;
+- ``SmartDevicePlugin.sessions`` — a ``DeviceSessionCache`` per plugin for
+  authenticated device clients: concurrent callers for one key wait for a
+  single ``factory()`` instead of each logging in.
+
+Both are per process (monitoring worker for polling, web worker for
+commands) and are closed by ``close_device_connections()``.
+"""
+from __future__ import annotations
+
+import asyncio
+import logging
+from typing import TYPE_CHECKING, Any, Awaitable, Callable, Dict, Optional, TypeVar
+
+if TYPE_CHECKING:
+    import aiohttp
+
+logger = logging.getLogger(__name__)
+
+T = TypeVar("T")
+
+POOL_LIMIT = 64
+POOL_LIMIT_PER_HOST = 4
+KEEPALIVE_TIMEOUT = 30.0
+
+
+class DeviceSessionCache:
+    """Authenticated device clients by key, created once per key."""
+
+    def __init__(self) -> None:
+        self._clients: Dict[str, Any] = {}
+        self._locks: Dict[str, asyncio.Lock] = {}
+
+    def __len__(self) -> int:
+        return len(self._clients)
+
+    def get(self, key: str) -> Optional[Any]:
+        return self._clients.get(key)
+
+    async def get_or_create(self, key: str, factory: Callable[[], Awaitable[T]]) -> T:
+        """Cached client for *key*, or the result of ``await factory()``.
+
+        A failing factory caches nothing; the next call tries again.
+        """
+        client = self._clients.get(key)
+        if client is not None:
+            return client
+        lock = self._locks.setdefault(key, asyncio.Lock())
+        async with lock:
+            # Another caller may have connected while we waited
+            client = self._clients.get(key)
+            if client is None:
+                client = await factory()
+                self._clients[key] = client
+            return client
+
+    def evict(self, key: str) -> None:
+        """Drop a client so the next call reconnects (after errors)."""
+        self._clients.pop(key, None)
+
+    def evict_prefix(self, prefix: str) -> int:
+        """Drop every client whose key starts with *prefix*. Returns the count."""
+        keys = [k for k in self._clients if k.startswith(prefix)]
+        for key in keys:
+            del self._clients[key]
+        return len(keys)
+
+    def clear(self) -> int:
+        count = len(self._clients)
+        self._clients.clear()
+        self._locks.clear()
+        return count
+
+
+class DeviceConnections:
+    """Process-wide pool (see module docstring)."""
+
+    def __init__(self) -> None:
+        self._session: Optional["aiohttp.ClientSession"] = None
+        self._session_loop: Optional[asyncio.AbstractEventLoop] = None
+        self._caches: Dict[str, DeviceSessionCache] = {}
+
+    async def http_session(self) -> "aiohttp.ClientSession":
+        """The shared keep-alive session of the running event loop.
+
+        Raises:
+            ImportError: If aiohttp is not installed.
+        """
+        import aiohttp
+
+        loop = asyncio.get_running_loop()
+        if self._session is None or self._session.closed or self._session_loop is not loop:
+            # A session is bound to the loop it was created on
+            connector = aiohttp.TCPConnector(
+                limit=POOL_LIMIT,
+                limit_per_host=POOL_LIMIT_PER_HOST,
+                keepalive_timeout=KEEPALIVE_TIMEOUT,
+            )
+            self._session = aiohttp.ClientSession(connector=connector)
+            self._session_loop = loop
+        return self._session
+
+    def sessions(self, plugin_name: str) -> DeviceSessionCache:
+        """*plugin_name*'s device session cache."""
+        cache = self._caches.get(plugin_name)
+        if cache is None:
+            cache = self._caches[plugin_name] = DeviceSessionCache()
+        return cache
+
+    async def close(self) -> None:
+        """Close the pool and forget all device sessions."""
+        for cache in self._caches.values():
+            cache.clear()
+        session, self._session = self._session, None
+        self._session_loop = None
+        if session is not None and not session.closed:
+            try:
+                await session.close()
+            except Exception as exc:
+                logger.debug("Closing smart-device HTTP session failed: %s", exc)
+
+
+_connections: Optional[DeviceConnections] = None
+
+
+def get_device_connections() -> DeviceConnections:
+    """This process's shared device connections."""
+    global _connections
+    if _connections is None:
+        _connections = DeviceConnections()
+    return _connections
+
+
+async def close_device_connections() -> None:
+    if _connections is not None:
+        await _connections.close()
@@ -19,6 +19,7 @@ from app.plugins.smart_device.schemas import (
     SmartDeviceUpdate,
 )
 from app.services.monitoring.shm import SMART_DEVICES_FILE, read_shm
+from app.services.monitoring.shm_ring import get_metric_rings
 from app.services.vpn.encryption import VPNEncryption
 
 logger = logging.getLogger(__name__)
@@ -451,12 +452,12 @@ class SmartDeviceManager:
     def get_power_summary(self, db: Session) -> Dict[str, Any]:
         """Aggregate current power readings across all online devices.
 
-        Returns a summary dict suitable for PowerSummaryResponse.
+        Returns a summary dict suitable for PowerSummaryResponse. Readings
+        come from the power metric rings; the devices JSON snapshot is only
+        parsed for devices without one.
         """
-        shm_data = read_shm(SMART_DEVICES_FILE, max_age_seconds=30.0)
-        devices_shm: Dict[str, Any] = {}
-        if shm_data:
-            devices_shm = shm_data.get("devices", {})
+        rings = get_metric_rings()
+        devices_shm: Optional[Dict[str, Any]] = None
 
         all_devices = self.list_devices(db)
         total_watts = 0.0
@@ -467,12 +468,19 @@ class SmartDeviceManager:
                 continue
 
             watts = 0.0
-            entry = devices_shm.get(str(device.id))
-            if entry:
-                state = entry.get("state", {})
-                pm = state.get("power_monitor")
-                if pm and isinstance(pm, dict):
-                    watts = float(pm.get("watts", 0.0))
+            latest = rings.latest("power", str(device.id), max_age=30.0)
+            if latest is not None:
+                watts = latest["watts"] or 0.0
+            else:
+                if devices_shm is None:
+                    shm_data = read_shm(SMART_DEVICES_FILE, max_age_seconds=30.0)
+                    devices_shm = shm_data.get("devices", {}) if shm_data else {}
+                entry = devices_shm.get(str(device.id))
+                if entry:
+                    state = entry.get("state", {})
+                    pm = state.get("power_monitor")
+                    if pm and isinstance(pm, dict):
+                        watts = float(pm.get("watts", 0.0))
 
             if watts > 0.0:
                 total_watts += watts
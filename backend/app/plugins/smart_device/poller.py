@@ -3,6 +3,11 @@
 Loads all enabled smart_device plugins, polls every active device on each
 plugin's interval, writes state to SHM and (periodically) to the DB.
 
+Each plugin gets a deadline-scheduled loop that polls its devices
+concurrently (``get_max_concurrent_polls()`` at a time). Device status and
+samples of all plugins are buffered and written by one flush task, in one
+transaction per flush.
+
 This module is intentionally self-contained so it can be imported in the
 monitoring worker without pulling in web-worker state.
 """
@@ -13,7 +18,9 @@ import importlib
 import importlib.util
 import json
 import logging
+import random
 import sys
+import threading
 import time
 from dataclasses import dataclass, field
 from datetime import datetime, timezone
@@ -24,6 +31,12 @@ logger = logging.getLogger(__name__)
 
 # How often to persist samples to DB (seconds); polls happen more frequently.
 _DB_PERSIST_INTERVAL = 60.0
+# How often buffered device status (online, last_seen, last_error) is flushed.
+_DB_FLUSH_INTERVAL = 5.0
+# Random offset of each poll round, as a fraction of the plugin's interval.
+_POLL_JITTER = 0.05
+# Timeout for a single device poll (seconds).
+_POLL_TIMEOUT = 10.0
 # How often to clean up old smart_device_samples (seconds).
 _SAMPLE_CLEANUP_INTERVAL = 86400.0  # daily
 
@@ -65,8 +78,16 @@ class SmartDevicePoller:
         # device_id (int) → last known state dict
         self._last_states: Dict[int, Dict[str, Any]] = {}
 
-        # Timestamps of last DB persist per plugin_name
-        self._last_db_persist: Dict[str, float] = {}
+        # Timestamp of the last sample persist (0 = never, first flush persists)
+        self._last_db_persist: float = 0.0
+
+        # device_id → (is_online, last_error, last_seen) awaiting the next flush;
+        # the flush runs in a worker thread, so swaps happen under the lock
+        self._pending_status: Dict[int, tuple] = {}
+        self._pending_lock = threading.Lock()
+
+        # plugin_name → stats of its last poll round
+        self._round_stats: Dict[str, Dict[str, Any]] = {}
 
         # Timestamp of last smart_device_samples cleanup (-inf = never, fires immediately)
         self._last_sample_cleanup: float = float("-inf")
@@ -77,7 +98,7 @@ class SmartDevicePoller:
         # Pending delta changes list (written to smart_devices_changes.json)
         self._pending_changes: List[Dict[str, Any]] = []
 
-        # Per-plugin poll tasks
+        # Per-plugin poll tasks and the DB flush task
         self._poll_tasks: List[asyncio.Task] = []
 
     # ------------------------------------------------------------------
@@ -107,6 +128,9 @@ class SmartDevicePoller:
                 name=f"smart_device_poll_{plugin.metadata.name}",
             )
             self._poll_tasks.append(task)
+        self._poll_tasks.append(
+            asyncio.create_task(self._flush_loop(), name="smart_device_db_flush")
+        )
 
         logger.info(
             "SmartDevicePoller started with %d plugin(s): %s",
@@ -124,6 +148,10 @@ class SmartDevicePoller:
             except asyncio.CancelledError:
                 pass
         self._poll_tasks.clear()
+        await asyncio.to_thread(self._flush_db, False)
+
+        from app.plugins.smart_device.connections import close_device_connections
+        await close_device_connections()
         logger.info("SmartDevicePoller stopped")
 
     def get_status(self) -> Dict[str, Any]:
@@ -133,6 +161,7 @@ class SmartDevicePoller:
             "plugin_count": len(self._plugins),
             "plugins": list(self._plugins.keys()),
             "device_count": len(self._snapshot),
+            "rounds": dict(self._round_stats),
         }
 
     # ------------------------------------------------------------------
@@ -291,42 +320,76 @@ class SmartDevicePoller:
     async def _poll_loop(self, plugin: Any) -> None:
         """Continuous poll loop for a single plugin.
 
+        Rounds are scheduled on a fixed grid of deadlines (``interval`` apart,
+        each shifted by a little jitter) instead of sleeping the remainder
+        of the previous round, so polling time does not accumulate as
+        drift. A round that overruns skips the deadlines it missed rather
+        than starting the next round immediately.
+
         Args:
             plugin: SmartDevicePlugin instance.
         """
         from app.core.config import settings
 
         plugin_name = plugin.metadata.name
-        interval = plugin.get_poll_interval_seconds()
+        interval = max(0.1, float(plugin.get_poll_interval_seconds()))
+        limit = asyncio.Semaphore(max(1, int(plugin.get_max_concurrent_polls())))
+        # Jitter so plugins with the same interval do not poll in lockstep
+        jitter = interval * _POLL_JITTER
+        deadline = time.monotonic()
 
-        while self._running:
-            loop_start = time.time()
+        async def poll(device: PollerDevice) -> None:
+            async with limit:
+                if self._running:
+                    await self._poll_one_device(plugin, device, settings.is_dev_mode)
 
+        while self._running:
+            round_start = time.monotonic()
             devices = self._get_active_devices(plugin_name)
-            for device in devices:
-                if not self._running:
-                    break
-                await self._poll_one_device(plugin, device, settings.is_dev_mode)
+            await asyncio.gather(*(poll(device) for device in devices))
 
             # Write SHM snapshot after each full plugin round
             self._write_shm_snapshot()
 
-            # Persist to DB if interval elapsed
-            last_persist = self._last_db_persist.get(plugin_name, 0.0)
-            if time.time() - last_persist >= _DB_PERSIST_INTERVAL:
-                await self._persist_samples_to_db(plugin_name)
-                self._last_db_persist[plugin_name] = time.time()
+            now = time.monotonic()
+            next_deadline = _next_deadline(deadline, interval, now)
+            skipped = round((next_deadline - deadline) / interval) - 1
+            if skipped:
+                logger.debug(
+                    "SmartDevicePoller: %s round took %.1fs (interval %.1fs), skipped %d",
+                    plugin_name, now - round_start, interval, skipped,
+                )
+            stats = self._round_stats.setdefault(plugin_name, {"skipped_rounds": 0})
+            stats["devices"] = len(devices)
+            stats["duration_seconds"] = round(now - round_start, 3)
+            stats["skipped_rounds"] += skipped
+            deadline = next_deadline
+
+            delay = deadline + random.uniform(-jitter, jitter) - time.monotonic()
+            if self._running and delay > 0:
+                try:
+                    await asyncio.sleep(delay)
+                except asyncio.CancelledError:
+                    break
 
-            # Periodically clean up old samples (runs once per interval, globally)
-            await self._maybe_cleanup_samples()
+    async def _flush_loop(self) -> None:
+        """Single DB writer for all plugins.
 
-            # Sleep for the remainder of the interval
-            elapsed = time.time() - loop_start
-            sleep_time = max(0.0, interval - elapsed)
+        Flushes buffered device status every ``_DB_FLUSH_INTERVAL``, adds the
+        samples of all devices every ``_DB_PERSIST_INTERVAL``, and runs the
+        daily sample cleanup.
+        """
+        while self._running:
             try:
-                await asyncio.sleep(sleep_time)
+                await asyncio.sleep(_DB_FLUSH_INTERVAL)
             except asyncio.CancelledError:
                 break
+            now = time.time()
+            persist = now - self._last_db_persist >= _DB_PERSIST_INTERVAL
+            await asyncio.to_thread(self._flush_db, persist)
+            if persist:
+                self._last_db_persist = now
+            await self._maybe_cleanup_samples()
 
     async def _poll_one_device(self, plugin: Any, device: PollerDevice, dev_mode: bool) -> None:
         """Poll a single device, handling timeouts and errors.
@@ -343,12 +406,12 @@ class SmartDevicePoller:
             if dev_mode:
                 new_state = await asyncio.wait_for(
                     plugin.poll_device_mock(device_id_str),
-                    timeout=10.0,
+                    timeout=_POLL_TIMEOUT,
                 )
             else:
                 new_state = await asyncio.wait_for(
                     plugin.poll_device(device_id_str),
-                    timeout=10.0,
+                    timeout=_POLL_TIMEOUT,
                 )
 
             # Validate poll data against capability contracts
@@ -420,7 +483,14 @@ class SmartDevicePoller:
 
         self._last_states[device_id] = new_state
 
-        # Update device online status in DB (best-effort)
+        # Power readings also go to the shared metric rings (web workers read
+        # the latest watts from there without parsing the devices snapshot)
+        power = new_state.get("power_monitor")
+        if isinstance(power, dict):
+            from app.services.monitoring.shm_ring import get_metric_rings
+            get_metric_rings().publish("power", power, label=str(device_id))
+
+        # Queue device online status for the next DB flush
         self._update_device_online(device, online=True, error=None)
 
         if changed:
@@ -451,47 +521,121 @@ class SmartDevicePoller:
     def _update_device_online(
         self, device: PollerDevice, online: bool, error: Optional[str]
     ) -> None:
-        """Update is_online / last_seen / last_error in the DB (best-effort)."""
+        """Queue is_online / last_seen / last_error for the next DB flush."""
+        seen = datetime.now(timezone.utc) if online else None
+        with self._pending_lock:
+            self._pending_status[device.id] = (online, error, seen)
+
+    def _take_pending_status(self) -> Dict[int, tuple]:
+        with self._pending_lock:
+            pending, self._pending_status = self._pending_status, {}
+        return pending
+
+    def _restore_pending_status(self, pending: Dict[int, tuple]) -> None:
+        """Put back status a failed flush did not write; newer updates win."""
+        with self._pending_lock:
+            self._pending_status = {**pending, **self._pending_status}
+
+    def _write_device_status(self, db, pending: Dict[int, tuple]) -> int:
+        """Write *pending* device status (one UPDATE per kind). Returns rows."""
+        if not pending:
+            return 0
+        from sqlalchemy import bindparam, update
+        from app.models.smart_device import SmartDevice
+
+        online_rows = [
+            {"b_id": device_id, "b_error": error, "b_seen": seen}
+            for device_id, (online, error, seen) in pending.items() if online
+        ]
+        offline_rows = [
+            {"b_id": device_id, "b_error": error}
+            for device_id, (online, error, _) in pending.items() if not online
+        ]
+        # Core executemany: a device deleted since its poll just matches no row
+        table = SmartDevice.__table__
+        where = table.c.id == bindparam("b_id")
+        if online_rows:
+            db.execute(
+                update(table).where(where).values(
+                    is_online=True, last_seen=bindparam("b_seen"), last_error=bindparam("b_error"),
+                ),
+                online_rows,
+            )
+        if offline_rows:
+            db.execute(
+                update(table).where(where).values(is_online=False, last_error=bindparam("b_error")),
+                offline_rows,
+            )
+        return len(pending)
+
+    def _write_samples(self, db, plugin_name: Optional[str] = None) -> int:
+        """Add the snapshot as SmartDeviceSample rows (one INSERT). Returns rows."""
+        from sqlalchemy import insert, select
+        from app.models.smart_device import SmartDevice, SmartDeviceSample
+
+        # list() copies atomically; poll loops keep updating the snapshot
+        entries = {
+            int(device_id_str): entry
+            for device_id_str, entry in list(self._snapshot.items())
+            if plugin_name is None or entry.get("plugin_name") == plugin_name
+        }
+        if not entries:
+            return 0
+        # A device deleted since its last poll would fail the whole (shared) INSERT
+        existing = set(db.execute(
+            select(SmartDevice.id).where(SmartDevice.id.in_(list(entries)))
+        ).scalars())
+        now = datetime.now(timezone.utc)
+        rows = [
+            {
+                "device_id": device_id,
+                "capability": capability,
+                "data_json": json.dumps(cap_state, default=str),
+                "timestamp": now,
+            }
+            for device_id, entry in entries.items() if device_id in existing
+            for capability, cap_state in list(entry.get("state", {}).items())
+        ]
+        if rows:
+            db.execute(insert(SmartDeviceSample), rows)
+        return len(rows)
+
+    def _flush_db(self, persist_samples: bool) -> None:
+        """Write queued status (and, if asked, samples) in one transaction.
+
+        Blocking; the loops call it via ``asyncio.to_thread``. Status that
+        could not be written is queued again for the next flush.
+        """
         if self._db_session_factory is None:
             return
+        if not self._pending_status and not persist_samples:
+            return
+        pending = self._take_pending_status()
         try:
-            from app.models.smart_device import SmartDevice
             db = self._db_session_factory()
             try:
-                row = db.query(SmartDevice).filter(SmartDevice.id == device.id).first()
-                if row:
-                    row.is_online = online
-                    if online:
-                        row.last_seen = datetime.now(timezone.utc)
-                    row.last_error = error
-                    db.commit()
+                self._write_device_status(db, pending)
+                if persist_samples:
+                    self._write_samples(db)
+                db.commit()
             finally:
                 db.close()
         except Exception as exc:
-            logger.debug("SmartDevicePoller: DB online-update failed: %s", exc)
+            self._restore_pending_status(pending)
+            logger.debug("SmartDevicePoller: DB flush failed: %s", exc)
+
+    async def _persist_samples_to_db(self, plugin_name: Optional[str] = None) -> None:
+        """Write current snapshot data as SmartDeviceSample rows (time-series).
 
-    async def _persist_samples_to_db(self, plugin_name: str) -> None:
-        """Write current snapshot data as SmartDeviceSample rows (time-series)."""
+        Args:
+            plugin_name: Only this plugin's devices; all plugins when None.
+        """
         if self._db_session_factory is None:
             return
         try:
-            from app.models.smart_device import SmartDeviceSample
-            now = datetime.now(timezone.utc)
             db = self._db_session_factory()
             try:
-                for device_id_str, entry in self._snapshot.items():
-                    # Only persist for this plugin
-                    if entry.get("plugin_name") != plugin_name:
-                        continue
-                    state = entry.get("state", {})
-                    for capability, cap_state in state.items():
-                        sample = SmartDeviceSample(
-                            device_id=int(device_id_str),
-                            capability=capability,
-                            data_json=json.dumps(cap_state, default=str),
-                            timestamp=now,
-                        )
-                        db.add(sample)
+                self._write_samples(db, plugin_name)
                 db.commit()
             finally:
                 db.close()
@@ -514,7 +658,7 @@ class SmartDevicePoller:
             return SMART_DEVICE_SAMPLE_RETENTION_DAYS
 
     def _should_cleanup_samples(self, now: float) -> bool:
-        """True when a sample cleanup is due (shared across all plugin loops)."""
+        """True when a sample cleanup is due (across all plugins)."""
         return now - self._last_sample_cleanup >= _SAMPLE_CLEANUP_INTERVAL
 
     async def _maybe_cleanup_samples(self) -> None:
@@ -524,8 +668,8 @@ class SmartDevicePoller:
         now = time.time()
         if not self._should_cleanup_samples(now):
             return
-        # Set before the synchronous cleanup. No await between the check and this
-        # set, and cleanup is sync, so concurrent plugin loops cannot double-fire.
+        # Set before the synchronous cleanup so a failing cleanup is not retried
+        # on every flush (it runs from the single flush loop).
         self._last_sample_cleanup = now
         try:
             from app.plugins.smart_device.retention import cleanup_smart_device_samples
@@ -580,3 +724,11 @@ class SmartDevicePoller:
         finally:
             if len(self._pending_changes) > 1000:
                 self._pending_changes.clear()
+
+
+def _next_deadline(previous: float, interval: float, now: float) -> float:
+    """First deadline after *now* on the grid ``previous + k * interval``."""
+    deadline = previous + interval
+    if deadline <= now:
+        deadline += ((now - deadline) // interval + 1) * interval
+    return deadline
@@ -68,3 +68,22 @@ class BackupRestoreResponse(BaseModel):
     message: str
     backup_id: int
     restored_at: datetime
+
+
+class BackupFileEntry(BaseModel):
+    """One entry of a chunked backup (``database/...``, ``files/...``, ``config/...``)."""
+    path: str
+    size: int
+    mtime: float
+
+
+class BackupFileListResponse(BaseModel):
+    """Schema for listing the entries of a backup."""
+    backup_id: int
+    entries: list[BackupFileEntry]
+
+
+class BackupFileRestoreRequest(BaseModel):
+    """Schema for restoring a single file from a backup."""
+    path: str = Field(description="Entry path, e.g. files/alice/report.pdf")
+    confirm: bool = Field(description="User must confirm overwriting the current file")
@@ -259,3 +259,154 @@ class BenchmarkPrepareResponse(BaseModel):
     disk_size_bytes: int
     warning_message: str
     profile: BenchmarkProfileEnum
+
+
+# ===== Workload (end-to-end) Benchmarks =====
+
+class WorkloadProfileConfig(BaseModel):
+    """Sizes of the workloads in an end-to-end benchmark profile.
+
+    Request counts stay below the default per-minute rate limits of the
+    endpoints they hit (file_list 200, file_download 500); throttled requests
+    are counted as errors, not retried.
+    """
+    name: str
+    display_name: str
+    description: str
+    estimated_duration_seconds: int
+    upload_size_mb: int
+    upload_concurrency: int = 4
+    download_ranges: int
+    range_size_kb: int = 1024
+    list_entries: int
+    list_iterations: int
+    vcl_versions: int
+    vcl_size_kb: int = 512
+    cache_reads: int
+    api_requests: int
+    api_concurrency: int
+    webdav_iterations: int
+
+
+WORKLOAD_PROFILES: Dict[str, WorkloadProfileConfig] = {
+    "quick": WorkloadProfileConfig(
+        name="quick",
+        display_name="Quick",
+        description="Short end-to-end run (~1 min): 256 MB upload, 2,000-entry folder",
+        estimated_duration_seconds=60,
+        upload_size_mb=256,
+        download_ranges=64,
+        list_entries=2000,
+        list_iterations=20,
+        vcl_versions=5,
+        cache_reads=32,
+        api_requests=160,
+        api_concurrency=8,
+        webdav_iterations=10,
+    ),
+    "standard": WorkloadProfileConfig(
+        name="standard",
+        display_name="Standard",
+        description="Full end-to-end run (~5 min): 2 GB upload, 20,000-entry folder",
+        estimated_duration_seconds=300,
+        upload_size_mb=2048,
+        download_ranges=128,
+        list_entries=20000,
+        list_iterations=30,
+        vcl_versions=10,
+        cache_reads=64,
+        api_requests=256,
+        api_concurrency=16,
+        webdav_iterations=20,
+    ),
+}
+
+
+class WorkloadStartRequest(BaseModel):
+    """Request to start an end-to-end workload benchmark."""
+    profile: str = "quick"
+    workloads: Optional[List[str]] = Field(
+        default=None, description="Subset of workloads to run (default: all)"
+    )
+    webdav_password: Optional[str] = Field(
+        default=None,
+        description="Password of the requesting admin for the WebDAV workload; used once, never stored",
+    )
+
+
+class WorkloadResultSchema(BaseModel):
+    """Measurements of a single workload."""
+    workload: str
+    status: str  # "ok", "skipped", "failed"
+    detail: Optional[str] = None
+    samples: int = 0
+    errors: int = 0
+    bytes_total: Optional[int] = None
+    elapsed_seconds: Optional[float] = None
+    throughput_mbps: Optional[float] = None
+    ops_per_second: Optional[float] = None
+    latency_p50_ms: Optional[float] = None
+    latency_p95_ms: Optional[float] = None
+    latency_p99_ms: Optional[float] = None
+    latency_max_ms: Optional[float] = None
+
+    class Config:
+        from_attributes = True
+
+
+class WorkloadBenchmarkResponse(BaseModel):
+    """Full workload benchmark run."""
+    id: int
+    profile: str
+    status: BenchmarkStatusEnum
+    progress_percent: float
+    current_workload: Optional[str] = None
+    error_message: Optional[str] = None
+    created_at: datetime
+    started_at: Optional[datetime] = None
+    completed_at: Optional[datetime] = None
+    duration_seconds: Optional[float] = None
+    app_version: Optional[str] = None
+    app_commit: Optional[str] = None
+    hardware_fingerprint: Optional[str] = None
+    environment: Dict[str, object] = {}
+    baseline_id: Optional[int] = None
+    regressions: Optional[int] = None
+    results: List[WorkloadResultSchema] = []
+
+
+class WorkloadBenchmarkListResponse(BaseModel):
+    """Paginated list of workload benchmark runs."""
+    items: List[WorkloadBenchmarkResponse]
+    total: int
+    page: int
+    page_size: int
+    total_pages: int
+
+
+class WorkloadProfileListResponse(BaseModel):
+    """Available workload profiles and workload names."""
+    profiles: List[WorkloadProfileConfig]
+    workloads: List[str]
+
+
+class WorkloadMetricDelta(BaseModel):
+    """One metric of one workload compared with the baseline run."""
+    workload: str
+    metric: str
+    baseline: float
+    current: float
+    change_percent: float  # positive = better
+    regression: bool
+
+
+class WorkloadComparisonResponse(BaseModel):
+    """Comparison of a run with its baseline."""
+    benchmark_id: int
+    baseline_id: Optional[int] = None
+    baseline_version: Optional[str] = None
+    current_version: Optional[str] = None
+    same_hardware: bool = True
+    threshold_percent: float
+    deltas: List[WorkloadMetricDelta] = []
+    regressions: int = 0
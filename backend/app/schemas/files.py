@@ -43,6 +43,23 @@ class FileItem(BaseModel):
 
 class FileListResponse(BaseModel):
     files: list[FileItem]
+    # Set only for paginated listings (``limit``/``cursor`` given)
+    next_cursor: str | None = None
+    total: int | None = None
+
+
+class FileSearchFacets(BaseModel):
+    extension: dict[str, int]
+    type: dict[str, int]
+    size: dict[str, int]
+    # Counted over the first FACET_SCAN_LIMIT matches only
+    truncated: bool = False
+
+
+class FileSearchResponse(BaseModel):
+    files: list[FileItem]
+    has_more: bool = False
+    facets: FileSearchFacets | None = None
 
 
 class UserRootUsageResponse(BaseModel):
@@ -110,6 +127,27 @@ class OwnershipTransferResponse(BaseModel):
     error: str | None = None
 
 
+class OwnershipTransferJobStatus(BaseModel):
+    """Progress of a bulk (batched, resumable) ownership transfer."""
+    id: int
+    status: str  # pending | running | completed | failed
+    source_path: str
+    target_path: str
+    old_owner_id: int
+    new_owner_id: int
+    total_items: int
+    processed_items: int
+    error_message: str | None = None
+    created_at: datetime
+    started_at: datetime | None = None
+    completed_at: datetime | None = None
+
+
+class BulkOwnershipTransferResponse(OwnershipTransferResponse):
+    """Response from starting a bulk transfer; ``job`` is None when it finished inline."""
+    job: OwnershipTransferJobStatus | None = None
+
+
 # ============================================================================
 # Residency Enforcement Schemas
 # ============================================================================
@@ -189,6 +189,8 @@ class TimeRangeEnum(str, Enum):
     ONE_HOUR = "1h"
     TWENTY_FOUR_HOURS = "24h"
     SEVEN_DAYS = "7d"
+    THIRTY_DAYS = "30d"
+    ONE_YEAR = "1y"
 
 
 # ===== Response Schemas =====
@@ -286,6 +288,25 @@ class DiskIoHistoryResponse(BaseModel):
     source: str
 
 
+class RollupBucketSchema(BaseModel):
+    """One aggregated bucket of a metric field."""
+    timestamp: datetime
+    min: float
+    max: float
+    avg: float
+    p95: float
+    count: int
+
+
+class RollupHistoryResponse(BaseModel):
+    """Rollup history of one metric field (and series, e.g. a disk)."""
+    metric: str
+    field: str
+    series: str
+    resolution_seconds: int
+    buckets: List[RollupBucketSchema]
+
+
 class ProcessHistoryResponse(BaseModel):
     """Process history response."""
     processes: Dict[str, List[ProcessSampleSchema]]
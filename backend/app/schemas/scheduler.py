@@ -220,7 +220,7 @@ SCHEDULER_REGISTRY: dict[str, dict[str, Any]] = {
     },
     "upload_cleanup": {
         "display_name": "Upload Cleanup",
-        "description": "Cleans up expired chunked uploads to free storage space",
+        "description": "Cleans up expired chunked uploads and prunes the sync change journal",
         "config_key": None,  # Fixed schedule
         "default_interval": 86400,  # Daily at 3 AM
         "can_run_manually": True,
@@ -152,3 +152,22 @@ class ServiceStartResponse(BaseModel):
 
     class Config:
         from_attributes = True
+
+
+class StartupStepTiming(BaseModel):
+    """Timing of one startup step in this worker."""
+    name: str = Field(..., description="Startup step identifier (e.g., 'plugins')")
+    phase: str = Field(..., description="'blocking' (before serving) or 'deferred' (in background)")
+    status: str = Field(..., description="pending, running, ok, failed or cancelled")
+    after: List[str] = Field(default_factory=list, description="Steps this one waited for")
+    started_ms: Optional[float] = Field(None, description="Start offset from the beginning of startup")
+    duration_ms: Optional[float] = Field(None, description="How long the step ran")
+    error: Optional[str] = Field(None, description="Error message if the step failed")
+
+
+class StartupReportResponse(BaseModel):
+    """Per-step startup timings of the worker that answered."""
+    pid: int = Field(..., description="Worker process ID")
+    ready_ms: Optional[float] = Field(None, description="Time until the worker accepted requests")
+    deferred_done_ms: Optional[float] = Field(None, description="Time until all deferred steps finished")
+    steps: List[StartupStepTiming] = Field(default_factory=list)
@@ -49,6 +49,54 @@ class SyncChangesResponse(BaseModel):
     change_token: str = Field(..., description="Change token for next sync")
 
 
+class JournalChangeItem(BaseModel):
+    """Single entry of the server change journal."""
+    cursor: int
+    action: str  # 'upsert', 'delete', 'move'
+    path: str
+    old_path: Optional[str] = None  # moves only
+    is_directory: bool = False
+    size: Optional[int] = None
+    checksum: Optional[str] = None
+    changed_at: Optional[str] = None
+
+
+class ChangesSinceResponse(BaseModel):
+    """Changes journaled after the client's cursor."""
+    changes: list[JournalChangeItem] = Field(..., description="Changes, oldest first")
+    cursor: str = Field(..., description="Cursor to send on the next call")
+    has_more: bool = Field(..., description="More changes are available right away")
+    reset_required: bool = Field(
+        ..., description="History since the cursor is gone; run a full /sync/changes round"
+    )
+
+
+class DeltaSignature(BaseModel):
+    """Block signature of a file (weak Adler-32 and strong BLAKE2b-128 per block)."""
+    block_size: int
+    file_size: int
+    blocks: list[tuple[int, str]]
+
+
+class DeltaSignatureResponse(DeltaSignature):
+    """Signature of the server copy of a file."""
+    path: str
+    checksum: Optional[str] = Field(default=None, description="SHA256 of the server copy, if known")
+
+
+class DeltaComputeRequest(BaseModel):
+    """Request a download delta against the client's copy."""
+    path: str = Field(..., description="File path")
+    signature: DeltaSignature = Field(..., description="Signature of the client's copy")
+
+
+class DeltaApplyResponse(BaseModel):
+    """Result of applying an upload delta."""
+    path: str
+    size: int
+    checksum: str
+
+
 class SyncStatusResponse(BaseModel):
     """Sync status for a device."""
     status: str
@@ -267,6 +267,14 @@ class CleanupResponse(BaseModel):
     affected_users: int
 
 
+class DictionaryTrainResponse(BaseModel):
+    """Result of training the zstd dictionary for small text blobs."""
+    success: bool
+    message: str
+    dictionary_id: Optional[int] = None
+    samples: int
+
+
 class AdminStatsResponse(BaseModel):
     """Detailed stats for admin."""
     total_versions: int
@@ -1,11 +1,15 @@
 """Service layer for API Key management."""
 import logging
 import secrets
+import threading
+import time
 from datetime import datetime, timedelta, timezone
-from typing import Optional
+from typing import NamedTuple, Optional
 
+from sqlalchemy import update
 from sqlalchemy.orm import Session
 
+from app.core.decision_cache import get_decision_cache
 from app.models.api_key import ApiKey
 from app.models.user import User
 
@@ -14,6 +18,59 @@ logger = logging.getLogger(__name__)
 # Max active keys per admin to prevent key sprawl
 MAX_ACTIVE_KEYS_PER_ADMIN = 25
 
+# Usage stats of a key are written at most this often per worker
+USAGE_FLUSH_INTERVAL = 60.0
+
+
+class ApiKeyGrant(NamedTuple):
+    """What request authentication needs from a valid key (cacheable)."""
+
+    id: int
+    target_user_id: int
+    expires_at: Optional[datetime]
+
+    def is_expired(self) -> bool:
+        return self.expires_at is not None and self.expires_at <= datetime.now(timezone.utc)
+
+
+class _UsageBuffer:
+    """Per-worker pending use counts, written as one UPDATE per key and interval."""
+
+    def __init__(self) -> None:
+        self._lock = threading.Lock()
+        self._pending: dict[int, list] = {}  # key id -> [uses, last ip, last used at]
+        self._flushed_at: dict[int, float] = {}
+
+    def record(self, key_id: int, ip: Optional[str]) -> Optional[list]:
+        """Count one use; returns the batch to write once the interval is over."""
+        now = time.monotonic()
+        with self._lock:
+            entry = self._pending.setdefault(key_id, [0, None, None])
+            entry[0] += 1
+            entry[1] = ip or entry[1]
+            entry[2] = datetime.now(timezone.utc)
+            if now - self._flushed_at.get(key_id, float("-inf")) < USAGE_FLUSH_INTERVAL:
+                return None
+            self._flushed_at[key_id] = now
+            return self._pending.pop(key_id)
+
+    def drain(self) -> dict[int, list]:
+        with self._lock:
+            pending, self._pending = self._pending, {}
+        return pending
+
+
+_usage = _UsageBuffer()
+
+
+def _write_usage(db: Session, key_id: int, uses: int, ip: Optional[str], used_at: datetime) -> None:
+    # Core statement on the table: a usage counter is no reason to invalidate
+    # the cached key (see decision_cache)
+    values = {"use_count": ApiKey.__table__.c.use_count + uses, "last_used_at": used_at}
+    if ip:
+        values["last_used_ip"] = ip
+    db.execute(update(ApiKey.__table__).where(ApiKey.__table__.c.id == key_id).values(**values))
+
 
 class ApiKeyService:
     """Business logic for API key CRUD operations."""
@@ -122,6 +179,51 @@ class ApiKeyService:
 
         return api_key
 
+    @staticmethod
+    def resolve_api_key(db: Session, raw_key: str) -> Optional[ApiKeyGrant]:
+        """``validate_api_key`` for request authentication, via the decision cache.
+
+        Revoking or editing a key invalidates the cached grant in every worker;
+        expiry is checked on every call.
+        """
+        def load() -> Optional[ApiKeyGrant]:
+            api_key = ApiKeyService.validate_api_key(db, raw_key)
+            if not api_key:
+                return None
+            expires_at = api_key.expires_at
+            if expires_at is not None and expires_at.tzinfo is None:
+                expires_at = expires_at.replace(tzinfo=timezone.utc)
+            return ApiKeyGrant(api_key.id, api_key.target_user_id, expires_at)
+
+        grant = get_decision_cache().get_or_load("api_key", ApiKey.hash_key(raw_key), load)
+        if grant is None or grant.is_expired():
+            return None
+        return grant
+
+    @staticmethod
+    def record_grant_usage(db: Session, grant: ApiKeyGrant, ip: Optional[str] = None) -> None:
+        """Count a use of *grant*'s key.
+
+        The first use in a worker, and then at most one use per
+        ``USAGE_FLUSH_INTERVAL``, writes the accumulated count; ``flush_usage``
+        writes the rest on shutdown.
+        """
+        batch = _usage.record(grant.id, ip)
+        if batch is None:
+            return
+        _write_usage(db, grant.id, *batch)
+        db.commit()
+
+    @staticmethod
+    def flush_usage(db: Session) -> int:
+        """Write all pending use counts of this worker. Returns keys written."""
+        pending = _usage.drain()
+        for key_id, batch in pending.items():
+            _write_usage(db, key_id, *batch)
+        if pending:
+            db.commit()
+        return len(pending)
+
     @staticmethod
     def record_usage(db: Session, api_key: ApiKey, ip: Optional[str] = None) -> None:
         """Record a usage event for an API key (call after validation)."""
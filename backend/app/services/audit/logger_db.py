@@ -11,6 +11,7 @@ from sqlalchemy.orm import Session
 
 from app.core.database import get_db
 from app.models.audit_log import AuditLog
+from app.services.audit.writer import BUFFERED_EVENT_TYPES, get_audit_writer
 
 logger = logging.getLogger(__name__)
 
@@ -65,13 +66,32 @@ class AuditLoggerDB:
             db: Optional database session (if not provided, creates new one)
             
         Returns:
-            Created AuditLog entry or None if failed
+            Created AuditLog entry, or None if failed or handed to the
+            batched writer (see ``audit/writer.py``)
         """
         if not self._enabled:
             return None
         
         # Serialize details to JSON if provided
         details_json = json.dumps(details) if details else None
+
+        # Routine events without a caller transaction go through the batched
+        # writer; security/admin events and explicit sessions stay synchronous
+        if db is None and event_type in BUFFERED_EVENT_TYPES:
+            row = {
+                "timestamp": datetime.now(timezone.utc),
+                "event_type": event_type,
+                "user": user,
+                "action": action,
+                "resource": resource,
+                "success": success,
+                "error_message": error_message,
+                "details": details_json,
+                "ip_address": ip_address,
+                "user_agent": user_agent,
+            }
+            if get_audit_writer().submit(row):
+                return None
         
         audit_entry = AuditLog(
             event_type=event_type,
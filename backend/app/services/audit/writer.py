@@ -0,0 +1,274 @@
+"""Buffered writer for high-volume audit events.
+
+``AuditLoggerDB.log_event`` used to commit one row per call, usually on a
+fresh session — during a large upload, WebDAV copy or sync run that is one
+database commit per file on the request path. Routine events (file access,
+sync, device and disk monitor noise) are now appended to a bounded
+in-memory queue instead, and a per-worker writer thread inserts them in
+batches: as soon as ``FLUSH_BATCH`` events are waiting, or ``FLUSH_INTERVAL``
+after the oldest one arrived.
+
+What stays synchronous (see ``AuditLoggerDB``):
+
+- every event type not in ``BUFFERED_EVENT_TYPES`` — security, user
+  management, configuration and other admin events are on disk before the
+  request returns;
+- calls that pass their own ``db`` session (the row belongs to the caller's
+  transaction);
+- everything while the writer is not running (tests, scripts, CLI tools).
+
+Backpressure: when the queue is full the caller writes its own event
+synchronously, so bursts slow down rather than lose rows. A failed batch
+goes back to the front of the queue and is retried on the next interval;
+only what no longer fits is dropped (and counted). ``stop()`` drains the
+queue and is awaited from the lifespan shutdown; a hard crash loses at most
+the last interval.
+"""
+from __future__ import annotations
+
+import logging
+import threading
+import time
+from collections import deque
+from datetime import datetime
+from typing import Any, Callable, Optional
+
+from sqlalchemy import insert
+from sqlalchemy.orm import Session
+
+from app.models.audit_log import AuditLog
+
+logger = logging.getLogger(__name__)
+
+# Routine, high-volume event types that may be written asynchronously
+BUFFERED_EVENT_TYPES = frozenset({
+    "FILE_ACCESS",
+    "FILE_MODIFY",
+    "FILE_OPERATION",
+    "SYNC",
+    "DISK_MONITOR",
+    "SMART_DEVICE",
+})
+
+QUEUE_SIZE = 10_000
+FLUSH_BATCH = 500
+FLUSH_INTERVAL = 0.25  # seconds
+STOP_TIMEOUT = 10.0
+
+
+class AuditWriter:
+    """Per-worker queue plus writer thread (see module docstring)."""
+
+    def __init__(
+        self,
+        session_factory: Optional[Callable[[], Session]] = None,
+        *,
+        max_queue: int = QUEUE_SIZE,
+        batch_size: int = FLUSH_BATCH,
+        interval: float = FLUSH_INTERVAL,
+    ) -> None:
+        self._session_factory = session_factory
+        self.max_queue = max_queue
+        self.batch_size = batch_size
+        self.interval = interval
+
+        self._queue: deque[dict[str, Any]] = deque()
+        self._cond = threading.Condition()
+        self._flush_lock = threading.Lock()  # one batch in flight at a time
+        self._thread: Optional[threading.Thread] = None
+        self._stopping = False
+
+        self._enqueued = 0
+        self._written = 0
+        self._batches = 0
+        self._overflow = 0
+        self._dropped = 0
+        self._failures = 0
+        self._high_water = 0
+        self._last_flush_ms: Optional[float] = None
+        self._last_error: Optional[str] = None
+        self._last_error_at: Optional[str] = None
+        self._started_at: Optional[float] = None
+
+    # ── Lifecycle ────────────────────────────────────────────────────
+
+    @property
+    def running(self) -> bool:
+        return self._thread is not None and self._thread.is_alive()
+
+    def start(self) -> None:
+        """Start the writer thread; ``submit`` buffers from now on."""
+        if self.running:
+            return
+        with self._cond:
+            self._stopping = False
+        self._started_at = time.time()
+        self._thread = threading.Thread(target=self._run, name="audit-writer", daemon=True)
+        self._thread.start()
+        logger.info(
+            "Audit writer started (batch=%d, interval=%.0f ms, queue=%d)",
+            self.batch_size, self.interval * 1000, self.max_queue,
+        )
+
+    def stop(self, timeout: float = STOP_TIMEOUT) -> int:
+        """Stop the thread and write everything still queued.
+
+        Blocking; call via ``asyncio.to_thread`` from async code. Returns the
+        number of events the final drain wrote.
+        """
+        thread, self._thread = self._thread, None
+        with self._cond:
+            self._stopping = True
+            self._cond.notify_all()
+        if thread is not None:
+            thread.join(timeout)
+        written = 0
+        while True:
+            n = self.flush()
+            if n <= 0:
+                break
+            written += n
+        if self._queue:
+            logger.error("Audit writer stopped with %d unwritten event(s)", len(self._queue))
+        return written
+
+    # ── Producer side ────────────────────────────────────────────────
+
+    def submit(self, row: dict[str, Any]) -> bool:
+        """Queue one ``audit_logs`` row.
+
+        Returns False when the event was not queued (writer stopped or queue
+        full); the caller then writes it synchronously.
+        """
+        if self._thread is None:
+            return False
+        with self._cond:
+            if self._stopping:
+                return False
+            if len(self._queue) >= self.max_queue:
+                self._overflow += 1
+                return False
+            self._queue.append(row)
+            self._enqueued += 1
+            depth = len(self._queue)
+            if depth > self._high_water:
+                self._high_water = depth
+            if depth == 1 or depth >= self.batch_size:
+                # First event starts the interval; a full batch goes now
+                self._cond.notify()
+        return True
+
+    # ── Writer side ──────────────────────────────────────────────────
+
+    def _run(self) -> None:
+        while True:
+            with self._cond:
+                while not self._queue and not self._stopping:
+                    self._cond.wait()
+                if self._stopping:
+                    return
+                if len(self._queue) < self.batch_size:
+                    self._cond.wait(self.interval)
+                if self._stopping:
+                    return
+            if self.flush() < 0:
+                # Database unavailable: back off for an interval
+                with self._cond:
+                    if not self._stopping:
+                        self._cond.wait(self.interval)
+
+    def flush(self) -> int:
+        """Write up to one batch. Returns rows written, or -1 if the insert failed."""
+        with self._flush_lock:
+            with self._cond:
+                if not self._queue:
+                    return 0
+                n = min(len(self._queue), self.batch_size)
+                batch = [self._queue.popleft() for _ in range(n)]
+
+            started = time.perf_counter()
+            try:
+                write_rows(batch, self._session_factory)
+            except Exception as exc:
+                self._requeue(batch)
+                self._failures += 1
+                self._last_error = str(exc)
+                self._last_error_at = datetime.now().astimezone().isoformat()
+                logger.warning("Audit writer: batch of %d failed, will retry: %s", n, exc)
+                return -1
+
+            self._last_flush_ms = round((time.perf_counter() - started) * 1000, 2)
+            self._written += n
+            self._batches += 1
+            return n
+
+    def _requeue(self, batch: list[dict[str, Any]]) -> None:
+        with self._cond:
+            room = self.max_queue - len(self._queue)
+            keep = batch[:max(room, 0)]
+            self._queue.extendleft(reversed(keep))
+            lost = len(batch) - len(keep)
+        if lost:
+            self._dropped += lost
+            logger.error("Audit writer: queue full after failed batch, %d event(s) dropped", lost)
+
+    # ── Metrics ──────────────────────────────────────────────────────
+
+    def get_status(self) -> dict[str, Any]:
+        """Counters for the service status dashboard."""
+        with self._cond:
+            depth = len(self._queue)
+        return {
+            "is_running": self.running,
+            "started_at": (
+                datetime.fromtimestamp(self._started_at).astimezone().isoformat()
+                if self._started_at and self.running else None
+            ),
+            "uptime_seconds": (
+                round(time.time() - self._started_at, 1)
+                if self._started_at and self.running else None
+            ),
+            "interval_seconds": self.interval,
+            "sample_count": self._written,
+            "error_count": self._failures,
+            "last_error": self._last_error,
+            "last_error_at": self._last_error_at,
+            "has_error": self._dropped > 0,
+            "queue_depth": depth,
+            "queue_high_water": self._high_water,
+            "queue_capacity": self.max_queue,
+            "enqueued_total": self._enqueued,
+            "written_total": self._written,
+            "batches_total": self._batches,
+            "overflow_sync_total": self._overflow,
+            "dropped_total": self._dropped,
+            "last_flush_ms": self._last_flush_ms,
+        }
+
+
+def write_rows(
+    rows: list[dict[str, Any]],
+    session_factory: Optional[Callable[[], Session]] = None,
+) -> None:
+    """Insert a batch of ``audit_logs`` rows in one transaction.
+
+    A Core executemany insert: SQLAlchemy sends it as multi-row ``VALUES``
+    pages on PostgreSQL and SQLite alike.
+    """
+    if session_factory is None:
+        from app.core.database import SessionLocal
+        session_factory = SessionLocal
+    with session_factory() as db:
+        db.execute(insert(AuditLog), rows)
+        db.commit()
+
+
+_writer: Optional[AuditWriter] = None
+
+
+def get_audit_writer() -> AuditWriter:
+    """Get this worker's audit writer (created stopped)."""
+    global _writer
+    if _writer is None:
+        _writer = AuditWriter()
+    return _writer
@@ -0,0 +1,395 @@
+"""Chunked backup archives: manifest, parallel builder, extraction.
+
+A chunked backup is a single manifest file (``backup_<ts>.manifest``, the
+``Backup.filepath``) next to the destination's chunk store
+(``chunkstore.py``). The manifest lists every entry — ``database/...``,
+``files/<relative path>``, ``config/...`` — with its size, mode, mtime and
+the sha256 of each of its chunks, plus the directories (so empty ones are
+restored too). It is JSON, compressed with zstd (gzip without the
+``zstandard`` package); readers detect the codec from the magic bytes.
+
+Every manifest is complete, incremental ones included. An incremental run
+takes the previous manifest as its parent and carries over the chunk list
+of every file whose size and mtime are unchanged, without opening it;
+everything else is read with ``ManifestBuilder.readers`` threads (sized to
+the RAID layout, ``chunkstore.reader_threads``) and compressed on a
+separate pool. New chunks dedupe against the whole store either way, so a
+"full" backup of unchanged data stores almost nothing.
+
+Restore reads only the chunks of the entries it needs, so extracting a
+single file costs that file's chunks — no archive scan.
+"""
+from __future__ import annotations
+
+import bisect
+import gzip
+import json
+import logging
+import os
+import stat
+import tarfile
+import threading
+import time
+from concurrent.futures import Future, ThreadPoolExecutor
+from dataclasses import dataclass, field
+from pathlib import Path, PurePosixPath
+from typing import Any, Iterable, Iterator, Optional
+
+from app.services.backup.chunkstore import (
+    CHUNK_MAX_SIZE,
+    CHUNK_MIN_SIZE,
+    ChunkStore,
+    chunk_digest,
+)
+from app.services.versioning.chunking import iter_chunks
+from app.services.versioning.codecs import (
+    build_codecs,
+    compression_threads,
+    write_atomic,
+    zstandard,
+)
+
+logger = logging.getLogger(__name__)
+
+MANIFEST_SUFFIX = ".manifest"
+MANIFEST_FORMAT = "baluhost.backup/v2"
+READ_SIZE = 4 * 1024 * 1024
+# Reads of a file that changes under the reader before it is stored as is
+READ_ATTEMPTS = 3
+_ZSTD_MAGIC = b"\x28\xb5\x2f\xfd"
+
+
+def is_chunked_archive(path: Path | str) -> bool:
+    return str(path).endswith(MANIFEST_SUFFIX)
+
+
+def open_store(backup_dir: Path, *, zstd_level: int = 3, threads: int = 0) -> ChunkStore:
+    """The chunk store of a backup destination directory."""
+    store_root = backup_dir / ".chunks"
+    codecs = build_codecs(store_root, gzip_level=6, zstd_level=zstd_level, threads=threads)
+    return ChunkStore(backup_dir, codecs, "zstd" if zstandard is not None else "gzip")
+
+
+# ── Manifest ─────────────────────────────────────────────────────────
+
+
+def write_manifest(path: Path, manifest: dict[str, Any]) -> int:
+    """Write *manifest* atomically; returns its stored size."""
+    payload = json.dumps(manifest, separators=(",", ":")).encode("utf-8")
+    if zstandard is not None:
+        data = zstandard.ZstdCompressor(level=9).compress(payload)
+    else:
+        data = gzip.compress(payload, mtime=0)
+    return write_atomic(path, data)
+
+
+def read_manifest(path: Path) -> dict[str, Any]:
+    data = Path(path).read_bytes()
+    if data[:4] == _ZSTD_MAGIC:
+        if zstandard is None:
+            raise RuntimeError("backup manifest is zstd-compressed but zstandard is not installed")
+        payload = zstandard.ZstdDecompressor().decompress(data)
+    else:
+        payload = gzip.decompress(data)
+    manifest = json.loads(payload)
+    if manifest.get("format") != MANIFEST_FORMAT:
+        raise ValueError(f"unsupported backup manifest format: {manifest.get('format')!r}")
+    return manifest
+
+
+def manifest_digests(manifest: dict[str, Any]) -> set[bytes]:
+    return {bytes.fromhex(d) for entry in manifest["entries"] for d in entry["chunks"]}
+
+
+# ── Building ─────────────────────────────────────────────────────────
+
+
+@dataclass
+class BuildStats:
+    files: int = 0
+    files_unchanged: int = 0
+    files_changed: int = 0  # still being written on every read attempt
+    bytes_read: int = 0
+    chunks_new: int = 0
+    chunks_deduped: int = 0
+    skipped: list[str] = field(default_factory=list)
+
+
+class ManifestBuilder:
+    """Collects entries into *store* (inside ``store.writing()``)."""
+
+    def __init__(
+        self,
+        store: ChunkStore,
+        *,
+        readers: int,
+        compressors: int,
+        parent: Optional[dict[str, Any]] = None,
+    ) -> None:
+        self.store = store
+        self.readers = max(1, readers)
+        self.compressors = compression_threads(compressors)
+        self.stats = BuildStats()
+        self._entries: list[dict[str, Any]] = []
+        self._dirs: list[str] = []
+        self._parent = {e["path"]: e for e in parent["entries"]} if parent else {}
+        self._stats_lock = threading.Lock()
+        # Bounds the chunks read but not yet written (memory)
+        self._inflight = threading.BoundedSemaphore(self.compressors * 2)
+        self._compress_pool: Optional[ThreadPoolExecutor] = None
+
+    def __enter__(self) -> "ManifestBuilder":
+        self._compress_pool = ThreadPoolExecutor(
+            max_workers=self.compressors, thread_name_prefix="backup-compress",
+        )
+        return self
+
+    def __exit__(self, *exc) -> None:
+        if self._compress_pool is not None:
+            self._compress_pool.shutdown(wait=True)
+            self._compress_pool = None
+
+    def add_file(self, source: Path, name: str) -> None:
+        """Add one file under the archive path *name*."""
+        self._entries.extend(self._read_all([(source, name)]))
+
+    def add_tree(self, root: Path, prefix: str, exclude: Iterable[Path] = ()) -> None:
+        """Add every regular file below *root* as ``<prefix>/<relative path>``.
+
+        Symlinks are not followed (a link out of the storage tree must not pull
+        foreign data into the backup); *exclude* prunes directories such as a
+        backup destination inside the storage tree.
+        """
+        excluded = {os.path.realpath(p) for p in exclude}
+        work: list[tuple[Path, str]] = []
+        for dirpath, dirnames, filenames in os.walk(root):
+            dirnames[:] = [
+                d for d in dirnames
+                if os.path.realpath(os.path.join(dirpath, d)) not in excluded
+                and not os.path.islink(os.path.join(dirpath, d))
+            ]
+            rel_dir = Path(dirpath).relative_to(root).as_posix()
+            self._dirs.append(prefix if rel_dir == "." else f"{prefix}/{rel_dir}")
+            for filename in filenames:
+                path = Path(dirpath) / filename
+                if path.is_symlink() or not path.is_file():
+                    continue
+                rel = path.relative_to(root).as_posix()
+                work.append((path, f"{prefix}/{rel}"))
+        self._entries.extend(self._read_all(work))
+
+    def finish(self, **meta: Any) -> dict[str, Any]:
+        entries = sorted(self._entries, key=lambda e: e["path"])
+        return {
+            "format": MANIFEST_FORMAT,
+            "created_at": time.time(),
+            **meta,
+            "dirs": sorted(set(self._dirs)),
+            "entries": entries,
+        }
+
+    # Parallel reading --------------------------------------------------
+
+    def _read_all(self, work: list[tuple[Path, str]]) -> list[dict[str, Any]]:
+        if not work:
+            return []
+        assert self._compress_pool is not None, "use ManifestBuilder as a context manager"
+        if self.readers == 1 or len(work) == 1:
+            results = [self._read_one(src, name) for src, name in work]
+        else:
+            with ThreadPoolExecutor(max_workers=self.readers, thread_name_prefix="backup-read") as pool:
+                results = list(pool.map(lambda item: self._read_one(*item), work))
+        entries = []
+        for entry, futures in filter(None, results):
+            for future in futures:
+                future.result()  # surface compression/write errors
+            entries.append(entry)
+        return entries
+
+    def _read_one(self, source: Path, name: str) -> Optional[tuple[dict[str, Any], list[Future]]]:
+        try:
+            st = source.stat()
+        except OSError as exc:
+            self._skip(name, exc)
+            return None
+        entry = {
+            "path": name,
+            "size": st.st_size,
+            "mtime_ns": st.st_mtime_ns,
+            "mode": stat.S_IMODE(st.st_mode),
+        }
+        previous = self._parent.get(name)
+        if (
+            previous is not None
+            and not previous.get("changed")
+            and previous["size"] == st.st_size
+            and previous["mtime_ns"] == st.st_mtime_ns
+            and all(self.store.has(bytes.fromhex(d)) for d in previous["chunks"])
+        ):
+            entry["chunks"] = previous["chunks"]
+            with self._stats_lock:
+                self.stats.files += 1
+                self.stats.files_unchanged += 1
+            return entry, []
+
+        # The entry describes the bytes actually read: a live file can change
+        # between the stat above and the last chunk. A file whose size or
+        # mtime moved while it was read is read again; if it never holds
+        # still, the last read is kept and the entry is marked "changed" so
+        # the next incremental reads it again instead of trusting its stat.
+        futures: list[Future] = []
+        new = deduped = bytes_read = 0
+        for attempt in range(1, READ_ATTEMPTS + 1):
+            digests: list[str] = []
+            size = 0
+            try:
+                with open(source, "rb") as f:
+                    before = os.fstat(f.fileno())
+                    for chunk in iter_chunks(
+                        f, min_size=CHUNK_MIN_SIZE, max_size=CHUNK_MAX_SIZE, read_size=READ_SIZE,
+                    ):
+                        size += len(chunk)
+                        digest = chunk_digest(chunk)
+                        digests.append(digest.hex())
+                        if not self.store.claim(digest):
+                            deduped += 1
+                            continue
+                        new += 1
+                        self._inflight.acquire()
+                        futures.append(self._compress_pool.submit(self._store_chunk, digest, chunk))
+                    after = os.fstat(f.fileno())
+            except OSError as exc:
+                # Vanished or unreadable mid-run: leave it out rather than fail the backup
+                self._skip(name, exc)
+                for future in futures:
+                    future.result()
+                return None
+            bytes_read += size
+            changed = (
+                size != after.st_size
+                or (before.st_size, before.st_mtime_ns) != (after.st_size, after.st_mtime_ns)
+            )
+            if not changed:
+                break
+            logger.info("Backup: %s changed while being read (attempt %d)", name, attempt)
+        entry["size"] = size
+        entry["mtime_ns"] = after.st_mtime_ns
+        entry["mode"] = stat.S_IMODE(after.st_mode)
+        entry["chunks"] = digests
+        if changed:
+            entry["changed"] = True
+        with self._stats_lock:
+            self.stats.files += 1
+            self.stats.files_changed += int(changed)
+            self.stats.bytes_read += bytes_read
+            self.stats.chunks_new += new
+            self.stats.chunks_deduped += deduped
+        return entry, futures
+
+    def _store_chunk(self, digest: bytes, chunk: bytes) -> None:
+        try:
+            codec, payload = self.store.encode(chunk)
+            self.store.append(digest, len(chunk), codec, payload)
+        except BaseException:
+            self.store.release(digest)
+            raise
+        finally:
+            self._inflight.release()
+
+    def _skip(self, name: str, exc: Exception) -> None:
+        logger.warning("Backup: skipping %s: %s", name, exc)
+        with self._stats_lock:
+            self.stats.skipped.append(name)
+
+
+# ── Extraction ───────────────────────────────────────────────────────
+
+
+def safe_target(root: Path, relative: str) -> Path:
+    """*root* / *relative*, refusing absolute or ``..`` paths (tampered manifests)."""
+    pure = PurePosixPath(relative)
+    if pure.is_absolute() or ".." in pure.parts or not pure.parts:
+        raise ValueError(f"unsafe path in backup manifest: {relative!r}")
+    return root.joinpath(*pure.parts)
+
+
+def find_entry(manifest: dict[str, Any], name: str) -> Optional[dict[str, Any]]:
+    """Manifest entry for *name* (entries are sorted by path)."""
+    entries = manifest["entries"]
+    i = bisect.bisect_left(entries, name, key=lambda e: e["path"])
+    if i < len(entries) and entries[i]["path"] == name:
+        return entries[i]
+    return None
+
+
+def iter_entry(store: ChunkStore, entry: dict[str, Any]) -> Iterator[bytes]:
+    """Plaintext of one entry, chunk by chunk."""
+    for digest in entry["chunks"]:
+        yield store.read(bytes.fromhex(digest))
+
+
+def extract_entry(store: ChunkStore, entry: dict[str, Any], target: Path) -> None:
+    target.parent.mkdir(parents=True, exist_ok=True)
+    tmp = target.with_name(target.name + ".restore-tmp")
+    with open(tmp, "wb") as f:
+        for data in iter_entry(store, entry):
+            f.write(data)
+    os.chmod(tmp, entry["mode"])
+    os.utime(tmp, ns=(entry["mtime_ns"], entry["mtime_ns"]))
+    os.replace(tmp, target)
+
+
+def extract_prefix(
+    store: ChunkStore,
+    manifest: dict[str, Any],
+    prefix: str,
+    destination: Path,
+    *,
+    workers: int = 2,
+) -> int:
+    """Restore every entry below *prefix* into *destination*. Returns file count."""
+    lead = prefix.rstrip("/") + "/"
+    for d in manifest.get("dirs", []):
+        if d.startswith(lead):
+            safe_target(destination, d[len(lead):]).mkdir(parents=True, exist_ok=True)
+    destination.mkdir(parents=True, exist_ok=True)
+    work = [
+        (e, safe_target(destination, e["path"][len(lead):]))
+        for e in manifest["entries"] if e["path"].startswith(lead)
+    ]
+    if workers <= 1 or len(work) <= 1:
+        for entry, target in work:
+            extract_entry(store, entry, target)
+    else:
+        with ThreadPoolExecutor(max_workers=workers, thread_name_prefix="backup-restore") as pool:
+            list(pool.map(lambda item: extract_entry(store, *item), work))
+    return len(work)
+
+
+def iter_tar(store: ChunkStore, manifest: dict[str, Any]) -> Iterator[bytes]:
+    """Stream the backup as an uncompressed tar (``backup/<path>`` members).
+
+    Used for downloads: the chunks are already compressed, and producing the
+    tar needs no staging space.
+    """
+    for d in manifest.get("dirs", []):
+        info = tarfile.TarInfo(f"backup/{d}")
+        info.type = tarfile.DIRTYPE
+        info.mode = 0o755
+        yield info.tobuf(format=tarfile.PAX_FORMAT)
+    for entry in manifest["entries"]:
+        info = tarfile.TarInfo(f"backup/{entry['path']}")
+        info.size = entry["size"]
+        info.mode = entry["mode"]
+        info.mtime = entry["mtime_ns"] // 1_000_000_000
+        yield info.tobuf(format=tarfile.PAX_FORMAT)
+        written = 0
+        for data in iter_entry(store, entry):
+            written += len(data)
+            yield data
+        if written != entry["size"]:
+            raise ValueError(f"backup entry {entry['path']} is truncated")
+        remainder = written % tarfile.BLOCKSIZE
+        if remainder:
+            yield tarfile.NUL * (tarfile.BLOCKSIZE - remainder)
+    yield tarfile.NUL * (tarfile.BLOCKSIZE * 2)
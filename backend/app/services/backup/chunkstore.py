@@ -0,0 +1,329 @@
+"""Content-addressed chunk packs for backups.
+
+Every backup destination directory holds one store in ``.chunks/``:
+
+- ``packs/pack-<id>.pack`` — compressed chunks appended back to back, up to
+  ``PACK_TARGET_SIZE`` per pack;
+- ``packs/pack-<id>.idx`` — written when the pack is sealed: one fixed-size
+  entry per chunk (sha256, offset, stored and raw length, codec). A pack
+  without an index is the remains of an interrupted run and is removed by
+  the next writer.
+
+Chunks are keyed by the sha256 of their plaintext, so a chunk that any
+earlier backup in the same directory already stored is never written
+again. Backups only reference chunks (see ``archive.py``): deleting one
+drops its manifest, and ``gc()`` then removes the packs no remaining
+manifest references. Packs that are only partly live are kept as they are
+(no compaction).
+
+One writer per store at a time: ``writing()`` holds an ``flock`` on
+``.chunks/lock``. Readers need no lock — sealed packs are never modified.
+"""
+from __future__ import annotations
+
+import hashlib
+import logging
+import os
+import struct
+import threading
+import uuid
+from contextlib import contextmanager
+from pathlib import Path
+from typing import Callable, Iterator, NamedTuple, Optional
+
+from app.services.versioning.codecs import BlobCodec, is_incompressible
+
+try:  # pragma: no cover - platform dependent
+    import fcntl
+except ImportError:  # Windows dev mode: a single backend process
+    fcntl = None  # type: ignore[assignment]
+
+logger = logging.getLogger(__name__)
+
+STORE_DIRNAME = ".chunks"
+PACK_TARGET_SIZE = 256 * 1024 * 1024
+
+# Chunk size bounds for backup data: much coarser than VCL's so that the
+# in-memory index stays around 100 bytes per MiB of unique data
+CHUNK_MIN_SIZE = 1024 * 1024
+CHUNK_MAX_SIZE = 8 * 1024 * 1024
+
+_ENTRY = struct.Struct("<32sQIIB")  # digest, offset, stored size, raw size, codec
+_CODEC_IDS = {"raw": 0, "gzip": 1, "zstd": 2}
+_CODEC_NAMES = {v: k for k, v in _CODEC_IDS.items()}
+
+
+class ChunkLocation(NamedTuple):
+    pack: str
+    offset: int
+    stored_size: int
+    size: int
+    codec: str
+
+
+class ChunkStore:
+    """One destination's chunk packs plus the in-memory digest index."""
+
+    def __init__(self, backup_dir: Path, codecs: dict[str, BlobCodec], default_codec: str):
+        self.root = backup_dir / STORE_DIRNAME
+        self.packs_dir = self.root / "packs"
+        self.codecs = codecs
+        self.default_codec = default_codec if default_codec in codecs else "gzip"
+
+        self._index: Optional[dict[bytes, ChunkLocation]] = None
+        self._lock = threading.Lock()
+        self._pending: set[bytes] = set()
+
+        # Open pack (writers only)
+        self._pack_name: Optional[str] = None
+        self._pack_file = None
+        self._pack_entries: list[bytes] = []
+        self._pack_offset = 0
+
+        self._read_fds: dict[str, int] = {}
+        self.bytes_written = 0
+        self.chunks_written = 0
+
+    # ── Index ────────────────────────────────────────────────────────
+
+    @property
+    def index(self) -> dict[bytes, ChunkLocation]:
+        if self._index is None:
+            self._index = self._load_index()
+        return self._index
+
+    def _load_index(self) -> dict[bytes, ChunkLocation]:
+        index: dict[bytes, ChunkLocation] = {}
+        if not self.packs_dir.is_dir():
+            return index
+        for idx_path in sorted(self.packs_dir.glob("*.idx")):
+            pack = idx_path.stem
+            data = idx_path.read_bytes()
+            for off in range(0, len(data) - _ENTRY.size + 1, _ENTRY.size):
+                digest, offset, stored, size, codec = _ENTRY.unpack_from(data, off)
+                index[digest] = ChunkLocation(pack, offset, stored, size, _CODEC_NAMES[codec])
+        return index
+
+    def has(self, digest: bytes) -> bool:
+        return digest in self.index
+
+    # ── Writing ──────────────────────────────────────────────────────
+
+    @contextmanager
+    def writing(self) -> Iterator["ChunkStore"]:
+        """Exclusive write session: removes leftovers, seals the open pack on exit."""
+        self.packs_dir.mkdir(parents=True, exist_ok=True)
+        lock_fd = os.open(self.root / "lock", os.O_RDWR | os.O_CREAT, 0o600)
+        try:
+            if fcntl is not None:
+                fcntl.flock(lock_fd, fcntl.LOCK_EX)
+            self._remove_unsealed()
+            self._index = None  # another writer may have sealed packs meanwhile
+            try:
+                yield self
+                self.seal()
+            except BaseException:
+                self._abandon()
+                raise
+        finally:
+            if fcntl is not None:
+                fcntl.flock(lock_fd, fcntl.LOCK_UN)
+            os.close(lock_fd)
+
+    def claim(self, digest: bytes) -> bool:
+        """Reserve *digest* for writing. False if it is stored or being stored."""
+        with self._lock:
+            if digest in self.index or digest in self._pending:
+                return False
+            self._pending.add(digest)
+            return True
+
+    def encode(self, data: bytes) -> tuple[str, bytes]:
+        """Pick the codec for one chunk and compress it (call off the store lock)."""
+        name = "raw" if is_incompressible(data) else self.default_codec
+        return name, self.codecs[name].compress(data)
+
+    def append(self, digest: bytes, size: int, codec: str, payload: bytes) -> None:
+        """Write one claimed, encoded chunk to the open pack."""
+        with self._lock:
+            if self._pack_file is None:
+                self._open_pack()
+            offset = self._pack_offset
+            self._pack_file.write(payload)
+            self._pack_offset += len(payload)
+            self._pack_entries.append(
+                _ENTRY.pack(digest, offset, len(payload), size, _CODEC_IDS[codec])
+            )
+            self.index[digest] = ChunkLocation(self._pack_name, offset, len(payload), size, codec)
+            self._pending.discard(digest)
+            self.bytes_written += len(payload)
+            self.chunks_written += 1
+            if self._pack_offset >= PACK_TARGET_SIZE:
+                self._seal_locked()
+
+    def release(self, digest: bytes) -> None:
+        """Give up a claim (the chunk could not be encoded)."""
+        with self._lock:
+            self._pending.discard(digest)
+
+    def _open_pack(self) -> None:
+        self._pack_name = f"pack-{uuid.uuid4().hex}"
+        self._pack_file = open(self.packs_dir / f"{self._pack_name}.pack", "wb")
+        self._pack_entries = []
+        self._pack_offset = 0
+
+    def _seal_locked(self) -> None:
+        if self._pack_file is None:
+            return
+        self._pack_file.flush()
+        os.fsync(self._pack_file.fileno())
+        self._pack_file.close()
+        idx_path = self.packs_dir / f"{self._pack_name}.idx"
+        tmp_path = idx_path.with_name(idx_path.name + ".tmp")
+        with open(tmp_path, "wb") as f:
+            f.write(b"".join(self._pack_entries))
+            f.flush()
+            os.fsync(f.fileno())
+        os.replace(tmp_path, idx_path)
+        self._pack_file = None
+        self._pack_name = None
+        self._pack_entries = []
+
+    def seal(self) -> None:
+        """Seal the open pack (also done when ``writing()`` exits)."""
+        with self._lock:
+            self._seal_locked()
+
+    def _abandon(self) -> None:
+        """Drop the open pack of a failed run (its chunks were never indexed on disk)."""
+        with self._lock:
+            if self._pack_file is not None:
+                self._pack_file.close()
+                (self.packs_dir / f"{self._pack_name}.pack").unlink(missing_ok=True)
+                self._pack_file = None
+                self._pack_name = None
+            self._index = None
+            self._pending.clear()
+
+    def _remove_unsealed(self) -> None:
+        for pack in self.packs_dir.glob("*.pack"):
+            if not pack.with_suffix(".idx").exists():
+                logger.info("Backup store: removing unsealed pack %s", pack.name)
+                pack.unlink(missing_ok=True)
+        for tmp in self.packs_dir.glob("*.idx.tmp"):
+            tmp.unlink(missing_ok=True)
+
+    # ── Reading ──────────────────────────────────────────────────────
+
+    def read(self, digest: bytes) -> bytes:
+        """Plaintext of one chunk."""
+        loc = self.index.get(digest)
+        if loc is None:
+            raise KeyError(f"chunk {digest.hex()} is missing from {self.root}")
+        fd = self._read_fds.get(loc.pack)
+        if fd is None:
+            with self._lock:
+                fd = self._read_fds.get(loc.pack)
+                if fd is None:
+                    fd = os.open(self.packs_dir / f"{loc.pack}.pack", os.O_RDONLY | getattr(os, "O_BINARY", 0))
+                    self._read_fds[loc.pack] = fd
+        if hasattr(os, "pread"):
+            payload = os.pread(fd, loc.stored_size, loc.offset)
+        else:  # pragma: no cover - Windows dev mode
+            with self._lock:
+                os.lseek(fd, loc.offset, os.SEEK_SET)
+                payload = os.read(fd, loc.stored_size)
+        data = self.codecs[loc.codec].decompress(payload)
+        if len(data) != loc.size:
+            raise ValueError(f"chunk {digest.hex()} is corrupt (size mismatch)")
+        return data
+
+    def close(self) -> None:
+        with self._lock:
+            for fd in self._read_fds.values():
+                os.close(fd)
+            self._read_fds.clear()
+
+    # ── Garbage collection ───────────────────────────────────────────
+
+    def gc(self, live_digests: Callable[[], set[bytes]]) -> int:
+        """Delete packs none of whose chunks are live. Returns bytes freed.
+
+        *live_digests* is called with the store lock held, so the manifests
+        it reads can't gain a reference between the scan and the deletes.
+        Skipped (returns 0) while a backup is writing to this store.
+        """
+        if not self.packs_dir.is_dir():
+            return 0
+        lock_fd = os.open(self.root / "lock", os.O_RDWR | os.O_CREAT, 0o600)
+        try:
+            if fcntl is not None:
+                try:
+                    fcntl.flock(lock_fd, fcntl.LOCK_EX | fcntl.LOCK_NB)
+                except BlockingIOError:
+                    return 0
+            live = live_digests()
+            self.close()
+            self._index = None
+            by_pack: dict[str, bool] = {}
+            for digest, loc in self.index.items():
+                by_pack[loc.pack] = by_pack.get(loc.pack, False) or digest in live
+            freed = 0
+            for pack, is_live in by_pack.items():
+                if is_live:
+                    continue
+                pack_path = self.packs_dir / f"{pack}.pack"
+                freed += pack_path.stat().st_size if pack_path.exists() else 0
+                # Index first: a pack without one is treated as garbage anyway
+                (self.packs_dir / f"{pack}.idx").unlink(missing_ok=True)
+                pack_path.unlink(missing_ok=True)
+            self._index = None
+            return freed
+        finally:
+            if fcntl is not None:
+                fcntl.flock(lock_fd, fcntl.LOCK_UN)
+            os.close(lock_fd)
+
+
+def chunk_digest(data: bytes) -> bytes:
+    return hashlib.sha256(data).digest()
+
+
+# ── Reader sizing ────────────────────────────────────────────────────
+
+
+def _sysfs_block_dir(path: Path) -> Optional[Path]:
+    try:
+        dev = path.stat().st_dev
+    except OSError:
+        return None
+    sys_dir = Path(f"/sys/dev/block/{os.major(dev)}:{os.minor(dev)}")
+    if not sys_dir.exists():
+        return None
+    sys_dir = sys_dir.resolve()
+    if (sys_dir / "partition").exists():
+        sys_dir = sys_dir.parent  # queue/ lives on the whole disk
+    return sys_dir
+
+
+def reader_threads(path: Path, configured: int = 0) -> int:
+    """Parallel file readers for a backup of *path*.
+
+    0 = auto: one reader per member disk of an md array (each spindle serves
+    reads independently), 4 on a non-rotational device, 2 otherwise.
+    """
+    if configured > 0:
+        return configured
+    sys_dir = _sysfs_block_dir(path)
+    if sys_dir is not None:
+        try:
+            disks = int((sys_dir / "md" / "raid_disks").read_text().strip())
+            return max(1, min(disks, 8))
+        except (OSError, ValueError):
+            pass
+        try:
+            if (sys_dir / "queue" / "rotational").read_text().strip() == "0":
+                return 4
+        except OSError:
+            pass
+    return 2
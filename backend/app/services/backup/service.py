@@ -10,7 +10,7 @@ import tarfile
 import tempfile
 from datetime import datetime, timedelta
 from pathlib import Path
-from typing import Optional
+from typing import Iterator, Optional
 from urllib.parse import urlparse
 
 from sqlalchemy.orm import Session
@@ -20,6 +20,9 @@ from app.core.database import engine, DATABASE_URL
 from app.models.backup import Backup
 from app.schemas.backup import BackupCreate, BackupInDB
 from app.services.audit.logger_db import AuditLoggerDB
+from app.services.backup import archive
+from app.services.backup.archive import MANIFEST_SUFFIX
+from app.services.backup.chunkstore import reader_threads
 import logging
 
 logger = logging.getLogger(__name__)
@@ -92,7 +95,9 @@ class BackupService:
             BackupInDB: Created backup metadata
         """
         timestamp = datetime.now().strftime("%Y%m%d_%H%M%S")
-        filename = f"backup_{timestamp}.tar.gz"
+        archive_format = "tar" if settings.backup_format == "tar" else "chunked"
+        suffix = MANIFEST_SUFFIX if archive_format == "chunked" else ".tar.gz"
+        filename = f"backup_{timestamp}{suffix}"
         # Use optional path from request or the service's backup_dir. A custom
         # destination is validated against the allowed storage roots so an admin
         # cannot make the backend write archives to arbitrary filesystem paths.
@@ -128,164 +133,18 @@ class BackupService:
             db=self.db
         )
         try:
-            # Create temporary directory for staging
-            with tempfile.TemporaryDirectory(dir=str(backup_dir)) as temp_dir:
-                temp_path = Path(temp_dir)
-                logger.log_event(
-                    event_type="BACKUP",
-                    action="stage_temp_dir",
-                    user=creator_username,
-                    resource=filename,
-                    success=True,
-                    details={"step": "temp_dir_created", "temp_path": str(temp_path)},
-                    db=self.db
-                )
-
-                # Copy database
-                if backup_data.includes_database:
-                    db_type, db_path = self._get_database_info()
-                    db_backup_dir = temp_path / "database"
-                    db_backup_dir.mkdir(parents=True, exist_ok=True)
-
-                    if db_type == "sqlite":
-                        # SQLite: Copy database file
-                        if db_path and db_path.exists():
-                            shutil.copy2(db_path, db_backup_dir / "baluhost.db")
-                            logger.log_event(
-                                event_type="BACKUP",
-                                action="copy_database",
-                                user=creator_username,
-                                resource=filename,
-                                success=True,
-                                details={"step": "database_copied", "db_type": "sqlite", "db_path": str(db_path)},
-                                db=self.db
-                            )
-                            # Also backup WAL files if they exist (SQLite)
-                            for ext in ["-wal", "-shm"]:
-                                wal_path = Path(str(db_path) + ext)
-                                if wal_path.exists():
-                                    shutil.copy2(wal_path, db_backup_dir / f"baluhost.db{ext}")
-                                    logger.log_event(
-                                        event_type="BACKUP",
-                                        action="copy_wal",
-                                        user=creator_username,
-                                        resource=filename,
-                                        success=True,
-                                        details={"step": "wal_copied", "wal_path": str(wal_path)},
-                                        db=self.db
-                                    )
-
-                    elif db_type == "postgresql":
-                        # PostgreSQL: Use pg_dump
-                        self._backup_postgres_database(db_backup_dir)
-                        logger.log_event(
-                            event_type="BACKUP",
-                            action="pg_dump_database",
-                            user=creator_username,
-                            resource=filename,
-                            success=True,
-                            details={"step": "database_dumped", "db_type": "postgresql"},
-                            db=self.db
-                        )
-
-                # Copy files
-                if backup_data.includes_files:
-                    storage_path = Path(settings.nas_storage_path)
-                    if storage_path.exists():
-                        files_backup_dir = temp_path / "files"
-                        logger.log_event(
-                            event_type="BACKUP",
-                            action="stage_files",
-                            user=creator_username,
-                            resource=filename,
-                            success=True,
-                            details={"step": "files_stage", "storage_path": str(storage_path)},
-                            db=self.db
-                        )
-                        if backup_data.backup_type == "incremental":
-                            # Finde letztes completed Backup
-                            last_backup = self.db.query(Backup).filter(
-                                Backup.status == "completed",
-                                Backup.includes_files == True
-                            ).order_by(Backup.created_at.desc()).first()
-                            last_files = set()
-                            last_files_mtime = dict()
-                            if last_backup and Path(last_backup.filepath).exists():
-                                with tarfile.open(last_backup.filepath, "r:gz") as tar:
-                                    for member in tar.getmembers():
-                                        if member.name.startswith("backup/files/") and member.isfile():
-                                            rel_path = member.name[len("backup/files/"):] 
-                                            last_files.add(rel_path)
-                                            last_files_mtime[rel_path] = member.mtime
-                            # Vergleiche aktuelle Dateien mit letztem Backup
-                            files_to_backup = []
-                            for file in storage_path.rglob("*"):
-                                if file.is_file():
-                                    rel_path = str(file.relative_to(storage_path))
-                                    mtime = int(file.stat().st_mtime)
-                                    # Neu oder geändert?
-                                    if rel_path not in last_files or mtime > last_files_mtime.get(rel_path, 0):
-                                        files_to_backup.append((file, rel_path))
-                            files_backup_dir.mkdir(parents=True, exist_ok=True)
-                            for file, rel_path in files_to_backup:
-                                dest = files_backup_dir / rel_path
-                                dest.parent.mkdir(parents=True, exist_ok=True)
-                                shutil.copy2(file, dest)
-                                logger.log_event(
-                                    event_type="BACKUP",
-                                    action="copy_file",
-                                    user=creator_username,
-                                    resource=filename,
-                                    success=True,
-                                    details={"step": "file_copied", "file": str(file)},
-                                    db=self.db
-                                )
-                        else:
-                            shutil.copytree(storage_path, files_backup_dir, symlinks=False)
-                            logger.log_event(
-                                event_type="BACKUP",
-                                action="copy_files_full",
-                                user=creator_username,
-                                resource=filename,
-                                success=True,
-                                details={"step": "files_copied_full", "storage_path": str(storage_path)},
-                                db=self.db
-                            )
-
-                # Copy config (optional)
-                if backup_data.includes_config:
-                    config_dir = temp_path / "config"
-                    config_dir.mkdir(parents=True, exist_ok=True)
-                    snapshot_summary = self._write_config_snapshot(config_dir)
-                    logger.log_event(
-                        event_type="BACKUP",
-                        action="copy_config",
-                        user=creator_username,
-                        resource=filename,
-                        success=True,
-                        details={
-                            "step": "config_snapshot_written",
-                            "files": snapshot_summary["files"],
-                            "redacted_field_count": snapshot_summary["redacted_count"],
-                        },
-                        db=self.db
-                    )
-
-                # Create tar.gz archive
-                with tarfile.open(filepath, "w:gz") as tar:
-                    tar.add(temp_path, arcname="backup")
-                logger.log_event(
-                    event_type="BACKUP",
-                    action="archive_created",
-                    user=creator_username,
-                    resource=filename,
-                    success=True,
-                    details={"step": "archive_created", "filepath": str(filepath)},
-                    db=self.db
+            if archive_format == "chunked":
+                # Size of a chunked backup = its manifest plus the chunk data it
+                # added to the store (shared chunks count for the first backup)
+                size_bytes = self._build_chunked_archive(
+                    backup_data, backup_dir, filepath, filename, creator_username, logger
                 )
+            else:
+                self._build_tar_archive(backup_data, backup_dir, filepath, filename, creator_username, logger)
+                size_bytes = filepath.stat().st_size
             
             # Update backup record with size and completion
-            backup.size_bytes = filepath.stat().st_size
+            backup.size_bytes = size_bytes
             backup.status = "completed"
             backup.completed_at = datetime.now()
             self.db.commit()
@@ -337,6 +196,312 @@ class BackupService:
             raise
     
 
+    def _build_tar_archive(
+        self,
+        backup_data: BackupCreate,
+        backup_dir: Path,
+        filepath: Path,
+        filename: str,
+        creator_username: str,
+        logger: AuditLoggerDB,
+    ) -> None:
+        """Legacy format: stage everything in a temp dir, then one ``.tar.gz``."""
+        # Create temporary directory for staging
+        with tempfile.TemporaryDirectory(dir=str(backup_dir)) as temp_dir:
+            temp_path = Path(temp_dir)
+            logger.log_event(
+                event_type="BACKUP",
+                action="stage_temp_dir",
+                user=creator_username,
+                resource=filename,
+                success=True,
+                details={"step": "temp_dir_created", "temp_path": str(temp_path)},
+                db=self.db
+            )
+
+            # Copy database
+            if backup_data.includes_database:
+                db_type, db_path = self._get_database_info()
+                db_backup_dir = temp_path / "database"
+                db_backup_dir.mkdir(parents=True, exist_ok=True)
+
+                if db_type == "sqlite":
+                    # SQLite: Copy database file
+                    if db_path and db_path.exists():
+                        shutil.copy2(db_path, db_backup_dir / "baluhost.db")
+                        logger.log_event(
+                            event_type="BACKUP",
+                            action="copy_database",
+                            user=creator_username,
+                            resource=filename,
+                            success=True,
+                            details={"step": "database_copied", "db_type": "sqlite", "db_path": str(db_path)},
+                            db=self.db
+                        )
+                        # Also backup WAL files if they exist (SQLite)
+                        for ext in ["-wal", "-shm"]:
+                            wal_path = Path(str(db_path) + ext)
+                            if wal_path.exists():
+                                shutil.copy2(wal_path, db_backup_dir / f"baluhost.db{ext}")
+                                logger.log_event(
+                                    event_type="BACKUP",
+                                    action="copy_wal",
+                                    user=creator_username,
+                                    resource=filename,
+                                    success=True,
+                                    details={"step": "wal_copied", "wal_path": str(wal_path)},
+                                    db=self.db
+                                )
+
+                elif db_type == "postgresql":
+                    # PostgreSQL: Use pg_dump
+                    self._backup_postgres_database(db_backup_dir)
+                    logger.log_event(
+                        event_type="BACKUP",
+                        action="pg_dump_database",
+                        user=creator_username,
+                        resource=filename,
+                        success=True,
+                        details={"step": "database_dumped", "db_type": "postgresql"},
+                        db=self.db
+                    )
+
+            # Copy files
+            if backup_data.includes_files:
+                storage_path = Path(settings.nas_storage_path)
+                if storage_path.exists():
+                    files_backup_dir = temp_path / "files"
+                    logger.log_event(
+                        event_type="BACKUP",
+                        action="stage_files",
+                        user=creator_username,
+                        resource=filename,
+                        success=True,
+                        details={"step": "files_stage", "storage_path": str(storage_path)},
+                        db=self.db
+                    )
+                    if backup_data.backup_type == "incremental":
+                        # Finde letztes completed Backup
+                        last_backup = self.db.query(Backup).filter(
+                            Backup.status == "completed",
+                            Backup.includes_files == True
+                        ).order_by(Backup.created_at.desc()).first()
+                        last_files = set()
+                        last_files_mtime = dict()
+                        if last_backup and Path(last_backup.filepath).exists():
+                            with tarfile.open(last_backup.filepath, "r:gz") as tar:
+                                for member in tar.getmembers():
+                                    if member.name.startswith("backup/files/") and member.isfile():
+                                        rel_path = member.name[len("backup/files/"):] 
+                                        last_files.add(rel_path)
+                                        last_files_mtime[rel_path] = member.mtime
+                        # Vergleiche aktuelle Dateien mit letztem Backup
+                        files_to_backup = []
+                        for file in storage_path.rglob("*"):
+                            if file.is_file():
+                                rel_path = str(file.relative_to(storage_path))
+                                mtime = int(file.stat().st_mtime)
+                                # Neu oder geändert?
+                                if rel_path not in last_files or mtime > last_files_mtime.get(rel_path, 0):
+                                    files_to_backup.append((file, rel_path))
+                        files_backup_dir.mkdir(parents=True, exist_ok=True)
+                        for file, rel_path in files_to_backup:
+                            dest = files_backup_dir / rel_path
+                            dest.parent.mkdir(parents=True, exist_ok=True)
+                            shutil.copy2(file, dest)
+                            logger.log_event(
+                                event_type="BACKUP",
+                                action="copy_file",
+                                user=creator_username,
+                                resource=filename,
+                                success=True,
+                                details={"step": "file_copied", "file": str(file)},
+                                db=self.db
+                            )
+                    else:
+                        shutil.copytree(storage_path, files_backup_dir, symlinks=False)
+                        logger.log_event(
+                            event_type="BACKUP",
+                            action="copy_files_full",
+                            user=creator_username,
+                            resource=filename,
+                            success=True,
+                            details={"step": "files_copied_full", "storage_path": str(storage_path)},
+                            db=self.db
+                        )
+
+            # Copy config (optional)
+            if backup_data.includes_config:
+                config_dir = temp_path / "config"
+                config_dir.mkdir(parents=True, exist_ok=True)
+                snapshot_summary = self._write_config_snapshot(config_dir)
+                logger.log_event(
+                    event_type="BACKUP",
+                    action="copy_config",
+                    user=creator_username,
+                    resource=filename,
+                    success=True,
+                    details={
+                        "step": "config_snapshot_written",
+                        "files": snapshot_summary["files"],
+                        "redacted_field_count": snapshot_summary["redacted_count"],
+                    },
+                    db=self.db
+                )
+
+            # Create tar.gz archive
+            with tarfile.open(filepath, "w:gz") as tar:
+                tar.add(temp_path, arcname="backup")
+            logger.log_event(
+                event_type="BACKUP",
+                action="archive_created",
+                user=creator_username,
+                resource=filename,
+                success=True,
+                details={"step": "archive_created", "filepath": str(filepath)},
+                db=self.db
+            )
+
+    def _build_chunked_archive(
+        self,
+        backup_data: BackupCreate,
+        backup_dir: Path,
+        filepath: Path,
+        filename: str,
+        creator_username: str,
+        logger: AuditLoggerDB,
+    ) -> int:
+        """Chunked format (``archive.py``): returns manifest size + new chunk bytes."""
+        parent = None
+        parent_name = None
+        if backup_data.backup_type == "incremental":
+            parent_name, parent = self._previous_manifest(backup_dir)
+
+        storage_path = Path(settings.nas_storage_path)
+        store = archive.open_store(
+            backup_dir,
+            zstd_level=settings.backup_zstd_level,
+            threads=settings.backup_compression_threads,
+        )
+        readers = reader_threads(storage_path, settings.backup_reader_threads)
+        try:
+            with store.writing(), archive.ManifestBuilder(
+                store,
+                readers=readers,
+                compressors=settings.backup_compression_threads,
+                parent=parent,
+            ) as builder, tempfile.TemporaryDirectory(dir=str(backup_dir)) as temp_dir:
+                temp_path = Path(temp_dir)
+
+                if backup_data.includes_database:
+                    db_type, db_path = self._get_database_info()
+                    if db_type == "sqlite":
+                        if db_path and db_path.exists():
+                            builder.add_file(db_path, "database/baluhost.db")
+                            for ext in ["-wal", "-shm"]:
+                                wal_path = Path(str(db_path) + ext)
+                                if wal_path.exists():
+                                    builder.add_file(wal_path, f"database/baluhost.db{ext}")
+                    elif db_type == "postgresql":
+                        self._backup_postgres_database(temp_path)
+                        builder.add_file(
+                            temp_path / "postgres_backup.sql.gz", "database/postgres_backup.sql.gz"
+                        )
+                    logger.log_event(
+                        event_type="BACKUP",
+                        action="copy_database",
+                        user=creator_username,
+                        resource=filename,
+                        success=True,
+                        details={"step": "database_stored", "db_type": db_type},
+                        db=self.db
+                    )
+
+                if backup_data.includes_files and storage_path.exists():
+                    builder.add_tree(storage_path, "files", exclude=[backup_dir])
+                    logger.log_event(
+                        event_type="BACKUP",
+                        action="store_files",
+                        user=creator_username,
+                        resource=filename,
+                        success=True,
+                        details={
+                            "step": "files_stored",
+                            "storage_path": str(storage_path),
+                            "parent": parent_name,
+                            "readers": readers,
+                            "files": builder.stats.files,
+                            "files_unchanged": builder.stats.files_unchanged,
+                            "files_changed": builder.stats.files_changed,
+                            "bytes_read": builder.stats.bytes_read,
+                            "chunks_new": builder.stats.chunks_new,
+                            "chunks_deduped": builder.stats.chunks_deduped,
+                            "skipped": len(builder.stats.skipped),
+                        },
+                        db=self.db
+                    )
+
+                if backup_data.includes_config:
+                    config_dir = temp_path / "config"
+                    config_dir.mkdir(parents=True, exist_ok=True)
+                    snapshot_summary = self._write_config_snapshot(config_dir)
+                    builder.add_tree(config_dir, "config")
+                    logger.log_event(
+                        event_type="BACKUP",
+                        action="copy_config",
+                        user=creator_username,
+                        resource=filename,
+                        success=True,
+                        details={
+                            "step": "config_snapshot_written",
+                            "files": snapshot_summary["files"],
+                            "redacted_field_count": snapshot_summary["redacted_count"],
+                        },
+                        db=self.db
+                    )
+
+                manifest = builder.finish(backup_type=backup_data.backup_type, parent=parent_name)
+                # Still under the store lock: chunk GC must never see the new
+                # packs without the manifest that references them
+                store.seal()
+                manifest_size = archive.write_manifest(filepath, manifest)
+        finally:
+            store.close()
+
+        logger.log_event(
+            event_type="BACKUP",
+            action="archive_created",
+            user=creator_username,
+            resource=filename,
+            success=True,
+            details={
+                "step": "archive_created",
+                "filepath": str(filepath),
+                "format": "chunked",
+                "entries": len(manifest["entries"]),
+                "stored_bytes": store.bytes_written,
+            },
+            db=self.db
+        )
+        return manifest_size + store.bytes_written
+
+    def _previous_manifest(self, backup_dir: Path) -> tuple[Optional[str], Optional[dict]]:
+        """Newest completed chunked backup in *backup_dir* (the incremental parent)."""
+        candidates = (
+            self.db.query(Backup)
+            .filter(Backup.status == "completed", Backup.includes_files == True)  # noqa: E712
+            .order_by(Backup.created_at.desc(), Backup.id.desc())
+        )
+        for candidate in candidates:
+            path = Path(candidate.filepath)
+            if not archive.is_chunked_archive(path) or path.parent != backup_dir or not path.exists():
+                continue
+            try:
+                return candidate.filename, archive.read_manifest(path)
+            except Exception as exc:
+                logger.warning("Backup: ignoring unreadable manifest %s: %s", path, exc)
+        return None, None
+
     from cachetools import cached, TTLCache
 
     _backups_cache = TTLCache(maxsize=16, ttl=60)  # 60 Sekunden Cache
@@ -379,6 +544,9 @@ class BackupService:
         filename = backup.filename
         self.db.delete(backup)
         self.db.commit()
+
+        if archive.is_chunked_archive(filepath):
+            self._collect_chunk_garbage({filepath.parent})
         
         # Log audit event
         logger = AuditLoggerDB()
@@ -426,23 +594,36 @@ class BackupService:
             return False
         
         config_reference_path: Optional[str] = None
+        chunked = archive.is_chunked_archive(filepath)
+        store = None
         try:
             # Extract backup to temporary directory
             with tempfile.TemporaryDirectory(dir=str(self.backup_dir)) as temp_dir:
                 temp_path = Path(temp_dir)
-
-                # Extract tar.gz
-                with tarfile.open(filepath, "r:gz") as tar:
-                    # Security: prevent tar-slip. The ``data`` filter rejects
-                    # members with absolute paths, ".." traversal, or unsafe
-                    # links, so a tampered archive cannot write outside the
-                    # temp dir. BaluHost backups only contain regular data
-                    # files under "backup/", so this is behaviour-preserving
-                    # for legitimate archives. (tarfile filters: py3.12+,
-                    # backported to 3.11.4+.)
-                    tar.extractall(temp_path, filter="data")
-                
                 backup_root = temp_path / "backup"
+
+                if chunked:
+                    # Only the database and config entries are staged; files are
+                    # written straight into the storage tree below
+                    manifest = archive.read_manifest(filepath)
+                    store = archive.open_store(filepath.parent)
+                    for prefix, wanted in (
+                        ("database", restore_database and backup.includes_database),
+                        ("config", restore_config and backup.includes_config),
+                    ):
+                        if wanted:
+                            archive.extract_prefix(store, manifest, prefix, backup_root / prefix)
+                else:
+                    # Extract tar.gz
+                    with tarfile.open(filepath, "r:gz") as tar:
+                        # Security: prevent tar-slip. The ``data`` filter rejects
+                        # members with absolute paths, ".." traversal, or unsafe
+                        # links, so a tampered archive cannot write outside the
+                        # temp dir. BaluHost backups only contain regular data
+                        # files under "backup/", so this is behaviour-preserving
+                        # for legitimate archives. (tarfile filters: py3.12+,
+                        # backported to 3.11.4+.)
+                        tar.extractall(temp_path, filter="data")
                 
                 # Restore database
                 if restore_database and backup.includes_database:
@@ -475,7 +656,17 @@ class BackupService:
                             raise FileNotFoundError("PostgreSQL backup file not found in backup archive")
                 
                 # Restore files
-                if restore_files and backup.includes_files:
+                if restore_files and backup.includes_files and chunked:
+                    storage_path = Path(settings.nas_storage_path)
+                    if storage_path.exists():
+                        # The chunk store may live inside the storage tree (custom
+                        # backup_path): clear everything except that branch
+                        _clear_tree(storage_path, keep=filepath.parent)
+                    archive.extract_prefix(
+                        store, manifest, "files", storage_path,
+                        workers=reader_threads(storage_path.parent, settings.backup_reader_threads),
+                    )
+                elif restore_files and backup.includes_files:
                     files_backup = backup_root / "files"
                     if files_backup.exists():
                         storage_path = Path(settings.nas_storage_path)
@@ -559,6 +750,9 @@ class BackupService:
                 db=self.db
             )
             raise
+        finally:
+            if store is not None:
+                store.close()
     
     def download_backup(self, backup_id: int) -> Optional[Path]:
         """
@@ -576,6 +770,98 @@ class BackupService:
         
         filepath = Path(backup.filepath)
         return filepath if filepath.exists() else None
+
+    def iter_backup_tar(self, filepath: Path) -> Iterator[bytes]:
+        """Stream a chunked backup (from ``download_backup``) as a tar archive."""
+        store = archive.open_store(filepath.parent)
+        try:
+            yield from archive.iter_tar(store, archive.read_manifest(filepath))
+        finally:
+            store.close()
+
+    def list_backup_files(
+        self, backup_id: int, prefix: str = "", limit: int = 1000
+    ) -> Optional[list[dict]]:
+        """Entries of a chunked backup below *prefix* (path, size, mtime).
+
+        Returns None if the backup does not exist or is a legacy tar archive.
+        """
+        filepath = self.download_backup(backup_id)
+        if filepath is None or not archive.is_chunked_archive(filepath):
+            return None
+        manifest = archive.read_manifest(filepath)
+        return [
+            {"path": e["path"], "size": e["size"], "mtime": e["mtime_ns"] / 1e9}
+            for e in manifest["entries"] if e["path"].startswith(prefix)
+        ][:limit]
+
+    def open_backup_file(self, backup_id: int, path: str) -> Optional[tuple[dict, Iterator[bytes]]]:
+        """One entry of a chunked backup: its manifest entry and a content stream.
+
+        Reads only that entry's chunks. Returns None if the backup or entry
+        does not exist (or the backup is a legacy tar archive).
+        """
+        filepath = self.download_backup(backup_id)
+        if filepath is None or not archive.is_chunked_archive(filepath):
+            return None
+        entry = archive.find_entry(archive.read_manifest(filepath), path)
+        if entry is None:
+            return None
+
+        def _content() -> Iterator[bytes]:
+            store = archive.open_store(filepath.parent)
+            try:
+                yield from archive.iter_entry(store, entry)
+            finally:
+                store.close()
+
+        return entry, _content()
+
+    def restore_backup_file(self, backup_id: int, path: str, user: str) -> bool:
+        """Put a single ``files/...`` entry back at its place in the storage tree."""
+        filepath = self.download_backup(backup_id)
+        if filepath is None or not archive.is_chunked_archive(filepath) or not path.startswith("files/"):
+            return False
+        entry = archive.find_entry(archive.read_manifest(filepath), path)
+        if entry is None:
+            return False
+        storage_path = Path(settings.nas_storage_path)
+        store = archive.open_store(filepath.parent)
+        try:
+            archive.extract_entry(
+                store, entry, archive.safe_target(storage_path, path[len("files/"):])
+            )
+        finally:
+            store.close()
+        AuditLoggerDB().log_event(
+            event_type="BACKUP",
+            action="restore_backup_file",
+            user=user,
+            resource=Path(filepath).name,
+            success=True,
+            details={"backup_id": backup_id, "path": path, "size_bytes": entry["size"]},
+            db=self.db
+        )
+        return True
+
+    def _collect_chunk_garbage(self, backup_dirs: set[Path]) -> None:
+        """Drop chunk packs no remaining manifest in *backup_dirs* references."""
+        def _live_digests(backup_dir: Path) -> set[bytes]:
+            live: set[bytes] = set()
+            for manifest_path in backup_dir.glob(f"*{MANIFEST_SUFFIX}"):
+                live |= archive.manifest_digests(archive.read_manifest(manifest_path))
+            return live
+
+        for backup_dir in backup_dirs:
+            try:
+                # Scanned under the store lock: a backup finishing meanwhile
+                # would otherwise lose the packs its new manifest references
+                freed = archive.open_store(backup_dir).gc(lambda: _live_digests(backup_dir))
+                if freed:
+                    logger.info("Backup store %s: freed %d bytes", backup_dir, freed)
+            except Exception as exc:
+                # Keeping garbage is safe; deleting live chunks is not
+                logger.warning("Backup chunk GC in %s skipped: %s", backup_dir, exc)
     
     def _backup_postgres_database(self, backup_dir: Path) -> None:
         """
@@ -794,12 +1080,16 @@ class BackupService:
             .all()
         )
         
+        chunk_stores: set[Path] = set()
+
         # Remove backups exceeding max count
         if len(backups) > settings.nas_backup_max_count:
             for backup in backups[settings.nas_backup_max_count:]:
                 filepath = Path(backup.filepath)
                 if filepath.exists():
                     filepath.unlink()
+                if archive.is_chunked_archive(filepath):
+                    chunk_stores.add(filepath.parent)
                 # Audit-Log
                 logger = AuditLoggerDB()
                 logger.log_event(
@@ -828,6 +1118,8 @@ class BackupService:
             filepath = Path(backup.filepath)
             if filepath.exists():
                 filepath.unlink()
+            if archive.is_chunked_archive(filepath):
+                chunk_stores.add(filepath.parent)
             # Audit-Log
             logger = AuditLoggerDB()
             logger.log_event(
@@ -842,6 +1134,22 @@ class BackupService:
             self.db.delete(backup)
         
         self.db.commit()
+        self._collect_chunk_garbage(chunk_stores)
+
+
+def _clear_tree(root: Path, keep: Path) -> None:
+    """Delete everything below *root* except *keep* and its ancestors."""
+    keep = keep.resolve()
+    for child in root.iterdir():
+        resolved = child.resolve()
+        if resolved == keep or resolved in keep.parents:
+            if child.is_dir() and not child.is_symlink() and resolved != keep:
+                _clear_tree(child, keep)
+            continue
+        if child.is_dir() and not child.is_symlink():
+            shutil.rmtree(child)
+        else:
+            child.unlink()
 
 
 def get_backup_service(db: Session) -> BackupService:
@@ -3,6 +3,10 @@ Disk Benchmark Service.
 
 Provides CrystalDiskMark-style disk performance benchmarks using fio.
 Supports both production (real fio) and development (simulated) modes.
+
+The workload suite (suite.py / workloads.py) measures end-to-end performance
+through the live API: uploads, downloads, listings, versioning, SSD cache and
+WebDAV, with per-run version/hardware fingerprints for regression tracking.
 """
 
 from app.services.benchmark.api import (
@@ -25,8 +29,18 @@ from app.services.benchmark.state import (
     BenchmarkBackend,
     FioNotFoundError,
     _active_benchmarks,
+    _active_workload_runs,
     _cancellation_flags,
+    _workload_cancellation_flags,
+)
+from app.services.benchmark.suite import (
+    cancel_workload_benchmark,
+    get_comparison,
+    get_workload_benchmark,
+    get_workload_history,
+    start_workload_benchmark,
 )
+from app.services.benchmark.workloads import WORKLOADS
 from app.services.benchmark.tokens import (
     generate_confirmation_token,
     validate_confirmation_token,
@@ -53,7 +67,16 @@ __all__ = [
     # Tokens
     "generate_confirmation_token",
     "validate_confirmation_token",
+    # Workload suite
+    "WORKLOADS",
+    "start_workload_benchmark",
+    "cancel_workload_benchmark",
+    "get_workload_benchmark",
+    "get_workload_history",
+    "get_comparison",
     # State (for monkey-patching in tests)
     "_active_benchmarks",
     "_cancellation_flags",
+    "_active_workload_runs",
+    "_workload_cancellation_flags",
 ]
@@ -14,9 +14,14 @@ from datetime import datetime, timezone
 
 from sqlalchemy.orm import Session
 
-from app.models.benchmark import BenchmarkStatus, DiskBenchmark
+from app.models.benchmark import BenchmarkStatus, DiskBenchmark, WorkloadBenchmark
 
-from .state import _active_benchmarks, _cancellation_flags
+from .state import (
+    _active_benchmarks,
+    _active_workload_runs,
+    _cancellation_flags,
+    _workload_cancellation_flags,
+)
 
 logger = logging.getLogger(__name__)
 
@@ -24,13 +29,16 @@ logger = logging.getLogger(__name__)
 def recover_stale_benchmarks(db: Session) -> int:
     """Mark any RUNNING/PENDING benchmarks as FAILED after a server restart.
 
-    Returns the number of recovered benchmarks.
+    Covers disk and workload benchmarks. Returns the number of recovered runs.
     """
-    stale = (
-        db.query(DiskBenchmark)
+    stale = [
+        *db.query(DiskBenchmark)
         .filter(DiskBenchmark.status.in_([BenchmarkStatus.RUNNING, BenchmarkStatus.PENDING]))
-        .all()
-    )
+        .all(),
+        *db.query(WorkloadBenchmark)
+        .filter(WorkloadBenchmark.status.in_([BenchmarkStatus.RUNNING, BenchmarkStatus.PENDING]))
+        .all(),
+    ]
     if not stale:
         return 0
 
@@ -84,9 +92,11 @@ async def shutdown_benchmarks(db: Session) -> None:
     # Set cancellation flags for all active benchmarks
     for bench_id in list(_active_benchmarks.keys()):
         _cancellation_flags[bench_id] = True
+    for run_id in list(_active_workload_runs.keys()):
+        _workload_cancellation_flags[run_id] = True
 
     # Cancel and wait for active tasks
-    for bench_id, task in list(_active_benchmarks.items()):
+    for task in [*_active_benchmarks.values(), *_active_workload_runs.values()]:
         task.cancel()
         try:
             await asyncio.wait_for(asyncio.shield(task), timeout=5)
@@ -102,4 +112,6 @@ async def shutdown_benchmarks(db: Session) -> None:
     # Clear tracking dicts
     _active_benchmarks.clear()
     _cancellation_flags.clear()
+    _active_workload_runs.clear()
+    _workload_cancellation_flags.clear()
     logger.info("Benchmark shutdown complete")
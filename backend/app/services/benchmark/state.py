@@ -26,6 +26,10 @@ logger = logging.getLogger(__name__)
 _active_benchmarks: Dict[int, asyncio.Task] = {}
 _cancellation_flags: Dict[int, bool] = {}
 
+# Workload benchmark runs (suite.py); separate id space from disk benchmarks
+_active_workload_runs: Dict[int, asyncio.Task] = {}
+_workload_cancellation_flags: Dict[int, bool] = {}
+
 # Timeout for a single fio test (10 minutes)
 _FIO_TIMEOUT_SECONDS = 600
 
@@ -0,0 +1,422 @@
+"""
+End-to-end benchmark suite: runs, fingerprints and comparisons.
+
+Uses the same job model as the disk benchmarks (api.py / lifecycle.py): one
+``WorkloadBenchmark`` row per run, an asyncio task tracked in
+``state._active_workload_runs``, cooperative cancellation through
+``state._workload_cancellation_flags``, stale runs failed on startup by
+``lifecycle.recover_stale_benchmarks``.
+
+Every run records the app version/commit and a hardware fingerprint. On
+completion it is compared with the previous completed run of the same
+profile on the same hardware, so a slowdown introduced by an update shows
+up as ``regressions`` on the first run after it.
+"""
+
+from __future__ import annotations
+
+import asyncio
+import hashlib
+import json
+import logging
+import os
+import platform
+import shutil
+from datetime import datetime, timezone
+from pathlib import Path
+from typing import Callable, Dict, List, Optional, Tuple
+
+import httpx
+from sqlalchemy.orm import Session
+
+from app.core.config import settings
+from app.models.benchmark import BenchmarkStatus, WorkloadBenchmark, WorkloadResult
+from app.schemas.benchmark import WORKLOAD_PROFILES, WorkloadProfileConfig
+
+from .state import _active_workload_runs, _workload_cancellation_flags
+from .workloads import WORKLOADS, WorkloadContext, WorkloadSkipped
+
+logger = logging.getLogger(__name__)
+
+# A metric that got worse by more than this counts as a regression
+REGRESSION_THRESHOLD = 0.10
+# Latency changes below this are noise, whatever the percentage
+MIN_LATENCY_DELTA_MS = 1.0
+# metric -> higher is better
+COMPARED_METRICS: Dict[str, bool] = {
+    "throughput_mbps": True,
+    "ops_per_second": True,
+    "latency_p50_ms": False,
+    "latency_p99_ms": False,
+}
+
+ClientFactory = Callable[..., httpx.AsyncClient]
+
+
+# ===== Fingerprints =====
+
+def _read_first(path: str, prefix: str) -> Optional[str]:
+    try:
+        with open(path, "r") as fh:
+            for line in fh:
+                if line.startswith(prefix):
+                    return line.split(":", 1)[1].strip()
+    except OSError:
+        pass
+    return None
+
+
+def _block_devices() -> List[str]:
+    """Model names of the physical block devices (Linux)."""
+    models = []
+    root = Path("/sys/block")
+    if not root.is_dir():
+        return models
+    for dev in sorted(root.iterdir()):
+        if dev.name.startswith(("loop", "ram", "zram", "dm-", "md", "sr")):
+            continue
+        try:
+            model = (dev / "device" / "model").read_text().strip()
+        except OSError:
+            model = "unknown"
+        models.append(f"{dev.name}:{model}")
+    return models
+
+
+def collect_environment() -> dict:
+    """Hardware and software facts recorded with every run."""
+    mem_kb = _read_first("/proc/meminfo", "MemTotal")
+    return {
+        "cpu_model": _read_first("/proc/cpuinfo", "model name") or platform.processor() or "unknown",
+        "cpu_count": os.cpu_count() or 0,
+        "memory_gb": round(int(mem_kb.split()[0]) / (1024 * 1024)) if mem_kb else None,
+        "block_devices": _block_devices(),
+        "kernel": platform.release(),
+        "python": platform.python_version(),
+        "mode": settings.nas_mode,
+    }
+
+
+def hardware_fingerprint(environment: dict) -> str:
+    """Stable id of the hardware; kernel/Python changes do not alter it."""
+    key = {k: environment.get(k) for k in ("cpu_model", "cpu_count", "memory_gb", "block_devices")}
+    return hashlib.sha256(json.dumps(key, sort_keys=True).encode()).hexdigest()[:16]
+
+
+async def _current_version() -> Tuple[Optional[str], Optional[str]]:
+    try:
+        from app.services.update.api import get_update_backend
+
+        info = await get_update_backend().get_current_version()
+        return info.version, info.commit
+    except Exception as exc:
+        logger.debug("Could not determine app version: %s", exc)
+        return None, None
+
+
+# ===== Runs =====
+
+def _api_client(user) -> httpx.AsyncClient:
+    """Loopback client for the local API, authenticated as *user* for one hour."""
+    from app.services.auth import create_access_token
+
+    token = create_access_token(user, expires_minutes=60)
+    return httpx.AsyncClient(
+        base_url=f"http://127.0.0.1:{settings.port}{settings.api_prefix}",
+        headers={"Authorization": f"Bearer {token}"},
+        timeout=httpx.Timeout(120.0),
+    )
+
+
+def _default_session_factory() -> Session:
+    from app.core.database import SessionLocal
+
+    return SessionLocal()
+
+
+def _resolve_workloads(workloads: Optional[List[str]]) -> List[str]:
+    if not workloads:
+        return list(WORKLOADS)
+    unknown = sorted(set(workloads) - set(WORKLOADS))
+    if unknown:
+        raise ValueError(f"Unknown workload(s): {', '.join(unknown)}")
+    return [name for name in WORKLOADS if name in workloads]  # keep run order
+
+
+async def start_workload_benchmark(
+    db: Session,
+    user_id: int,
+    profile: str = "quick",
+    workloads: Optional[List[str]] = None,
+    webdav_password: Optional[str] = None,
+    *,
+    client_factory: Optional[ClientFactory] = None,
+    session_factory: Optional[Callable[[], Session]] = None,
+) -> WorkloadBenchmark:
+    """Record a new run and start it in the background.
+
+    Raises:
+        ValueError: Unknown profile/workload, or another run is in progress
+    """
+    config = WORKLOAD_PROFILES.get(profile)
+    if config is None:
+        raise ValueError(f"Unknown workload profile '{profile}'")
+    names = _resolve_workloads(workloads)
+    if _active_workload_runs:
+        raise ValueError("A workload benchmark is already running")
+
+    environment = await asyncio.to_thread(collect_environment)
+    version, commit = await _current_version()
+    run = WorkloadBenchmark(
+        profile=profile,
+        status=BenchmarkStatus.PENDING,
+        progress_percent=0.0,
+        app_version=version,
+        app_commit=commit,
+        hardware_fingerprint=hardware_fingerprint(environment),
+        environment_json=json.dumps(environment),
+        user_id=user_id,
+    )
+    db.add(run)
+    db.commit()
+    db.refresh(run)
+
+    run_id = run.id
+    task = asyncio.create_task(_run_suite(
+        run_id, user_id, config, names, webdav_password,
+        client_factory or _api_client, session_factory or _default_session_factory,
+    ))
+    _active_workload_runs[run_id] = task
+    _workload_cancellation_flags[run_id] = False
+    return run
+
+
+async def _run_workload(name: str, ctx: WorkloadContext) -> WorkloadResult:
+    try:
+        measurement = await WORKLOADS[name](ctx)
+    except WorkloadSkipped as exc:
+        return WorkloadResult(workload=name, status="skipped", detail=str(exc)[:512])
+    except Exception as exc:
+        logger.warning("Workload %s failed: %s", name, exc)
+        return WorkloadResult(workload=name, status="failed", detail=str(exc)[:512] or type(exc).__name__)
+    summary = measurement.summary()
+    status = "failed" if summary["errors"] and not summary["samples"] else "ok"
+    return WorkloadResult(workload=name, status=status, detail=measurement.detail(), **summary)
+
+
+def _remove_scratch(scratch: str, session_factory: Callable[[], Session]) -> None:
+    from app.services.files import operations
+    from app.services.files.path_utils import _resolve_path
+
+    db = session_factory()
+    try:
+        operations.delete_path(scratch, db=db)
+        db.commit()
+    except Exception as exc:
+        logger.warning("Could not delete benchmark folder %s: %s", scratch, exc)
+        db.rollback()
+    finally:
+        db.close()
+    # Files created on disk only (listing) have no metadata to go through
+    shutil.rmtree(_resolve_path(scratch), ignore_errors=True)
+
+
+async def _run_suite(
+    run_id: int,
+    user_id: int,
+    config: WorkloadProfileConfig,
+    names: List[str],
+    webdav_password: Optional[str],
+    client_factory: ClientFactory,
+    session_factory: Callable[[], Session],
+) -> None:
+    from app.models.user import User
+    from app.services.files.path_utils import _resolve_path
+    from app.services.files.storage_permissions import ensure_dir_with_permissions
+
+    def cancelled() -> bool:
+        return _workload_cancellation_flags.get(run_id, False)
+
+    db = session_factory()
+    run = db.get(WorkloadBenchmark, run_id)
+    scratch: Optional[str] = None
+    try:
+        user = db.get(User, user_id)
+        if run is None or user is None:
+            raise RuntimeError("Run or user no longer exists")
+        run.status = BenchmarkStatus.RUNNING
+        run.started_at = datetime.now(timezone.utc)
+        db.commit()
+
+        scratch = f"{user.username}/.benchmark-{run_id}"
+        scratch_dir = _resolve_path(scratch)
+        await asyncio.to_thread(ensure_dir_with_permissions, scratch_dir)
+
+        async with client_factory(user) as client:
+            ctx = WorkloadContext(
+                client=client,
+                session_factory=session_factory,
+                user_id=user.id,
+                username=user.username,
+                scratch=scratch,
+                scratch_dir=scratch_dir,
+                config=config,
+                cancelled=cancelled,
+                webdav_password=webdav_password,
+            )
+            for index, name in enumerate(names):
+                if cancelled():
+                    break
+                run.current_workload = name
+                run.progress_percent = round(index / len(names) * 100, 1)
+                db.commit()
+                run.results.append(await _run_workload(name, ctx))
+                db.commit()
+
+        if cancelled():
+            run.status = BenchmarkStatus.CANCELLED
+        else:
+            run.status = BenchmarkStatus.COMPLETED
+            run.progress_percent = 100.0
+            baseline = find_baseline(db, run)
+            if baseline is not None:
+                run.baseline_id = baseline.id
+                run.regressions = sum(1 for d in compare_runs(run, baseline) if d["regression"])
+    except asyncio.CancelledError:
+        if run is not None:
+            run.status = BenchmarkStatus.CANCELLED
+        raise
+    except Exception as exc:
+        logger.exception("Workload benchmark %d failed: %s", run_id, exc)
+        db.rollback()
+        if run is not None:
+            run.status = BenchmarkStatus.FAILED
+            run.error_message = str(exc)[:1024]
+    finally:
+        if scratch is not None:
+            await asyncio.shield(asyncio.to_thread(_remove_scratch, scratch, session_factory))
+        if run is not None:
+            now = datetime.now(timezone.utc)
+            run.completed_at = now
+            run.current_workload = None
+            if run.started_at:
+                started = run.started_at
+                if started.tzinfo is None:
+                    started = started.replace(tzinfo=timezone.utc)
+                run.duration_seconds = (now - started).total_seconds()
+            db.commit()
+        db.close()
+        _active_workload_runs.pop(run_id, None)
+        _workload_cancellation_flags.pop(run_id, None)
+
+
+def cancel_workload_benchmark(run_id: int) -> bool:
+    """Ask a running suite to stop after the current operation."""
+    if run_id not in _active_workload_runs:
+        return False
+    _workload_cancellation_flags[run_id] = True
+    return True
+
+
+def get_workload_benchmark(db: Session, run_id: int) -> Optional[WorkloadBenchmark]:
+    return db.query(WorkloadBenchmark).filter(WorkloadBenchmark.id == run_id).first()
+
+
+def get_workload_history(
+    db: Session,
+    page: int = 1,
+    page_size: int = 10,
+    profile: Optional[str] = None,
+) -> Tuple[List[WorkloadBenchmark], int]:
+    """Paginated runs, newest first."""
+    query = db.query(WorkloadBenchmark)
+    if profile:
+        query = query.filter(WorkloadBenchmark.profile == profile)
+    total = query.count()
+    runs = (
+        query.order_by(WorkloadBenchmark.created_at.desc(), WorkloadBenchmark.id.desc())
+        .offset((page - 1) * page_size)
+        .limit(page_size)
+        .all()
+    )
+    return runs, total
+
+
+# ===== Comparison =====
+
+def find_baseline(db: Session, run: WorkloadBenchmark) -> Optional[WorkloadBenchmark]:
+    """Previous completed run of the same profile on the same hardware."""
+    return (
+        db.query(WorkloadBenchmark)
+        .filter(
+            WorkloadBenchmark.id < run.id,
+            WorkloadBenchmark.profile == run.profile,
+            WorkloadBenchmark.hardware_fingerprint == run.hardware_fingerprint,
+            WorkloadBenchmark.status == BenchmarkStatus.COMPLETED,
+        )
+        .order_by(WorkloadBenchmark.id.desc())
+        .first()
+    )
+
+
+def compare_runs(
+    current: WorkloadBenchmark,
+    baseline: WorkloadBenchmark,
+    threshold: float = REGRESSION_THRESHOLD,
+) -> List[dict]:
+    """Per-metric deltas of the workloads both runs measured successfully.
+
+    ``change_percent`` is signed so that positive always means better.
+    """
+    previous = {r.workload: r for r in baseline.results if r.status == "ok"}
+    deltas = []
+    for result in current.results:
+        before = previous.get(result.workload)
+        if result.status != "ok" or before is None:
+            continue
+        for metric, higher_is_better in COMPARED_METRICS.items():
+            old, new = getattr(before, metric), getattr(result, metric)
+            if old is None or new is None or old <= 0:
+                continue
+            change = (new - old) / old if higher_is_better else (old - new) / old
+            regression = change < -threshold
+            if not higher_is_better and new - old < MIN_LATENCY_DELTA_MS:
+                regression = False
+            deltas.append({
+                "workload": result.workload,
+                "metric": metric,
+                "baseline": old,
+                "current": new,
+                "change_percent": round(change * 100, 1),
+                "regression": regression,
+            })
+    return deltas
+
+
+def get_comparison(
+    db: Session, run_id: int, baseline_id: Optional[int] = None
+) -> Optional[dict]:
+    """Compare a run with *baseline_id* (default: its recorded/previous baseline).
+
+    Returns None if the run does not exist.
+    """
+    run = get_workload_benchmark(db, run_id)
+    if run is None:
+        return None
+    if baseline_id is None:
+        baseline_id = run.baseline_id
+    baseline = get_workload_benchmark(db, baseline_id) if baseline_id is not None else find_baseline(db, run)
+    if baseline is None:
+        deltas: List[dict] = []
+    else:
+        deltas = compare_runs(run, baseline)
+    return {
+        "benchmark_id": run.id,
+        "baseline_id": baseline.id if baseline else None,
+        "baseline_version": baseline.app_version if baseline else None,
+        "current_version": run.app_version,
+        "same_hardware": baseline is None or baseline.hardware_fingerprint == run.hardware_fingerprint,
+        "threshold_percent": REGRESSION_THRESHOLD * 100,
+        "deltas": deltas,
+        "regressions": sum(1 for d in deltas if d["regression"]),
+    }
@@ -0,0 +1,416 @@
+"""
+End-to-end workloads of the benchmark suite (see suite.py).
+
+Each workload drives the live stack the way a client does: HTTP requests
+against the local API (or the WebDAV server) as the admin who started the
+run, with per-operation latencies recorded in a ``Measurement``. Services
+are called directly only where clients have no endpoint of their own (VCL
+version creation, SSD cache population). Everything is written below the
+run's scratch folder, which the suite removes afterwards.
+
+``WORKLOADS`` is also the run order: later workloads reuse the file the
+upload workload wrote (``ctx.state["upload_path"]``).
+"""
+
+from __future__ import annotations
+
+import asyncio
+import logging
+import math
+import os
+import random
+import time
+from dataclasses import dataclass, field
+from pathlib import Path
+from typing import Awaitable, Callable, Dict, List, Optional
+from urllib.parse import quote
+
+import httpx
+from sqlalchemy.orm import Session
+
+from app.core.config import settings
+from app.schemas.benchmark import WorkloadProfileConfig
+
+logger = logging.getLogger(__name__)
+
+_SMALL_FILE_BYTES = 4096
+_RANGE_CONCURRENCY = 4
+
+
+class WorkloadSkipped(Exception):
+    """The workload does not apply to this system; the message says why."""
+
+
+def _percentile(sorted_values: List[float], q: float) -> Optional[float]:
+    """Nearest-rank percentile of an ascending list."""
+    if not sorted_values:
+        return None
+    rank = max(0, min(len(sorted_values) - 1, math.ceil(q * len(sorted_values)) - 1))
+    return sorted_values[rank]
+
+
+@dataclass
+class Measurement:
+    """Per-operation latencies (seconds) and bytes moved by one workload."""
+
+    latencies: List[float] = field(default_factory=list)
+    bytes_total: int = 0
+    errors: int = 0
+    rate_limited: int = 0
+    # Wall time of the whole workload; defaults to the sum of latencies
+    elapsed: float = 0.0
+    note: Optional[str] = None
+
+    def add(self, seconds: float, nbytes: int = 0) -> None:
+        self.latencies.append(seconds)
+        self.bytes_total += nbytes
+
+    def check(self, response: httpx.Response) -> bool:
+        """Count a failed response; True if it succeeded."""
+        if response.status_code < 400:
+            return True
+        self.errors += 1
+        if response.status_code == 429:
+            self.rate_limited += 1
+        return False
+
+    def detail(self) -> Optional[str]:
+        parts = [self.note] if self.note else []
+        if self.rate_limited:
+            parts.append(f"{self.rate_limited} requests rate limited")
+        return "; ".join(parts) or None
+
+    def summary(self) -> dict:
+        """Column values for ``WorkloadResult``."""
+        latencies = sorted(self.latencies)
+        elapsed = self.elapsed or sum(latencies)
+
+        def ms(value: Optional[float]) -> Optional[float]:
+            return round(value * 1000, 3) if value is not None else None
+
+        return {
+            "samples": len(latencies),
+            "errors": self.errors,
+            "bytes_total": self.bytes_total or None,
+            "elapsed_seconds": round(elapsed, 4) if elapsed else None,
+            "throughput_mbps": round(self.bytes_total / elapsed / (1024 * 1024), 2)
+            if self.bytes_total and elapsed else None,
+            "ops_per_second": round(len(latencies) / elapsed, 2) if latencies and elapsed else None,
+            "latency_p50_ms": ms(_percentile(latencies, 0.50)),
+            "latency_p95_ms": ms(_percentile(latencies, 0.95)),
+            "latency_p99_ms": ms(_percentile(latencies, 0.99)),
+            "latency_max_ms": ms(latencies[-1] if latencies else None),
+        }
+
+
+@dataclass
+class WorkloadContext:
+    """What a workload needs; one per run."""
+
+    client: httpx.AsyncClient  # API base URL, authenticated as the run's admin
+    session_factory: Callable[[], Session]
+    user_id: int
+    username: str
+    scratch: str  # storage-relative path of the run's scratch folder
+    scratch_dir: Path
+    config: WorkloadProfileConfig
+    cancelled: Callable[[], bool]
+    webdav_password: Optional[str] = None
+    state: dict = field(default_factory=dict)
+
+
+def _url_path(relative_path: str) -> str:
+    return quote(relative_path, safe="/")
+
+
+def _upload_path(ctx: WorkloadContext) -> str:
+    path = ctx.state.get("upload_path")
+    if path is None:
+        raise WorkloadSkipped("needs the file written by upload_chunked")
+    return path
+
+
+async def _run_concurrent(
+    ctx: WorkloadContext, total: int, concurrency: int, op: Callable[[int], Awaitable[None]]
+) -> None:
+    semaphore = asyncio.Semaphore(max(1, concurrency))
+
+    async def one(index: int) -> None:
+        async with semaphore:
+            if not ctx.cancelled():
+                await op(index)
+
+    await asyncio.gather(*(one(i) for i in range(total)))
+
+
+async def _range_reads(ctx: WorkloadContext, m: Measurement, path: str, count: int) -> None:
+    size = ctx.state["upload_size"]
+    length = min(ctx.config.range_size_kb * 1024, size)
+    rng = random.Random(ctx.user_id)  # same offsets on every run
+    offsets = [rng.randrange(0, max(1, size - length + 1)) & ~4095 for _ in range(count)]
+    url = f"/files/download/{_url_path(path)}"
+
+    async def read(index: int) -> None:
+        start = offsets[index]
+        t0 = time.perf_counter()
+        response = await ctx.client.get(url, headers={"Range": f"bytes={start}-{start + length - 1}"})
+        if m.check(response):
+            m.add(time.perf_counter() - t0, len(response.content))
+
+    await _run_concurrent(ctx, count, _RANGE_CONCURRENCY, read)
+
+
+# ── Workloads ────────────────────────────────────────────────────────────────
+
+async def upload_chunked(ctx: WorkloadContext) -> Measurement:
+    """Parallel chunked upload; latency per chunk, MB/s from init to complete."""
+    m = Measurement()
+    total = ctx.config.upload_size_mb * 1024 * 1024
+    started = time.perf_counter()
+    response = await ctx.client.post("/files/upload/chunked/init", json={
+        "filename": "upload.bin", "total_size": total, "target_path": ctx.scratch, "parallel": True,
+    })
+    if not m.check(response):
+        raise RuntimeError(f"upload init failed: HTTP {response.status_code}")
+    init = response.json()
+    upload_id, chunk_size = init["upload_id"], init["chunk_size"]
+    # One random block; a per-chunk prefix keeps the chunks distinct
+    block = os.urandom(min(chunk_size, total))
+
+    async def send(index: int) -> None:
+        length = min(chunk_size, total - index * chunk_size)
+        body = (index.to_bytes(8, "big") + block[8:length]) if length > 8 else block[:length]
+        t0 = time.perf_counter()
+        r = await ctx.client.post(
+            f"/files/upload/chunked/{upload_id}/chunk",
+            params={"chunk_index": index},
+            content=body,
+            headers={"Content-Type": "application/octet-stream"},
+        )
+        if m.check(r):
+            m.add(time.perf_counter() - t0, length)
+
+    try:
+        await _run_concurrent(ctx, init["total_chunks"], ctx.config.upload_concurrency, send)
+        if ctx.cancelled() or m.errors:
+            await ctx.client.delete(f"/files/upload/chunked/{upload_id}")
+            return m
+        response = await ctx.client.post(f"/files/upload/chunked/{upload_id}/complete")
+    except BaseException:
+        await ctx.client.delete(f"/files/upload/chunked/{upload_id}")
+        raise
+    if not m.check(response):
+        raise RuntimeError(f"upload complete failed: HTTP {response.status_code}")
+    m.elapsed = time.perf_counter() - started
+    ctx.state["upload_path"] = response.json()["path"]
+    ctx.state["upload_size"] = total
+    return m
+
+
+async def download(ctx: WorkloadContext) -> Measurement:
+    """Full streamed download; latency is time to first byte."""
+    m = Measurement()
+    path = _upload_path(ctx)
+    t0 = time.perf_counter()
+    async with ctx.client.stream("GET", f"/files/download/{_url_path(path)}") as response:
+        if not m.check(response):
+            return m
+        first_byte: Optional[float] = None
+        async for chunk in response.aiter_bytes(1024 * 1024):
+            if first_byte is None:
+                first_byte = time.perf_counter() - t0
+            m.bytes_total += len(chunk)
+    m.elapsed = time.perf_counter() - t0
+    if first_byte is not None:
+        m.latencies.append(first_byte)
+    return m
+
+
+async def download_range(ctx: WorkloadContext) -> Measurement:
+    """Random Range requests (video seeking, resumed downloads)."""
+    m = Measurement()
+    await _range_reads(ctx, m, _upload_path(ctx), ctx.config.download_ranges)
+    return m
+
+
+async def list_directory(ctx: WorkloadContext) -> Measurement:
+    """Full listing of a large folder; files are created on disk like SMB writes."""
+    m = Measurement()
+    folder = ctx.scratch_dir / "listing"
+    count = ctx.config.list_entries
+
+    def populate() -> None:
+        folder.mkdir(parents=True, exist_ok=True)
+        for i in range(count):
+            (folder / f"entry-{i:06d}.dat").touch()
+
+    await asyncio.to_thread(populate)
+    ctx.state["listing_path"] = f"{ctx.scratch}/listing"
+    for _ in range(ctx.config.list_iterations):
+        if ctx.cancelled():
+            break
+        t0 = time.perf_counter()
+        response = await ctx.client.get("/files/list", params={"path": ctx.state["listing_path"]})
+        if m.check(response):
+            m.add(time.perf_counter() - t0, len(response.content))
+    m.note = f"{count} entries"
+    return m
+
+
+async def vcl_version(ctx: WorkloadContext) -> Measurement:
+    """VCL version creation for the uploaded file (service call, no endpoint)."""
+    m = Measurement()
+    path = _upload_path(ctx)
+
+    def create_versions() -> None:
+        from app.services.files import metadata_db
+        from app.services.files.path_utils import _resolve_path
+        from app.services.versioning.vcl import VCLService
+
+        db = ctx.session_factory()
+        service = VCLService(db)
+        created = []
+        try:
+            meta = metadata_db.get_metadata(path, db=db)
+            if meta is None:
+                raise WorkloadSkipped("uploaded file has no metadata")
+            with open(_resolve_path(path), "rb") as fh:
+                base = fh.read(ctx.config.vcl_size_kb * 1024)
+            for i in range(ctx.config.vcl_versions):
+                if ctx.cancelled():
+                    break
+                content = i.to_bytes(8, "big") + base[8:]
+                t0 = time.perf_counter()
+                created.append(service.create_version(
+                    meta, content, ctx.user_id, change_type="update", comment="benchmark",
+                ))
+                m.add(time.perf_counter() - t0, len(content))
+        finally:
+            try:
+                for version in created:
+                    service.delete_version(version)
+                db.commit()
+            finally:
+                db.close()
+
+    await asyncio.to_thread(create_versions)
+    return m
+
+
+async def ssd_cache_hit(ctx: WorkloadContext) -> Measurement:
+    """Range reads of the uploaded file after it was copied into the SSD cache."""
+    m = Measurement()
+    path = _upload_path(ctx)
+
+    def populate() -> None:
+        from app.services.cache.ssd_file_cache import SSDFileCacheService
+        from app.services.files.path_utils import _resolve_path
+
+        db = ctx.session_factory()
+        try:
+            service = SSDFileCacheService(db)
+            if not service.is_cache_enabled():
+                raise WorkloadSkipped("SSD cache is not enabled")
+            if not service.should_cache_file(ctx.state["upload_size"]):
+                raise WorkloadSkipped("test file exceeds the cache's size limits")
+            cached = service.cache_file(path, _resolve_path(path))
+            db.commit()
+            if cached is None:
+                raise WorkloadSkipped("cache fill was skipped")
+        finally:
+            db.close()
+
+    await asyncio.to_thread(populate)
+    await _range_reads(ctx, m, path, ctx.config.cache_reads)
+    return m
+
+
+async def api_latency(ctx: WorkloadContext) -> Measurement:
+    """Concurrent small-file GETs: request overhead (auth, permissions, metadata)."""
+    m = Measurement()
+    small = ctx.scratch_dir / "small.bin"
+    await asyncio.to_thread(small.write_bytes, os.urandom(_SMALL_FILE_BYTES))
+    url = f"/files/download/{_url_path(ctx.scratch)}/small.bin"
+
+    async def get(_index: int) -> None:
+        t0 = time.perf_counter()
+        response = await ctx.client.get(url)
+        if m.check(response):
+            m.add(time.perf_counter() - t0, len(response.content))
+
+    started = time.perf_counter()
+    await _run_concurrent(ctx, ctx.config.api_requests, ctx.config.api_concurrency, get)
+    m.elapsed = time.perf_counter() - started
+    m.note = f"concurrency {ctx.config.api_concurrency}"
+    return m
+
+
+def _webdav_client(ctx: WorkloadContext) -> httpx.AsyncClient:
+    if not ctx.webdav_password:
+        raise WorkloadSkipped("no WebDAV password given")
+    if not settings.webdav_enabled:
+        raise WorkloadSkipped("WebDAV is disabled")
+    scheme = "https" if settings.webdav_ssl_enabled else "http"
+    return httpx.AsyncClient(
+        base_url=f"{scheme}://127.0.0.1:{settings.webdav_port}",
+        auth=(ctx.username, ctx.webdav_password),
+        verify=False,  # loopback to our own self-signed certificate
+        timeout=httpx.Timeout(120.0),
+    )
+
+
+async def webdav_propfind(ctx: WorkloadContext) -> Measurement:
+    """PROPFIND (Depth: 1) of the large folder, as file managers do."""
+    m = Measurement()
+    listing = ctx.state.get("listing_path")
+    if listing is None:
+        raise WorkloadSkipped("needs the folder written by list_directory")
+    async with _webdav_client(ctx) as dav:
+        for _ in range(ctx.config.webdav_iterations):
+            if ctx.cancelled():
+                break
+            t0 = time.perf_counter()
+            try:
+                response = await dav.request("PROPFIND", f"/{_url_path(listing)}/", headers={"Depth": "1"})
+            except httpx.ConnectError as exc:
+                raise WorkloadSkipped("WebDAV server not reachable") from exc
+            if m.check(response):
+                m.add(time.perf_counter() - t0, len(response.content))
+    return m
+
+
+async def webdav_download(ctx: WorkloadContext) -> Measurement:
+    """Full GET of the uploaded file over WebDAV; latency is time to first byte."""
+    m = Measurement()
+    path = _upload_path(ctx)
+    async with _webdav_client(ctx) as dav:
+        t0 = time.perf_counter()
+        try:
+            async with dav.stream("GET", f"/{_url_path(path)}") as response:
+                if not m.check(response):
+                    return m
+                first_byte: Optional[float] = None
+                async for chunk in response.aiter_bytes(1024 * 1024):
+                    if first_byte is None:
+                        first_byte = time.perf_counter() - t0
+                    m.bytes_total += len(chunk)
+        except httpx.ConnectError as exc:
+            raise WorkloadSkipped("WebDAV server not reachable") from exc
+    m.elapsed = time.perf_counter() - t0
+    if first_byte is not None:
+        m.latencies.append(first_byte)
+    return m
+
+
+# Run order (dependencies first)
+WORKLOADS: Dict[str, Callable[[WorkloadContext], Awaitable[Measurement]]] = {
+    "upload_chunked": upload_chunked,
+    "download": download,
+    "download_range": download_range,
+    "list_directory": list_directory,
+    "vcl_version": vcl_version,
+    "ssd_cache_hit": ssd_cache_hit,
+    "api_latency": api_latency,
+    "webdav_propfind": webdav_propfind,
+    "webdav_download": webdav_download,
+}
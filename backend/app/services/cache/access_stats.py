@@ -0,0 +1,188 @@
+"""Batched SSD cache access accounting.
+
+Serving a cached file used to cost two UPDATEs (entry access_count plus the
+array's hit counters) and a flush on the request path. Hits and misses are
+now accumulated in memory per worker and written in one batch every few
+seconds by a lifespan background task; a final flush runs on shutdown.
+
+The flush also refreshes each touched entry's LFRU ``eviction_priority``.
+Eviction only needs these columns to be roughly current, so losing at most
+one interval of counts on a crash is acceptable.
+"""
+from __future__ import annotations
+
+import asyncio
+import logging
+import threading
+from collections import defaultdict
+from dataclasses import dataclass, field
+from datetime import datetime, timezone
+from typing import Optional
+
+from sqlalchemy import bindparam, select, update as sql_update
+from sqlalchemy.orm import Session
+
+from app.models.ssd_file_cache import SSDCacheEntry, SSDCacheConfig, lfru_priority
+
+logger = logging.getLogger(__name__)
+
+FLUSH_INTERVAL_SECONDS = 5.0
+# Upper bound on ids per IN (...) when reading current access counts
+_SELECT_CHUNK = 500
+
+
+@dataclass
+class _ArrayCounters:
+    hits: int = 0
+    misses: int = 0
+    bytes_served: int = 0
+
+
+@dataclass
+class _Pending:
+    entries: dict[int, list] = field(default_factory=dict)  # id -> [count, last_ts]
+    arrays: dict[str, _ArrayCounters] = field(
+        default_factory=lambda: defaultdict(_ArrayCounters)
+    )
+
+    def empty(self) -> bool:
+        return not self.entries and not self.arrays
+
+
+class CacheAccessStats:
+    """Thread-safe per-worker accumulator for cache hits and misses."""
+
+    def __init__(self) -> None:
+        self._lock = threading.Lock()
+        self._pending = _Pending()
+
+    def record_hit(self, array_name: str, entry_id: int, file_size: int) -> None:
+        now = datetime.now(timezone.utc)
+        with self._lock:
+            slot = self._pending.entries.get(entry_id)
+            if slot is None:
+                self._pending.entries[entry_id] = [1, now]
+            else:
+                slot[0] += 1
+                slot[1] = now
+            counters = self._pending.arrays[array_name]
+            counters.hits += 1
+            counters.bytes_served += file_size
+
+    def record_miss(self, array_name: str) -> None:
+        with self._lock:
+            self._pending.arrays[array_name].misses += 1
+
+    def discard(self) -> None:
+        """Drop everything not yet flushed."""
+        with self._lock:
+            self._pending = _Pending()
+
+    def _merge_back(self, pending: _Pending) -> None:
+        with self._lock:
+            for entry_id, (count, ts) in pending.entries.items():
+                slot = self._pending.entries.get(entry_id)
+                if slot is None:
+                    self._pending.entries[entry_id] = [count, ts]
+                else:
+                    slot[0] += count
+                    slot[1] = max(slot[1], ts)
+            for array_name, c in pending.arrays.items():
+                target = self._pending.arrays[array_name]
+                target.hits += c.hits
+                target.misses += c.misses
+                target.bytes_served += c.bytes_served
+
+    def flush(self, db: Optional[Session] = None) -> int:
+        """Write accumulated counts in one batch. Returns the number of entries touched.
+
+        With *db* the caller owns the transaction (we only flush the session);
+        otherwise a short-lived session is opened and committed. On failure
+        the drained counts are merged back so the next flush retries them.
+        """
+        with self._lock:
+            if self._pending.empty():
+                return 0
+            pending, self._pending = self._pending, _Pending()
+
+        own_session = db is None
+        if own_session:
+            from app.core.database import SessionLocal
+            db = SessionLocal()
+        try:
+            if pending.entries:
+                table = SSDCacheEntry.__table__
+                # The LFRU priority needs the resulting count; read the current
+                # ones, then apply the increments relative to the stored value
+                # so concurrent flushes from other workers still add up.
+                ids = list(pending.entries)
+                current: dict[int, int] = {}
+                for start in range(0, len(ids), _SELECT_CHUNK):
+                    rows = db.execute(
+                        select(table.c.id, table.c.access_count)
+                        .where(table.c.id.in_(ids[start:start + _SELECT_CHUNK]))
+                    ).all()
+                    current.update((row_id, int(count or 0)) for row_id, count in rows)
+                params = [
+                    {
+                        "_id": entry_id,
+                        "_count": count,
+                        "_ts": ts,
+                        "_priority": lfru_priority(current[entry_id] + count, ts),
+                    }
+                    for entry_id, (count, ts) in pending.entries.items()
+                    if entry_id in current  # evicted since the hit
+                ]
+                if params:
+                    db.execute(
+                        sql_update(table)
+                        .where(table.c.id == bindparam("_id"))
+                        .values(
+                            access_count=table.c.access_count + bindparam("_count"),
+                            last_accessed=bindparam("_ts"),
+                            eviction_priority=bindparam("_priority"),
+                        ),
+                        params,
+                    )
+            for array_name, c in pending.arrays.items():
+                db.execute(
+                    sql_update(SSDCacheConfig)
+                    .where(SSDCacheConfig.array_name == array_name)
+                    .values(
+                        total_hits=SSDCacheConfig.total_hits + c.hits,
+                        total_misses=SSDCacheConfig.total_misses + c.misses,
+                        total_bytes_served_from_cache=(
+                            SSDCacheConfig.total_bytes_served_from_cache + c.bytes_served
+                        ),
+                    )
+                )
+            if own_session:
+                db.commit()
+            else:
+                db.flush()
+        except Exception:
+            if own_session:
+                db.rollback()
+            self._merge_back(pending)
+            raise
+        finally:
+            if own_session:
+                db.close()
+        return len(pending.entries)
+
+
+_stats = CacheAccessStats()
+
+
+def get_access_stats() -> CacheAccessStats:
+    return _stats
+
+
+async def run_flush_loop(interval: float = FLUSH_INTERVAL_SECONDS) -> None:
+    """Lifespan task: periodically persist this worker's cache counters."""
+    while True:
+        await asyncio.sleep(interval)
+        try:
+            await asyncio.to_thread(_stats.flush)
+        except Exception as exc:
+            logger.warning("SSD cache stats flush failed: %s", exc)
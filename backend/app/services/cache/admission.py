@@ -0,0 +1,156 @@
+"""TinyLFU admission for the SSD file cache.
+
+A count-min sketch of recent read frequency, kept in a memory-mapped file
+under the monitoring SHM directory so all workers count into the same
+table. Every cache lookup (hit or miss) increments the file's counters;
+when the cache is full, a new file is only admitted if it has been read
+more often than the entries it would displace. A one-off read of a large
+file therefore cannot flush the hot working set.
+
+Counters are 4-bit-style (saturate at 15) and the whole table is halved
+after every ``SAMPLE_FACTOR * width`` increments, so the sketch tracks recent
+popularity rather than all-time totals. Increments are unsynchronised
+read-modify-writes; an occasional lost update only makes an estimate
+slightly low, which is acceptable for an admission heuristic.
+"""
+from __future__ import annotations
+
+import hashlib
+import logging
+import mmap
+import os
+import struct
+import threading
+from pathlib import Path
+from typing import Optional
+
+from app.core.config import settings
+from app.services.monitoring.shm import SHM_DIR
+
+logger = logging.getLogger(__name__)
+
+_MAGIC = b"BHTL"
+_HEADER = struct.Struct("<4sIIQ")  # magic | depth | width | increments
+_HEADER_SIZE = 64
+
+DEPTH = 4
+WIDTH = 1 << 16
+MAX_COUNT = 15
+SAMPLE_FACTOR = 10  # age after SAMPLE_FACTOR * width increments
+
+_HALVE = bytes(i >> 1 for i in range(256))
+
+
+def _default_sketch_path() -> Path:
+    root = str(Path(settings.nas_storage_path).expanduser().resolve())
+    digest = hashlib.sha1(root.encode("utf-8")).hexdigest()[:12]
+    return SHM_DIR / f"ssd_cache_sketch-{digest}.bin"
+
+
+class FrequencySketch:
+    """Shared count-min sketch (see module docstring)."""
+
+    def __init__(self, path: Optional[Path] = None, width: int = WIDTH, depth: int = DEPTH) -> None:
+        self.path = path or _default_sketch_path()
+        self.width = width
+        self.depth = depth
+        self.sample_size = SAMPLE_FACTOR * width
+        self._size = _HEADER_SIZE + width * depth
+        self._mm: Optional[mmap.mmap] = None
+        self._fd: Optional[int] = None
+        self._dirty = False
+        self._open()
+
+    def _open(self) -> None:
+        try:
+            self.path.parent.mkdir(parents=True, exist_ok=True)
+            self._fd = os.open(self.path, os.O_RDWR | os.O_CREAT, 0o600)
+            if os.fstat(self._fd).st_size != self._size:
+                os.ftruncate(self._fd, self._size)
+            self._mm = mmap.mmap(self._fd, self._size)
+            magic, depth, width, _n = _HEADER.unpack_from(self._mm, 0)
+            if (magic, depth, width) != (_MAGIC, self.depth, self.width):
+                self._mm[:] = bytes(self._size)
+                _HEADER.pack_into(self._mm, 0, _MAGIC, self.depth, self.width, 0)
+        except (OSError, ValueError) as exc:
+            logger.warning("SSD cache admission sketch unavailable: %s", exc)
+            self.close()
+
+    def close(self) -> None:
+        if self._mm is not None:
+            try:
+                self._mm.close()
+            except (BufferError, ValueError):
+                pass
+            self._mm = None
+        if self._fd is not None:
+            os.close(self._fd)
+            self._fd = None
+
+    def _offsets(self, array_name: str, source_path: str) -> list[int]:
+        raw = f"{array_name}\x00{source_path}".encode("utf-8", "surrogateescape")
+        digest = hashlib.blake2b(raw, digest_size=4 * self.depth).digest()
+        return [
+            _HEADER_SIZE + row * self.width
+            + int.from_bytes(digest[4 * row:4 * row + 4], "little") % self.width
+            for row in range(self.depth)
+        ]
+
+    def increment(self, array_name: str, source_path: str) -> None:
+        mm = self._mm
+        if mm is None:
+            return
+        try:
+            for offset in self._offsets(array_name, source_path):
+                value = mm[offset]
+                if value < MAX_COUNT:
+                    mm[offset] = value + 1
+            magic, depth, width, n = _HEADER.unpack_from(mm, 0)
+            n += 1
+            if n >= self.sample_size:
+                self._age()
+            else:
+                _HEADER.pack_into(mm, 0, magic, depth, width, n)
+            self._dirty = True
+        except (ValueError, IndexError, struct.error):
+            pass
+
+    def estimate(self, array_name: str, source_path: str) -> int:
+        mm = self._mm
+        if mm is None:
+            return 0
+        try:
+            return min(mm[offset] for offset in self._offsets(array_name, source_path))
+        except (ValueError, IndexError):
+            return 0
+
+    def _age(self) -> None:
+        """Halve every counter (TinyLFU reset) and restart the sample."""
+        mm = self._mm
+        assert mm is not None
+        mm[_HEADER_SIZE:] = mm[_HEADER_SIZE:].translate(_HALVE)
+        _HEADER.pack_into(mm, 0, _MAGIC, self.depth, self.width, 0)
+
+    def clear(self) -> None:
+        if self._mm is None:
+            return
+        self._mm[_HEADER_SIZE:] = bytes(self._size - _HEADER_SIZE)
+        _HEADER.pack_into(self._mm, 0, _MAGIC, self.depth, self.width, 0)
+        self._dirty = False
+
+    def clear_if_dirty(self) -> None:
+        if self._dirty:
+            self.clear()
+
+
+_sketch: Optional[FrequencySketch] = None
+_sketch_lock = threading.Lock()
+
+
+def get_frequency_sketch() -> FrequencySketch:
+    global _sketch
+    if _sketch is None:
+        with _sketch_lock:
+            if _sketch is None:
+                _sketch = FrequencySketch()
+    return _sketch
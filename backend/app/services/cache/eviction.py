@@ -3,18 +3,24 @@
 Supports LFRU (default), LRU, and LFU eviction policies.
 Per-array: each array has independent eviction.
 
-LFRU scoring: score = access_count * recency_weight
-  recency_weight = 1.0 / (1 + hours_since_last_access)
-  Lowest score = evict first.
+LFRU scoring: exponentially decayed hit count, stored as the indexed
+``SSDCacheEntry.eviction_priority`` column (see ``lfru_priority``) and
+refreshed on insert and on each access-stats flush. Lowest = evict first.
+Candidates for every policy are read in index order, in batches, until
+enough bytes are covered — no full-table scan.
+
+Admission (TinyLFU): when a new file does not fit, it only displaces the
+entries it would need to evict if it has been read more often than each
+of them recently (``admission.FrequencySketch``).
 """
 import logging
-from datetime import datetime, timezone
-from typing import List
+from typing import List, Optional
 
 from sqlalchemy.orm import Session
-from sqlalchemy import asc
+from sqlalchemy import asc, tuple_
 
 from app.models.ssd_file_cache import SSDCacheEntry, SSDCacheConfig
+from app.services.cache.admission import get_frequency_sketch
 
 logger = logging.getLogger(__name__)
 
@@ -25,6 +31,8 @@ class EvictionManager:
     # Trigger eviction when usage > 95%, target: reduce to 80%
     HIGH_WATERMARK = 0.95
     LOW_WATERMARK = 0.80
+    # Candidates are fetched in index order this many rows at a time
+    BATCH_SIZE = 256
 
     def __init__(self, db: Session, array_name: str = "md0"):
         self.db = db
@@ -32,11 +40,7 @@ class EvictionManager:
 
     def needs_eviction(self) -> bool:
         """Check if cache usage exceeds high watermark."""
-        config = (
-            self.db.query(SSDCacheConfig)
-            .filter(SSDCacheConfig.array_name == self.array_name)
-            .first()
-        )
+        config = self._get_config()
         if not config:
             return False
         current = int(config.current_size_bytes)
@@ -69,50 +73,8 @@ class EvictionManager:
         if accumulated >= needed_bytes:
             return invalid
 
-        # Then: get valid entries ordered by eviction priority
-        base_filter = [
-            SSDCacheEntry.array_name == self.array_name,
-            SSDCacheEntry.is_valid.is_(True),
-        ]
-
-        if policy == "lru":
-            query = (
-                self.db.query(SSDCacheEntry)
-                .filter(*base_filter)
-                .order_by(asc(SSDCacheEntry.last_accessed))
-            )
-        elif policy == "lfu":
-            query = (
-                self.db.query(SSDCacheEntry)
-                .filter(*base_filter)
-                .order_by(asc(SSDCacheEntry.access_count))
-            )
-        else:
-            # LFRU: we need to score in Python since the formula is complex
-            query = (
-                self.db.query(SSDCacheEntry)
-                .filter(*base_filter)
-            )
-
-        valid_entries = query.all()
-
-        if policy == "lfru":
-            now = datetime.now(timezone.utc)
-            scored = []
-            for e in valid_entries:
-                last = e.last_accessed
-                if last and last.tzinfo is None:
-                    last = last.replace(tzinfo=timezone.utc)
-                hours_ago = (now - last).total_seconds() / 3600 if last else 999
-                recency_weight = 1.0 / (1 + hours_ago)
-                score = int(e.access_count) * recency_weight
-                scored.append((score, e))
-            scored.sort(key=lambda x: x[0])
-            valid_entries = [e for _, e in scored]
-
-        # Collect enough entries to free needed_bytes
         candidates = list(invalid)
-        for entry in valid_entries:
+        for entry in self._iter_valid_ordered(policy):
             if accumulated >= needed_bytes:
                 break
             candidates.append(entry)
@@ -120,6 +82,86 @@ class EvictionManager:
 
         return candidates
 
+    def _iter_valid_ordered(self, policy: str):
+        """Yield valid entries in eviction order, one index-range batch at a time.
+
+        Each batch resumes after the last row's sort key (keyset), so it
+        seeks into the index instead of skipping the rows already read.
+        """
+        if policy == "lru":
+            keys = (SSDCacheEntry.last_accessed, SSDCacheEntry.id)
+        elif policy == "lfu":
+            keys = (SSDCacheEntry.access_count, SSDCacheEntry.last_accessed, SSDCacheEntry.id)
+        else:
+            keys = (SSDCacheEntry.eviction_priority, SSDCacheEntry.id)
+
+        query = (
+            self.db.query(SSDCacheEntry)
+            .filter(
+                SSDCacheEntry.array_name == self.array_name,
+                SSDCacheEntry.is_valid.is_(True),
+            )
+            .order_by(*(asc(key) for key in keys))
+        )
+        batch_query = query
+        while True:
+            batch = batch_query.limit(self.BATCH_SIZE).all()
+            yield from batch
+            if len(batch) < self.BATCH_SIZE:
+                return
+            last = batch[-1]
+            # The id tie-breaker makes the key unique (and the columns are NOT NULL)
+            batch_query = query.filter(
+                tuple_(*keys) > tuple_(*(getattr(last, key.key) for key in keys))
+            )
+
+    def admit(
+        self, cache_service, source_path: str, file_size: int
+    ) -> bool:
+        """TinyLFU admission for a file that does not fit into the cache.
+
+        Picks the victims the configured policy would evict to make room and
+        admits the newcomer only if its recent read frequency beats every
+        valid victim's. On admission the victims are deleted immediately.
+        """
+        config = self._get_config()
+        if not config:
+            return False
+        max_size = int(config.max_size_bytes)
+        if file_size > max_size:
+            return False
+        needed = int(config.current_size_bytes) + file_size - max_size
+        if needed <= 0:
+            return True
+
+        policy = str(config.eviction_policy) or "lfru"
+        victims = self.get_eviction_candidates(policy, needed)
+        if sum(int(v.file_size_bytes) for v in victims) < needed:
+            return False
+
+        sketch = get_frequency_sketch()
+        candidate_freq = sketch.estimate(self.array_name, source_path)
+        for victim in victims:
+            if not victim.is_valid:
+                continue
+            if sketch.estimate(self.array_name, str(victim.source_path)) >= candidate_freq:
+                logger.debug(
+                    "TinyLFU rejected %s (freq=%d) for array %s",
+                    source_path, candidate_freq, self.array_name,
+                )
+                return False
+
+        for victim in victims:
+            cache_service.delete_cache_file(victim)
+        return True
+
+    def _get_config(self) -> Optional[SSDCacheConfig]:
+        return (
+            self.db.query(SSDCacheConfig)
+            .filter(SSDCacheConfig.array_name == self.array_name)
+            .first()
+        )
+
     def run_eviction(self, cache_service) -> dict:
         """
         Run one eviction cycle.
@@ -129,11 +171,7 @@ class EvictionManager:
 
         Returns summary dict with freed_bytes, deleted_count.
         """
-        config = (
-            self.db.query(SSDCacheConfig)
-            .filter(SSDCacheConfig.array_name == self.array_name)
-            .first()
-        )
+        config = self._get_config()
         if not config:
             return {"freed_bytes": 0, "deleted_count": 0}
 
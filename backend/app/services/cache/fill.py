@@ -0,0 +1,239 @@
+"""SSD cache-fill pipeline.
+
+Downloads that miss the SSD cache hand the file to this pipeline instead of
+spawning an ad-hoc copy task per request. Per worker it provides:
+
+- a bounded queue (full queue = the fill is dropped; it will be offered
+  again on the next miss),
+- de-duplication of files already queued or being filled (across workers
+  the ``.part`` file lock in ``fill_io`` does the same),
+- a shared ``ByteBudget`` so fills stay under a configurable HDD read rate,
+- readahead for sequential media: opening episode N of a folder queues the
+  next file of the same type in natural sort order.
+"""
+from __future__ import annotations
+
+import asyncio
+import logging
+import os
+import re
+import threading
+from dataclasses import dataclass
+from pathlib import Path, PurePosixPath
+from typing import Optional
+
+from app.core.config import settings
+from app.services.cache.fill_io import ByteBudget
+
+logger = logging.getLogger(__name__)
+
+# Extensions that are usually consumed in folder order (series, albums, audiobooks)
+SEQUENTIAL_MEDIA_EXTENSIONS = frozenset({
+    ".mkv", ".mp4", ".m4v", ".avi", ".mov", ".webm", ".ts", ".wmv",
+    ".mp3", ".flac", ".m4a", ".m4b", ".ogg", ".opus", ".wav", ".aac",
+})
+
+_NATURAL_SPLIT = re.compile(r"(\d+)")
+
+
+def _natural_key(name: str) -> list:
+    return [int(part) if part.isdigit() else part.casefold() for part in _NATURAL_SPLIT.split(name)]
+
+
+def next_in_series(file_path: Path) -> Optional[Path]:
+    """The file after *file_path* in its folder, if both are sequential media."""
+    suffix = file_path.suffix.lower()
+    if suffix not in SEQUENTIAL_MEDIA_EXTENSIONS:
+        return None
+    try:
+        with os.scandir(file_path.parent) as it:
+            siblings = [
+                entry.name for entry in it
+                if entry.name.lower().endswith(suffix) and entry.is_file(follow_symlinks=False)
+            ]
+    except OSError:
+        return None
+    siblings.sort(key=_natural_key)
+    try:
+        position = siblings.index(file_path.name)
+    except ValueError:
+        return None
+    if position + 1 >= len(siblings):
+        return None
+    return file_path.parent / siblings[position + 1]
+
+
+@dataclass(frozen=True)
+class FillJob:
+    array_name: str
+    resource_path: str
+    file_path: Path
+    file_id: Optional[int] = None
+    # Readahead job: resolve and fill the *next* file instead of this one
+    prefetch_next: bool = False
+
+
+class CacheFillPipeline:
+    """Bounded, de-duplicated, bandwidth-limited cache population (per worker)."""
+
+    def __init__(
+        self,
+        *,
+        max_queue: int = 64,
+        concurrency: int = 1,
+        bytes_per_second: float = 0.0,
+    ) -> None:
+        self.max_queue = max_queue
+        self.concurrency = concurrency
+        self.budget = ByteBudget(bytes_per_second)
+        self._queue: Optional[asyncio.Queue] = None
+        self._loop: Optional[asyncio.AbstractEventLoop] = None
+        self._workers: list[asyncio.Task] = []
+        self._pending: set[tuple[str, str]] = set()
+        self._pending_lock = threading.Lock()
+
+    # ------------------------------------------------------------------
+    # Submission (event-loop thread)
+    # ------------------------------------------------------------------
+
+    def submit(
+        self,
+        resource_path: str,
+        file_path: Path,
+        *,
+        file_id: Optional[int] = None,
+        array_name: str = "md0",
+    ) -> bool:
+        """Queue a fill. Returns False if it was a duplicate or the queue is full."""
+        return self._enqueue(FillJob(array_name, resource_path, Path(file_path), file_id))
+
+    def submit_readahead(
+        self, resource_path: str, file_path: Path, *, array_name: str = "md0"
+    ) -> bool:
+        """Queue the successor of a sequential media file (resolved off-loop)."""
+        if Path(file_path).suffix.lower() not in SEQUENTIAL_MEDIA_EXTENSIONS:
+            return False
+        return self._enqueue(
+            FillJob(array_name, resource_path, Path(file_path), prefetch_next=True)
+        )
+
+    def _claim(self, array_name: str, resource_path: str) -> bool:
+        with self._pending_lock:
+            key = (array_name, resource_path)
+            if key in self._pending:
+                return False
+            self._pending.add(key)
+            return True
+
+    def _release(self, array_name: str, resource_path: str) -> None:
+        with self._pending_lock:
+            self._pending.discard((array_name, resource_path))
+
+    def _enqueue(self, job: FillJob) -> bool:
+        try:
+            loop = asyncio.get_running_loop()
+        except RuntimeError:
+            return False
+        self._ensure_workers(loop)
+        assert self._queue is not None
+        if not job.prefetch_next and not self._claim(job.array_name, job.resource_path):
+            return False
+        try:
+            self._queue.put_nowait(job)
+        except asyncio.QueueFull:
+            if not job.prefetch_next:
+                self._release(job.array_name, job.resource_path)
+            logger.debug("Cache fill queue full, dropping %s", job.resource_path)
+            return False
+        return True
+
+    def _ensure_workers(self, loop: asyncio.AbstractEventLoop) -> None:
+        if self._queue is None or self._loop is not loop:
+            # First use, or a new event loop (e.g. a fresh TestClient)
+            self._queue = asyncio.Queue(maxsize=self.max_queue)
+            self._loop = loop
+            self._workers = []
+        self._workers = [w for w in self._workers if not w.done()]
+        while len(self._workers) < self.concurrency:
+            self._workers.append(
+                asyncio.create_task(self._worker(), name="ssd_cache_fill")
+            )
+
+    # ------------------------------------------------------------------
+    # Workers
+    # ------------------------------------------------------------------
+
+    async def _worker(self) -> None:
+        queue = self._queue
+        assert queue is not None
+        while True:
+            job = await queue.get()
+            try:
+                await asyncio.to_thread(self.run_job, job)
+            except Exception:
+                logger.debug("Cache fill failed for %s", job.resource_path, exc_info=True)
+            finally:
+                queue.task_done()
+
+    def run_job(self, job: FillJob) -> Optional[Path]:
+        """Execute one job synchronously (worker thread)."""
+        if job.prefetch_next:
+            successor = next_in_series(job.file_path)
+            if successor is None:
+                return None
+            resource_path = str(PurePosixPath(job.resource_path).parent / successor.name)
+            if not self._claim(job.array_name, resource_path):
+                return None
+            job = FillJob(job.array_name, resource_path, successor)
+        try:
+            return self._fill(job)
+        finally:
+            self._release(job.array_name, job.resource_path)
+
+    def _fill(self, job: FillJob) -> Optional[Path]:
+        from app.core.database import SessionLocal
+        from app.services.cache.ssd_file_cache import SSDFileCacheService
+
+        db = SessionLocal()
+        try:
+            svc = SSDFileCacheService(db, job.array_name)
+            result = svc.cache_file(
+                job.resource_path, job.file_path, file_id=job.file_id, budget=self.budget,
+            )
+            db.commit()
+            return result
+        except Exception:
+            db.rollback()
+            raise
+        finally:
+            db.close()
+
+    async def join(self) -> None:
+        """Wait until everything queued so far has been processed (tests)."""
+        if self._queue is not None:
+            await self._queue.join()
+
+    async def shutdown(self) -> None:
+        workers, self._workers = self._workers, []
+        for task in workers:
+            task.cancel()
+        if workers:
+            await asyncio.gather(*workers, return_exceptions=True)
+        self._queue = None
+        self._loop = None
+        with self._pending_lock:
+            self._pending.clear()
+
+
+_pipeline: Optional[CacheFillPipeline] = None
+
+
+def get_cache_fill_pipeline() -> CacheFillPipeline:
+    global _pipeline
+    if _pipeline is None:
+        _pipeline = CacheFillPipeline(
+            max_queue=settings.ssd_file_cache_fill_queue_size,
+            concurrency=settings.ssd_file_cache_fill_concurrency,
+            bytes_per_second=settings.ssd_file_cache_fill_bandwidth_mb_s * 1024 * 1024,
+        )
+    return _pipeline
@@ -0,0 +1,169 @@
+"""Low-level copy primitives for SSD cache fills.
+
+``copy_file_budgeted`` moves a file from the HDD array to the SSD with
+``os.copy_file_range`` (in-kernel, no user-space buffers), paced by a
+``ByteBudget`` so cache fills can't starve foreground RAID reads. The copy
+lands in ``<dest>.part`` and is renamed into place only when complete; the
+``.part`` file is ``flock``-ed for the duration, which is also how two
+workers racing to fill the same file find out about each other. Callers that
+need a checksum pass a ``hashlib`` object and get the digest of exactly the
+bytes written, read back from the SSD copy (still in page cache) rather than
+pulling the source through user space.
+"""
+from __future__ import annotations
+
+import logging
+import os
+import shutil
+import threading
+import time
+from pathlib import Path
+from typing import Any, Optional
+
+try:  # pragma: no cover - platform dependent
+    import fcntl
+except ImportError:  # Windows dev mode
+    fcntl = None  # type: ignore[assignment]
+
+logger = logging.getLogger(__name__)
+
+# Bytes copied per call (and per budget debit). Small enough that the
+# budget paces smoothly and the source's page cache can be dropped behind us.
+COPY_SLICE_BYTES = 8 * 1024 * 1024
+_FALLBACK_BLOCK = 1024 * 1024
+
+
+class ByteBudget:
+    """Blocking token bucket in bytes/second (``rate <= 0`` = unlimited)."""
+
+    def __init__(self, rate: float, burst: Optional[float] = None) -> None:
+        self.rate = float(rate)
+        self.burst = float(burst if burst is not None else max(rate, COPY_SLICE_BYTES))
+        self._tokens = self.burst
+        self._stamp = time.monotonic()
+        self._lock = threading.Lock()
+
+    def consume(self, nbytes: int) -> None:
+        if self.rate <= 0:
+            return
+        with self._lock:
+            now = time.monotonic()
+            self._tokens = min(self.burst, self._tokens + (now - self._stamp) * self.rate)
+            self._stamp = now
+            self._tokens -= nbytes
+            deficit = -self._tokens
+        if deficit > 0:
+            time.sleep(deficit / self.rate)
+
+
+def _fadvise(fd: int, offset: int, length: int, advice_name: str) -> None:
+    advice = getattr(os, advice_name, None)
+    if advice is None or not hasattr(os, "posix_fadvise"):
+        return
+    try:
+        os.posix_fadvise(fd, offset, length, advice)
+    except OSError:
+        pass
+
+
+def _copy_range(src_fd: int, dst_fd: int, offset: int, count: int) -> int:
+    """Copy up to *count* bytes at *offset*; returns bytes copied (0 = EOF)."""
+    if hasattr(os, "copy_file_range"):
+        try:
+            return os.copy_file_range(src_fd, dst_fd, count, offset, offset)
+        except OSError:
+            pass  # EXDEV/ENOSYS/EINVAL on older kernels or odd filesystems
+    copied = 0
+    while copied < count:
+        block = os.pread(src_fd, min(_FALLBACK_BLOCK, count - copied), offset + copied)
+        if not block:
+            break
+        view = memoryview(block)
+        while view:
+            written = os.pwrite(dst_fd, view, offset + copied)
+            view = view[written:]
+            copied += written
+    return copied
+
+
+def _hash_file(path: Path, digest: Any) -> None:
+    with open(path, "rb", buffering=0) as f:
+        while True:
+            block = f.read(_FALLBACK_BLOCK)
+            if not block:
+                break
+            digest.update(block)
+
+
+def _lock_part(part: Path) -> Optional[int]:
+    """Open and ``flock`` *part*; returns the fd, or None if another fill holds it.
+
+    The lock is only ours if *part* still names the inode we locked: between
+    our open and our flock the previous holder may have renamed its ``.part``
+    into place (our fd would then point at the live cache file) or a new fill
+    may have replaced it. Either way, start over on the current path.
+    """
+    while True:
+        fd = os.open(part, os.O_WRONLY | os.O_CREAT, 0o600)
+        if fcntl is None:
+            return fd
+        try:
+            fcntl.flock(fd, fcntl.LOCK_EX | fcntl.LOCK_NB)
+        except BlockingIOError:
+            os.close(fd)
+            return None
+        try:
+            current = os.stat(part)
+        except FileNotFoundError:
+            current = None
+        mine = os.fstat(fd)
+        if current is not None and (current.st_dev, current.st_ino) == (mine.st_dev, mine.st_ino):
+            return fd
+        os.close(fd)
+
+
+def copy_file_budgeted(
+    src: Path, dst: Path, budget: Optional[ByteBudget] = None, digest: Any = None
+) -> bool:
+    """Copy *src* to *dst* atomically. Returns False if another fill holds *dst*.
+
+    Preserves mode and timestamps like ``shutil.copy2``. With *digest* (a
+    ``hashlib`` object) the finished copy is fed to it before the rename.
+    """
+    part = dst.with_name(dst.name + ".part")
+    out_fd = _lock_part(part)
+    if out_fd is None:
+        return False
+    try:
+        os.ftruncate(out_fd, 0)
+        try:
+            in_fd = os.open(src, os.O_RDONLY)
+            try:
+                size = os.fstat(in_fd).st_size
+                _fadvise(in_fd, 0, 0, "POSIX_FADV_SEQUENTIAL")
+                offset = 0
+                while offset < size:
+                    count = min(COPY_SLICE_BYTES, size - offset)
+                    if budget is not None:
+                        budget.consume(count)
+                    copied = _copy_range(in_fd, out_fd, offset, count)
+                    if copied <= 0:
+                        break  # source shrank under us
+                    # Cache fills shouldn't evict the foreground's page cache
+                    _fadvise(in_fd, offset, copied, "POSIX_FADV_DONTNEED")
+                    offset += copied
+            finally:
+                os.close(in_fd)
+            if digest is not None:
+                _hash_file(part, digest)
+            shutil.copystat(src, part)
+            os.replace(part, dst)
+        except BaseException:
+            try:
+                part.unlink()
+            except OSError:
+                pass
+            raise
+        return True
+    finally:
+        os.close(out_fd)
@@ -0,0 +1,401 @@
+"""Shared hot index for SSD file cache lookups.
+
+A fixed-size, open-addressed hash table in a memory-mapped file under the
+monitoring SHM directory (``/dev/shm/baluhost`` on Linux), shared by all
+Uvicorn workers. It maps ``(array_name, source_path)`` to the cached file
+location, so ``SSDFileCacheService.get_cached_path`` can answer a hit (or a
+recent miss) without touching PostgreSQL.
+
+Layout::
+
+    header (64 B)  magic "BHCI" | version | slot_count | slot_size | generation
+    slot[i]        seq u32 | key 16s | state u8 | pad | path_len u16 |
+                   source_mtime f64 | stamp f64 | entry_id u64 | size u64 |
+                   cache_path bytes (<= slot_size - 56)
+
+Readers are lock-free: each slot is guarded by a seqlock (``seq`` is odd
+while a write is in progress; a reader retries if it changes under it).
+Writers serialise on an ``flock`` of the index file, so every worker sees an
+invalidation as soon as it is written — no per-worker cache to go stale.
+
+The table is bounded: a key probes at most ``PROBE_WINDOW`` slots, and an
+insert that finds no free slot in its window replaces the oldest one.
+Anything that does not fit (paths longer than the slot) simply isn't
+indexed and falls back to the database. Every failure degrades to "not
+indexed" — the index can never block a download.
+"""
+from __future__ import annotations
+
+import hashlib
+import logging
+import mmap
+import os
+import struct
+import threading
+import time
+from dataclasses import dataclass
+from pathlib import Path
+from typing import Optional
+
+from app.core.config import settings
+from app.services.monitoring.shm import SHM_DIR
+
+try:  # pragma: no cover - platform dependent
+    import fcntl
+except ImportError:  # Windows dev mode: single process, a thread lock suffices
+    fcntl = None  # type: ignore[assignment]
+
+logger = logging.getLogger(__name__)
+
+_MAGIC = b"BHCI"
+_VERSION = 1
+_HEADER = struct.Struct("<4sIIIQ")
+_HEADER_SIZE = 64
+_SLOT = struct.Struct("<I16sBxHddQQ")
+_SEQ = struct.Struct("<I")
+
+SLOT_COUNT = 16384
+SLOT_SIZE = 512
+PROBE_WINDOW = 8
+MAX_PATH_BYTES = SLOT_SIZE - _SLOT.size
+
+# Slot states
+_EMPTY = 0
+_HIT = 1
+_MISS = 2
+_TOMBSTONE = 3
+_CONFIG = 4
+
+# Negative entries and config flags are re-validated against the DB after
+# this long; positive entries are invalidated explicitly but also expire so
+# an entry removed by an out-of-band tool can't live forever.
+MISS_TTL_SECONDS = 60.0
+CONFIG_TTL_SECONDS = 30.0
+HIT_TTL_SECONDS = 3600.0
+
+
+@dataclass(frozen=True)
+class HotIndexRecord:
+    """A decoded index slot."""
+
+    state: int
+    source_mtime: float
+    entry_id: int
+    file_size: int
+    cache_path: str
+
+    @property
+    def is_hit(self) -> bool:
+        return self.state == _HIT
+
+    @property
+    def is_miss(self) -> bool:
+        return self.state == _MISS
+
+
+def _default_index_path() -> Path:
+    # Keyed on the storage root so separate instances (and test workers)
+    # sharing /dev/shm never see each other's entries.
+    root = str(Path(settings.nas_storage_path).expanduser().resolve())
+    digest = hashlib.sha1(root.encode("utf-8")).hexdigest()[:12]
+    return SHM_DIR / f"ssd_cache_index-{digest}.bin"
+
+
+class SSDCacheHotIndex:
+    """Cross-worker mmap'd lookup table (see module docstring)."""
+
+    def __init__(
+        self,
+        path: Optional[Path] = None,
+        slot_count: int = SLOT_COUNT,
+        slot_size: int = SLOT_SIZE,
+    ) -> None:
+        self.path = path or _default_index_path()
+        self.slot_count = slot_count
+        self.slot_size = slot_size
+        self._size = _HEADER_SIZE + slot_count * slot_size
+        self._mm: Optional[mmap.mmap] = None
+        self._fd: Optional[int] = None
+        self._thread_lock = threading.Lock()
+        self._dirty = False
+        self._open()
+
+    # ------------------------------------------------------------------
+    # Setup
+    # ------------------------------------------------------------------
+
+    def _open(self) -> None:
+        try:
+            self.path.parent.mkdir(parents=True, exist_ok=True)
+            fd = os.open(self.path, os.O_RDWR | os.O_CREAT, 0o600)
+        except OSError as exc:
+            logger.warning("SSD cache hot index unavailable (%s): %s", self.path, exc)
+            return
+        self._fd = fd
+        try:
+            with self._write_lock():
+                if os.fstat(fd).st_size != self._size:
+                    os.ftruncate(fd, self._size)
+                self._mm = mmap.mmap(fd, self._size)
+                magic, version, slots, slot_size, _gen = _HEADER.unpack_from(self._mm, 0)
+                if (magic, version, slots, slot_size) != (
+                    _MAGIC, _VERSION, self.slot_count, self.slot_size,
+                ):
+                    self._mm[:] = bytes(self._size)
+                    _HEADER.pack_into(
+                        self._mm, 0, _MAGIC, _VERSION, self.slot_count, self.slot_size, 0,
+                    )
+        except (OSError, ValueError) as exc:
+            logger.warning("SSD cache hot index init failed: %s", exc)
+            self.close()
+
+    def close(self) -> None:
+        if self._mm is not None:
+            try:
+                self._mm.close()
+            except (BufferError, ValueError):
+                pass
+            self._mm = None
+        if self._fd is not None:
+            os.close(self._fd)
+            self._fd = None
+
+    @property
+    def available(self) -> bool:
+        return self._mm is not None
+
+    class _Lock:
+        def __init__(self, index: "SSDCacheHotIndex") -> None:
+            self._index = index
+
+        def __enter__(self) -> None:
+            self._index._thread_lock.acquire()
+            if fcntl is not None and self._index._fd is not None:
+                fcntl.flock(self._index._fd, fcntl.LOCK_EX)
+
+        def __exit__(self, *exc) -> None:
+            if fcntl is not None and self._index._fd is not None:
+                fcntl.flock(self._index._fd, fcntl.LOCK_UN)
+            self._index._thread_lock.release()
+
+    def _write_lock(self) -> "SSDCacheHotIndex._Lock":
+        return SSDCacheHotIndex._Lock(self)
+
+    # ------------------------------------------------------------------
+    # Slot helpers
+    # ------------------------------------------------------------------
+
+    @staticmethod
+    def _key(kind: str, array_name: str, source_path: str) -> bytes:
+        raw = f"{kind}\x00{array_name}\x00{source_path}".encode("utf-8", "surrogateescape")
+        return hashlib.blake2b(raw, digest_size=16).digest()
+
+    def _slot_offsets(self, key: bytes):
+        start = int.from_bytes(key[:8], "little") % self.slot_count
+        for i in range(PROBE_WINDOW):
+            yield _HEADER_SIZE + ((start + i) % self.slot_count) * self.slot_size
+
+    def _read_slot(self, offset: int) -> Optional[tuple]:
+        mm = self._mm
+        assert mm is not None
+        for _ in range(4):
+            (seq1,) = _SEQ.unpack_from(mm, offset)
+            if seq1 & 1:
+                continue  # writer in progress
+            raw = mm[offset:offset + self.slot_size]
+            (seq2,) = _SEQ.unpack_from(mm, offset)
+            if seq1 == seq2:
+                head = _SLOT.unpack_from(raw, 0)
+                path_len = head[3]
+                path = raw[_SLOT.size:_SLOT.size + path_len]
+                return head + (path,)
+        return None  # contended — treat as not indexed
+
+    def _write_slot(
+        self,
+        offset: int,
+        key: bytes,
+        state: int,
+        source_mtime: float = 0.0,
+        entry_id: int = 0,
+        file_size: int = 0,
+        path: bytes = b"",
+    ) -> None:
+        mm = self._mm
+        assert mm is not None
+        (seq,) = _SEQ.unpack_from(mm, offset)
+        _SEQ.pack_into(mm, offset, (seq + 1) | 1)
+        _SLOT.pack_into(
+            mm, offset, (seq + 1) | 1, key, state, len(path),
+            source_mtime, time.time(), entry_id, file_size,
+        )
+        mm[offset + _SLOT.size:offset + _SLOT.size + len(path)] = path
+        _SEQ.pack_into(mm, offset, ((seq + 1) | 1) + 1)
+        self._dirty = True
+
+    def _lookup(self, key: bytes, ttl_for_state) -> Optional[HotIndexRecord]:
+        if self._mm is None:
+            return None
+        try:
+            for offset in self._slot_offsets(key):
+                slot = self._read_slot(offset)
+                if slot is None:
+                    return None
+                _seq, slot_key, state, _plen, mtime, stamp, entry_id, size, path = slot
+                if state == _EMPTY:
+                    return None
+                if slot_key != key or state == _TOMBSTONE:
+                    continue
+                if time.time() - stamp > ttl_for_state(state):
+                    return None
+                return HotIndexRecord(
+                    state=state,
+                    source_mtime=mtime,
+                    entry_id=entry_id,
+                    file_size=size,
+                    cache_path=path.decode("utf-8", "surrogateescape"),
+                )
+        except (ValueError, struct.error):
+            return None
+        return None
+
+    def _store(self, key: bytes, state: int, **fields) -> None:
+        if self._mm is None:
+            return
+        try:
+            with self._write_lock():
+                target = None
+                oldest_offset, oldest_stamp = None, float("inf")
+                for offset in self._slot_offsets(key):
+                    _seq, slot_key, slot_state, _pl, _mt, stamp, _id, _sz = _SLOT.unpack_from(
+                        self._mm, offset,
+                    )
+                    if slot_key == key and slot_state != _EMPTY:
+                        target = offset
+                        break
+                    if slot_state in (_EMPTY, _TOMBSTONE):
+                        if target is None:
+                            target = offset
+                        if slot_state == _EMPTY:
+                            break
+                    elif stamp < oldest_stamp:
+                        oldest_offset, oldest_stamp = offset, stamp
+                if target is None:
+                    target = oldest_offset
+                if target is not None:
+                    self._write_slot(target, key, state, **fields)
+        except (OSError, ValueError, struct.error) as exc:
+            logger.debug("SSD cache hot index write failed: %s", exc)
+
+    def _remove(self, key: bytes) -> None:
+        if self._mm is None:
+            return
+        try:
+            with self._write_lock():
+                for offset in self._slot_offsets(key):
+                    _seq, slot_key, state, *_rest = _SLOT.unpack_from(self._mm, offset)
+                    if state == _EMPTY:
+                        return
+                    if slot_key == key and state != _TOMBSTONE:
+                        self._write_slot(offset, key, _TOMBSTONE)
+                        return
+        except (OSError, ValueError, struct.error) as exc:
+            logger.debug("SSD cache hot index remove failed: %s", exc)
+
+    @staticmethod
+    def _ttl(state: int) -> float:
+        if state == _MISS:
+            return MISS_TTL_SECONDS
+        if state == _CONFIG:
+            return CONFIG_TTL_SECONDS
+        return HIT_TTL_SECONDS
+
+    # ------------------------------------------------------------------
+    # Public API
+    # ------------------------------------------------------------------
+
+    def lookup(self, array_name: str, source_path: str) -> Optional[HotIndexRecord]:
+        """Return the indexed hit/miss for a file, or ``None`` if unknown."""
+        return self._lookup(self._key("e", array_name, source_path), self._ttl)
+
+    def put_hit(
+        self,
+        array_name: str,
+        source_path: str,
+        *,
+        cache_path: str,
+        source_mtime: float,
+        entry_id: int,
+        file_size: int,
+    ) -> None:
+        encoded = cache_path.encode("utf-8", "surrogateescape")
+        key = self._key("e", array_name, source_path)
+        if len(encoded) > self.slot_size - _SLOT.size:
+            self._remove(key)  # too long to index; never serve a stale slot
+            return
+        self._store(
+            key, _HIT, source_mtime=source_mtime, entry_id=entry_id,
+            file_size=file_size, path=encoded,
+        )
+
+    def put_miss(self, array_name: str, source_path: str, source_mtime: float) -> None:
+        self._store(self._key("e", array_name, source_path), _MISS, source_mtime=source_mtime)
+
+    def remove(self, array_name: str, source_path: str) -> None:
+        self._remove(self._key("e", array_name, source_path))
+
+    def get_enabled(self, array_name: str) -> Optional[bool]:
+        """Cached ``SSDCacheConfig.is_enabled`` for *array_name* (``None`` = unknown)."""
+        record = self._lookup(self._key("c", array_name, ""), self._ttl)
+        if record is None or record.state != _CONFIG:
+            return None
+        return bool(record.entry_id)
+
+    def put_enabled(self, array_name: str, enabled: bool) -> None:
+        self._store(self._key("c", array_name, ""), _CONFIG, entry_id=int(enabled))
+
+    def remove_config(self, array_name: str) -> None:
+        self._remove(self._key("c", array_name, ""))
+
+    def clear(self) -> None:
+        """Drop every slot and bump the generation counter."""
+        if self._mm is None:
+            return
+        with self._write_lock():
+            *_head, generation = _HEADER.unpack_from(self._mm, 0)
+            self._mm[_HEADER_SIZE:] = bytes(self._size - _HEADER_SIZE)
+            _HEADER.pack_into(
+                self._mm, 0, _MAGIC, _VERSION, self.slot_count, self.slot_size, generation + 1,
+            )
+        self._dirty = False
+
+    def clear_if_dirty(self) -> None:
+        """``clear()`` only if this process wrote to the index (cheap test reset)."""
+        if self._dirty:
+            self.clear()
+
+
+# ---------------------------------------------------------------------------
+# Singleton
+# ---------------------------------------------------------------------------
+_index: Optional[SSDCacheHotIndex] = None
+_index_lock = threading.Lock()
+
+
+def get_hot_index() -> SSDCacheHotIndex:
+    global _index
+    if _index is None:
+        with _index_lock:
+            if _index is None:
+                _index = SSDCacheHotIndex()
+    return _index
+
+
+def reset_hot_index(path: Optional[Path] = None) -> SSDCacheHotIndex:
+    """Replace the singleton (tests point it at a temp file)."""
+    global _index
+    with _index_lock:
+        if _index is not None:
+            _index.close()
+        _index = SSDCacheHotIndex(path)
+    return _index
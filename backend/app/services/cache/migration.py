@@ -15,6 +15,7 @@ from sqlalchemy.orm import Session
 from app.core.database import SessionLocal
 from app.models.migration_job import MigrationJob
 from app.models.vcl import VersionBlob
+from app.services.versioning.codecs import STORED_SUFFIXES
 
 logger = logging.getLogger(__name__)
 
@@ -26,6 +27,14 @@ _PROGRESS_FLUSH_INTERVAL = 5.0  # seconds
 _PROGRESS_FLUSH_FILES = 10  # or every N files
 
 
+def _blob_files(blobs_dir: Path) -> list[Path]:
+    """Blob, chunk and dictionary files in *blobs_dir* (any codec)."""
+    return sorted(
+        f for f in blobs_dir.iterdir()
+        if f.suffix in STORED_SUFFIXES and f.is_file()
+    )
+
+
 class MigrationService:
     """Manages VCL data migration jobs (copy, verify, cleanup)."""
 
@@ -113,7 +122,7 @@ class MigrationService:
             if not dry_run:
                 dest_blobs.mkdir(parents=True, exist_ok=True)
 
-            blob_files = sorted(source_blobs.glob("*.gz"))
+            blob_files = _blob_files(source_blobs)
             total = len(blob_files)
             total_bytes = 0
             # Pre-scan total bytes
@@ -270,7 +279,11 @@ class MigrationService:
             dest_prefix = job.dest_path
             blobs = (
                 db.query(VersionBlob)
-                .filter(VersionBlob.storage_path.like(f"{dest_prefix}%"))
+                .filter(
+                    VersionBlob.storage_path.like(f"{dest_prefix}%"),
+                    # chunked blobs point at the blobs directory, not a file
+                    VersionBlob.storage_format != "chunked",
+                )
                 .all()
             )
 
@@ -395,9 +408,11 @@ class MigrationService:
                 db.commit()
                 return
 
-            dest_blobs = Path(str(first_blob.storage_path)).parent
+            dest_blobs = Path(str(first_blob.storage_path))
+            if first_blob.storage_format != "chunked":
+                dest_blobs = dest_blobs.parent
 
-            blob_files = sorted(source_blobs.glob("*.gz"))
+            blob_files = _blob_files(source_blobs)
             total = len(blob_files)
             job.total_files = total
             db.commit()
@@ -502,8 +517,7 @@ class MigrationService:
             return
 
         source_size = sum(
-            f.stat().st_size for f in source_blobs.glob("*.gz")
-            if f.is_file()
+            f.stat().st_size for f in _blob_files(source_blobs)
         )
         dest_usage = shutil.disk_usage(dest)
         headroom = int(source_size * 1.05)  # 5% headroom
@@ -6,38 +6,38 @@ file delivery. Per-array: each RAID array has its own config and entries.
 """
 import hashlib
 import logging
+import os
 import shutil
 from datetime import datetime, timezone
 from pathlib import Path, PurePosixPath
 from typing import Optional, List
 
-from cachetools import TTLCache
 from sqlalchemy.orm import Session
 from sqlalchemy import update as sql_update
 from sqlalchemy.exc import IntegrityError
 
-from app.models.ssd_file_cache import SSDCacheEntry, SSDCacheConfig
+from app.models.ssd_file_cache import SSDCacheEntry, SSDCacheConfig, lfru_priority
 from app.core.config import settings
+from app.core.tracing import traced
+from app.services.cache.access_stats import get_access_stats
+from app.services.cache.admission import get_frequency_sketch
+from app.services.cache.eviction import EvictionManager
+from app.services.cache.fill_io import ByteBudget, copy_file_budgeted
+from app.services.cache.hot_index import get_hot_index
 
 logger = logging.getLogger(__name__)
 
 
-def _default_cache_path(array_name: str) -> str:
-    """Return the default cache path, dev-mode aware."""
+def cache_base_path() -> str:
+    """Directory holding the per-array default cache paths, dev-mode aware."""
     if settings.is_dev_mode:
-        return str(Path(settings.nas_storage_path).resolve() / ".cache" / "filecache" / array_name)
-    return f"/mnt/cache-vcl/filecache/{array_name}"
+        return str(Path(settings.nas_storage_path).resolve() / ".cache" / "filecache")
+    return "/mnt/cache-vcl/filecache"
 
-# In-memory hot-path cache to avoid DB hit on every file read
-_path_cache: TTLCache = TTLCache(maxsize=10_000, ttl=60)
 
-
-def _sha256_file(path: Path) -> str:
-    sha256 = hashlib.sha256()
-    with open(path, "rb") as f:
-        for chunk in iter(lambda: f.read(65536), b""):
-            sha256.update(chunk)
-    return sha256.hexdigest()
+def _default_cache_path(array_name: str) -> str:
+    """Return the default cache path, dev-mode aware."""
+    return f"{cache_base_path()}/{array_name}"
 
 
 class SSDFileCacheService:
@@ -90,8 +90,12 @@ class SSDFileCacheService:
         return config
 
     def is_cache_enabled(self) -> bool:
-        config = self.get_config()
-        return bool(config.is_enabled)
+        index = get_hot_index()
+        enabled = index.get_enabled(self.array_name)
+        if enabled is None:
+            enabled = bool(self.get_config().is_enabled)
+            index.put_enabled(self.array_name, enabled)
+        return enabled
 
     @classmethod
     def get_all_configs(cls, db: Session) -> List[SSDCacheConfig]:
@@ -103,35 +107,49 @@ class SSDFileCacheService:
     def should_cache_file(self, file_size: int) -> bool:
         """Check if a file is eligible for caching based on config limits."""
         config = self.get_config()
+        return self._is_eligible(config, file_size) and self._has_capacity(config, file_size)
+
+    @staticmethod
+    def _is_eligible(config: SSDCacheConfig, file_size: int) -> bool:
         if not config.is_enabled:
             return False
         if file_size < int(config.min_file_size_bytes):
             return False
         if file_size > int(config.max_file_size_bytes):
             return False
-        # Check if we have capacity
+        return True
+
+    @staticmethod
+    def _has_capacity(config: SSDCacheConfig, file_size: int) -> bool:
         current = int(config.current_size_bytes)
         max_size = int(config.max_size_bytes)
-        if current + file_size > max_size:
-            return False
-        return True
+        return current + file_size <= max_size
 
     # ========== Cache Lookup ==========
 
+    @traced("get_cached_path")
     def get_cached_path(
         self, source_path: str, source_mtime: float
     ) -> Optional[Path]:
         """
         Look up a file in the cache.
 
-        Returns SSD path if cache hit (valid + mtime matches).
-        Increments access_count on hit. Returns None on miss.
+        Returns SSD path if cache hit (valid + mtime matches), None on miss.
+
+        Answered from the shared hot index when possible, so a hit costs no
+        database round trip. Hit/miss accounting is accumulated in memory and
+        persisted by ``access_stats.run_flush_loop``.
         """
-        cache_key = (self.array_name, source_path, source_mtime)
-        cached = _path_cache.get(cache_key)
-        if cached is not None:
-            # Fast path: in-memory hit — still update DB stats asynchronously
-            return Path(cached) if cached else None
+        get_frequency_sketch().increment(self.array_name, source_path)
+        index = get_hot_index()
+        record = index.lookup(self.array_name, source_path)
+        if record is not None and record.source_mtime == source_mtime:
+            if record.is_miss:
+                self._record_miss()
+                return None
+            if record.is_hit and os.path.exists(record.cache_path):
+                self._record_hit(record.entry_id, record.file_size)
+                return Path(record.cache_path)
 
         entry = (
             self.db.query(SSDCacheEntry)
@@ -144,7 +162,7 @@ class SSDFileCacheService:
         )
 
         if not entry:
-            _path_cache[cache_key] = ""
+            index.put_miss(self.array_name, source_path, source_mtime)
             self._record_miss()
             return None
 
@@ -152,31 +170,26 @@ class SSDFileCacheService:
         if float(entry.source_mtime) != source_mtime:
             # Source changed — invalidate
             self.invalidate_entry(source_path)
-            _path_cache[cache_key] = ""
+            index.put_miss(self.array_name, source_path, source_mtime)
             self._record_miss()
             return None
 
         cached_path = Path(str(entry.cache_path))
         if not cached_path.exists():
             self.invalidate_entry(source_path)
-            _path_cache[cache_key] = ""
+            index.put_miss(self.array_name, source_path, source_mtime)
             self._record_miss()
             return None
 
-        # Cache hit — update access tracking
-        now = datetime.now(timezone.utc)
-        self.db.execute(
-            sql_update(SSDCacheEntry)
-            .where(SSDCacheEntry.id == entry.id)
-            .values(
-                access_count=SSDCacheEntry.access_count + 1,
-                last_accessed=now,
-            )
+        index.put_hit(
+            self.array_name,
+            source_path,
+            cache_path=str(cached_path),
+            source_mtime=source_mtime,
+            entry_id=int(entry.id),
+            file_size=int(entry.file_size_bytes),
         )
-        self._record_hit(int(entry.file_size_bytes))
-        self.db.flush()
-
-        _path_cache[cache_key] = str(cached_path)
+        self._record_hit(int(entry.id), int(entry.file_size_bytes))
         return cached_path
 
     # ========== Cache Population ==========
@@ -186,43 +199,47 @@ class SSDFileCacheService:
         source_path: str,
         source_abs_path: Path,
         file_id: Optional[int] = None,
+        budget: Optional[ByteBudget] = None,
     ) -> Optional[Path]:
         """
         Copy a file from HDD to SSD cache.
 
         Returns SSD cache path on success, None if skipped/failed.
-        This method should be called in a background task.
+        Runs on a cache-fill worker thread (see ``fill.CacheFillPipeline``);
+        *budget* paces the HDD reads.
         """
         try:
             if not source_abs_path.exists() or not source_abs_path.is_file():
                 return None
 
             file_size = source_abs_path.stat().st_size
-            if not self.should_cache_file(file_size):
-                return None
-
-            # Skip if already cached
-            existing = (
-                self.db.query(SSDCacheEntry)
-                .filter(
-                    SSDCacheEntry.array_name == self.array_name,
-                    SSDCacheEntry.source_path == source_path,
-                )
-                .first()
-            )
-            if existing and bool(existing.is_valid):
-                return Path(str(existing.cache_path))
-
             config = self.get_config()
-            cache_root = Path(str(config.cache_path))
+            if not self._is_eligible(config, file_size):
+                return None
 
-            # Build cache destination — mirror source path structure
             # Reject path traversal
             rel = PurePosixPath(source_path)
             if ".." in rel.parts:
                 logger.warning("Rejected cache path with ..: %s", source_path)
                 return None
 
+            # Skip if already cached
+            existing = self._find_entry(source_path)
+            if existing and bool(existing.is_valid):
+                return Path(str(existing.cache_path))
+
+            if not self._has_capacity(config, file_size):
+                # Full: TinyLFU decides whether this file may displace others
+                if not EvictionManager(self.db, self.array_name).admit(
+                    self, source_path, file_size
+                ):
+                    return None
+                self.db.refresh(config)
+                # Our own stale (invalid) row may have been one of the victims
+                existing = self._find_entry(source_path)
+
+            # Build cache destination — mirror source path structure
+            cache_root = Path(str(config.cache_path))
             cache_dest = cache_root / rel
             cache_dest.parent.mkdir(parents=True, exist_ok=True)
 
@@ -239,11 +256,13 @@ class SSDFileCacheService:
             except OSError:
                 return None
 
-            # Copy file
-            shutil.copy2(str(source_abs_path), str(cache_dest))
-
-            # Compute checksum
-            checksum = _sha256_file(cache_dest)
+            # Copy file in-kernel, hashing the SSD copy; another worker may
+            # already be filling the same destination
+            digest = hashlib.sha256()
+            if not copy_file_budgeted(source_abs_path, cache_dest, budget, digest):
+                logger.debug("Cache fill for %s already in progress", source_path)
+                return None
+            checksum = digest.hexdigest()
             source_mtime = source_abs_path.stat().st_mtime
             now = datetime.now(timezone.utc)
 
@@ -262,6 +281,7 @@ class SSDFileCacheService:
                         is_valid=True,
                         access_count=0,
                         last_accessed=now,
+                        eviction_priority=lfru_priority(0, now),
                     )
                 )
                 size_delta = file_size - old_size
@@ -290,6 +310,15 @@ class SSDFileCacheService:
             )
             self.db.flush()
 
+            get_hot_index().put_hit(
+                self.array_name,
+                source_path,
+                cache_path=str(cache_dest),
+                source_mtime=source_mtime,
+                entry_id=int(existing.id if existing else entry.id),
+                file_size=file_size,
+            )
+
             logger.debug("Cached %s (%d bytes) for array %s", source_path, file_size, self.array_name)
             return cache_dest
 
@@ -297,6 +326,16 @@ class SSDFileCacheService:
             logger.exception("Failed to cache file %s", source_path)
             return None
 
+    def _find_entry(self, source_path: str) -> Optional[SSDCacheEntry]:
+        return (
+            self.db.query(SSDCacheEntry)
+            .filter(
+                SSDCacheEntry.array_name == self.array_name,
+                SSDCacheEntry.source_path == source_path,
+            )
+            .first()
+        )
+
     # ========== Invalidation ==========
 
     def invalidate_entry(self, source_path: str) -> None:
@@ -310,10 +349,7 @@ class SSDFileCacheService:
             .values(is_valid=False)
         )
         self.db.flush()
-        # Clear in-memory cache for this path
-        keys_to_remove = [k for k in _path_cache if k[1] == source_path]
-        for k in keys_to_remove:
-            _path_cache.pop(k, None)
+        get_hot_index().remove(self.array_name, source_path)
 
     def delete_cache_file(self, entry: SSDCacheEntry) -> int:
         """Delete physical cache file and DB record. Returns freed bytes."""
@@ -336,35 +372,21 @@ class SSDFileCacheService:
             )
         )
         self.db.flush()
-
-        # Clear in-memory cache
-        source = str(entry.source_path)
-        keys_to_remove = [k for k in _path_cache if k[1] == source]
-        for k in keys_to_remove:
-            _path_cache.pop(k, None)
+        get_hot_index().remove(self.array_name, str(entry.source_path))
 
         return freed
 
     # ========== Stats Helpers ==========
 
-    def _record_hit(self, file_size: int) -> None:
-        self.db.execute(
-            sql_update(SSDCacheConfig)
-            .where(SSDCacheConfig.array_name == self.array_name)
-            .values(
-                total_hits=SSDCacheConfig.total_hits + 1,
-                total_bytes_served_from_cache=(
-                    SSDCacheConfig.total_bytes_served_from_cache + file_size
-                ),
-            )
-        )
+    def _record_hit(self, entry_id: int, file_size: int) -> None:
+        get_access_stats().record_hit(self.array_name, entry_id, file_size)
 
     def _record_miss(self) -> None:
-        self.db.execute(
-            sql_update(SSDCacheConfig)
-            .where(SSDCacheConfig.array_name == self.array_name)
-            .values(total_misses=SSDCacheConfig.total_misses + 1)
-        )
+        get_access_stats().record_miss(self.array_name)
+
+    def flush_access_stats(self) -> None:
+        """Persist pending hit/miss counts through this service's session."""
+        get_access_stats().flush(self.db)
 
     def count_entries(self) -> tuple[int, int]:
         """Return (total_entries, valid_entries) for this array."""
@@ -429,7 +451,9 @@ class SSDFileCacheService:
             .values(**update_values)
         )
         self.db.commit()
+        get_hot_index().remove_config(self.array_name)
 
     def clear_in_memory_cache(self) -> None:
-        """Clear the in-memory TTL cache (for testing)."""
-        _path_cache.clear()
+        """Clear the shared hot index and pending access counts (for testing)."""
+        get_hot_index().clear()
+        get_access_stats().discard()
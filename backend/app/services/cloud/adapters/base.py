@@ -3,7 +3,7 @@ from abc import ABC, abstractmethod
 from dataclasses import dataclass, field
 from datetime import datetime
 from pathlib import Path
-from typing import Callable, Optional
+from typing import AsyncIterator, Callable, Optional
 
 
 @dataclass
@@ -33,7 +33,18 @@ class UploadResult:
 
 
 class CloudAdapter(ABC):
-    """Abstract interface for cloud storage providers."""
+    """Abstract interface for cloud storage providers.
+
+    The transfer engine (services/cloud/transfer.py) streams file contents
+    through stream_range/upload_stream when an adapter supports them, so it
+    can throttle, split large downloads into parts and resume; otherwise it
+    falls back to download_file/upload_file per file.
+    """
+
+    # stream_range/upload_stream are implemented
+    supports_streaming: bool = False
+    # stream_range honours offset/length (multipart downloads)
+    supports_ranges: bool = False
 
     @abstractmethod
     async def list_files(self, path: str = "/") -> list[CloudFile]:
@@ -65,6 +76,30 @@ class CloudAdapter(ABC):
         """Get total size in bytes of a file or folder. Returns None if unknown."""
         ...
 
+    async def list_tree(self, remote_path: str) -> list[CloudFile]:
+        """List all files (no directories) below a folder, recursively."""
+        result: list[CloudFile] = []
+        pending = [remote_path]
+        while pending:
+            for entry in await self.list_files(pending.pop()):
+                if entry.is_directory:
+                    pending.append(entry.path)
+                else:
+                    result.append(entry)
+        return result
+
+    def stream_range(
+        self, remote_path: str, offset: int = 0, length: Optional[int] = None
+    ) -> AsyncIterator[bytes]:
+        """Yield the bytes of a remote file, optionally only a range of it."""
+        raise NotImplementedError("Streaming not supported by this adapter")
+
+    async def upload_stream(
+        self, remote_path: str, size: int, chunks: AsyncIterator[bytes]
+    ) -> None:
+        """Upload a file of ``size`` bytes from an async chunk iterator."""
+        raise NotImplementedError("Streaming not supported by this adapter")
+
     async def get_file_count(self, remote_path: str) -> Optional[int]:
         """Get total number of files in a folder. Returns None if unknown."""
         return None
@@ -3,7 +3,7 @@ import asyncio
 import logging
 from datetime import datetime, timezone
 from pathlib import Path
-from typing import Callable, Optional
+from typing import AsyncIterator, Callable, Optional
 
 from app.services.cloud.adapters.base import CloudAdapter, CloudFile, DownloadResult, UploadResult
 
@@ -75,6 +75,9 @@ _MOCK_FS: dict[str, list[CloudFile]] = {
 class DevCloudAdapter(CloudAdapter):
     """Mock adapter for development without real cloud credentials."""
 
+    supports_streaming = True
+    supports_ranges = True
+
     def __init__(self, provider: str = "google_drive"):
         self.provider = provider
 
@@ -113,6 +116,30 @@ class DevCloudAdapter(CloudAdapter):
                     progress_callback(downloaded)
                 await asyncio.sleep(0.05)
 
+    async def stream_range(
+        self, remote_path: str, offset: int = 0, length: Optional[int] = None
+    ) -> AsyncIterator[bytes]:
+        """Simulate streaming (part of) a mock file as zero bytes."""
+        size = 1024
+        for files in _MOCK_FS.values():
+            for f in files:
+                if f.path == remote_path and f.size_bytes:
+                    size = f.size_bytes
+        end = size if length is None else min(size, offset + length)
+        position = offset
+        while position < end:
+            step = min(256 * 1024, end - position)
+            position += step
+            await asyncio.sleep(0.01)
+            yield b"\x00" * step
+
+    async def upload_stream(
+        self, remote_path: str, size: int, chunks: AsyncIterator[bytes]
+    ) -> None:
+        """Simulate a streamed upload by consuming the chunks."""
+        async for _chunk in chunks:
+            await asyncio.sleep(0.01)
+
     async def download_folder(
         self,
         remote_path: str,
@@ -8,10 +8,17 @@ from sqlalchemy import func, or_
 from sqlalchemy.orm import Session
 
 from app.core.config import settings
+from app.core.job_lock import job_lock
 from app.models.cloud import CloudConnection
 from app.models.cloud_export import CloudExportJob
 from app.schemas.cloud_export import CloudExportStatistics
 from app.services.cloud.service import CloudService
+from app.services.cloud.transfer import (
+    TransferEngine,
+    TransferItem,
+    TransferJournal,
+    bandwidth_limit,
+)
 
 logger = logging.getLogger(__name__)
 
@@ -91,11 +98,25 @@ class CloudExportService:
     # ─── Execute Export ───────────────────────────────────────────
 
     async def execute_export(self, job_id: int) -> None:
-        """Background task: upload file/folder, then create share link."""
+        """Background task: upload file/folder, then create share link.
+
+        Also resumes an interrupted upload: files recorded in the transfer
+        journal are not uploaded again.
+        """
+        with job_lock("export", job_id) as acquired:
+            if not acquired:
+                logger.info("Export job %d is already running in another worker", job_id)
+                return
+            await self._execute_export(job_id)
+
+    async def _execute_export(self, job_id: int) -> None:
         job = self.db.query(CloudExportJob).get(job_id)
         if not job:
             logger.error("Export job %d not found", job_id)
             return
+        if job.status not in ("pending", "uploading"):
+            logger.info("Export job %d is %s, not executing", job_id, job.status)
+            return
 
         connection = self.db.query(CloudConnection).get(job.connection_id)
         if not connection:
@@ -121,24 +142,48 @@ class CloudExportService:
 
             cloud_dest = f"{job.cloud_folder}{job.file_name}"
 
+            if job.is_directory:
+                items = [
+                    TransferItem(
+                        rel_path=f.relative_to(local_path).as_posix(),
+                        remote_path=f"{cloud_dest}/{f.relative_to(local_path).as_posix()}",
+                        local_path=f,
+                        size=f.stat().st_size,
+                    )
+                    for f in sorted(local_path.rglob("*"))
+                    if f.is_file()
+                ]
+            else:
+                items = [
+                    TransferItem(
+                        rel_path=job.file_name,
+                        remote_path=cloud_dest,
+                        local_path=local_path,
+                        size=local_path.stat().st_size,
+                    )
+                ]
+
+            journal = TransferJournal(self.db, "export", job_id).load()
+
             def progress_callback(bytes_done: int, *_args) -> None:
                 job.progress_bytes = bytes_done
                 self.db.commit()
 
-            if job.is_directory:
-                result = await adapter.upload_folder(
-                    local_path, cloud_dest, progress_callback=progress_callback
-                )
-                job.progress_bytes = result.bytes_transferred
-                if result.errors:
-                    job.error_message = "; ".join(result.errors[:5])
-            else:
-                await adapter.upload_file(
-                    local_path, cloud_dest, progress_callback=lambda b: progress_callback(b)
-                )
-                if local_path.exists():
-                    job.progress_bytes = local_path.stat().st_size
-
+            engine = TransferEngine(
+                adapter,
+                journal,
+                direction="upload",
+                rate_limit=lambda: bandwidth_limit(self.db, job.user_id, "upload"),
+                progress=progress_callback,
+            )
+            result = await engine.run(items)
+            job.progress_bytes = result.bytes_transferred
+            if result.errors:
+                job.error_message = "; ".join(result.errors[:5])
+                if not job.is_directory:
+                    raise RuntimeError(result.errors[0])
+
+            journal.clear()
             job.cloud_path = cloud_dest
             self.db.commit()
 
@@ -5,11 +5,20 @@ from datetime import datetime, timezone
 from pathlib import Path
 from typing import Optional
 
+from sqlalchemy import select
 from sqlalchemy.orm import Session
 
 from app.core.config import settings
+from app.core.job_lock import job_lock
 from app.models.cloud import CloudConnection, CloudImportJob
+from app.services.cloud.adapters.base import CloudAdapter
 from app.services.cloud.service import CloudService
+from app.services.cloud.transfer import (
+    TransferEngine,
+    TransferItem,
+    TransferJournal,
+    bandwidth_limit,
+)
 
 logger = logging.getLogger(__name__)
 
@@ -19,7 +28,15 @@ class CloudImportJobService:
 
     def __init__(self, db: Session):
         self.db = db
-        self._cancel_flags: dict[int, bool] = {}
+
+    def _cancel_requested(self, job_id: int) -> bool:
+        """Whether the job row says "cancelled".
+
+        The cancel route may run in any worker, so the request lives in the
+        database rather than in this process; the engine polls it every tick.
+        """
+        status = self.db.scalar(select(CloudImportJob.status).where(CloudImportJob.id == job_id))
+        return status == "cancelled"
 
     def start_import(
         self,
@@ -56,15 +73,32 @@ class CloudImportJobService:
         return job
 
     async def execute_import(self, job_id: int) -> None:
-        """Execute an import job (download files from cloud to NAS)."""
+        """Execute an import job (download files from cloud to NAS).
+
+        Also resumes an interrupted job: files and parts recorded in the
+        transfer journal are not downloaded again.
+        """
+        with job_lock("import", job_id) as acquired:
+            if not acquired:
+                logger.info("Import job %d is already running in another worker", job_id)
+                return
+            await self._execute_import(job_id)
+
+    async def _execute_import(self, job_id: int) -> None:
         job = self.db.query(CloudImportJob).get(job_id)
         if not job:
             logger.error("Import job %d not found", job_id)
             return
+        if job.status not in ("pending", "running"):
+            logger.info("Import job %d is %s, not executing", job_id, job.status)
+            return
 
-        # Mark as running
+        # Mark as running (a resumed job keeps its original start time)
+        if job.status == "running":
+            logger.info("Resuming import job %d", job_id)
+        else:
+            job.started_at = datetime.now(timezone.utc)
         job.status = "running"
-        job.started_at = datetime.now(timezone.utc)
         self.db.commit()
 
         cloud_service = CloudService(self.db)
@@ -88,83 +122,76 @@ class CloudImportJobService:
             if not str(dest_path.resolve()).startswith(str(storage_root)):
                 raise ValueError("Destination path outside storage root")
 
-            # Get total size estimate
-            total_size = await adapter.get_total_size(job.source_path)
-            if total_size:
-                job.total_bytes = total_size
-                self.db.commit()
-
-            # Check if source is a file or directory
-            parent_path = "/".join(job.source_path.rstrip("/").split("/")[:-1]) or "/"
-            source_name = job.source_path.rstrip("/").split("/")[-1]
+            items, errors = await self._collect_items(adapter, job.source_path, dest_path.resolve())
+            job.files_total = len(items)
+            job.total_bytes = sum(item.size or 0 for item in items) or None
+            self.db.commit()
 
-            files = await adapter.list_files(parent_path)
-            source_file = next((f for f in files if f.name == source_name), None)
+            journal = TransferJournal(self.db, "import", job_id).load()
 
-            if source_file and not source_file.is_directory:
-                # Single file download
-                job.files_total = 1
+            def progress(bytes_done: int, current_file: Optional[str], files_done: int) -> None:
+                job.progress_bytes = bytes_done
+                job.files_transferred = files_done
+                if current_file:
+                    job.current_file = current_file
                 self.db.commit()
 
-                local_file = dest_path / source_file.name
-
-                def file_progress(bytes_done: int) -> None:
-                    job.progress_bytes = bytes_done
-                    job.current_file = source_file.name
-                    self.db.commit()
-
-                await adapter.download_file(
-                    job.source_path, local_file, progress_callback=file_progress
-                )
-                job.files_transferred = 1
-                job.progress_bytes = local_file.stat().st_size if local_file.exists() else 0
-            else:
-                # Folder download — get file count for progress tracking
-                file_count = await adapter.get_file_count(job.source_path)
-                if file_count is not None:
-                    job.files_total = file_count
-                    self.db.commit()
-
-                def folder_progress(bytes_done: int, current_file: Optional[str]) -> None:
-                    if self._cancel_flags.get(job_id):
-                        raise asyncio.CancelledError("Job cancelled by user")
-                    job.progress_bytes = bytes_done
-                    if current_file:
-                        job.current_file = current_file
-                    self.db.commit()
-
-                result = await adapter.download_folder(
-                    job.source_path, dest_path, progress_callback=folder_progress
-                )
-                job.files_transferred = result.files_transferred
-                job.progress_bytes = result.bytes_transferred
+            engine = TransferEngine(
+                adapter,
+                journal,
+                direction="download",
+                rate_limit=lambda: bandwidth_limit(self.db, job.user_id, "download"),
+                progress=progress,
+                is_cancelled=lambda: self._cancel_requested(job_id),
+            )
+            result = await engine.run(items)
+            job.files_transferred = result.files_transferred
+            job.progress_bytes = result.bytes_transferred
 
-                if result.errors:
-                    job.error_message = "; ".join(result.errors[:5])
+            errors += result.errors
+            if errors:
+                job.error_message = "; ".join(errors[:5])
 
-            # Mark completed
-            job.status = "completed"
-            job.completed_at = datetime.now(timezone.utc)
+            # Mark completed, unless a cancel landed after the last tick
+            journal.clear()
             job.current_file = None
             self.db.commit()
+            completed = (
+                self.db.query(CloudImportJob)
+                .filter(CloudImportJob.id == job_id, CloudImportJob.status == "running")
+                .update(
+                    {"status": "completed", "completed_at": datetime.now(timezone.utc)},
+                    synchronize_session="fetch",
+                )
+            )
+            self.db.commit()
+            if not completed:
+                logger.info("Import job %d was cancelled as it finished", job_id)
+                return
 
             # Update connection last_used_at
             connection.last_used_at = datetime.now(timezone.utc)
             self.db.commit()
 
             logger.info(
-                "Import job %d completed: %d files, %d bytes",
-                job_id, job.files_transferred, job.progress_bytes,
+                "Import job %d completed: %d files (%d already present), %d bytes",
+                job_id, job.files_transferred, result.files_skipped, job.progress_bytes,
             )
 
         except asyncio.CancelledError:
-            job.status = "cancelled"
-            job.completed_at = datetime.now(timezone.utc)
-            job.error_message = "Cancelled by user"
-            self.db.commit()
+            if not await asyncio.to_thread(self._cancel_requested, job_id):
+                # Shutdown, not the user: stay "running" so startup resumes it
+                logger.info("Import job %d interrupted, will resume on restart", job_id)
+                raise
+            # cancel_job already wrote the row; pick up its status and stamps
+            self.db.refresh(job)
             logger.info("Import job %d cancelled", job_id)
 
         except Exception as e:
+            if await asyncio.to_thread(self._cancel_requested, job_id):
+                self.db.refresh(job)
+                logger.info("Import job %d cancelled", job_id)
+                return
             logger.exception("Import job %d failed", job_id)
             job.status = "failed"
             job.error_message = str(e)[:500]
@@ -173,7 +200,45 @@ class CloudImportJobService:
 
         finally:
             await adapter.close()
-            self._cancel_flags.pop(job_id, None)
+
+    @staticmethod
+    async def _collect_items(
+        adapter: CloudAdapter, source_path: str, dest_path: Path
+    ) -> tuple[list[TransferItem], list[str]]:
+        """List the files of the import source (a single file or a folder)."""
+        # Check if source is a file or directory
+        parent_path = "/".join(source_path.rstrip("/").split("/")[:-1]) or "/"
+        source_name = source_path.rstrip("/").split("/")[-1]
+
+        files = await adapter.list_files(parent_path)
+        source_file = next((f for f in files if f.name == source_name), None)
+
+        if source_file and not source_file.is_directory:
+            entries = [(source_file.name, source_file)]
+        else:
+            prefix = source_path.rstrip("/") + "/"
+            entries = [
+                (f.path[len(prefix):] if f.path.startswith(prefix) else f.name, f)
+                for f in await adapter.list_tree(source_path)
+            ]
+
+        items: list[TransferItem] = []
+        errors: list[str] = []
+        for rel_path, remote in entries:
+            local_path = (dest_path / rel_path).resolve()
+            if not local_path.is_relative_to(dest_path):
+                errors.append(f"{rel_path}: path outside destination")
+                continue
+            items.append(
+                TransferItem(
+                    rel_path=rel_path,
+                    remote_path=remote.path,
+                    local_path=local_path,
+                    size=remote.size_bytes,
+                    modified_at=remote.modified_at,
+                )
+            )
+        return items, errors
 
     def get_job_status(self, job_id: int, user_id: int) -> Optional[CloudImportJob]:
         """Get a job by ID, ensuring ownership."""
@@ -199,19 +264,29 @@ class CloudImportJobService:
         )
 
     def cancel_job(self, job_id: int, user_id: int) -> bool:
-        """Cancel a running job."""
+        """Cancel a pending or running job.
+
+        Only the row is updated; the worker running the job (possibly another
+        process) sees the status on its next tick and stops.
+        """
         job = self.get_job_status(job_id, user_id)
         if not job:
             return False
 
-        if job.status == "running":
-            self._cancel_flags[job_id] = True
-            return True
-
-        if job.status == "pending":
-            job.status = "cancelled"
-            job.completed_at = datetime.now(timezone.utc)
-            self.db.commit()
-            return True
-
-        return False
+        cancelled = (
+            self.db.query(CloudImportJob)
+            .filter(
+                CloudImportJob.id == job_id,
+                CloudImportJob.status.in_(("pending", "running")),
+            )
+            .update(
+                {
+                    "status": "cancelled",
+                    "completed_at": datetime.now(timezone.utc),
+                    "error_message": "Cancelled by user",
+                },
+                synchronize_session="fetch",
+            )
+        )
+        self.db.commit()
+        return bool(cancelled)
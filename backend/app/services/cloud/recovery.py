@@ -0,0 +1,66 @@
+"""Resume cloud imports/exports that a restart interrupted (primary worker).
+
+Jobs still "running"/"uploading" (or "pending", whose background task died
+with the old process) are executed again; the transfer journal makes them
+skip what is already done. The per-job lock (app.core.job_lock) keeps a job
+that another live worker is executing from being started twice.
+"""
+import asyncio
+import logging
+
+from app.core.database import SessionLocal
+from app.models.cloud import CloudImportJob
+from app.models.cloud_export import CloudExportJob
+
+logger = logging.getLogger(__name__)
+
+
+async def _resume_import(job_id: int) -> None:
+    from app.services.cloud.import_job import CloudImportJobService
+
+    db = SessionLocal()
+    try:
+        await CloudImportJobService(db).execute_import(job_id)
+    finally:
+        db.close()
+
+
+async def _resume_export(job_id: int) -> None:
+    from app.services.cloud.export_service import CloudExportService
+
+    db = SessionLocal()
+    try:
+        await CloudExportService(db).execute_export(job_id)
+    finally:
+        db.close()
+
+
+async def resume_interrupted_jobs() -> int:
+    """Run every unfinished import/export job; returns how many were resumed."""
+    db = SessionLocal()
+    try:
+        imports = [
+            job_id for (job_id,) in db.query(CloudImportJob.id).filter(
+                CloudImportJob.status.in_(("pending", "running"))
+            )
+        ]
+        exports = [
+            job_id for (job_id,) in db.query(CloudExportJob.id).filter(
+                CloudExportJob.status.in_(("pending", "uploading"))
+            )
+        ]
+    finally:
+        db.close()
+
+    if not imports and not exports:
+        return 0
+    logger.info("Resuming %d cloud import(s) and %d export(s)", len(imports), len(exports))
+    results = await asyncio.gather(
+        *(_resume_import(job_id) for job_id in imports),
+        *(_resume_export(job_id) for job_id in exports),
+        return_exceptions=True,
+    )
+    for result in results:
+        if isinstance(result, Exception):
+            logger.warning("Resuming a cloud transfer failed: %s", result)
+    return len(imports) + len(exports)
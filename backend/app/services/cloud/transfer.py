@@ -0,0 +1,643 @@
+"""
+Parallel, resumable transfer engine for cloud import/export.
+
+CloudImportJobService and CloudExportService hand the engine the file list
+of a job (TransferItem) and it moves the data:
+
+- Files run on up to ``cloud_transfer_max_streams`` concurrent streams; how
+  many are active adapts to the measured throughput (StreamController).
+- Downloads above ``cloud_transfer_multipart_cutoff_mb`` are split into
+  fixed-size parts, fetched independently into ``.<name>.baluhost-part`` and
+  renamed into place once every part is there.
+- Finished files and parts are journaled in cloud_transfer_checkpoints, so a
+  job restarted after a reboot or a sleep cycle skips what is already on
+  disk. Downloaded files get the remote mtime, which also lets a repeated
+  sync skip unchanged files.
+- Throughput is capped by the user's sync bandwidth limit
+  (SyncBandwidthLimit, including its throttle window), re-read every 30 s.
+- Everything that touches the job's DB session (journal writes, the
+  progress/cancel/limit callbacks) runs in a thread, one hop at a time, so
+  the streams keep moving while the database is slow.
+
+Adapters without streaming support (iCloud) fall back to one
+download_file/upload_file call per file; resume then works per file.
+"""
+from __future__ import annotations
+
+import asyncio
+import logging
+import math
+import os
+import time
+from dataclasses import dataclass, field
+from datetime import datetime
+from pathlib import Path
+from typing import AsyncIterator, Callable, Optional
+
+from sqlalchemy import delete, insert, update
+from sqlalchemy.orm import Session
+from sqlalchemy.sql import func
+
+from app.core.config import settings
+from app.models.cloud import CloudTransferCheckpoint
+from app.models.sync_progress import SyncBandwidthLimit
+from app.services.cloud.adapters.base import CloudAdapter
+
+logger = logging.getLogger(__name__)
+
+MiB = 1024 * 1024
+PART_SUFFIX = ".baluhost-part"
+UPLOAD_CHUNK_SIZE = MiB
+
+# Retries per file/part; the backoff outlasts a network coming back after wake
+MAX_ATTEMPTS = 5
+RETRY_BASE_DELAY = 2.0
+RETRY_MAX_DELAY = 60.0
+
+# Progress callback, journal flush and cancellation check cadence (seconds)
+TICK_INTERVAL = 1.0
+# How often the bandwidth limit is re-read (throttle windows change hourly)
+LIMIT_REFRESH_INTERVAL = 30.0
+# Remote and local mtimes closer than this count as equal
+MTIME_TOLERANCE = 2.0
+
+
+@dataclass
+class TransferItem:
+    """One file of a job."""
+    rel_path: str  # journal key, relative to the job root
+    remote_path: str
+    local_path: Path
+    size: Optional[int] = None
+    modified_at: Optional[datetime] = None
+
+
+@dataclass
+class TransferResult:
+    files_transferred: int = 0  # includes files skipped as already complete
+    files_skipped: int = 0
+    bytes_transferred: int = 0
+    errors: list[str] = field(default_factory=list)
+
+
+# ─── Bandwidth ────────────────────────────────────────────────────
+
+def bandwidth_limit(
+    db: Session, user_id: int, direction: str, now: Optional[datetime] = None
+) -> Optional[int]:
+    """The user's sync bandwidth limit in bytes/s for "download"/"upload".
+
+    With ``throttle_enabled`` the limit only applies inside the throttle
+    window (local hours, may wrap midnight); otherwise it always applies.
+    """
+    limit = db.query(SyncBandwidthLimit).filter(SyncBandwidthLimit.user_id == user_id).first()
+    if limit is None:
+        return None
+    rate = limit.download_speed_limit if direction == "download" else limit.upload_speed_limit
+    if not rate or rate <= 0:
+        return None
+    if limit.throttle_enabled:
+        hour = (now or datetime.now()).hour
+        start, end = limit.throttle_start_hour, limit.throttle_end_hour
+        if start < end:
+            inside = start <= hour < end
+        elif start > end:
+            inside = hour >= start or hour < end
+        else:
+            inside = True
+        if not inside:
+            return None
+    return rate
+
+
+class RateLimiter:
+    """Token bucket shared by all streams of a job (bytes/s, None = unlimited)."""
+
+    def __init__(self, rate: Optional[int] = None):
+        self.rate = rate
+        self._tokens = 0.0
+        self._stamp = time.monotonic()
+
+    async def consume(self, nbytes: int) -> None:
+        if not self.rate:
+            return
+        now = time.monotonic()
+        self._tokens = min(float(self.rate), self._tokens + (now - self._stamp) * self.rate)
+        self._stamp = now
+        self._tokens -= nbytes
+        if self._tokens < 0:
+            # Concurrent streams each wait out the shared deficit
+            await asyncio.sleep(-self._tokens / self.rate)
+
+
+class StreamController:
+    """Hill-climbs the number of parallel streams on measured throughput.
+
+    Every window the aggregate rate is compared with the previous one: a
+    gain of more than GAIN adds a stream, a loss of more than GAIN right
+    after adding one takes it back. Errors halve the streams. While the
+    bandwidth limit is what caps the rate, no streams are added.
+    """
+
+    GAIN = 0.10
+
+    def __init__(self, initial: int, maximum: int, window: float = 5.0):
+        self.maximum = max(1, maximum)
+        self.limit = max(1, min(initial, self.maximum))
+        self.window = window
+        self._window_start: Optional[float] = None
+        self._window_bytes = 0
+        self._last_rate: Optional[float] = None
+        self._last_change = 0
+
+    def record(self, nbytes: int, now: float, capped_at: Optional[int] = None) -> None:
+        if self._window_start is None:
+            self._window_start = now
+        self._window_bytes += nbytes
+        elapsed = now - self._window_start
+        if elapsed >= self.window:
+            rate = self._window_bytes / elapsed
+            self.adjust(rate, capped=bool(capped_at) and rate >= 0.9 * capped_at)
+            self._window_start = now
+            self._window_bytes = 0
+
+    def adjust(self, rate: float, capped: bool = False) -> None:
+        last, self._last_rate = self._last_rate, rate
+        change = 0
+        if capped:
+            pass
+        elif last is None or rate > last * (1 + self.GAIN):
+            change = 1 if self.limit < self.maximum else 0
+        elif rate < last * (1 - self.GAIN) and self._last_change > 0:
+            change = -1
+        self.limit = max(1, self.limit + change)
+        self._last_change = change
+
+    def on_error(self) -> None:
+        self.limit = max(1, self.limit // 2)
+        self._last_change = 0
+
+
+# ─── Checkpoint journal ───────────────────────────────────────────
+
+@dataclass
+class Checkpoint:
+    size: int
+    completed: bool = False
+    parts: set[int] = field(default_factory=set)
+
+
+class TransferJournal:
+    """cloud_transfer_checkpoints rows of one job, written in batches."""
+
+    def __init__(self, db: Session, job_kind: str, job_id: int):
+        self.db = db
+        self.job_kind = job_kind
+        self.job_id = job_id
+        self._entries: dict[str, Checkpoint] = {}
+        self._persisted: set[str] = set()
+        self._dirty: set[str] = set()
+
+    def load(self) -> "TransferJournal":
+        rows = self.db.query(CloudTransferCheckpoint).filter(
+            CloudTransferCheckpoint.job_kind == self.job_kind,
+            CloudTransferCheckpoint.job_id == self.job_id,
+        ).all()
+        for row in rows:
+            parts = {int(p) for p in row.parts_done.split(",") if p} if row.parts_done else set()
+            self._entries[row.rel_path] = Checkpoint(row.size_bytes, row.completed, parts)
+            self._persisted.add(row.rel_path)
+        return self
+
+    def get(self, rel_path: str) -> Optional[Checkpoint]:
+        return self._entries.get(rel_path)
+
+    def reset(self, rel_path: str, size: int) -> Checkpoint:
+        self._entries[rel_path] = entry = Checkpoint(size)
+        self._dirty.add(rel_path)
+        return entry
+
+    def part_done(self, rel_path: str, index: int, size: int) -> None:
+        entry = self._entries.get(rel_path) or self.reset(rel_path, size)
+        entry.parts.add(index)
+        self._dirty.add(rel_path)
+
+    def file_done(self, rel_path: str, size: int) -> None:
+        entry = self._entries.get(rel_path) or self.reset(rel_path, size)
+        entry.size = size
+        entry.completed = True
+        entry.parts.clear()
+        self._dirty.add(rel_path)
+
+    def flush(self) -> None:
+        self.write(self.take())
+
+    def take(self) -> list[tuple[str, bool, dict]]:
+        """Snapshot and reset the dirty entries as ``(rel_path, new, values)``.
+
+        Called on the event loop, where the workers mutate the entries;
+        the snapshot can then be written from a thread with ``write``.
+        """
+        rows = [(rel, rel not in self._persisted, self._values(rel)) for rel in self._dirty]
+        self._dirty.clear()
+        return rows
+
+    def write(self, rows: list[tuple[str, bool, dict]]) -> None:
+        if not rows:
+            return
+        try:
+            new = [values for _, is_new, values in rows if is_new]
+            if new:
+                self.db.execute(insert(CloudTransferCheckpoint), new)
+            for rel, is_new, values in rows:
+                if is_new:
+                    continue
+                self.db.execute(
+                    update(CloudTransferCheckpoint)
+                    .where(
+                        CloudTransferCheckpoint.job_kind == self.job_kind,
+                        CloudTransferCheckpoint.job_id == self.job_id,
+                        CloudTransferCheckpoint.rel_path == rel,
+                    )
+                    .values(updated_at=func.now(), **values)
+                )
+            self.db.commit()
+        except BaseException:
+            self._dirty.update(rel for rel, _, _ in rows)
+            raise
+        self._persisted.update(rel for rel, is_new, _ in rows if is_new)
+
+    def clear(self) -> None:
+        """Drop the journal once the job finished."""
+        self.db.execute(
+            delete(CloudTransferCheckpoint).where(
+                CloudTransferCheckpoint.job_kind == self.job_kind,
+                CloudTransferCheckpoint.job_id == self.job_id,
+            )
+        )
+        self.db.commit()
+        self._entries.clear()
+        self._persisted.clear()
+        self._dirty.clear()
+
+    def _values(self, rel_path: str) -> dict:
+        entry = self._entries[rel_path]
+        return {
+            "job_kind": self.job_kind,
+            "job_id": self.job_id,
+            "rel_path": rel_path,
+            "size_bytes": entry.size,
+            "completed": entry.completed,
+            "parts_done": ",".join(str(p) for p in sorted(entry.parts)) or None,
+        }
+
+
+# ─── Engine ───────────────────────────────────────────────────────
+
+@dataclass
+class _FileState:
+    item: TransferItem
+    parts_left: int = 1
+    failed: bool = False
+
+
+@dataclass
+class _Unit:
+    file: _FileState
+    index: int = 0  # part index; whole-file units use 0
+    offset: int = 0
+    length: Optional[int] = None  # None = whole file
+    attempt_bytes: int = 0  # counted by the current attempt, undone on failure
+
+
+class TransferEngine:
+    """Moves the files of one job; see the module docstring."""
+
+    def __init__(
+        self,
+        adapter: CloudAdapter,
+        journal: TransferJournal,
+        *,
+        direction: str,
+        rate_limit: Callable[[], Optional[int]] = lambda: None,
+        progress: Optional[Callable[[int, Optional[str], int], None]] = None,
+        is_cancelled: Callable[[], bool] = lambda: False,
+        max_streams: Optional[int] = None,
+        initial_streams: Optional[int] = None,
+        part_size: Optional[int] = None,
+        multipart_cutoff: Optional[int] = None,
+    ):
+        if direction not in ("download", "upload"):
+            raise ValueError(f"Unknown transfer direction: {direction}")
+        self.adapter = adapter
+        self.journal = journal
+        self.direction = direction
+        self._rate_limit = rate_limit
+        self._progress = progress
+        self._is_cancelled = is_cancelled
+        self.part_size = part_size or settings.cloud_transfer_part_size_mb * MiB
+        self.multipart_cutoff = (
+            multipart_cutoff or settings.cloud_transfer_multipart_cutoff_mb * MiB
+        )
+        self.controller = StreamController(
+            initial_streams or settings.cloud_transfer_initial_streams,
+            max_streams or settings.cloud_transfer_max_streams,
+        )
+        self.limiter = RateLimiter()
+        self.result = TransferResult()
+        self._current_file: Optional[str] = None
+        self._cancelled = False
+        self._db_hop: Optional[asyncio.Future] = None
+
+    async def run(self, items: list[TransferItem]) -> TransferResult:
+        """Transfer ``items``; raises CancelledError when the job is cancelled."""
+        self.limiter.rate = await self._in_db_thread(self._rate_limit)
+        queue: asyncio.Queue[_Unit] = asyncio.Queue()
+        # Stats every local file and preallocates part files: off the loop
+        for unit in await asyncio.to_thread(self._plan, items):
+            queue.put_nowait(unit)
+
+        workers = [
+            asyncio.create_task(self._worker(index, queue))
+            for index in range(self.controller.maximum)
+        ]
+        finished = asyncio.create_task(queue.join())
+        ticker = asyncio.create_task(self._tick())
+        try:
+            await asyncio.wait({finished, ticker}, return_when=asyncio.FIRST_COMPLETED)
+        finally:
+            for task in (*workers, finished, ticker):
+                task.cancel()
+            await asyncio.gather(*workers, finished, ticker, return_exceptions=True)
+            if self._db_hop is not None:
+                # A tick cancelled mid-write still owns the session
+                await asyncio.gather(self._db_hop, return_exceptions=True)
+            await self._in_db_thread(self._flush_and_report, self.journal.take())
+
+        if self._cancelled:
+            raise asyncio.CancelledError("Job cancelled by user")
+        return self.result
+
+    # --- planning ---------------------------------------------------------
+
+    def _plan(self, items: list[TransferItem]) -> list[_Unit]:
+        units: list[_Unit] = []
+        for item in items:
+            if self._already_done(item):
+                self.result.files_transferred += 1
+                self.result.files_skipped += 1
+                self.result.bytes_transferred += item.size or 0
+                continue
+
+            state = _FileState(item)
+            size = item.size or 0
+            if (
+                self.direction == "download"
+                and self.adapter.supports_ranges
+                and size > self.multipart_cutoff
+            ):
+                units.extend(self._plan_parts(state))
+            else:
+                units.append(_Unit(state))
+        return units
+
+    def _already_done(self, item: TransferItem) -> bool:
+        checkpoint = self.journal.get(item.rel_path)
+        if self.direction == "upload":
+            return bool(checkpoint and checkpoint.completed and checkpoint.size == item.size)
+
+        try:
+            stat = item.local_path.stat()
+        except OSError:
+            return False
+        if item.size is None or stat.st_size != item.size:
+            return False
+        if checkpoint and checkpoint.completed:
+            return True
+        # Same size and mtime as the remote copy: left by an earlier sync
+        return (
+            item.modified_at is not None
+            and abs(stat.st_mtime - item.modified_at.timestamp()) <= MTIME_TOLERANCE
+        )
+
+    def _plan_parts(self, state: _FileState) -> list[_Unit]:
+        item = state.item
+        size = item.size or 0
+        count = math.ceil(size / self.part_size)
+        part_path = self._part_path(item)
+
+        checkpoint = self.journal.get(item.rel_path)
+        try:
+            intact = part_path.stat().st_size == size
+        except OSError:
+            intact = False
+        if checkpoint is None or checkpoint.size != size or checkpoint.completed or not intact:
+            part_path.parent.mkdir(parents=True, exist_ok=True)
+            with open(part_path, "wb") as fh:
+                fh.truncate(size)
+            checkpoint = self.journal.reset(item.rel_path, size)
+
+        missing = [i for i in range(count) if i not in checkpoint.parts]
+        self.result.bytes_transferred += sum(
+            min(self.part_size, size - i * self.part_size) for i in checkpoint.parts if i < count
+        )
+        state.parts_left = len(missing)
+        if not missing:  # every part landed but the rename did not
+            return [_Unit(state, index=-1, offset=0, length=0)]
+        return [
+            _Unit(state, index=i, offset=i * self.part_size,
+                  length=min(self.part_size, size - i * self.part_size))
+            for i in missing
+        ]
+
+    @staticmethod
+    def _part_path(item: TransferItem) -> Path:
+        return item.local_path.with_name(f".{item.local_path.name}{PART_SUFFIX}")
+
+    # --- execution --------------------------------------------------------
+
+    async def _worker(self, index: int, queue: asyncio.Queue) -> None:
+        while True:
+            if index >= self.controller.limit:
+                await asyncio.sleep(0.5)
+                continue
+            unit = await queue.get()
+            try:
+                await self._run_unit(unit)
+            finally:
+                queue.task_done()
+
+    async def _run_unit(self, unit: _Unit) -> None:
+        for attempt in range(1, MAX_ATTEMPTS + 1):
+            if unit.file.failed:
+                return
+            unit.attempt_bytes = 0
+            try:
+                await self._transfer(unit)
+                return
+            except asyncio.CancelledError:
+                raise
+            except Exception as e:
+                self.result.bytes_transferred -= unit.attempt_bytes
+                self.controller.on_error()
+                if attempt == MAX_ATTEMPTS:
+                    unit.file.failed = True
+                    self.result.errors.append(f"{unit.file.item.rel_path}: {e}")
+                    logger.warning("Cloud transfer of %s failed: %s", unit.file.item.rel_path, e)
+                    return
+                delay = min(RETRY_MAX_DELAY, RETRY_BASE_DELAY * 2 ** (attempt - 1))
+                logger.info(
+                    "Retrying %s in %.0fs (attempt %d/%d): %s",
+                    unit.file.item.rel_path, delay, attempt, MAX_ATTEMPTS, e,
+                )
+                await asyncio.sleep(delay)
+
+    async def _transfer(self, unit: _Unit) -> None:
+        item = unit.file.item
+        self._current_file = item.rel_path
+        if self.direction == "upload":
+            await self._upload(unit)
+            self.journal.file_done(item.rel_path, item.size or 0)
+            self.result.files_transferred += 1
+        elif unit.length is None:
+            await self._download_whole(unit)
+        else:
+            if unit.index >= 0:
+                await self._download_part(unit)
+                self.journal.part_done(item.rel_path, unit.index, item.size or 0)
+                unit.file.parts_left -= 1
+            if unit.file.parts_left <= 0:
+                await self._finish_download(item, self._part_path(item))
+
+    async def _download_part(self, unit: _Unit) -> None:
+        """Fetch one range into the part file; durable on disk when this returns.
+
+        The caller journals the part as done right after, so the data is
+        fsynced first: a crash must never leave a "done" part full of zeros.
+        File I/O runs in worker threads to keep the event loop free.
+        """
+        item = unit.file.item
+        fd = await asyncio.to_thread(os.open, self._part_path(item), os.O_WRONLY)
+        try:
+            position = unit.offset
+            async for chunk in self.adapter.stream_range(item.remote_path, unit.offset, unit.length):
+                await self._account(unit, len(chunk))
+                await asyncio.to_thread(os.pwrite, fd, chunk, position)
+                position += len(chunk)
+            if position - unit.offset != unit.length:
+                raise IOError(f"short read: {position - unit.offset} of {unit.length} bytes")
+            await asyncio.to_thread(os.fsync, fd)
+        finally:
+            os.close(fd)
+
+    async def _download_whole(self, unit: _Unit) -> None:
+        item = unit.file.item
+        part_path = self._part_path(item)
+        await asyncio.to_thread(part_path.parent.mkdir, parents=True, exist_ok=True)
+        if self.adapter.supports_streaming:
+            fh = await asyncio.to_thread(open, part_path, "wb")
+            try:
+                async for chunk in self.adapter.stream_range(item.remote_path):
+                    await self._account(unit, len(chunk))
+                    await asyncio.to_thread(fh.write, chunk)
+            finally:
+                await asyncio.to_thread(fh.close)
+        else:
+            progress = self._progress_counter(unit)
+            await self.adapter.download_file(item.remote_path, part_path, progress_callback=progress)
+            progress((await asyncio.to_thread(part_path.stat)).st_size)
+        await self._finish_download(item, part_path)
+
+    async def _finish_download(self, item: TransferItem, part_path: Path) -> None:
+        size = await asyncio.to_thread(self._install_download, item, part_path)
+        self.journal.file_done(item.rel_path, size)
+        self.result.files_transferred += 1
+
+    @staticmethod
+    def _install_download(item: TransferItem, part_path: Path) -> int:
+        """fsync the finished part file, rename it into place; returns its size."""
+        fd = os.open(part_path, os.O_RDONLY)
+        try:
+            os.fsync(fd)
+        finally:
+            os.close(fd)
+        os.replace(part_path, item.local_path)
+        if item.modified_at is not None:
+            stamp = item.modified_at.timestamp()
+            os.utime(item.local_path, (stamp, stamp))
+        return item.local_path.stat().st_size
+
+    async def _upload(self, unit: _Unit) -> None:
+        item = unit.file.item
+        if self.adapter.supports_streaming:
+            await self.adapter.upload_stream(
+                item.remote_path, item.size or 0, self._read_chunks(unit)
+            )
+            return
+        progress = self._progress_counter(unit)
+        await self.adapter.upload_file(item.local_path, item.remote_path, progress_callback=progress)
+        progress(item.size or 0)
+
+    async def _read_chunks(self, unit: _Unit) -> AsyncIterator[bytes]:
+        fh = await asyncio.to_thread(open, unit.file.item.local_path, "rb")
+        try:
+            while chunk := await asyncio.to_thread(fh.read, UPLOAD_CHUNK_SIZE):
+                await self._account(unit, len(chunk))
+                yield chunk
+        finally:
+            await asyncio.to_thread(fh.close)
+
+    async def _account(self, unit: _Unit, nbytes: int) -> None:
+        await self.limiter.consume(nbytes)
+        self._count(unit, nbytes)
+
+    def _count(self, unit: _Unit, nbytes: int) -> None:
+        unit.attempt_bytes += nbytes
+        self.result.bytes_transferred += nbytes
+        self.controller.record(nbytes, time.monotonic(), self.limiter.rate)
+
+    def _progress_counter(self, unit: _Unit) -> Callable[[int], None]:
+        """Adapter progress callback (cumulative bytes) for the fallback path."""
+        seen = 0
+
+        def on_progress(done: int) -> None:
+            nonlocal seen
+            if done > seen:
+                self._count(unit, done - seen)
+                seen = done
+
+        return on_progress
+
+    # --- housekeeping -----------------------------------------------------
+
+    async def _in_db_thread(self, fn: Callable, *args):
+        """Run ``fn`` (which uses the job's DB session) off the event loop.
+
+        Shielded, so cancelling the caller never leaves a thread on the
+        session unseen: ``run`` waits for ``_db_hop`` before its last flush.
+        """
+        self._db_hop = asyncio.ensure_future(asyncio.to_thread(fn, *args))
+        return await asyncio.shield(self._db_hop)
+
+    async def _tick(self) -> None:
+        last_refresh = time.monotonic()
+        while True:
+            await asyncio.sleep(TICK_INTERVAL)
+            if await self._in_db_thread(self._is_cancelled):
+                self._cancelled = True
+                return
+            now = time.monotonic()
+            if now - last_refresh >= LIMIT_REFRESH_INTERVAL:
+                self.limiter.rate = await self._in_db_thread(self._rate_limit)
+                last_refresh = now
+            await self._in_db_thread(self._flush_and_report, self.journal.take())
+
+    def _flush_and_report(self, rows: list[tuple[str, bool, dict]]) -> None:
+        self.journal.write(rows)
+        self._report()
+
+    def _report(self) -> None:
+        if self._progress:
+            self._progress(
+                self.result.bytes_transferred, self._current_file, self.result.files_transferred
+            )
@@ -9,9 +9,14 @@ Provides file management with:
 """
 
 from app.services.files.folder_size import (
+    folder_size_token,
     get_folder_size,
+    get_folder_sizes,
     invalidate_folder_sizes_for_path,
     invalidate_all_folder_sizes,
+    move_folder_sizes,
+    record_file_size_change,
+    record_file_size_changes,
 )
 from app.services.files.path_utils import (
     ROOT_DIR,
@@ -83,9 +88,14 @@ from app.services.files.ownership import (
 
 __all__ = [
     # Folder size
+    "folder_size_token",
     "get_folder_size",
+    "get_folder_sizes",
     "invalidate_folder_sizes_for_path",
     "invalidate_all_folder_sizes",
+    "move_folder_sizes",
+    "record_file_size_change",
+    "record_file_size_changes",
     # Path utilities
     "ROOT_DIR",
     "SHARED_DIR_NAME",
@@ -15,6 +15,7 @@ from sqlalchemy.orm import Session
 if TYPE_CHECKING:
     from app.models.file_share import FileShare
 
+from app.core.decision_cache import get_decision_cache
 from app.schemas.user import UserPublic
 from app.services.files import path_utils
 from app.services.files import metadata_db as file_metadata_db
@@ -32,6 +33,63 @@ def _ancestor_paths(relative_path: str) -> list[str]:
     return candidates
 
 
+# Users with more readable shares than this are not cached (queried per call)
+MAX_CACHED_SHARE_GRANTS = 5000
+
+
+def _load_share_grants(db: Session, user_id: int) -> Optional[dict[str, Optional[float]]]:
+    from app.models.file_share import FileShare
+    from app.models.file_metadata import FileMetadata
+
+    now = datetime.now(timezone.utc)
+    stmt = (
+        select(FileMetadata.path, FileShare.expires_at)
+        .join(FileMetadata, FileShare.file_id == FileMetadata.id)
+        .where(
+            FileShare.shared_with_user_id == user_id,
+            FileShare.owner_id != user_id,
+            FileShare.can_read.is_(True),
+            or_(
+                FileShare.expires_at.is_(None),
+                FileShare.expires_at > now,
+            ),
+        )
+        .limit(MAX_CACHED_SHARE_GRANTS + 1)
+    )
+    rows = db.execute(stmt).all()
+    if len(rows) > MAX_CACHED_SHARE_GRANTS:
+        return None
+    grants: dict[str, Optional[float]] = {}
+    for path, expires_at in rows:
+        if expires_at is not None and expires_at.tzinfo is None:
+            expires_at = expires_at.replace(tzinfo=timezone.utc)
+        expiry = expires_at.timestamp() if expires_at is not None else None
+        # Several shares of one path: keep the longest-lived
+        if path in grants and (grants[path] is None or (expiry is not None and expiry <= grants[path])):
+            continue
+        grants[path] = expiry
+    return grants
+
+
+def _share_grants(db: Session, user_id: int) -> Optional[dict[str, Optional[float]]]:
+    """Readable share grants of *user_id* (path -> expiry timestamp), cached.
+
+    None while the decision cache is off (or for very many shares): callers
+    then run their own query.
+    """
+    cache = get_decision_cache()
+    if not cache.enabled:
+        return None
+    return cache.get_or_load("shares", user_id, lambda: _load_share_grants(db, user_id))
+
+
+def _grant_active(grants: dict[str, Optional[float]], path: str, now: float) -> bool:
+    if path not in grants:
+        return False
+    expiry = grants[path]
+    return expiry is None or expiry > now
+
+
 # ── Share queries ─────────────────────────────────────────────────────────────
 
 def is_path_shared_with_user(db: Session, relative_path: str, user_id: int) -> bool:
@@ -43,15 +101,20 @@ def is_path_shared_with_user(db: Session, relative_path: str, user_id: int) -> b
     if db is None:
         return False
 
+    candidates = _ancestor_paths(relative_path)
+    if not candidates:
+        return False
+
+    grants = _share_grants(db, user_id)
+    if grants is not None:
+        now_ts = datetime.now(timezone.utc).timestamp()
+        return any(_grant_active(grants, c, now_ts) for c in candidates)
+
     from app.models.file_share import FileShare
     from app.models.file_metadata import FileMetadata
 
     now = datetime.now(timezone.utc)
 
-    candidates = _ancestor_paths(relative_path)
-    if not candidates:
-        return False
-
     # Single query: join FileShare → FileMetadata, filter by path candidates + user
     stmt = (
         select(FileShare.id)
@@ -138,6 +201,16 @@ def are_paths_shared_with_user_bulk(
     if not all_candidates:
         return set()
 
+    grants = _share_grants(db, user_id)
+    if grants is not None:
+        now_ts = now.timestamp()
+        return {
+            entry_path
+            for candidate, entries in candidate_to_entries.items()
+            if _grant_active(grants, candidate, now_ts)
+            for entry_path in entries
+        }
+
     # Single query: find which candidate paths have an active share
     stmt = (
         select(FileMetadata.path)
@@ -2,17 +2,34 @@
 
 Tracks in-flight chunked uploads, writes chunks to temp files on disk,
 and finalises uploads by moving temp files to the target location.
+
+Two session modes exist:
+
+* **sequential** (default) — chunks must arrive in order and are appended
+  to the temp file while a single SHA-256 hasher follows the stream.
+* **parallel** — the temp file is preallocated to ``total_size`` and chunks
+  may arrive in any order (and several at once). Each chunk is written at
+  ``chunk_index * chunk_size`` with a positional write, recorded in a
+  received-chunk bitmap (used for resume), and digested individually.
+  The whole-file SHA-256 is advanced as a "hash frontier": every chunk
+  that extends the contiguous prefix is hashed from memory as it lands,
+  and chunks that arrived early are folded in (from the page cache) as
+  soon as the gap before them closes. Completion therefore only hashes
+  what is still outstanding instead of re-reading the whole file.
 """
 from __future__ import annotations
 
 import asyncio
 import hashlib
 import logging
+import os
+import queue
+import threading
 import uuid
 from dataclasses import dataclass, field
 from datetime import datetime, timezone, timedelta
 from pathlib import Path
-from typing import AsyncIterator, Dict, Optional
+from typing import AsyncIterator, Dict, List, Optional, Set
 
 from app.core.config import settings
 
@@ -26,6 +43,10 @@ TMP_UPLOAD_DIR = Path(settings.nas_storage_path).expanduser().resolve() / ".tmp"
 SESSION_MAX_AGE = timedelta(hours=24)
 
 
+class _StreamOverflow(Exception):
+    """Internal: a streamed chunk crossed its byte limit."""
+
+
 @dataclass
 class ChunkedUploadSession:
     """Tracks a single chunked upload."""
@@ -43,6 +64,45 @@ class ChunkedUploadSession:
     created_at: datetime = field(default_factory=lambda: datetime.now(timezone.utc))
     _hasher: hashlib._Hash = field(default_factory=hashlib.sha256, repr=False)
 
+    # --- parallel mode only -------------------------------------------------
+    parallel: bool = False
+    # One bit per chunk; bit set == chunk fully written to the temp file.
+    received_bitmap: bytearray = field(default_factory=bytearray, repr=False)
+    # Per-chunk SHA-256 hex digests (returned to the client for verification).
+    chunk_digests: Dict[int, str] = field(default_factory=dict, repr=False)
+    # Chunks currently being written (rejects concurrent duplicates).
+    _inflight: Set[int] = field(default_factory=set, repr=False)
+    # Number of leading chunks already fed into ``_hasher``.
+    _hashed_chunks: int = field(default=0, repr=False)
+    _hash_lock: threading.Lock = field(default_factory=threading.Lock, repr=False)
+
+    @property
+    def total_chunks(self) -> int:
+        if self.chunk_size <= 0:
+            return 0
+        return -(-self.total_size // self.chunk_size)
+
+    def chunk_length(self, chunk_index: int) -> int:
+        """Expected byte length of *chunk_index* (the last chunk may be short)."""
+        offset = chunk_index * self.chunk_size
+        return max(0, min(self.chunk_size, self.total_size - offset))
+
+    def has_chunk(self, chunk_index: int) -> bool:
+        byte = chunk_index >> 3
+        if byte >= len(self.received_bitmap):
+            return False
+        return bool(self.received_bitmap[byte] & (1 << (chunk_index & 7)))
+
+    def mark_chunk(self, chunk_index: int) -> None:
+        self.received_bitmap[chunk_index >> 3] |= 1 << (chunk_index & 7)
+
+    def missing_chunks(self) -> List[int]:
+        """Indices of chunks that have not been received yet (for resume)."""
+        return [i for i in range(self.total_chunks) if not self.has_chunk(i)]
+
+    def received_chunks(self) -> List[int]:
+        return [i for i in range(self.total_chunks) if self.has_chunk(i)]
+
 
 class ChunkedUploadManager:
     """In-memory session tracker for chunked uploads.
@@ -52,6 +112,9 @@ class ChunkedUploadManager:
 
     DEFAULT_CHUNK_SIZE = 32 * 1024 * 1024  # 32 MB
     MAX_CONCURRENT_WRITES_PER_USER = 16
+    # Streaming ring: peak buffer memory per in-flight chunk = 4 MiB.
+    STREAM_BUFFER_SIZE = 1024 * 1024
+    STREAM_BUFFER_COUNT = 4
 
     def __init__(self) -> None:
         self._sessions: Dict[str, ChunkedUploadSession] = {}
@@ -80,8 +143,13 @@ class ChunkedUploadManager:
         user_id: int,
         username: str,
         chunk_size: int | None = None,
+        parallel: bool = False,
     ) -> ChunkedUploadSession:
-        """Create a new chunked upload session and its temp file."""
+        """Create a new chunked upload session and its temp file.
+
+        With ``parallel=True`` the temp file is preallocated to *total_size*
+        and chunks may be written in any order (see module docstring).
+        """
         upload_id = str(uuid.uuid4())
         negotiated_chunk_size = chunk_size or self.DEFAULT_CHUNK_SIZE
 
@@ -97,14 +165,19 @@ class ChunkedUploadManager:
             temp_file_path=temp_path,
             user_id=user_id,
             username=username,
+            parallel=parallel,
         )
 
+        if parallel:
+            session.received_bitmap = bytearray((session.total_chunks + 7) // 8)
+            await asyncio.to_thread(self._preallocate, temp_path, total_size)
+
         async with self._lock:
             self._sessions[upload_id] = session
 
         logger.info(
-            "Chunked upload session created: id=%s file=%s size=%d chunk=%d",
-            upload_id, filename, total_size, negotiated_chunk_size,
+            "Chunked upload session created: id=%s file=%s size=%d chunk=%d parallel=%s",
+            upload_id, filename, total_size, negotiated_chunk_size, parallel,
         )
         return session
 
@@ -126,11 +199,14 @@ class ChunkedUploadManager:
             session = self._sessions.get(upload_id)
             if session is None:
                 raise ValueError(f"Unknown upload session: {upload_id}")
-            if chunk_index != session.next_chunk_index:
+            if not session.parallel and chunk_index != session.next_chunk_index:
                 raise ValueError(
                     f"Expected chunk {session.next_chunk_index}, got {chunk_index}"
                 )
 
+        if session.parallel:
+            return await self._write_chunk_parallel(session, chunk_index, data)
+
         # Overflow guard: outside the lock so abort_session can acquire it.
         if session.received_bytes + len(data) > session.total_size:
             await self.abort_session(upload_id)
@@ -163,9 +239,16 @@ class ChunkedUploadManager:
         """Stream chunk data directly to disk without buffering the whole chunk.
 
         *stream* is an async iterator yielding raw byte fragments (e.g.
-        ``request.stream()``).  Each fragment is appended to the temp file
-        immediately, keeping peak memory close to the network read-buffer size
-        rather than the full chunk size.
+        ``request.stream()``). Fragments are packed into a small ring of
+        reusable buffers (``STREAM_BUFFER_COUNT`` × ``STREAM_BUFFER_SIZE``)
+        that a single writer thread drains, writing and hashing each buffer
+        as it fills. Peak memory per upload is therefore bounded by the ring,
+        not the chunk size, and the ``total_size`` overflow guard fires as
+        soon as the stream crosses it.
+
+        If the stream fails part-way (client disconnect, disk error) the
+        sequential temp file is truncated back to the last complete chunk and
+        the session hasher is left untouched, so the chunk can be re-sent.
 
         Returns the total received bytes after this chunk.
         """
@@ -173,44 +256,324 @@ class ChunkedUploadManager:
             session = self._sessions.get(upload_id)
             if session is None:
                 raise ValueError(f"Unknown upload session: {upload_id}")
-            if chunk_index != session.next_chunk_index:
-                raise ValueError(
-                    f"Expected chunk {session.next_chunk_index}, got {chunk_index}"
+            if not session.parallel:
+                if chunk_index != session.next_chunk_index:
+                    raise ValueError(
+                        f"Expected chunk {session.next_chunk_index}, got {chunk_index}"
+                    )
+                if session._inflight:
+                    raise ValueError(f"Chunk {chunk_index} is already being written")
+                session._inflight.add(chunk_index)
+
+        if session.parallel:
+            return await self._write_chunk_stream_parallel(session, chunk_index, stream)
+
+        # Hash into a copy so a failed chunk never pollutes the session digest.
+        hasher = session._hasher.copy()
+        limit = session.total_size - session.received_bytes
+        try:
+            async with self._get_user_semaphore(session.user_id):
+                chunk_bytes = await self._pipe_stream_to_file(
+                    stream, session.temp_file_path, offset=None, limit=limit, hashers=[hasher],
                 )
+        except _StreamOverflow:
+            session._inflight.discard(chunk_index)
+            await self.abort_session(upload_id)
+            raise ValueError(
+                "Upload exceeds declared total_size "
+                f"({session.total_size} bytes) for session {upload_id}"
+            ) from None
+        except BaseException:
+            session._inflight.discard(chunk_index)
+            await asyncio.to_thread(
+                self._truncate_temp_file, session.temp_file_path, session.received_bytes,
+            )
+            raise
 
-        # Collect stream fragments, then write + hash in a worker thread
-        # so synchronous disk I/O doesn't block the event loop.
-        # Memory overhead = 1 chunk (same as before — network already buffered it).
-        parts: list[bytes] = []
-        async for part in stream:
-            parts.append(part)
+        async with self._lock:
+            session._inflight.discard(chunk_index)
+            session._hasher = hasher
+            session.received_bytes += chunk_bytes
+            session.next_chunk_index += 1
 
-        # Overflow guard: outside the lock so abort_session can acquire it.
-        incoming = sum(len(p) for p in parts)
-        if session.received_bytes + incoming > session.total_size:
+        return session.received_bytes
+
+    async def _write_chunk_stream_parallel(
+        self,
+        session: ChunkedUploadSession,
+        chunk_index: int,
+        stream: "AsyncIterator[bytes]",
+    ) -> int:
+        """Streaming counterpart of ``_write_chunk_parallel``."""
+        upload_id = session.upload_id
+        self._check_parallel_index(session, chunk_index)
+        expected = session.chunk_length(chunk_index)
+
+        async with self._lock:
+            if session.has_chunk(chunk_index):
+                return session.received_bytes
+            if chunk_index in session._inflight:
+                raise ValueError(f"Chunk {chunk_index} is already being written")
+            session._inflight.add(chunk_index)
+
+        chunk_hasher = hashlib.sha256()
+        hashers = [chunk_hasher]
+        # If this chunk extends the hashed prefix, hash it into the whole-file
+        # digest while streaming. Nobody else can advance the frontier past
+        # this index until it is marked, so the copy stays valid.
+        frontier_hasher = await asyncio.to_thread(self._frontier_copy, session, chunk_index)
+        if frontier_hasher is not None:
+            hashers.append(frontier_hasher)
+
+        try:
+            async with self._get_user_semaphore(session.user_id):
+                written = await self._pipe_stream_to_file(
+                    stream, session.temp_file_path,
+                    offset=chunk_index * session.chunk_size, limit=expected, hashers=hashers,
+                )
+        except _StreamOverflow:
+            session._inflight.discard(chunk_index)
+            if chunk_index == session.total_chunks - 1:
+                await self.abort_session(upload_id)
+                raise ValueError(
+                    "Upload exceeds declared total_size "
+                    f"({session.total_size} bytes) for session {upload_id}"
+                ) from None
+            raise ValueError(
+                f"Chunk {chunk_index} must be {expected} bytes, got more"
+            ) from None
+        except BaseException:
+            session._inflight.discard(chunk_index)
+            raise
+
+        if written != expected:
+            session._inflight.discard(chunk_index)
+            raise ValueError(f"Chunk {chunk_index} must be {expected} bytes, got {written}")
+
+        async with self._lock:
+            session._inflight.discard(chunk_index)
+            session.mark_chunk(chunk_index)
+            session.chunk_digests[chunk_index] = chunk_hasher.hexdigest()
+            session.received_bytes += written
+            received = session.received_bytes
+
+        await asyncio.to_thread(
+            self._advance_hash_frontier, session, chunk_index, prefix_hasher=frontier_hasher,
+        )
+        return received
+
+    async def _pipe_stream_to_file(
+        self,
+        stream: "AsyncIterator[bytes]",
+        path: Path,
+        *,
+        offset: Optional[int],
+        limit: int,
+        hashers: List["hashlib._Hash"],
+    ) -> int:
+        """Pump *stream* into *path* through a bounded ring of buffers.
+
+        The event loop copies fragments into free buffers and hands full ones
+        to a single writer thread, which writes (appending when *offset* is
+        ``None``, positionally otherwise), updates *hashers* and returns the
+        buffer to the ring. When all buffers are in flight the reader awaits
+        a free one, which backpressures the client instead of growing memory.
+
+        Raises ``_StreamOverflow`` as soon as more than *limit* bytes arrive.
+        Returns the number of bytes written.
+        """
+        loop = asyncio.get_running_loop()
+        free: asyncio.Queue = asyncio.Queue()
+        for _ in range(self.STREAM_BUFFER_COUNT):
+            free.put_nowait(bytearray(self.STREAM_BUFFER_SIZE))
+        filled: "queue.SimpleQueue[Optional[tuple[bytearray, int]]]" = queue.SimpleQueue()
+
+        def _writer() -> None:
+            flags = os.O_WRONLY | os.O_CREAT | (os.O_APPEND if offset is None else 0)
+            fd = os.open(path, flags, 0o600)
+            pos = offset or 0
+            try:
+                while True:
+                    item = filled.get()
+                    if item is None:
+                        return
+                    buf, length = item
+                    view = memoryview(buf)[:length]
+                    done = 0
+                    while done < length:
+                        if offset is None:
+                            done += os.write(fd, view[done:])
+                        else:
+                            done += os.pwrite(fd, view[done:], pos + done)
+                    pos += length
+                    for h in hashers:
+                        h.update(view)
+                    view.release()
+                    loop.call_soon_threadsafe(free.put_nowait, buf)
+            finally:
+                os.close(fd)
+                # Wakes a reader blocked on ``free.get()`` if we died early.
+                loop.call_soon_threadsafe(free.put_nowait, None)
+
+        writer = asyncio.ensure_future(asyncio.to_thread(_writer))
+        total = 0
+        buf: Optional[bytearray] = None
+        fill = 0
+        try:
+            async for part in stream:
+                total += len(part)
+                if total > limit:
+                    raise _StreamOverflow()
+                src = memoryview(part)
+                while src:
+                    if buf is None:
+                        buf = await free.get()
+                        if buf is None:
+                            await writer  # re-raises the writer's error
+                            raise OSError(f"Upload writer for {path.name} stopped")
+                        fill = 0
+                    n = min(len(src), len(buf) - fill)
+                    buf[fill:fill + n] = src[:n]
+                    fill += n
+                    src = src[n:]
+                    if fill == len(buf):
+                        filled.put((buf, fill))
+                        buf = None
+            if buf is not None and fill:
+                filled.put((buf, fill))
+                buf = None
+        except BaseException:
+            filled.put(None)
+            await asyncio.gather(writer, return_exceptions=True)
+            raise
+        filled.put(None)
+        await writer
+        return total
+
+    async def _write_chunk_parallel(
+        self,
+        session: ChunkedUploadSession,
+        chunk_index: int,
+        data: bytes,
+    ) -> int:
+        """Positional write of one chunk into a preallocated parallel session.
+
+        Re-sending a chunk that was already stored is a no-op (the client
+        may retry after losing the response), so resume is idempotent.
+        """
+        upload_id = session.upload_id
+        self._check_parallel_index(session, chunk_index)
+        expected = session.chunk_length(chunk_index)
+        if len(data) > expected and chunk_index == session.total_chunks - 1:
+            # Same disk-fill guard as the sequential path.
             await self.abort_session(upload_id)
             raise ValueError(
                 "Upload exceeds declared total_size "
                 f"({session.total_size} bytes) for session {upload_id}"
             )
+        if len(data) != expected:
+            raise ValueError(
+                f"Chunk {chunk_index} must be {expected} bytes, got {len(data)}"
+            )
 
-        def _write_and_hash() -> int:
-            written = 0
-            with open(session.temp_file_path, "ab") as f:
-                for p in parts:
-                    f.write(p)
-                    session._hasher.update(p)
-                    written += len(p)
-            return written
+        async with self._lock:
+            if session.has_chunk(chunk_index):
+                return session.received_bytes
+            if chunk_index in session._inflight:
+                raise ValueError(f"Chunk {chunk_index} is already being written")
+            session._inflight.add(chunk_index)
 
-        async with self._get_user_semaphore(session.user_id):
-            chunk_bytes = await asyncio.to_thread(_write_and_hash)
+        offset = chunk_index * session.chunk_size
+
+        def _pwrite_and_digest() -> str:
+            fd = os.open(session.temp_file_path, os.O_WRONLY)
+            try:
+                view = memoryview(data)
+                pos = 0
+                while pos < len(view):
+                    pos += os.pwrite(fd, view[pos:], offset + pos)
+            finally:
+                os.close(fd)
+            return hashlib.sha256(data).hexdigest()
+
+        try:
+            async with self._get_user_semaphore(session.user_id):
+                digest = await asyncio.to_thread(_pwrite_and_digest)
+        except BaseException:
+            async with self._lock:
+                session._inflight.discard(chunk_index)
+            raise
 
         async with self._lock:
-            session.received_bytes += chunk_bytes
-            session.next_chunk_index += 1
+            session._inflight.discard(chunk_index)
+            session.mark_chunk(chunk_index)
+            session.chunk_digests[chunk_index] = digest
+            session.received_bytes += len(data)
+            received = session.received_bytes
 
-        return session.received_bytes
+        # Try to extend the whole-file hash while the chunk is still in memory.
+        if chunk_index == session._hashed_chunks:
+            await asyncio.to_thread(self._advance_hash_frontier, session, chunk_index, data)
+        return received
+
+    @staticmethod
+    def _check_parallel_index(session: ChunkedUploadSession, chunk_index: int) -> None:
+        if chunk_index < 0 or chunk_index >= session.total_chunks:
+            raise ValueError(
+                f"Chunk index {chunk_index} out of range (0..{session.total_chunks - 1})"
+            )
+
+    @staticmethod
+    def _frontier_copy(
+        session: ChunkedUploadSession, chunk_index: int,
+    ) -> Optional["hashlib._Hash"]:
+        """Copy of the whole-file hasher if *chunk_index* is next in line."""
+        with session._hash_lock:
+            if session._hashed_chunks == chunk_index:
+                return session._hasher.copy()
+        return None
+
+    @staticmethod
+    def _advance_hash_frontier(
+        session: ChunkedUploadSession,
+        chunk_index: int | None = None,
+        data: bytes | None = None,
+        *,
+        prefix_hasher: Optional["hashlib._Hash"] = None,
+    ) -> None:
+        """Feed every contiguous received chunk into the session hasher.
+
+        *data* (if given) is the in-memory payload of *chunk_index*;
+        *prefix_hasher* is a ``_frontier_copy`` that already absorbed it
+        while streaming. Chunks beyond it that arrived early are read back
+        from the temp file.
+        """
+        with session._hash_lock:
+            if chunk_index is not None and chunk_index == session._hashed_chunks:
+                if prefix_hasher is not None:
+                    session._hasher = prefix_hasher
+                    session._hashed_chunks += 1
+                elif data is not None:
+                    session._hasher.update(data)
+                    session._hashed_chunks += 1
+            if not session.has_chunk(session._hashed_chunks):
+                return
+            fd = os.open(session.temp_file_path, os.O_RDONLY)
+            try:
+                while session.has_chunk(session._hashed_chunks):
+                    idx = session._hashed_chunks
+                    length = session.chunk_length(idx)
+                    offset = idx * session.chunk_size
+                    pos = 0
+                    while pos < length:
+                        block = os.pread(fd, min(length - pos, 4 * 1024 * 1024), offset + pos)
+                        if not block:
+                            raise OSError(f"Short read in temp file for chunk {idx}")
+                        session._hasher.update(block)
+                        pos += len(block)
+                    session._hashed_chunks += 1
+            finally:
+                os.close(fd)
 
     async def complete_session(self, upload_id: str) -> tuple[Path, str]:
         """Finalise the upload: return the temp file path and SHA-256 hex digest.
@@ -220,13 +583,24 @@ class ChunkedUploadManager:
         After calling this the session is removed.
         """
         async with self._lock:
-            session = self._sessions.pop(upload_id, None)
-        if session is None:
-            raise ValueError(f"Unknown upload session: {upload_id}")
+            session = self._sessions.get(upload_id)
+            if session is None:
+                raise ValueError(f"Unknown upload session: {upload_id}")
+            if session.parallel:
+                missing = session.missing_chunks()
+                if missing or session._inflight:
+                    # Keep the session so the client can resume the gaps.
+                    raise ValueError(
+                        f"Upload incomplete: {len(missing)} chunk(s) missing "
+                        f"(first: {missing[0] if missing else 'in flight'})"
+                    )
+            self._sessions.pop(upload_id, None)
 
         if not session.temp_file_path.exists():
             raise FileNotFoundError(f"Temp file missing for session {upload_id}")
 
+        if session.parallel:
+            await asyncio.to_thread(self._advance_hash_frontier, session)
         sha256_hex = session._hasher.hexdigest()
 
         logger.info(
@@ -287,6 +661,30 @@ class ChunkedUploadManager:
     # Helpers
     # ------------------------------------------------------------------
 
+    @staticmethod
+    def _preallocate(path: Path, size: int) -> None:
+        """Create *path* with *size* bytes reserved (sparse if unsupported)."""
+        fd = os.open(path, os.O_WRONLY | os.O_CREAT | os.O_TRUNC, 0o600)
+        try:
+            if size > 0 and hasattr(os, "posix_fallocate"):
+                try:
+                    os.posix_fallocate(fd, 0, size)
+                    return
+                except OSError:
+                    pass  # e.g. EOPNOTSUPP on some FUSE/tmpfs mounts
+            os.ftruncate(fd, size)
+        finally:
+            os.close(fd)
+
+    @staticmethod
+    def _truncate_temp_file(path: Path, size: int) -> None:
+        """Drop a partially appended chunk so the client can re-send it."""
+        try:
+            if path.exists():
+                os.truncate(path, size)
+        except OSError as exc:
+            logger.warning("Failed to truncate temp file %s: %s", path, exc)
+
     @staticmethod
     def _remove_temp_file(path: Path) -> None:
         try:
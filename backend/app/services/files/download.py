@@ -0,0 +1,425 @@
+"""HTTP download engine for storage files.
+
+Serves files (from the HDD array or the SSD file cache) with:
+
+* **Range requests** — single and multi-range (``multipart/byteranges``),
+  ``If-Range`` and ``416`` for unsatisfiable ranges, so video scrubbing and
+  resumed downloads only transfer the bytes they need.
+* **Conditional GET** — ``If-None-Match`` / ``If-Modified-Since`` (plus
+  ``If-Match`` / ``If-Unmodified-Since``). The ETag is the stored SHA-256
+  from ``FileMetadata`` when that checksum is provably current for the file
+  on disk, otherwise a weak mtime/size validator.
+* **Zero-copy delivery** — when ``settings.download_accel_redirect_prefix`` is
+  set, the response body of a file below the storage or SSD-cache root is
+  handed to nginx via ``X-Accel-Redirect`` (nginx ``sendfile`` + its own
+  range handling). nginx then owns the validators too: it sends its own
+  mtime/size ETag and Last-Modified and evaluates every conditional header
+  against them, so the backend checks none itself on that path. Cache
+  copies keep the source mtime, so both internal locations agree; a
+  deployment switching accel on or off sees every ETag change once.
+  Without nginx, the ASGI
+  ``http.response.zerocopysend`` extension is used where the server offers
+  it; otherwise the file is streamed in ``READ_BLOCK_SIZE`` positional reads
+  off the event loop.
+
+Routes call :func:`build_download_response`; validators are always derived
+from the *source* file so the HDD and SSD-cache paths agree on ETags.
+"""
+from __future__ import annotations
+
+import asyncio
+import email.utils
+import mimetypes
+import os
+import secrets
+from dataclasses import dataclass
+from datetime import datetime, timezone
+from pathlib import Path
+from typing import List, Mapping, Optional, Sequence, Tuple
+from urllib.parse import quote
+
+from starlette.responses import Response
+from starlette.types import Receive, Scope, Send
+
+from app.core.config import settings
+
+# Requests with more ranges than this are answered with the full body
+# (RFC 9110 §14.2 allows ignoring Range; protects against range amplification).
+MAX_RANGES = 16
+READ_BLOCK_SIZE = 256 * 1024
+# Metadata written within this window before the file's mtime is still
+# considered to describe the current content (filesystem timestamp slop).
+_CHECKSUM_MTIME_SLACK_SECONDS = 2.0
+
+ByteRange = Tuple[int, int]  # inclusive (first, last)
+
+
+# ---------------------------------------------------------------------------
+# Validators
+# ---------------------------------------------------------------------------
+
+def make_etag(
+    st: os.stat_result,
+    checksum: Optional[str] = None,
+    metadata_size: Optional[int] = None,
+    metadata_timestamp: Optional[datetime] = None,
+) -> str:
+    """Return the ETag for a file.
+
+    The stored SHA-256 is only used as a strong ETag when the metadata row
+    matches the file on disk (same size, written no earlier than the last
+    modification). Writes through SMB/NFS bypass the metadata layer, so a
+    stale checksum must never produce a false ``304``.
+    """
+    if checksum and metadata_size == st.st_size and metadata_timestamp is not None:
+        ts = metadata_timestamp
+        if ts.tzinfo is None:
+            ts = ts.replace(tzinfo=timezone.utc)
+        if ts.timestamp() + _CHECKSUM_MTIME_SLACK_SECONDS >= st.st_mtime:
+            return f'"{checksum}"'
+    return f'W/"{st.st_mtime_ns:x}-{st.st_size:x}"'
+
+
+def _split_etags(header: str) -> List[str]:
+    return [tag.strip() for tag in header.split(",") if tag.strip()]
+
+
+def _opaque(tag: str) -> str:
+    return tag[2:] if tag.startswith("W/") else tag
+
+
+def _weak_match(header: str, etag: str) -> bool:
+    tags = _split_etags(header)
+    return "*" in tags or any(_opaque(t) == _opaque(etag) for t in tags)
+
+
+def _strong_match(header: str, etag: str) -> bool:
+    if etag.startswith("W/"):
+        return "*" in _split_etags(header)
+    tags = _split_etags(header)
+    return "*" in tags or etag in tags
+
+
+def _parse_http_date(value: Optional[str]) -> Optional[float]:
+    if not value:
+        return None
+    try:
+        return email.utils.parsedate_to_datetime(value).timestamp()
+    except (TypeError, ValueError, IndexError):
+        return None
+
+
+def evaluate_preconditions(
+    headers: Mapping[str, str],
+    etag: str,
+    mtime: float,
+    method: str = "GET",
+) -> Optional[int]:
+    """Evaluate RFC 9110 §13.2.2 preconditions.
+
+    Returns ``304`` / ``412`` when the request short-circuits, else ``None``.
+    """
+    mtime = int(mtime)  # HTTP dates have second resolution
+    if_match = headers.get("if-match")
+    if if_match is not None:
+        if not _strong_match(if_match, etag):
+            return 412
+    else:
+        since = _parse_http_date(headers.get("if-unmodified-since"))
+        if since is not None and mtime > since:
+            return 412
+
+    if_none_match = headers.get("if-none-match")
+    if if_none_match is not None:
+        if _weak_match(if_none_match, etag):
+            return 304 if method in ("GET", "HEAD") else 412
+    elif method in ("GET", "HEAD"):
+        since = _parse_http_date(headers.get("if-modified-since"))
+        if since is not None and mtime <= since:
+            return 304
+    return None
+
+
+def if_range_allows(headers: Mapping[str, str], etag: str, mtime: float) -> bool:
+    """``If-Range``: honour Range only if the representation is unchanged."""
+    value = headers.get("if-range")
+    if value is None:
+        return True
+    value = value.strip()
+    if value.startswith('"') or value.startswith("W/"):
+        return not etag.startswith("W/") and value == etag
+    since = _parse_http_date(value)
+    return since is not None and int(mtime) == int(since)
+
+
+# ---------------------------------------------------------------------------
+# Range parsing
+# ---------------------------------------------------------------------------
+
+def parse_range_header(header: Optional[str], size: int) -> Optional[List[ByteRange]]:
+    """Parse a ``Range`` header against a representation of *size* bytes.
+
+    Returns ``None`` when the header should be ignored (absent, malformed,
+    not ``bytes``, too many ranges) and the full body served; an empty list
+    when no range is satisfiable (``416``); otherwise sorted, coalesced
+    inclusive ranges.
+    """
+    if not header:
+        return None
+    unit, _, spec = header.partition("=")
+    if unit.strip().lower() != "bytes" or not spec.strip():
+        return None
+
+    ranges: List[ByteRange] = []
+    parts = [p.strip() for p in spec.split(",") if p.strip()]
+    if len(parts) > MAX_RANGES:
+        return None
+    for part in parts:
+        first_s, sep, last_s = part.partition("-")
+        if not sep:
+            return None
+        first_s, last_s = first_s.strip(), last_s.strip()
+        try:
+            if first_s == "":
+                if not last_s:
+                    return None
+                suffix = int(last_s)
+                if suffix < 0:
+                    return None
+                if suffix == 0 or size == 0:
+                    continue
+                ranges.append((max(0, size - suffix), size - 1))
+                continue
+            first = int(first_s)
+            last = int(last_s) if last_s else size - 1
+        except ValueError:
+            return None
+        if first < 0 or (last_s and last < first):
+            return None
+        if first >= size:
+            continue  # unsatisfiable on its own
+        ranges.append((first, min(last, size - 1)))
+
+    ranges.sort()
+    merged: List[ByteRange] = []
+    for first, last in ranges:
+        if merged and first <= merged[-1][1] + 1:
+            merged[-1] = (merged[-1][0], max(merged[-1][1], last))
+        else:
+            merged.append((first, last))
+    return merged
+
+
+# ---------------------------------------------------------------------------
+# Response
+# ---------------------------------------------------------------------------
+
+def content_disposition(filename: str, disposition: str = "attachment") -> str:
+    quoted = quote(filename)
+    if quoted != filename:
+        return f"{disposition}; filename*=utf-8''{quoted}"
+    return f'{disposition}; filename="{filename}"'
+
+
+def accel_redirect_uri(prefix: str, path: Path) -> Optional[str]:
+    """nginx-internal URI serving *path*, or None when nginx cannot serve it.
+
+    nginx has one internal location per root, ``<prefix>/storage/`` and
+    ``<prefix>/cache/`` (see deploy/nginx/baluhost.conf), so the URI is the
+    path relative to that root. Files elsewhere (e.g. a custom cache path)
+    are streamed by the backend.
+    """
+    from app.services.cache.ssd_file_cache import cache_base_path
+    from app.services.files import path_utils
+
+    resolved = path.resolve()
+    for location, root in (
+        ("storage", path_utils.ROOT_DIR),
+        ("cache", Path(cache_base_path()).resolve()),
+    ):
+        try:
+            relative = resolved.relative_to(root)
+        except ValueError:
+            continue
+        return f"{prefix.rstrip('/')}/{location}/{quote(relative.as_posix())}"
+    return None
+
+
+@dataclass
+class _Segment:
+    prefix: bytes   # multipart part header (empty for single-range / full body)
+    offset: int
+    count: int
+
+
+class RangeFileResponse(Response):
+    """ASGI response streaming one or more byte ranges of a file."""
+
+    def __init__(
+        self,
+        path: Path,
+        *,
+        status_code: int,
+        headers: Mapping[str, str],
+        segments: Sequence[_Segment],
+        trailer: bytes = b"",
+        media_type: Optional[str] = None,
+    ) -> None:
+        self.path = path
+        self.status_code = status_code
+        self.media_type = media_type
+        self.background = None
+        self.segments = list(segments)
+        self.trailer = trailer
+        self.init_headers(dict(headers))
+
+    async def __call__(self, scope: Scope, receive: Receive, send: Send) -> None:
+        await send({
+            "type": "http.response.start",
+            "status": self.status_code,
+            "headers": self.raw_headers,
+        })
+        if scope.get("method", "GET").upper() == "HEAD":
+            await send({"type": "http.response.body", "body": b"", "more_body": False})
+            return
+
+        zerocopy = "http.response.zerocopysend" in scope.get("extensions", {})
+        fh = await asyncio.to_thread(open, self.path, "rb")
+        try:
+            for segment in self.segments:
+                if segment.prefix:
+                    await send({"type": "http.response.body", "body": segment.prefix, "more_body": True})
+                if zerocopy:
+                    await send({
+                        "type": "http.response.zerocopysend",
+                        "file": fh,
+                        "offset": segment.offset,
+                        "count": segment.count,
+                        "more_body": True,
+                    })
+                    continue
+                fd = fh.fileno()
+                pos, remaining = segment.offset, segment.count
+                while remaining > 0:
+                    block = await asyncio.to_thread(
+                        os.pread, fd, min(READ_BLOCK_SIZE, remaining), pos,
+                    )
+                    if not block:
+                        break  # file shrank underneath us
+                    pos += len(block)
+                    remaining -= len(block)
+                    await send({"type": "http.response.body", "body": block, "more_body": True})
+            await send({"type": "http.response.body", "body": self.trailer, "more_body": False})
+        finally:
+            await asyncio.to_thread(fh.close)
+
+
+def build_download_response(
+    request_headers: Mapping[str, str],
+    serve_path: Path,
+    filename: str,
+    *,
+    method: str = "GET",
+    source_stat: Optional[os.stat_result] = None,
+    checksum: Optional[str] = None,
+    metadata_size: Optional[int] = None,
+    metadata_timestamp: Optional[datetime] = None,
+) -> Response:
+    """Build the response for downloading *serve_path*.
+
+    *source_stat* is the stat of the authoritative (HDD) file when
+    *serve_path* is an SSD-cache copy; validators are computed from it so
+    both paths yield the same ETag/Last-Modified.
+    """
+    media_type = mimetypes.guess_type(filename)[0] or "application/octet-stream"
+    accel_prefix = settings.download_accel_redirect_prefix
+    accel_uri = accel_redirect_uri(accel_prefix, serve_path) if accel_prefix else None
+    if accel_uri:
+        # nginx answers Range/If-Range and every conditional from the file
+        # with its own ETag/Last-Modified; sending ours as well would give
+        # the client validators nginx then judges If-Match against.
+        accel_headers = {
+            "cache-control": "private, no-cache",
+            "content-disposition": content_disposition(filename),
+            "x-accel-redirect": accel_uri,
+        }
+        return Response(status_code=200, headers=accel_headers, media_type=media_type)
+
+    serve_stat = serve_path.stat()
+    validator_stat = source_stat or serve_stat
+    size = serve_stat.st_size
+    etag = make_etag(validator_stat, checksum, metadata_size, metadata_timestamp)
+    mtime = validator_stat.st_mtime
+
+    base_headers = {
+        "etag": etag,
+        "last-modified": email.utils.formatdate(mtime, usegmt=True),
+        "accept-ranges": "bytes",
+        "cache-control": "private, no-cache",
+    }
+
+    precondition = evaluate_preconditions(request_headers, etag, mtime, method)
+    if precondition is not None:
+        return Response(status_code=precondition, headers=base_headers)
+
+    base_headers["content-disposition"] = content_disposition(filename)
+
+    ranges = None
+    if if_range_allows(request_headers, etag, mtime):
+        ranges = parse_range_header(request_headers.get("range"), size)
+
+    if ranges is not None and not ranges:
+        return Response(
+            status_code=416,
+            headers={**base_headers, "content-range": f"bytes */{size}"},
+        )
+
+    if ranges is None:
+        headers = {**base_headers, "content-length": str(size)}
+        return RangeFileResponse(
+            serve_path, status_code=200, headers=headers,
+            segments=[_Segment(b"", 0, size)], media_type=media_type,
+        )
+
+    if len(ranges) == 1:
+        first, last = ranges[0]
+        headers = {
+            **base_headers,
+            "content-range": f"bytes {first}-{last}/{size}",
+            "content-length": str(last - first + 1),
+        }
+        return RangeFileResponse(
+            serve_path, status_code=206, headers=headers,
+            segments=[_Segment(b"", first, last - first + 1)], media_type=media_type,
+        )
+
+    boundary = secrets.token_hex(12)
+    segments: List[_Segment] = []
+    for i, (first, last) in enumerate(ranges):
+        separator = "" if i == 0 else "\r\n"
+        prefix = (
+            f"{separator}--{boundary}\r\n"
+            f"Content-Type: {media_type}\r\n"
+            f"Content-Range: bytes {first}-{last}/{size}\r\n\r\n"
+        ).encode("latin-1")
+        segments.append(_Segment(prefix, first, last - first + 1))
+    trailer = f"\r\n--{boundary}--\r\n".encode("latin-1")
+    length = sum(len(s.prefix) + s.count for s in segments) + len(trailer)
+    headers = {**base_headers, "content-length": str(length)}
+    return RangeFileResponse(
+        serve_path, status_code=206, headers=headers, segments=segments,
+        trailer=trailer, media_type=f"multipart/byteranges; boundary={boundary}",
+    )
+
+
+def is_initial_request(request_headers: Mapping[str, str]) -> bool:
+    """True unless this is a continuation request (Range not starting at 0).
+
+    Used to log one download activity per transfer instead of one per seek.
+    """
+    header = request_headers.get("range")
+    if not header:
+        return True
+    _, _, spec = header.partition("=")
+    first = spec.split(",")[0].strip()
+    return first.startswith("0-")
@@ -1,55 +1,90 @@
-"""Recursive folder size calculation with TTL cache.
+"""Persistent folder-size index.
 
-Follows the same caching pattern as ``_used_bytes_cache`` in ``operations.py``.
+Every indexed directory has one row holding the bytes of its direct files
+(``own_bytes``) and of its whole subtree (``total_bytes``), so any
+directory's size is a single primary-key lookup. The index is a small
+SQLite database in WAL mode under ``<storage>/.system/`` and is therefore
+shared by all workers and survives restarts.
+
+Invariant: if a directory has a row, so do all of its subdirectories, and
+``total = own + sum(child totals)``. It is built lazily — the first
+``get_folder_size`` of an unindexed directory scans that subtree once and
+records every level — and kept current incrementally:
+
+- file writes and deletes through the API (``operations.py``, chunked
+  uploads, sync deltas) know the size change of the file and call
+  ``record_file_size_change``: one UPDATE adds it to the parent and its
+  ancestors, nothing is scanned;
+- everything else that changes a directory (new or removed directories,
+  WebDAV writes) calls ``invalidate_folder_sizes_for_path``, which rescans
+  only that directory's direct entries and pushes the delta up the
+  ancestor chain;
+- directory moves carry their subtree rows to the new location
+  (``move_folder_sizes``), so nothing is rescanned;
+- writes from outside the API (SMB, NFS, WebDAV) are picked up by the
+  inotify watcher in ``folder_size_watcher.py`` on the primary worker.
+
+A delta and a rescan must not both count the same write: the inotify
+watcher may rescan a directory while an upload batch is still writing to
+it. Every scan stamps the rows it wrote with ``scanned``, a number from a
+shared sequence allocated after the directory was read. Writers take
+``folder_size_token()`` (the newest number) before they touch the disk and
+pass it with their deltas; a directory scanned after the token may already
+include the write, so instead of adding the delta it is rescanned.
+
+Paths outside the storage root and the root-level system directories
+(``.system`` holds the index itself, ``.tmp`` churns with uploads) are not
+indexed; they are scanned directly with a short TTL memo.
+
+Every touch/move/clear is also appended to a short change log
+(``changes``), whether or not the path is indexed. Other processes that
+cache directory state — the WebDAV worker's PROPFIND cache — follow it
+with ``changes_since`` instead of watching the tree themselves.
 """
 
 from __future__ import annotations
 
+import logging
 import os
+import sqlite3
 import threading
 import time
-from pathlib import Path
+from pathlib import Path, PurePosixPath
+from typing import Callable, Iterable, Optional
 
-# Cache: absolute path string → (size_bytes, timestamp)
-_folder_size_cache: dict[str, tuple[int, float]] = {}
-_folder_size_cache_lock = threading.Lock()
-_FOLDER_SIZE_CACHE_TTL = 300.0  # 5 minutes
-_FOLDER_SIZE_CACHE_MAX_ENTRIES = 2048  # prevent unbounded growth
+logger = logging.getLogger(__name__)
 
+INDEX_FILENAME = "folder_sizes.sqlite3"
 
-def get_folder_size(path: Path) -> int:
-    """Return total size of all files inside *path* (recursive).
+# Memo for the unindexed paths (system dirs, outside the root)
+_SCAN_MEMO_TTL = 300.0
+_SCAN_MEMO_MAX_ENTRIES = 256
 
-    Results are cached for 5 minutes.  Uses ``os.scandir()`` for speed and
-    ``follow_symlinks=False`` to avoid loops.
-    """
-    key = str(path)
-    now = time.time()
-
-    with _folder_size_cache_lock:
-        cached = _folder_size_cache.get(key)
-        if cached is not None:
-            size, ts = cached
-            if now - ts < _FOLDER_SIZE_CACHE_TTL:
-                return size
-
-    total = _scan_size(path)
-
-    with _folder_size_cache_lock:
-        # Evict expired entries when cache exceeds max size
-        if len(_folder_size_cache) >= _FOLDER_SIZE_CACHE_MAX_ENTRIES:
-            expired = [k for k, (_, ts) in _folder_size_cache.items()
-                       if now - ts >= _FOLDER_SIZE_CACHE_TTL]
-            for k in expired:
-                del _folder_size_cache[k]
-            # If still over limit, drop oldest half
-            if len(_folder_size_cache) >= _FOLDER_SIZE_CACHE_MAX_ENTRIES:
-                sorted_keys = sorted(_folder_size_cache, key=lambda k: _folder_size_cache[k][1])
-                for k in sorted_keys[:len(sorted_keys) // 2]:
-                    del _folder_size_cache[k]
-        _folder_size_cache[key] = (total, now)
+# Change log rows kept for followers; older ones are pruned every 1000 rows
+_CHANGE_LOG_KEEP = 10_000
+# A follower further behind than this just drops its whole cache
+_CHANGE_LOG_MAX_BATCH = 5_000
 
-    return total
+# ``since`` for callers without a token: every row qualifies
+_UNSCANNED_MAX = 2**63 - 1
+
+_SCHEMA = """
+CREATE TABLE IF NOT EXISTS dirs (
+    path        TEXT PRIMARY KEY,
+    parent      TEXT,
+    own_bytes   INTEGER NOT NULL,
+    total_bytes INTEGER NOT NULL,
+    scanned     INTEGER NOT NULL DEFAULT 0  -- scans.seq of the scan behind own_bytes
+) WITHOUT ROWID;
+CREATE INDEX IF NOT EXISTS dirs_parent ON dirs(parent);
+CREATE TABLE IF NOT EXISTS scans (
+    seq  INTEGER PRIMARY KEY AUTOINCREMENT  -- only the newest row is kept
+);
+CREATE TABLE IF NOT EXISTS changes (
+    seq  INTEGER PRIMARY KEY AUTOINCREMENT,
+    path TEXT  -- NULL: everything (index cleared)
+);
+"""
 
 
 def _scan_size(path: Path) -> int:
@@ -70,18 +105,529 @@ def _scan_size(path: Path) -> int:
     return total
 
 
+def _scan_direct(path: Path) -> tuple[int, list[str]]:
+    """Return (bytes of direct files, names of direct subdirectories)."""
+    own = 0
+    subdirs: list[str] = []
+    try:
+        with os.scandir(path) as it:
+            for entry in it:
+                try:
+                    if entry.is_dir(follow_symlinks=False):
+                        subdirs.append(entry.name)
+                    elif entry.is_file(follow_symlinks=False):
+                        own += entry.stat(follow_symlinks=False).st_size
+                except (PermissionError, OSError):
+                    continue
+    except (PermissionError, OSError):
+        pass
+    return own, subdirs
+
+
+def _join(parent: str, name: str) -> str:
+    return f"{parent}/{name}" if parent else name
+
+
+def _parent_of(rel: str) -> Optional[str]:
+    if rel == "":
+        return None
+    parent = PurePosixPath(rel).parent.as_posix()
+    return "" if parent == "." else parent
+
+
+def _ancestors(rel: str) -> list[str]:
+    """Strict ancestors of *rel*, nearest first, ending with the root ``""``."""
+    result = []
+    current = _parent_of(rel)
+    while current is not None:
+        result.append(current)
+        current = _parent_of(current)
+    return result
+
+
+def _subtree_bounds(rel: str) -> tuple[str, str]:
+    """Half-open ``[lo, hi)`` range covering every strict descendant of *rel*."""
+    # '0' sorts directly after '/', so "a/" <= path < "a0" selects "a/..."
+    prefix = f"{rel}/" if rel else ""
+    return prefix, (f"{rel}0" if rel else "\U0010ffff")
+
+
+class FolderSizeIndex:
+    """SQLite-backed directory aggregates (see module docstring)."""
+
+    def __init__(
+        self,
+        root: Path,
+        db_path: Path,
+        *,
+        is_excluded: Callable[[str], bool] = lambda name: False,
+    ) -> None:
+        self.root = Path(root).resolve()
+        self.db_path = Path(db_path)
+        # Root-level directory names that are never indexed
+        self._is_excluded = is_excluded
+        self._local = threading.local()
+        self._listeners: list[Callable[[list[str]], None]] = []
+        self._memo: dict[str, tuple[int, float]] = {}
+        self._memo_lock = threading.Lock()
+
+    # ------------------------------------------------------------------
+    # Connection
+    # ------------------------------------------------------------------
+
+    def _conn(self) -> sqlite3.Connection:
+        conn = getattr(self._local, "conn", None)
+        if conn is not None:
+            # The storage tree may have been wiped and recreated underneath us
+            try:
+                if os.stat(self.db_path).st_ino == self._local.inode:
+                    return conn
+            except OSError:
+                pass
+            conn.close()
+        self.db_path.parent.mkdir(parents=True, exist_ok=True)
+        conn = sqlite3.connect(self.db_path, timeout=30.0, isolation_level=None)
+        conn.execute("PRAGMA journal_mode=WAL")
+        conn.execute("PRAGMA synchronous=NORMAL")
+        conn.executescript(_SCHEMA)
+        columns = {r[1] for r in conn.execute("PRAGMA table_info(dirs)")}
+        if "scanned" not in columns:  # index written before scan stamps
+            conn.execute("ALTER TABLE dirs ADD COLUMN scanned INTEGER NOT NULL DEFAULT 0")
+        self._local.conn = conn
+        self._local.inode = os.stat(self.db_path).st_ino
+        return conn
+
+    def close(self) -> None:
+        conn = getattr(self._local, "conn", None)
+        if conn is not None:
+            conn.close()
+            self._local.conn = None
+
+    def add_listener(self, callback: Callable[[list[str]], None]) -> None:
+        """Call *callback* with relative paths of newly indexed directories."""
+        self._listeners.append(callback)
+
+    def _notify(self, paths: list[str]) -> None:
+        for callback in self._listeners:
+            try:
+                callback(paths)
+            except Exception:
+                logger.debug("folder size listener failed", exc_info=True)
+
+    def relative(self, path: Path) -> Optional[str]:
+        """Index key for *path*, or None if it is not indexed."""
+        try:
+            rel = Path(path).resolve().relative_to(self.root).as_posix()
+        except (ValueError, OSError):
+            return None
+        if rel == ".":
+            return ""
+        return None if self._is_excluded(rel.split("/", 1)[0]) else rel
+
+    def _subdirs(self, rel: str, names: list[str]) -> list[str]:
+        if rel:
+            return names
+        return [n for n in names if not self._is_excluded(n)]
+
+    def _scan_memoized(self, path: Path) -> int:
+        key = str(path)
+        now = time.monotonic()
+        with self._memo_lock:
+            cached = self._memo.get(key)
+            if cached is not None and now - cached[1] < _SCAN_MEMO_TTL:
+                return cached[0]
+        total = _scan_size(path)
+        with self._memo_lock:
+            if len(self._memo) >= _SCAN_MEMO_MAX_ENTRIES:
+                self._memo.clear()
+            self._memo[key] = (total, now)
+        return total
+
+    def _abs(self, rel: str) -> Path:
+        return self.root / rel if rel else self.root
+
+    # ------------------------------------------------------------------
+    # Building
+    # ------------------------------------------------------------------
+
+    def _collect(self, rel: str, rows: list[tuple[str, Optional[str], int, int]]) -> int:
+        """Scan *rel* recursively, appending one row per directory (post-order)."""
+        own, subdirs = _scan_direct(self._abs(rel))
+        total = own
+        for name in self._subdirs(rel, subdirs):
+            total += self._collect(_join(rel, name), rows)
+        rows.append((rel, _parent_of(rel), own, total))
+        return total
+
+    # ------------------------------------------------------------------
+    # Queries
+    # ------------------------------------------------------------------
+
+    def get(self, path: Path) -> int:
+        rel = self.relative(path)
+        if rel is None:
+            return self._scan_memoized(path)
+        conn = self._conn()
+        row = conn.execute("SELECT total_bytes FROM dirs WHERE path = ?", (rel,)).fetchone()
+        if row is not None:
+            return int(row[0])
+
+        # First request for this subtree: scan it once outside any write
+        # lock, then keep rows another worker may have written meanwhile.
+        rows: list[tuple[str, Optional[str], int, int]] = []
+        total = self._collect(rel, rows)
+        conn.execute("BEGIN IMMEDIATE")
+        try:
+            scanned = self._next_scan(conn)
+            conn.executemany(
+                "INSERT OR IGNORE INTO dirs (path, parent, own_bytes, total_bytes, scanned) "
+                "VALUES (?, ?, ?, ?, ?)",
+                [(*r, scanned) for r in rows],
+            )
+            conn.execute("COMMIT")
+        except BaseException:
+            conn.execute("ROLLBACK")
+            raise
+        self._notify([r[0] for r in rows])
+        row = conn.execute("SELECT total_bytes FROM dirs WHERE path = ?", (rel,)).fetchone()
+        return int(row[0]) if row is not None else total
+
+    def get_many(self, paths: Iterable[Path]) -> dict[Path, int]:
+        """Sizes for several directories (one round trip for indexed ones)."""
+        paths = list(paths)
+        rels = {p: self.relative(p) for p in paths}
+        keys = [r for r in rels.values() if r is not None]
+        known: dict[str, int] = {}
+        conn = self._conn()
+        for start in range(0, len(keys), 500):
+            chunk = keys[start:start + 500]
+            marks = ",".join("?" * len(chunk))
+            known.update(
+                (p, int(t)) for p, t in conn.execute(
+                    f"SELECT path, total_bytes FROM dirs WHERE path IN ({marks})", chunk,
+                )
+            )
+        return {
+            p: known[r] if r is not None and r in known else self.get(p)
+            for p, r in rels.items()
+        }
+
+    def indexed_paths(self) -> list[str]:
+        return [r[0] for r in self._conn().execute("SELECT path FROM dirs")]
+
+    # ------------------------------------------------------------------
+    # Change log
+    # ------------------------------------------------------------------
+
+    def _log_changes(self, conn: sqlite3.Connection, rels: list[Optional[str]]) -> None:
+        conn.executemany("INSERT INTO changes (path) VALUES (?)", [(r,) for r in rels])
+        last = conn.execute("SELECT last_insert_rowid()").fetchone()[0]
+        if last // 1000 != (last - len(rels)) // 1000:
+            conn.execute("DELETE FROM changes WHERE seq <= ?", (last - _CHANGE_LOG_KEEP,))
+
+    def change_cursor(self) -> int:
+        """Position of the newest change-log entry (start point for a follower)."""
+        row = self._conn().execute("SELECT MAX(seq) FROM changes").fetchone()
+        return int(row[0] or 0)
+
+    def changes_since(self, cursor: int) -> tuple[int, Optional[list[Optional[str]]]]:
+        """Changed paths after *cursor* and the new cursor.
+
+        Paths are index keys (``None`` = everything changed). Returns None
+        instead of a list when the log no longer reaches back to *cursor*
+        (pruned, or the index was recreated): the follower must assume
+        everything changed.
+        """
+        conn = self._conn()
+        newest = int(conn.execute("SELECT MAX(seq) FROM changes").fetchone()[0] or 0)
+        if newest < cursor:
+            return newest, None
+        rows = conn.execute(
+            "SELECT seq, path FROM changes WHERE seq > ? ORDER BY seq LIMIT ?",
+            (cursor, _CHANGE_LOG_MAX_BATCH + 1),
+        ).fetchall()
+        if not rows:
+            return cursor, []
+        # Sequence numbers are gapless (AUTOINCREMENT; rollbacks reuse them)
+        if rows[0][0] != cursor + 1 or len(rows) > _CHANGE_LOG_MAX_BATCH:
+            return newest, None
+        return int(rows[-1][0]), [r[1] for r in rows]
+
+    # ------------------------------------------------------------------
+    # Incremental maintenance
+    # ------------------------------------------------------------------
+
+    def scan_token(self) -> int:
+        """Newest scan number; take it before writing files (see ``apply_delta``)."""
+        row = self._conn().execute("SELECT MAX(seq) FROM scans").fetchone()
+        return int(row[0] or 0)
+
+    def _next_scan(self, conn: sqlite3.Connection) -> int:
+        """Number for a scan whose results are being written (inside its transaction)."""
+        seq = conn.execute("INSERT INTO scans DEFAULT VALUES").lastrowid
+        conn.execute("DELETE FROM scans WHERE seq < ?", (seq,))
+        return int(seq)
+
+    def apply_delta(self, path: Path, delta: int, since: Optional[int] = None) -> bool:
+        """The file *path* grew by *delta* bytes (negative: shrank or was removed).
+
+        Adds *delta* to its directory's ``own_bytes`` and to the totals of
+        that directory and its ancestors, without scanning. *since* is the
+        ``scan_token()`` taken before the file was written. Returns False
+        when the directory has no row (not indexed, or created since) or was
+        scanned after *since* (the scan may already count the write); then
+        nothing is changed and the caller falls back to ``touch``.
+        """
+        rel = self.relative(Path(path).parent)
+        if rel is None:
+            return True
+        conn = self._conn()
+        conn.execute("BEGIN IMMEDIATE")
+        try:
+            updated = conn.execute(
+                "UPDATE dirs SET own_bytes = own_bytes + ?, total_bytes = total_bytes + ? "
+                "WHERE path = ? AND scanned <= ?",
+                (delta, delta, rel, since if since is not None else _UNSCANNED_MAX),
+            ).rowcount
+            if not updated:
+                conn.execute("COMMIT")
+                return False
+            ancestors = _ancestors(rel)
+            if delta and ancestors:
+                marks = ",".join("?" * len(ancestors))
+                conn.execute(
+                    f"UPDATE dirs SET total_bytes = total_bytes + ? WHERE path IN ({marks})",
+                    [delta, *ancestors],
+                )
+            self._log_changes(conn, [rel])
+            conn.execute("COMMIT")
+        except BaseException:
+            conn.execute("ROLLBACK")
+            raise
+        return True
+
+    def touch(self, path: Path) -> None:
+        """Something changed directly inside (or at) *path*; rescan and fix the aggregates."""
+        rel = self.relative(path)
+        if rel is None:
+            return
+        conn = self._conn()
+        self._log_changes(conn, [rel])
+        # Nearest directory that still exists
+        while rel and not self._abs(rel).is_dir():
+            rel = _parent_of(rel) or ""
+        chain = [rel] + _ancestors(rel)
+        marks = ",".join("?" * len(chain))
+        have = {r[0] for r in conn.execute(f"SELECT path FROM dirs WHERE path IN ({marks})", chain)}
+        target = next((p for p in chain if p in have), None)
+        if target is None:
+            return  # nothing indexed above this path
+        self._refresh(target)
+
+    def _refresh(self, rel: str) -> None:
+        conn = self._conn()
+        created: list[str] = []
+        conn.execute("BEGIN IMMEDIATE")
+        try:
+            row = conn.execute(
+                "SELECT total_bytes FROM dirs WHERE path = ?", (rel,)
+            ).fetchone()
+            if row is None:
+                conn.execute("COMMIT")
+                return
+            old_total = int(row[0])
+            own, subdirs = _scan_direct(self._abs(rel))
+            stored = dict(conn.execute(
+                "SELECT path, total_bytes FROM dirs WHERE parent = ?", (rel,)
+            ).fetchall())
+
+            total = own
+            rows: list[tuple[str, Optional[str], int, int]] = []
+            for name in self._subdirs(rel, subdirs):
+                child = _join(rel, name)
+                if child in stored:
+                    total += int(stored.pop(child))
+                    continue
+                total += self._collect(child, rows)
+            # Numbered after reading the disk: a writer whose token is older
+            # cannot tell what this scan saw and rescans instead (apply_delta)
+            scanned = self._next_scan(conn)
+            conn.executemany(
+                "INSERT OR REPLACE INTO dirs (path, parent, own_bytes, total_bytes, scanned) "
+                "VALUES (?, ?, ?, ?, ?)",
+                [(*r, scanned) for r in rows],
+            )
+            created.extend(r[0] for r in rows)
+            for gone in stored:  # subdirectories that no longer exist
+                lo, hi = _subtree_bounds(gone)
+                conn.execute(
+                    "DELETE FROM dirs WHERE path = ? OR (path >= ? AND path < ?)", (gone, lo, hi),
+                )
+
+            conn.execute(
+                "UPDATE dirs SET own_bytes = ?, total_bytes = ?, scanned = ? WHERE path = ?",
+                (own, total, scanned, rel),
+            )
+            delta = total - old_total
+            if delta:
+                ancestors = _ancestors(rel)
+                if ancestors:
+                    marks = ",".join("?" * len(ancestors))
+                    conn.execute(
+                        f"UPDATE dirs SET total_bytes = total_bytes + ? WHERE path IN ({marks})",
+                        [delta, *ancestors],
+                    )
+            conn.execute("COMMIT")
+        except BaseException:
+            conn.execute("ROLLBACK")
+            raise
+        if created:
+            self._notify(created)
+
+    def move(self, source: Path, target: Path) -> None:
+        """Carry a moved directory's rows to its new location.
+
+        Call after the rename and before touching the two parents.
+        """
+        old, new = self.relative(source), self.relative(target)
+        if old is None or new is None or old == new or old == "":
+            return
+        conn = self._conn()
+        lo, hi = _subtree_bounds(old)
+        conn.execute("BEGIN IMMEDIATE")
+        try:
+            rows = conn.execute(
+                "SELECT path, own_bytes, total_bytes, scanned FROM dirs "
+                "WHERE path = ? OR (path >= ? AND path < ?)", (old, lo, hi),
+            ).fetchall()
+            conn.execute("DELETE FROM dirs WHERE path = ? OR (path >= ? AND path < ?)", (old, lo, hi))
+            moved = []
+            for path, own, total, scanned in rows:
+                new_path = new + path[len(old):]
+                moved.append((new_path, _parent_of(new_path), own, total, scanned))
+            conn.executemany(
+                "INSERT OR REPLACE INTO dirs (path, parent, own_bytes, total_bytes, scanned) "
+                "VALUES (?, ?, ?, ?, ?)",
+                moved,
+            )
+            self._log_changes(conn, [old, new])
+            conn.execute("COMMIT")
+        except BaseException:
+            conn.execute("ROLLBACK")
+            raise
+        if moved:
+            self._notify([m[0] for m in moved])
+
+    def clear(self) -> None:
+        conn = self._conn()
+        conn.execute("DELETE FROM dirs")
+        self._log_changes(conn, [None])
+        with self._memo_lock:
+            self._memo.clear()
+
+
+# ---------------------------------------------------------------------------
+# Module-level API (used by operations.py and the files package)
+# ---------------------------------------------------------------------------
+
+_index: Optional[FolderSizeIndex] = None
+_index_lock = threading.Lock()
+
+
+def get_folder_size_index() -> FolderSizeIndex:
+    global _index
+    from app.services.files import path_utils
+
+    root = Path(path_utils.ROOT_DIR).resolve()
+    if _index is None or _index.root != root:
+        with _index_lock:
+            if _index is None or _index.root != root:
+                db_path = root / path_utils.SYSTEM_DIR_NAME / INDEX_FILENAME
+                _index = FolderSizeIndex(
+                    root, db_path, is_excluded=path_utils.is_system_directory,
+                )
+    return _index
+
+
+def get_folder_size(path: Path) -> int:
+    """Return total size of all files inside *path* (recursive).
+
+    Answered from the persistent index; the first call for a directory
+    scans its subtree once with ``os.scandir()`` (``follow_symlinks=False``).
+    """
+    try:
+        return get_folder_size_index().get(path)
+    except sqlite3.Error as exc:
+        logger.warning("Folder size index unavailable, scanning %s: %s", path, exc)
+        return _scan_size(path)
+
+
+def get_folder_sizes(paths: Iterable[Path]) -> dict[Path, int]:
+    """``get_folder_size`` for several directories (directory listings)."""
+    paths = list(paths)
+    try:
+        return get_folder_size_index().get_many(paths)
+    except sqlite3.Error as exc:
+        logger.warning("Folder size index unavailable, scanning: %s", exc)
+        return {p: _scan_size(p) for p in paths}
+
+
 def invalidate_folder_sizes_for_path(path: Path, root: Path) -> None:
-    """Invalidate cache for *path* and all its parents up to *root*."""
-    with _folder_size_cache_lock:
-        current = path
-        while True:
-            _folder_size_cache.pop(str(current), None)
-            if current == root or current.parent == current:
-                break
-            current = current.parent
+    """Record that the contents of *path* changed (it may no longer exist).
+
+    *root* is kept for API compatibility; the index knows the storage root.
+    """
+    try:
+        get_folder_size_index().touch(path)
+    except sqlite3.Error as exc:
+        logger.warning("Folder size index update failed for %s: %s", path, exc)
+
+
+def folder_size_token() -> int:
+    """Take before writing or deleting files; pass to ``record_file_size_change(s)``."""
+    try:
+        return get_folder_size_index().scan_token()
+    except sqlite3.Error as exc:
+        logger.warning("Folder size index unavailable: %s", exc)
+        return -1  # older than every scan: the deltas turn into rescans
+
+
+def record_file_size_changes(changes: Iterable[tuple[Path, int]], since: Optional[int] = None) -> None:
+    """Files changed size: ``(file path, delta bytes)`` pairs, e.g. an upload batch.
+
+    *since* is the ``folder_size_token()`` taken before the writes. Deltas
+    go straight into the index. Files whose directory has no row yet
+    (created by this batch) or was rescanned since *since* are covered by
+    one rescan of each such directory afterwards, deepest first, which
+    already sees them on disk.
+    """
+    try:
+        index = get_folder_size_index()
+        unindexed = {
+            path.parent for path, delta in changes if not index.apply_delta(path, delta, since)
+        }
+        for directory in sorted(unindexed, key=lambda p: len(p.parts), reverse=True):
+            index.touch(directory)
+    except sqlite3.Error as exc:
+        logger.warning("Folder size index update failed: %s", exc)
+
+
+def record_file_size_change(path: Path, delta: int, since: Optional[int] = None) -> None:
+    """The file *path* grew by *delta* bytes (negative: shrank or was deleted)."""
+    record_file_size_changes([(path, delta)], since)
+
+
+def move_folder_sizes(source: Path, target: Path) -> None:
+    """A directory was renamed/moved from *source* to *target*."""
+    try:
+        get_folder_size_index().move(source, target)
+    except sqlite3.Error as exc:
+        logger.warning("Folder size index move failed (%s -> %s): %s", source, target, exc)
 
 
 def invalidate_all_folder_sizes() -> None:
-    """Clear the entire folder size cache."""
-    with _folder_size_cache_lock:
-        _folder_size_cache.clear()
+    """Drop the whole index; it is rebuilt lazily."""
+    try:
+        get_folder_size_index().clear()
+    except sqlite3.Error as exc:
+        logger.warning("Folder size index clear failed: %s", exc)
@@ -0,0 +1,294 @@
+"""inotify watcher that keeps the folder-size index current for external writes.
+
+API file operations update the index themselves. Writes that bypass the
+API — Samba, NFS, WebDAV, a shell on the box — are seen here: the primary
+worker puts an inotify watch on every indexed directory and, after a short
+debounce, asks the index to refresh the directories that changed.
+
+Only indexed directories need a watch (an unindexed one has no aggregate
+to go stale). Directories indexed by *this* process are watched as soon as
+they are added (index listener); ones indexed by other workers are picked
+up by a periodic resync. On queue overflow events were lost, so the index
+is dropped and rebuilt lazily.
+
+fanotify would give whole-filesystem coverage with one mark but requires
+``CAP_SYS_ADMIN``, which the backend does not run with.
+"""
+
+from __future__ import annotations
+
+import ctypes
+import ctypes.util
+import errno
+import logging
+import os
+import select
+import struct
+import threading
+import time
+from typing import Optional
+
+from app.services.files.folder_size import FolderSizeIndex, _parent_of, get_folder_size_index
+
+logger = logging.getLogger(__name__)
+
+IN_CLOSE_WRITE = 0x00000008
+IN_MOVED_FROM = 0x00000040
+IN_MOVED_TO = 0x00000080
+IN_CREATE = 0x00000100
+IN_DELETE = 0x00000200
+IN_DELETE_SELF = 0x00000400
+IN_Q_OVERFLOW = 0x00004000
+IN_IGNORED = 0x00008000
+IN_ONLYDIR = 0x01000000
+IN_ISDIR = 0x40000000
+IN_NONBLOCK = os.O_NONBLOCK
+IN_CLOEXEC = getattr(os, "O_CLOEXEC", 0o2000000)
+
+WATCH_MASK = (
+    IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO
+    | IN_DELETE_SELF | IN_ONLYDIR
+)
+_EVENT_HEADER = struct.Struct("iIII")  # wd, mask, cookie, len
+_READ_SIZE = 64 * 1024
+
+
+def _load_libc():
+    name = ctypes.util.find_library("c")
+    if not name:
+        return None
+    libc = ctypes.CDLL(name, use_errno=True)
+    if not hasattr(libc, "inotify_init1"):
+        return None
+    libc.inotify_add_watch.argtypes = [ctypes.c_int, ctypes.c_char_p, ctypes.c_uint32]
+    libc.inotify_rm_watch.argtypes = [ctypes.c_int, ctypes.c_int]
+    return libc
+
+
+def inotify_available() -> bool:
+    try:
+        return _load_libc() is not None
+    except OSError:
+        return False
+
+
+class FolderSizeWatcher:
+    """Background thread translating inotify events into index refreshes."""
+
+    def __init__(
+        self,
+        index: FolderSizeIndex,
+        *,
+        debounce_seconds: float = 2.0,
+        resync_seconds: float = 60.0,
+    ) -> None:
+        self.index = index
+        self.debounce_seconds = debounce_seconds
+        self.resync_seconds = resync_seconds
+        self._libc = None
+        self._fd = -1
+        self._wake_r = self._wake_w = -1
+        self._thread: Optional[threading.Thread] = None
+        self._stop = threading.Event()
+        self._lock = threading.Lock()
+        self._wd_to_rel: dict[int, str] = {}
+        self._rel_to_wd: dict[str, int] = {}
+        self._dirty: set[str] = set()
+        self._dirty_since = 0.0
+        self._limit_warned = False
+
+    # ------------------------------------------------------------------
+    # Lifecycle
+    # ------------------------------------------------------------------
+
+    def start(self) -> bool:
+        if self._thread is not None:
+            return True
+        self._libc = _load_libc()
+        if self._libc is None:
+            logger.info("inotify not available; folder sizes follow API operations only")
+            return False
+        fd = self._libc.inotify_init1(IN_NONBLOCK | IN_CLOEXEC)
+        if fd < 0:
+            err = ctypes.get_errno()
+            logger.warning("inotify_init1 failed: %s", os.strerror(err))
+            return False
+        self._fd = fd
+        self._wake_r, self._wake_w = os.pipe()
+        self._stop.clear()
+        self.index.add_listener(self.watch)
+        self._sync_watches()
+        self._thread = threading.Thread(
+            target=self._run, name="folder-size-watcher", daemon=True,
+        )
+        self._thread.start()
+        logger.info("Folder size watcher started (%d directories)", len(self._wd_to_rel))
+        return True
+
+    def stop(self) -> None:
+        thread, self._thread = self._thread, None
+        if thread is None:
+            return
+        self._stop.set()
+        try:
+            os.write(self._wake_w, b"x")
+        except OSError:
+            pass
+        thread.join(timeout=5.0)
+        self._flush_dirty()
+        for fd in (self._fd, self._wake_r, self._wake_w):
+            try:
+                os.close(fd)
+            except OSError:
+                pass
+        self._fd = self._wake_r = self._wake_w = -1
+        with self._lock:
+            self._wd_to_rel.clear()
+            self._rel_to_wd.clear()
+
+    # ------------------------------------------------------------------
+    # Watches
+    # ------------------------------------------------------------------
+
+    def watch(self, rel_paths: list[str]) -> None:
+        """Watch *rel_paths* (index listener; also used by the resync)."""
+        if self._fd < 0:
+            return
+        for rel in rel_paths:
+            path = os.fsencode(str(self.index.root / rel if rel else self.index.root))
+            wd = self._libc.inotify_add_watch(self._fd, path, WATCH_MASK)
+            if wd < 0:
+                err = ctypes.get_errno()
+                if err == errno.ENOSPC and not self._limit_warned:
+                    self._limit_warned = True
+                    logger.warning(
+                        "inotify watch limit reached; raise fs.inotify.max_user_watches "
+                        "(external writes below unwatched folders are not reflected in sizes)"
+                    )
+                continue
+            with self._lock:
+                old = self._wd_to_rel.get(wd)
+                if old is not None:
+                    # Same inode under a new name (directory moved)
+                    self._rel_to_wd.pop(old, None)
+                self._wd_to_rel[wd] = rel
+                self._rel_to_wd[rel] = wd
+
+    def _sync_watches(self) -> None:
+        indexed = set(self.index.indexed_paths())
+        indexed.add("")  # root: catches new top-level folders
+        with self._lock:
+            missing = [rel for rel in indexed if rel not in self._rel_to_wd]
+        self.watch(sorted(missing))
+
+    @property
+    def watch_count(self) -> int:
+        return len(self._wd_to_rel)
+
+    # ------------------------------------------------------------------
+    # Event loop (watcher thread)
+    # ------------------------------------------------------------------
+
+    def _run(self) -> None:
+        poller = select.poll()
+        poller.register(self._fd, select.POLLIN)
+        poller.register(self._wake_r, select.POLLIN)
+        next_resync = time.monotonic() + self.resync_seconds
+        while not self._stop.is_set():
+            now = time.monotonic()
+            deadline = next_resync
+            if self._dirty:
+                deadline = min(deadline, self._dirty_since + self.debounce_seconds)
+            timeout_ms = max(0, int((deadline - now) * 1000))
+            try:
+                ready = poller.poll(timeout_ms)
+            except InterruptedError:
+                continue
+            if any(fd == self._fd for fd, _ in ready):
+                self._read_events()
+            now = time.monotonic()
+            try:
+                if self._dirty and now - self._dirty_since >= self.debounce_seconds:
+                    self._flush_dirty()
+                if now >= next_resync:
+                    next_resync = now + self.resync_seconds
+                    self._sync_watches()
+            except Exception:
+                logger.warning("Folder size watcher update failed", exc_info=True)
+
+    def _read_events(self) -> None:
+        while True:
+            try:
+                buf = os.read(self._fd, _READ_SIZE)
+            except BlockingIOError:
+                return
+            except OSError:
+                return
+            if not buf:
+                return
+            self._parse(buf)
+
+    def _parse(self, buf: bytes) -> None:
+        offset = 0
+        size = _EVENT_HEADER.size
+        while offset + size <= len(buf):
+            wd, mask, _cookie, name_len = _EVENT_HEADER.unpack_from(buf, offset)
+            offset += size + name_len
+            if mask & IN_Q_OVERFLOW:
+                self._overflow()
+                continue
+            with self._lock:
+                rel = self._wd_to_rel.get(wd)
+                if mask & IN_IGNORED and rel is not None:
+                    self._wd_to_rel.pop(wd, None)
+                    if self._rel_to_wd.get(rel) == wd:
+                        self._rel_to_wd.pop(rel, None)
+            if rel is None or mask & IN_IGNORED:
+                continue
+            if mask & IN_DELETE_SELF:
+                # The parent's IN_DELETE also arrives; refreshing it is enough
+                parent = _parent_of(rel)
+                if parent is not None:
+                    self._mark(parent)
+                continue
+            self._mark(rel)
+
+    def _mark(self, rel: str) -> None:
+        if not self._dirty:
+            self._dirty_since = time.monotonic()
+        self._dirty.add(rel)
+
+    def _overflow(self) -> None:
+        logger.warning("inotify queue overflowed; dropping folder size index")
+        self._dirty.clear()
+        self.index.clear()
+        # Rows are gone; old watches are harmless and get reused on re-index
+
+    def _flush_dirty(self) -> None:
+        dirty, self._dirty = self._dirty, set()
+        # Deepest first so parents see their children's new totals
+        for rel in sorted(dirty, key=lambda r: r.count("/") + (1 if r else 0), reverse=True):
+            self.index.touch(self.index.root / rel if rel else self.index.root)
+
+
+_watcher: Optional[FolderSizeWatcher] = None
+
+
+def start_folder_size_watcher(debounce_seconds: float = 2.0) -> Optional[FolderSizeWatcher]:
+    """Start the watcher for the current storage root (primary worker only)."""
+    global _watcher
+    if _watcher is not None:
+        return _watcher
+    watcher = FolderSizeWatcher(get_folder_size_index(), debounce_seconds=debounce_seconds)
+    if not watcher.start():
+        return None
+    _watcher = watcher
+    return watcher
+
+
+def stop_folder_size_watcher() -> None:
+    global _watcher
+    watcher, _watcher = _watcher, None
+    if watcher is not None:
+        watcher.stop()
+
@@ -0,0 +1,272 @@
+"""Paginated and streamed directory listings for very large directories.
+
+``list_directory`` builds a ``FileItem`` for every entry before returning,
+which for folders with tens of thousands of entries means one ``stat()``,
+metadata row, owner and share lookup per entry. Here the directory is read
+once with ``os.scandir`` (names and ``d_type`` only), filtered and sorted on
+those names, and only the requested page goes through the full
+``FileItem`` pipeline.
+
+Pagination is keyset-based: the cursor carries the sort key of the last
+entry returned, so entries created or deleted between requests do not
+shift pages the way an offset would. The filesystem stays authoritative —
+files written over SMB/NFS have no ``FileMetadata`` row — so metadata,
+ownership and shares are fetched per page from their path indexes.
+
+Ordering matches ``list_directory``: directories first, then files.
+"""
+
+from __future__ import annotations
+
+import base64
+import json
+import os
+from dataclasses import dataclass, field
+from pathlib import Path
+from typing import Iterator, Literal, Optional
+
+from sqlalchemy.orm import Session
+
+from app.core.tracing import traced
+from app.schemas.files import FileItem
+from app.schemas.user import UserPublic
+from app.services.files import path_utils
+from app.services.files.folder_size import get_folder_sizes
+from app.services.files.operations import _build_file_items, _ensure_can_list
+from app.services.permissions import PermissionDeniedError
+
+SortKey = Literal["name", "size", "modified"]
+SortOrder = Literal["asc", "desc"]
+EntryType = Literal["file", "directory"]
+
+DEFAULT_PAGE_SIZE = 200
+MAX_PAGE_SIZE = 1000
+
+_CURSOR_VERSION = 1
+
+
+class InvalidCursorError(ValueError):
+    """The cursor is malformed or belongs to a different sort/filter."""
+
+
+@dataclass
+class DirectoryListing:
+    """A directory snapshot, sorted and filtered, positioned at a cursor."""
+
+    relative_path: str
+    sort: SortKey
+    order: SortOrder
+    query: Optional[str]
+    entry_type: Optional[EntryType]
+    # (sort key, absolute path, relative path, is_dir), in listing order
+    rows: list[tuple[tuple, Path, str, bool]] = field(default_factory=list)
+    start: int = 0
+
+    @property
+    def total(self) -> int:
+        """Entries matching the filter (before per-entry permission checks)."""
+        return len(self.rows)
+
+
+# ── Cursor ────────────────────────────────────────────────────────────────────
+
+def _fingerprint(listing: DirectoryListing) -> list:
+    return [listing.relative_path, listing.sort, listing.order, listing.query, listing.entry_type]
+
+
+def encode_cursor(listing: DirectoryListing, key: tuple) -> str:
+    payload = {"v": _CURSOR_VERSION, "f": _fingerprint(listing), "k": list(key)}
+    raw = json.dumps(payload, separators=(",", ":"), ensure_ascii=False).encode()
+    return base64.urlsafe_b64encode(raw).decode().rstrip("=")
+
+
+def _decode_cursor(listing: DirectoryListing, cursor: str) -> tuple:
+    try:
+        raw = base64.urlsafe_b64decode(cursor + "=" * (-len(cursor) % 4))
+        payload = json.loads(raw)
+        key = tuple(payload["k"])
+        valid = payload.get("v") == _CURSOR_VERSION and len(key) == 4
+    except (ValueError, KeyError, TypeError) as exc:
+        raise InvalidCursorError("Invalid cursor") from exc
+    if not valid:
+        raise InvalidCursorError("Invalid cursor")
+    if payload.get("f") != _fingerprint(listing):
+        raise InvalidCursorError("Cursor does not match this listing")
+    return key
+
+
+def _is_after(key: tuple, cursor: tuple, descending: bool) -> bool:
+    if key[0] != cursor[0]:
+        return key[0] > cursor[0]  # directories (0) always come first
+    try:
+        return key[1:] < cursor[1:] if descending else key[1:] > cursor[1:]
+    except TypeError as exc:  # tampered cursor with mismatched types
+        raise InvalidCursorError("Invalid cursor") from exc
+
+
+# ── Listing ───────────────────────────────────────────────────────────────────
+
+def open_directory_listing(
+    relative_path: str,
+    user: UserPublic | None,
+    db: Optional[Session] = None,
+    *,
+    cursor: Optional[str] = None,
+    sort: SortKey = "name",
+    order: SortOrder = "asc",
+    query: Optional[str] = None,
+    entry_type: Optional[EntryType] = None,
+) -> DirectoryListing:
+    """Read, filter and sort *relative_path* and position it after *cursor*.
+
+    Permission errors are raised here, before any page is produced, so
+    streaming callers can still answer with a proper status code.
+    """
+    if user is None:
+        raise PermissionDeniedError("Authentication required")
+
+    listing = DirectoryListing(
+        relative_path=relative_path,
+        sort=sort,
+        order=order,
+        query=query.casefold() if query else None,
+        entry_type=entry_type,
+    )
+    cursor_key = _decode_cursor(listing, cursor) if cursor else None
+
+    target = path_utils._resolve_path(relative_path)
+    if not target.is_dir():
+        return listing
+
+    _ensure_can_list(relative_path, user, db)
+
+    base = target.relative_to(path_utils.ROOT_DIR).as_posix()
+    base = "" if base == "." else base
+    hide_system = user.role != "admin"
+
+    scanned: list[tuple[os.DirEntry, bool]] = []
+    with os.scandir(target) as it:
+        for entry in it:
+            name = entry.name
+            if hide_system and path_utils.is_system_directory(name):
+                continue
+            if listing.query and listing.query not in name.casefold():
+                continue
+            try:
+                is_dir = entry.is_dir()
+            except OSError:
+                continue
+            if entry_type is not None and is_dir != (entry_type == "directory"):
+                continue
+            scanned.append((entry, is_dir))
+
+    folder_sizes: dict[Path, int] = {}
+    if sort == "size":
+        folder_sizes = get_folder_sizes(Path(e.path) for e, is_dir in scanned if is_dir)
+
+    rows = listing.rows
+    for entry, is_dir in scanned:
+        path = Path(entry.path)
+        if sort == "name":
+            primary: float = 0
+        else:
+            try:
+                st = entry.stat()
+            except OSError:
+                continue
+            if sort == "modified":
+                primary = st.st_mtime
+            else:
+                primary = folder_sizes.get(path, 0) if is_dir else st.st_size
+        key = (0 if is_dir else 1, primary, entry.name.lower(), entry.name)
+        rel = f"{base}/{entry.name}" if base else entry.name
+        rows.append((key, path, rel, is_dir))
+
+    descending = order == "desc"
+    rows.sort(key=lambda row: row[0][1:], reverse=descending)
+    rows.sort(key=lambda row: row[0][0])  # stable: groups keep their inner order
+
+    if cursor_key is not None:
+        # Rows are sorted, so the first row after the cursor can be bisected
+        lo, hi = 0, len(rows)
+        while lo < hi:
+            mid = (lo + hi) // 2
+            if _is_after(rows[mid][0], cursor_key, descending):
+                hi = mid
+            else:
+                lo = mid + 1
+        listing.start = lo
+    return listing
+
+
+def next_page(
+    listing: DirectoryListing,
+    user: UserPublic,
+    db: Optional[Session],
+    limit: int = DEFAULT_PAGE_SIZE,
+) -> tuple[list[FileItem], Optional[str]]:
+    """Build the next *limit* visible items and advance *listing*.
+
+    Returns the items and the cursor for the following page (None at the end).
+    """
+    limit = max(1, min(limit, MAX_PAGE_SIZE))
+    rows = listing.rows
+    items: list[FileItem] = []
+    last_key: Optional[tuple] = None
+    while len(items) < limit and listing.start < len(rows):
+        # Entries hidden by permissions shrink a batch; keep pulling until full
+        batch = rows[listing.start:listing.start + (limit - len(items))]
+        listing.start += len(batch)
+        keys = {rel: key for key, _, rel, _ in batch}
+        built = _build_file_items([(path, rel, is_dir) for _, path, rel, is_dir in batch], user, db)
+        items.extend(built)
+        if built:
+            last_key = keys[built[-1].path]
+        else:
+            last_key = batch[-1][0]
+
+    if listing.start >= len(rows) or last_key is None:
+        return items, None
+    return items, encode_cursor(listing, last_key)
+
+
+@traced("list_directory_page")
+def list_directory_page(
+    relative_path: str,
+    user: UserPublic | None,
+    db: Optional[Session] = None,
+    *,
+    cursor: Optional[str] = None,
+    limit: int = DEFAULT_PAGE_SIZE,
+    sort: SortKey = "name",
+    order: SortOrder = "asc",
+    query: Optional[str] = None,
+    entry_type: Optional[EntryType] = None,
+) -> tuple[list[FileItem], Optional[str]]:
+    """One page of a directory listing plus the cursor for the next one."""
+    listing = open_directory_listing(
+        relative_path, user, db,
+        cursor=cursor, sort=sort, order=order, query=query, entry_type=entry_type,
+    )
+    assert user is not None
+    return next_page(listing, user, db, limit)
+
+
+def iter_directory_pages(
+    listing: DirectoryListing,
+    user: UserPublic,
+    db: Optional[Session],
+    *,
+    page_size: int = DEFAULT_PAGE_SIZE,
+    limit: Optional[int] = None,
+) -> Iterator[tuple[list[FileItem], Optional[str]]]:
+    """Yield successive pages until the end (or *limit* items)."""
+    remaining = limit
+    while True:
+        size = page_size if remaining is None else min(page_size, remaining)
+        items, cursor = next_page(listing, user, db, size)
+        yield items, cursor
+        if remaining is not None:
+            remaining -= len(items)
+        if cursor is None or (remaining is not None and remaining <= 0):
+            return
@@ -35,6 +35,29 @@ def _get_parent_path(path: str) -> Optional[str]:
     return str(Path(path).parent.as_posix())
 
 
+def _journal(db: Session, metadata: FileMetadata, action: str, old_path: Optional[str] = None) -> None:
+    """Record *metadata*'s change in the sync journal (same transaction)."""
+    from app.services.sync.journal import record_change
+
+    record_change(
+        db,
+        owner_id=metadata.owner_id,
+        action=action,
+        path=metadata.path,
+        old_path=old_path,
+        is_directory=metadata.is_directory,
+        size_bytes=None if action == "delete" else metadata.size_bytes,
+        checksum=None if action == "delete" else metadata.checksum,
+    )
+
+
+def _index(metadata: FileMetadata) -> None:
+    """Refresh *metadata*'s search index row (same transaction)."""
+    from app.services.files.search import index_metadata
+
+    index_metadata(metadata)
+
+
 # ============================================================================
 # Database Operations
 # ============================================================================
@@ -108,6 +131,8 @@ def create_metadata(
         )
         
         db.add(metadata)
+        _journal(db, metadata, "upsert")
+        _index(metadata)
         db.commit()
         db.refresh(metadata)
         return metadata
@@ -156,7 +181,8 @@ def update_metadata(
         if checksum is not None:
             metadata.checksum = checksum
 
-        # updated_at is set automatically by onupdate
+        _journal(db, metadata, "upsert")
+        _index(metadata)  # also sets updated_at
         db.commit()
         db.refresh(metadata)
         return metadata
@@ -190,6 +216,7 @@ def delete_metadata(relative_path: str, db: Optional[Session] = None) -> bool:
         if not metadata:
             return False
         
+        _journal(db, metadata, "delete")
         db.delete(metadata)
         db.commit()
         return True
@@ -234,8 +261,9 @@ def rename_metadata(
         metadata.path = new_normalized
         metadata.name = new_name
         metadata.parent_path = _get_parent_path(new_normalized)
-        # updated_at is set automatically by onupdate
-        
+        _journal(db, metadata, "move", old_path=old_normalized)
+        _index(metadata)  # also sets updated_at
+
         db.commit()
         db.refresh(metadata)
         return metadata
@@ -369,7 +397,12 @@ def set_owner_id(relative_path: str, owner_id: int, db: Optional[Session] = None
         if not metadata:
             return False
         
-        metadata.owner_id = owner_id
+        if metadata.owner_id != owner_id:
+            # Gone for the previous owner's devices, new for the new owner's
+            _journal(db, metadata, "delete")
+            metadata.owner_id = owner_id
+            _journal(db, metadata, "upsert")
+            _index(metadata)
         # updated_at is set automatically by onupdate
         db.commit()
         return True
@@ -23,11 +23,19 @@ if TYPE_CHECKING:
     from app.models.file_share import FileShare
 
 from app.core.config import settings
+from app.core.tracing import traced
 from app.schemas.files import FileItem
 from app.schemas.user import UserPublic
 from app.services.files import metadata_db as file_metadata_db
 from app.services.files import path_utils
-from app.services.files.folder_size import get_folder_size, invalidate_folder_sizes_for_path
+from app.services.files.folder_size import (
+    folder_size_token,
+    get_folder_sizes,
+    invalidate_folder_sizes_for_path,
+    move_folder_sizes,
+    record_file_size_change,
+    record_file_size_changes,
+)
 from app.services.files.storage_permissions import (
     ensure_dir_with_permissions,
     set_storage_dir_permissions,
@@ -122,16 +130,19 @@ def _schedule_vcl_version(
             file_meta = db.get(FileMetadata, file_meta_id)
             if not file_meta:
                 return
-            content = await asyncio.to_thread(destination.read_bytes)
-            vcl_service = VCLService(db)
-            vcl_service.create_version(
-                file=file_meta,
-                content=content,
-                user_id=owner_id,
-                checksum=checksum,
-                change_type="update" if is_update else "create",
-            )
-            db.commit()
+
+            def _store() -> None:
+                # Chunking, hashing and compression are CPU/disk bound
+                VCLService(db).create_version_from_file(
+                    file=file_meta,
+                    file_path=destination,
+                    user_id=owner_id,
+                    checksum=checksum,
+                    change_type="update" if is_update else "create",
+                )
+                db.commit()
+
+            await asyncio.to_thread(_store)
         except Exception as e:
             db.rollback()
             logging.getLogger(__name__).warning(
@@ -145,6 +156,7 @@ def _schedule_vcl_version(
 
 # ── CRUD operations ──────────────────────────────────────────────────────────
 
+@traced("list_directory")
 def list_directory(relative_path: str = "", user: UserPublic | None = None, db: Optional[Session] = None) -> Iterable[FileItem]:
     """List files and directories with permission filtering.
 
@@ -159,11 +171,7 @@ def list_directory(relative_path: str = "", user: UserPublic | None = None, db:
     if not target.exists():
         return []
 
-    directory_owner = get_owner(relative_path, db=db)
-    if directory_owner and not path_utils.is_in_shared_dir(relative_path) and not can_view(user, directory_owner):
-        # Fallback: allow if path is shared with this user
-        if not (db and is_path_shared_with_user(db, relative_path, user.id)):
-            raise PermissionDeniedError("Operation not permitted")
+    _ensure_can_list(relative_path, user, db)
 
     # ── Pass 1: collect filesystem entries and their relative paths ────────
     entries: list[tuple[Path, str, bool]] = []  # (entry, relative_path, is_dir)
@@ -174,6 +182,28 @@ def list_directory(relative_path: str = "", user: UserPublic | None = None, db:
         relative_entry = str(entry.relative_to(path_utils.ROOT_DIR).as_posix())
         entries.append((entry, relative_entry, entry.is_dir()))
 
+    items = _build_file_items(entries, user, db)
+    items.sort(key=lambda item: (item.type != "directory", item.name.lower()))
+    return items
+
+
+def _ensure_can_list(relative_path: str, user: UserPublic, db: Optional[Session]) -> None:
+    directory_owner = get_owner(relative_path, db=db)
+    if directory_owner and not path_utils.is_in_shared_dir(relative_path) and not can_view(user, directory_owner):
+        # Fallback: allow if path is shared with this user
+        if not (db and is_path_shared_with_user(db, relative_path, user.id)):
+            raise PermissionDeniedError("Operation not permitted")
+
+
+def _build_file_items(
+    entries: list[tuple[Path, str, bool]],
+    user: UserPublic,
+    db: Optional[Session],
+) -> list[FileItem]:
+    """Turn ``(entry, relative_path, is_dir)`` tuples into visible ``FileItem``s.
+
+    Keeps the input order and drops entries the user may not see.
+    """
     if not entries:
         return []
 
@@ -255,6 +285,9 @@ def list_directory(relative_path: str = "", user: UserPublic | None = None, db:
                 for uid, uname in users:
                     owner_name_map[str(uid)] = uname
 
+    # Folder sizes come from the persistent index in one lookup
+    folder_sizes = get_folder_sizes([entry for entry, _, is_dir in entries if is_dir])
+
     # ── Pass 2: build FileItem list using pre-fetched data ────────────────
     items: list[FileItem] = []
     for entry, relative_entry, is_dir in entries:
@@ -288,7 +321,7 @@ def list_directory(relative_path: str = "", user: UserPublic | None = None, db:
         item = FileItem(
             name=entry.name,
             path=relative_entry,
-            size=get_folder_size(entry) if is_dir else stats.st_size,
+            size=folder_sizes.get(entry, 0) if is_dir else stats.st_size,
             type="directory" if is_dir else "file",
             modified_at=datetime.fromtimestamp(stats.st_mtime, tz=timezone.utc),
             owner_id=entry_owner,
@@ -306,10 +339,10 @@ def list_directory(relative_path: str = "", user: UserPublic | None = None, db:
                 item.can_delete = share.can_delete
         items.append(item)
 
-    items.sort(key=lambda item: (item.type != "directory", item.name.lower()))
     return items
 
 
+@traced("save_uploads")
 async def save_uploads(
     relative_path: str,
     uploads: list[UploadFile],
@@ -405,6 +438,8 @@ async def save_uploads(
     STREAM_CHUNK = 8 * 1024 * 1024  # 8 MB read/write buffer
 
     saved_paths: list[str] = []
+    size_changes: list[tuple[Path, int]] = []
+    size_token = await asyncio.to_thread(folder_size_token)
     for idx, upload in enumerate(uploads):
         # Use folder path if provided (for folder uploads)
         if folder_paths and idx < len(folder_paths) and folder_paths[idx]:
@@ -491,6 +526,7 @@ async def save_uploads(
                 await progress_manager.update_progress(upload_ids[idx], written)
 
             used_bytes = used_bytes - existing_size + written
+            size_changes.append((destination, written - existing_size))
             relative_destination = str(destination.relative_to(path_utils.ROOT_DIR).as_posix())
             saved_paths.append(relative_destination)
 
@@ -583,16 +619,23 @@ async def save_uploads(
 
     # Invalidate storage quota cache after uploads
     invalidate_used_bytes_cache()
-    invalidate_folder_sizes_for_path(path_utils._resolve_path(relative_path), path_utils.ROOT_DIR)
+    await asyncio.to_thread(record_file_size_changes, size_changes, size_token)
     return saved_paths
 
 
-def delete_path(relative_path: str, user: UserPublic | None = None, db: Optional[Session] = None) -> None:
+def delete_path(
+    relative_path: str,
+    user: UserPublic | None = None,
+    db: Optional[Session] = None,
+    *,
+    _update_folder_sizes: bool = True,
+) -> None:
     """Delete a file or directory and its metadata.
 
     For directories the deletion is recursive. If a child deletion fails
     the error propagates immediately so the caller sees a clear failure
-    rather than a silently half-deleted tree.
+    rather than a silently half-deleted tree. The folder-size index is
+    updated once for the top-level path, not per child.
     """
     audit = get_audit_logger_db()
 
@@ -621,7 +664,7 @@ def delete_path(relative_path: str, user: UserPublic | None = None, db: Optional
         # failures don't leave orphaned metadata.
         children = list(target.iterdir())
         for child in children:
-            delete_path(path_utils._relative_posix(child), user=user, db=db)
+            delete_path(path_utils._relative_posix(child), user=user, db=db, _update_folder_sizes=False)
         try:
             target.rmdir()
         except PermissionError as exc:
@@ -641,7 +684,9 @@ def delete_path(relative_path: str, user: UserPublic | None = None, db: Optional
                         raise
                 else:
                     raise
+        size_token = folder_size_token() if _update_folder_sizes else None
         try:
+            removed_bytes = 0 if target.is_symlink() else target.stat().st_size
             target.unlink()
         except PermissionError as exc:
             _emit_permission_error("delete", file_relative, user.username if user else "system")
@@ -668,7 +713,11 @@ def delete_path(relative_path: str, user: UserPublic | None = None, db: Optional
 
     # Invalidate storage quota cache after deletion
     invalidate_used_bytes_cache()
-    invalidate_folder_sizes_for_path(path_utils._resolve_path(relative_path), path_utils.ROOT_DIR)
+    if _update_folder_sizes:
+        if is_directory:
+            invalidate_folder_sizes_for_path(target.parent, path_utils.ROOT_DIR)
+        else:
+            record_file_size_change(target, -removed_bytes, size_token)
 
 
 def create_folder(parent_path: str, name: str, owner: UserPublic | None = None, db: Optional[Session] = None) -> Path:
@@ -766,10 +815,10 @@ def rename_path(old_path: str, new_name: str, user: UserPublic | None = None, db
     if not is_dir:
         _invalidate_ssd_cache(source_relative, db=db)
 
-    # Invalidate folder size cache for renamed directories
+    # Carry the renamed directory's folder-size rows over (no rescan)
     if is_dir:
-        invalidate_folder_sizes_for_path(source, path_utils.ROOT_DIR)
-        invalidate_folder_sizes_for_path(target, path_utils.ROOT_DIR)
+        move_folder_sizes(source, target)
+        invalidate_folder_sizes_for_path(target.parent, path_utils.ROOT_DIR)
 
     return target
 
@@ -835,7 +884,9 @@ def move_path(source_path: str, target_path: str, user: UserPublic | None = None
     if is_file:
         _invalidate_ssd_cache(source_relative, db=db)
 
-    # Invalidate folder size cache for source parent and destination
+    # Update folder sizes: carry a moved directory's rows, then fix both parents
+    if not is_file:
+        move_folder_sizes(source, final_target_resolved)
     invalidate_folder_sizes_for_path(source_parent, path_utils.ROOT_DIR)
     invalidate_folder_sizes_for_path(final_target_resolved.parent, path_utils.ROOT_DIR)
 
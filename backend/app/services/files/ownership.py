@@ -6,6 +6,10 @@ This service handles:
 - Physical movement of files to maintain user-directory residency invariant
 - Cascading updates to child entries, shares, share links, and VCL versions
 - Residency enforcement scanning and fixing
+
+Subtrees are rewritten with set-based UPDATEs (``_rewrite_subtree``) over
+the ``path`` prefix index rather than row by row; directories too large for
+one transaction go through the resumable batch jobs in ``ownership_jobs``.
 """
 from __future__ import annotations
 
@@ -13,10 +17,11 @@ import hashlib
 import logging
 import os
 from dataclasses import dataclass, field
+from datetime import datetime, timezone
 from pathlib import Path
-from typing import Literal, Optional, cast
+from typing import Iterator, Literal, Optional, Sequence, cast
 
-from sqlalchemy import select, text, true
+from sqlalchemy import String, and_, case, func, insert, literal, or_, select, text, true, update
 from sqlalchemy.orm import Session
 
 from app.core.config import settings
@@ -24,10 +29,13 @@ from app.core.config import settings
 # ``app.services.files.ownership.SessionLocal``; not referenced directly.
 from app.core.database import SessionLocal  # noqa: F401
 from app.models.file_metadata import FileMetadata
+from app.models.file_search import FileSearchEntry
 from app.models.file_share import FileShare
 from app.models.user import User
 from app.services.audit.logger_db import get_audit_logger_db
 from app.services.files import metadata_db as file_metadata_db
+from app.services.files.folder_size import invalidate_folder_sizes_for_path, move_folder_sizes
+from app.services.files.search import fold, index_metadata
 
 logger = logging.getLogger(__name__)
 
@@ -36,6 +44,9 @@ SHARED_DIR_NAME = "Shared"
 
 ConflictStrategy = Literal["rename", "skip", "overwrite"]
 
+# Rows per keyset page of the residency scan
+SCAN_BATCH = 5000
+
 
 class OwnershipError(Exception):
     """Base exception for ownership operations."""
@@ -214,6 +225,269 @@ def _acquire_advisory_lock(db: Session, path: str) -> None:
     db.execute(text(f"SELECT pg_advisory_xact_lock({path_hash})"))
 
 
+def _like_prefix(prefix: str) -> str:
+    """LIKE pattern for every path starting with *prefix* (``\\`` escapes)."""
+    escaped = prefix.replace("\\", "\\\\").replace("%", "\\%").replace("_", "\\_")
+    return f"{escaped}%"
+
+
+def _below(path: str):
+    """WHERE clause for all ``FileMetadata`` rows strictly below *path*.
+
+    A constant ``LIKE 'path/%'`` pattern, so PostgreSQL can use the
+    ``text_pattern_ops`` prefix index on ``file_metadata.path``.
+    """
+    return FileMetadata.path.like(_like_prefix(f"{path}/"), escape="\\")
+
+
+def _rewrite_subtree(
+    db: Session,
+    file_ids: Sequence[int],
+    old_path: str,
+    new_path: str,
+    new_owner_id: Optional[int],
+) -> None:
+    """Move descendants of *old_path* below *new_path* and/or to a new owner.
+
+    One UPDATE on ``file_metadata`` and one on ``file_search_index`` for the
+    given ids, whatever their number: the path prefix is swapped in SQL
+    (``new_prefix || substr(path, ...)``) instead of per ORM object. A new
+    owner also gets one INSERT ... SELECT of sync journal upserts. Rows
+    loaded in the session are not synchronised; callers only pass ids.
+    """
+    if not file_ids or (new_owner_id is None and new_path == old_path):
+        return
+    # One timestamp for both tables, so the index matches the rows' updated_at
+    stamp = datetime.now(timezone.utc)
+    values: dict = {"updated_at": stamp}
+    index_values: dict = {"modified_at": stamp}
+    if new_owner_id is not None:
+        values["owner_id"] = new_owner_id
+        index_values["owner_id"] = new_owner_id
+    if new_path != old_path:
+        old_prefix = f"{old_path}/"
+        new_prefix = f"{new_path}/"
+        cut = len(old_prefix) + 1
+        values["path"] = literal(new_prefix, String) + func.substr(FileMetadata.path, cut)
+        values["parent_path"] = case(
+            (FileMetadata.parent_path == old_path, new_path),
+            else_=literal(new_prefix, String) + func.substr(FileMetadata.parent_path, cut),
+        )
+        index_values["path"] = literal(new_prefix, String) + func.substr(FileSearchEntry.path, cut)
+        # casefold maps character by character, so the folded prefix has a
+        # fixed length and the folded remainder can be kept as is
+        index_values["path_folded"] = literal(fold(new_prefix), String) + func.substr(
+            FileSearchEntry.path_folded, len(fold(old_prefix)) + 1
+        )
+    db.execute(
+        update(FileMetadata)
+        .where(FileMetadata.id.in_(file_ids))
+        .values(**values)
+        .execution_options(synchronize_session=False)
+    )
+    db.execute(
+        update(FileSearchEntry)
+        .where(FileSearchEntry.file_id.in_(file_ids))
+        .values(**index_values)
+        .execution_options(synchronize_session=False)
+    )
+    if new_owner_id is not None:
+        # The new owner's devices have never seen these rows; the old owner's
+        # drop them with the subtree root's delete (see _journal_transfer)
+        from app.models.sync_state import SyncChange
+
+        columns = ("owner_id", "action", "path", "is_directory", "size_bytes", "checksum")
+        db.execute(
+            insert(SyncChange).from_select(
+                columns,
+                select(
+                    FileMetadata.owner_id,
+                    literal("upsert", String),
+                    FileMetadata.path,
+                    FileMetadata.is_directory,
+                    FileMetadata.size_bytes,
+                    FileMetadata.checksum,
+                )
+                .where(FileMetadata.id.in_(file_ids))
+                .order_by(FileMetadata.id),
+            )
+        )
+
+
+def _rename_on_disk(source_abs: Path, target_abs: Path) -> None:
+    """Rename *source_abs* to *target_abs* and carry its folder-size rows."""
+    is_dir = source_abs.is_dir()
+    os.rename(source_abs, target_abs)
+    if is_dir:
+        move_folder_sizes(source_abs, target_abs)
+    invalidate_folder_sizes_for_path(source_abs.parent, ROOT_DIR)
+    invalidate_folder_sizes_for_path(target_abs.parent, ROOT_DIR)
+
+
+def _journal_transfer(db: Session, metadata: FileMetadata, old_path: str, old_owner_id: int) -> None:
+    """Sync journal entries for an entry that moved and/or changed owner.
+
+    A new owner is a delete for the old owner (a directory takes its subtree
+    with it) and an upsert for the new one, whose descendants are journaled
+    by ``_rewrite_subtree``. Same owner, new path: one move.
+    """
+    from app.services.sync.journal import record_change
+
+    if metadata.owner_id != old_owner_id:
+        record_change(
+            db, owner_id=old_owner_id, action="delete", path=old_path,
+            is_directory=metadata.is_directory,
+        )
+        record_change(
+            db, owner_id=metadata.owner_id, action="upsert", path=metadata.path,
+            is_directory=metadata.is_directory, size_bytes=metadata.size_bytes,
+            checksum=metadata.checksum,
+        )
+    elif metadata.path != old_path:
+        record_change(
+            db, owner_id=metadata.owner_id, action="move", path=metadata.path,
+            old_path=old_path, is_directory=metadata.is_directory,
+            size_bytes=metadata.size_bytes, checksum=metadata.checksum,
+        )
+
+
+def _move_entry(db: Session, metadata: FileMetadata, new_path: str, new_owner_id: int) -> None:
+    """Point the transferred entry itself at *new_path* and its new owner."""
+    old_path, old_owner_id = metadata.path, metadata.owner_id
+    metadata.owner_id = new_owner_id
+    metadata.path = new_path
+    metadata.name = Path(new_path).name
+    metadata.parent_path = str(Path(new_path).parent) if "/" in new_path else None
+    index_metadata(metadata)
+    _journal_transfer(db, metadata, old_path, old_owner_id)
+
+
+def _validate_transfer(
+    normalized_path: str,
+    new_owner_id: int,
+    requesting_user_id: int,
+    requesting_user_is_admin: bool,
+    db: Session,
+) -> tuple[Optional[OwnershipTransferResult], Optional[FileMetadata], Optional[User]]:
+    """Checks shared by single and bulk transfers.
+
+    Returns ``(result, metadata, new_owner)``; a non-None *result* ends the
+    transfer (an error, or the self-transfer no-op).
+    """
+    metadata = file_metadata_db.get_metadata(normalized_path, db=db)
+    if not metadata:
+        return OwnershipTransferResult(
+            success=False,
+            message="File or directory not found",
+            error="NOT_FOUND"
+        ), None, None
+
+    old_owner_id = metadata.owner_id
+
+    # Check if new owner exists and is active
+    new_owner = _get_user_by_id(new_owner_id, db)
+    if not new_owner or not new_owner.is_active:
+        return OwnershipTransferResult(
+            success=False,
+            message="Target user not found or inactive",
+            error="INVALID_TARGET_USER"
+        ), None, None
+
+    # Self-transfer is a no-op
+    if new_owner_id == old_owner_id:
+        return OwnershipTransferResult(
+            success=True,
+            message="No transfer needed - already owned by target user",
+            transferred_count=0,
+            new_path=normalized_path
+        ), None, None
+
+    # Check authorization: must be current owner or admin
+    if not requesting_user_is_admin and requesting_user_id != old_owner_id:
+        get_audit_logger_db().log_event(
+            event_type="SECURITY",
+            user=str(requesting_user_id),
+            action="ownership_transfer_denied",
+            resource=normalized_path,
+            success=False,
+            error_message="Unauthorized transfer attempt",
+            db=db
+        )
+        return OwnershipTransferResult(
+            success=False,
+            message="Only the owner or an admin can transfer ownership",
+            error="UNAUTHORIZED"
+        ), None, None
+
+    # Cannot transfer home directories themselves
+    old_owner_user = _get_user_by_id(old_owner_id, db)
+    if old_owner_user and _is_home_directory(normalized_path, old_owner_user.username):
+        return OwnershipTransferResult(
+            success=False,
+            message="Cannot transfer a user's home directory",
+            error="HOME_DIRECTORY"
+        ), None, None
+
+    return None, metadata, new_owner
+
+
+def _plan_target(
+    normalized_path: str,
+    metadata: FileMetadata,
+    new_owner: User,
+    conflict_strategy: ConflictStrategy,
+    recursive: bool,
+    db: Session,
+) -> tuple[Optional[OwnershipTransferResult], Optional[str], list[ConflictInfo]]:
+    """Resolve where a moved entry lands in the new owner's home.
+
+    Returns ``(result, new_relative_path, conflicts)``; *result* is set when
+    the conflict strategy skips the transfer. An overwritten target is
+    deleted here.
+    """
+    conflicts: list[ConflictInfo] = []
+
+    # Ensure target user has home directory
+    _ensure_home_directory_exists(new_owner.username, new_owner.id, db)
+
+    target_dir = ROOT_DIR / new_owner.username
+    filename = Path(normalized_path).name
+
+    # Resolve conflicts
+    resolved_name, conflict_info = _resolve_name_conflict(
+        target_dir, filename, conflict_strategy
+    )
+
+    if conflict_info.action != "no_conflict":
+        conflicts.append(conflict_info)
+
+    if resolved_name is None:
+        # Skip due to conflict
+        skipped_count = 1
+        if metadata.is_directory and recursive:
+            # Count children that would be skipped
+            skipped_count += db.query(func.count(FileMetadata.id)).filter(
+                _below(normalized_path)
+            ).scalar() or 0
+
+        return OwnershipTransferResult(
+            success=True,
+            message="Transfer skipped due to naming conflict",
+            transferred_count=0,
+            skipped_count=skipped_count,
+            new_path=normalized_path,
+            conflicts=conflicts
+        ), None, conflicts
+
+    target_abs = target_dir / resolved_name
+
+    # Handle overwrite
+    if conflict_info.action == "overwritten" and target_abs.exists():
+        _delete_path_and_metadata(str(target_abs.relative_to(ROOT_DIR)), db)
+
+    return None, f"{new_owner.username}/{resolved_name}", conflicts
+
+
 def transfer_ownership(
     path: str,
     new_owner_id: int,
@@ -235,6 +509,9 @@ def transfer_ownership(
     - VCL version ownership & quota transfer
     - Audit logging
     
+    Everything happens in one transaction. For very large directories use
+    ``ownership_jobs.start_bulk_transfer``, which commits in batches.
+
     Args:
         path: Relative path to the file/directory
         new_owner_id: User ID of the new owner
@@ -252,62 +529,14 @@ def transfer_ownership(
     
     try:
         # 1. VALIDATION
-        
-        # Get current metadata
-        metadata = file_metadata_db.get_metadata(normalized_path, db=db)
-        if not metadata:
-            return OwnershipTransferResult(
-                success=False,
-                message="File or directory not found",
-                error="NOT_FOUND"
-            )
-        
+        rejected, metadata, new_owner = _validate_transfer(
+            normalized_path, new_owner_id, requesting_user_id, requesting_user_is_admin, db
+        )
+        if rejected is not None:
+            return rejected
+        assert metadata is not None and new_owner is not None
         old_owner_id = metadata.owner_id
         
-        # Check if new owner exists and is active
-        new_owner = _get_user_by_id(new_owner_id, db)
-        if not new_owner or not new_owner.is_active:
-            return OwnershipTransferResult(
-                success=False,
-                message="Target user not found or inactive",
-                error="INVALID_TARGET_USER"
-            )
-        
-        # Self-transfer is a no-op
-        if new_owner_id == old_owner_id:
-            return OwnershipTransferResult(
-                success=True,
-                message="No transfer needed - already owned by target user",
-                transferred_count=0,
-                new_path=normalized_path
-            )
-        
-        # Check authorization: must be current owner or admin
-        if not requesting_user_is_admin and requesting_user_id != old_owner_id:
-            audit.log_event(
-                event_type="SECURITY",
-                user=str(requesting_user_id),
-                action="ownership_transfer_denied",
-                resource=normalized_path,
-                success=False,
-                error_message="Unauthorized transfer attempt",
-                db=db
-            )
-            return OwnershipTransferResult(
-                success=False,
-                message="Only the owner or an admin can transfer ownership",
-                error="UNAUTHORIZED"
-            )
-        
-        # Cannot transfer home directories themselves
-        old_owner_user = _get_user_by_id(old_owner_id, db)
-        if old_owner_user and _is_home_directory(normalized_path, old_owner_user.username):
-            return OwnershipTransferResult(
-                success=False,
-                message="Cannot transfer a user's home directory",
-                error="HOME_DIRECTORY"
-            )
-        
         # 2. DETERMINE IF PHYSICAL MOVE IS NEEDED
         
         in_shared = _is_in_shared_dir(normalized_path)
@@ -332,91 +561,39 @@ def transfer_ownership(
         new_relative_path = normalized_path
         
         if needs_physical_move:
-            # Ensure target user has home directory
-            _ensure_home_directory_exists(new_owner.username, new_owner.id, db)
-            
-            target_dir = ROOT_DIR / new_owner.username
-            filename = Path(normalized_path).name
-            
-            # Resolve conflicts
-            resolved_name, conflict_info = _resolve_name_conflict(
-                target_dir, filename, conflict_strategy
+            skipped, planned_path, conflicts = _plan_target(
+                normalized_path, metadata, new_owner, conflict_strategy, recursive, db
             )
-            
-            if conflict_info.action != "no_conflict":
-                conflicts.append(conflict_info)
-            
-            if resolved_name is None:
-                # Skip due to conflict
-                skipped_count = 1
-                if metadata.is_directory and recursive:
-                    # Count children that would be skipped
-                    child_count = db.query(FileMetadata).filter(
-                        FileMetadata.path.like(f"{normalized_path}/%")
-                    ).count()
-                    skipped_count += child_count
-                
-                return OwnershipTransferResult(
-                    success=True,
-                    message="Transfer skipped due to naming conflict",
-                    transferred_count=0,
-                    skipped_count=skipped_count,
-                    new_path=normalized_path,
-                    conflicts=conflicts
-                )
-            
-            target_abs = target_dir / resolved_name
-            new_relative_path = f"{new_owner.username}/{resolved_name}"
-            
-            # Handle overwrite
-            if conflict_info.action == "overwritten" and target_abs.exists():
-                _delete_path_and_metadata(str(target_abs.relative_to(ROOT_DIR)), db)
+            if skipped is not None:
+                return skipped
+            assert planned_path is not None
+            new_relative_path = planned_path
             
             # 5. PHYSICAL MOVE (atomic on same filesystem)
-            os.rename(source_abs, target_abs)
+            _rename_on_disk(source_abs, ROOT_DIR / new_relative_path)
             
         # 6. UPDATE METADATA
         
         old_path = metadata.path
         
         # Update the main entry
-        metadata.owner_id = new_owner_id
-        metadata.path = new_relative_path
-        metadata.name = Path(new_relative_path).name
-        metadata.parent_path = str(Path(new_relative_path).parent) if "/" in new_relative_path else None
+        _move_entry(db, metadata, new_relative_path, new_owner_id)
         transferred_count = 1
-        children: list[FileMetadata] = []
+        child_ids: list[int] = []
 
-        # 7. CASCADE TO CHILDREN (for directories)
+        # 7. CASCADE TO CHILDREN (for directories), set-based
         if metadata.is_directory and recursive:
-            old_prefix = f"{old_path}/"
-            new_prefix = f"{new_relative_path}/"
-            
-            children = db.query(FileMetadata).filter(
-                FileMetadata.path.startswith(old_prefix)
-            ).all()
-            
-            for child in children:
-                # Update path prefix
-                child.path = new_prefix + child.path[len(old_prefix):]
-                # Update parent_path
-                if child.parent_path:
-                    if child.parent_path == old_path:
-                        child.parent_path = new_relative_path
-                    elif child.parent_path.startswith(old_prefix):
-                        child.parent_path = new_prefix + child.parent_path[len(old_prefix):]
-                # Update owner
-                child.owner_id = new_owner_id
-                transferred_count += 1
+            child_ids = list(db.scalars(
+                select(FileMetadata.id).where(_below(old_path))
+            ))
+            _rewrite_subtree(db, child_ids, old_path, new_relative_path, new_owner_id)
+            transferred_count += len(child_ids)
         
         # 8. CASCADE SHARES
         _cascade_shares_on_transfer(metadata.id, old_owner_id, new_owner_id, db)
 
         # 9. CASCADE VCL VERSIONS & QUOTA
-        vcl_file_ids = [metadata.id]
-        if metadata.is_directory and recursive:
-            vcl_file_ids.extend(child.id for child in children)
-        _cascade_vcl_on_transfer(vcl_file_ids, old_owner_id, new_owner_id, db)
+        _cascade_vcl_on_transfer([metadata.id, *child_ids], old_owner_id, new_owner_id, db)
 
         # 10. COMMIT
         db.commit()
@@ -585,6 +762,58 @@ def _delete_path_and_metadata(relative_path: str, db: Session) -> None:
             abs_path.unlink()
 
 
+def iter_residency_violations(
+    db: Session,
+    scope: Optional[str] = None,
+    batch_size: int = SCAN_BATCH,
+) -> Iterator[ResidencyViolation]:
+    """
+    Yield files that violate the residency invariant, in id order.
+
+    The comparison runs in SQL: a row qualifies unless its path is the
+    owner's home or lies below it (``substr(path, 1, len(username) + 1) =
+    username || '/'``), or it is in Shared/. Only violating rows reach
+    Python, fetched in keyset pages of *batch_size*, so the scan's memory
+    does not grow with the number of files.
+    """
+    home_prefix = User.username + literal("/", String)
+    compliant = or_(
+        FileMetadata.path == User.username,
+        func.substr(FileMetadata.path, 1, func.length(User.username) + 1) == home_prefix,
+        FileMetadata.path == SHARED_DIR_NAME,
+        FileMetadata.path.like(_like_prefix(f"{SHARED_DIR_NAME}/"), escape="\\"),
+    )
+    conditions = [~compliant, FileMetadata.path != ""]
+    if scope:
+        # Scan only for specific user
+        conditions.append(User.username == scope)
+
+    last_id = 0
+    while True:
+        rows = db.execute(
+            select(FileMetadata.id, FileMetadata.path, User.id, User.username)
+            .join(User, FileMetadata.owner_id == User.id)
+            .where(and_(FileMetadata.id > last_id, *conditions))
+            .order_by(FileMetadata.id)
+            .limit(batch_size)
+        ).all()
+        if not rows:
+            return
+        for _file_id, path, owner_id, username in rows:
+            # Leading slashes or odd paths are re-checked the classic way
+            first_segment = _get_first_segment(path)
+            if not first_segment or first_segment == username or _is_in_shared_dir(path):
+                continue
+            yield ResidencyViolation(
+                path=path,
+                current_owner_id=owner_id,
+                current_owner_username=username,
+                expected_directory=username,
+                actual_directory=first_segment
+            )
+        last_id = rows[-1][0]
+
+
 def scan_residency_violations(
     db: Session,
     scope: Optional[str] = None
@@ -602,43 +831,7 @@ def scan_residency_violations(
     Returns:
         List of ResidencyViolation objects
     """
-    violations: list[ResidencyViolation] = []
-    
-    # Build query
-    query = db.query(FileMetadata, User).join(User, FileMetadata.owner_id == User.id)
-    
-    if scope:
-        # Scan only for specific user
-        query = query.filter(User.username == scope)
-    
-    entries = query.all()
-    
-    for metadata, user in entries:
-        path = metadata.path
-        
-        # Skip Shared directory
-        if _is_in_shared_dir(path):
-            continue
-        
-        # Get first path segment
-        first_segment = _get_first_segment(path)
-        if not first_segment:
-            continue
-        
-        # File should be in owner's directory
-        expected_dir = user.username
-        actual_dir = first_segment
-        
-        if actual_dir != expected_dir:
-            violations.append(ResidencyViolation(
-                path=path,
-                current_owner_id=user.id,
-                current_owner_username=user.username,
-                expected_directory=expected_dir,
-                actual_directory=actual_dir
-            ))
-    
-    return violations
+    return list(iter_residency_violations(db, scope))
 
 
 def enforce_residency(
@@ -702,21 +895,15 @@ def enforce_residency(
                     metadata.path = correct_path
                     metadata.name = resolved_name
                     metadata.parent_path = violation.expected_directory
+                    index_metadata(metadata)
+                    _journal_transfer(db, metadata, old_path, metadata.owner_id)
                     
                     # Update children paths if directory
                     if metadata.is_directory:
-                        old_prefix = f"{old_path}/"
-                        new_prefix = f"{correct_path}/"
-                        children = db.query(FileMetadata).filter(
-                            FileMetadata.path.startswith(old_prefix)
-                        ).all()
-                        for child in children:
-                            child.path = new_prefix + child.path[len(old_prefix):]
-                            if child.parent_path:
-                                if child.parent_path == old_path:
-                                    child.parent_path = correct_path
-                                elif child.parent_path.startswith(old_prefix):
-                                    child.parent_path = new_prefix + child.parent_path[len(old_prefix):]
+                        child_ids = list(db.scalars(
+                            select(FileMetadata.id).where(_below(old_path))
+                        ))
+                        _rewrite_subtree(db, child_ids, old_path, correct_path, None)
                 
                 fixed_count += 1
                 
@@ -0,0 +1,311 @@
+"""Bulk ownership transfers: resumable, batched subtree rewrites.
+
+``ownership.transfer_ownership`` does everything in one transaction. That is
+fine for a folder, but a home directory with hundreds of thousands of files
+would hold one huge transaction, and the advisory lock, for minutes. A bulk
+transfer instead:
+
+1. validates and plans like ``transfer_ownership`` and records an
+   ``OwnershipTransferJob`` (``start_bulk_transfer``);
+2. renames the directory on disk and repoints the entry itself (one commit);
+3. rewrites the descendants in id-ordered batches of
+   ``ownership_transfer_batch_size``: metadata, search index, VCL versions
+   and quota, each batch with set-based UPDATEs and its own commit, which
+   also advances the job's keyset cursor (``last_file_id``). Only rows that
+   existed when the root was moved (id up to ``max_file_id``) are rewritten;
+   anything created at the old path while the job runs stays where it is.
+
+An interrupted job continues from its cursor: ``resume_interrupted_jobs`` on
+the primary worker at startup, or ``POST .../jobs/{id}/resume``. A rename
+that happened just before a crash is recognised from the disk state. The
+progress counters on the job row are streamed to the UI by
+``GET /files/transfer-ownership/jobs/{id}/progress``.
+"""
+from __future__ import annotations
+
+import asyncio
+import logging
+from datetime import datetime, timezone
+from typing import Optional
+
+from sqlalchemy import func, or_, select
+from sqlalchemy.orm import Session
+
+from app.core.config import settings
+from app.core.database import SessionLocal
+from app.core.job_lock import job_lock
+from app.models.file_metadata import FileMetadata
+from app.models.ownership_transfer import OwnershipTransferJob
+from app.services.audit.logger_db import get_audit_logger_db
+from app.services.files import ownership
+from app.services.files.ownership import (
+    ConflictStrategy,
+    OwnershipTransferError,
+    OwnershipTransferResult,
+)
+
+logger = logging.getLogger(__name__)
+
+ACTIVE_STATUSES = ("pending", "running")
+
+
+def get_job(db: Session, job_id: int) -> Optional[OwnershipTransferJob]:
+    """Get a bulk transfer job by ID."""
+    return db.get(OwnershipTransferJob, job_id)
+
+
+def _overlapping_job(db: Session, path: str) -> Optional[OwnershipTransferJob]:
+    """An active job whose source is *path*, one of its ancestors or descendants."""
+    ancestors = []
+    parts = path.split("/")
+    for i in range(1, len(parts)):
+        ancestors.append("/".join(parts[:i]))
+    return db.query(OwnershipTransferJob).filter(
+        OwnershipTransferJob.status.in_(ACTIVE_STATUSES),
+        or_(
+            OwnershipTransferJob.source_path == path,
+            OwnershipTransferJob.source_path.in_(ancestors),
+            OwnershipTransferJob.source_path.like(ownership._like_prefix(f"{path}/"), escape="\\"),
+        ),
+    ).first()
+
+
+def start_bulk_transfer(
+    path: str,
+    new_owner_id: int,
+    requesting_user_id: int,
+    requesting_user_is_admin: bool,
+    db: Session,
+    conflict_strategy: ConflictStrategy = "rename",
+    batch_size: Optional[int] = None,
+) -> tuple[OwnershipTransferResult, Optional[OwnershipTransferJob]]:
+    """
+    Validate a recursive transfer and create its job; run it with ``run_bulk_transfer``.
+
+    Files and directories with at most one batch of descendants are
+    transferred right away by ``transfer_ownership``; the returned job is
+    None then, as it is for every rejected or skipped transfer.
+    """
+    batch_size = batch_size or settings.ownership_transfer_batch_size
+    normalized_path = path.strip("/")
+
+    rejected, metadata, new_owner = ownership._validate_transfer(
+        normalized_path, new_owner_id, requesting_user_id, requesting_user_is_admin, db
+    )
+    if rejected is not None:
+        return rejected, None
+    assert metadata is not None and new_owner is not None
+
+    total = 0
+    if metadata.is_directory:
+        total = db.query(func.count(FileMetadata.id)).filter(
+            ownership._below(normalized_path)
+        ).scalar() or 0
+    if total <= batch_size:
+        return ownership.transfer_ownership(
+            path=normalized_path,
+            new_owner_id=new_owner_id,
+            requesting_user_id=requesting_user_id,
+            requesting_user_is_admin=requesting_user_is_admin,
+            db=db,
+            recursive=True,
+            conflict_strategy=conflict_strategy,
+        ), None
+
+    if _overlapping_job(db, normalized_path) is not None:
+        return OwnershipTransferResult(
+            success=False,
+            message="Another ownership transfer is running for this directory",
+            error="TRANSFER_IN_PROGRESS",
+        ), None
+
+    if not (ownership.ROOT_DIR / normalized_path).exists():
+        return OwnershipTransferResult(
+            success=False,
+            message="Source file/directory does not exist on disk",
+            error="DISK_NOT_FOUND"
+        ), None
+
+    physical_move = not ownership._is_in_shared_dir(normalized_path)
+    target_path = normalized_path
+    conflicts: list[ownership.ConflictInfo] = []
+    if physical_move:
+        skipped, planned_path, conflicts = ownership._plan_target(
+            normalized_path, metadata, new_owner, conflict_strategy, True, db
+        )
+        if skipped is not None:
+            return skipped, None
+        assert planned_path is not None
+        target_path = planned_path
+
+    job = OwnershipTransferJob(
+        file_id=metadata.id,
+        source_path=normalized_path,
+        target_path=target_path,
+        old_owner_id=metadata.owner_id,
+        new_owner_id=new_owner_id,
+        requested_by=requesting_user_id,
+        physical_move=physical_move,
+        status="pending",
+        total_items=total + 1,
+    )
+    db.add(job)
+    db.commit()
+    db.refresh(job)
+
+    return OwnershipTransferResult(
+        success=True,
+        message=f"Transfer of {job.total_items} item(s) started",
+        new_path=target_path,
+        conflicts=conflicts,
+    ), job
+
+
+def _move_root(db: Session, job: OwnershipTransferJob) -> None:
+    """Step 2: rename on disk and repoint the transferred entry (caller commits)."""
+    metadata = db.get(FileMetadata, job.file_id)
+    if metadata is None:
+        raise OwnershipTransferError("The transferred entry no longer exists")
+
+    if job.physical_move:
+        source_abs = ownership.ROOT_DIR / job.source_path
+        target_abs = ownership.ROOT_DIR / job.target_path
+        if source_abs.exists() and not target_abs.exists():
+            ownership._rename_on_disk(source_abs, target_abs)
+        elif not target_abs.exists():
+            raise OwnershipTransferError(
+                f"Neither {job.source_path} nor {job.target_path} exists on disk"
+            )
+        # else: renamed before the job was interrupted
+
+    ownership._move_entry(db, metadata, job.target_path, job.new_owner_id)
+    ownership._cascade_shares_on_transfer(metadata.id, job.old_owner_id, job.new_owner_id, db)
+    ownership._cascade_vcl_on_transfer([metadata.id], job.old_owner_id, job.new_owner_id, db)
+
+
+def _next_batch(db: Session, job: OwnershipTransferJob, batch_size: int) -> list[int]:
+    return list(db.scalars(
+        select(FileMetadata.id)
+        .where(
+            ownership._below(job.source_path),
+            FileMetadata.id > job.last_file_id,
+            FileMetadata.id <= job.max_file_id,
+        )
+        .order_by(FileMetadata.id)
+        .limit(batch_size)
+    ))
+
+
+def _execute(db: Session, job: OwnershipTransferJob, batch_size: int) -> None:
+    if job.status == "pending":
+        ownership._acquire_advisory_lock(db, job.source_path)
+        # Snapshot under the lock, in the rename's transaction: later rows at
+        # the old path are new files, not part of the moved tree
+        job.max_file_id = db.scalar(select(func.max(FileMetadata.id))) or 0
+        _move_root(db, job)
+        job.status = "running"
+        job.started_at = datetime.now(timezone.utc)
+        job.processed_items = 1
+        db.commit()
+
+    # Step 3: one short transaction per batch; the lock is per transaction
+    while True:
+        ownership._acquire_advisory_lock(db, job.source_path)
+        ids = _next_batch(db, job, batch_size)
+        if not ids:
+            break
+        ownership._rewrite_subtree(db, ids, job.source_path, job.target_path, job.new_owner_id)
+        ownership._cascade_vcl_on_transfer(ids, job.old_owner_id, job.new_owner_id, db)
+        job.last_file_id = ids[-1]
+        job.processed_items += len(ids)
+        db.commit()
+
+    job.status = "completed"
+    job.completed_at = datetime.now(timezone.utc)
+    db.commit()
+
+    get_audit_logger_db().log_event(
+        event_type="FILE_MODIFY",
+        user=str(job.requested_by),
+        action="ownership_transfer",
+        resource=job.target_path,
+        details={
+            "job_id": job.id,
+            "old_path": job.source_path,
+            "new_path": job.target_path,
+            "old_owner_id": job.old_owner_id,
+            "new_owner_id": job.new_owner_id,
+            "transferred_count": job.processed_items,
+            "recursive": True,
+            "physical_move": job.physical_move,
+        },
+        success=True,
+        db=db
+    )
+
+
+def run_bulk_transfer(job_id: int, batch_size: Optional[int] = None) -> None:
+    """Run (or continue) a bulk transfer job. Uses its own DB session."""
+    batch_size = batch_size or settings.ownership_transfer_batch_size
+    with job_lock("ownership", job_id) as acquired:
+        if not acquired:
+            logger.info("Ownership transfer job %d is running in another worker", job_id)
+            return
+        db = SessionLocal()
+        try:
+            job = db.get(OwnershipTransferJob, job_id)
+            if job is None or job.status not in ACTIVE_STATUSES:
+                return
+            try:
+                _execute(db, job, batch_size)
+            except Exception as e:
+                db.rollback()
+                logger.exception("Ownership transfer job %d failed", job_id)
+                job.status = "failed"
+                job.error_message = str(e)
+                job.completed_at = datetime.now(timezone.utc)
+                db.commit()
+                get_audit_logger_db().log_event(
+                    event_type="FILE_MODIFY",
+                    user=str(job.requested_by),
+                    action="ownership_transfer",
+                    resource=job.source_path,
+                    details={"job_id": job.id, "processed": job.processed_items},
+                    success=False,
+                    error_message=str(e),
+                    db=db
+                )
+        finally:
+            db.close()
+
+
+def resume_job(db: Session, job_id: int) -> Optional[OwnershipTransferJob]:
+    """Make a failed job runnable again; it continues from its cursor."""
+    job = get_job(db, job_id)
+    if job is not None and job.status == "failed":
+        # Jobs that failed before the root move start over at step 2
+        job.status = "pending" if job.started_at is None else "running"
+        job.error_message = None
+        job.completed_at = None
+        db.commit()
+    return job
+
+
+async def resume_interrupted_jobs() -> int:
+    """Continue every job a restart interrupted (primary worker); returns the count."""
+    db = SessionLocal()
+    try:
+        job_ids = [
+            job_id for (job_id,) in db.query(OwnershipTransferJob.id).filter(
+                OwnershipTransferJob.status.in_(ACTIVE_STATUSES)
+            )
+        ]
+    finally:
+        db.close()
+
+    if not job_ids:
+        return 0
+    logger.info("Resuming %d ownership transfer job(s)", len(job_ids))
+    for job_id in job_ids:
+        await asyncio.to_thread(run_bulk_transfer, job_id)
+    return len(job_ids)
@@ -0,0 +1,385 @@
+"""Indexed file search over ``FileMetadata``.
+
+Finding a file used to mean browsing directory by directory, or an
+``ILIKE '%term%'`` over ``file_metadata`` — a sequential scan at a few
+million rows. ``file_search_index`` keeps one denormalized row per metadata
+row (folded name and path, extension, size, mtime, owner, optional extracted
+text). ``metadata_db`` refreshes it in the same transaction as every
+create/update/rename/delete and owner change, so it never lags behind the
+metadata it mirrors; ``rebuild_index`` repairs it after bulk imports.
+
+Queries (``search_files``):
+
+- ``prefix``: the name starts with the query (type-ahead), a btree
+  ``text_pattern_ops`` range scan;
+- ``contains`` (default): every whitespace-separated term occurs in the name
+  (or the path, ``scope="path"``); on PostgreSQL ``LIKE '%term%'`` is served
+  by the pg_trgm GIN indexes for terms of three or more characters;
+- ``fuzzy``: trigram similarity to the name, best match first (PostgreSQL;
+  ``contains`` elsewhere);
+- ``content=True`` also matches extracted text (``@@`` full-text on
+  PostgreSQL, ``LIKE`` on SQLite).
+
+Attribute filters (folder, extensions, type, size and mtime ranges, owner)
+combine with any mode. Visibility is part of the WHERE clause — the caller's
+own rows, ``Shared/``, and rows at or below a path shared with them — so a
+page is never thinned out after the query and ``limit`` stays exact. Facets
+(extension, type, size class) count at most ``FACET_SCAN_LIMIT`` matches so
+broad queries stay bounded.
+"""
+from __future__ import annotations
+
+import logging
+from dataclasses import dataclass, field
+from datetime import datetime, timezone
+from typing import Literal, Optional, Sequence
+
+from sqlalchemy import and_, case, delete, exists, func, insert, literal_column, or_, select
+from sqlalchemy import inspect as sa_inspect
+from sqlalchemy.orm import Session, aliased
+
+from app.models.file_metadata import FileMetadata
+from app.models.file_search import FileSearchEntry
+from app.models.file_share import FileShare
+from app.schemas.user import UserPublic
+from app.services.files.path_utils import SHARED_DIR_NAME
+from app.services.permissions import is_privileged
+
+logger = logging.getLogger(__name__)
+
+SearchMode = Literal["prefix", "contains", "fuzzy"]
+SearchScope = Literal["name", "path"]
+SearchSort = Literal["relevance", "name", "size", "modified"]
+EntryType = Literal["file", "directory"]
+
+DEFAULT_LIMIT = 50
+MAX_LIMIT = 500
+MAX_OFFSET = 5000
+FACET_SCAN_LIMIT = 10_000
+FACET_TOP = 20
+MAX_CONTENT_CHARS = 200_000
+MAX_EXTENSION_LENGTH = 32
+REBUILD_BATCH = 5000
+
+# (label, exclusive upper bound in bytes)
+SIZE_CLASSES: tuple[tuple[str, Optional[int]], ...] = (
+    ("<1MB", 1 << 20),
+    ("1MB-100MB", 100 << 20),
+    ("100MB-1GB", 1 << 30),
+    (">=1GB", None),
+)
+
+_FTS_CONFIG = literal_column("'simple'::regconfig")
+
+
+def fold(text: str) -> str:
+    """Case-insensitive form stored in and matched against the folded columns."""
+    return text.casefold()
+
+
+def extension_of(name: str, is_directory: bool = False) -> Optional[str]:
+    """Lowercase extension without the dot; None for directories and dotfiles."""
+    if is_directory:
+        return None
+    dot = name.rfind(".")
+    if dot <= 0 or dot == len(name) - 1:
+        return None
+    ext = name[dot + 1:].casefold()
+    return ext if len(ext) <= MAX_EXTENSION_LENGTH else None
+
+
+def _fields(
+    owner_id: int,
+    path: str,
+    name: str,
+    is_directory: bool,
+    size_bytes: Optional[int],
+    mime_type: Optional[str],
+    modified_at: Optional[datetime],
+) -> dict:
+    return {
+        "owner_id": owner_id,
+        "path": path,
+        "name": name,
+        "path_folded": fold(path),
+        "name_folded": fold(name),
+        "extension": extension_of(name, is_directory),
+        "is_directory": bool(is_directory),
+        "size_bytes": size_bytes or 0,
+        "mime_type": mime_type,
+        "modified_at": modified_at,
+    }
+
+
+# ── Index maintenance ─────────────────────────────────────────────────────────
+
+def row_timestamp(metadata: FileMetadata) -> Optional[datetime]:
+    """``coalesce(updated_at, created_at)`` of *metadata* as of its next flush.
+
+    The column defaults are evaluated by the database, so a new or changed
+    row gets its timestamp set here instead; the index then stores the same
+    value that ``rebuild_index`` would read back.
+    """
+    state = sa_inspect(metadata)
+    if state.transient or state.pending:
+        if metadata.created_at is None:
+            metadata.created_at = datetime.now(timezone.utc)
+    elif state.modified:
+        metadata.updated_at = datetime.now(timezone.utc)  # what onupdate would write
+    return metadata.updated_at or metadata.created_at
+
+
+def index_metadata(metadata: FileMetadata) -> FileSearchEntry:
+    """Create or refresh *metadata*'s index row; flushed with the metadata.
+
+    Call after changing the metadata. Deletes need no call: the row goes
+    with its ``FileMetadata`` (ORM and FK cascade).
+    """
+    modified_at = row_timestamp(metadata)
+    entry = metadata.search_entry
+    if entry is None:
+        entry = metadata.search_entry = FileSearchEntry()
+    values = _fields(
+        metadata.owner_id, metadata.path, metadata.name, metadata.is_directory,
+        metadata.size_bytes, metadata.mime_type, modified_at,
+    )
+    for key, value in values.items():
+        setattr(entry, key, value)
+    return entry
+
+
+def set_content(db: Session, file_id: int, text: Optional[str]) -> bool:
+    """Store extracted text for *file_id* (caller commits). False if not indexed."""
+    entry = db.get(FileSearchEntry, file_id)
+    if entry is None:
+        return False
+    entry.content = text[:MAX_CONTENT_CHARS] if text else None
+    return True
+
+
+def rebuild_index(db: Session, batch_size: int = REBUILD_BATCH) -> int:
+    """Rewrite every index row from ``file_metadata``; returns the row count.
+
+    Works in id-ordered batches of *batch_size* (one commit each) so a large
+    table is never held in memory; extracted text is kept.
+    """
+    last_id = 0
+    total = 0
+    while True:
+        rows = db.execute(
+            select(
+                FileMetadata.id, FileMetadata.owner_id, FileMetadata.path, FileMetadata.name,
+                FileMetadata.is_directory, FileMetadata.size_bytes, FileMetadata.mime_type,
+                func.coalesce(FileMetadata.updated_at, FileMetadata.created_at),
+                FileSearchEntry.content,
+            )
+            .outerjoin(FileSearchEntry, FileSearchEntry.file_id == FileMetadata.id)
+            .where(FileMetadata.id > last_id)
+            .order_by(FileMetadata.id)
+            .limit(batch_size)
+        ).all()
+        if not rows:
+            return total
+        ids = [row[0] for row in rows]
+        db.execute(delete(FileSearchEntry).where(FileSearchEntry.file_id.in_(ids)))
+        db.execute(insert(FileSearchEntry), [
+            {"file_id": row[0], "content": row[8], **_fields(*row[1:8])}
+            for row in rows
+        ])
+        db.commit()
+        total += len(rows)
+        last_id = ids[-1]
+
+
+# ── Queries ───────────────────────────────────────────────────────────────────
+
+@dataclass
+class SearchQuery:
+    text: str = ""
+    mode: SearchMode = "contains"
+    scope: SearchScope = "name"
+    content: bool = False
+    folder: Optional[str] = None
+    extensions: Sequence[str] = ()
+    entry_type: Optional[EntryType] = None
+    min_size: Optional[int] = None
+    max_size: Optional[int] = None
+    modified_after: Optional[datetime] = None
+    modified_before: Optional[datetime] = None
+    owner_id: Optional[int] = None
+    sort: SearchSort = "relevance"
+    limit: int = DEFAULT_LIMIT
+    offset: int = 0
+    facets: bool = False
+
+
+@dataclass
+class SearchResult:
+    hits: list[FileSearchEntry]
+    has_more: bool
+    # {"extension": {...}, "type": {...}, "size": {...}, "truncated": bool}
+    facets: Optional[dict] = field(default=None)
+
+
+def _like_escape(term: str) -> str:
+    return term.replace("\\", "\\\\").replace("%", "\\%").replace("_", "\\_")
+
+
+def _starts_with(column, prefix: str):
+    return column.like(_like_escape(prefix) + "%", escape="\\")
+
+
+def _contains(column, term: str):
+    return column.like("%" + _like_escape(term) + "%", escape="\\")
+
+
+def _visible_to(user: UserPublic):
+    """WHERE clause for the rows *user* may see (None: everything)."""
+    if is_privileged(user):
+        return None
+    shared = aliased(FileMetadata)
+    now = datetime.now(timezone.utc)
+    granted = exists(
+        select(literal_column("1"))
+        .select_from(FileShare)
+        .join(shared, FileShare.file_id == shared.id)
+        .where(
+            FileShare.shared_with_user_id == user.id,
+            FileShare.owner_id != user.id,
+            FileShare.can_read.is_(True),
+            or_(FileShare.expires_at.is_(None), FileShare.expires_at > now),
+            # The shared path itself or anything below it
+            or_(
+                FileSearchEntry.path == shared.path,
+                func.substr(FileSearchEntry.path, 1, func.length(shared.path) + 1) == shared.path + "/",
+            ),
+        )
+    )
+    return or_(
+        FileSearchEntry.owner_id == user.id,
+        FileSearchEntry.path == SHARED_DIR_NAME,
+        _starts_with(FileSearchEntry.path, f"{SHARED_DIR_NAME}/"),
+        granted,
+    )
+
+
+def _text_clause(query: SearchQuery, text: str, postgres: bool):
+    column = FileSearchEntry.path_folded if query.scope == "path" else FileSearchEntry.name_folded
+    if query.mode == "prefix":
+        matched = _starts_with(column, text)
+    elif query.mode == "fuzzy" and postgres:
+        matched = column.op("%")(text)  # pg_trgm similarity above pg_trgm.similarity_threshold
+    else:
+        matched = and_(*(_contains(column, term) for term in text.split()))
+    if not query.content:
+        return matched
+    if postgres:
+        in_text = func.to_tsvector(_FTS_CONFIG, func.coalesce(FileSearchEntry.content, literal_column("''"))).op("@@")(
+            func.plainto_tsquery(_FTS_CONFIG, text)
+        )
+    else:
+        in_text = and_(*(_contains(func.lower(FileSearchEntry.content), term) for term in text.split()))
+    return or_(matched, in_text)
+
+
+def _conditions(user: UserPublic, query: SearchQuery, text: str, postgres: bool) -> list:
+    conditions = []
+    visible = _visible_to(user)
+    if visible is not None:
+        conditions.append(visible)
+    if text:
+        conditions.append(_text_clause(query, text, postgres))
+    folder = (query.folder or "").strip("/")
+    if folder:
+        conditions.append(_starts_with(FileSearchEntry.path_folded, fold(folder) + "/"))
+    if query.extensions:
+        conditions.append(FileSearchEntry.extension.in_([fold(e.lstrip(".")) for e in query.extensions]))
+    if query.entry_type is not None:
+        conditions.append(FileSearchEntry.is_directory.is_(query.entry_type == "directory"))
+    if query.min_size is not None:
+        conditions.append(FileSearchEntry.size_bytes >= query.min_size)
+    if query.max_size is not None:
+        conditions.append(FileSearchEntry.size_bytes <= query.max_size)
+    if query.modified_after is not None:
+        conditions.append(FileSearchEntry.modified_at >= query.modified_after)
+    if query.modified_before is not None:
+        conditions.append(FileSearchEntry.modified_at < query.modified_before)
+    if query.owner_id is not None:
+        conditions.append(FileSearchEntry.owner_id == query.owner_id)
+    return conditions
+
+
+def _order_by(query: SearchQuery, text: str, postgres: bool) -> list:
+    tiebreak = [FileSearchEntry.name_folded, FileSearchEntry.file_id]
+    if query.sort == "name" or (query.sort == "relevance" and not text):
+        return tiebreak
+    if query.sort == "size":
+        return [FileSearchEntry.size_bytes.desc(), *tiebreak]
+    if query.sort == "modified":
+        return [FileSearchEntry.modified_at.desc(), *tiebreak]
+    if query.mode == "fuzzy" and postgres:
+        return [func.similarity(FileSearchEntry.name_folded, text).desc(), *tiebreak]
+    # Exact name, then names starting with the query, then shorter names
+    rank = case(
+        (FileSearchEntry.name_folded == text, 0),
+        (_starts_with(FileSearchEntry.name_folded, text), 1),
+        else_=2,
+    )
+    return [rank, func.length(FileSearchEntry.name_folded), *tiebreak]
+
+
+def _facets(db: Session, conditions: list) -> dict:
+    matches = (
+        select(FileSearchEntry.extension, FileSearchEntry.is_directory, FileSearchEntry.size_bytes)
+        .where(*conditions)
+        .limit(FACET_SCAN_LIMIT + 1)
+        .subquery()
+    )
+    scanned = db.execute(select(func.count()).select_from(matches)).scalar() or 0
+
+    extensions = db.execute(
+        select(matches.c.extension, func.count())
+        .where(matches.c.extension.is_not(None))
+        .group_by(matches.c.extension)
+        .order_by(func.count().desc(), matches.c.extension)
+        .limit(FACET_TOP)
+    ).all()
+    types = db.execute(select(matches.c.is_directory, func.count()).group_by(matches.c.is_directory)).all()
+
+    size_class = case(
+        *((matches.c.size_bytes < bound, label) for label, bound in SIZE_CLASSES if bound is not None),
+        else_=SIZE_CLASSES[-1][0],
+    )
+    sizes = dict(db.execute(
+        select(size_class, func.count()).where(matches.c.is_directory.is_(False)).group_by(size_class)
+    ).all())
+
+    return {
+        "extension": {ext: count for ext, count in extensions},
+        "type": {("directory" if is_dir else "file"): count for is_dir, count in types},
+        "size": {label: sizes[label] for label, _ in SIZE_CLASSES if label in sizes},
+        "truncated": scanned > FACET_SCAN_LIMIT,
+    }
+
+
+def search_files(db: Session, user: UserPublic, query: SearchQuery) -> SearchResult:
+    """Index rows matching *query* that *user* may see, one page of them."""
+    postgres = db.get_bind().dialect.name == "postgresql"
+    text = " ".join(fold(query.text).split())
+    limit = max(1, min(query.limit, MAX_LIMIT))
+    offset = max(0, min(query.offset, MAX_OFFSET))
+
+    conditions = _conditions(user, query, text, postgres)
+    rows = db.execute(
+        select(FileSearchEntry)
+        .where(*conditions)
+        .order_by(*_order_by(query, text, postgres))
+        .offset(offset)
+        .limit(limit + 1)
+    ).scalars().all()
+
+    return SearchResult(
+        hits=list(rows[:limit]),
+        has_more=len(rows) > limit,
+        facets=_facets(db, conditions) if query.facets else None,
+    )
@@ -23,6 +23,9 @@ from app.services.hardware.smart.api import (
     get_smart_status,
 )
 
+# --- Engine (monitoring worker) ---
+from app.services.hardware.smart.engine import request_smart_refresh
+
 # --- Scheduler ---
 from app.services.hardware.smart.scheduler import (
     get_smart_scheduler_status,
@@ -86,4 +89,5 @@ __all__ = [
     "toggle_dev_mode",
     "get_smart_device_models",
     "get_smart_device_order",
+    "request_smart_refresh",
 ]
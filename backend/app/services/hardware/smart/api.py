@@ -11,6 +11,7 @@ from app.schemas.system import SmartStatusResponse
 
 from app.services.hardware.smart import cache as _cache
 from app.services.hardware.smart.collector import _read_real_smart_data
+from app.services.hardware.smart.engine import read_published_status
 from app.services.hardware.smart.mock_data import _mock_status
 
 logger = logging.getLogger(__name__)
@@ -60,7 +61,8 @@ def get_smart_status() -> SmartStatusResponse:
     """Return SMART diagnostics information.
 
     In Dev-Mode: Respektiert _DEV_USE_MOCK_DATA Toggle.
-    In Production: Versucht immer echte SMART-Daten zu lesen, Fallback zu Mock bei Fehlern.
+    In Production: Snapshot der SMART-Engine im Monitoring-Worker (kein smartctl
+    in diesem Prozess); ohne Snapshot echte SMART-Daten lesen, Fallback zu Mock.
     """
     cached = _cache.get_cached_smart_status()
     if cached:
@@ -91,7 +93,12 @@ def get_smart_status() -> SmartStatusResponse:
                 _cache._set_smart_cache(mock)
                 return mock
 
-    # Production: Versuche echte Daten, Fallback zu Mock
+    # Production: Engine-Snapshot (per Datei-mtime gememoized, kein Prozess-Cache nötig)
+    published = read_published_status()
+    if published is not None:
+        return published
+
+    # Kein Engine-Snapshot: echte Daten selbst lesen, Fallback zu Mock
     try:
         data = _read_real_smart_data()
         if not data.devices:
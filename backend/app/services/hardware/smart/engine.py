@@ -0,0 +1,421 @@
+"""Per-device SMART collection engine (monitoring worker).
+
+``get_smart_status()`` used to run ``smartctl --scan`` and one smartctl per
+disk whenever its single 120 s cache blob expired, in whichever process
+asked first: one slow or sleeping disk delayed the whole response, and an
+expiry could spin up HDDs that had gone to standby. The engine runs in the
+monitoring worker instead:
+
+- every device has its own schedule (``interval``; failed reads back off up
+  to ``MAX_BACKOFF``) and keeps its own last good reading;
+- reads run on a bounded pool (``settings.smart_max_parallel``), so a slow
+  disk only delays itself;
+- ATA/SCSI disks are read with ``-n standby``: a spun-down disk keeps its
+  last reading (listed under ``standby``) and is never woken. While the
+  sleep manager holds the system in soft sleep (``pause()``) no disk is
+  read; ``resume()`` reads them all once they are spun up again;
+- every change is published to ``SMART_SUMMARY_FILE`` (coalesced to one
+  write per ``PUBLISH_DEBOUNCE``); web workers answer ``get_smart_status()``
+  from it (``read_published_status``) and never run smartctl themselves.
+
+Other processes ask for an early read with ``request_smart_refresh()`` (the
+scheduler job, self-tests), which leaves a marker file in SHM.
+"""
+from __future__ import annotations
+
+import logging
+import threading
+import time
+from concurrent.futures import ThreadPoolExecutor
+from dataclasses import dataclass
+from datetime import datetime, timezone
+from typing import Callable, Dict, Iterable, Optional
+
+from app.schemas.system import SmartDevice, SmartStatusResponse
+
+from app.services.hardware.smart.collector import SmartDeviceStandby, read_device, scan_devices
+from app.services.hardware.smart.enrichment import _enrich_with_filesystem_usage
+
+logger = logging.getLogger(__name__)
+
+DEFAULT_INTERVAL = 120.0
+DEFAULT_MAX_PARALLEL = 4
+MAX_BACKOFF = 1800.0
+RESCAN_INTERVAL = 600.0
+RESCAN_RETRY = 60.0
+PUBLISH_DEBOUNCE = 1.0
+# Readers accept snapshots up to PUBLISHED_MAX_AGE old; republish well within it
+REPUBLISH_INTERVAL = 60.0
+PUBLISHED_MAX_AGE = 180.0
+USAGE_INTERVAL = 60.0  # filesystem/RAID usage enrichment
+REFRESH_POLL_INTERVAL = 2.0
+
+_USAGE_FIELDS = ("used_bytes", "used_percent", "mount_point", "raid_member_of")
+
+
+@dataclass
+class _DeviceState:
+    info: dict
+    reading: Optional[SmartDevice] = None
+    read_at: Optional[float] = None  # wall clock of the reading
+    next_due: float = 0.0
+    in_flight: bool = False
+    standby: bool = False
+    failures: int = 0
+
+
+def _health_key(device: SmartDevice) -> tuple:
+    """What notifications depend on: status plus failing / reallocation attributes."""
+    return (
+        device.status,
+        tuple(sorted(
+            (a.name, a.status, a.raw) for a in device.attributes
+            if a.status != "OK" or "reallocated" in a.name.lower()
+        )),
+    )
+
+
+def _publish_to_shm(payload: dict) -> None:
+    from app.services.monitoring.shm import SMART_SUMMARY_FILE, write_shm
+
+    write_shm(SMART_SUMMARY_FILE, payload)
+
+
+class SmartEngine:
+    """Schedules, runs and publishes per-device SMART reads (see module docstring)."""
+
+    def __init__(
+        self,
+        smartctl_path: str,
+        interval: float = DEFAULT_INTERVAL,
+        max_parallel: int = DEFAULT_MAX_PARALLEL,
+        rescan_interval: float = RESCAN_INTERVAL,
+        publish: Callable[[dict], None] = _publish_to_shm,
+    ) -> None:
+        self._smartctl = smartctl_path
+        self._interval = max(10.0, float(interval))
+        self._max_parallel = max(1, int(max_parallel))
+        self._rescan_interval = rescan_interval
+        self._publish_fn = publish
+        self._devices: Dict[str, _DeviceState] = {}  # scan order
+        self._lock = threading.Lock()
+        self._wake = threading.Event()
+        self._stopping = threading.Event()
+        self._pool: Optional[ThreadPoolExecutor] = None
+        self._thread: Optional[threading.Thread] = None
+        self._paused = False
+        self._dirty = False
+        self._next_rescan = 0.0
+        self._last_publish = 0.0
+        self._refresh_seen = time.time()
+        self._usage: Dict[str, dict] = {}
+        self._usage_at = 0.0
+        self.reads = 0
+        self.standby_skips = 0
+        self.failures = 0
+
+    # ── Lifecycle ────────────────────────────────────────────────────
+
+    @property
+    def running(self) -> bool:
+        return self._thread is not None and self._thread.is_alive()
+
+    def start(self) -> None:
+        if self.running:
+            return
+        self._stopping.clear()
+        self._pool = ThreadPoolExecutor(max_workers=self._max_parallel, thread_name_prefix="smartctl")
+        self._thread = threading.Thread(target=self._run, name="smart-engine", daemon=True)
+        self._thread.start()
+
+    def stop(self) -> None:
+        self._stopping.set()
+        self._wake.set()
+        if self._thread is not None:
+            self._thread.join(timeout=5)
+            self._thread = None
+        if self._pool is not None:
+            # A running smartctl finishes on its own (20 s timeout); nothing waits for it
+            self._pool.shutdown(wait=False, cancel_futures=True)
+            self._pool = None
+
+    def pause(self) -> None:
+        """Stop reading disks (soft sleep); published readings stay available."""
+        self._paused = True
+
+    def resume(self) -> None:
+        """Read every device now (disks were just spun up), then continue."""
+        self._paused = False
+        self.refresh()
+
+    def refresh(self, devices: Optional[Iterable[str]] = None) -> None:
+        """Read *devices* (default: all) as soon as possible."""
+        wanted = set(devices) if devices else None
+        with self._lock:
+            for name, state in self._devices.items():
+                if wanted is None or name in wanted:
+                    state.next_due = 0.0
+        self._wake.set()
+
+    # ── Views ────────────────────────────────────────────────────────
+
+    def snapshot(self) -> SmartStatusResponse:
+        """Last reading of every device (filesystem usage applied)."""
+        with self._lock:
+            states = [s for s in self._devices.values() if s.reading is not None]
+            devices = [s.reading.model_copy() for s in states]
+            newest = max((s.read_at for s in states), default=None)
+        self._apply_usage(devices)
+        checked_at = datetime.fromtimestamp(newest, tz=timezone.utc) if newest else datetime.now(timezone.utc)
+        return SmartStatusResponse(checked_at=checked_at, devices=devices)
+
+    def get_status(self) -> dict:
+        with self._lock:
+            standby = [n for n, s in self._devices.items() if s.standby]
+            failing = [n for n, s in self._devices.items() if s.failures]
+            devices = len(self._devices)
+        return {
+            "is_running": self.running,
+            "paused": self._paused,
+            "devices": devices,
+            "standby": standby,
+            "failing": failing,
+            "reads": self.reads,
+            "standby_skips": self.standby_skips,
+            "failures": self.failures,
+            "interval_seconds": self._interval,
+            "max_parallel": self._max_parallel,
+        }
+
+    # ── Worker thread ────────────────────────────────────────────────
+
+    def _run(self) -> None:
+        while not self._stopping.is_set():
+            now = time.monotonic()
+            try:
+                self._check_refresh_request()
+                if now >= self._next_rescan:
+                    self._rescan(now)
+                if not self._paused:
+                    self._dispatch(now)
+                since_publish = now - self._last_publish
+                if (self._dirty and since_publish >= PUBLISH_DEBOUNCE) or since_publish >= REPUBLISH_INTERVAL:
+                    self._publish()
+            except Exception as exc:
+                logger.warning("SMART engine iteration failed: %s", exc)
+            self._wake.wait(self._sleep_time(time.monotonic()))
+            self._wake.clear()
+
+    def _sleep_time(self, now: float) -> float:
+        timeout = min(REFRESH_POLL_INTERVAL, self._next_rescan - now)
+        if self._dirty:
+            timeout = min(timeout, self._last_publish + PUBLISH_DEBOUNCE - now)
+        if not self._paused:
+            with self._lock:
+                due = [s.next_due for s in self._devices.values() if not s.in_flight]
+            if due:
+                timeout = min(timeout, min(due) - now)
+        return max(0.05, timeout)
+
+    def _rescan(self, now: float) -> None:
+        try:
+            scanned = scan_devices(self._smartctl)
+        except Exception as exc:
+            logger.warning("SMART device scan failed: %s", exc)
+            self._next_rescan = now + min(self._rescan_interval, RESCAN_RETRY)
+            return
+        self._next_rescan = now + self._rescan_interval
+        with self._lock:
+            current = {d["name"]: d for d in scanned}
+            if list(current) != list(self._devices):
+                self._dirty = True
+            devices: Dict[str, _DeviceState] = {}
+            for name, info in current.items():
+                state = self._devices.get(name)
+                if state is None:
+                    state = _DeviceState(info=info)
+                else:
+                    state.info = info
+                devices[name] = state
+            self._devices = devices
+
+    def _dispatch(self, now: float) -> None:
+        pool = self._pool
+        if pool is None:
+            return
+        with self._lock:
+            due = [(n, s) for n, s in self._devices.items() if not s.in_flight and s.next_due <= now]
+            for _, state in due:
+                state.in_flight = True
+        for name, state in due:
+            pool.submit(self._read, name, dict(state.info))
+
+    def _read(self, name: str, info: dict) -> None:
+        reading: Optional[SmartDevice] = None
+        standby = False
+        try:
+            reading = read_device(self._smartctl, info, skip_standby=True)
+        except SmartDeviceStandby:
+            standby = True
+        except Exception as exc:
+            logger.debug("SMART read of %s failed: %s", name, exc)
+        self._record(name, reading, standby)
+
+    def _record(self, name: str, reading: Optional[SmartDevice], standby: bool) -> None:
+        now = time.monotonic()
+        changed: Optional[SmartDevice] = None
+        with self._lock:
+            state = self._devices.get(name)
+            if state is None:
+                return  # vanished from the scan meanwhile
+            state.in_flight = False
+            if standby:
+                state.standby = True
+                state.failures = 0
+                state.next_due = now + self._interval
+                self.standby_skips += 1
+            elif reading is not None:
+                if state.reading is None or _health_key(state.reading) != _health_key(reading):
+                    changed = reading
+                state.reading = reading
+                state.read_at = time.time()
+                state.standby = False
+                state.failures = 0
+                state.next_due = now + self._interval
+                self.reads += 1
+            else:
+                state.failures += 1
+                state.next_due = now + min(self._interval * 2 ** (state.failures - 1), MAX_BACKOFF)
+                self.failures += 1
+            self._dirty = True
+        self._wake.set()
+        if changed is not None:
+            self._notify(changed)
+
+    def _notify(self, device: SmartDevice) -> None:
+        # Only on a first reading or a health change, not on every read
+        from app.services.hardware.smart.api import _check_smart_for_notifications
+
+        _check_smart_for_notifications(SmartStatusResponse(checked_at=datetime.now(timezone.utc), devices=[device]))
+
+    def _apply_usage(self, devices: list[SmartDevice]) -> None:
+        if time.monotonic() - self._usage_at >= USAGE_INTERVAL:
+            _enrich_with_filesystem_usage(devices)
+            self._usage = {d.name: {f: getattr(d, f) for f in _USAGE_FIELDS} for d in devices}
+            self._usage_at = time.monotonic()
+            return
+        for device in devices:
+            for key, value in self._usage.get(device.name, {}).items():
+                setattr(device, key, value)
+
+    def _publish(self) -> None:
+        self._dirty = False
+        self._last_publish = time.monotonic()
+        status = self.snapshot()
+        with self._lock:
+            standby = [n for n, s in self._devices.items() if s.standby]
+        self._publish_fn({
+            # name + temperature: fan_control disk:* sources
+            "devices": [
+                {"name": d.name, "temperature_celsius": float(d.temperature)}
+                for d in status.devices if d.temperature is not None
+            ],
+            "status": status.model_dump(mode="json"),
+            "standby": standby,
+            "timestamp": time.time(),
+        })
+
+    def _check_refresh_request(self) -> None:
+        from app.services.monitoring.shm import SMART_REFRESH_FILE, read_shm
+
+        request = read_shm(SMART_REFRESH_FILE, max_age_seconds=PUBLISHED_MAX_AGE)
+        if not request or request.get("timestamp", 0) <= self._refresh_seen:
+            return
+        self._refresh_seen = request["timestamp"]
+        self.refresh(request.get("devices"))
+
+
+# ── Process-level access ─────────────────────────────────────────────────────
+
+_engine: Optional[SmartEngine] = None
+_published: tuple[float, Optional[SmartStatusResponse]] = (0.0, None)
+
+
+def get_smart_engine() -> Optional[SmartEngine]:
+    """This process's engine; None outside the monitoring worker."""
+    return _engine
+
+
+def start_smart_engine() -> Optional[SmartEngine]:
+    """Start the engine (monitoring worker). None in dev mode or without smartctl."""
+    global _engine
+    from app.core.config import settings
+    from app.services.hardware.smart.utils import _get_smartctl_path
+
+    if _engine is not None:
+        return _engine
+    if settings.is_dev_mode:
+        return None
+    smartctl = _get_smartctl_path()
+    if smartctl is None:
+        logger.info("smartctl not found; SMART engine not started")
+        return None
+    _engine = SmartEngine(
+        smartctl,
+        interval=settings.smart_device_interval_seconds,
+        max_parallel=settings.smart_max_parallel,
+    )
+    _engine.start()
+    logger.info(
+        "SMART engine started (every %ds per device, %d parallel)",
+        settings.smart_device_interval_seconds, settings.smart_max_parallel,
+    )
+    return _engine
+
+
+def stop_smart_engine() -> None:
+    global _engine
+    if _engine is not None:
+        _engine.stop()
+        _engine = None
+
+
+def request_smart_refresh(devices: Optional[list[str]] = None) -> None:
+    """Ask the engine (in whichever process it runs) to read *devices* now."""
+    if _engine is not None:
+        _engine.refresh(devices)
+        return
+    from app.services.monitoring.shm import SMART_REFRESH_FILE, write_shm
+
+    write_shm(SMART_REFRESH_FILE, {"devices": devices, "timestamp": time.time()})
+
+
+def read_published_status() -> Optional[SmartStatusResponse]:
+    """The engine's latest snapshot, or None if no engine is publishing.
+
+    Parsed once per published file (keyed by mtime), not per call.
+    """
+    global _published
+    from app.services.monitoring.shm import SHM_DIR, SMART_SUMMARY_FILE, read_shm
+
+    try:
+        mtime = (SHM_DIR / SMART_SUMMARY_FILE).stat().st_mtime
+    except OSError:
+        return None
+    if time.time() - mtime > PUBLISHED_MAX_AGE:
+        return None
+    if mtime == _published[0]:
+        return _published[1]
+    payload = read_shm(SMART_SUMMARY_FILE, max_age_seconds=PUBLISHED_MAX_AGE)
+    status = None
+    # The fallback summary writer publishes temperatures only
+    if isinstance(payload, dict) and payload.get("status") is not None:
+        try:
+            status = SmartStatusResponse.model_validate(payload["status"])
+        except Exception as exc:
+            logger.debug("Unreadable SMART snapshot: %s", exc)
+        # Nothing read yet and no disk known to be asleep: let the caller collect
+        if status is not None and not status.devices and not payload.get("standby"):
+            status = None
+    _published = (mtime, status)
+    return status
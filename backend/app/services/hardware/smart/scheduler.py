@@ -33,9 +33,11 @@ def _perform_smart_scan_job() -> None:
     try:
         logger.info("SMART scan job: invalidating cache and performing scan")
         invalidate_smart_cache()
-        # Warm the cache by calling get_smart_status (will populate from mock or real)
+        # The engine re-reads every awake disk; the result below is its last snapshot
         # Lazy import to avoid circular dependency
         from app.services.hardware.smart.api import get_smart_status
+        from app.services.hardware.smart.engine import request_smart_refresh
+        request_smart_refresh()
         status = get_smart_status()
         logger.info("SMART scan job: completed")
         complete_scheduler_execution(
@@ -82,6 +84,8 @@ def run_smart_self_test(device: str, test_type: str = "short") -> str:
         if result.returncode:
             logger.warning("smartctl -t returned code %d for %s (non-fatal)", result.returncode, device)
         invalidate_smart_cache()
+        from app.services.hardware.smart.engine import request_smart_refresh
+        request_smart_refresh([device])
         return f"SMART {test_type} test started for {device}"
     except subprocess.TimeoutExpired as exc:
         raise RuntimeError(f"SMART test command timed out for {device}") from exc
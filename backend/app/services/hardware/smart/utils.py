@@ -6,11 +6,14 @@ from __future__ import annotations
 
 import logging
 import platform
+import re
 
 from app.schemas.system import SmartSelfTest
 
 logger = logging.getLogger(__name__)
 
+_STANDBY_MESSAGE = re.compile(r"Device is in (STANDBY|SLEEP)", re.IGNORECASE)
+
 
 def _get_smartctl_path() -> str | None:
     """Find smartctl executable path."""
@@ -81,23 +84,49 @@ def _get_model_from_lsblk(device_name: str) -> str | None:
     return None
 
 
-def _run_smartctl(smartctl_path: str, dev_type: str, device_name: str) -> tuple[object, dict | None]:
+def _is_nvme(dev_type: str, device_name: str) -> bool:
+    return 'nvme' in dev_type.lower() or 'nvme' in device_name.lower()
+
+
+def _is_standby_result(result: object) -> bool:
+    """True if smartctl ``-n standby`` skipped the device (it was spun down)."""
+    # smartctl exits with 2 and reports "Device is in STANDBY mode, exit(2)"
+    if getattr(result, 'returncode', None) != 2:
+        return False
+    output = getattr(result, 'stdout', '') or ''
+    return bool(_STANDBY_MESSAGE.search(output))
+
+
+def _run_smartctl(
+    smartctl_path: str,
+    dev_type: str,
+    device_name: str,
+    skip_standby: bool = False,
+) -> tuple[object, dict | None]:
     """Run smartctl and return (subprocess_result, parsed_json_or_None).
 
     Uses bitmask return-code check: only bits 0 (command-line error) and
     1 (device open failed) cause the result to be discarded.  Higher bits
     (SMART command failed, disk failing, error-log entries, self-test log
     entries) are informational — the JSON output is still valid.
+
+    With *skip_standby* an ATA/SCSI disk that is spun down is not woken
+    (``-n standby``); the result is then discarded and
+    ``_is_standby_result(result)`` is True. NVMe ignores the flag.
     """
     import json
     import subprocess
-    import re as _re
     base_args = ["sudo", "-n", smartctl_path, '-H', '-i', '-l', 'selftest', '-j', '-d', dev_type, device_name]
-    if not _re.search(r'nvme', dev_type, _re.IGNORECASE) and 'nvme' not in device_name.lower():
+    if not _is_nvme(dev_type, device_name):
         base_args.insert(3, '-A')
+        if skip_standby:
+            base_args[3:3] = ['-n', 'standby']
     result = subprocess.run(base_args, capture_output=True, text=True, check=False, timeout=20)
     # Only abort on bit 0 (parse error) or bit 1 (device open failed)
     if result.returncode & 0b11:
+        if skip_standby and _is_standby_result(result):
+            logger.debug("smartctl: %s is in standby, not woken", device_name)
+            return result, None
         logger.warning("smartctl error for %s (code %d, bits 0-1 set) — skipping", device_name, result.returncode)
         return result, None
     try:
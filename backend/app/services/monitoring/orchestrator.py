@@ -30,6 +30,8 @@ from app.services.monitoring.process_tracker import ProcessTracker
 from app.services.monitoring.uptime_collector import UptimeCollector
 from app.services.monitoring.gpu_collector import GpuMetricCollector
 from app.services.monitoring.retention_manager import RetentionManager
+from app.services.monitoring.rollups import RollupAggregator
+from app.services.monitoring.shm_ring import get_metric_rings
 
 logger = logging.getLogger(__name__)
 
@@ -98,6 +100,7 @@ class MonitoringOrchestrator:
             persist_interval=persist_interval,
         )
         self.retention_manager = RetentionManager()
+        self.rollups = RollupAggregator()
 
         # State
         self._monitor_task: Optional[asyncio.Task] = None
@@ -136,6 +139,11 @@ class MonitoringOrchestrator:
 
         self._is_running = True
 
+        from app.core.config import settings
+        if settings.monitoring_process_tracking == "events":
+            if not self.process_tracker.start_event_tracking():
+                logger.info("Event-driven process tracking unsupported here, scanning processes")
+
         # Start monitoring loop
         self._monitor_task = asyncio.create_task(self._monitor_loop())
         logger.info(
@@ -167,6 +175,19 @@ class MonitoringOrchestrator:
                 pass
             self._cleanup_task = None
 
+        self.process_tracker.stop_event_tracking()
+
+        # Write the partially filled rollup buckets; the next run merges into them
+        if self._db_session_factory and self.rollups.pending():
+            try:
+                db = self._db_session_factory()
+                try:
+                    self.rollups.flush(db, include_open=True)
+                finally:
+                    db.close()
+            except Exception as e:
+                logger.error(f"Failed to flush rollups on shutdown: {e}")
+
         logger.info("Monitoring orchestrator stopped")
 
     async def _monitor_loop(self) -> None:
@@ -207,19 +228,35 @@ class MonitoringOrchestrator:
                 logger.error(f"Failed to get DB session: {e}")
 
         try:
-            # Collect from all metric collectors
-            self.cpu_collector.process_sample(db)
-            self.memory_collector.process_sample(db)
-            self.network_collector.process_sample(db)
+            # Collect from all metric collectors; each sample is also
+            # published to the shared rings for the web workers and added
+            # to the rollup buckets
+            rings = get_metric_rings()
+            samples = {
+                "cpu": self.cpu_collector.process_sample(db),
+                "memory": self.memory_collector.process_sample(db),
+                "network": self.network_collector.process_sample(db),
+            }
             self.uptime_collector.process_sample(db)
             # GPU (no-op when no dedicated GPU detected)
-            self.gpu_collector.process_sample(db)
+            samples["gpu"] = self.gpu_collector.process_sample(db)
+            for kind, sample in samples.items():
+                label = self.network_collector.get_active_interface_type() if kind == "network" else None
+                rings.publish(kind, sample, label=label)
+                self.rollups.add(kind, sample)
 
             # Disk I/O collects multiple samples (one per disk)
             disk_samples = self.disk_io_collector.collect_all_samples()
+            for disk_sample in disk_samples:
+                rings.publish("disk_io", disk_sample, label=disk_sample.disk_name)
+                self.rollups.add("disk_io", disk_sample, series=disk_sample.disk_name)
             if should_persist and db and disk_samples:
                 self.disk_io_collector.save_all_to_db(db, disk_samples)
 
+            # Closed rollup buckets are written on persist cycles
+            if db:
+                self.rollups.flush(db)
+
             # Process tracking
             process_samples = self.process_tracker.collect_samples()
             if should_persist and db and process_samples:
@@ -295,16 +332,6 @@ class MonitoringOrchestrator:
         except Exception as e:
             logger.error(f"Retention cleanup failed: {e}")
 
-    # ===== SHM fallback =====
-
-    def _read_shm_data(self) -> Optional[dict]:
-        """Read orchestrator collector data from SHM (written by monitoring_worker)."""
-        try:
-            from app.services.monitoring.shm import read_shm, ORCHESTRATOR_DATA_FILE
-            return read_shm(ORCHESTRATOR_DATA_FILE, max_age_seconds=15.0)
-        except Exception:
-            return None
-
     # ===== Public API for current values =====
 
     def get_cpu_current(self) -> Optional[CpuSampleSchema]:
@@ -313,13 +340,7 @@ class MonitoringOrchestrator:
         if sample is not None:
             return sample
 
-        shm = self._read_shm_data()
-        if shm and shm.get("cpu_current"):
-            try:
-                return CpuSampleSchema(**shm["cpu_current"])
-            except Exception:
-                pass
-        return None
+        return get_metric_rings().latest("cpu")
 
     def get_memory_current(self) -> Optional[MemorySampleSchema]:
         """Get current memory sample (in-memory → SHM fallback)."""
@@ -327,13 +348,7 @@ class MonitoringOrchestrator:
         if sample is not None:
             return sample
 
-        shm = self._read_shm_data()
-        if shm and shm.get("memory_current"):
-            try:
-                return MemorySampleSchema(**shm["memory_current"])
-            except Exception:
-                pass
-        return None
+        return get_metric_rings().latest("memory")
 
     def get_network_current(self) -> Optional[NetworkSampleSchema]:
         """Get current network sample (in-memory → SHM fallback)."""
@@ -341,13 +356,7 @@ class MonitoringOrchestrator:
         if sample is not None:
             return sample
 
-        shm = self._read_shm_data()
-        if shm and shm.get("network_current"):
-            try:
-                return NetworkSampleSchema(**shm["network_current"])
-            except Exception:
-                pass
-        return None
+        return get_metric_rings().latest("network")
 
     def get_network_interface_type(self) -> str:
         """Get network interface type (in-memory → SHM fallback)."""
@@ -355,10 +364,7 @@ class MonitoringOrchestrator:
         if itype != "unknown":
             return itype
 
-        shm = self._read_shm_data()
-        if shm and shm.get("interface_type"):
-            return shm["interface_type"]
-        return itype
+        return get_metric_rings().label("network") or itype
 
     def get_disk_io_current(self) -> Dict:
         """Get current disk I/O samples for all disks (in-memory → SHM fallback)."""
@@ -371,16 +377,9 @@ class MonitoringOrchestrator:
         if result:
             return result
 
-        shm = self._read_shm_data()
-        if shm and shm.get("disk_io_current"):
-            try:
-                return {
-                    disk: DiskIoSampleSchema(**data) if data else None
-                    for disk, data in shm["disk_io_current"].items()
-                }
-            except Exception:
-                pass
-        return {}
+        rings = get_metric_rings()
+        result = {disk: rings.latest("disk_io", disk) for disk in rings.labels("disk_io")}
+        return {k: v for k, v in result.items() if v is not None}
 
     def get_cpu_current_with_db_fallback(self, db: Session) -> Optional[CpuSampleSchema]:
         """Get current CPU sample (in-memory → SHM → DB fallback)."""
@@ -394,8 +393,11 @@ class MonitoringOrchestrator:
         return None
 
     def get_gpu_current(self) -> Optional[GpuSampleSchema]:
-        """Get current GPU sample (in-memory only)."""
-        return self.gpu_collector.get_current()
+        """Get current GPU sample (in-memory → SHM fallback)."""
+        sample = self.gpu_collector.get_current()
+        if sample is not None:
+            return sample
+        return get_metric_rings().latest("gpu")
 
     def get_gpu_current_with_db_fallback(self, db: Session) -> Optional[GpuSampleSchema]:
         """Get current GPU sample (in-memory → DB fallback).
@@ -415,8 +417,11 @@ class MonitoringOrchestrator:
         return None
 
     def get_gpu_history(self, limit: Optional[int] = None) -> List:
-        """Get GPU history from memory buffer."""
-        return self.gpu_collector.get_history_memory(limit)
+        """Get GPU history from memory (in-memory → SHM fallback)."""
+        samples = self.gpu_collector.get_history_memory(limit)
+        if samples:
+            return samples
+        return get_metric_rings().history("gpu", limit=limit)
 
     def get_memory_current_with_db_fallback(self, db: Session) -> Optional[MemorySampleSchema]:
         """Get current memory sample (in-memory → SHM → DB fallback)."""
@@ -489,14 +494,7 @@ class MonitoringOrchestrator:
         if samples:
             return samples
 
-        shm = self._read_shm_data()
-        if shm and shm.get("cpu_history"):
-            try:
-                all_samples = [CpuSampleSchema(**s) for s in shm["cpu_history"]]
-                return all_samples[-limit:] if limit else all_samples
-            except Exception:
-                pass
-        return []
+        return get_metric_rings().history("cpu", limit=limit)
 
     def get_memory_history(self, limit: Optional[int] = None) -> List:
         """Get memory history from memory (in-memory → SHM fallback)."""
@@ -504,14 +502,7 @@ class MonitoringOrchestrator:
         if samples:
             return samples
 
-        shm = self._read_shm_data()
-        if shm and shm.get("memory_history"):
-            try:
-                all_samples = [MemorySampleSchema(**s) for s in shm["memory_history"]]
-                return all_samples[-limit:] if limit else all_samples
-            except Exception:
-                pass
-        return []
+        return get_metric_rings().history("memory", limit=limit)
 
     def get_network_history(self, limit: Optional[int] = None) -> List:
         """Get network history from memory (in-memory → SHM fallback)."""
@@ -519,14 +510,7 @@ class MonitoringOrchestrator:
         if samples:
             return samples
 
-        shm = self._read_shm_data()
-        if shm and shm.get("network_history"):
-            try:
-                all_samples = [NetworkSampleSchema(**s) for s in shm["network_history"]]
-                return all_samples[-limit:] if limit else all_samples
-            except Exception:
-                pass
-        return []
+        return get_metric_rings().history("network", limit=limit)
 
     def get_disk_io_history(self, disk_name: Optional[str] = None) -> "Dict[str, List[DiskIoSampleSchema]] | List[DiskIoSampleSchema]":
         """Get disk I/O history from memory (in-memory → SHM fallback)."""
@@ -539,22 +523,10 @@ class MonitoringOrchestrator:
             if any(v for v in result.values()):
                 return result
 
-        shm = self._read_shm_data()
-        if shm and shm.get("disk_io_history"):
-            try:
-                all_disks = {
-                    d: [DiskIoSampleSchema(**s) for s in samples]
-                    for d, samples in shm["disk_io_history"].items()
-                }
-                if disk_name:
-                    return all_disks.get(disk_name, [])
-                return all_disks
-            except Exception:
-                pass
-
+        rings = get_metric_rings()
         if disk_name:
-            return []
-        return {}
+            return rings.history("disk_io", disk_name)
+        return {disk: rings.history("disk_io", disk) for disk in rings.labels("disk_io")}
 
     def get_disk_io_available_disks(self) -> List[str]:
         """Get available disks (in-memory → SHM fallback)."""
@@ -562,10 +534,7 @@ class MonitoringOrchestrator:
         if disks:
             return disks
 
-        shm = self._read_shm_data()
-        if shm and shm.get("available_disks"):
-            return shm["available_disks"]
-        return []
+        return get_metric_rings().labels("disk_io")
 
     def get_process_history(self, process_name: Optional[str] = None):
         """Get process history from memory."""
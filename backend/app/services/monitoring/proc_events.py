@@ -0,0 +1,321 @@
+"""Event-driven discovery and exit detection of BaluHost processes (Linux).
+
+The scan mode of :class:`ProcessTracker` walks every process on the host
+with psutil on every sample — on a desktop or gaming box with hundreds of
+processes that is one of the most expensive things the monitoring worker
+does, and a crash is only noticed on the next sample. ``ProcessWatcher``
+learns about processes from the kernel instead:
+
+- the netlink proc connector reports every fork and exec; a process is
+  classified (``classify(pid)``, reads comm + cmdline once) when it execs,
+  or when it forks from a process that is already tracked;
+- every tracked process is held by a pidfd, and the watcher thread wakes
+  the moment it exits and reports it via ``on_exit`` — crash detection does
+  not wait for the next sample;
+- samples read ``/proc/<pid>/stat`` of the tracked PIDs only
+  (:func:`read_stat`).
+
+The proc connector needs CAP_NET_ADMIN. Without it the watcher rescans
+``/proc`` (comm + cmdline, no psutil) every ``RESCAN_INTERVAL`` seconds to
+discover new processes; exits stay immediate through the pidfds. With the
+connector a rescan only runs every ``SAFETY_RESCAN_INTERVAL`` and after
+lost messages (ENOBUFS).
+"""
+from __future__ import annotations
+
+import errno
+import logging
+import os
+import select
+import socket
+import struct
+import sys
+import threading
+import time
+from typing import Callable, Dict, Iterator, NamedTuple, Optional, Tuple
+
+logger = logging.getLogger(__name__)
+
+PROC_ROOT = "/proc"
+RESCAN_INTERVAL = 30.0
+SAFETY_RESCAN_INTERVAL = 600.0
+
+# linux/netlink.h, linux/connector.h, linux/cn_proc.h
+NETLINK_CONNECTOR = 11
+NLMSG_DONE = 3
+CN_IDX_PROC = 1
+CN_VAL_PROC = 1
+PROC_CN_MCAST_LISTEN = 1
+PROC_EVENT_FORK = 0x00000001
+PROC_EVENT_EXEC = 0x00000002
+
+_NLMSG_HDR = struct.Struct("=IHHII")   # len | type | flags | seq | pid
+_CN_MSG = struct.Struct("=IIIIHH")     # idx | val | seq | ack | len | flags
+_PROC_EVENT = struct.Struct("=IIQ")    # what | cpu | timestamp_ns
+_FORK = struct.Struct("=IIII")         # parent pid | parent tgid | child pid | child tgid
+_EXEC = struct.Struct("=II")           # pid | tgid
+
+# /proc/<pid>/stat state letters, named like psutil's status values
+_STATUS = {
+    "R": "running", "S": "sleeping", "D": "disk-sleep", "Z": "zombie",
+    "T": "stopped", "t": "tracing-stop", "X": "dead", "x": "dead",
+    "K": "wake-kill", "W": "waking", "P": "parked", "I": "idle",
+}
+
+
+class ProcStat(NamedTuple):
+    status: str
+    cpu_seconds: float  # utime + stime
+    rss_bytes: int
+
+
+_clk_tck: Optional[int] = None
+_page_size: Optional[int] = None
+
+
+def read_stat(pid: int) -> Optional[ProcStat]:
+    """Parse ``/proc/<pid>/stat``; None if the process is gone."""
+    global _clk_tck, _page_size
+    try:
+        with open(f"{PROC_ROOT}/{pid}/stat", "rb") as f:
+            data = f.read()
+    except OSError:
+        return None
+    # comm (field 2) may contain spaces and parentheses: split after the last ")"
+    fields = data[data.rfind(b")") + 2:].split()
+    if len(fields) < 22:
+        return None
+    if _clk_tck is None:
+        _clk_tck = os.sysconf("SC_CLK_TCK")
+        _page_size = os.sysconf("SC_PAGE_SIZE")
+    state = fields[0].decode("ascii", "replace")
+    return ProcStat(
+        status=_STATUS.get(state, "unknown"),
+        cpu_seconds=(int(fields[11]) + int(fields[12])) / _clk_tck,
+        rss_bytes=int(fields[21]) * _page_size,
+    )
+
+
+def read_identity(pid: int) -> Optional[Tuple[str, str]]:
+    """(comm, cmdline) of *pid*, lowercased; None if it is gone or unreadable."""
+    try:
+        with open(f"{PROC_ROOT}/{pid}/comm", "rb") as f:
+            name = f.read().strip()
+        with open(f"{PROC_ROOT}/{pid}/cmdline", "rb") as f:
+            cmdline = f.read().rstrip(b"\0").replace(b"\0", b" ")
+    except OSError:
+        return None
+    return name.decode("utf-8", "replace").lower(), cmdline.decode("utf-8", "replace").lower()
+
+
+def list_pids() -> Iterator[int]:
+    try:
+        names = os.listdir(PROC_ROOT)
+    except OSError:
+        return
+    for name in names:
+        if name.isdigit():
+            yield int(name)
+
+
+def parse_proc_events(data: bytes) -> Iterator[Tuple[int, int, int]]:
+    """``(event, tgid, parent tgid)`` for each process fork/exec in a datagram.
+
+    Thread creation (a fork whose child is not a thread-group leader) is
+    skipped; ``parent tgid`` is 0 for exec events.
+    """
+    offset = 0
+    header = _NLMSG_HDR.size + _CN_MSG.size + _PROC_EVENT.size
+    while offset + _NLMSG_HDR.size <= len(data):
+        length, msg_type, _, _, _ = _NLMSG_HDR.unpack_from(data, offset)
+        if length < _NLMSG_HDR.size or offset + length > len(data):
+            break
+        if msg_type == NLMSG_DONE and length >= header:
+            idx, val, _, _, _, _ = _CN_MSG.unpack_from(data, offset + _NLMSG_HDR.size)
+            event = offset + _NLMSG_HDR.size + _CN_MSG.size
+            what = _PROC_EVENT.unpack_from(data, event)[0]
+            detail = event + _PROC_EVENT.size
+            if (idx, val) != (CN_IDX_PROC, CN_VAL_PROC):
+                pass
+            elif what == PROC_EVENT_FORK and length >= header + _FORK.size:
+                _, parent_tgid, child_pid, child_tgid = _FORK.unpack_from(data, detail)
+                if child_pid == child_tgid:
+                    yield PROC_EVENT_FORK, child_tgid, parent_tgid
+            elif what == PROC_EVENT_EXEC and length >= header + _EXEC.size:
+                yield PROC_EVENT_EXEC, _EXEC.unpack_from(data, detail)[1], 0
+        offset += (length + 3) & ~3  # NLMSG_ALIGN
+
+
+def _open_proc_connector() -> Optional[socket.socket]:
+    """Subscribed proc connector socket, or None (no privilege, no support)."""
+    sock = None
+    try:
+        sock = socket.socket(socket.AF_NETLINK, socket.SOCK_DGRAM, NETLINK_CONNECTOR)
+        sock.bind((0, CN_IDX_PROC))
+        payload = struct.pack("=I", PROC_CN_MCAST_LISTEN)
+        message = _CN_MSG.pack(CN_IDX_PROC, CN_VAL_PROC, 0, 0, len(payload), 0) + payload
+        sock.send(_NLMSG_HDR.pack(_NLMSG_HDR.size + len(message), NLMSG_DONE, 0, 0, 0) + message)
+        sock.setblocking(False)
+        return sock
+    except (OSError, AttributeError) as exc:
+        logger.info("Proc connector unavailable (%s), discovering processes by /proc rescans", exc)
+        if sock is not None:
+            sock.close()
+        return None
+
+
+class ProcessWatcher:
+    """Tracks classified processes by pidfd (see module docstring).
+
+    Args:
+        classify: ``pid -> name or None``; called from the watcher thread.
+        on_exit: ``(pid, name)`` when a tracked process exits or execs into
+            something that is no longer classified as *name*.
+    """
+
+    def __init__(
+        self,
+        classify: Callable[[int], Optional[str]],
+        on_exit: Callable[[int, str], None],
+        rescan_interval: float = RESCAN_INTERVAL,
+    ) -> None:
+        self._classify = classify
+        self._on_exit = on_exit
+        self._rescan_interval = rescan_interval
+        self._tracked: Dict[int, Tuple[str, int]] = {}  # pid -> (name, pidfd)
+        self._lock = threading.Lock()
+        self._sock: Optional[socket.socket] = None
+        self._wake: Optional[Tuple[int, int]] = None
+        self._thread: Optional[threading.Thread] = None
+        self.source = "stopped"  # "netlink" | "rescan" while running
+
+    @staticmethod
+    def supported() -> bool:
+        return sys.platform.startswith("linux") and hasattr(os, "pidfd_open") and os.path.isdir(PROC_ROOT)
+
+    @property
+    def running(self) -> bool:
+        return self._thread is not None and self._thread.is_alive()
+
+    def start(self) -> bool:
+        """Initial rescan, then watch in a daemon thread. False if unsupported."""
+        if self.running:
+            return True
+        if not self.supported():
+            return False
+        self._sock = _open_proc_connector()
+        if self._sock is not None:
+            self.source = "netlink"
+            self._rescan_interval = max(self._rescan_interval, SAFETY_RESCAN_INTERVAL)
+        else:
+            self.source = "rescan"
+        self._wake = os.pipe()
+        self.rescan()
+        self._thread = threading.Thread(target=self._run, name="proc-watcher", daemon=True)
+        self._thread.start()
+        return True
+
+    def stop(self) -> None:
+        if self._wake is not None:
+            os.write(self._wake[1], b"x")
+        if self._thread is not None:
+            self._thread.join(timeout=5)
+            self._thread = None
+        if self._sock is not None:
+            self._sock.close()
+            self._sock = None
+        if self._wake is not None:
+            for fd in self._wake:
+                os.close(fd)
+            self._wake = None
+        with self._lock:
+            for _, pidfd in self._tracked.values():
+                os.close(pidfd)
+            self._tracked.clear()
+        self.source = "stopped"
+
+    def tracked(self) -> Dict[int, str]:
+        """pid -> name of the processes currently tracked."""
+        with self._lock:
+            return {pid: name for pid, (name, _) in self._tracked.items()}
+
+    def rescan(self) -> None:
+        """Classify every process (new ones, and tracked ones that may have exec'd)."""
+        for pid in list_pids():
+            self._consider(pid)
+
+    # ------------------------------------------------------------------
+
+    def _consider(self, pid: int) -> None:
+        name = self._classify(pid)
+        with self._lock:
+            current = self._tracked.get(pid)
+        if current is not None and current[0] != name:
+            self._exited(pid)
+            current = None
+        if name is not None and current is None:
+            try:
+                pidfd = os.pidfd_open(pid)
+            except OSError:
+                return  # already gone
+            with self._lock:
+                self._tracked[pid] = (name, pidfd)
+
+    def _exited(self, pid: int) -> None:
+        with self._lock:
+            entry = self._tracked.pop(pid, None)
+        if entry is None:
+            return
+        name, pidfd = entry
+        os.close(pidfd)
+        try:
+            self._on_exit(pid, name)
+        except Exception as exc:
+            logger.debug("Process exit handler failed for %d: %s", pid, exc)
+
+    def _drain_netlink(self) -> bool:
+        """Handle queued events; False if the kernel dropped some."""
+        with self._lock:
+            tracked = set(self._tracked)
+        while True:
+            try:
+                data = self._sock.recv(65536)
+            except BlockingIOError:
+                return True
+            except OSError as exc:
+                if exc.errno == errno.ENOBUFS:
+                    return False
+                raise
+            for event, pid, parent in parse_proc_events(data):
+                if event == PROC_EVENT_EXEC or parent in tracked:
+                    self._consider(pid)
+                    with self._lock:
+                        if pid in self._tracked:
+                            tracked.add(pid)
+
+    def _run(self) -> None:
+        last_rescan = time.monotonic()
+        while True:
+            with self._lock:
+                by_fd = {pidfd: pid for pid, (_, pidfd) in self._tracked.items()}
+            watched = [self._wake[0], *by_fd]
+            if self._sock is not None:
+                watched.append(self._sock.fileno())
+            timeout = max(0.0, last_rescan + self._rescan_interval - time.monotonic())
+            try:
+                ready, _, _ = select.select(watched, [], [], timeout)
+            except OSError as exc:
+                logger.warning("Process watcher select failed: %s", exc)
+                return
+            if self._wake[0] in ready:
+                return
+            try:
+                for fd in ready:
+                    if fd in by_fd:
+                        self._exited(by_fd[fd])
+                lost = self._sock is not None and self._sock.fileno() in ready and not self._drain_netlink()
+                if lost or time.monotonic() - last_rescan >= self._rescan_interval:
+                    self.rescan()
+                    last_rescan = time.monotonic()
+            except Exception as exc:
+                logger.warning("Process watcher iteration failed: %s", exc)
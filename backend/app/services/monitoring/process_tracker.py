@@ -4,11 +4,18 @@ Process tracker for BaluHost-related processes.
 Tracks the BaluHost systemd units (backend, backend-local, scheduler, webdav,
 monitoring) plus optional dev/operator processes (TUI, frontend-dev) for
 historical analysis and crash detection.
+
+Two modes: by default every sample scans all processes with psutil. After
+``start_event_tracking()`` (the monitoring orchestrator, on Linux) processes
+are discovered and their exits detected by a ``ProcessWatcher``
+(``proc_events.py``), and a sample only reads ``/proc/<pid>/stat`` of the
+tracked PIDs.
 """
 
 from __future__ import annotations
 
 import logging
+import time
 from datetime import datetime, timedelta, timezone
 from threading import Lock
 from typing import Dict, List, Optional
@@ -53,6 +60,14 @@ def get_baluhost_process_patterns() -> List[Dict]:
     return [p for p in BALUHOST_PROCESS_PATTERNS if p["name"] != "baluhost-frontend-dev"]
 
 
+def match_process(name: str, cmdline: str, patterns: List[Dict]) -> Optional[str]:
+    """First pattern entry whose tokens all appear in *name* or *cmdline* (lowercased)."""
+    for entry in patterns:
+        if all(p.lower() in name or p.lower() in cmdline for p in entry["patterns"]):
+            return entry["name"]
+    return None
+
+
 class ProcessTracker:
     """
     Tracks BaluHost-related processes.
@@ -76,19 +91,152 @@ class ProcessTracker:
         self._known_pids: Dict[str, int] = {}  # process_name -> last known PID
         self._lock = Lock()
 
+        # Event mode (start_event_tracking)
+        self._watcher = None
+        self._patterns: List[Dict] = []
+        self._cpu_times: Dict[int, tuple] = {}  # pid -> (cpu seconds, monotonic)
+        self._exit_samples: List[ProcessSampleSchema] = []  # recorded on exit, returned by the next collect
+
+    @property
+    def tracking_mode(self) -> str:
+        """``scan``, or the watcher's event source (``netlink`` / ``rescan``)."""
+        return self._watcher.source if self._watcher is not None else "scan"
+
+    def start_event_tracking(self) -> bool:
+        """Switch to event-driven tracking. False (keeps scanning) if unsupported."""
+        if self._watcher is not None:
+            return True
+        from app.services.monitoring.proc_events import ProcessWatcher
+
+        self._patterns = get_baluhost_process_patterns()
+        watcher = ProcessWatcher(self._classify_pid, self._on_process_exit)
+        if not watcher.start():
+            return False
+        self._watcher = watcher
+        logger.info(
+            "Process tracking is event-driven (%s), %d process(es) tracked",
+            watcher.source, len(watcher.tracked()),
+        )
+        return True
+
+    def stop_event_tracking(self) -> None:
+        watcher, self._watcher = self._watcher, None
+        if watcher is not None:
+            watcher.stop()
+        self._cpu_times.clear()
+
+    def _classify_pid(self, pid: int) -> Optional[str]:
+        from app.services.monitoring.proc_events import read_identity
+
+        identity = read_identity(pid)
+        if identity is None:
+            return None
+        return match_process(identity[0], identity[1], self._patterns)
+
+    def _on_process_exit(self, pid: int, name: str) -> None:
+        """Watcher callback: record the stop as soon as no process of *name* is left."""
+        watcher = self._watcher
+        if watcher is not None and name in watcher.tracked().values():
+            return  # e.g. one backend worker exited, the unit is still running
+        with self._lock:
+            if name not in self._known_pids:
+                return
+            del self._known_pids[name]
+            sample = self._stopped_sample(name, pid, datetime.now(timezone.utc))
+            self._exit_samples.append(sample)
+        logger.warning(f"Process '{name}' (PID {pid}) stopped or crashed")
+
+    def _stopped_sample(self, name: str, pid: int, timestamp: datetime) -> ProcessSampleSchema:
+        """Synthetic is_alive=False sample, appended to the buffer. Caller holds the lock."""
+        sample = ProcessSampleSchema(
+            timestamp=timestamp,
+            process_name=name,
+            pid=pid,
+            cpu_percent=0.0,
+            memory_mb=0.0,
+            status="stopped",
+            is_alive=False,
+        )
+        self._append(name, sample)
+        return sample
+
+    def _append(self, name: str, sample: ProcessSampleSchema) -> None:
+        buffer = self._process_buffers.setdefault(name, [])
+        buffer.append(sample)
+        if len(buffer) > self.buffer_size:
+            buffer.pop(0)
+
+    def _read_tracked(self) -> List[tuple]:
+        """(name, pid, cpu %, memory MB, status) of the watcher's processes."""
+        from app.services.monitoring.proc_events import read_stat
+
+        tracked = self._watcher.tracked() if self._watcher is not None else {}
+        now = time.monotonic()
+        found = []
+        for pid, name in sorted(tracked.items()):
+            stat = read_stat(pid)
+            if stat is None:
+                continue  # exiting; the watcher reports it
+            previous = self._cpu_times.get(pid)
+            self._cpu_times[pid] = (stat.cpu_seconds, now)
+            cpu_percent = 0.0  # like psutil, the first reading of a process is 0
+            if previous is not None and now > previous[1]:
+                cpu_percent = max(0.0, (stat.cpu_seconds - previous[0]) / (now - previous[1]) * 100)
+            found.append((name, pid, cpu_percent, stat.rss_bytes / (1024 * 1024), stat.status))
+        for pid in set(self._cpu_times) - set(tracked):
+            del self._cpu_times[pid]
+        return found
+
     def collect_samples(self) -> List[ProcessSampleSchema]:
         """
         Collect samples for all BaluHost processes.
 
-        Iterates processes once and classifies each PID under the first pattern
-        whose tokens all match. This prevents double-counting when a process
-        matches multiple patterns (e.g. backend-local also matches backend).
+        Scan mode iterates processes once and classifies each PID under the
+        first pattern whose tokens all match. This prevents double-counting
+        when a process matches multiple patterns (e.g. backend-local also
+        matches backend). Event mode samples the watcher's tracked PIDs,
+        which are classified the same way, and also returns the stops the
+        watcher recorded since the last call.
         """
         samples: List[ProcessSampleSchema] = []
         timestamp = datetime.now(timezone.utc)
         seen_names: set[str] = set()
-        active_patterns = get_baluhost_process_patterns()
 
+        found = self._read_tracked() if self._watcher is not None else self._scan()
+        with self._lock:
+            samples.extend(self._exit_samples)
+            self._exit_samples.clear()
+            for matched_name, pid, cpu_percent, memory_mb, status in found:
+                sample = ProcessSampleSchema(
+                    timestamp=timestamp,
+                    process_name=matched_name,
+                    pid=pid,
+                    cpu_percent=round(cpu_percent, 2),
+                    memory_mb=round(memory_mb, 2),
+                    status=status,
+                    is_alive=True,
+                )
+                samples.append(sample)
+                seen_names.add(matched_name)
+                self._append(matched_name, sample)
+                self._known_pids[matched_name] = pid
+
+            # Emit synthetic "stopped" samples for previously seen names that are now gone
+            gone = set(self._known_pids.keys()) - seen_names
+            for matched_name in gone:
+                last_pid = self._known_pids[matched_name]
+                samples.append(self._stopped_sample(matched_name, last_pid, timestamp))
+                logger.warning(
+                    f"Process '{matched_name}' (PID {last_pid}) stopped or crashed"
+                )
+                del self._known_pids[matched_name]
+
+        return samples
+
+    def _scan(self) -> List[tuple]:
+        """(name, pid, cpu %, memory MB, status) of matching processes, via psutil."""
+        found = []
+        active_patterns = get_baluhost_process_patterns()
         try:
             for proc in psutil.process_iter(
                 ["pid", "name", "cmdline", "cpu_percent", "memory_info", "status"]
@@ -98,13 +246,7 @@ class ProcessTracker:
                     name = (info.get("name") or "").lower()
                     cmdline = " ".join(info.get("cmdline") or []).lower()
 
-                    matched_name: Optional[str] = None
-                    for entry in active_patterns:
-                        patterns = entry["patterns"]
-                        if all(p.lower() in name or p.lower() in cmdline for p in patterns):
-                            matched_name = entry["name"]
-                            break
-
+                    matched_name = match_process(name, cmdline, active_patterns)
                     if matched_name is None:
                         continue
 
@@ -112,52 +254,18 @@ class ProcessTracker:
                     if info.get("memory_info"):
                         memory_mb = info["memory_info"].rss / (1024 * 1024)
 
-                    sample = ProcessSampleSchema(
-                        timestamp=timestamp,
-                        process_name=matched_name,
-                        pid=info["pid"],
-                        cpu_percent=round(info.get("cpu_percent", 0.0) or 0.0, 2),
-                        memory_mb=round(memory_mb, 2),
-                        status=info.get("status", "unknown"),
-                        is_alive=True,
-                    )
-                    samples.append(sample)
-                    seen_names.add(matched_name)
-
-                    with self._lock:
-                        self._process_buffers.setdefault(matched_name, []).append(sample)
-                        if len(self._process_buffers[matched_name]) > self.buffer_size:
-                            self._process_buffers[matched_name].pop(0)
-                        self._known_pids[matched_name] = info["pid"]
+                    found.append((
+                        matched_name,
+                        info["pid"],
+                        info.get("cpu_percent", 0.0) or 0.0,
+                        memory_mb,
+                        info.get("status", "unknown"),
+                    ))
                 except (psutil.NoSuchProcess, psutil.AccessDenied):
                     continue
         except Exception as e:
             logger.error(f"Error iterating processes: {e}")
-
-        # Emit synthetic "stopped" samples for previously seen names that are now gone
-        with self._lock:
-            gone = set(self._known_pids.keys()) - seen_names
-            for matched_name in gone:
-                last_pid = self._known_pids[matched_name]
-                sample = ProcessSampleSchema(
-                    timestamp=timestamp,
-                    process_name=matched_name,
-                    pid=last_pid,
-                    cpu_percent=0.0,
-                    memory_mb=0.0,
-                    status="stopped",
-                    is_alive=False,
-                )
-                samples.append(sample)
-                self._process_buffers.setdefault(matched_name, []).append(sample)
-                if len(self._process_buffers[matched_name]) > self.buffer_size:
-                    self._process_buffers[matched_name].pop(0)
-                logger.warning(
-                    f"Process '{matched_name}' (PID {last_pid}) stopped or crashed"
-                )
-                del self._known_pids[matched_name]
-
-        return samples
+        return found
 
     def _find_processes(self, patterns: List[str]) -> List[Dict]:
         """
@@ -23,6 +23,7 @@ from app.models.monitoring import (
     UptimeSample,
     GpuSample,
 )
+from app.services.monitoring.rollups import apply_rollup_retention
 
 logger = logging.getLogger(__name__)
 
@@ -170,13 +171,13 @@ class RetentionManager:
 
     def run_all_cleanup(self, db: Session) -> Dict[str, int]:
         """
-        Run cleanup for all metric types.
+        Run cleanup for all metric types and the rollup tiers.
 
         Args:
             db: Database session
 
         Returns:
-            Dict of metric_type -> deleted count
+            Dict of metric_type (or ``rollups_<tier>``) -> deleted count
         """
         results = {}
 
@@ -184,6 +185,9 @@ class RetentionManager:
             deleted = self.apply_retention_policy(db, metric_type)
             results[metric_type.value] = deleted
 
+        # Rollup tiers have their own retention (partition drops on PostgreSQL)
+        results.update(apply_rollup_retention(db))
+
         total = sum(results.values())
         logger.info(f"Total cleanup: {total} samples deleted")
 
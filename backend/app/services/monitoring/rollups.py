@@ -0,0 +1,481 @@
+"""
+Downsampled monitoring history (rollup tiers).
+
+Raw sample tables keep one row per persisted sample, which makes long-range
+charts pull hundreds of thousands of rows through the ORM. The rollup tier
+aggregates every collected sample (not only the persisted ones) on write into
+1 min, 15 min and 1 h buckets with min/max/avg/p95 per metric field and per
+disk, and history queries read the coarsest tier that still gives the chart
+enough points.
+
+Storage: one narrow row per (metric, series, field, bucket). On PostgreSQL
+each tier table is range-partitioned on ``bucket_start`` (daily partitions
+for 1 min, monthly for 15 min / 1 h, created on demand) with a BRIN index,
+and retention drops whole partitions. SQLite (dev/tests) uses plain tables
+and a DELETE.
+
+Buckets are written once they close. A bucket that was flushed partially
+(shutdown) is merged on conflict: counts/sums add up, min/max combine, and
+p95 keeps the larger of the two — an upper bound, which is what alerting
+charts care about.
+"""
+
+from __future__ import annotations
+
+import logging
+import math
+import re
+import threading
+from datetime import datetime, timedelta, timezone
+from typing import Any, Dict, List, Optional, Tuple, Type
+
+from sqlalchemy import func, text
+from sqlalchemy.orm import Session
+
+from app.core.config import settings
+from app.models.monitoring import MetricRollup15m, MetricRollup1h, MetricRollup1m
+from app.schemas.monitoring import (
+    CpuSampleSchema,
+    DiskIoSampleSchema,
+    MemorySampleSchema,
+    NetworkSampleSchema,
+)
+
+logger = logging.getLogger(__name__)
+
+# Resolution (seconds) -> model, partition span and label
+RESOLUTIONS: Tuple[int, ...] = (60, 900, 3600)
+ROLLUP_MODELS: Dict[int, Type[Any]] = {
+    60: MetricRollup1m,
+    900: MetricRollup15m,
+    3600: MetricRollup1h,
+}
+RESOLUTION_LABELS = {60: "1m", 900: "15m", 3600: "1h"}
+_PARTITION_SPAN = {60: "day", 900: "month", 3600: "month"}
+
+# Aggregated fields per metric; ``series`` is the disk name for disk_io
+ROLLUP_FIELDS: Dict[str, Tuple[str, ...]] = {
+    "cpu": ("usage_percent", "frequency_mhz", "temperature_celsius"),
+    "memory": ("percent", "used_bytes", "total_bytes", "available_bytes", "baluhost_memory_bytes"),
+    "network": ("download_mbps", "upload_mbps"),
+    "disk_io": (
+        "read_mbps", "write_mbps", "read_iops", "write_iops",
+        "avg_response_ms", "active_time_percent",
+    ),
+    "gpu": (
+        "usage_percent", "vram_used_bytes", "vram_total_bytes",
+        "temperature_edge_celsius", "power_watts",
+    ),
+}
+
+DEFAULT_MAX_POINTS = 1000
+# Open buckets kept when the database is unreachable (~2 days of 1 min buckets
+# for a typical box); older ones are dropped rather than growing without bound
+MAX_PENDING_BUCKETS = 50_000
+_UPSERT_BATCH = 200  # rows per INSERT (SQLite bind-parameter limit)
+_KEY_COLUMNS = ("metric", "series", "field", "bucket_start")
+
+
+def retention_days(resolution: int) -> int:
+    """Configured retention of a rollup tier."""
+    return {
+        60: settings.monitoring_rollup_retention_days_1m,
+        900: settings.monitoring_rollup_retention_days_15m,
+        3600: settings.monitoring_rollup_retention_days_1h,
+    }[resolution]
+
+
+def _utc_naive(ts: datetime) -> datetime:
+    if ts.tzinfo is not None:
+        ts = ts.astimezone(timezone.utc).replace(tzinfo=None)
+    return ts
+
+
+def bucket_start(ts: datetime, resolution: int) -> datetime:
+    """Start of the *resolution*-second bucket containing *ts* (naive UTC)."""
+    ts = _utc_naive(ts)
+    epoch = int((ts - datetime(1970, 1, 1)).total_seconds())
+    return datetime(1970, 1, 1) + timedelta(seconds=epoch - epoch % resolution)
+
+
+def percentile_95(values: List[float]) -> float:
+    """Nearest-rank 95th percentile."""
+    ordered = sorted(values)
+    return ordered[max(0, math.ceil(0.95 * len(ordered)) - 1)]
+
+
+def _dialect(db: Session) -> str:
+    try:
+        return db.get_bind().dialect.name
+    except Exception:
+        return ""
+
+
+# ===== On-write aggregation =====
+
+class RollupAggregator:
+    """
+    Accumulates samples into open buckets and writes closed ones.
+
+    ``add`` is called for every collected sample; ``flush`` runs on the
+    orchestrator's persist cycles (and on shutdown with ``include_open``).
+    """
+
+    def __init__(self) -> None:
+        # (resolution, metric, series, field, bucket_start) -> values
+        self._open: Dict[Tuple[int, str, str, str, datetime], List[float]] = {}
+        self._lock = threading.Lock()
+
+    def add(self, metric: str, sample: Any, series: str = "") -> None:
+        """Add one sample (a collector schema) to its buckets."""
+        fields = ROLLUP_FIELDS.get(metric)
+        if fields is None or sample is None:
+            return
+        try:
+            ts = _utc_naive(sample.timestamp)
+        except AttributeError:
+            return
+        values = []
+        for field in fields:
+            value = getattr(sample, field, None)
+            if isinstance(value, (int, float)) and not isinstance(value, bool) and math.isfinite(value):
+                values.append((field, float(value)))
+        if not values:
+            return
+        with self._lock:
+            for resolution in RESOLUTIONS:
+                start = bucket_start(ts, resolution)
+                for field, value in values:
+                    self._open.setdefault((resolution, metric, series, field, start), []).append(value)
+
+    def pending(self) -> int:
+        """Number of buckets not yet written."""
+        with self._lock:
+            return len(self._open)
+
+    def flush(self, db: Session, now: Optional[datetime] = None, include_open: bool = False) -> int:
+        """Write closed (or, with *include_open*, all) buckets; returns rows written."""
+        now = _utc_naive(now or datetime.now(timezone.utc))
+        with self._lock:
+            ready = {
+                key: values for key, values in self._open.items()
+                if include_open or key[4] + timedelta(seconds=key[0]) <= now
+            }
+            for key in ready:
+                del self._open[key]
+        if not ready:
+            return 0
+
+        rows: Dict[int, List[dict]] = {}
+        for (resolution, metric, series, field, start), values in ready.items():
+            rows.setdefault(resolution, []).append({
+                "metric": metric,
+                "series": series,
+                "field": field,
+                "bucket_start": start,
+                "sample_count": len(values),
+                "value_min": min(values),
+                "value_max": max(values),
+                "value_sum": sum(values),
+                "value_p95": percentile_95(values),
+            })
+
+        try:
+            for resolution, tier_rows in rows.items():
+                ensure_partitions(db, resolution, {r["bucket_start"] for r in tier_rows})
+                _upsert(db, ROLLUP_MODELS[resolution], tier_rows)
+            db.commit()
+        except Exception as e:
+            logger.error(f"Failed to write monitoring rollups: {e}")
+            db.rollback()
+            # Partition DDL is transactional: re-check them on the next flush
+            with _partition_lock:
+                _known_partitions.clear()
+            self._requeue(ready)
+            return 0
+        return sum(len(r) for r in rows.values())
+
+    def _requeue(self, ready: Dict[Tuple[int, str, str, str, datetime], List[float]]) -> None:
+        with self._lock:
+            for key, values in ready.items():
+                if len(self._open) >= MAX_PENDING_BUCKETS:
+                    logger.warning("Rollup backlog full, dropping unwritten buckets")
+                    return
+                self._open.setdefault(key, []).extend(values)
+
+
+def _upsert(db: Session, model: Type[Any], rows: List[dict]) -> None:
+    """Insert bucket rows, merging into existing ones with the same key."""
+    dialect = _dialect(db)
+    if dialect == "postgresql":
+        from sqlalchemy.dialects.postgresql import insert
+        least, greatest = func.least, func.greatest
+    elif dialect == "sqlite":
+        from sqlalchemy.dialects.sqlite import insert
+        least, greatest = func.min, func.max
+    else:
+        for row in rows:
+            _merge_row(db, model, row)
+        return
+
+    for i in range(0, len(rows), _UPSERT_BATCH):
+        stmt = insert(model).values(rows[i:i + _UPSERT_BATCH])
+        excluded = stmt.excluded
+        stmt = stmt.on_conflict_do_update(
+            index_elements=list(_KEY_COLUMNS),
+            set_={
+                "sample_count": model.sample_count + excluded.sample_count,
+                "value_min": least(model.value_min, excluded.value_min),
+                "value_max": greatest(model.value_max, excluded.value_max),
+                "value_sum": model.value_sum + excluded.value_sum,
+                "value_p95": greatest(model.value_p95, excluded.value_p95),
+            },
+        )
+        db.execute(stmt)
+
+
+def _merge_row(db: Session, model: Type[Any], row: dict) -> None:
+    existing = db.get(model, tuple(row[c] for c in _KEY_COLUMNS))
+    if existing is None:
+        db.add(model(**row))
+        return
+    existing.sample_count += row["sample_count"]
+    existing.value_min = min(existing.value_min, row["value_min"])
+    existing.value_max = max(existing.value_max, row["value_max"])
+    existing.value_sum += row["value_sum"]
+    existing.value_p95 = max(existing.value_p95, row["value_p95"])
+
+
+# ===== PostgreSQL partitions =====
+
+_partitioned: Dict[str, bool] = {}
+_known_partitions: set = set()
+_partition_lock = threading.Lock()
+_PARTITION_SUFFIX = re.compile(r"_p(\d{8}|\d{6})$")
+
+
+def _is_partitioned(db: Session, table: str) -> bool:
+    if _dialect(db) != "postgresql":
+        return False
+    with _partition_lock:
+        cached = _partitioned.get(table)
+    if cached is None:
+        relkind = db.execute(
+            text("SELECT relkind FROM pg_class WHERE relname = :t AND relkind IN ('p', 'r')"),
+            {"t": table},
+        ).scalar()
+        cached = relkind == "p"
+        with _partition_lock:
+            _partitioned[table] = cached
+    return cached
+
+
+def partition_bounds(resolution: int, start: datetime) -> Tuple[str, datetime, datetime]:
+    """(name suffix, lower, upper) of the partition holding bucket *start*."""
+    if _PARTITION_SPAN[resolution] == "day":
+        lower = datetime(start.year, start.month, start.day)
+        return lower.strftime("p%Y%m%d"), lower, lower + timedelta(days=1)
+    lower = datetime(start.year, start.month, 1)
+    upper = datetime(start.year + (start.month == 12), start.month % 12 + 1, 1)
+    return lower.strftime("p%Y%m"), lower, upper
+
+
+def _partition_upper(resolution: int, name: str) -> Optional[datetime]:
+    match = _PARTITION_SUFFIX.search(name)
+    if not match:
+        return None
+    digits = match.group(1)
+    fmt = "%Y%m%d" if len(digits) == 8 else "%Y%m"
+    return partition_bounds(resolution, datetime.strptime(digits, fmt))[2]
+
+
+def ensure_partitions(db: Session, resolution: int, starts: set) -> None:
+    """Create the partitions for bucket *starts* (PostgreSQL only, idempotent)."""
+    table = ROLLUP_MODELS[resolution].__tablename__
+    if not _is_partitioned(db, table):
+        return
+    for start in starts:
+        suffix, lower, upper = partition_bounds(resolution, start)
+        name = f"{table}_{suffix}"
+        if name in _known_partitions:
+            continue
+        # Bounds come from datetime formatting, never from user input
+        db.execute(text(
+            f"CREATE TABLE IF NOT EXISTS {name} PARTITION OF {table} "
+            f"FOR VALUES FROM ('{lower.isoformat(sep=' ')}') TO ('{upper.isoformat(sep=' ')}')"
+        ))
+        with _partition_lock:
+            _known_partitions.add(name)
+
+
+def apply_rollup_retention(db: Session, now: Optional[datetime] = None) -> Dict[str, int]:
+    """Drop rollup data older than each tier's retention; returns rows removed per tier.
+
+    Partitioned tables lose whole partitions once their upper bound is past
+    the cutoff, so up to one partition span of extra history is kept.
+    """
+    now = _utc_naive(now or datetime.now(timezone.utc))
+    results: Dict[str, int] = {}
+    for resolution, model in ROLLUP_MODELS.items():
+        key = f"rollups_{RESOLUTION_LABELS[resolution]}"
+        cutoff = now - timedelta(days=retention_days(resolution))
+        table = model.__tablename__
+        try:
+            if _is_partitioned(db, table):
+                removed = 0
+                children = db.execute(text(
+                    "SELECT c.relname FROM pg_inherits i "
+                    "JOIN pg_class c ON c.oid = i.inhrelid "
+                    "JOIN pg_class p ON p.oid = i.inhparent "
+                    "WHERE p.relname = :parent"
+                ), {"parent": table}).scalars().all()
+                for child in children:
+                    upper = _partition_upper(resolution, child)
+                    if upper is None or upper > cutoff:
+                        continue
+                    removed += db.execute(text(f"SELECT count(*) FROM {child}")).scalar() or 0
+                    db.execute(text(f"DROP TABLE IF EXISTS {child}"))
+                    with _partition_lock:
+                        _known_partitions.discard(child)
+            else:
+                removed = db.query(model).filter(
+                    model.bucket_start < cutoff
+                ).delete(synchronize_session=False)
+            db.commit()
+            results[key] = removed
+        except Exception as e:
+            logger.error(f"Failed to apply rollup retention for {table}: {e}")
+            db.rollback()
+            results[key] = 0
+    return results
+
+
+# ===== Queries =====
+
+def choose_resolution(
+    start: datetime,
+    end: Optional[datetime] = None,
+    max_points: int = DEFAULT_MAX_POINTS,
+) -> int:
+    """Finest tier that covers [start, end] in at most *max_points* buckets.
+
+    Tiers whose retention does not reach back to *start* are skipped.
+    """
+    now = datetime.now(timezone.utc).replace(tzinfo=None)
+    start = _utc_naive(start)
+    end = _utc_naive(end) if end else now
+    span = max(0.0, (end - start).total_seconds())
+    for resolution in RESOLUTIONS:
+        if start < now - timedelta(days=retention_days(resolution)):
+            continue
+        if span / resolution <= max_points:
+            return resolution
+    return RESOLUTIONS[-1]
+
+
+def query_rollups(
+    db: Session,
+    metric: str,
+    start: datetime,
+    end: Optional[datetime] = None,
+    *,
+    fields: Optional[Tuple[str, ...]] = None,
+    series: Optional[str] = None,
+    resolution: Optional[int] = None,
+    max_points: int = DEFAULT_MAX_POINTS,
+) -> Tuple[int, List[Any]]:
+    """Rollup rows of *metric* in [start, end], oldest first, and the tier used."""
+    resolution = resolution or choose_resolution(start, end, max_points)
+    model = ROLLUP_MODELS[resolution]
+    query = db.query(model).filter(
+        model.metric == metric,
+        model.bucket_start >= bucket_start(start, resolution),
+    )
+    if end is not None:
+        query = query.filter(model.bucket_start <= _utc_naive(end))
+    if fields:
+        query = query.filter(model.field.in_(fields))
+    if series is not None:
+        query = query.filter(model.series == series)
+    return resolution, query.order_by(model.bucket_start.asc()).all()
+
+
+def _cpu_sample(ts: datetime, v: Dict[str, float], _series: str) -> CpuSampleSchema:
+    return CpuSampleSchema(
+        timestamp=ts,
+        usage_percent=v.get("usage_percent", 0.0),
+        frequency_mhz=v.get("frequency_mhz"),
+        temperature_celsius=v.get("temperature_celsius"),
+    )
+
+
+def _memory_sample(ts: datetime, v: Dict[str, float], _series: str) -> MemorySampleSchema:
+    def as_int(name: str) -> Optional[int]:
+        return int(v[name]) if name in v else None
+
+    return MemorySampleSchema(
+        timestamp=ts,
+        used_bytes=as_int("used_bytes") or 0,
+        total_bytes=as_int("total_bytes") or 0,
+        percent=v.get("percent", 0.0),
+        available_bytes=as_int("available_bytes"),
+        baluhost_memory_bytes=as_int("baluhost_memory_bytes"),
+    )
+
+
+def _network_sample(ts: datetime, v: Dict[str, float], _series: str) -> NetworkSampleSchema:
+    return NetworkSampleSchema(
+        timestamp=ts,
+        download_mbps=v.get("download_mbps", 0.0),
+        upload_mbps=v.get("upload_mbps", 0.0),
+    )
+
+
+def _disk_io_sample(ts: datetime, v: Dict[str, float], series: str) -> DiskIoSampleSchema:
+    return DiskIoSampleSchema(
+        timestamp=ts,
+        disk_name=series,
+        read_mbps=v.get("read_mbps", 0.0),
+        write_mbps=v.get("write_mbps", 0.0),
+        read_iops=v.get("read_iops", 0.0),
+        write_iops=v.get("write_iops", 0.0),
+        avg_response_ms=v.get("avg_response_ms"),
+        active_time_percent=v.get("active_time_percent"),
+    )
+
+
+_SAMPLE_BUILDERS = {
+    "cpu": _cpu_sample,
+    "memory": _memory_sample,
+    "network": _network_sample,
+    "disk_io": _disk_io_sample,
+}
+
+
+def history_samples(
+    db: Session,
+    metric: str,
+    start: datetime,
+    *,
+    max_points: int = DEFAULT_MAX_POINTS,
+    series: Optional[str] = None,
+) -> Tuple[int, Dict[str, list]]:
+    """Bucket averages as collector sample schemas, grouped by series.
+
+    Returns the tier used and ``{series: [samples]}`` (series "" for
+    system-wide metrics); empty when the tier has no data for the range.
+    Ranges longer than *max_points* hours return every hourly bucket.
+    """
+    resolution, rows = query_rollups(db, metric, start, series=series, max_points=max_points)
+    grouped: Dict[str, Dict[datetime, Dict[str, float]]] = {}
+    for row in rows:
+        buckets = grouped.setdefault(row.series, {})
+        buckets.setdefault(row.bucket_start, {})[row.field] = row.value_sum / row.sample_count
+    build = _SAMPLE_BUILDERS[metric]
+    return resolution, {
+        name: [
+            build(ts.replace(tzinfo=timezone.utc), values, name)
+            for ts, values in sorted(buckets.items())
+        ]
+        for name, buckets in grouped.items()
+    }
@@ -2,7 +2,9 @@
 Shared-memory IPC via /dev/shm/baluhost/ (Linux) or %TEMP%/baluhost-shm/ (Windows).
 
 Provides atomic JSON read/write for inter-process communication between
-the monitoring_worker process and the main Uvicorn web workers.
+the monitoring_worker process and the main Uvicorn web workers. Per-sample
+metrics (orchestrator collectors, smart plug power) use the binary rings in
+``shm_ring`` instead.
 """
 
 from __future__ import annotations
@@ -30,10 +32,14 @@ POWER_MONITOR_FILE = "power_monitor.json"
 ORCHESTRATOR_STATUS_FILE = "orchestrator_status.json"
 HEARTBEAT_FILE = "heartbeat.json"
 COMMANDS_FILE = "commands.json"
-ORCHESTRATOR_DATA_FILE = "orchestrator_data.json"
 SMART_DEVICES_FILE = "smart_devices.json"
 SMART_DEVICES_CHANGES_FILE = "smart_devices_changes.json"
 SMART_SUMMARY_FILE = "smart_summary.json"
+SMART_REFRESH_FILE = "smart_refresh.json"
+
+# Mapped by the web workers for their whole lifetime (core.decision_cache):
+# a monitoring worker restart must not swap it for a new file under them
+_KEEP_ON_CLEANUP = {"decision_cache.bin"}
 
 
 def _ensure_dir() -> None:
@@ -102,10 +108,12 @@ def read_shm(filename: str, max_age_seconds: float = 30.0) -> Optional[Any]:
 
 
 def cleanup_shm() -> None:
-    """Remove all SHM files and the directory."""
+    """Remove all SHM files (except ``_KEEP_ON_CLEANUP``) and the directory."""
     try:
         if SHM_DIR.exists():
             for f in SHM_DIR.iterdir():
+                if f.name in _KEEP_ON_CLEANUP:
+                    continue
                 try:
                     f.unlink()
                 except OSError:
@@ -7,7 +7,9 @@ Services managed:
 - Monitoring Orchestrator (collectors, 5s interval, DB persistence)
 - Power Monitor (Tapo devices, 5s interval, DB persistence)
 
-Communicates with web workers via /dev/shm/baluhost/ (atomic JSON files).
+Communicates with web workers via /dev/shm/baluhost/: orchestrator samples
+and power readings go to the binary metric rings (``shm_ring``), status and
+the remaining snapshots are atomic JSON files.
 """
 
 from __future__ import annotations
@@ -17,13 +19,12 @@ import logging
 import os
 import time
 from datetime import datetime, timezone
-from typing import Callable, Optional
+from typing import TYPE_CHECKING, Callable, Optional
 
 from app.services.monitoring.shm import (
     TELEMETRY_FILE,
     DISK_IO_FILE,
     ORCHESTRATOR_STATUS_FILE,
-    ORCHESTRATOR_DATA_FILE,
     HEARTBEAT_FILE,
     SMART_SUMMARY_FILE,
     write_shm,
@@ -32,6 +33,9 @@ from app.services.monitoring.shm import (
 )
 from app.plugins.smart_device.poller import SmartDevicePoller
 
+if TYPE_CHECKING:
+    from app.services.hardware.smart.engine import SmartEngine
+
 logger = logging.getLogger(__name__)
 
 # Heartbeat interval (seconds)
@@ -42,12 +46,11 @@ _TELEMETRY_SNAPSHOT_INTERVAL = 3.0
 _DISK_IO_SNAPSHOT_INTERVAL = 1.0
 _POWER_SNAPSHOT_INTERVAL = 5.0  # unused, kept for reference
 _ORCHESTRATOR_SNAPSHOT_INTERVAL = 5.0
-_ORCHESTRATOR_DATA_SNAPSHOT_INTERVAL = 5.0
 _COMMAND_POLL_INTERVAL = 2.0
 _SMART_DEVICES_SNAPSHOT_INTERVAL = 5.0
-# Disk SMART scan is gated by a 120s cache in hardware/smart/cache.py.
-# Republishing the summary every 60s keeps the SHM fresh without forcing
-# extra smartctl invocations.
+# Fallback when the SMART engine is not running (no smartctl): the summary is
+# gated by the 120s cache in hardware/smart/cache.py. With the engine running,
+# it publishes the summary itself (hardware/smart/engine.py).
 _SMART_SUMMARY_SNAPSHOT_INTERVAL = 60.0
 
 
@@ -66,6 +69,7 @@ class MonitoringWorker:
         self._services_started = False
         self._started_at: Optional[float] = None
         self._smart_device_poller: Optional[SmartDevicePoller] = None
+        self._smart_engine: Optional["SmartEngine"] = None
 
     @property
     def running(self) -> bool:
@@ -108,6 +112,14 @@ class MonitoringWorker:
             logger.warning("Smart device poller could not start: %s", exc)
             self._smart_device_poller = None
 
+        # Start per-device SMART collection (publishes SMART_SUMMARY_FILE)
+        try:
+            from app.services.hardware.smart.engine import start_smart_engine
+            self._smart_engine = start_smart_engine()
+        except Exception as exc:
+            logger.warning("SMART engine could not start: %s", exc)
+            self._smart_engine = None
+
         self._services_started = True
         logger.info("All monitoring services started")
 
@@ -121,7 +133,6 @@ class MonitoringWorker:
         last_telemetry = 0.0
         last_disk_io = 0.0
         last_orchestrator = 0.0
-        last_orchestrator_data = 0.0
         last_command_poll = 0.0
         last_smart_devices = 0.0
         last_smart_summary = 0.0
@@ -146,18 +157,13 @@ class MonitoringWorker:
                         self._write_orchestrator_snapshot()
                         last_orchestrator = now
 
-                    # Write orchestrator collector data snapshot
-                    if now - last_orchestrator_data >= _ORCHESTRATOR_DATA_SNAPSHOT_INTERVAL:
-                        self._write_orchestrator_data_snapshot()
-                        last_orchestrator_data = now
-
                     # Write smart devices snapshot
                     if now - last_smart_devices >= _SMART_DEVICES_SNAPSHOT_INTERVAL:
                         self._write_smart_devices_snapshot()
                         last_smart_devices = now
 
                     # Write SMART disk summary snapshot (for fan_control disk:* sources)
-                    if now - last_smart_summary >= _SMART_SUMMARY_SNAPSHOT_INTERVAL:
+                    if self._smart_engine is None and now - last_smart_summary >= _SMART_SUMMARY_SNAPSHOT_INTERVAL:
                         self._write_smart_summary_snapshot()
                         last_smart_summary = now
 
@@ -183,6 +189,13 @@ class MonitoringWorker:
 
         if self._services_started:
             # Stop services in reverse order
+            try:
+                from app.services.hardware.smart.engine import stop_smart_engine
+                stop_smart_engine()
+                self._smart_engine = None
+            except Exception as exc:
+                logger.debug("Error stopping SMART engine: %s", exc)
+
             try:
                 if self._smart_device_poller is not None:
                     await self._smart_device_poller.stop()
@@ -209,6 +222,8 @@ class MonitoringWorker:
 
             self._services_started = False
 
+        from app.services.monitoring.shm_ring import get_metric_rings
+        get_metric_rings().close()
         cleanup_shm()
         logger.info("MonitoringWorker shutdown complete")
 
@@ -263,55 +278,6 @@ class MonitoringWorker:
         except Exception as exc:
             logger.debug("Orchestrator snapshot failed: %s", exc)
 
-    def _write_orchestrator_data_snapshot(self) -> None:
-        """Write orchestrator collector data (current + history) to SHM."""
-        try:
-            from app.services.monitoring.orchestrator import get_monitoring_orchestrator
-
-            orch = get_monitoring_orchestrator()
-
-            # Current values
-            cpu_cur = orch.get_cpu_current()
-            mem_cur = orch.get_memory_current()
-            net_cur = orch.get_network_current()
-            disk_io_cur = orch.get_disk_io_current()
-
-            # History buffers
-            cpu_hist = orch.get_cpu_history()
-            mem_hist = orch.get_memory_history()
-            net_hist = orch.get_network_history()
-            disk_io_hist = orch.get_disk_io_history()
-
-            # Interface type
-            interface_type = orch.network_collector.get_active_interface_type()
-
-            # Available disks
-            available_disks = orch.disk_io_collector.get_available_disks()
-
-            # Serialize via model_dump(mode="json") for datetime handling
-            data = {
-                "cpu_current": cpu_cur.model_dump(mode="json") if cpu_cur else None,
-                "memory_current": mem_cur.model_dump(mode="json") if mem_cur else None,
-                "network_current": net_cur.model_dump(mode="json") if net_cur else None,
-                "disk_io_current": {
-                    disk: s.model_dump(mode="json") if s else None
-                    for disk, s in disk_io_cur.items()
-                } if disk_io_cur else {},
-                "cpu_history": [s.model_dump(mode="json") for s in cpu_hist],
-                "memory_history": [s.model_dump(mode="json") for s in mem_hist],
-                "network_history": [s.model_dump(mode="json") for s in net_hist],
-                "disk_io_history": {
-                    disk: [s.model_dump(mode="json") for s in samples]
-                    for disk, samples in disk_io_hist.items()
-                } if isinstance(disk_io_hist, dict) else {},
-                "available_disks": available_disks,
-                "interface_type": interface_type,
-                "timestamp": time.time(),
-            }
-            write_shm(ORCHESTRATOR_DATA_FILE, data)
-        except Exception as exc:
-            logger.debug("Orchestrator data snapshot failed: %s", exc)
-
     def _write_smart_summary_snapshot(self) -> None:
         """Publish disk SMART summary (name + temperature) to SHM.
 
@@ -456,6 +422,11 @@ class MonitoringWorker:
         pause_disk_io = cmd.get("pause_disk_io", True)
         reduced_telemetry_interval = cmd.get("reduced_telemetry_interval")
 
+        # Disks are spun down in soft sleep; no smartctl may wake them
+        if self._smart_engine is not None:
+            self._smart_engine.pause()
+            logger.info("Paused SMART engine (sleep mode)")
+
         if pause_monitoring:
             try:
                 from app.services.monitoring.orchestrator import stop_monitoring
@@ -516,5 +487,10 @@ class MonitoringWorker:
         except Exception as exc:
             logger.warning("Could not resume orchestrator: %s", exc)
 
+        # Read every disk once now that they are spun up again
+        if self._smart_engine is not None:
+            self._smart_engine.resume()
+            logger.info("Resumed SMART engine")
+
         self._paused = False
         logger.info("Monitoring services resumed")
@@ -0,0 +1,548 @@
+"""Batched, coalescing dispatch of event notifications.
+
+``EventEmitter.emit`` / ``emit_sync`` used to handle every event on its own:
+one insert and commit, one WebSocket frame per recipient and one FCM call
+per device. A degraded array or a mass file operation produces hundreds of
+near-identical events within seconds, and each paid all of those round
+trips on the event loop (FCM calls were blocking, too).
+
+While the dispatcher runs, events are queued instead and flushed once per
+tick: ``WINDOW`` after the first queued event, or as soon as ``FLUSH_BATCH``
+are waiting. A flush
+
+1. coalesces events with the same recipient, event type and severity: exact
+   duplicates become one notification with ``coalesced_count``, related
+   events one summary notification (first title "(+N weitere)", the first
+   ``MAX_LISTED`` messages, per-event metadata under ``items``);
+2. inserts the notifications and routed per-user copies in one transaction,
+   loading admins, routing and preferences once per tick;
+3. sends the WebSocket frames, then one ``unread_count`` update per affected
+   user;
+4. sends each notification's pushes as FCM multicasts (off the event loop)
+   and clears unregistered tokens in one UPDATE.
+
+Not queued: ``NotificationService.create`` (callers get the row back), and
+everything while the dispatcher is stopped (tests, scripts, the monitoring
+worker) or its queue is full; those take the direct path as before. A failed
+insert puts the batch back at the front of the queue; ``stop()`` drains it
+on shutdown.
+"""
+from __future__ import annotations
+
+import asyncio
+import logging
+import threading
+import time
+from collections import deque
+from dataclasses import dataclass, field
+from datetime import datetime, timezone
+from typing import Any, Callable, Optional
+
+from sqlalchemy import update
+from sqlalchemy.orm import Session
+
+from app.models.mobile import MobileDevice
+from app.models.notification import Notification, NotificationPreferences
+from app.models.user import User
+
+logger = logging.getLogger(__name__)
+
+QUEUE_SIZE = 10_000
+FLUSH_BATCH = 1_000
+WINDOW = 0.5  # seconds the first event of a tick waits for related ones
+MAX_LISTED = 5  # messages spelled out in a summary notification
+MAX_ITEMS = 50  # per-event metadata kept on a summary notification
+
+
+@dataclass
+class PendingNotification:
+    """A notification waiting for the next flush."""
+    user_id: Optional[int]  # None = system notification (admins + routed users)
+    category: str
+    notification_type: str
+    title: str
+    message: str
+    action_url: Optional[str] = None
+    extra_data: Optional[dict[str, Any]] = None
+    priority: int = 0
+
+    @property
+    def event_type(self) -> str:
+        return (self.extra_data or {}).get("event_type") or self.category
+
+    def coalesce_key(self) -> tuple:
+        # action_url is part of the key: a summary links to one target only
+        return (self.user_id, self.event_type, self.notification_type, self.action_url)
+
+
+def coalesce(items: list[PendingNotification]) -> list[PendingNotification]:
+    """Merge events with the same recipient, event type, severity and link (order kept)."""
+    groups: dict[tuple, list[PendingNotification]] = {}
+    for item in items:
+        groups.setdefault(item.coalesce_key(), []).append(item)
+    return [_merge(group) for group in groups.values()]
+
+
+def _merge(group: list[PendingNotification]) -> PendingNotification:
+    first = group[0]
+    count = len(group)
+    if count == 1:
+        return first
+
+    priority = max(item.priority for item in group)
+    if all(item.title == first.title and item.message == first.message for item in group):
+        return PendingNotification(
+            user_id=first.user_id,
+            category=first.category,
+            notification_type=first.notification_type,
+            title=f"{first.title} ({count}×)",
+            message=first.message,
+            action_url=first.action_url,
+            extra_data={**(first.extra_data or {}), "coalesced_count": count},
+            priority=priority,
+        )
+
+    messages = list(dict.fromkeys(item.message for item in group))
+    body = "\n".join(messages[:MAX_LISTED])
+    if len(messages) > MAX_LISTED:
+        body += f"\n… und {len(messages) - MAX_LISTED} weitere"
+    return PendingNotification(
+        user_id=first.user_id,
+        category=first.category,
+        notification_type=first.notification_type,
+        title=f"{first.title} (+{count - 1} weitere)",
+        message=body,
+        action_url=first.action_url,
+        extra_data={
+            "event_type": first.event_type,
+            "coalesced_count": count,
+            "items": [item.extra_data for item in group[:MAX_ITEMS]],
+        },
+        priority=priority,
+    )
+
+
+@dataclass
+class _Delivery:
+    """What one written notification still needs after the commit."""
+    payload: dict[str, Any]
+    push: dict[str, Any]
+    admins: bool = False
+    user_ids: list[int] = field(default_factory=list)
+    tokens: list[str] = field(default_factory=list)
+
+
+class NotificationDispatcher:
+    """Per-worker queue plus flush task on the event loop (see module docstring)."""
+
+    def __init__(
+        self,
+        *,
+        max_queue: int = QUEUE_SIZE,
+        batch_size: int = FLUSH_BATCH,
+        window: float = WINDOW,
+    ) -> None:
+        self.max_queue = max_queue
+        self.batch_size = batch_size
+        self.window = window
+
+        self._queue: deque[PendingNotification] = deque()
+        self._lock = threading.Lock()  # submit() is called from worker threads too
+        self._session_factory: Optional[Callable[[], Session]] = None
+        self._loop: Optional[asyncio.AbstractEventLoop] = None
+        self._wake: Optional[asyncio.Event] = None
+        self._stopped: Optional[asyncio.Event] = None  # cuts the window short on stop()
+        self._task: Optional[asyncio.Task] = None
+        self._stopping = False
+
+        self._enqueued = 0
+        self._written = 0
+        self._coalesced = 0
+        self._pushed = 0
+        self._batches = 0
+        self._overflow = 0
+        self._failures = 0
+        self._high_water = 0
+        self._last_flush_ms: Optional[float] = None
+        self._last_error: Optional[str] = None
+        self._last_error_at: Optional[str] = None
+        self._started_at: Optional[float] = None
+
+    # ── Lifecycle ────────────────────────────────────────────────────
+
+    @property
+    def running(self) -> bool:
+        return self._task is not None and not self._task.done()
+
+    def start(self, session_factory: Callable[[], Session]) -> None:
+        """Start the flush task on the running loop; events queue from now on."""
+        if self.running:
+            return
+        self._session_factory = session_factory
+        self._loop = asyncio.get_running_loop()
+        self._wake = asyncio.Event()
+        self._stopped = asyncio.Event()
+        self._stopping = False
+        self._started_at = time.time()
+        self._task = asyncio.create_task(self._run(), name="notification_dispatcher")
+        logger.info(
+            "Notification dispatcher started (window=%.0f ms, batch=%d, queue=%d)",
+            self.window * 1000, self.batch_size, self.max_queue,
+        )
+
+    async def stop(self) -> int:
+        """Stop queueing, finish the current tick and deliver what is left.
+
+        Returns the number of events the final drain handled.
+        """
+        task, self._task = self._task, None
+        if task is None:
+            return 0
+        self._stopping = True
+        if self._wake is not None:
+            self._wake.set()
+        if self._stopped is not None:
+            self._stopped.set()
+        await asyncio.gather(task, return_exceptions=True)
+
+        handled = 0
+        while True:
+            n = await self.flush()
+            if n <= 0:
+                break
+            handled += n
+        if self._queue:
+            logger.error("Notification dispatcher stopped with %d undelivered event(s)", len(self._queue))
+        self._loop = None
+        return handled
+
+    # ── Producer side ────────────────────────────────────────────────
+
+    def submit(self, item: PendingNotification) -> bool:
+        """Queue one notification (any thread).
+
+        Returns False when it was not queued (dispatcher stopped or queue
+        full); the caller then delivers it directly.
+        """
+        loop, wake = self._loop, self._wake
+        if self._task is None or loop is None or wake is None:
+            return False
+        with self._lock:
+            if len(self._queue) >= self.max_queue:
+                self._overflow += 1
+                return False
+            self._queue.append(item)
+            self._enqueued += 1
+            depth = len(self._queue)
+            if depth > self._high_water:
+                self._high_water = depth
+        if depth == 1 or depth >= self.batch_size:
+            # First event opens the window; a full batch goes now
+            try:
+                loop.call_soon_threadsafe(wake.set)
+            except RuntimeError:
+                pass  # loop closing: stop() drains the queue
+        return True
+
+    # ── Flush side ───────────────────────────────────────────────────
+
+    async def _run(self) -> None:
+        assert self._wake is not None
+        while not self._stopping:
+            await self._wake.wait()
+            self._wake.clear()
+            if self._stopping:
+                return
+            if len(self._queue) < self.batch_size:
+                await self._pause()
+            try:
+                handled = await self.flush()
+            except Exception:  # never let the loop die; the next tick retries
+                logger.exception("Notification dispatcher flush crashed")
+                handled = -1
+            if self._queue:
+                # More than one batch waiting, or a failed one went back
+                if handled < 0:
+                    await self._pause()
+                self._wake.set()
+
+    async def _pause(self) -> None:
+        """Wait one window, or less if stop() is called meanwhile."""
+        assert self._stopped is not None
+        try:
+            await asyncio.wait_for(self._stopped.wait(), self.window)
+        except asyncio.TimeoutError:
+            pass
+
+    async def flush(self) -> int:
+        """Deliver up to one batch. Returns events handled, or -1 if the insert failed."""
+        with self._lock:
+            if not self._queue:
+                return 0
+            n = min(len(self._queue), self.batch_size)
+            batch = [self._queue.popleft() for _ in range(n)]
+
+        started = time.perf_counter()
+        merged = coalesce(batch)
+        try:
+            deliveries, unread = await asyncio.to_thread(self._write, merged)
+        except Exception as exc:
+            self._requeue(batch)
+            self._failures += 1
+            self._last_error = str(exc)
+            self._last_error_at = datetime.now().astimezone().isoformat()
+            logger.warning("Notification dispatcher: batch of %d failed, will retry: %s", n, exc)
+            return -1
+
+        self._batches += 1
+        self._written += len(merged)
+        self._coalesced += n - len(merged)
+
+        await self._deliver_in_app(deliveries, unread)
+        pushes = [d for d in deliveries if d.tokens]
+        if pushes:
+            try:
+                await asyncio.to_thread(self._push, pushes)
+            except Exception as exc:
+                logger.error("Notification dispatcher: push delivery failed: %s", exc)
+
+        self._last_flush_ms = round((time.perf_counter() - started) * 1000, 2)
+        return n
+
+    def _requeue(self, batch: list[PendingNotification]) -> None:
+        with self._lock:
+            room = self.max_queue - len(self._queue)
+            keep = batch[:max(room, 0)]
+            self._queue.extendleft(reversed(keep))
+            dropped = len(batch) - len(keep)
+        if dropped:
+            logger.error("Notification dispatcher: dropped %d event(s), queue full", dropped)
+
+    def _write(
+        self, items: list[PendingNotification]
+    ) -> tuple[list[_Delivery], dict[int, int]]:
+        """Insert one tick's notifications and resolve their recipients (worker thread)."""
+        from app.services.notification_routing import get_routed_user_ids
+        from app.services.notifications.firebase import FirebaseService
+        from app.services.notifications.service import get_notification_service
+
+        svc = get_notification_service()
+        factory = self._session_factory
+        if factory is None:
+            from app.core.database import SessionLocal
+            factory = SessionLocal
+
+        with factory() as db:
+            has_system = any(item.user_id is None for item in items)
+            admin_ids: set[int] = set()
+            routed: dict[str, list[int]] = {}
+            if has_system:
+                admin_ids = {
+                    uid for (uid,) in db.query(User.id).filter(
+                        User.role == "admin",
+                        User.is_active == True,
+                    )
+                }
+                for category in {item.category for item in items if item.user_id is None}:
+                    routed[category] = get_routed_user_ids(db, category)
+
+            involved = {item.user_id for item in items if item.user_id is not None}
+            involved |= admin_ids
+            for ids in routed.values():
+                involved.update(ids)
+            prefs: dict[int, NotificationPreferences] = {}
+            if involved:
+                prefs = {
+                    p.user_id: p for p in db.query(NotificationPreferences).filter(
+                        NotificationPreferences.user_id.in_(involved)
+                    )
+                }
+
+            now = datetime.now(timezone.utc)
+            planned: list[tuple[Notification, list[int], bool, list[int]]] = []
+            rows: list[Notification] = []
+            unread_targets: set[int] = set()
+
+            def _row(item: PendingNotification, user_id: Optional[int]) -> Notification:
+                row = Notification(
+                    user_id=user_id,
+                    category=item.category,
+                    notification_type=item.notification_type,
+                    title=item.title,
+                    message=item.message,
+                    action_url=item.action_url,
+                    extra_data=item.extra_data,
+                    priority=item.priority,
+                    is_read=False,
+                    created_at=now,
+                )
+                rows.append(row)
+                return row
+
+            for item in items:
+                row = _row(item, item.user_id)
+                in_app: list[int] = []
+                push_users: list[int] = []
+                if item.user_id is None:
+                    # System notification: admin connections plus routed users;
+                    # admins always get the push, preferences only gate routed users
+                    unread_targets |= admin_ids
+                    push_users.extend(admin_ids)
+                    for uid in routed.get(item.category, []):
+                        user_prefs = prefs.get(uid)
+                        if user_prefs and svc._is_quiet_hours(user_prefs) and item.priority < 3:
+                            continue
+                        _row(item, uid)
+                        unread_targets.add(uid)
+                        if svc._should_send_to_channel(user_prefs, item.category, "in_app"):
+                            in_app.append(uid)
+                        if svc._should_send_to_channel(user_prefs, item.category, "push"):
+                            push_users.append(uid)
+                    planned.append((row, in_app, True, push_users))
+                    continue
+
+                unread_targets.add(item.user_id)
+                user_prefs = prefs.get(item.user_id)
+                # Quiet hours (critical bypasses) and priority threshold: store only
+                quiet = user_prefs is not None and svc._is_quiet_hours(user_prefs) and item.priority < 3
+                below = user_prefs is not None and item.priority < user_prefs.min_priority
+                if not quiet and not below:
+                    if svc._should_send_to_channel(user_prefs, item.category, "in_app"):
+                        in_app.append(item.user_id)
+                    if svc._should_send_to_channel(user_prefs, item.category, "push"):
+                        push_users.append(item.user_id)
+                planned.append((row, in_app, False, push_users))
+
+            db.add_all(rows)
+            db.flush()
+
+            push_ids = {uid for _, _, _, users in planned for uid in users}
+            tokens_by_user: dict[int, list[str]] = {}
+            if push_ids and FirebaseService.is_available():
+                for uid, token in db.query(MobileDevice.user_id, MobileDevice.push_token).filter(
+                    MobileDevice.user_id.in_(push_ids),
+                    MobileDevice.is_active == True,
+                    MobileDevice.push_token.isnot(None),
+                ):
+                    tokens_by_user.setdefault(uid, []).append(token)
+
+            deliveries = [
+                _Delivery(
+                    payload=row.to_dict(),
+                    push={
+                        "title": row.title,
+                        "body": row.message,
+                        "category": row.category,
+                        "priority": row.priority,
+                        "notification_id": row.id,
+                        "action_url": row.action_url,
+                        "notification_type": row.notification_type,
+                    },
+                    admins=admins,
+                    user_ids=in_app,
+                    tokens=list(dict.fromkeys(
+                        token for uid in push_users for token in tokens_by_user.get(uid, [])
+                    )),
+                )
+                for row, in_app, admins, push_users in planned
+            ]
+            db.commit()
+
+            unread = svc.get_unread_totals(db, sorted(unread_targets), admin_ids)
+
+        logger.info(
+            "Notification dispatcher: %d notification(s), %d row(s) written",
+            len(items), len(rows),
+        )
+        return deliveries, unread
+
+    async def _deliver_in_app(
+        self, deliveries: list[_Delivery], unread: dict[int, int]
+    ) -> None:
+        from app.services.websocket_manager import get_websocket_manager
+
+        ws = get_websocket_manager()
+        if not ws:
+            return
+        try:
+            for delivery in deliveries:
+                if delivery.admins:
+                    await ws.broadcast_to_admins(delivery.payload)
+                for uid in delivery.user_ids:
+                    await ws.broadcast_to_user(uid, delivery.payload)
+            # One aggregated count per user per tick instead of one per event
+            for uid, count in unread.items():
+                await ws.send_unread_count(uid, count)
+        except Exception as e:
+            logger.error(f"Failed to broadcast notifications: {e}")
+
+    def _push(self, deliveries: list[_Delivery]) -> None:
+        """One FCM multicast per notification (worker thread)."""
+        from app.services.notifications.firebase import FirebaseService
+
+        unregistered: list[str] = []
+        for delivery in deliveries:
+            result = FirebaseService.send_multicast(delivery.tokens, **delivery.push)
+            self._pushed += result["success_count"]
+            unregistered.extend(result["unregistered"])
+            if result["error"]:
+                logger.error(
+                    "Push for notification %s failed on %d device(s): %s",
+                    delivery.push["notification_id"], result["failure_count"], result["error"],
+                )
+
+        if unregistered:
+            logger.warning("Clearing %d unregistered push token(s)", len(unregistered))
+            factory = self._session_factory
+            if factory is None:
+                from app.core.database import SessionLocal
+                factory = SessionLocal
+            with factory() as db:
+                db.execute(
+                    update(MobileDevice)
+                    .where(MobileDevice.push_token.in_(unregistered))
+                    .values(push_token=None)
+                )
+                db.commit()
+
+    def get_status(self) -> dict[str, Any]:
+        """Counters for the service status dashboard."""
+        with self._lock:
+            depth = len(self._queue)
+        return {
+            "is_running": self.running,
+            "started_at": (
+                datetime.fromtimestamp(self._started_at).astimezone().isoformat()
+                if self._started_at and self.running else None
+            ),
+            "uptime_seconds": (
+                round(time.time() - self._started_at, 1)
+                if self._started_at and self.running else None
+            ),
+            "interval_seconds": self.window,
+            "sample_count": self._written,
+            "error_count": self._failures,
+            "last_error": self._last_error,
+            "last_error_at": self._last_error_at,
+            "queue_depth": depth,
+            "queue_high_water": self._high_water,
+            "queue_capacity": self.max_queue,
+            "enqueued_total": self._enqueued,
+            "written_total": self._written,
+            "coalesced_total": self._coalesced,
+            "pushed_total": self._pushed,
+            "batches_total": self._batches,
+            "overflow_direct_total": self._overflow,
+            "last_flush_ms": self._last_flush_ms,
+        }
+
+
+_dispatcher: Optional[NotificationDispatcher] = None
+
+
+def get_notification_dispatcher() -> NotificationDispatcher:
+    """Get this worker's notification dispatcher (created stopped)."""
+    global _dispatcher
+    if _dispatcher is None:
+        _dispatcher = NotificationDispatcher()
+    return _dispatcher
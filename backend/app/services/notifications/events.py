@@ -531,10 +531,28 @@ class EventEmitter:
             title = config.title_template
             message = config.message_template
 
-        # Create notification
+        # Queue for the next dispatcher tick; direct delivery when it is not
+        # running. Without a session factory (not wired yet) nothing is sent.
+        from app.services.notifications.dispatcher import (
+            PendingNotification,
+            get_notification_dispatcher,
+        )
         from app.services.notifications.service import get_notification_service
 
+        queued = False
         if self._db_session_factory:
+            queued = get_notification_dispatcher().submit(PendingNotification(
+                user_id=user_id,
+                category=config.category,
+                notification_type=config.notification_type,
+                title=title,
+                message=message,
+                action_url=config.action_url,
+                extra_data={"event_type": event_type, **kwargs},
+                priority=config.priority,
+            ))
+
+        if not queued and self._db_session_factory:
             db = self._db_session_factory()
             try:
                 service = get_notification_service()
@@ -639,6 +657,24 @@ class EventEmitter:
                         )
                         return
 
+                from app.services.notifications.dispatcher import (
+                    PendingNotification,
+                    get_notification_dispatcher,
+                )
+
+                if get_notification_dispatcher().submit(PendingNotification(
+                    user_id=user_id,
+                    category=config.category,
+                    notification_type=config.notification_type,
+                    title=title,
+                    message=message,
+                    action_url=config.action_url,
+                    extra_data={"event_type": event_type, **kwargs},
+                    priority=config.priority,
+                )):
+                    _set_cooldown(event_type, cooldown_entity)
+                    return
+
                 from app.models.notification import Notification
 
                 notification = Notification(
@@ -4,6 +4,7 @@ import json
 import logging
 import os
 import tempfile
+import threading
 from typing import Any, Optional, Dict
 from datetime import datetime, timezone
 
@@ -25,12 +26,18 @@ from app.core.config import get_settings
 # Path to credentials file (relative to backend working directory)
 CREDENTIALS_FILE = os.path.join(os.getcwd(), "firebase-credentials.json")
 
+# FCM accepts at most 500 registration tokens per multicast request
+MULTICAST_LIMIT = 500
+
 
 class FirebaseService:
     """Service for sending push notifications via Firebase Cloud Messaging."""
     
     _initialized = False
     _app = None
+    # Startup no longer initializes the SDK; the first caller that needs it does
+    _init_attempted = False
+    _init_lock = threading.Lock()
     
     @classmethod
     def initialize(cls) -> bool:
@@ -81,11 +88,62 @@ class FirebaseService:
             logger.error("Initialization failed: %s", e)
             return False
     
+    @classmethod
+    def _ensure_initialized(cls) -> bool:
+        """Initialize once on first use; a failed attempt is not retried until reset()."""
+        if cls._initialized or cls._init_attempted or not FIREBASE_AVAILABLE:
+            return cls._initialized
+        with cls._init_lock:
+            if not cls._init_attempted:
+                cls._init_attempted = True
+                cls.initialize()
+        return cls._initialized
+
     @classmethod
     def is_available(cls) -> bool:
-        """Check if Firebase is available and initialized."""
-        return FIREBASE_AVAILABLE and cls._initialized
+        """Check if Firebase is available and initialized (initializing it lazily)."""
+        return FIREBASE_AVAILABLE and cls._ensure_initialized()
     
+    @staticmethod
+    def _notification_payload(
+        title: str,
+        body: str,
+        category: str,
+        priority: int,
+        notification_id: Optional[int],
+        action_url: Optional[str],
+        notification_type: str,
+    ) -> Dict[str, Any]:
+        """Message fields shared by single sends and multicasts."""
+        channel_map = {
+            "critical": "alerts_critical",
+            "warning": "alerts_warning",
+            "info": "alerts_info",
+        }
+        channel_id = channel_map.get(notification_type, "alerts_info")
+        return {
+            "notification": messaging.Notification(
+                title=title,
+                body=body,
+            ),
+            "data": {
+                "type": "notification",
+                "notification_id": str(notification_id or 0),
+                "category": category,
+                "priority": str(priority),
+                "action_url": action_url or "",
+            },
+            "android": messaging.AndroidConfig(
+                priority="high",
+                notification=messaging.AndroidNotification(
+                    icon="ic_notification",
+                    color="#38bdf8",
+                    sound="default",
+                    channel_id=channel_id,
+                ),
+            ),
+        }
+
     @classmethod
     def send_notification(
         cls,
@@ -121,33 +179,10 @@ class FirebaseService:
             }
 
         try:
-            channel_map = {
-                "critical": "alerts_critical",
-                "warning": "alerts_warning",
-                "info": "alerts_info",
-            }
-            channel_id = channel_map.get(notification_type, "alerts_info")
-
             message = messaging.Message(
-                notification=messaging.Notification(
-                    title=title,
-                    body=body,
-                ),
-                data={
-                    "type": "notification",
-                    "notification_id": str(notification_id or 0),
-                    "category": category,
-                    "priority": str(priority),
-                    "action_url": action_url or "",
-                },
-                android=messaging.AndroidConfig(
-                    priority="high",
-                    notification=messaging.AndroidNotification(
-                        icon="ic_notification",
-                        color="#38bdf8",
-                        sound="default",
-                        channel_id=channel_id,
-                    ),
+                **cls._notification_payload(
+                    title, body, category, priority, notification_id,
+                    action_url, notification_type,
                 ),
                 token=device_token,
             )
@@ -171,6 +206,61 @@ class FirebaseService:
                 "error": str(e),
             }
 
+    @classmethod
+    def send_multicast(
+        cls,
+        device_tokens: list[str],
+        title: str,
+        body: str,
+        category: str = "system",
+        priority: int = 0,
+        notification_id: Optional[int] = None,
+        action_url: Optional[str] = None,
+        notification_type: str = "info",
+    ) -> Dict[str, Any]:
+        """Send one notification to many devices, MULTICAST_LIMIT tokens per FCM call.
+
+        Returns:
+            dict with success_count, failure_count, unregistered (tokens to
+            clear) and error (first non-token error, if any)
+        """
+        result: Dict[str, Any] = {
+            "success_count": 0,
+            "failure_count": 0,
+            "unregistered": [],
+            "error": None,
+        }
+        if not device_tokens:
+            return result
+        if not cls.is_available():
+            result["failure_count"] = len(device_tokens)
+            result["error"] = "Firebase not initialized"
+            return result
+
+        payload = cls._notification_payload(
+            title, body, category, priority, notification_id, action_url, notification_type,
+        )
+        for start in range(0, len(device_tokens), MULTICAST_LIMIT):
+            chunk = device_tokens[start:start + MULTICAST_LIMIT]
+            try:
+                response = messaging.send_each_for_multicast(
+                    messaging.MulticastMessage(**payload, tokens=chunk)
+                )
+            except Exception as e:
+                result["failure_count"] += len(chunk)
+                result["error"] = result["error"] or str(e)
+                continue
+            result["success_count"] += response.success_count
+            result["failure_count"] += response.failure_count
+            for token, sent in zip(chunk, response.responses):
+                if sent.success:
+                    continue
+                if isinstance(sent.exception, messaging.UnregisteredError):
+                    result["unregistered"].append(token)
+                elif result["error"] is None:
+                    result["error"] = str(sent.exception)
+        return result
+
     @classmethod
     def send_expiration_warning(
         cls,
@@ -388,6 +478,7 @@ class FirebaseService:
                 logger.warning("Warning during app deletion: %s", e)
         cls._app = None
         cls._initialized = False
+        cls._init_attempted = False
 
     @classmethod
     def get_status(cls) -> Dict[str, Any]:
@@ -436,7 +527,7 @@ class FirebaseService:
 
         return {
             "configured": credentials_source is not None,
-            "initialized": cls._initialized,
+            "initialized": cls._ensure_initialized(),
             "project_id": project_id,
             "client_email": client_email,
             "credentials_source": credentials_source,
@@ -635,6 +635,44 @@ class NotificationService:
 
         return query.count()
 
+    def get_unread_totals(
+        self,
+        db: Session,
+        user_ids: list[int],
+        admin_ids: set[int],
+    ) -> dict[int, int]:
+        """Total unread count for many users in two queries.
+
+        Same filter as ``get_unread_count``: users in *admin_ids* also count
+        the system notifications (user_id NULL).
+        """
+        if not user_ids:
+            return {}
+        snooze_filter = or_(
+            Notification.snoozed_until.is_(None),
+            Notification.snoozed_until <= datetime.now(timezone.utc),
+        )
+        base = [
+            Notification.is_read == False,
+            Notification.deleted_at.is_(None),
+            snooze_filter,
+        ]
+        own = dict(
+            db.query(Notification.user_id, func.count(Notification.id))
+            .filter(Notification.user_id.in_(user_ids), *base)
+            .group_by(Notification.user_id)
+            .all()
+        )
+        system = 0
+        if admin_ids.intersection(user_ids):
+            system = db.query(func.count(Notification.id)).filter(
+                Notification.user_id.is_(None), *base
+            ).scalar() or 0
+        return {
+            uid: own.get(uid, 0) + (system if uid in admin_ids else 0)
+            for uid in user_ids
+        }
+
     def mark_as_read(
         self,
         db: Session,
@@ -275,11 +275,21 @@ class PiholeApiClient:
             payload["timer"] = timer
         return await self.post("/api/dns/blocking", json=payload)
 
-    async def get_queries(self, limit: int = 100, offset: int = 0) -> dict[str, Any]:
+    async def get_queries(
+        self,
+        limit: int = 100,
+        offset: int = 0,
+        since: float | None = None,
+        cursor: int | None = None,
+    ) -> dict[str, Any]:
         """GET /api/queries"""
         params: dict[str, Any] = {"length": limit}
         if offset:
             params["start"] = offset
+        if since:
+            params["from"] = int(since)
+        if cursor is not None:
+            params["cursor"] = cursor
         return await self.get("/api/queries", params=params)
 
     async def get_top_domains(self, count: int = 10) -> dict[str, Any]:
@@ -85,7 +85,14 @@ class DevPiholeBackend:
 
     # ── Query Log ─────────────────────────────────────────────────────
 
-    async def get_queries(self, limit: int = 100, offset: int = 0) -> dict[str, Any]:
+    async def get_queries(
+        self,
+        limit: int = 100,
+        offset: int = 0,
+        *,
+        since: float | None = None,
+        cursor: int | None = None,
+    ) -> dict[str, Any]:
         domains = [
             "google.com", "github.com", "reddit.com", "ads.google.com",
             "tracking.facebook.com", "api.github.com", "cdn.jsdelivr.net",
@@ -96,13 +103,19 @@ class DevPiholeBackend:
         query_types = ["A", "AAAA", "A", "A", "AAAA", "HTTPS"]
         clients = ["192.168.1.10", "192.168.1.20", "192.168.1.30", "10.8.0.2", "192.168.1.100"]
 
-        now = time.time()
+        # One mock query every 2.5s up to `total`; the cursor pins "now" so
+        # paging behaves like a stable result set
+        total = 50000
+        now = float(cursor if cursor is not None else int(time.time()))
         queries = []
-        for i in range(limit):
+        for i in range(max(0, min(limit, total - offset))):
+            ts = now - (offset + i) * 2.5
+            if since is not None and ts < since:
+                break
             domain = random.choice(domains)
             s = random.choice(statuses)
             queries.append({
-                "timestamp": now - (offset + i) * 2.5,
+                "timestamp": ts,
                 "domain": domain,
                 "client": random.choice(clients),
                 "query_type": random.choice(query_types),
@@ -110,7 +123,7 @@ class DevPiholeBackend:
                 "reply_type": "IP" if s == "FORWARDED" else ("NXDOMAIN" if s == "BLOCKED" else "CACHE"),
                 "response_time": round(random.uniform(0.5, 150.0), 1),
             })
-        return {"queries": queries, "total": 50000}
+        return {"queries": queries, "total": total, "cursor": int(now)}
 
     # ── Statistics ────────────────────────────────────────────────────
 
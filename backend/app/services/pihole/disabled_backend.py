@@ -52,7 +52,14 @@ class DisabledPiholeBackend:
 
     # ── Query Log ─────────────────────────────────────────────────────
 
-    async def get_queries(self, limit: int = 100, offset: int = 0) -> dict[str, Any]:
+    async def get_queries(
+        self,
+        limit: int = 100,
+        offset: int = 0,
+        *,
+        since: float | None = None,
+        cursor: int | None = None,
+    ) -> dict[str, Any]:
         return {"queries": [], "total": 0}
 
     # ── Statistics ────────────────────────────────────────────────────
@@ -369,8 +369,15 @@ class LocalDockerPiholeBackend:
 
     # ── Query Log ─────────────────────────────────────────────────────
 
-    async def get_queries(self, limit: int = 100, offset: int = 0) -> dict[str, Any]:
-        data = await self._api.get_queries(limit, offset)
+    async def get_queries(
+        self,
+        limit: int = 100,
+        offset: int = 0,
+        *,
+        since: float | None = None,
+        cursor: int | None = None,
+    ) -> dict[str, Any]:
+        data = await self._api.get_queries(limit, offset, since=since, cursor=cursor)
         queries = []
         for q in data.get("queries", []):
             reply = q.get("reply") or {}
@@ -378,6 +385,7 @@ class LocalDockerPiholeBackend:
                 reply = {}
             response_time = reply.get("time")
             queries.append({
+                "id": q.get("id"),
                 "timestamp": q.get("time", 0),
                 "domain": q.get("domain", ""),
                 "client": q.get("client", {}).get("ip", q.get("client", "")),
@@ -386,7 +394,11 @@ class LocalDockerPiholeBackend:
                 "reply_type": reply.get("type", ""),
                 "response_time": response_time,
             })
-        return {"queries": queries, "total": data.get("recordsTotal", len(queries))}
+        return {
+            "queries": queries,
+            "total": data.get("recordsTotal", len(queries)),
+            "cursor": data.get("cursor"),
+        }
 
     # ── Statistics ────────────────────────────────────────────────────
 
@@ -36,8 +36,20 @@ class PiholeBackend(Protocol):
 
     # ── Query Log ─────────────────────────────────────────────────────
 
-    async def get_queries(self, limit: int = 100, offset: int = 0) -> dict[str, Any]:
-        """Return paginated query log."""
+    async def get_queries(
+        self,
+        limit: int = 100,
+        offset: int = 0,
+        *,
+        since: float | None = None,
+        cursor: int | None = None,
+    ) -> dict[str, Any]:
+        """Return paginated query log, newest first.
+
+        ``since`` limits the log to queries at or after a unix timestamp.
+        ``cursor`` (returned with every page) pins later pages to the same
+        result set, so queries arriving mid-pagination do not shift offsets.
+        """
         ...
 
     # ── Statistics ────────────────────────────────────────────────────
@@ -1,7 +1,9 @@
 """DNS query analytics from the local PostgreSQL store.
 
 Extracts all direct ORM queries from the pihole route handlers into
-reusable service functions.
+reusable service functions. Top domains/blocked/clients read the per-hour
+counters maintained by the collector (``query_ingest``) instead of grouping
+the raw ``dns_queries`` table.
 """
 
 from __future__ import annotations
@@ -12,7 +14,14 @@ from typing import Optional
 from sqlalchemy import distinct, func
 from sqlalchemy.orm import Session
 
-from app.models.dns_queries import DnsQuery, DnsQueryCollectorState, DnsQueryHourlyStat
+from app.models.dns_queries import (
+    DnsQuery,
+    DnsQueryClientHourly,
+    DnsQueryCollectorState,
+    DnsQueryDomainHourly,
+    DnsQueryHourlyStat,
+)
+from app.services.pihole.query_ingest import hour_of
 
 
 def _period_to_delta(period: str) -> timedelta:
@@ -92,43 +101,37 @@ def get_stored_stats(db: Session, *, period: str) -> dict:
     }
 
 
+def _top(db: Session, model, key, count: int, period: str, blocked: bool = False) -> list:
+    """Top ``key`` values over a period from the per-hour counters.
+
+    Whole hours are summed, so the hour containing the period start counts
+    in full.
+    """
+    since = hour_of(datetime.now(timezone.utc) - _period_to_delta(period))
+    cnt = func.sum(model.blocked_queries if blocked else model.total_queries)
+    q = (
+        db.query(key, cnt.label("cnt"))
+        .filter(model.hour >= since)
+        .group_by(key)
+    )
+    if blocked:
+        q = q.having(cnt > 0)
+    return q.order_by(cnt.desc()).limit(count).all()
+
+
 def get_stored_top_domains(db: Session, *, count: int, period: str) -> list:
     """Get top queried domains."""
-    since = datetime.now(timezone.utc) - _period_to_delta(period)
-    return (
-        db.query(DnsQuery.domain, func.count().label("cnt"))
-        .filter(DnsQuery.timestamp >= since)
-        .group_by(DnsQuery.domain)
-        .order_by(func.count().desc())
-        .limit(count)
-        .all()
-    )
+    return _top(db, DnsQueryDomainHourly, DnsQueryDomainHourly.domain, count, period)
 
 
 def get_stored_top_blocked(db: Session, *, count: int, period: str) -> list:
     """Get top blocked domains."""
-    since = datetime.now(timezone.utc) - _period_to_delta(period)
-    return (
-        db.query(DnsQuery.domain, func.count().label("cnt"))
-        .filter(DnsQuery.timestamp >= since, DnsQuery.status == "BLOCKED")
-        .group_by(DnsQuery.domain)
-        .order_by(func.count().desc())
-        .limit(count)
-        .all()
-    )
+    return _top(db, DnsQueryDomainHourly, DnsQueryDomainHourly.domain, count, period, blocked=True)
 
 
 def get_stored_top_clients(db: Session, *, count: int, period: str) -> list:
     """Get top clients by query count."""
-    since = datetime.now(timezone.utc) - _period_to_delta(period)
-    return (
-        db.query(DnsQuery.client, func.count().label("cnt"))
-        .filter(DnsQuery.timestamp >= since)
-        .group_by(DnsQuery.client)
-        .order_by(func.count().desc())
-        .limit(count)
-        .all()
-    )
+    return _top(db, DnsQueryClientHourly, DnsQueryClientHourly.client, count, period)
 
 
 def get_stored_history(db: Session, *, period: str) -> list:
@@ -2,29 +2,44 @@
 
 Runs as a background asyncio task on the primary worker.  Uses a timestamp
 watermark to avoid duplicate inserts across restarts.
+
+Each poll drains the query log: pages (newest first, pinned by the API
+cursor) are fetched until one reaches the watermark, so a busy network no
+longer loses everything past the first page. The new rows are bulk-loaded
+and folded into the hourly rollups in the same transaction as the watermark
+update (``query_ingest``).
 """
 
 from __future__ import annotations
 
 import asyncio
 import logging
+import time
 from datetime import datetime, timedelta, timezone
 from typing import Any, Callable
 
-from sqlalchemy import delete, distinct, func
+from sqlalchemy import delete
 from sqlalchemy.orm import Session
 
-from app.core.database import DATABASE_URL, commit_with_retry
+from app.core.database import commit_with_retry
 from app.models.dns_queries import (
     DnsQuery,
     DnsQueryCollectorState,
     DnsQueryHourlyStat,
 )
+from app.services.pihole.query_ingest import (
+    apply_batch_rollups,
+    bulk_insert_queries,
+    delete_rollups_before,
+    normalize_query,
+)
 
 logger = logging.getLogger(__name__)
 
-# Batch size when fetching from Pi-hole API
-_FETCH_BATCH = 200
+# Page size when fetching from Pi-hole API
+_FETCH_BATCH = 1000
+# Upper bound per poll; anything older is reported as a gap, not fetched
+_MAX_PAGES_PER_POLL = 50
 
 
 class DnsQueryCollector:
@@ -34,8 +49,6 @@ class DnsQueryCollector:
         self._task: asyncio.Task[None] | None = None
         self._running = False
         self._db_factory: Callable[[], Session] | None = None
-        # Hourly stats recomputation tracking
-        self._last_hourly_recompute: datetime | None = None
         # Retention cleanup tracking
         self._last_retention_run: datetime | None = None
 
@@ -83,19 +96,11 @@ class DnsQueryCollector:
 
                 interval = state.get("poll_interval_seconds", 30)
 
-                # Fetch & store new queries
+                # Fetch & store new queries (hourly stats are updated per batch)
                 await self._fetch_and_store()
 
-                # Hourly stats recomputation (every hour)
-                now = datetime.now(timezone.utc)
-                if (
-                    self._last_hourly_recompute is None
-                    or (now - self._last_hourly_recompute).total_seconds() >= 3600
-                ):
-                    self._compute_hourly_stats(hours=2)
-                    self._last_hourly_recompute = now
-
                 # Retention cleanup (every 6 hours)
+                now = datetime.now(timezone.utc)
                 if (
                     self._last_retention_run is None
                     or (now - self._last_retention_run).total_seconds() >= 21600
@@ -114,8 +119,45 @@ class DnsQueryCollector:
 
     # ── Fetch & Store ────────────────────────────────────────────────
 
+    async def _fetch_new(
+        self, backend: Any, watermark: float, since: float
+    ) -> tuple[list[dict[str, Any]], bool]:
+        """Page through the query log until the watermark is reached.
+
+        Returns:
+            (queries newer than the watermark, whether the log was drained)
+        """
+        collected: list[dict[str, Any]] = []
+        seen: set[Any] = set()
+        cursor = None
+        for page in range(_MAX_PAGES_PER_POLL):
+            data = await backend.get_queries(
+                limit=_FETCH_BATCH, offset=page * _FETCH_BATCH, since=since, cursor=cursor,
+            )
+            batch: list[dict[str, Any]] = data.get("queries", [])
+            if cursor is None:
+                cursor = data.get("cursor")
+
+            reached = False
+            for q in batch:
+                ts = q.get("timestamp", 0)
+                if ts <= watermark:
+                    reached = True
+                    continue
+                # Without a cursor, queries arriving mid-pagination shift the
+                # offsets and repeat the tail of the previous page
+                key = q.get("id") or (ts, q.get("domain"), q.get("client"), q.get("query_type"))
+                if key in seen:
+                    continue
+                seen.add(key)
+                collected.append(q)
+
+            if reached or len(batch) < _FETCH_BATCH:
+                return collected, True
+        return collected, False
+
     async def _fetch_and_store(self) -> None:
-        """Fetch new queries from Pi-hole and bulk-insert into PostgreSQL."""
+        """Fetch all new queries from Pi-hole and bulk-load them with their rollups."""
         from app.services.pihole.service import get_pihole_service
 
         assert self._db_factory is not None
@@ -124,51 +166,39 @@ class DnsQueryCollector:
             state_row = db.query(DnsQueryCollectorState).filter_by(id=1).first()
             if state_row is None:
                 return
-            watermark = state_row.last_fetched_timestamp
+            watermark = state_row.last_fetched_timestamp or 0.0
+            retention_days = state_row.retention_days or 30
+            # Never fetch history that retention would delete right away
+            since = max(watermark, time.time() - retention_days * 86400)
 
             service = get_pihole_service(db)
             backend = service._get_backend()
 
-            new_count = 0
-            highest_ts = watermark
-
-            # Fetch a single batch — Pi-hole returns the most recent queries.
-            # The watermark filter below skips already-seen entries.
-            data = await backend.get_queries(limit=_FETCH_BATCH, offset=0)
-            queries_raw: list[dict[str, Any]] = data.get("queries", [])
-
-            to_insert: list[dict[str, Any]] = []
-            for q in queries_raw:
-                ts = q.get("timestamp", 0)
-                if ts <= watermark:
-                    continue
-                if ts > highest_ts:
-                    highest_ts = ts
-                to_insert.append({
-                    "timestamp": datetime.fromtimestamp(ts, tz=timezone.utc),
-                    "domain": (q.get("domain") or "")[:253],
-                    "client": (q.get("client") or "")[:45],
-                    "query_type": (q.get("query_type") or "")[:10],
-                    "status": (q.get("status") or "")[:20],
-                    "reply_type": (q.get("reply_type") or "")[:20] if q.get("reply_type") else None,
-                    "response_time_ms": q.get("response_time"),
-                })
+            queries_raw, drained = await self._fetch_new(backend, watermark, since)
+            if not drained:
+                logger.warning(
+                    "DnsQueryCollector: more than %d new queries since the last poll; "
+                    "older ones were skipped (consider a shorter poll interval)",
+                    _FETCH_BATCH * _MAX_PAGES_PER_POLL,
+                )
 
+            to_insert = [normalize_query(q) for q in queries_raw]
             if to_insert:
-                db.add_all([DnsQuery(**row) for row in to_insert])
-                new_count = len(to_insert)
+                bulk_insert_queries(db, to_insert)
+                apply_batch_rollups(db, to_insert)
 
             # Update watermark
+            highest_ts = max((q.get("timestamp", 0) for q in queries_raw), default=watermark)
             if highest_ts > watermark:
                 state_row.last_fetched_timestamp = highest_ts
             state_row.last_poll_at = datetime.now(timezone.utc)
-            state_row.total_queries_stored = (state_row.total_queries_stored or 0) + new_count
+            state_row.total_queries_stored = (state_row.total_queries_stored or 0) + len(to_insert)
             state_row.last_error = None
             state_row.last_error_at = None
             commit_with_retry(db)
 
-            if new_count > 0:
-                logger.debug("DnsQueryCollector stored %d new queries", new_count)
+            if to_insert:
+                logger.debug("DnsQueryCollector stored %d new queries", len(to_insert))
 
         except Exception:
             db.rollback()
@@ -178,84 +208,10 @@ class DnsQueryCollector:
         finally:
             db.close()
 
-    # ── Hourly Stats ─────────────────────────────────────────────────
-
-    def _compute_hourly_stats(self, hours: int = 2) -> None:
-        """Recompute hourly aggregations for the last N hours."""
-        assert self._db_factory is not None
-        db = self._db_factory()
-        try:
-            now = datetime.now(timezone.utc)
-            since = now - timedelta(hours=hours)
-            # Truncate to hour boundary
-            since = since.replace(minute=0, second=0, microsecond=0)
-
-            # Get distinct hours with data (cross-database compatible)
-            if DATABASE_URL.startswith("sqlite"):
-                # SQLite: use strftime to truncate to hour
-                hour_expr = func.strftime("%Y-%m-%d %H:00:00", DnsQuery.timestamp)
-            else:
-                # PostgreSQL
-                hour_expr = func.date_trunc("hour", DnsQuery.timestamp)
-            rows = (
-                db.query(
-                    hour_expr.label("hour"),
-                    func.count().label("total"),
-                    func.count().filter(DnsQuery.status == "BLOCKED").label("blocked"),
-                    func.count().filter(DnsQuery.status == "CACHED").label("cached"),
-                    func.count().filter(DnsQuery.status == "FORWARDED").label("forwarded"),
-                    func.count(distinct(DnsQuery.domain)).label("domains"),
-                    func.count(distinct(DnsQuery.client)).label("clients"),
-                    func.avg(DnsQuery.response_time_ms).label("avg_rt"),
-                )
-                .filter(DnsQuery.timestamp >= since)
-                .group_by(hour_expr)
-                .all()
-            )
-
-            _is_sqlite = DATABASE_URL.startswith("sqlite")
-            for row in rows:
-                # SQLite strftime returns a string — parse to datetime
-                hour_val = (
-                    datetime.strptime(row.hour, "%Y-%m-%d %H:%M:%S")
-                    .replace(tzinfo=timezone.utc)
-                    if _is_sqlite and isinstance(row.hour, str)
-                    else row.hour
-                )
-                # Upsert
-                existing = db.query(DnsQueryHourlyStat).filter_by(hour=hour_val).first()
-                if existing:
-                    existing.total_queries = row.total
-                    existing.blocked_queries = row.blocked
-                    existing.cached_queries = row.cached
-                    existing.forwarded_queries = row.forwarded
-                    existing.unique_domains = row.domains
-                    existing.unique_clients = row.clients
-                    existing.avg_response_time_ms = round(row.avg_rt, 2) if row.avg_rt else None
-                else:
-                    db.add(DnsQueryHourlyStat(
-                        hour=hour_val,
-                        total_queries=row.total,
-                        blocked_queries=row.blocked,
-                        cached_queries=row.cached,
-                        forwarded_queries=row.forwarded,
-                        unique_domains=row.domains,
-                        unique_clients=row.clients,
-                        avg_response_time_ms=round(row.avg_rt, 2) if row.avg_rt else None,
-                    ))
-
-            commit_with_retry(db)
-            logger.debug("Hourly stats recomputed for %d hours", len(rows))
-        except Exception:
-            db.rollback()
-            logger.exception("Hourly stats computation failed")
-        finally:
-            db.close()
-
     # ── Retention ────────────────────────────────────────────────────
 
     def _run_retention(self) -> None:
-        """Delete queries and hourly stats older than retention_days."""
+        """Delete queries, hourly stats and rollups older than retention_days."""
         assert self._db_factory is not None
         db = self._db_factory()
         try:
@@ -271,6 +227,7 @@ class DnsQueryCollector:
                 delete(DnsQueryHourlyStat).where(DnsQueryHourlyStat.hour < cutoff)
             )
             deleted_stats: int = s_result.rowcount or 0
+            deleted_stats += delete_rollups_before(db, cutoff)
 
             commit_with_retry(db)
             if deleted_queries or deleted_stats:
@@ -0,0 +1,232 @@
+"""Bulk load of collected Pi-hole queries and incremental rollups.
+
+``DnsQueryCollector`` hands every poll's new queries to this module in one
+transaction:
+
+- ``bulk_insert_queries`` loads the raw rows — PostgreSQL ``COPY ... FROM
+  STDIN`` on the session's own connection (so the watermark update commits
+  atomically with the rows), a Core ``executemany`` insert elsewhere.
+- ``apply_batch_rollups`` folds the same batch into the per-hour domain and
+  client counters (``dns_query_domain_hourly`` / ``dns_query_client_hourly``)
+  and the hourly summary (``dns_query_hourly_stats``). Counts add up, the
+  average response time is merged weighted by ``timed_queries``, and the
+  unique domain/client counts are the number of counter rows for the hour —
+  so nothing rescans ``dns_queries``.
+"""
+
+from __future__ import annotations
+
+import io
+import logging
+from datetime import datetime, timezone
+from typing import Any, Iterable
+
+from sqlalchemy import delete, func, insert
+from sqlalchemy.orm import Session
+
+from app.models.dns_queries import (
+    DnsQuery,
+    DnsQueryClientHourly,
+    DnsQueryDomainHourly,
+    DnsQueryHourlyStat,
+)
+
+logger = logging.getLogger(__name__)
+
+# Column order of the COPY stream
+_COLUMNS = (
+    "timestamp", "domain", "client", "query_type", "status", "reply_type", "response_time_ms",
+)
+
+# Rows per multi-row upsert statement
+_UPSERT_BATCH = 500
+
+
+def normalize_query(q: dict[str, Any]) -> dict[str, Any]:
+    """Map one backend query dict onto ``DnsQuery`` columns (naive UTC timestamp)."""
+    rt = q.get("response_time")
+    return {
+        "timestamp": datetime.fromtimestamp(q.get("timestamp", 0), tz=timezone.utc).replace(tzinfo=None),
+        "domain": (q.get("domain") or "")[:253],
+        "client": (q.get("client") or "")[:45],
+        "query_type": (q.get("query_type") or "")[:10],
+        "status": (q.get("status") or "")[:20],
+        "reply_type": (q.get("reply_type") or "")[:20] if q.get("reply_type") else None,
+        "response_time_ms": float(rt) if isinstance(rt, (int, float)) else None,
+    }
+
+
+def hour_of(ts: datetime) -> datetime:
+    """Truncate to the hour, as stored in the rollup tables (naive UTC)."""
+    if ts.tzinfo is not None:
+        ts = ts.astimezone(timezone.utc).replace(tzinfo=None)
+    return ts.replace(minute=0, second=0, microsecond=0)
+
+
+def _dialect(db: Session) -> str:
+    return db.get_bind().dialect.name
+
+
+# ── Raw rows ─────────────────────────────────────────────────────────
+
+
+def _csv_field(value: Any) -> str:
+    if value is None:
+        return ""  # unquoted empty = NULL in COPY csv
+    if isinstance(value, datetime):
+        return value.isoformat(sep=" ")
+    if isinstance(value, (int, float)):
+        return repr(value)
+    return '"' + str(value).replace("\x00", "").replace('"', '""') + '"'
+
+
+def copy_payload(rows: Iterable[dict[str, Any]]) -> io.StringIO:
+    """Build the ``COPY ... (FORMAT csv)`` stream for ``rows``."""
+    buf = io.StringIO()
+    for row in rows:
+        buf.write(",".join(_csv_field(row[c]) for c in _COLUMNS))
+        buf.write("\n")
+    buf.seek(0)
+    return buf
+
+
+def bulk_insert_queries(db: Session, rows: list[dict[str, Any]]) -> None:
+    """Insert normalised query rows inside the session's transaction."""
+    if not rows:
+        return
+    if _dialect(db) == "postgresql":
+        columns = ", ".join(f'"{c}"' for c in _COLUMNS)
+        # The session's DBAPI connection: COPY joins the open transaction
+        raw = db.connection().connection
+        with raw.cursor() as cur:
+            cur.copy_expert(
+                f"COPY {DnsQuery.__tablename__} ({columns}) FROM STDIN WITH (FORMAT csv)",
+                copy_payload(rows),
+            )
+    else:
+        db.execute(insert(DnsQuery), rows)
+
+
+# ── Rollups ──────────────────────────────────────────────────────────
+
+
+def _upsert_counts(db: Session, model: Any, key: str, rows: list[dict[str, Any]]) -> None:
+    """Add per-hour counters, creating rows as needed."""
+    dialect = _dialect(db)
+    if dialect == "postgresql":
+        from sqlalchemy.dialects.postgresql import insert as dialect_insert
+    elif dialect == "sqlite":
+        from sqlalchemy.dialects.sqlite import insert as dialect_insert
+    else:
+        for row in rows:
+            existing = db.get(model, (row["hour"], row[key]))
+            if existing is None:
+                db.add(model(**row))
+            else:
+                existing.total_queries += row["total_queries"]
+                existing.blocked_queries += row["blocked_queries"]
+        db.flush()
+        return
+
+    for i in range(0, len(rows), _UPSERT_BATCH):
+        stmt = dialect_insert(model).values(rows[i:i + _UPSERT_BATCH])
+        stmt = stmt.on_conflict_do_update(
+            index_elements=["hour", key],
+            set_={
+                "total_queries": model.total_queries + stmt.excluded.total_queries,
+                "blocked_queries": model.blocked_queries + stmt.excluded.blocked_queries,
+            },
+        )
+        db.execute(stmt)
+
+
+def apply_batch_rollups(db: Session, rows: list[dict[str, Any]]) -> set[datetime]:
+    """Fold a batch of inserted rows into the hourly rollups.
+
+    Returns:
+        The hours that were touched
+    """
+    domains: dict[tuple[datetime, str], list[int]] = {}
+    clients: dict[tuple[datetime, str], list[int]] = {}
+    hours: dict[datetime, dict[str, Any]] = {}
+
+    for row in rows:
+        hour = hour_of(row["timestamp"])
+        status = row["status"]
+        blocked = 1 if status == "BLOCKED" else 0
+        for counters, value in ((domains, row["domain"]), (clients, row["client"])):
+            c = counters.setdefault((hour, value), [0, 0])
+            c[0] += 1
+            c[1] += blocked
+        h = hours.setdefault(hour, {
+            "total": 0, "blocked": 0, "cached": 0, "forwarded": 0, "timed": 0, "rt_sum": 0.0,
+        })
+        h["total"] += 1
+        h["blocked"] += blocked
+        h["cached"] += status == "CACHED"
+        h["forwarded"] += status == "FORWARDED"
+        if row["response_time_ms"] is not None:
+            h["timed"] += 1
+            h["rt_sum"] += row["response_time_ms"]
+
+    _upsert_counts(db, DnsQueryDomainHourly, "domain", [
+        {"hour": hour, "domain": domain, "total_queries": t, "blocked_queries": b}
+        for (hour, domain), (t, b) in domains.items()
+    ])
+    _upsert_counts(db, DnsQueryClientHourly, "client", [
+        {"hour": hour, "client": client, "total_queries": t, "blocked_queries": b}
+        for (hour, client), (t, b) in clients.items()
+    ])
+
+    for hour, h in hours.items():
+        _merge_hourly_stat(db, hour, h)
+    return set(hours)
+
+
+def _merge_hourly_stat(db: Session, hour: datetime, batch: dict[str, Any]) -> None:
+    unique_domains = (
+        db.query(func.count()).select_from(DnsQueryDomainHourly)
+        .filter(DnsQueryDomainHourly.hour == hour).scalar()
+    ) or 0
+    unique_clients = (
+        db.query(func.count()).select_from(DnsQueryClientHourly)
+        .filter(DnsQueryClientHourly.hour == hour).scalar()
+    ) or 0
+
+    stat = db.query(DnsQueryHourlyStat).filter_by(hour=hour).first()
+    if stat is None:
+        stat = DnsQueryHourlyStat(
+            hour=hour, total_queries=0, blocked_queries=0, cached_queries=0,
+            forwarded_queries=0, timed_queries=0,
+        )
+        db.add(stat)
+        db.flush()  # sessions run with autoflush off; the next batch must find it
+
+    # Rows recomputed before timed_queries existed: weigh the old average
+    # by the hour's total
+    old_weight = stat.timed_queries or (
+        stat.total_queries if stat.avg_response_time_ms is not None else 0
+    )
+    weight = old_weight + batch["timed"]
+    if weight:
+        old_sum = (stat.avg_response_time_ms or 0.0) * old_weight
+        stat.avg_response_time_ms = round((old_sum + batch["rt_sum"]) / weight, 2)
+
+    stat.total_queries = (stat.total_queries or 0) + batch["total"]
+    stat.blocked_queries = (stat.blocked_queries or 0) + batch["blocked"]
+    stat.cached_queries = (stat.cached_queries or 0) + batch["cached"]
+    stat.forwarded_queries = (stat.forwarded_queries or 0) + batch["forwarded"]
+    stat.timed_queries = weight
+    stat.unique_domains = unique_domains
+    stat.unique_clients = unique_clients
+
+
+def delete_rollups_before(db: Session, cutoff: datetime) -> int:
+    """Retention for the per-hour counters. Returns the number of rows removed."""
+    cutoff_hour = hour_of(cutoff)
+    removed = 0
+    for model in (DnsQueryDomainHourly, DnsQueryClientHourly):
+        result: Any = db.execute(delete(model).where(model.hour < cutoff_hour))
+        removed += result.rowcount or 0
+    return removed
+
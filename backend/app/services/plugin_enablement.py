@@ -137,7 +137,15 @@ async def reconcile_worker() -> None:
     state - the winner's reconcile is a moment away.
 
     Never raises: a reconcile is best-effort maintenance on a request path.
+
+    Plugins load in the background after the worker starts serving; until
+    that startup step is done, wait for it instead of enabling the same
+    plugins a second time from here.
     """
+    from app.core import startup
+
+    await startup.wait_for("plugins")
+
     if _reconcile_lock.locked():
         return
 
@@ -10,6 +10,7 @@ import logging
 from datetime import datetime, timezone
 from typing import Optional
 
+from sqlalchemy import text
 from sqlalchemy.orm import Session
 
 from app.core.database import SessionLocal
@@ -25,6 +26,9 @@ logger = logging.getLogger(__name__)
 # Max age (seconds) for a worker heartbeat to be considered healthy
 WORKER_HEARTBEAT_MAX_AGE = 60
 
+# PostgreSQL NOTIFY channel the worker listens on for "requested" rows
+REQUEST_CHANNEL = "scheduler_requests"
+
 
 def _format_interval(seconds: int) -> str:
     """Convert seconds to human-readable interval."""
@@ -74,6 +78,21 @@ def recover_stale_executions(db: Session) -> int:
     return len(stale)
 
 
+def notify_execution_requested(db: Session, execution_id: int) -> None:
+    """Wake the scheduler worker for a new "requested" row.
+
+    NOTIFY is transactional, so call this before the commit that makes the
+    row visible. No-op on SQLite, where the worker polls.
+    """
+    bind = db.get_bind()
+    if bind.dialect.name != "postgresql":
+        return
+    db.execute(
+        text("SELECT pg_notify(:channel, :payload)"),
+        {"channel": REQUEST_CHANNEL, "payload": str(execution_id)},
+    )
+
+
 def log_scheduler_execution(
     scheduler_name: str,
     trigger_type: str = TriggerType.SCHEDULED.value,
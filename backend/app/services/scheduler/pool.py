@@ -0,0 +1,182 @@
+"""
+Concurrent job execution for the scheduler worker.
+
+Every job declares the resources it loads (JOB_RESOURCES). The pool runs
+jobs on their own threads as long as
+- the job is not already running (one instance per scheduler name),
+- a worker slot is free (one slot is kept for interactive jobs), and
+- every resource the job needs is below its concurrency limit.
+
+Queued jobs are started in priority order, then FIFO. Interactive "run now"
+requests outrank scheduled runs: they go first, may use the reserved slot,
+and a blocked job reserves its resources for the rest of the pass, so a
+queue of scheduled scrubs and backups cannot starve a waiting request.
+Running jobs are never interrupted; none of them can be stopped halfway
+without leaving the array or a backup in a worse state than finishing.
+"""
+import enum
+import heapq
+import itertools
+import logging
+import threading
+from collections import Counter
+from dataclasses import dataclass, field
+from typing import Callable, Optional
+
+logger = logging.getLogger(__name__)
+
+
+class Resource(str, enum.Enum):
+    """What a job keeps busy while it runs."""
+    ARRAY_IO = "array_io"  # sustained reads/writes on the storage arrays
+    CPU = "cpu"  # compression, hashing
+    NETWORK = "network"  # WAN transfers and remote APIs
+
+
+# Resources per scheduler; jobs not listed here only take a worker slot
+JOB_RESOURCES: dict[str, tuple[Resource, ...]] = {
+    "raid_scrub": (Resource.ARRAY_IO,),
+    "backup": (Resource.ARRAY_IO, Resource.CPU),
+    "sync_check": (Resource.NETWORK,),
+    "auto_update": (Resource.NETWORK,),
+    "cloud_sync": (Resource.NETWORK,),
+    "plugin_update_check": (Resource.NETWORK,),
+}
+
+PRIORITY_INTERACTIVE = 0
+PRIORITY_SCHEDULED = 10
+
+
+@dataclass(order=True)
+class _Job:
+    priority: int
+    seq: int
+    name: str = field(compare=False)
+    run: Callable[[], None] = field(compare=False)
+    resources: tuple[Resource, ...] = field(compare=False)
+    interactive: bool = field(compare=False)
+
+
+class JobPool:
+    """Bounded, resource-aware executor for scheduler jobs."""
+
+    def __init__(self, max_workers: int, limits: dict[Resource, int]):
+        # At least one slot for scheduled jobs plus the interactive one
+        self.max_workers = max(2, max_workers)
+        self.limits = dict(limits)
+        self._lock = threading.Lock()
+        self._queue: list[_Job] = []
+        self._seq = itertools.count()
+        self._running: dict[str, _Job] = {}
+        self._in_use: Counter[Resource] = Counter()
+        self._threads: set[threading.Thread] = set()
+        self._closed = False
+
+    def submit(
+        self,
+        name: str,
+        run: Callable[[], None],
+        *,
+        interactive: bool = False,
+        resources: Optional[tuple[Resource, ...]] = None,
+    ) -> bool:
+        """Queue a job; starts it right away when its resources are free.
+
+        Scheduled runs of a job that is already queued or running are
+        dropped (returns False), like APScheduler's coalescing. Interactive
+        runs are always queued and wait for the running instance.
+        """
+        with self._lock:
+            if self._closed:
+                return False
+            if not interactive and (name in self._running or self._is_queued(name)):
+                logger.debug("Skipping scheduled run of %s: already queued or running", name)
+                return False
+            job = _Job(
+                priority=PRIORITY_INTERACTIVE if interactive else PRIORITY_SCHEDULED,
+                seq=next(self._seq),
+                name=name,
+                run=run,
+                resources=JOB_RESOURCES.get(name, ()) if resources is None else resources,
+                interactive=interactive,
+            )
+            heapq.heappush(self._queue, job)
+            self._dispatch()
+        return True
+
+    def running(self) -> set[str]:
+        """Names of the jobs currently executing."""
+        with self._lock:
+            return set(self._running)
+
+    def queued(self) -> list[str]:
+        """Names of the waiting jobs, in the order they would start."""
+        with self._lock:
+            return [job.name for job in sorted(self._queue)]
+
+    def shutdown(self, wait: bool = False, timeout: Optional[float] = None) -> list[str]:
+        """Stop accepting jobs and drop the queue; returns the dropped names."""
+        with self._lock:
+            self._closed = True
+            dropped = [job.name for job in sorted(self._queue)]
+            self._queue.clear()
+            threads = list(self._threads)
+        if wait:
+            for thread in threads:
+                thread.join(timeout)
+        return dropped
+
+    # --- internals (called with the lock held) -----------------------------
+
+    def _is_queued(self, name: str) -> bool:
+        return any(job.name == name for job in self._queue)
+
+    def _can_start(self, job: _Job) -> bool:
+        if job.name in self._running:
+            return False
+        # The last slot only ever goes to an interactive job
+        slots = self.max_workers if job.interactive else self.max_workers - 1
+        if len(self._running) >= slots:
+            return False
+        return all(self._in_use[r] < self.limits.get(r, 1) for r in job.resources)
+
+    def _dispatch(self) -> None:
+        """Start every queued job that fits, highest priority first."""
+        if self._closed:
+            return
+        reserved: set[Resource] = set()
+        waiting: list[_Job] = []
+        while self._queue:
+            job = heapq.heappop(self._queue)
+            if reserved.intersection(job.resources) or not self._can_start(job):
+                reserved.update(job.resources)
+                waiting.append(job)
+                continue
+            self._start(job)
+        for job in waiting:
+            heapq.heappush(self._queue, job)
+
+    def _start(self, job: _Job) -> None:
+        self._running[job.name] = job
+        self._in_use.update(job.resources)
+        thread = threading.Thread(
+            target=self._run, args=(job,), name=f"scheduler-{job.name}", daemon=True,
+        )
+        self._threads.add(thread)
+        logger.debug(
+            "Starting %s (interactive=%s, resources=%s)",
+            job.name, job.interactive, [r.value for r in job.resources],
+        )
+        thread.start()
+
+    def _run(self, job: _Job) -> None:
+        try:
+            job.run()
+        except Exception:
+            logger.exception("Scheduler job %s raised", job.name)
+        finally:
+            with self._lock:
+                del self._running[job.name]
+                self._in_use.subtract(job.resources)
+                self._threads.discard(threading.current_thread())
+                self._dispatch()
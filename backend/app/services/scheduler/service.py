@@ -32,7 +32,7 @@ from app.schemas.scheduler import (
     SchedulerToggleResponse,
     SCHEDULER_REGISTRY,
 )
-from .execution import _format_interval, _is_worker_healthy
+from .execution import _format_interval, _is_worker_healthy, notify_execution_requested
 
 logger = logging.getLogger(__name__)
 
@@ -205,8 +205,8 @@ class SchedulerService:
         """
         Trigger a scheduler to run immediately.
 
-        Creates a "requested" execution row in the DB.
-        The worker process polls for these and executes them.
+        Creates a "requested" execution row in the DB and notifies the
+        worker (LISTEN/NOTIFY on PostgreSQL; the worker polls on SQLite).
         Returns immediately (fire-and-forget).
         """
         if name not in SCHEDULER_REGISTRY:
@@ -258,6 +258,8 @@ class SchedulerService:
             status=SchedulerStatus.REQUESTED.value,
         )
         self.db.add(execution)
+        self.db.flush()
+        notify_execution_requested(self.db, execution.id)
         self.db.commit()
         self.db.refresh(execution)
 
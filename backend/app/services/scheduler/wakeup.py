@@ -0,0 +1,101 @@
+"""
+Push wakeup for the scheduler worker.
+
+On PostgreSQL the worker keeps one autocommit connection that LISTENs on
+REQUEST_CHANNEL; SchedulerService.run_scheduler_now NOTIFYs in the same
+transaction that inserts the "requested" row. wait() returns as soon as a
+notification arrives, so "run now" starts without a polling delay and the
+worker no longer queries the executions table every two seconds.
+
+On SQLite, or while the listen connection is down, wait() just times out
+and the worker falls back to polling.
+"""
+import logging
+import select
+import time
+
+from sqlalchemy.engine import Engine
+
+from .execution import REQUEST_CHANNEL
+
+logger = logging.getLogger(__name__)
+
+# Delay between attempts to re-open a broken listen connection (seconds)
+RECONNECT_INTERVAL = 30
+
+
+class RequestListener:
+    """Blocks until a run-now request is announced or the timeout passes."""
+
+    def __init__(self, engine: Engine):
+        self._engine = engine
+        self._conn = None  # raw DB-API connection (psycopg2)
+        self._last_attempt = 0.0
+        self.supported = engine.dialect.name == "postgresql"
+
+    @property
+    def listening(self) -> bool:
+        return self._conn is not None
+
+    def start(self) -> None:
+        if self.supported:
+            self._connect()
+
+    def close(self) -> None:
+        if self._conn is not None:
+            try:
+                self._conn.close()
+            except Exception:
+                pass
+            self._conn = None
+
+    def wait(self, timeout: float) -> bool:
+        """Wait up to ``timeout`` seconds; True when a request was announced."""
+        if self._conn is None:
+            if self.supported and time.monotonic() - self._last_attempt >= RECONNECT_INTERVAL:
+                self._connect()
+            if self._conn is None:
+                time.sleep(timeout)
+                return False
+
+        try:
+            if self._conn.notifies:
+                return self._drain()
+            readable, _, _ = select.select([self._conn], [], [], timeout)
+            if not readable:
+                return False
+            self._conn.poll()
+            return self._drain()
+        except Exception as e:
+            logger.warning("Scheduler listen connection lost, polling until reconnect: %s", e)
+            self.close()
+            return False
+
+    def _drain(self) -> bool:
+        found = bool(self._conn.notifies)
+        self._conn.notifies.clear()
+        return found
+
+    def _connect(self) -> None:
+        self._last_attempt = time.monotonic()
+        conn = None
+        try:
+            # Detached from the pool: the connection lives as long as the worker
+            fairy = self._engine.raw_connection()
+            fairy.detach()
+            conn = fairy.dbapi_connection
+            conn.rollback()  # pool_pre_ping may have opened a transaction
+            conn.autocommit = True
+            cursor = conn.cursor()
+            cursor.execute(f"LISTEN {REQUEST_CHANNEL}")
+            cursor.close()
+        except Exception as e:
+            logger.warning("LISTEN %s failed, polling instead: %s", REQUEST_CHANNEL, e)
+            if conn is not None:
+                try:
+                    conn.close()
+                except Exception:
+                    pass
+            return
+        self._conn = conn
+        logger.info("Scheduler worker listening on %s", REQUEST_CHANNEL)
@@ -6,12 +6,18 @@ heavy I/O (backup, RAID scrub, SMART scan) from blocking the web API.
 
 IPC with the web process is done via the PostgreSQL/SQLite database:
 - Web API writes "requested" execution rows -> Worker picks them up
+  (woken by NOTIFY on PostgreSQL, polling on SQLite)
 - Worker writes scheduler_state rows -> Web API reads them for status
+
+Jobs run concurrently in a resource-aware pool (pool.py): APScheduler and
+the request poller only queue them.
 """
 import asyncio
+import functools
 import json
 import logging
 import os
+import threading
 import time
 from datetime import datetime, timezone, timedelta
 from typing import Optional
@@ -19,7 +25,7 @@ from typing import Optional
 from apscheduler.schedulers.background import BackgroundScheduler
 
 from app.core.config import settings
-from app.core.database import SessionLocal, commit_with_retry
+from app.core.database import SessionLocal, commit_with_retry, engine
 from app.models.scheduler_history import (
     SchedulerExecution,
     SchedulerConfig,
@@ -29,6 +35,8 @@ from app.models.scheduler_state import SchedulerState
 from app.schemas.scheduler import SCHEDULER_REGISTRY
 
 from .execution import log_scheduler_execution, complete_scheduler_execution
+from .pool import JobPool, Resource
+from .wakeup import RequestListener
 
 logger = logging.getLogger(__name__)
 
@@ -55,6 +63,9 @@ SCHEDULER_POWER_LEVELS: dict[str, str] = {
 # How often to poll for requested executions (seconds)
 POLL_INTERVAL = 2
 
+# Safety-net poll while LISTEN is active, in case a notification was missed
+LISTEN_POLL_INTERVAL = 60
+
 # How often to update heartbeat in scheduler_state (seconds)
 HEARTBEAT_INTERVAL = 10
 
@@ -74,7 +85,20 @@ class SchedulerWorker:
         self.pid = os.getpid()
         self._last_heartbeat = 0.0
         self._last_config_check = 0.0
-        self._executing_scheduler: Optional[str] = None
+        self._last_poll = 0.0
+        self._poll_due = True
+        self.pool = JobPool(
+            settings.scheduler_max_concurrent_jobs,
+            {
+                Resource.ARRAY_IO: settings.scheduler_array_io_slots,
+                Resource.CPU: settings.scheduler_cpu_slots,
+                Resource.NETWORK: settings.scheduler_network_slots,
+            },
+        )
+        self._listener = RequestListener(engine)
+        # Ids of "requested" rows queued in the pool but not started yet
+        self._claimed: set[int] = set()
+        self._claimed_lock = threading.Lock()
         # Track which schedulers are enabled (to detect config changes)
         self._enabled_cache: dict[str, bool] = {}
         self._interval_cache: dict[str, int] = {}
@@ -86,6 +110,8 @@ class SchedulerWorker:
         # Recover stale executions from a previous crash
         self._recover_stale_executions()
 
+        self._listener.start()
+
         # Initialize APScheduler
         self.scheduler = BackgroundScheduler(
             job_defaults={
@@ -107,15 +133,19 @@ class SchedulerWorker:
         logger.info("Scheduler worker started with %d jobs", len(self.scheduler.get_jobs()))
 
     def run_loop(self) -> None:
-        """Main loop: poll for requested executions and update heartbeats."""
+        """Main loop: pick up requested executions and update heartbeats."""
         while self.running:
             now = time.monotonic()
 
-            # Poll for "requested" execution rows
-            try:
-                self._poll_requested_executions()
-            except Exception:
-                logger.exception("Error polling requested executions")
+            # Pick up "requested" execution rows when notified, or poll
+            interval = LISTEN_POLL_INTERVAL if self._listener.listening else POLL_INTERVAL
+            if self._poll_due or now - self._last_poll >= interval:
+                self._poll_due = False
+                self._last_poll = now
+                try:
+                    self._poll_requested_executions()
+                except Exception:
+                    logger.exception("Error polling requested executions")
 
             # Update heartbeats periodically
             if now - self._last_heartbeat >= HEARTBEAT_INTERVAL:
@@ -133,7 +163,8 @@ class SchedulerWorker:
                     logger.exception("Error checking config changes")
                 self._last_config_check = now
 
-            time.sleep(POLL_INTERVAL)
+            if self._listener.wait(POLL_INTERVAL):
+                self._poll_due = True
 
     def shutdown(self) -> None:
         """Graceful shutdown: cancel running jobs, clear state."""
@@ -143,9 +174,16 @@ class SchedulerWorker:
         if self.scheduler and self.scheduler.running:
             self.scheduler.shutdown(wait=False)
 
-        # Mark any currently executing job as cancelled
-        if self._executing_scheduler:
-            self._cancel_running_executions(self._executing_scheduler)
+        # Queued run-now rows stay "requested" and are picked up on restart
+        dropped = self.pool.shutdown()
+        if dropped:
+            logger.info("Dropped %d queued job(s): %s", len(dropped), ", ".join(dropped))
+
+        # Mark any currently executing jobs as cancelled
+        for name in self.pool.running():
+            self._cancel_running_executions(name)
+
+        self._listener.close()
 
         # Clear all scheduler_state rows
         self._clear_all_state()
@@ -155,7 +193,7 @@ class SchedulerWorker:
     # --- Job Dispatching ---------------------------------------------------
 
     def _poll_requested_executions(self) -> None:
-        """Check for execution rows with status='requested' and run them."""
+        """Queue execution rows with status='requested' as interactive jobs."""
         db = SessionLocal()
         try:
             requested = (
@@ -174,17 +212,37 @@ class SchedulerWorker:
                     db.commit()
                     continue
 
-                # Mark as running
-                execution.status = SchedulerStatus.RUNNING.value
-                execution.started_at = datetime.now(timezone.utc)
-                db.commit()
+                with self._claimed_lock:
+                    if execution.id in self._claimed:
+                        continue
+                    self._claimed.add(execution.id)
 
-                # Execute the job
-                self._execute_job(execution.id, name)
+                run = functools.partial(self._run_requested, execution.id, name)
+                if not self.pool.submit(name, run, interactive=True):
+                    with self._claimed_lock:
+                        self._claimed.discard(execution.id)
 
         finally:
             db.close()
 
+    def _run_requested(self, execution_id: int, name: str) -> None:
+        """Pool entry point for a run-now request: mark it running, then execute."""
+        db = SessionLocal()
+        try:
+            execution = db.get(SchedulerExecution, execution_id)
+            if execution is None or execution.status != SchedulerStatus.REQUESTED.value:
+                return  # Cancelled or recovered while queued
+
+            execution.status = SchedulerStatus.RUNNING.value
+            execution.started_at = datetime.now(timezone.utc)
+            db.commit()
+        finally:
+            db.close()
+            with self._claimed_lock:
+                self._claimed.discard(execution_id)
+
+        self._execute_job(execution_id, name)
+
     def _register_power_demand(self, name: str) -> bool:
         """Register a power demand for the given scheduler via the backend API."""
         level = SCHEDULER_POWER_LEVELS.get(name)
@@ -247,7 +305,6 @@ class SchedulerWorker:
         """Run a scheduler job and update the execution record."""
         logger.info("Executing scheduler job: %s (execution_id=%d)", name, execution_id)
 
-        self._executing_scheduler = name
         self._set_executing_state(name, True)
         self._register_power_demand(name)
 
@@ -310,7 +367,6 @@ class SchedulerWorker:
 
         finally:
             self._unregister_power_demand(name)
-            self._executing_scheduler = None
             self._set_executing_state(name, False)
 
     def _dispatch_job(self, name: str) -> Optional[dict]:
@@ -408,45 +464,47 @@ class SchedulerWorker:
     # --- APScheduler Job Callbacks -----------------------------------------
 
     def _create_scheduled_callback(self, scheduler_name: str):
-        """Create a callback for APScheduler periodic jobs."""
+        """Create a callback for APScheduler periodic jobs (queues the run)."""
         def callback():
-            execution_id = log_scheduler_execution(
-                scheduler_name, job_id=f"{scheduler_name}_periodic"
-            )
-            self._executing_scheduler = scheduler_name
-            self._set_executing_state(scheduler_name, True)
-            self._register_power_demand(scheduler_name)
+            self.pool.submit(scheduler_name, functools.partial(self._run_scheduled, scheduler_name))
 
-            try:
-                result = self._dispatch_job(scheduler_name)
-                complete_scheduler_execution(
-                    execution_id, success=True, result=result
-                )
-                logger.info("Scheduled job completed: %s", scheduler_name)
+        return callback
 
-                # Emit notification for scheduler success. Per-user category
-                # preferences (scheduler.success) gate actual delivery.
-                try:
-                    from app.services.notifications.events import emit_scheduler_completed_sync
-                    emit_scheduler_completed_sync(scheduler_name)
-                except Exception:
-                    pass
-            except Exception as e:
-                logger.exception("Scheduled job failed: %s", scheduler_name)
-                complete_scheduler_execution(
-                    execution_id, success=False, error=str(e)
-                )
-                try:
-                    from app.services.notifications.events import emit_scheduler_failed_sync
-                    emit_scheduler_failed_sync(scheduler_name, str(e))
-                except Exception:
-                    pass
-            finally:
-                self._unregister_power_demand(scheduler_name)
-                self._executing_scheduler = None
-                self._set_executing_state(scheduler_name, False)
+    def _run_scheduled(self, scheduler_name: str) -> None:
+        """Pool entry point for a periodic run."""
+        execution_id = log_scheduler_execution(
+            scheduler_name, job_id=f"{scheduler_name}_periodic"
+        )
+        self._set_executing_state(scheduler_name, True)
+        self._register_power_demand(scheduler_name)
 
-        return callback
+        try:
+            result = self._dispatch_job(scheduler_name)
+            complete_scheduler_execution(
+                execution_id, success=True, result=result
+            )
+            logger.info("Scheduled job completed: %s", scheduler_name)
+
+            # Emit notification for scheduler success. Per-user category
+            # preferences (scheduler.success) gate actual delivery.
+            try:
+                from app.services.notifications.events import emit_scheduler_completed_sync
+                emit_scheduler_completed_sync(scheduler_name)
+            except Exception:
+                pass
+        except Exception as e:
+            logger.exception("Scheduled job failed: %s", scheduler_name)
+            complete_scheduler_execution(
+                execution_id, success=False, error=str(e)
+            )
+            try:
+                from app.services.notifications.events import emit_scheduler_failed_sync
+                emit_scheduler_failed_sync(scheduler_name, str(e))
+            except Exception:
+                pass
+        finally:
+            self._unregister_power_demand(scheduler_name)
+            self._set_executing_state(scheduler_name, False)
 
     # --- Job Loading & Config ----------------------------------------------
 
@@ -605,10 +663,11 @@ class SchedulerWorker:
         db = SessionLocal()
         try:
             now = datetime.now(timezone.utc)
+            executing = self.pool.running()
 
             for name in SCHEDULER_REGISTRY:
                 is_running = self._enabled_cache.get(name, False)
-                is_executing = self._executing_scheduler == name
+                is_executing = name in executing
 
                 # Get next_run_at from APScheduler
                 next_run_at = None
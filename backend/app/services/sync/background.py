@@ -14,6 +14,7 @@ from typing import Optional
 
 from sqlalchemy.orm import Session
 
+from app.core.config import settings
 from app.core.database import SessionLocal
 from app.models.sync_progress import SyncSchedule
 from app.services.sync.file_sync import FileSyncService
@@ -166,7 +167,11 @@ class SyncBackgroundScheduler:
             raise
 
     async def cleanup_expired_uploads(self) -> dict:
-        """Clean up expired chunked uploads. Returns a result dict."""
+        """Clean up expired chunked uploads and old sync journal entries.
+
+        Returns a result dict.
+        """
+        from app.services.sync.journal import prune_journal
         from app.services.sync.progressive import ProgressiveSyncService
 
         db = SessionLocal()
@@ -174,7 +179,13 @@ class SyncBackgroundScheduler:
             sync_service = ProgressiveSyncService(db)
             cleaned = sync_service.cleanup_expired_uploads()
             self.logger.info("Expired uploads cleaned up")
-            return {"cleaned": cleaned if isinstance(cleaned, int) else 0}
+            pruned = prune_journal(db, settings.sync_journal_retention_days)
+            if pruned:
+                self.logger.info("Pruned %d sync journal entries", pruned)
+            return {
+                "cleaned": cleaned if isinstance(cleaned, int) else 0,
+                "journal_pruned": pruned,
+            }
         finally:
             db.close()
 
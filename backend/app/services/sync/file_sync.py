@@ -1,15 +1,31 @@
 """File sync service for local network synchronization."""
 
 import hashlib
+import logging
+import mmap
+import os
+import shutil
 from datetime import datetime, timezone
 from pathlib import Path
-from typing import Optional
+from typing import Iterator, Optional
 
 from sqlalchemy.orm import Session
 
 from app.models.sync_state import SyncState, SyncMetadata, SyncFileVersion
 from app.models.file_metadata import FileMetadata
 from app.core.config import settings
+from app.core.tracing import traced
+from app.services.sync import delta
+from app.services.sync.journal import changes_since, current_cursor, parse_cursor
+
+logger = logging.getLogger(__name__)
+
+# Spool for uploaded deltas (``.tmp`` is a system dir, hidden from listings)
+DELTA_TMP_DIR = Path(settings.nas_storage_path).expanduser().resolve() / ".tmp" / "sync-delta"
+
+
+class FileBusyError(RuntimeError):
+    """Another request is applying a delta to the same file."""
 
 
 class FileSyncService:
@@ -83,6 +99,7 @@ class FileSyncService:
             "change_token": sync_state.last_change_token
         }
     
+    @traced("detect_changes")
     def detect_changes(self, user_id: int, device_id: str, file_list: list[dict]) -> dict:
         """
         Detect changes on client side.
@@ -111,14 +128,30 @@ class FileSyncService:
             "conflicts": [],        # Conflicting files
             "change_token": None
         }
-        
+
+        # Read the cursor first: anything journaled while this round runs is
+        # replayed by the next changes-since call instead of being lost.
+        cursor = current_cursor(self.db)
+
         client_files = {f["path"]: f for f in file_list}
+        # Plain column tuples: no ORM identity map for 100k+ rows
         server_files = {
-            fm.path: fm for fm in self.db.query(FileMetadata).filter(
-                FileMetadata.owner_id == user_id
-            ).all()
+            row.path: row for row in self.db.query(
+                FileMetadata.id,
+                FileMetadata.path,
+                FileMetadata.is_directory,
+                FileMetadata.size_bytes,
+                FileMetadata.updated_at,
+            ).filter(FileMetadata.owner_id == user_id)
         }
-        
+        sync_meta_by_file = {
+            row.file_metadata_id: row for row in self.db.query(
+                SyncMetadata.file_metadata_id,
+                SyncMetadata.content_hash,
+                SyncMetadata.server_modified_at,
+            ).filter(SyncMetadata.sync_state_id == sync_state.id)
+        }
+
         # Check for server changes
         for path, file_metadata in server_files.items():
             if path not in client_files:
@@ -128,36 +161,47 @@ class FileSyncService:
                     "size": file_metadata.size_bytes,
                     "modified_at": file_metadata.updated_at.isoformat() if file_metadata.updated_at else None
                 })
-        
+
         # Check for client changes and conflicts
         for path, client_file in client_files.items():
-            if path not in server_files:
+            server_file = server_files.get(path)
+            if server_file is None:
                 # File deleted on server
                 changes["to_delete"].append({"path": path})
-            else:
-                server_file = server_files[path]
-                sync_meta = self.db.query(SyncMetadata).filter(
-                    SyncMetadata.file_metadata_id == server_file.id,
-                    SyncMetadata.sync_state_id == sync_state.id
-                ).first()
-                
-                if sync_meta and sync_meta.content_hash != client_file.get("hash"):
-                    client_modified = client_file.get("modified_at")
-                    if client_modified and sync_meta.server_modified_at.isoformat() > client_modified:
-                        changes["conflicts"].append({
-                            "path": path,
-                            "client_hash": client_file.get("hash"),
-                            "server_hash": sync_meta.content_hash,
-                            "server_modified_at": sync_meta.server_modified_at.isoformat()
-                        })
-        
+                continue
+
+            sync_meta = sync_meta_by_file.get(server_file.id)
+            if sync_meta and sync_meta.content_hash != client_file.get("hash"):
+                client_modified = client_file.get("modified_at")
+                if client_modified and sync_meta.server_modified_at.isoformat() > client_modified:
+                    changes["conflicts"].append({
+                        "path": path,
+                        "client_hash": client_file.get("hash"),
+                        "server_hash": sync_meta.content_hash,
+                        "server_modified_at": sync_meta.server_modified_at.isoformat()
+                    })
+
         sync_state.last_sync = datetime.now(timezone.utc)
-        sync_state.last_change_token = self._generate_change_token()
+        sync_state.last_change_token = str(cursor)
         self.db.commit()
-        
+
         changes["change_token"] = sync_state.last_change_token
         return changes
-    
+
+    def get_changes_since(self, user_id: int, device_id: str, token: Optional[str], limit: int) -> dict:
+        """Journal entries since *token* (a cursor from a previous sync round)."""
+        sync_state = self.get_existing_device(device_id, user_id)
+        if not sync_state:
+            return {"error": "Device not registered"}
+
+        result = changes_since(self.db, user_id, parse_cursor(token), limit)
+        if not result["has_more"] and not result["reset_required"]:
+            sync_state.last_sync = datetime.now(timezone.utc)
+            sync_state.last_change_token = str(result["cursor"])
+            self.db.commit()
+        result["cursor"] = str(result["cursor"])
+        return result
+
     def resolve_conflict(self, user_id: int, file_path: str, resolution: str) -> bool:
         """
         Resolve a conflict.
@@ -210,10 +254,144 @@ class FileSyncService:
         self.db.add(version)
         self.db.commit()
     
-    def _generate_change_token(self) -> str:
-        """Generate a unique change token for delta sync."""
-        import uuid
-        return str(uuid.uuid4())
+    # ===== Block delta transfers =====
+
+    def _owned_file(self, user_id: int, file_path: str) -> tuple[FileMetadata, Path]:
+        """Metadata and absolute path of a regular file owned by *user_id*.
+
+        Raises FileNotFoundError when there is no such file.
+        """
+        from app.services.files import path_utils
+
+        relative = file_path.strip("/")
+        file_metadata = self.db.query(FileMetadata).filter(
+            FileMetadata.path == relative,
+            FileMetadata.owner_id == user_id
+        ).first()
+        if not file_metadata or file_metadata.is_directory:
+            raise FileNotFoundError(file_path)
+        abs_path = path_utils._resolve_path(relative)
+        if not abs_path.is_file():
+            raise FileNotFoundError(file_path)
+        return file_metadata, abs_path
+
+    def get_signature(self, user_id: int, file_path: str) -> dict:
+        """Block signature of the server copy, for a client-side delta upload."""
+        file_metadata, abs_path = self._owned_file(user_id, file_path)
+        with open(abs_path, "rb") as f:
+            signature = delta.compute_signature(f, os.fstat(f.fileno()).st_size)
+        signature["path"] = file_path
+        signature["checksum"] = file_metadata.checksum
+        return signature
+
+    def iter_download_delta(self, user_id: int, file_path: str, signature: dict) -> Iterator[bytes]:
+        """Delta from the client's copy (described by *signature*) to the server copy.
+
+        The file and signature are checked up front; the returned generator
+        maps the file and streams the delta.
+        """
+        _, abs_path = self._owned_file(user_id, file_path)
+        delta.validate_signature(signature)
+        f = open(abs_path, "rb")
+
+        def _generate() -> Iterator[bytes]:
+            with f:
+                if os.fstat(f.fileno()).st_size == 0:
+                    yield from delta.compute_delta(signature, b"")
+                    return
+                with mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ) as mapped:
+                    yield from delta.compute_delta(
+                        signature, mapped, max_rolled=settings.sync_delta_max_rolled_bytes
+                    )
+
+        return _generate()
+
+    def apply_upload_delta(
+        self, user_id: int, file_path: str, delta_path: Path, base_checksum: Optional[str] = None
+    ) -> dict:
+        """Rebuild the server copy from the client's delta and swap it in atomically.
+
+        Runs like an upload that overwrites the file: the result must fit the
+        available space, and a VCL version is created when one is due. One
+        delta per file at a time (``FileBusyError`` otherwise, across workers).
+
+        Raises ``delta.BaseMismatchError`` when the server copy is not the base the
+        delta was computed against (the client should fetch a new signature),
+        ``QuotaExceededError`` when the result does not fit, ``delta.DeltaError``
+        for a malformed delta.
+        """
+        from app.core.job_lock import job_lock
+        from app.services.files import metadata_db
+        from app.services.files.folder_size import folder_size_token, record_file_size_change
+        from app.services.files.path_utils import QuotaExceededError
+        from app.services.files.storage import _invalidate_ssd_cache, calculate_available_bytes
+
+        file_metadata, abs_path = self._owned_file(user_id, file_path)
+        with job_lock("file", file_metadata.id) as acquired:
+            if not acquired:
+                raise FileBusyError(file_path)
+            # The previous holder may have just replaced the file
+            self.db.refresh(file_metadata)
+            if base_checksum and file_metadata.checksum and base_checksum != file_metadata.checksum:
+                raise delta.BaseMismatchError("Server copy changed since the signature was taken")
+
+            # Same rule as save_uploads: the new content must fit what is free
+            available = calculate_available_bytes()
+            tmp_path = abs_path.with_name(f".{abs_path.name}.delta-tmp")
+            size_token = folder_size_token()  # the temp file lives in the same directory
+            try:
+                with open(abs_path, "rb") as base, open(delta_path, "rb") as patch, open(tmp_path, "wb") as out:
+                    base_stat = os.fstat(base.fileno())
+                    base_size = base_stat.st_size
+                    try:
+                        size, checksum = delta.apply_delta(base, patch, out, base_size, max_size=available)
+                    except delta.DeltaLimitError as exc:
+                        raise QuotaExceededError(
+                            f"Not enough space: delta result exceeds available {available} bytes"
+                        ) from exc
+                # Writers other than delta sync do not take the lock
+                current = os.stat(abs_path)
+                if (current.st_ino, current.st_size, current.st_mtime_ns) != (
+                    base_stat.st_ino, base_stat.st_size, base_stat.st_mtime_ns
+                ):
+                    raise delta.BaseMismatchError("Server copy changed while the delta was applied")
+                shutil.copymode(abs_path, tmp_path)
+                os.replace(tmp_path, abs_path)
+            finally:
+                tmp_path.unlink(missing_ok=True)
+
+            relative = file_metadata.path
+            metadata_db.update_metadata(relative, size_bytes=size, checksum=checksum, db=self.db)
+            _invalidate_ssd_cache(relative, db=self.db)
+            record_file_size_change(abs_path, size - base_size, size_token)
+            self._version_delta_result(file_metadata, abs_path, user_id, checksum)
+        return {"path": file_path, "size": size, "checksum": checksum}
+
+    def _version_delta_result(
+        self, file_metadata: FileMetadata, abs_path: Path, user_id: int, checksum: str
+    ) -> None:
+        """VCL version of a delta-updated file, as save_uploads does for an overwrite.
+
+        Runs under the file's lock so the version holds exactly the content
+        just swapped in. A VCL failure does not undo the update.
+        """
+        from app.services.versioning.vcl import VCLService
+
+        try:
+            vcl = VCLService(self.db)
+            should_create, _reason = vcl.should_create_version(file_metadata, checksum, user_id)
+            if should_create:
+                vcl.create_version_from_file(
+                    file=file_metadata,
+                    file_path=abs_path,
+                    user_id=user_id,
+                    checksum=checksum,
+                    change_type="update",
+                )
+                self.db.commit()
+        except Exception as e:
+            self.db.rollback()
+            logger.warning("VCL version for delta update of %s failed: %s", file_metadata.path, e)
 
     # ===== Helpers used by sync routes =====
 
@@ -0,0 +1,232 @@
+"""Server-side change journal for delta sync.
+
+Every ``FileMetadata`` create/update/delete/rename appends a ``SyncChange``
+row in the same transaction (see ``services/files/metadata_db``). The row id
+is the cursor handed to sync clients: "give me everything after cursor X" is
+a single index range scan on ``(owner_id, id)`` instead of diffing the
+device's full file list against every file the user owns.
+
+Ids are handed out when rows are inserted, not when they commit: on
+PostgreSQL a transaction holding id 10 can commit after the one holding 11.
+A reader that saw 11 and moved its cursor there would never see 10. So a
+page only reaches up to the last id below which the journal is *settled*
+(every id either visible or rolled back for good), and the cursor never
+moves past the last entry it returned. A gap that may still belong to a
+running transaction is remembered in the cursor together with the
+snapshot's ``xmax``; once every transaction of that snapshot has ended
+(``xmin >= xmax``) the gap is final. SQLite has one writer at a time, so
+there ids become visible in commit order and nothing is held back.
+
+Cursors are opaque strings on the wire. A device without a cursor, or with
+one the journal can no longer answer for (pruned history, a pre-journal UUID
+token, or one from a restored database), gets ``reset_required``; the device then does one full
+``detect_changes`` round and continues from the cursor that returns.
+"""
+
+from __future__ import annotations
+
+from datetime import datetime, timedelta, timezone
+from typing import NamedTuple, Optional
+
+from sqlalchemy import func, text
+from sqlalchemy.orm import Session
+
+from app.models.sync_state import SyncChange
+
+DEFAULT_PAGE_SIZE = 1000
+MAX_PAGE_SIZE = 10000
+
+
+def record_change(
+    db: Session,
+    *,
+    owner_id: int,
+    action: str,
+    path: str,
+    old_path: Optional[str] = None,
+    is_directory: bool = False,
+    size_bytes: Optional[int] = None,
+    checksum: Optional[str] = None,
+) -> None:
+    """Append a journal entry; committed together with the caller's change."""
+    db.add(SyncChange(
+        owner_id=owner_id,
+        action=action,
+        path=path,
+        old_path=old_path,
+        is_directory=is_directory,
+        size_bytes=size_bytes,
+        checksum=checksum,
+    ))
+
+
+class Cursor(NamedTuple):
+    """Position in the journal plus what is known about the ids above it.
+
+    ``position`` is the last entry the device has seen. Ids up to
+    ``settled`` are known to be final, so the next gap scan starts there.
+    ``seen_high`` and ``seen_xmax`` are set while ids at or below
+    ``seen_high`` may still be committed by a transaction older than
+    snapshot xmax ``seen_xmax``.
+    """
+
+    position: int
+    settled: int = 0
+    seen_high: int = 0
+    seen_xmax: int = 0
+
+    def __str__(self) -> str:
+        if self.settled <= self.position and not self.seen_xmax:
+            return str(self.position)
+        return f"{self.position}:{self.settled}:{self.seen_high}:{self.seen_xmax}"
+
+
+def parse_cursor(token: Optional[str]) -> Optional[Cursor]:
+    """Cursor from its wire form; None for tokens that are not journal cursors."""
+    if token is None:
+        return None
+    try:
+        parts = [int(part) for part in token.split(":")]
+    except ValueError:
+        return None
+    if len(parts) not in (1, 4) or any(part < 0 for part in parts):
+        return None
+    return Cursor(*parts)
+
+
+# One statement, so the gap scan and the snapshot describe the same moment:
+# a transaction holding a missing id below the newest visible one was
+# already running then, so it is among the snapshot's in-progress xids.
+_SETTLED_SQL = text("""
+    SELECT txid_snapshot_xmin(txid_current_snapshot()) AS xmin,
+           txid_snapshot_xmax(txid_current_snapshot()) AS xmax,
+           (SELECT max(id) FROM sync_changes) AS newest,
+           (SELECT prev FROM (
+                SELECT id, lag(id, 1, CAST(:after AS BIGINT)) OVER (ORDER BY id) AS prev
+                FROM sync_changes WHERE id > :after
+            ) AS steps
+            WHERE id > prev + 1 ORDER BY id LIMIT 1) AS gap_after
+""")
+
+
+def _settled(db: Session, after: Cursor) -> tuple[int, Cursor]:
+    """Highest id up to which the journal is final, and the gap to remember.
+
+    Returns ``(bound, state)``: every id in ``(after.position, bound]``
+    is either visible or rolled back for good. ``state`` is *after* with
+    ``settled`` moved to *bound* and the ``seen_high``/``seen_xmax`` of a
+    gap above it that a still-running transaction may fill (zeros when
+    there is none).
+    """
+    if db.get_bind().dialect.name != "postgresql":
+        # One writer at a time: ids become visible in commit order
+        return current_position(db), Cursor(after.position)
+
+    safe = max(after.position, after.settled)
+    xmin = db.execute(text("SELECT txid_snapshot_xmin(txid_current_snapshot())")).scalar_one()
+    if after.seen_xmax and xmin >= after.seen_xmax:
+        # Everything running when the gap was seen has ended since
+        safe = max(safe, after.seen_high)
+
+    row = db.execute(_SETTLED_SQL, {"after": safe}).one()
+    newest = row.newest or 0
+    if row.gap_after is None or row.xmin >= row.xmax:
+        # No gap, or nothing in progress that could still fill one
+        bound = max(newest, safe)
+        return bound, Cursor(after.position, bound)
+    return row.gap_after, Cursor(after.position, row.gap_after, newest, row.xmax)
+
+
+def current_position(db: Session) -> int:
+    """Id of the newest journal entry (0 if the journal is empty)."""
+    return db.query(func.max(SyncChange.id)).scalar() or 0
+
+
+def current_cursor(db: Session) -> Cursor:
+    """Cursor for a device that is in sync with the journal as of now.
+
+    Stops below any gap a running transaction may still fill; the device
+    may see some entries again that its full scan already reflected, but
+    never misses one.
+    """
+    oldest = db.query(func.min(SyncChange.id)).scalar()
+    start = oldest - 1 if oldest else 0
+    bound, state = _settled(db, Cursor(start))
+    return state._replace(position=bound)
+
+
+def changes_since(
+    db: Session,
+    owner_id: int,
+    cursor: Optional[Cursor],
+    limit: int = DEFAULT_PAGE_SIZE,
+) -> dict:
+    """Journal entries of *owner_id* after *cursor*, oldest first.
+
+    Returns ``changes``, the ``cursor`` to pass next time, ``has_more`` when the
+    page was cut at *limit*, and ``reset_required`` when the history between
+    *cursor* and now is incomplete. Entries above the settled bound (see the
+    module docstring) are left for a later call.
+    """
+    limit = max(1, min(limit, MAX_PAGE_SIZE))
+    oldest, newest = db.query(func.min(SyncChange.id), func.max(SyncChange.id)).one()
+    newest = newest or 0
+    if (
+        cursor is None
+        or cursor.position > newest
+        or (oldest is not None and cursor.position < oldest - 1)
+    ):
+        return {"changes": [], "cursor": current_cursor(db), "has_more": False, "reset_required": True}
+
+    bound, state = _settled(db, cursor)
+    rows = (
+        db.query(SyncChange)
+        .filter(
+            SyncChange.owner_id == owner_id,
+            SyncChange.id > cursor.position,
+            SyncChange.id <= bound,
+        )
+        .order_by(SyncChange.id)
+        .limit(limit + 1)
+        .all()
+    )
+    has_more = len(rows) > limit
+    rows = rows[:limit]
+    # Never past the last entry returned; the settled bound rides along so
+    # the next gap scan does not start over from there.
+    next_cursor = state._replace(position=rows[-1].id if rows else cursor.position)
+    return {
+        "changes": [
+            {
+                "cursor": row.id,
+                "action": row.action,
+                "path": row.path,
+                "old_path": row.old_path,
+                "is_directory": row.is_directory,
+                "size": row.size_bytes,
+                "checksum": row.checksum,
+                "changed_at": row.created_at.isoformat() if row.created_at else None,
+            }
+            for row in rows
+        ],
+        "cursor": next_cursor,
+        "has_more": has_more,
+        "reset_required": False,
+    }
+
+
+def prune_journal(db: Session, retention_days: int) -> int:
+    """Delete journal entries older than *retention_days*; returns the row count.
+
+    The newest entry is always kept, so ``current_position`` never goes back to 0
+    and devices that are up to date stay valid across an idle period.
+    """
+    cutoff = datetime.now(timezone.utc) - timedelta(days=retention_days)
+    newest = current_position(db)
+    deleted = (
+        db.query(SyncChange)
+        .filter(SyncChange.created_at < cutoff, SyncChange.id < newest)
+        .delete(synchronize_session=False)
+    )
+    db.commit()
+    return deleted
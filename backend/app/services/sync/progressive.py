@@ -9,6 +9,8 @@ from sqlalchemy.orm import Session
 
 from app.models.sync_progress import ChunkedUpload, SyncBandwidthLimit
 from app.models.file_metadata import FileMetadata
+from app.services.files.search import index_metadata
+from app.services.sync.journal import record_change
 from app.core.config import settings
 
 
@@ -53,6 +55,7 @@ class ProgressiveSyncService:
                 is_directory=False,
                 mime_type="application/octet-stream"
             )
+            index_metadata(file_metadata)
             self.db.add(file_metadata)
             self.db.flush()
         
@@ -248,7 +251,14 @@ class ProgressiveSyncService:
         
         if file_metadata:
             file_metadata.size_bytes = upload.total_size
-            # updated_at is set automatically by onupdate
+            index_metadata(file_metadata)  # also sets updated_at
+            record_change(
+                self.db,
+                owner_id=file_metadata.owner_id,
+                action="upsert",
+                path=file_metadata.path,
+                size_bytes=upload.total_size,
+            )
     
     def cleanup_expired_uploads(self):
         """Clean up old incomplete uploads."""
@@ -6,6 +6,7 @@ from pathlib import Path
 from typing import Iterable, Optional
 
 from passlib.context import CryptContext
+from sqlalchemy import select
 from sqlalchemy.orm import Session
 
 from app.core.config import Settings, settings
@@ -19,6 +20,9 @@ logger = logging.getLogger(__name__)
 
 SHARED_DIR_NAME = "Shared"
 
+# Descendants rewritten per UPDATE when a home directory is renamed
+_RENAME_BATCH = 1000
+
 
 def _get_db() -> Session:
     """Get database session for service layer."""
@@ -89,8 +93,9 @@ def ensure_user_home_directories(db: Optional[Session] = None) -> None:
 
 def _rename_home_directory(old_username: str, new_username: str, db: Optional[Session] = None) -> None:
     """Rename a user's home directory and update all related metadata paths."""
-    from app.services.files.metadata_db import rename_metadata
     from app.models.file_metadata import FileMetadata
+    from app.services.files import ownership
+    from app.services.files.metadata_db import rename_metadata
 
     with ensure_db(db) as session:
         storage_root = _get_storage_root()
@@ -108,18 +113,14 @@ def _rename_home_directory(old_username: str, new_username: str, db: Optional[Se
             db=session,
         )
 
-        # Update all child metadata paths with the old prefix
-        old_prefix = f"{old_username}/"
-        new_prefix = f"{new_username}/"
-        children = session.query(FileMetadata).filter(
-            FileMetadata.path.startswith(old_prefix)
-        ).all()
-        for child in children:
-            child.path = new_prefix + child.path[len(old_prefix):]
-            if child.parent_path and child.parent_path.startswith(old_prefix):
-                child.parent_path = new_prefix + child.parent_path[len(old_prefix):]
-            elif child.parent_path == old_username:
-                child.parent_path = new_username
+        # Repoint all descendants (metadata and search index) in SQL
+        child_ids = list(session.scalars(
+            select(FileMetadata.id).where(ownership._below(old_username)).order_by(FileMetadata.id)
+        ))
+        for start in range(0, len(child_ids), _RENAME_BATCH):
+            ownership._rewrite_subtree(
+                session, child_ids[start:start + _RENAME_BATCH], old_username, new_username, None,
+            )
         session.commit()
         logger.info("Renamed home directory from '%s' to '%s'", old_username, new_username)
 
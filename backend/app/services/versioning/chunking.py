@@ -0,0 +1,82 @@
+"""Content-defined chunking for VCL version storage.
+
+Splits a byte stream at positions chosen by the content itself, so an
+insertion or edit only changes the chunks around it and every other chunk
+of the new version hashes to one that is already stored.
+
+A byte-at-a-time rolling hash is far too slow in Python (~200 ns/byte), so
+the per-position fingerprint is computed with C-speed primitives over whole
+blocks instead: the block is whitened through a fixed byte table and
+multiplied, as one big integer, by a 64-bit odd constant. Byte *i* of the
+product then mixes input bytes *i-7 .. i* (plus carries), and a boundary
+candidate is any position where two consecutive product bytes are zero —
+probability 2**-16, i.e. one candidate per ~64 KiB of random data.
+
+Boundaries are taken at the first candidate after ``min_size`` bytes, or
+forced at ``max_size``. Long runs of a single byte (sparse VM images) thus
+either cut at ``min_size`` or ``max_size``, both deterministic, so those
+chunks dedupe too.
+
+The tables are derived from fixed seeds: changing them changes every
+boundary, and therefore the dedup rate against already stored versions.
+"""
+
+from __future__ import annotations
+
+import hashlib
+import io
+from typing import BinaryIO, Iterator
+
+MIN_CHUNK_SIZE = 16 * 1024
+MAX_CHUNK_SIZE = 256 * 1024
+READ_SIZE = 4 * 1024 * 1024
+
+_WHITEN = hashlib.shake_256(b"baluhost-vcl-cdc-whiten-v1").digest(256)
+_MULTIPLIER = int.from_bytes(
+    hashlib.sha256(b"baluhost-vcl-cdc-multiplier-v1").digest()[:8], "little"
+) | 1
+_CONTEXT = 8  # bytes of look-behind mixed into each position
+_MARK = b"\x00\x00"
+
+
+def _fingerprint(block: bytes, context: bytes) -> bytes:
+    """Per-byte boundary fingerprint of *block*, given the bytes before it."""
+    data = context + block
+    product = int.from_bytes(data.translate(_WHITEN), "little") * _MULTIPLIER
+    return product.to_bytes(len(data) + 8, "little")[len(context):len(data)]
+
+
+def iter_chunks(
+    stream: BinaryIO,
+    *,
+    min_size: int = MIN_CHUNK_SIZE,
+    max_size: int = MAX_CHUNK_SIZE,
+    read_size: int = READ_SIZE,
+) -> Iterator[bytes]:
+    """Yield the content-defined chunks of *stream* in order."""
+    buf = bytearray()
+    marks = bytearray()
+    context = b""
+    eof = False
+    while True:
+        if not eof and len(buf) < max_size:
+            block = stream.read(read_size)
+            if block:
+                marks += _fingerprint(block, context)
+                context = (context + block)[-_CONTEXT:]
+                buf += block
+                continue
+            eof = True
+        if not buf:
+            return
+        limit = min(len(buf), max_size)
+        idx = marks.find(_MARK, max(0, min_size - len(_MARK)), limit)
+        cut = idx + len(_MARK) if idx >= 0 else limit
+        yield bytes(buf[:cut])
+        del buf[:cut]
+        del marks[:cut]
+
+
+def chunk_bytes(content: bytes, **kwargs) -> list[bytes]:
+    """``iter_chunks`` for in-memory content."""
+    return list(iter_chunks(io.BytesIO(content), **kwargs))
@@ -0,0 +1,304 @@
+"""Compression codecs for VCL blob and chunk files.
+
+Every stored file records the codec it was written with
+(``VersionBlob.storage_format`` for single-file blobs, ``VersionChunk.codec``
+for chunks), so switching the default codec only affects new data and old
+gzip blobs stay readable.
+
+- ``zstd`` — default when the ``zstandard`` package is installed. Large
+  inputs use zstd's own worker threads. Small text-like inputs use a trained
+  dictionary when one exists. The frame header carries the dictionary id,
+  so decompression finds the right dictionary without any extra metadata.
+- ``gzip`` — the original format, and the fallback without ``zstandard``.
+- ``raw`` — uncompressed. Used for content whose sampled byte entropy says
+  compression would only burn CPU (JPEG, MP4, ZIP, already-compressed data).
+
+Readers are streaming file objects, so a version is never decompressed into
+memory as a whole.
+"""
+
+from __future__ import annotations
+
+import gzip
+import math
+import os
+import tempfile
+import threading
+from collections import Counter
+from concurrent.futures import ThreadPoolExecutor
+from pathlib import Path
+from typing import BinaryIO, Iterable, Optional
+
+try:
+    import zstandard
+except ImportError:  # optional dependency, gzip is used instead
+    zstandard = None
+
+# Order-0 entropy in bits per byte above which data is stored raw. Deflate,
+# JPEG and H.264 payloads measure 7.95+; text sits around 4.5-5.5 and
+# executables around 6.
+INCOMPRESSIBLE_ENTROPY = 7.8
+ENTROPY_SAMPLE_SIZE = 4 * 1024  # x3 (head, middle, tail): ~0.5 ms per call
+ENTROPY_MIN_SIZE = 4 * 1024  # below this the estimate is meaningless
+
+ZSTD_THREADS_MIN_SIZE = 4 * 1024 * 1024  # multithreaded zstd only pays off for big inputs
+DICT_MAX_CONTENT_SIZE = 64 * 1024  # "small" files that benefit from a dictionary
+DICT_SIZE = 112 * 1024
+DICT_ACTIVE_NAME = "dictionary.zdict"
+
+# Every suffix a file in ``blobs/`` can have (used by storage migration)
+STORED_SUFFIXES = (".gz", ".zst", ".raw", ".zdict")
+
+
+def sample_entropy(data: bytes, sample_size: int = ENTROPY_SAMPLE_SIZE) -> float:
+    """Order-0 Shannon entropy (bits/byte) of the head, middle and tail of *data*."""
+    if len(data) > 3 * sample_size:
+        mid = len(data) // 2
+        data = data[:sample_size] + data[mid:mid + sample_size] + data[-sample_size:]
+    total = len(data)
+    if not total:
+        return 0.0
+    return -sum(n / total * math.log2(n / total) for n in Counter(data).values())
+
+
+def is_incompressible(data: bytes) -> bool:
+    """True if *data* should be stored raw rather than compressed."""
+    return len(data) >= ENTROPY_MIN_SIZE and sample_entropy(data) >= INCOMPRESSIBLE_ENTROPY
+
+
+def looks_like_text(data: bytes) -> bool:
+    """Cheap text check for dictionary candidates (no NUL bytes in the head)."""
+    return b"\x00" not in data[:ENTROPY_SAMPLE_SIZE]
+
+
+def write_atomic(path: Path, payload: bytes) -> int:
+    """Write *payload* to *path* via a temp file and rename; returns its size.
+
+    The temp name is unique (``mkstemp`` in the target directory), so two
+    writers of the same chunk or blob never share a half-written file.
+    """
+    fd, tmp_name = tempfile.mkstemp(dir=path.parent, prefix=f".{path.name}.", suffix=".tmp")
+    try:
+        with os.fdopen(fd, "wb") as f:
+            f.write(payload)
+        os.replace(tmp_name, path)
+    except BaseException:
+        try:
+            os.unlink(tmp_name)
+        except OSError:
+            pass
+        raise
+    return len(payload)
+
+
+# ── Codecs ────────────────────────────────────────────────────────────────────
+
+class BlobCodec:
+    """Compresses whole byte strings and opens streaming readers/writers."""
+
+    name = ""
+    suffix = ""
+
+    def compress(self, data: bytes) -> bytes:
+        raise NotImplementedError
+
+    def decompress(self, data: bytes) -> bytes:
+        raise NotImplementedError
+
+    def open_reader(self, path: Path) -> BinaryIO:
+        """Streaming reader yielding the decompressed content of *path*."""
+        raise NotImplementedError
+
+    def open_writer(self, path: Path) -> BinaryIO:
+        """Streaming writer compressing into *path*."""
+        raise NotImplementedError
+
+    def write(self, data: bytes, path: Path) -> int:
+        """Compress *data* into *path* atomically; returns the stored size."""
+        return write_atomic(path, self.compress(data))
+
+
+class RawCodec(BlobCodec):
+    name = "raw"
+    suffix = ".raw"
+
+    def compress(self, data: bytes) -> bytes:
+        return data
+
+    def decompress(self, data: bytes) -> bytes:
+        return data
+
+    def open_reader(self, path: Path) -> BinaryIO:
+        return open(path, "rb")
+
+    def open_writer(self, path: Path) -> BinaryIO:
+        return open(path, "wb")
+
+
+class GzipCodec(BlobCodec):
+    name = "gzip"
+    suffix = ".gz"
+
+    def __init__(self, level: int = 6):
+        self.level = level
+
+    def compress(self, data: bytes) -> bytes:
+        return gzip.compress(data, compresslevel=self.level, mtime=0)
+
+    def decompress(self, data: bytes) -> bytes:
+        return gzip.decompress(data)
+
+    def open_reader(self, path: Path) -> BinaryIO:
+        return gzip.open(path, "rb")  # type: ignore[return-value]
+
+    def open_writer(self, path: Path) -> BinaryIO:
+        return gzip.open(path, "wb", compresslevel=self.level)  # type: ignore[return-value]
+
+
+class DictionaryStore:
+    """Trained zstd dictionaries kept next to the blobs.
+
+    ``dict-<id>.zdict`` files are never deleted: every frame compressed with a
+    dictionary needs it to decompress. ``dictionary.zdict`` is a copy of the
+    one currently used for new small files.
+    """
+
+    def __init__(self, directory: Path):
+        self.directory = directory
+        self._lock = threading.Lock()
+        self._by_id: dict[int, "zstandard.ZstdCompressionDict"] = {}
+        self._active: Optional["zstandard.ZstdCompressionDict"] = None
+        self._active_mtime: Optional[float] = None
+
+    def get(self, dict_id: int) -> "zstandard.ZstdCompressionDict":
+        with self._lock:
+            cached = self._by_id.get(dict_id)
+            if cached is None:
+                path = self.directory / f"dict-{dict_id}.zdict"
+                if not path.exists():
+                    raise FileNotFoundError(f"zstd dictionary not found: {path}")
+                cached = zstandard.ZstdCompressionDict(path.read_bytes())
+                self._by_id[dict_id] = cached
+            return cached
+
+    def active(self) -> Optional["zstandard.ZstdCompressionDict"]:
+        """The dictionary for new small files (re-read when another worker retrains)."""
+        path = self.directory / DICT_ACTIVE_NAME
+        try:
+            mtime = path.stat().st_mtime
+        except FileNotFoundError:
+            return None
+        with self._lock:
+            if mtime != self._active_mtime:
+                self._active = zstandard.ZstdCompressionDict(path.read_bytes())
+                self._active_mtime = mtime
+            return self._active
+
+    def train(self, samples: list[bytes], dict_size: int = DICT_SIZE) -> int:
+        """Train a dictionary from *samples*, make it active and return its id."""
+        trained = zstandard.train_dictionary(dict_size, samples)
+        payload = trained.as_bytes()
+        dict_id = trained.dict_id()
+        write_atomic(self.directory / f"dict-{dict_id}.zdict", payload)
+        write_atomic(self.directory / DICT_ACTIVE_NAME, payload)
+        return dict_id
+
+
+class ZstdCodec(BlobCodec):
+    name = "zstd"
+    suffix = ".zst"
+
+    def __init__(self, level: int = 3, threads: int = 0, dictionaries: Optional[DictionaryStore] = None):
+        self.level = level
+        self.threads = threads
+        self.dictionaries = dictionaries
+
+    def _dictionary_for(self, data: bytes):
+        if (
+            self.dictionaries is None
+            or len(data) > DICT_MAX_CONTENT_SIZE
+            or not looks_like_text(data)
+        ):
+            return None
+        return self.dictionaries.active()
+
+    def _decompressor(self, header: bytes):
+        dict_id = zstandard.get_frame_parameters(header).dict_id
+        if dict_id and self.dictionaries is not None:
+            return zstandard.ZstdDecompressor(dict_data=self.dictionaries.get(dict_id))
+        return zstandard.ZstdDecompressor()
+
+    def compress(self, data: bytes) -> bytes:
+        dictionary = self._dictionary_for(data)
+        if dictionary is not None:
+            return zstandard.ZstdCompressor(level=self.level, dict_data=dictionary).compress(data)
+        threads = self.threads if len(data) >= ZSTD_THREADS_MIN_SIZE else 0
+        return zstandard.ZstdCompressor(level=self.level, threads=threads).compress(data)
+
+    def decompress(self, data: bytes) -> bytes:
+        return self._decompressor(data).decompress(data)
+
+    def open_reader(self, path: Path) -> BinaryIO:
+        f = open(path, "rb")
+        try:
+            header = f.read(18)  # maximum frame header size
+            f.seek(0)
+            return self._decompressor(header).stream_reader(f, closefd=True)
+        except Exception:
+            f.close()
+            raise
+
+    def open_writer(self, path: Path) -> BinaryIO:
+        cctx = zstandard.ZstdCompressor(level=self.level, threads=self.threads)
+        return cctx.stream_writer(open(path, "wb"), closefd=True)
+
+
+# ── Registry ──────────────────────────────────────────────────────────────────
+
+_dictionary_stores: dict[Path, DictionaryStore] = {}
+_registry_lock = threading.Lock()
+_pool: Optional[ThreadPoolExecutor] = None
+
+
+def zstd_available() -> bool:
+    return zstandard is not None
+
+
+def compression_threads(configured: int) -> int:
+    """Worker threads for compression; 0 means auto (at most 4, the NAS shares cores)."""
+    if configured > 0:
+        return configured
+    return max(1, min(4, os.cpu_count() or 1))
+
+
+def build_codecs(
+    blobs_path: Path,
+    *,
+    gzip_level: int,
+    zstd_level: int,
+    threads: int,
+) -> dict[str, BlobCodec]:
+    """All codecs able to read from/write into *blobs_path*, keyed by name."""
+    codecs: dict[str, BlobCodec] = {
+        RawCodec.name: RawCodec(),
+        GzipCodec.name: GzipCodec(gzip_level),
+    }
+    if zstandard is not None:
+        with _registry_lock:
+            store = _dictionary_stores.get(blobs_path)
+            if store is None:
+                store = _dictionary_stores[blobs_path] = DictionaryStore(blobs_path)
+        codecs[ZstdCodec.name] = ZstdCodec(zstd_level, threads, store)
+    return codecs
+
+
+def compress_many(items: Iterable[tuple[BlobCodec, bytes]], threads: int) -> list[bytes]:
+    """Compress several buffers in parallel (zlib and zstd release the GIL)."""
+    items = list(items)
+    if threads <= 1 or len(items) <= 1:
+        return [codec.compress(data) for codec, data in items]
+    global _pool
+    with _registry_lock:
+        if _pool is None:
+            _pool = ThreadPoolExecutor(max_workers=threads, thread_name_prefix="vcl-compress")
+    return list(_pool.map(lambda item: item[0].compress(item[1]), items))
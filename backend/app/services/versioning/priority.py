@@ -274,7 +274,7 @@ class VCLPriorityMode:
             
             if not dry_run:
                 try:
-                    self.vcl_service.delete_blob(blob)
+                    blob_size = self.vcl_service.delete_blob(blob)
                     deleted_blobs.append({
                         'id': blob.id,
                         'checksum': blob.checksum[:16] + '...',
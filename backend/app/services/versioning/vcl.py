@@ -1,19 +1,73 @@
 """Version Control Light (VCL) Core Service.
 
 Handles version creation, blob storage, deduplication, and compression.
+
+Content of at least ``CHUNKED_MIN_SIZE`` bytes is stored as a manifest of
+content-defined chunks (see ``chunking.py``): chunks are deduplicated across
+all versions and files, so a small edit to a large file only writes the
+chunks around the edit. Smaller content keeps the single-file blob.
+
+Blobs and chunks are written with the configured codec (zstd by default, see
+``codecs.py``) unless their sampled entropy says they are already compressed,
+in which case they are stored raw.
+
+Blob and chunk files whose rows a transaction deletes are only unlinked once
+that transaction commits; a rollback keeps them, since the rows come back.
 """
 import hashlib
-import gzip
+import io
+import logging
+import os
 import shutil
+from collections import Counter
 from pathlib import Path
-from typing import Optional, Tuple, List
+from typing import BinaryIO, Iterator, Optional, Tuple, List
 from datetime import datetime, timezone
 from sqlalchemy.orm import Session
-from sqlalchemy import func, update
+from sqlalchemy import event, func, insert, select, update
+from sqlalchemy.exc import IntegrityError
 
-from app.models.vcl import FileVersion, VersionBlob, VCLSettings, VCLStats
+from app.models.vcl import FileVersion, VersionBlob, VersionBlobChunk, VersionChunk, VCLSettings, VCLStats
 from app.models.file_metadata import FileMetadata
 from app.core.config import settings
+from app.core.tracing import traced
+from app.services.versioning.chunking import iter_chunks
+from app.services.versioning.codecs import (
+    DICT_MAX_CONTENT_SIZE,
+    BlobCodec,
+    GzipCodec,
+    build_codecs,
+    compress_many,
+    compression_threads,
+    is_incompressible,
+    looks_like_text,
+    write_atomic,
+)
+
+logger = logging.getLogger(__name__)
+
+# Session.info key: (path, (st_dev, st_ino)) of files to unlink on commit
+_UNLINK_AFTER_COMMIT = "vcl_unlink_after_commit"
+
+
+@event.listens_for(Session, "after_commit")
+def _unlink_released_files(session: Session) -> None:
+    for path, identity in session.info.pop(_UNLINK_AFTER_COMMIT, ()):
+        try:
+            # A new chunk with the same checksum may have been written since
+            # the release; that file is a different inode and must stay.
+            st = os.stat(path)
+            if (st.st_dev, st.st_ino) == identity:
+                os.unlink(path)
+        except FileNotFoundError:
+            pass
+        except OSError as e:
+            logger.warning("Could not delete released VCL file %s: %s", path, e)
+
+
+@event.listens_for(Session, "after_rollback")
+def _keep_released_files(session: Session) -> None:
+    session.info.pop(_UNLINK_AFTER_COMMIT, None)
 
 
 class VCLService:
@@ -22,6 +76,10 @@ class VCLService:
     # Constants
     MAX_FILE_SIZE = 100 * 1024 * 1024  # 100 MB
     COMPRESSION_LEVEL = 6  # gzip compression level (balance)
+    DICT_MIN_SAMPLES = 32  # zstd dictionary training needs a reasonable corpus
+    CHUNKED_MIN_SIZE = 1024 * 1024  # 1 MB: below this a single blob is cheaper
+    CHUNK_BATCH = 64  # chunks looked up / written per round trip
+    READ_BLOCK = 1024 * 1024
     
     def __init__(self, db: Session):
         self.db = db
@@ -32,6 +90,15 @@ class VCLService:
             self.storage_base = Path(settings.nas_storage_path) / ".system" / "versions"
         self.blobs_path = self.storage_base / "blobs"
         self._ensure_storage_dirs()
+        self.compression_threads = compression_threads(settings.vcl_compression_threads)
+        self.codecs = build_codecs(
+            self.blobs_path,
+            gzip_level=self.COMPRESSION_LEVEL,
+            zstd_level=settings.vcl_zstd_level,
+            threads=self.compression_threads,
+        )
+        # Falls back to gzip when zstandard is not installed
+        self.codec: BlobCodec = self.codecs.get(settings.vcl_codec) or self.codecs[GzipCodec.name]
     
     def _ensure_storage_dirs(self):
         """Ensure version storage directories exist."""
@@ -72,86 +139,103 @@ class VCLService:
     
     # ========== Compression Operations ==========
     
-    def compress_content(self, content: bytes, dest_path: Path) -> int:
+    def get_codec(self, name: str) -> BlobCodec:
+        """Codec a blob or chunk was stored with."""
+        codec = self.codecs.get(name)
+        if codec is None:
+            raise ValueError(f"Blob codec '{name}' is not available (is zstandard installed?)")
+        return codec
+    
+    def select_codec(self, content: bytes) -> BlobCodec:
+        """Configured codec, or raw storage for already-compressed content."""
+        return self.codecs["raw"] if is_incompressible(content) else self.codec
+    
+    def compress_content(self, content: bytes, dest_path: Path, codec: Optional[BlobCodec] = None) -> int:
         """
-        Compress content with gzip and save to file.
+        Compress content and save to file.
         
         Args:
             content: Content to compress
             dest_path: Destination path for compressed file
+            codec: Codec to use (default: the configured codec)
             
         Returns:
             Compressed size in bytes
         """
-        with gzip.open(dest_path, 'wb', compresslevel=self.COMPRESSION_LEVEL) as f_out:
-            f_out.write(content)
-        
-        return dest_path.stat().st_size
+        return (codec or self.codec).write(content, dest_path)
     
-    def compress_file(self, source_path: Path, dest_path: Path) -> int:
+    def compress_file(self, source_path: Path, dest_path: Path, codec: Optional[BlobCodec] = None) -> int:
         """
-        Compress file with gzip.
+        Compress file, streaming.
         
         Args:
             source_path: Source file path
             dest_path: Destination path for compressed file
+            codec: Codec to use (default: the configured codec)
             
         Returns:
             Compressed size in bytes
         """
         with open(source_path, 'rb') as f_in:
-            with gzip.open(dest_path, 'wb', compresslevel=self.COMPRESSION_LEVEL) as f_out:
-                shutil.copyfileobj(f_in, f_out)
+            with (codec or self.codec).open_writer(dest_path) as f_out:
+                shutil.copyfileobj(f_in, f_out, self.READ_BLOCK)
         
         return dest_path.stat().st_size
     
-    def decompress_file(self, compressed_path: Path, dest_path: Path) -> int:
+    def decompress_file(self, compressed_path: Path, dest_path: Path, codec: Optional[BlobCodec] = None) -> int:
         """
-        Decompress gzip file.
+        Decompress file, streaming.
         
         Args:
             compressed_path: Compressed file path
             dest_path: Destination path for decompressed file
+            codec: Codec the file was written with (default: the configured codec)
             
         Returns:
             Decompressed size in bytes
         """
-        with gzip.open(compressed_path, 'rb') as f_in:
+        with (codec or self.codec).open_reader(compressed_path) as f_in:
             with open(dest_path, 'wb') as f_out:
-                shutil.copyfileobj(f_in, f_out)
+                shutil.copyfileobj(f_in, f_out, self.READ_BLOCK)
         
         return dest_path.stat().st_size
     
-    def read_compressed_content(self, compressed_path: Path) -> bytes:
+    def read_compressed_content(self, compressed_path: Path, codec: Optional[BlobCodec] = None) -> bytes:
         """
-        Read and decompress content.
+        Read and decompress content into memory (prefer ``iter_version_content``).
         
         Args:
             compressed_path: Path to compressed file
+            codec: Codec the file was written with (default: the configured codec)
             
         Returns:
             Decompressed content as bytes
         """
-        with gzip.open(compressed_path, 'rb') as f:
+        with (codec or self.codec).open_reader(compressed_path) as f:
             return f.read()
     
-    def decompress_content(self, compressed_content: bytes) -> bytes:
+    def decompress_content(self, compressed_content: bytes, codec: Optional[BlobCodec] = None) -> bytes:
         """
-        Decompress gzip-compressed bytes.
+        Decompress bytes.
         
         Args:
             compressed_content: Compressed content as bytes
+            codec: Codec the bytes were written with (default: the configured codec)
             
         Returns:
             Decompressed content as bytes
         """
-        return gzip.decompress(compressed_content)
+        return (codec or self.codec).decompress(compressed_content)
     
     # ========== Blob Operations (Deduplication) ==========
     
-    def get_blob_path(self, checksum: str) -> Path:
+    def get_blob_path(self, checksum: str, codec: str = GzipCodec.name) -> Path:
         """Get storage path for blob by checksum."""
-        return self.blobs_path / f"{checksum}.gz"
+        return self.blobs_path / f"{checksum}{self.get_codec(codec).suffix}"
+    
+    def get_chunk_path(self, checksum: str, codec: str = GzipCodec.name) -> Path:
+        """Get storage path for a content-defined chunk by checksum."""
+        return self.blobs_path / f"chunk-{checksum}{self.get_codec(codec).suffix}"
     
     def find_blob_by_checksum(self, checksum: str) -> Optional[VersionBlob]:
         """
@@ -182,9 +266,13 @@ class VCLService:
         Returns:
             Created VersionBlob
         """
+        if len(content) >= self.CHUNKED_MIN_SIZE:
+            return self.create_chunked_blob(io.BytesIO(content), checksum)
+        
         # Store compressed blob
-        blob_path = self.get_blob_path(checksum)
-        compressed_size = self.compress_content(content, blob_path)
+        codec = self.select_codec(content)
+        blob_path = self.get_blob_path(checksum, codec.name)
+        compressed_size = self.compress_content(content, blob_path, codec)
         
         # Create blob record
         blob = VersionBlob(
@@ -193,6 +281,7 @@ class VCLService:
             original_size=len(content),
             compressed_size=compressed_size,
             reference_count=0,
+            storage_format=codec.name,
             created_at=datetime.now(timezone.utc)
         )
         
@@ -201,6 +290,184 @@ class VCLService:
         
         return blob
     
+    def create_chunked_blob(self, source: BinaryIO, checksum: str) -> VersionBlob:
+        """
+        Create a blob stored as a manifest of deduplicated chunks.
+        
+        *source* is read block by block, so large files are never held in
+        memory. Only chunks not already in the store are compressed (in
+        parallel) and written. The blob's ``compressed_size`` is the size of
+        the chunks this blob actually inserted, i.e. what it added to disk
+        usage; a chunk another transaction inserted first counts for that one.
+        
+        Args:
+            source: Binary stream positioned at the start of the content
+            checksum: SHA256 checksum of the whole content
+            
+        Returns:
+            Created VersionBlob
+        """
+        blob = VersionBlob(
+            checksum=checksum,
+            storage_path=str(self.blobs_path),
+            original_size=0,
+            compressed_size=0,
+            reference_count=0,
+            storage_format="chunked",
+            created_at=datetime.now(timezone.utc)
+        )
+        self.db.add(blob)
+        self.db.flush()
+        
+        added_bytes = 0
+        original_size = 0
+        seq = 0
+        refs: Counter = Counter()
+        batch: list[tuple[str, bytes]] = []
+        
+        def _flush_batch() -> None:
+            nonlocal added_bytes, seq
+            known = self._chunk_ids({h for h, _ in batch})
+            new: dict[str, tuple[BlobCodec, bytes]] = {}
+            for chunk_hash, data in batch:
+                if chunk_hash not in known and chunk_hash not in new:
+                    new[chunk_hash] = (self.select_codec(data), data)
+            if new:
+                payloads = compress_many(new.values(), self.compression_threads)
+                rows = []
+                for (chunk_hash, (codec, data)), payload in zip(new.items(), payloads):
+                    rows.append({
+                        "checksum": chunk_hash,
+                        "original_size": len(data),
+                        "compressed_size": write_atomic(self.get_chunk_path(chunk_hash, codec.name), payload),
+                        "reference_count": 0,
+                        "codec": codec.name,
+                        "created_at": datetime.now(timezone.utc),
+                    })
+                inserted = self._insert_chunks(rows)
+                added_bytes += sum(row["compressed_size"] for row in rows if row["checksum"] in inserted)
+                known.update(self._chunk_ids(set(new)))
+            self.db.execute(insert(VersionBlobChunk), [
+                {"blob_id": blob.id, "seq": seq + i, "chunk_id": known[chunk_hash]}
+                for i, (chunk_hash, _) in enumerate(batch)
+            ])
+            refs.update(known[chunk_hash] for chunk_hash, _ in batch)
+            seq += len(batch)
+            batch.clear()
+        
+        for data in iter_chunks(source):
+            original_size += len(data)
+            batch.append((hashlib.sha256(data).hexdigest(), data))
+            if len(batch) >= self.CHUNK_BATCH:
+                _flush_batch()
+        if batch:
+            _flush_batch()
+        
+        self._add_chunk_references(refs)
+        self.db.execute(
+            update(VersionBlob).
+            where(VersionBlob.id == blob.id).
+            values(compressed_size=added_bytes, original_size=original_size)
+        )
+        self.db.flush()
+        self.db.refresh(blob)
+        return blob
+    
+    def _chunk_ids(self, checksums: set[str]) -> dict[str, int]:
+        """Map the given chunk checksums to the ids of their existing rows."""
+        return dict(self.db.execute(
+            select(VersionChunk.checksum, VersionChunk.id).
+            where(VersionChunk.checksum.in_(checksums))
+        ).all())
+    
+    def _insert_chunks(self, rows: list[dict]) -> set[str]:
+        """
+        Insert chunk rows, skipping checksums that already exist.
+        
+        Another upload may store the same chunk concurrently; its row wins and
+        ours is dropped instead of failing the whole version on the unique
+        checksum. Both wrote identical bytes to the same path.
+        
+        Returns:
+            Checksums of the rows this call inserted
+        """
+        dialect = self.db.get_bind().dialect.name
+        if dialect in ("postgresql", "sqlite"):
+            if dialect == "postgresql":
+                from sqlalchemy.dialects.postgresql import insert as dialect_insert
+            else:
+                from sqlalchemy.dialects.sqlite import insert as dialect_insert
+            stmt = (
+                dialect_insert(VersionChunk).values(rows).
+                on_conflict_do_nothing(index_elements=["checksum"]).
+                returning(VersionChunk.checksum)
+            )
+            return set(self.db.scalars(stmt))
+        
+        inserted: set[str] = set()
+        for row in rows:
+            try:
+                with self.db.begin_nested():
+                    self.db.execute(insert(VersionChunk).values(**row))
+            except IntegrityError:
+                continue
+            inserted.add(row["checksum"])
+        return inserted
+    
+    def _add_chunk_references(self, refs: Counter) -> None:
+        """Apply reference deltas ``{chunk_id: delta}``, one UPDATE per distinct delta."""
+        by_delta: dict[int, list[int]] = {}
+        for chunk_id, delta in refs.items():
+            by_delta.setdefault(delta, []).append(chunk_id)
+        for delta, chunk_ids in by_delta.items():
+            for i in range(0, len(chunk_ids), 500):
+                self.db.execute(
+                    update(VersionChunk).
+                    where(VersionChunk.id.in_(chunk_ids[i:i + 500])).
+                    values(reference_count=VersionChunk.reference_count + delta)
+                )
+        self.db.flush()
+    
+    def _release_chunks(self, blob: VersionBlob) -> int:
+        """
+        Drop a chunked blob's manifest and delete chunks nobody references.
+        
+        Returns:
+            Compressed bytes freed on disk
+        """
+        chunk_ids = [
+            row.chunk_id for row in self.db.query(VersionBlobChunk.chunk_id).filter(
+                VersionBlobChunk.blob_id == blob.id
+            )
+        ]
+        self.db.query(VersionBlobChunk).filter(
+            VersionBlobChunk.blob_id == blob.id
+        ).delete(synchronize_session=False)
+        refs = Counter(chunk_ids)
+        self._add_chunk_references(Counter({chunk_id: -n for chunk_id, n in refs.items()}))
+        
+        freed_bytes = 0
+        unique_ids = list(refs)
+        for i in range(0, len(unique_ids), 500):
+            unreferenced = self.db.query(VersionChunk).filter(
+                VersionChunk.id.in_(unique_ids[i:i + 500]),
+                VersionChunk.reference_count <= 0
+            ).all()
+            for chunk in unreferenced:
+                self._unlink_after_commit(self.get_chunk_path(str(chunk.checksum), str(chunk.codec)))
+                freed_bytes += int(chunk.compressed_size)  # type: ignore
+                self.db.delete(chunk)
+        self.db.flush()
+        return freed_bytes
+    
+    def _unlink_after_commit(self, path: Path) -> None:
+        """Delete *path* once the current transaction commits (kept on rollback)."""
+        try:
+            st = path.stat()
+        except FileNotFoundError:
+            return
+        self.db.info.setdefault(_UNLINK_AFTER_COMMIT, []).append((path, (st.st_dev, st.st_ino)))
+    
     def increment_blob_reference(self, blob: VersionBlob):
         """Increment blob reference count."""
         # Use SQL update to avoid Column assignment issues
@@ -236,23 +503,30 @@ class VCLService:
         )
         self.db.flush()
     
-    def delete_blob(self, blob: VersionBlob):
+    def delete_blob(self, blob: VersionBlob) -> int:
         """
         Delete blob file and database record.
         Only if reference count is 0.
+        
+        Returns:
+            Compressed bytes freed on disk (for chunked blobs: the chunks that
+            no other blob shares)
         """
         ref_count: int = int(blob.reference_count)  # type: ignore
         if ref_count > 0:
             raise ValueError(f"Cannot delete blob {blob.id} with {ref_count} references")
         
-        # Delete physical file
-        storage_path: str = str(blob.storage_path)  # type: ignore
-        blob_path = Path(storage_path)
-        if blob_path.exists():
-            blob_path.unlink()
+        if blob.storage_format == "chunked":
+            freed_bytes = self._release_chunks(blob)
+        else:
+            # Delete physical file once the row deletion is committed
+            storage_path: str = str(blob.storage_path)  # type: ignore
+            self._unlink_after_commit(Path(storage_path))
+            freed_bytes = int(blob.compressed_size)  # type: ignore
         
         # Delete database record
         self.db.delete(blob)
+        return freed_bytes
     
     def get_or_create_blob(self, content: bytes, checksum: str) -> Tuple[VersionBlob, bool]:
         """
@@ -278,6 +552,29 @@ class VCLService:
             self.increment_blob_reference(new_blob)
             return new_blob, True
     
+    def get_or_create_blob_from_file(self, file_path: Path, checksum: str) -> Tuple[VersionBlob, bool]:
+        """
+        Like ``get_or_create_blob``, reading the content from *file_path*.
+        
+        Content that will be chunked is streamed from the file instead of
+        being loaded into memory first.
+        
+        Returns:
+            Tuple of (blob, was_created)
+        """
+        existing_blob = self.find_blob_by_checksum(checksum)
+        if existing_blob:
+            self.increment_blob_reference(existing_blob)
+            return existing_blob, False
+        
+        if file_path.stat().st_size >= self.CHUNKED_MIN_SIZE:
+            with open(file_path, "rb") as f:
+                new_blob = self.create_chunked_blob(f, checksum)
+        else:
+            new_blob = self.create_blob(file_path.read_bytes(), checksum)
+        self.increment_blob_reference(new_blob)
+        return new_blob, True
+    
     # ========== Version Operations ==========
     
     def should_create_version(
@@ -340,6 +637,7 @@ class VCLService:
         
         return (max_version or 0) + 1
     
+    @traced("create_version")
     def create_version(
         self,
         file: FileMetadata,
@@ -376,6 +674,59 @@ class VCLService:
         # Get or create blob (deduplication)
         blob, was_created = self.get_or_create_blob(content, checksum)
         
+        return self._record_version(
+            file, blob, was_created, len(content), user_id, checksum,
+            is_high_priority=is_high_priority,
+            change_type=change_type,
+            comment=comment,
+            was_cached=was_cached,
+            cache_duration=cache_duration,
+        )
+    
+    @traced("create_version")
+    def create_version_from_file(
+        self,
+        file: FileMetadata,
+        file_path: Path,
+        user_id: int,
+        checksum: Optional[str] = None,
+        is_high_priority: bool = False,
+        change_type: str = "update",
+        comment: Optional[str] = None,
+    ) -> FileVersion:
+        """
+        Create new file version from the file on disk.
+        
+        Same as ``create_version``, but large content is chunked straight
+        from the file, so memory stays bounded by the chunk batch size.
+        """
+        if checksum is None:
+            checksum = self.calculate_checksum_from_file(file_path)
+        
+        blob, was_created = self.get_or_create_blob_from_file(file_path, checksum)
+        
+        return self._record_version(
+            file, blob, was_created, int(blob.original_size), user_id, checksum,  # type: ignore
+            is_high_priority=is_high_priority,
+            change_type=change_type,
+            comment=comment,
+        )
+    
+    def _record_version(
+        self,
+        file: FileMetadata,
+        blob: VersionBlob,
+        was_created: bool,
+        file_size: int,
+        user_id: int,
+        checksum: str,
+        is_high_priority: bool = False,
+        change_type: str = "update",
+        comment: Optional[str] = None,
+        was_cached: bool = False,
+        cache_duration: Optional[int] = None
+    ) -> FileVersion:
+        """Add the FileVersion row for *blob* and update quota and stats."""
         # Determine storage type
         storage_type = 'stored' if was_created else 'reference'
         
@@ -394,7 +745,7 @@ class VCLService:
             version_number=version_number,
             blob_id=blob.id,
             storage_type=storage_type,
-            file_size=len(content),
+            file_size=file_size,
             compressed_size=blob_comp,
             compression_ratio=compression_ratio,
             checksum=checksum,
@@ -416,7 +767,7 @@ class VCLService:
         # Update global stats
         self._update_stats(
             version_created=True,
-            size_bytes=len(content),
+            size_bytes=file_size,
             compressed_bytes=blob_comp,
             blob_created=was_created,
             is_priority=is_high_priority,
@@ -463,14 +814,85 @@ class VCLService:
         Returns:
             Decompressed content as bytes
         """
-        if not version.blob:
+        return b"".join(self.iter_version_content(version))
+    
+    def iter_version_content(self, version: FileVersion) -> Iterator[bytes]:
+        """
+        Stream the decompressed content of a version.
+        
+        Missing blob or chunk files are detected before the first block is
+        produced, so callers can still fail cleanly.
+        
+        Args:
+            version: FileVersion
+            
+        Returns:
+            Iterator over content blocks
+        """
+        blob = version.blob
+        if not blob:
             raise ValueError(f"Version {version.id} has no associated blob")
         
-        blob_path = Path(version.blob.storage_path)
+        if blob.storage_format == "chunked":
+            chunks = [
+                (self.get_chunk_path(row.checksum, row.codec), self.get_codec(row.codec))
+                for row in self.db.query(VersionChunk.checksum, VersionChunk.codec)
+                .join(VersionBlobChunk, VersionBlobChunk.chunk_id == VersionChunk.id)
+                .filter(VersionBlobChunk.blob_id == blob.id)
+                .order_by(VersionBlobChunk.seq)
+            ]
+            for chunk_path, _ in chunks:
+                if not chunk_path.exists():
+                    raise FileNotFoundError(f"Chunk file not found: {chunk_path}")
+            return (codec.decompress(path.read_bytes()) for path, codec in chunks)
+        
+        codec = self.get_codec(str(blob.storage_format))
+        blob_path = Path(blob.storage_path)
         if not blob_path.exists():
             raise FileNotFoundError(f"Blob file not found: {blob_path}")
+        return self._iter_blob_file(blob_path, codec)
+    
+    def _iter_blob_file(self, path: Path, codec: BlobCodec) -> Iterator[bytes]:
+        with codec.open_reader(path) as f:
+            while block := f.read(self.READ_BLOCK):
+                yield block
+    
+    def train_dictionary(self, max_samples: int = 1000) -> Tuple[Optional[int], int]:
+        """
+        Train the zstd dictionary used for new small text blobs.
+        
+        Samples the most recent small, text-like single-file blobs. Frames
+        record their dictionary id, so retraining never breaks old blobs.
         
-        return self.read_compressed_content(blob_path)
+        Returns:
+            Tuple of (dictionary_id or None if too few samples, samples used)
+        """
+        zstd = self.codecs.get("zstd")
+        if zstd is None:
+            raise ValueError("zstd dictionaries need the zstandard package")
+        
+        blobs = self.db.query(VersionBlob).filter(
+            VersionBlob.storage_format.in_(("gzip", "zstd")),
+            VersionBlob.original_size > 0,
+            VersionBlob.original_size <= DICT_MAX_CONTENT_SIZE
+        ).order_by(VersionBlob.created_at.desc()).limit(max_samples).all()
+        
+        samples: list[bytes] = []
+        for blob in blobs:
+            blob_path = Path(blob.storage_path)
+            if not blob_path.exists():
+                continue
+            data = self.read_compressed_content(blob_path, self.get_codec(str(blob.storage_format)))
+            if looks_like_text(data):
+                samples.append(data)
+        
+        if len(samples) < self.DICT_MIN_SAMPLES:
+            return None, len(samples)
+        try:
+            dict_id = zstd.dictionaries.train(samples)  # type: ignore[attr-defined]
+        except Exception as e:  # zstandard.ZstdError: corpus unsuitable
+            raise ValueError(f"Dictionary training failed: {e}") from e
+        return dict_id, len(samples)
     
     def delete_version(self, version: FileVersion) -> int:
         """
@@ -479,10 +901,17 @@ class VCLService:
         Args:
             version: FileVersion to delete
             
+        Quota and stats are reversed by exactly what ``create_version``
+        charged for this version (its ``compressed_size``, to the user only
+        if it was 'stored'), not by the bytes freed on disk: with shared
+        blobs and chunks those belong to whichever version happens to drop
+        the last reference, and charging them there made usage drift.
+        
         Returns:
-            Bytes freed
+            Bytes freed on disk
         """
         freed_bytes = 0
+        blob_deleted = False
         
         # Decrement blob reference
         if version.blob:
@@ -491,8 +920,8 @@ class VCLService:
             # If blob can be deleted, delete it
             blob_can_delete: bool = bool(version.blob.can_delete)  # type: ignore
             if blob_can_delete:
-                freed_bytes = int(version.blob.compressed_size)  # type: ignore
-                self.delete_blob(version.blob)
+                freed_bytes = self.delete_blob(version.blob)
+                blob_deleted = True
         
         # Delete version record
         self.db.delete(version)
@@ -500,18 +929,19 @@ class VCLService:
         # Cast Columns for parameter types
         vers_user_id: int = int(version.user_id)  # type: ignore
         vers_file_size: int = int(version.file_size)  # type: ignore
+        vers_comp_size: int = int(version.compressed_size)  # type: ignore
         vers_is_priority: bool = bool(version.is_high_priority)  # type: ignore
         
         # Update user quota
-        if freed_bytes > 0:
-            self._update_user_usage(vers_user_id, -freed_bytes)
+        if version.storage_type == 'stored' and vers_comp_size > 0:
+            self._update_user_usage(vers_user_id, -vers_comp_size)
         
         # Update stats
         self._update_stats(
             version_deleted=True,
             size_bytes=-vers_file_size,
-            compressed_bytes=-freed_bytes,
-            blob_deleted=freed_bytes > 0,
+            compressed_bytes=-vers_comp_size,
+            blob_deleted=blob_deleted,
             is_priority=vers_is_priority
         )
         
@@ -7,6 +7,11 @@ process, analogous to how scheduler_worker_service.py runs APScheduler jobs.
 IPC with the web process is done via the database:
 - Worker writes webdav_state row → Web API reads it for status
 - Heartbeat updated every 10s so the web process can detect staleness
+
+With ``webdav_fast_path`` the server uses SendfileGateway, which sends the
+FileRange bodies of the GET fast path (compat/webdav_fastpath.py) with
+``socket.sendfile()`` — a kernel copy on plain HTTP; under TLS Python
+falls back to large writes.
 """
 
 import datetime
@@ -21,6 +26,7 @@ from typing import Optional
 
 from cheroot import wsgi
 
+from app.compat.webdav_fastpath import FileRange
 from app.core.config import settings
 from app.core.database import SessionLocal, commit_with_retry
 from app.models.webdav_state import WebdavState
@@ -30,6 +36,39 @@ logger = logging.getLogger(__name__)
 HEARTBEAT_INTERVAL = 10  # seconds
 
 
+class SendfileGateway(wsgi.Gateway_10):
+    """WSGI gateway that sends FileRange bodies with socket.sendfile()."""
+
+    def respond(self):
+        response = self.req.server.wsgi_app(self.env, self.start_response)
+        try:
+            if isinstance(response, FileRange) and self._can_sendfile():
+                self._sendfile(response)
+            else:
+                for chunk in filter(None, response):
+                    if not isinstance(chunk, bytes):
+                        raise ValueError("WSGI Applications must yield bytes")
+                    self.write(chunk)
+        finally:
+            self.req.ensure_headers_sent()
+            if hasattr(response, "close"):
+                response.close()
+
+    def _can_sendfile(self) -> bool:
+        self.req.ensure_headers_sent()
+        return not self.req.chunked_write and getattr(self.req, "allow_message_body", True)
+
+    def _sendfile(self, body: FileRange) -> None:
+        if body.length <= 0:
+            return
+        self.req.conn.wfile.flush()  # headers first
+        sent = self.req.conn.socket.sendfile(body.file, body.offset, body.length)
+        if sent != body.length:
+            # File shrank underneath us; the announced length can't be kept
+            self.req.close_connection = True
+            raise IOError(f"sendfile sent {sent} of {body.length} bytes")
+
+
 def get_local_ip() -> str:
     """Detect the primary local IP address."""
     try:
@@ -137,7 +176,10 @@ class WebdavWorker:
         self._server = wsgi.Server(
             bind_addr=("0.0.0.0", port),
             wsgi_app=app,
+            numthreads=settings.webdav_server_threads,
         )
+        if settings.webdav_fast_path:
+            self._server.gateway = SendfileGateway
 
         # Optionally enable SSL
         if ssl_enabled:
@@ -0,0 +1,178 @@
+"""Cross-worker bus for WebSocket broadcasts.
+
+A client's socket lives in exactly one of the Uvicorn workers, but
+notifications are created in whichever worker handled the request and the
+SHM bridges only run on the primary. Each worker therefore binds a Unix
+datagram socket (``<pid>.sock``) in a per-instance directory under the
+monitoring SHM dir, and ``publish()`` sends the already-serialised frame to
+every other socket in it. The receiving worker hands the datagram to its
+``WebSocketManager``, which delivers it to local connections only (no
+re-publish, so there are no loops).
+
+Datagram layout: one JSON header line (origin name, target user, admins-only
+flag, topic) followed by the frame text exactly as it goes on the wire.
+
+Best-effort like the rest of the SHM IPC: a peer whose receive buffer is full
+misses the frame, sockets of dead workers are unlinked on the first refused
+send, and platforms without ``AF_UNIX`` datagrams (Windows dev mode, single
+process) simply run without a bus.
+"""
+from __future__ import annotations
+
+import asyncio
+import hashlib
+import json
+import logging
+import os
+import socket
+from pathlib import Path
+from typing import Any, Callable, Optional
+
+from app.core.config import settings
+from app.services.monitoring.shm import SHM_DIR
+
+logger = logging.getLogger(__name__)
+
+# Frames above this are delivered locally only. Notifications and panel
+# updates are a few KB; the AF_UNIX default send buffer is ~200 KB.
+MAX_DATAGRAM_BYTES = 64 * 1024
+
+Deliver = Callable[[dict[str, Any], str], None]
+
+
+def _default_bus_dir() -> Path:
+    # Keyed on the storage root like the metric rings and the SSD cache hot
+    # index, so separate instances sharing /dev/shm never see each other.
+    root = str(Path(settings.nas_storage_path).expanduser().resolve())
+    digest = hashlib.sha1(root.encode("utf-8")).hexdigest()[:12]
+    return SHM_DIR / f"ws_bus-{digest}"
+
+
+class WebSocketBus:
+    """One worker's endpoint on the broadcast bus (see module docstring)."""
+
+    def __init__(
+        self,
+        deliver: Deliver,
+        directory: Optional[Path] = None,
+        name: Optional[str] = None,
+    ) -> None:
+        self.directory = directory or _default_bus_dir()
+        # Socket file stem and origin id; defaults to the worker pid
+        self.name = name or str(os.getpid())
+        self._deliver = deliver
+        self._sock: Optional[socket.socket] = None
+        self._path: Optional[Path] = None
+        self._loop: Optional[asyncio.AbstractEventLoop] = None
+
+    @property
+    def running(self) -> bool:
+        return self._sock is not None
+
+    def start(self) -> bool:
+        """Bind this worker's socket and start reading on the running loop.
+
+        Returns False (and leaves the bus disabled) when the platform has no
+        Unix datagram sockets or the bind fails.
+        """
+        if self._sock is not None:
+            return True
+        if not hasattr(socket, "AF_UNIX"):
+            return False
+        path = self.directory / f"{self.name}.sock"
+        sock = None
+        try:
+            loop = asyncio.get_running_loop()
+            self.directory.mkdir(parents=True, exist_ok=True)
+            try:
+                path.unlink()  # left behind by a previous process with our name
+            except FileNotFoundError:
+                pass
+            sock = socket.socket(socket.AF_UNIX, socket.SOCK_DGRAM)
+            sock.setblocking(False)
+            sock.bind(str(path))
+            loop.add_reader(sock.fileno(), self._on_readable)
+        except Exception as exc:
+            logger.warning("WebSocket bus disabled: %s", exc)
+            if sock is not None:
+                sock.close()
+            return False
+        self._sock, self._path, self._loop = sock, path, loop
+        logger.info("WebSocket bus listening on %s", path)
+        return True
+
+    def stop(self) -> None:
+        """Stop reading and remove this worker's socket."""
+        sock, self._sock = self._sock, None
+        if sock is None:
+            return
+        try:
+            if self._loop is not None and not self._loop.is_closed():
+                self._loop.remove_reader(sock.fileno())
+        except Exception:
+            pass
+        sock.close()
+        if self._path is not None:
+            try:
+                self._path.unlink()
+            except OSError:
+                pass
+
+    def publish(self, header: dict[str, Any], frame: str) -> int:
+        """Send a frame to every other worker. Returns the number of peers reached."""
+        sock = self._sock
+        if sock is None:
+            return 0
+        data = (
+            json.dumps({**header, "o": self.name}, separators=(",", ":")) + "\n" + frame
+        ).encode("utf-8")
+        if len(data) > MAX_DATAGRAM_BYTES:
+            logger.warning(
+                "WebSocket bus: %d byte frame (topic=%s) delivered locally only",
+                len(data), header.get("p"),
+            )
+            return 0
+
+        reached = 0
+        try:
+            peers = [e.path for e in os.scandir(self.directory) if e.name.endswith(".sock")]
+        except OSError:
+            return 0
+        for peer in peers:
+            if peer == str(self._path):
+                continue
+            try:
+                sock.sendto(data, peer)
+                reached += 1
+            except (ConnectionRefusedError, FileNotFoundError):
+                # Nobody bound: the worker died without stop()
+                try:
+                    os.unlink(peer)
+                except OSError:
+                    pass
+            except BlockingIOError:
+                logger.debug("WebSocket bus: peer %s is backed up, frame dropped", peer)
+            except OSError as exc:
+                logger.debug("WebSocket bus: send to %s failed: %s", peer, exc)
+        return reached
+
+    def _on_readable(self) -> None:
+        sock = self._sock
+        if sock is None:
+            return
+        while True:
+            try:
+                data = sock.recv(MAX_DATAGRAM_BYTES)
+            except (BlockingIOError, InterruptedError):
+                return
+            except OSError as exc:
+                logger.debug("WebSocket bus: receive failed: %s", exc)
+                return
+            try:
+                head, _, frame = data.decode("utf-8").partition("\n")
+                header = json.loads(head)
+                if header.get("o") == self.name:
+                    continue
+                self._deliver(header, frame)
+            except Exception as exc:
+                logger.debug("WebSocket bus: dropped malformed datagram: %s", exc)
@@ -1,32 +1,190 @@
 """WebSocket manager for real-time notification delivery.
 
 Manages WebSocket connections and broadcasts notifications to connected clients.
+
+A broadcast serialises its frame once and appends it to the bounded send
+queue of every target connection; each connection has its own writer task
+draining that queue, so one slow client (phone on a bad link) only backs up
+itself. What happens to a frame when a queue is full depends on the topic
+(``TOPIC_POLICIES``):
+
+- ``coalesce``: latest state wins — a still-queued frame of the same topic is
+  replaced in place (panel updates, unread count)
+- ``drop``: high-rate telemetry, may be discarded under pressure
+- ``reliable`` (default, notifications): evicts queued telemetry first; if
+  the queue holds nothing but reliable frames the client is disconnected as
+  a slow consumer (close 1013) and re-reads its state on reconnect
+
+Every broadcast is also published on the worker bus (``websocket_bus``) so
+clients connected to any of the Uvicorn workers receive it. Returned counts
+are this worker's connections only.
 """
 
 import asyncio
+import json
 import logging
+from collections import deque
 from typing import Optional, Any
-from dataclasses import dataclass
+from dataclasses import dataclass, field
 
 from fastapi import WebSocket
 
+from app.services.websocket_bus import WebSocketBus
+
 logger = logging.getLogger(__name__)
 
 # Max simultaneous WebSocket connections per user (DoS guard, Posten 5 #2).
 # Covers a desktop client + phone + a couple of browser tabs.
 MAX_CONNECTIONS_PER_USER = 5
 
+# Frames queued per connection before the topic policy kicks in
+SEND_QUEUE_SIZE = 64
+# A single send blocked longer than this marks the client dead
+SEND_TIMEOUT_SECONDS = 10.0
+
+POLICY_RELIABLE = "reliable"
+POLICY_COALESCE = "coalesce"
+POLICY_DROP = "drop"
+
+TOPIC_POLICIES: dict[str, str] = {
+    "unread_count": POLICY_COALESCE,
+    "dashboard_panel_update": POLICY_COALESCE,
+    "smart_device_update": POLICY_DROP,
+}
+
+# Close codes (RFC 6455 / IANA registry)
+_CLOSE_INTERNAL_ERROR = 1011
+_CLOSE_TRY_AGAIN_LATER = 1013
+
 
 class ConnectionLimitExceeded(Exception):
     """Raised when a user exceeds MAX_CONNECTIONS_PER_USER active connections."""
 
 
-@dataclass
+def encode_frame(msg_type: str, payload: Any) -> str:
+    """Serialise a ``{"type", "payload"}`` frame (same encoding as ``send_json``)."""
+    return json.dumps(
+        {"type": msg_type, "payload": payload},
+        separators=(",", ":"),
+        ensure_ascii=False,
+    )
+
+
+@dataclass(eq=False)
 class Connection:
     """Represents a WebSocket connection."""
     websocket: WebSocket
     user_id: int
     is_admin: bool = False
+    closed: bool = False
+    dropped: int = 0
+    # Queued frames: [topic, text, policy]
+    _queue: deque = field(default_factory=deque, repr=False)
+    _wakeup: asyncio.Event = field(default_factory=asyncio.Event, repr=False)
+    _idle: asyncio.Event = field(default_factory=asyncio.Event, repr=False)
+    _writer: Optional[asyncio.Task] = field(default=None, repr=False)
+    _manager: Optional["WebSocketManager"] = field(default=None, repr=False)
+
+    def __post_init__(self) -> None:
+        self._idle.set()
+
+    @property
+    def pending(self) -> int:
+        """Number of frames waiting to be sent."""
+        return len(self._queue)
+
+    def send_typed(self, msg_type: str, payload: Any) -> bool:
+        """Queue a direct ``{"type", "payload"}`` message to this connection only."""
+        return self.enqueue(encode_frame(msg_type, payload), msg_type)
+
+    def enqueue(self, text: str, topic: str) -> bool:
+        """Queue a pre-serialised frame. Returns False if it was not queued."""
+        if self.closed:
+            return False
+        policy = TOPIC_POLICIES.get(topic, POLICY_RELIABLE)
+
+        if policy == POLICY_COALESCE:
+            for frame in self._queue:
+                if frame[0] == topic:
+                    frame[1] = text
+                    return True
+
+        if len(self._queue) >= SEND_QUEUE_SIZE and not self._evict_telemetry():
+            if policy != POLICY_RELIABLE:
+                self.dropped += 1
+                return False
+            logger.warning(
+                f"WebSocket: user {self.user_id} is not keeping up "
+                f"({len(self._queue)} frames queued), disconnecting"
+            )
+            self._fail(_CLOSE_TRY_AGAIN_LATER)
+            return False
+
+        self._queue.append([topic, text, policy])
+        self._idle.clear()
+        self._wakeup.set()
+        if self._writer is None:
+            self._writer = asyncio.get_running_loop().create_task(self._run_writer())
+        return True
+
+    def _evict_telemetry(self) -> bool:
+        """Drop the oldest queued non-reliable frame to make room."""
+        for frame in self._queue:
+            if frame[2] != POLICY_RELIABLE:
+                self._queue.remove(frame)
+                self.dropped += 1
+                return True
+        return False
+
+    async def _run_writer(self) -> None:
+        try:
+            while not self.closed:
+                if not self._queue:
+                    self._idle.set()
+                    self._wakeup.clear()
+                    await self._wakeup.wait()
+                    continue
+                _, text, _ = self._queue.popleft()
+                await asyncio.wait_for(
+                    self.websocket.send_text(text), SEND_TIMEOUT_SECONDS
+                )
+        except asyncio.CancelledError:
+            raise
+        except Exception as e:
+            logger.warning(f"Failed to send to user {self.user_id}: {e!r}")
+            self._fail(_CLOSE_INTERNAL_ERROR, from_writer=True)
+
+    def _fail(self, close_code: int, from_writer: bool = False) -> None:
+        """Mark dead, unregister and close the socket so the route's receive loop ends."""
+        if self.closed:
+            return
+        self.closed = True
+        self._queue.clear()
+        self._idle.set()
+        if self._writer is not None and not from_writer:
+            self._writer.cancel()
+        if self._manager is not None:
+            self._manager._discard(self)
+        asyncio.get_running_loop().create_task(self._close_quietly(close_code))
+
+    async def _close_quietly(self, code: int) -> None:
+        try:
+            await asyncio.wait_for(self.websocket.close(code=code), SEND_TIMEOUT_SECONDS)
+        except Exception:
+            pass
+
+    async def shutdown(self) -> None:
+        """Stop the writer task (queued frames are discarded)."""
+        self.closed = True
+        self._queue.clear()
+        self._idle.set()
+        writer, self._writer = self._writer, None
+        if writer is not None and writer is not asyncio.current_task():
+            writer.cancel()
+            try:
+                await writer
+            except (asyncio.CancelledError, Exception):
+                pass
 
 
 class WebSocketManager:
@@ -40,6 +198,8 @@ class WebSocketManager:
         self._admin_users: set[int] = set()
         # Lock for thread-safe operations
         self._lock = asyncio.Lock()
+        # Cross-worker fan-out, started by init_websocket_manager()
+        self._bus: Optional[WebSocketBus] = None
 
     async def connect(
         self,
@@ -62,6 +222,7 @@ class WebSocketManager:
             user_id=user_id,
             is_admin=is_admin,
         )
+        connection._manager = self
 
         async with self._lock:
             if len(self._user_connections.get(user_id, [])) >= MAX_CONNECTIONS_PER_USER:
@@ -89,25 +250,79 @@ class WebSocketManager:
             websocket: The WebSocket connection to remove
         """
         async with self._lock:
-            for user_id, connections in list(self._user_connections.items()):
-                for conn in connections[:]:  # Iterate over copy
-                    if conn.websocket is websocket:
-                        connections.remove(conn)
-                        logger.info(
-                            f"WebSocket disconnected: user_id={user_id}, "
-                            f"total_connections={self._count_connections()}"
-                        )
-
-                        # Clean up empty user entries
-                        if not connections:
-                            del self._user_connections[user_id]
-                            self._admin_users.discard(user_id)
-                        return
+            conn = next(
+                (
+                    c for conns in self._user_connections.values()
+                    for c in conns if c.websocket is websocket
+                ),
+                None,
+            )
+            if conn is None:
+                return
+            self._discard(conn)
+            logger.info(
+                f"WebSocket disconnected: user_id={conn.user_id}, "
+                f"total_connections={self._count_connections()}"
+            )
+        await conn.shutdown()
+
+    def _discard(self, conn: Connection) -> None:
+        """Unregister a connection (no await, safe from writer tasks)."""
+        connections = self._user_connections.get(conn.user_id)
+        if connections is None or conn not in connections:
+            return
+        connections.remove(conn)
+        # Clean up empty user entries
+        if not connections:
+            del self._user_connections[conn.user_id]
+            self._admin_users.discard(conn.user_id)
 
     def _count_connections(self) -> int:
         """Count total active connections."""
         return sum(len(conns) for conns in self._user_connections.values())
 
+    # ------------------------------------------------------------------
+    # Fan-out
+    # ------------------------------------------------------------------
+
+    def _targets(self, user_id: Optional[int], admins_only: bool) -> list[Connection]:
+        if user_id is not None:
+            connections = list(self._user_connections.get(user_id, []))
+        else:
+            connections = [c for conns in self._user_connections.values() for c in conns]
+        if admins_only:
+            connections = [c for c in connections if c.is_admin]
+        return connections
+
+    def _deliver_local(
+        self, frame: str, topic: str, user_id: Optional[int], admins_only: bool
+    ) -> int:
+        return sum(1 for conn in self._targets(user_id, admins_only) if conn.enqueue(frame, topic))
+
+    def _deliver_remote(self, header: dict[str, Any], frame: str) -> None:
+        """Bus callback: a frame published by another worker."""
+        self._deliver_local(
+            frame, header.get("p") or "notification", header.get("u"), bool(header.get("a"))
+        )
+
+    def _fan_out(
+        self,
+        msg_type: str,
+        payload: Any,
+        topic: Optional[str] = None,
+        user_id: Optional[int] = None,
+        admins_only: bool = False,
+    ) -> int:
+        topic = topic or msg_type
+        try:
+            frame = encode_frame(msg_type, payload)
+        except (TypeError, ValueError) as e:
+            logger.error(f"WebSocket: cannot serialise {topic} frame: {e}")
+            return 0
+        if self._bus is not None:
+            self._bus.publish({"u": user_id, "a": admins_only, "p": topic}, frame)
+        return self._deliver_local(frame, topic, user_id, admins_only)
+
     async def broadcast_to_user(
         self,
         user_id: int,
@@ -120,34 +335,9 @@ class WebSocketManager:
             message: Message to send
 
         Returns:
-            Number of connections the message was sent to
+            Number of connections the message was queued for
         """
-        sent_count = 0
-        async with self._lock:
-            connections = self._user_connections.get(user_id, [])
-            disconnected = []
-
-            for conn in connections:
-                try:
-                    await conn.websocket.send_json({
-                        "type": "notification",
-                        "payload": message,
-                    })
-                    sent_count += 1
-                except Exception as e:
-                    logger.warning(f"Failed to send to user {user_id}: {e}")
-                    disconnected.append(conn)
-
-            # Clean up disconnected connections
-            for conn in disconnected:
-                if conn in connections:
-                    connections.remove(conn)
-
-            if not connections and user_id in self._user_connections:
-                del self._user_connections[user_id]
-                self._admin_users.discard(user_id)
-
-        return sent_count
+        return self._fan_out("notification", message, user_id=user_id)
 
     async def broadcast_to_admins(self, message: dict[str, Any]) -> int:
         """Broadcast a message to all admin users.
@@ -156,72 +346,24 @@ class WebSocketManager:
             message: Message to send
 
         Returns:
-            Number of connections the message was sent to
+            Number of connections the message was queued for
         """
-        sent_count = 0
-        async with self._lock:
-            for user_id in list(self._admin_users):
-                connections = self._user_connections.get(user_id, [])
-                disconnected = []
-
-                for conn in connections:
-                    if conn.is_admin:
-                        try:
-                            await conn.websocket.send_json({
-                                "type": "notification",
-                                "payload": message,
-                            })
-                            sent_count += 1
-                        except Exception as e:
-                            logger.warning(f"Failed to send to admin {user_id}: {e}")
-                            disconnected.append(conn)
-
-                # Clean up disconnected connections
-                for conn in disconnected:
-                    if conn in connections:
-                        connections.remove(conn)
-
-                if not connections and user_id in self._user_connections:
-                    del self._user_connections[user_id]
-                    self._admin_users.discard(user_id)
-
-        return sent_count
-
-    async def broadcast_to_all(self, message: dict[str, Any]) -> int:
+        return self._fan_out("notification", message, admins_only=True)
+
+    async def broadcast_to_all(
+        self, message: dict[str, Any], topic: Optional[str] = None
+    ) -> int:
         """Broadcast a message to all connected users.
 
         Args:
             message: Message to send
+            topic: Queue policy key (``TOPIC_POLICIES``); the frame type stays
+                "notification"
 
         Returns:
-            Number of connections the message was sent to
+            Number of connections the message was queued for
         """
-        sent_count = 0
-        async with self._lock:
-            for user_id, connections in list(self._user_connections.items()):
-                disconnected = []
-
-                for conn in connections:
-                    try:
-                        await conn.websocket.send_json({
-                            "type": "notification",
-                            "payload": message,
-                        })
-                        sent_count += 1
-                    except Exception as e:
-                        logger.warning(f"Failed to broadcast to user {user_id}: {e}")
-                        disconnected.append(conn)
-
-                # Clean up disconnected connections
-                for conn in disconnected:
-                    if conn in connections:
-                        connections.remove(conn)
-
-                if not connections and user_id in self._user_connections:
-                    del self._user_connections[user_id]
-                    self._admin_users.discard(user_id)
-
-        return sent_count
+        return self._fan_out("notification", message, topic=topic)
 
     async def broadcast_typed(
         self, msg_type: str, payload: dict[str, Any], admins_only: bool = False
@@ -233,6 +375,7 @@ class WebSocketManager:
 
         Args:
             msg_type: Message type string (e.g. "dashboard_panel_update").
+                Also the queue policy key.
             payload: Message payload dict.
             admins_only: Skip non-admin connections. Needed for payloads that a
                 REST route would gate behind is_privileged() - without it the
@@ -246,36 +389,9 @@ class WebSocketManager:
                 for the next reader.
 
         Returns:
-            Number of connections the message was sent to.
+            Number of connections the message was queued for.
         """
-        sent_count = 0
-        async with self._lock:
-            for user_id, connections in list(self._user_connections.items()):
-                disconnected = []
-
-                for conn in connections:
-                    if admins_only and not conn.is_admin:
-                        continue
-                    try:
-                        await conn.websocket.send_json({
-                            "type": msg_type,
-                            "payload": payload,
-                        })
-                        sent_count += 1
-                    except Exception as e:
-                        logger.warning(f"Failed to broadcast to user {user_id}: {e}")
-                        disconnected.append(conn)
-
-                # Clean up disconnected connections
-                for conn in disconnected:
-                    if conn in connections:
-                        connections.remove(conn)
-
-                if not connections and user_id in self._user_connections:
-                    del self._user_connections[user_id]
-                    self._admin_users.discard(user_id)
-
-        return sent_count
+        return self._fan_out(msg_type, payload, admins_only=admins_only)
 
     async def send_unread_count(self, user_id: int, count: int) -> int:
         """Send updated unread count to a user's connections.
@@ -285,30 +401,50 @@ class WebSocketManager:
             count: Unread notification count
 
         Returns:
-            Number of connections the message was sent to
+            Number of connections the message was queued for
         """
-        sent_count = 0
-        async with self._lock:
-            connections = self._user_connections.get(user_id, [])
-            disconnected = []
-
-            for conn in connections:
-                try:
-                    await conn.websocket.send_json({
-                        "type": "unread_count",
-                        "payload": {"count": count},
-                    })
-                    sent_count += 1
-                except Exception as e:
-                    logger.warning(f"Failed to send unread count to user {user_id}: {e}")
-                    disconnected.append(conn)
-
-            # Clean up disconnected connections
-            for conn in disconnected:
-                if conn in connections:
-                    connections.remove(conn)
-
-        return sent_count
+        return self._fan_out("unread_count", {"count": count}, user_id=user_id)
+
+    async def drain(self, timeout: float = 5.0) -> bool:
+        """Wait until every local send queue is empty.
+
+        Returns:
+            False if the timeout expired first
+        """
+        waits = [
+            c._idle.wait() for conns in self._user_connections.values() for c in conns
+        ]
+        if not waits:
+            return True
+        try:
+            await asyncio.wait_for(asyncio.gather(*waits), timeout)
+            return True
+        except asyncio.TimeoutError:
+            return False
+
+    # ------------------------------------------------------------------
+    # Lifecycle
+    # ------------------------------------------------------------------
+
+    def start_bus(self, bus: Optional[WebSocketBus] = None) -> bool:
+        """Join the cross-worker bus (needs a running event loop)."""
+        if self._bus is not None and self._bus.running:
+            return True
+        self._bus = bus or WebSocketBus(self._deliver_remote)
+        if not self._bus.start():
+            self._bus = None
+            return False
+        return True
+
+    async def shutdown(self, timeout: float = 2.0) -> None:
+        """Leave the bus, flush pending frames briefly and stop writer tasks."""
+        if self._bus is not None:
+            self._bus.stop()
+            self._bus = None
+        await self.drain(timeout)
+        for conns in list(self._user_connections.values()):
+            for conn in list(conns):
+                await conn.shutdown()
 
     def get_connected_user_ids(self) -> list[int]:
         """Get list of all connected user IDs.
@@ -362,7 +498,8 @@ def get_websocket_manager() -> WebSocketManager:
 def init_websocket_manager() -> WebSocketManager:
     """Initialize the WebSocket manager.
 
-    Should be called during application startup.
+    Should be called during application startup (inside the event loop, so it
+    can join the cross-worker bus).
 
     Returns:
         WebSocketManager instance
@@ -374,5 +511,6 @@ def init_websocket_manager() -> WebSocketManager:
     notification_service = get_notification_service()
     notification_service.set_websocket_manager(manager)
 
-    logger.info("WebSocket manager initialized")
+    joined = manager.start_bus()
+    logger.info(f"WebSocket manager initialized (cross-worker bus {'on' if joined else 'off'})")
     return manager
@@ -45,6 +45,11 @@ async def async_main() -> int:
     from app.services.monitoring.shm import cleanup_shm
     cleanup_shm()
 
+    # Users, API keys and shares changed here must reach the web workers'
+    # auth decision caches (this process caches nothing itself)
+    from app.core.decision_cache import get_decision_cache
+    get_decision_cache().enable_invalidation()
+
     # Create and start the worker
     from app.services.monitoring.worker_service import MonitoringWorker
     worker = MonitoringWorker()
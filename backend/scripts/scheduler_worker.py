@@ -8,7 +8,8 @@ not block the main Uvicorn web worker.
 
 IPC is done via the shared database:
   - Web API creates SchedulerExecution rows with status='requested'
-  - This worker polls for them and executes the corresponding job
+  - This worker picks them up (NOTIFY on PostgreSQL, polling on SQLite)
+    and runs them in its resource-aware job pool
   - Heartbeat + state written to scheduler_state table
 
 Usage:
@@ -36,6 +37,11 @@ def main() -> int:
     from app.core.database import init_db, SessionLocal
     init_db()
 
+    # Users, API keys and shares changed here must reach the web workers'
+    # auth decision caches (this process caches nothing itself)
+    from app.core.decision_cache import get_decision_cache
+    get_decision_cache().enable_invalidation()
+
     # Initialize Firebase so notification_check and emit_scheduler_failed_sync
     # can send push notifications from this process.
     from app.services.notifications.firebase import FirebaseService
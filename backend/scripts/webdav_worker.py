@@ -34,6 +34,11 @@ def main() -> int:
     from app.core.database import init_db
     init_db()
 
+    # Users, API keys and shares changed here must reach the web workers'
+    # auth decision caches (this process caches nothing itself)
+    from app.core.decision_cache import get_decision_cache
+    get_decision_cache().enable_invalidation()
+
     # Create and start the worker
     from app.services.webdav_service import WebdavWorker
     worker = WebdavWorker()
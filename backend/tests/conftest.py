@@ -181,6 +181,32 @@ def db_session() -> Generator[Session, None, None]:
         # Drop all tables
         Base.metadata.drop_all(bind=engine)
 
+        # The SSD cache hot index and hit counters are derived from this
+        # database but live in shared memory / process state; drop them too.
+        from app.services.cache.access_stats import get_access_stats
+        from app.services.cache import admission, hot_index
+        if hot_index._index is not None:
+            hot_index._index.clear_if_dirty()
+        if admission._sketch is not None:
+            admission._sketch.clear_if_dirty()
+        get_access_stats().discard()
+
+
+@pytest.fixture(autouse=True)
+def isolated_metric_rings(tmp_path_factory):
+    """Give every test its own monitoring metric rings file.
+
+    Collectors and the smart-device poller publish into the process-wide
+    rings; without this a sample from one test would be served to the next.
+    """
+    from app.services.monitoring import shm_ring
+    rings = shm_ring.MetricRings(tmp_path_factory.getbasetemp() / f"metrics-{uuid4().hex}.ring")
+    previous, shm_ring._rings = shm_ring._rings, rings
+    yield rings
+    shm_ring._rings = previous
+    rings.close()
+    rings.path.unlink(missing_ok=True)
+
 
 @pytest.fixture(scope="function")
 def db(db_session: Session) -> Generator[Session, None, None]:
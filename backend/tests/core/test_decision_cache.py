@@ -0,0 +1,226 @@
+"""Tests for the auth decision cache (core/decision_cache.py).
+
+Tests:
+- Hits skip the loader; None is not cached; TTL and LRU bounds
+- A change during a load still invalidates the loaded value
+- Invalidation reaches another worker through the shared table, also from
+  processes that only publish (scheduler, monitoring, WebDAV workers)
+- ORM commits invalidate users, API keys and share grants
+- API key usage is written once per interval, not per request
+"""
+import pytest
+from sqlalchemy.orm import Session
+
+from app.api import deps
+from app.core import decision_cache
+from app.core.decision_cache import DecisionCache, GenerationTable
+from app.models.api_key import ApiKey
+from app.models.file_share import FileShare
+from app.models.user import User
+from app.services.api_key_service import ApiKeyService
+from app.services.files import access
+
+
+@pytest.fixture
+def cache(monkeypatch):
+    """An enabled cache with a process-local table, installed as the singleton."""
+    c = DecisionCache(ttl=60.0, max_entries=100)
+    c.enable(GenerationTable())
+    monkeypatch.setattr(decision_cache, "_cache", c)
+    yield c
+    c.disable()
+
+
+class Loader:
+    def __init__(self, value="v"):
+        self.value = value
+        self.calls = 0
+
+    def __call__(self):
+        self.calls += 1
+        return self.value
+
+
+class TestCache:
+    def test_hit_skips_loader(self, cache):
+        load = Loader()
+        assert cache.get_or_load("user", 1, load) == "v"
+        assert cache.get_or_load("user", "1", load) == "v"
+        assert load.calls == 1
+
+    def test_none_is_not_cached(self, cache):
+        load = Loader(None)
+        cache.get_or_load("user", 1, load)
+        cache.get_or_load("user", 1, load)
+        assert load.calls == 2
+
+    def test_disabled_cache_always_loads(self):
+        c = DecisionCache()
+        load = Loader()
+        c.get_or_load("user", 1, load)
+        c.get_or_load("user", 1, load)
+        assert load.calls == 2
+
+    def test_ttl_expires_entries(self, cache, monkeypatch):
+        load = Loader()
+        cache.get_or_load("user", 1, load)
+        now = decision_cache.time.monotonic()
+        monkeypatch.setattr(decision_cache.time, "monotonic", lambda: now + 61)
+
+        cache.get_or_load("user", 1, load)
+        assert load.calls == 2
+
+    def test_lru_is_bounded(self, cache):
+        for i in range(150):
+            cache.get_or_load("user", i, Loader())
+        assert cache.get_stats()["entries"] == 100
+
+    def test_change_during_load_invalidates(self, cache):
+        def racing_load():
+            cache.invalidate("user", 1)  # committed while the old row was read
+            return "stale"
+
+        cache.get_or_load("user", 1, racing_load)
+        assert cache.get_or_load("user", 1, Loader("fresh")) == "fresh"
+
+    def test_namespace_invalidation(self, cache):
+        cache.get_or_load("shares", 1, Loader())
+        cache.get_or_load("user", 1, Loader())
+        cache.invalidate("shares")
+
+        shares, users = Loader(), Loader()
+        cache.get_or_load("shares", 1, shares)
+        cache.get_or_load("user", 1, users)
+        assert (shares.calls, users.calls) == (1, 0)
+
+    def test_invalidation_reaches_other_workers(self, tmp_path):
+        path = tmp_path / "decision_cache.bin"
+        worker_a, worker_b = DecisionCache(), DecisionCache()
+        worker_a.table, worker_b.table = GenerationTable(path), GenerationTable(path)
+        try:
+            worker_a.get_or_load("user", 7, Loader("old"))
+            worker_b.invalidate("user", 7)
+            assert worker_a.get_or_load("user", 7, Loader("new")) == "new"
+        finally:
+            worker_a.table.close()
+            worker_b.table.close()
+
+    def test_invalidation_only_process_publishes(self, tmp_path):
+        path = tmp_path / "decision_cache.bin"
+        worker, scheduler = DecisionCache(), DecisionCache()
+        worker.table, published = GenerationTable(path), GenerationTable(path)
+        scheduler.enable_invalidation(published)
+        try:
+            worker.get_or_load("user", 7, Loader("old"))
+            load = Loader("new")
+            scheduler.get_or_load("user", 7, load)
+            scheduler.get_or_load("user", 7, load)
+            assert load.calls == 2  # caches nothing itself
+            scheduler.invalidate("user", 7)
+            assert worker.get_or_load("user", 7, Loader("new")) == "new"
+        finally:
+            worker.table.close()
+            published.close()
+            scheduler.disable()
+
+
+class TestOrmInvalidation:
+    def test_user_update_reloads(self, cache, db_session: Session, regular_user: User):
+        first = deps._resolve_active_user(regular_user.id, db_session)
+        assert first.role == "user"
+
+        regular_user.role = "admin"
+        db_session.commit()
+
+        assert deps._resolve_active_user(regular_user.id, db_session).role == "admin"
+
+    def test_deactivated_user_is_refused(self, cache, db_session: Session, regular_user: User):
+        assert deps._resolve_active_user(regular_user.id, db_session) is not None
+
+        regular_user.is_active = False
+        db_session.commit()
+
+        assert deps._resolve_active_user(regular_user.id, db_session) is None
+
+    def test_rolled_back_change_publishes_nothing(self, cache, db_session: Session, regular_user: User):
+        deps._resolve_active_user(regular_user.id, db_session)
+        before = cache.invalidations
+
+        regular_user.role = "admin"
+        db_session.flush()
+        db_session.rollback()
+
+        assert cache.invalidations == before
+
+    def test_deleted_api_key_is_refused(self, cache, db_session: Session, admin_user, regular_user):
+        api_key, raw = ApiKeyService.create_api_key(
+            db=db_session, name="cached", created_by_id=admin_user.id, target_user_id=regular_user.id,
+        )
+        grant = ApiKeyService.resolve_api_key(db_session, raw)
+        assert grant.target_user_id == regular_user.id
+
+        ApiKeyService.delete_api_key(db_session, api_key.id, admin_user.id)
+
+        assert ApiKeyService.resolve_api_key(db_session, raw) is None
+
+    def test_bulk_delete_invalidates_api_keys(self, cache, db_session: Session, admin_user, regular_user):
+        _, raw = ApiKeyService.create_api_key(
+            db=db_session, name="bulk", created_by_id=admin_user.id, target_user_id=regular_user.id,
+        )
+        assert ApiKeyService.resolve_api_key(db_session, raw) is not None
+
+        ApiKeyService.delete_all_for_user(db_session, regular_user.id)
+
+        assert ApiKeyService.resolve_api_key(db_session, raw) is None
+
+    def test_new_share_is_visible(self, cache, db_session: Session, sample_file_metadata, another_user):
+        path = f"{sample_file_metadata.path}"
+        assert not access.is_path_shared_with_user(db_session, path, another_user.id)
+
+        db_session.add(FileShare(
+            file_id=sample_file_metadata.id,
+            owner_id=sample_file_metadata.owner_id,
+            shared_with_user_id=another_user.id,
+            can_read=True,
+        ))
+        db_session.commit()
+
+        assert access.is_path_shared_with_user(db_session, path, another_user.id)
+        assert access.are_paths_shared_with_user_bulk(db_session, [path, "other.txt"], another_user.id) == {path}
+
+    def test_renamed_file_moves_its_grant(self, cache, db_session: Session, sample_file_metadata, another_user):
+        db_session.add(FileShare(
+            file_id=sample_file_metadata.id,
+            owner_id=sample_file_metadata.owner_id,
+            shared_with_user_id=another_user.id,
+            can_read=True,
+        ))
+        db_session.commit()
+        assert access.is_path_shared_with_user(db_session, "test_file.txt", another_user.id)
+
+        sample_file_metadata.path = "renamed.txt"
+        db_session.commit()
+
+        assert not access.is_path_shared_with_user(db_session, "test_file.txt", another_user.id)
+        assert access.is_path_shared_with_user(db_session, "renamed.txt", another_user.id)
+
+
+class TestApiKeyUsage:
+    def test_usage_is_written_once_per_interval(self, db_session: Session, admin_user, regular_user, monkeypatch):
+        from app.services import api_key_service
+
+        monkeypatch.setattr(api_key_service, "_usage", api_key_service._UsageBuffer())
+        api_key, raw = ApiKeyService.create_api_key(
+            db=db_session, name="usage", created_by_id=admin_user.id, target_user_id=regular_user.id,
+        )
+        grant = ApiKeyService.resolve_api_key(db_session, raw)
+
+        for _ in range(3):
+            ApiKeyService.record_grant_usage(db_session, grant, ip="10.0.0.5")
+        db_session.expire_all()
+        row = db_session.get(ApiKey, api_key.id)
+        assert (row.use_count, row.last_used_ip) == (1, "10.0.0.5")
+
+        assert ApiKeyService.flush_usage(db_session) == 1
+        db_session.expire_all()
+        assert db_session.get(ApiKey, api_key.id).use_count == 3
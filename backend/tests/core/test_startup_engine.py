@@ -0,0 +1,164 @@
+"""Dependency-ordered, concurrent startup (app/core/startup.py).
+
+Startup used to run every service one after another, so each worker answered
+only after the slowest hardware probe and plugin import. The engine starts
+independent steps together, defers the non-critical ones past the point the
+worker accepts requests, and records per-step timings.
+"""
+
+import asyncio
+
+import pytest
+from fastapi import FastAPI
+
+from app.core import lifespan, startup
+from app.core.startup import StartupEngine, StartupStep
+
+
+async def test_independent_steps_run_concurrently():
+    running = 0
+    peak = 0
+
+    async def _step():
+        nonlocal running, peak
+        running += 1
+        peak = max(peak, running)
+        await asyncio.sleep(0.05)
+        running -= 1
+
+    engine = StartupEngine([StartupStep(f"s{i}", _step) for i in range(3)])
+    await engine.run_blocking()
+
+    assert peak == 3
+
+
+async def test_a_step_waits_for_its_dependencies():
+    order: list[str] = []
+
+    async def _slow():
+        await asyncio.sleep(0.03)
+        order.append("database")
+
+    engine = StartupEngine([
+        StartupStep("users", lambda: order.append("users"), after=("database",)),
+        StartupStep("database", _slow),
+    ])
+    await engine.run_blocking()
+
+    assert order == ["database", "users"]
+
+
+async def test_thread_steps_do_not_block_the_loop():
+    import time
+
+    ticks = 0
+
+    async def _ticker():
+        nonlocal ticks
+        for _ in range(5):
+            await asyncio.sleep(0.01)
+            ticks += 1
+
+    engine = StartupEngine([
+        StartupStep("blocking_io", lambda: time.sleep(0.1), thread=True),
+        StartupStep("ticker", _ticker),
+    ])
+    await engine.run_blocking()
+
+    assert ticks == 5
+
+
+async def test_critical_failure_aborts_startup():
+    def _fail():
+        raise RuntimeError("database unreachable")
+
+    engine = StartupEngine([StartupStep("database", _fail, critical=True)])
+
+    with pytest.raises(RuntimeError, match="database unreachable"):
+        await engine.run_blocking()
+
+
+async def test_non_critical_failure_is_recorded_and_dependents_still_run():
+    ran: list[str] = []
+
+    def _fail():
+        raise RuntimeError("no fans")
+
+    engine = StartupEngine([
+        StartupStep("fan_control", _fail),
+        StartupStep("service_registry", lambda: ran.append("registry"), after=("fan_control",)),
+    ])
+    await engine.run_blocking()
+
+    assert ran == ["registry"]
+    steps = {s["name"]: s for s in engine.report()["steps"]}
+    assert steps["fan_control"]["status"] == "failed"
+    assert steps["fan_control"]["error"] == "no fans"
+    assert steps["service_registry"]["status"] == "ok"
+
+
+async def test_deferred_steps_run_after_serving_and_can_be_awaited():
+    release = asyncio.Event()
+
+    async def _plugins():
+        await release.wait()
+
+    engine = StartupEngine([
+        StartupStep("database", lambda: None),
+        StartupStep("plugins", _plugins, deferred=True),
+    ])
+    await engine.run_blocking()
+    assert engine.report()["ready_ms"] is not None
+    assert not engine.is_done("plugins")
+
+    engine.start_deferred()
+    assert await engine.wait_for("plugins", timeout=0.01) is False
+
+    release.set()
+    assert await engine.wait_for("plugins", timeout=1.0) is True
+    await engine.cancel_deferred()
+    assert engine.report()["deferred_done_ms"] is not None
+
+
+async def test_cancel_deferred_stops_unfinished_steps():
+    async def _forever():
+        await asyncio.Event().wait()
+
+    engine = StartupEngine([StartupStep("discovery", _forever, deferred=True)])
+    await engine.run_blocking()
+    engine.start_deferred()
+    await asyncio.sleep(0)
+
+    await engine.cancel_deferred()
+
+    assert engine.report()["steps"][0]["status"] == "cancelled"
+
+
+def test_graph_errors_are_rejected():
+    noop = lambda: None  # noqa: E731
+    with pytest.raises(ValueError, match="unknown"):
+        StartupEngine([StartupStep("a", noop, after=("missing",))])
+    with pytest.raises(ValueError, match="cycle"):
+        StartupEngine([StartupStep("a", noop, after=("b",)), StartupStep("b", noop, after=("a",))])
+    with pytest.raises(ValueError, match="cannot wait for deferred"):
+        StartupEngine([
+            StartupStep("plugins", noop, deferred=True),
+            StartupStep("routes", noop, after=("plugins",)),
+        ])
+
+
+async def test_wait_for_without_engine_is_a_no_op():
+    startup.set_startup_engine(None)
+
+    assert await startup.wait_for("plugins") is True
+
+
+def test_lifespan_graph_is_valid():
+    engine = StartupEngine(lifespan._startup_steps(FastAPI()))
+    steps = {s["name"]: s for s in engine.report()["steps"]}
+
+    # What a request may touch right away must be up before serving
+    for name in ("database", "admin_user", "home_directories", "notifications", "request_services"):
+        assert steps[name]["phase"] == "blocking"
+    for name in ("plugins", "power", "discovery", "service_registry"):
+        assert steps[name]["phase"] == "deferred"
@@ -0,0 +1,98 @@
+"""Tests for the shared token-bucket rate limiting (core/token_bucket.py).
+
+Tests:
+- Burst up to the limit, then refusal; refill over time
+- Two tables on one file (two workers) share their buckets
+- Full sets recycle idle buckets before busy ones
+- The slowapi limiters count through the token-bucket strategy
+"""
+import pytest
+from limits import parse
+
+from app.core import token_bucket
+from app.core.rate_limiter import SharedLimiter, limiter, user_limiter
+from app.core.token_bucket import TokenBucketRateLimiter, TokenBucketTable
+
+
+@pytest.fixture
+def clock(monkeypatch):
+    now = [1000.0]
+    monkeypatch.setattr(token_bucket.time, "monotonic", lambda: now[0])
+    return now
+
+
+class TestBuckets:
+    def test_burst_then_refuse_then_refill(self, clock):
+        table = TokenBucketTable()
+
+        results = [table.take("k", capacity=5, rate=5 / 60)[0] for _ in range(6)]
+        assert results == [True] * 5 + [False]
+
+        clock[0] += 12  # one token per 12 s
+        assert table.take("k", 5, 5 / 60)[0]
+        assert not table.take("k", 5, 5 / 60)[0]
+
+    def test_refill_is_capped_at_capacity(self, clock):
+        table = TokenBucketTable()
+        table.take("k", 3, 1.0)
+        clock[0] += 3600
+
+        assert table.take("k", 3, 1.0, consume=False)[1] == 3
+
+    def test_check_does_not_consume(self, clock):
+        table = TokenBucketTable()
+        for _ in range(3):
+            assert table.take("k", 1, 0.01, consume=False)[0]
+        assert table.take("k", 1, 0.01)[0]
+        assert not table.take("k", 1, 0.01, consume=False)[0]
+
+    def test_workers_share_one_file(self, tmp_path, clock):
+        path = tmp_path / "rate_limits.bin"
+        worker_a, worker_b = TokenBucketTable(path), TokenBucketTable(path)
+        try:
+            assert worker_a.take("ip:1", 2, 0.01)[0]
+            assert worker_b.take("ip:1", 2, 0.01)[0]
+            assert not worker_a.take("ip:1", 2, 0.01)[0]
+
+            worker_b.reset("ip:1")
+            assert worker_a.take("ip:1", 2, 0.01)[0]
+        finally:
+            worker_a.close()
+            worker_b.close()
+
+    def test_full_set_recycles_idle_bucket_first(self, clock, monkeypatch):
+        monkeypatch.setattr(token_bucket, "SETS", 1)
+        table = TokenBucketTable()
+        # Fill the only set: "busy" is drained, the others are idle again
+        for i in range(token_bucket.WAYS - 1):
+            table.take(f"idle{i}", 1, 1.0)
+        table.take("busy", 1, 0.0001)
+        clock[0] += 10
+
+        table.take("newcomer", 1, 1.0)
+
+        assert not table.take("busy", 1, 0.0001)[0]
+
+
+class TestLimiterIntegration:
+    def test_module_limiters_use_token_buckets(self):
+        for lim in (limiter, user_limiter):
+            assert isinstance(lim, SharedLimiter)
+            assert isinstance(lim._limiter, TokenBucketRateLimiter)
+        assert limiter._limiter.table is user_limiter._limiter.table
+        assert limiter._limiter.namespace != user_limiter._limiter.namespace
+
+    def test_strategy_speaks_the_limits_interface(self, clock):
+        strategy = TokenBucketRateLimiter(TokenBucketTable(), "ip")
+        item = parse("3/minute")
+
+        assert all(strategy.hit(item, "1.2.3.4", "/api/auth/login") for _ in range(3))
+        assert not strategy.hit(item, "1.2.3.4", "/api/auth/login")
+        assert strategy.hit(item, "5.6.7.8", "/api/auth/login")
+
+        reset_time, remaining = strategy.get_window_stats(item, "1.2.3.4", "/api/auth/login")
+        assert remaining == 0
+        assert reset_time > token_bucket.time.time()
+
+        strategy.clear(item, "1.2.3.4", "/api/auth/login")
+        assert strategy.test(item, "1.2.3.4", "/api/auth/login")
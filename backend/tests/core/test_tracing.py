@@ -0,0 +1,202 @@
+"""Tests for the latency histograms (core/tracing.py).
+
+Tests:
+- Log-linear buckets and their exact Prometheus export
+- Thread histograms merge; worker files sum across processes
+- Request timing middleware: route templates, DB queries per request, sampling
+- /api/metrics exposition of the collected series
+"""
+import threading
+
+import pytest
+from fastapi import FastAPI
+from fastapi.testclient import TestClient
+from prometheus_client import CollectorRegistry, generate_latest
+from sqlalchemy import create_engine, text
+from sqlalchemy.pool import StaticPool
+
+from app.core import tracing
+from app.core.tracing import Tracer, bucket_index, span, traced
+from app.middleware.request_timing import RequestTimingMiddleware
+
+
+@pytest.fixture
+def tracer(monkeypatch, tmp_path):
+    """An enabled tracer writing to a temp dir, installed as the singleton."""
+    t = Tracer(directory=tmp_path)
+    t.enabled = True
+    monkeypatch.setattr(tracing, "_tracer", t)
+    yield t
+    t.stop()
+
+
+def test_buckets_are_log_linear_with_bounded_error():
+    assert bucket_index(0.0) == 0
+    assert bucket_index(1e9) == tracing.BUCKETS - 1
+    previous = 0
+    value = 2.0 ** tracing.MIN_EXP
+    while value < 2.0 ** tracing.MAX_EXP:
+        index = bucket_index(value)
+        assert index >= previous
+        previous = index
+        value *= 1.07
+    # 1.0 and 1.2 s share a bucket (1/4 octave wide); 1.3 s does not
+    assert bucket_index(1.0) == bucket_index(1.2) != bucket_index(1.3)
+
+
+def test_export_bounds_count_values_exactly():
+    series = tracing.Series()
+    for seconds in (0.001, 0.0015, 0.0016, 0.4, 100.0):
+        series.buckets[bucket_index(seconds)] += 1
+
+    cumulative = dict(series.cumulative())
+
+    assert cumulative[1.5 * 2.0 ** -10] == 1  # 1.46 ms
+    assert cumulative[2.0 ** -9] == 3  # 1.95 ms
+    assert cumulative[2.0 ** 6] == 4
+    assert cumulative[float("inf")] == 5
+
+
+def test_thread_histograms_are_merged(tracer):
+    def work():
+        for _ in range(100):
+            tracer.record(("span", "work"), 0.002)
+
+    threads = [threading.Thread(target=work) for _ in range(4)]
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+
+    merged = tracer.snapshot()[("span", "work")]
+    assert merged.count == 400
+    assert merged.total == pytest.approx(0.8)
+
+
+def test_collect_sums_live_workers_and_archives_dead_ones(tracer, tmp_path, monkeypatch):
+    other = Tracer(directory=tmp_path, pid=tracer.pid + 1)
+    dead = Tracer(directory=tmp_path, pid=tracer.pid + 2)
+    for t in (tracer, other, dead):
+        t.record(("http", "GET /api/files/list"), 0.01, db_queries=3, db_seconds=0.004)
+    other.flush()
+    dead.flush()
+    monkeypatch.setattr(tracing, "_pid_alive", lambda pid: pid != dead.pid)
+
+    series = tracer.collect()[("http", "GET /api/files/list")]
+
+    # this worker (in memory) + the other one (file) + the dead one (archive)
+    assert series.count == 3
+    assert series.db_queries == 9
+    assert not dead._file.path.exists()
+    assert tracer.collect()[("http", "GET /api/files/list")].count == 3  # folded once
+    other.stop()
+    dead.stop()
+
+
+def test_stopped_worker_totals_are_kept(tracer, tmp_path):
+    other = Tracer(directory=tmp_path, pid=tracer.pid + 1)
+    other.record(("db", "SELECT"), 0.001)
+    other.flush()
+    other.record(("db", "SELECT"), 0.001)  # after the last flush
+
+    other.stop()
+
+    assert not (tmp_path / f"{other.prefix}-{other.pid}.bin").exists()
+    assert tracer.collect()[("db", "SELECT")].count == 2
+
+
+def test_reused_pid_does_not_truncate_a_dead_workers_file(tracer, tmp_path):
+    first = Tracer(directory=tmp_path, pid=tracer.pid + 1)
+    first.record(("db", "SELECT"), 0.001)
+    first.flush()
+    first._file.close(unlink=False)  # killed: file left behind
+
+    second = Tracer(directory=tmp_path, pid=first.pid)
+    second.record(("db", "SELECT"), 0.001)
+    second.flush()
+
+    assert tracer.collect()[("db", "SELECT")].count == 2
+    second.stop()
+
+
+def test_flush_only_rewrites_changed_series(tracer):
+    tracer.record(("db", "SELECT"), 0.001)
+    tracer.flush()
+    seq = tracer._file._seq
+    tracer.flush()
+    assert tracer._file._seq == seq
+    tracer.record(("db", "SELECT"), 0.001)
+    tracer.flush()
+    assert tracer._file._seq == seq + 2
+
+
+def _app(engine) -> FastAPI:
+    app = FastAPI()
+
+    @traced("lookup")
+    def lookup(item_id: int) -> int:
+        with engine.connect() as conn:
+            return conn.execute(text("SELECT :v"), {"v": item_id}).scalar()
+
+    @app.get("/items/{item_id}")
+    def get_item(item_id: int):
+        with span("outer"):
+            return {"value": lookup(item_id)}
+
+    app.add_middleware(RequestTimingMiddleware)
+    return app
+
+
+@pytest.fixture
+def engine():
+    e = create_engine("sqlite://", poolclass=StaticPool, connect_args={"check_same_thread": False})
+    tracing.instrument_engine(e)
+    yield e
+    e.dispose()
+
+
+def test_requests_are_recorded_by_route_template_with_db_totals(tracer, engine):
+    client = TestClient(_app(engine))
+    for item_id in (1, 2, 3):
+        assert client.get(f"/items/{item_id}").json() == {"value": item_id}
+    client.get("/nope")
+
+    series = tracer.snapshot()
+    route = series[("http", "GET /items/{item_id}")]
+    assert route.count == 3
+    assert route.db_queries == 3
+    assert series[("http", "GET unmatched")].count == 1
+    assert series[("span", "lookup")].count == 3
+    assert series[("span", "outer")].count == 3
+    assert series[("db", "SELECT")].count == 3
+
+
+def test_unsampled_requests_only_record_route_latency(tracer, engine):
+    tracer.sample_rate = 0.0
+    TestClient(_app(engine)).get("/items/1")
+
+    series = tracer.snapshot()
+    assert series[("http", "GET /items/{item_id}")].db_queries == 0
+    assert set(series) == {("http", "GET /items/{item_id}")}
+
+
+def test_disabled_tracer_records_nothing(tracer, engine):
+    tracer.enabled = False
+    TestClient(_app(engine)).get("/items/1")
+
+    assert tracer.snapshot() == {}
+
+
+def test_metrics_exposition(tracer):
+    from app.api.routes.metrics import LatencyCollector
+
+    tracer.record(("http", "GET /api/files/list"), 0.003, db_queries=2, db_seconds=0.001)
+    tracer.record(("span", "create_version"), 0.2)
+    registry = CollectorRegistry()
+    registry.register(LatencyCollector())
+
+    output = generate_latest(registry).decode()
+
+    assert 'baluhost_http_request_duration_seconds_count{endpoint="/api/files/list",method="GET"} 1.0' in output
+    assert 'baluhost_http_request_db_queries_total{endpoint="/api/files/list",method="GET"} 2.0' in output
+    assert 'baluhost_span_duration_seconds_bucket{le="+Inf",span="create_version"} 1.0' in output
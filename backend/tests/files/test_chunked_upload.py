@@ -8,8 +8,11 @@ Covers:
 - Session completion
 - Session abort and cleanup
 - Stale session cleanup
+- Parallel (out-of-order) chunk mode
+- Bounded streaming pipeline
 """
 
+import os
 import pytest
 import asyncio
 from datetime import datetime, timedelta, timezone
@@ -386,3 +389,234 @@ async def test_write_chunk_stream_rejects_overflow(tmp_path, monkeypatch):
     with pytest.raises(ValueError, match="exceeds declared total_size"):
         await mgr.write_chunk_stream(session.upload_id, 0, _stream(b"AA", b"BB"))
     assert mgr.get_session(session.upload_id) is None
+
+
+# ============================================================================
+# Parallel (out-of-order) mode
+# ============================================================================
+
+class TestParallelMode:
+    """Out-of-order / concurrent chunk ingestion with positional writes."""
+
+    @staticmethod
+    async def _session(mgr, payload: bytes, chunk_size: int):
+        return await mgr.create_session(
+            target_path="uploads", filename="big.bin", total_size=len(payload),
+            user_id=1, username="testuser", chunk_size=chunk_size, parallel=True,
+        )
+
+    @staticmethod
+    def _chunks(payload: bytes, chunk_size: int) -> list[bytes]:
+        return [payload[i:i + chunk_size] for i in range(0, len(payload), chunk_size)]
+
+    @pytest.mark.asyncio
+    async def test_temp_file_preallocated(self, manager):
+        session = await self._session(manager, b"x" * 10, 4)
+        assert session.temp_file_path.stat().st_size == 10
+        assert session.total_chunks == 3
+        assert session.missing_chunks() == [0, 1, 2]
+
+    @pytest.mark.asyncio
+    async def test_out_of_order_chunks_produce_correct_file_and_hash(self, manager):
+        import hashlib
+        payload = bytes(range(256)) * 5  # 1280 bytes
+        session = await self._session(manager, payload, 100)
+        chunks = self._chunks(payload, 100)
+
+        for idx in [5, 12, 0, 3, 1, 2, 11, 4, 10, 6, 9, 8, 7]:
+            await manager.write_chunk(session.upload_id, idx, chunks[idx])
+
+        temp_path, sha256_hex = await manager.complete_session(session.upload_id)
+        assert temp_path.read_bytes() == payload
+        assert sha256_hex == hashlib.sha256(payload).hexdigest()
+
+    @pytest.mark.asyncio
+    async def test_concurrent_chunks(self, manager):
+        import hashlib
+        payload = b"".join(bytes([i]) * 64 for i in range(16))
+        session = await self._session(manager, payload, 64)
+        chunks = self._chunks(payload, 64)
+
+        await asyncio.gather(*(
+            manager.write_chunk(session.upload_id, i, c) for i, c in enumerate(chunks)
+        ))
+
+        _, sha256_hex = await manager.complete_session(session.upload_id)
+        assert sha256_hex == hashlib.sha256(payload).hexdigest()
+
+    @pytest.mark.asyncio
+    async def test_stream_variant(self, manager):
+        import hashlib
+
+        async def _stream(data: bytes):
+            for i in range(0, len(data), 3):
+                yield data[i:i + 3]
+
+        payload = b"abcdefghij"
+        session = await self._session(manager, payload, 4)
+        for idx, chunk in reversed(list(enumerate(self._chunks(payload, 4)))):
+            await manager.write_chunk_stream(session.upload_id, idx, _stream(chunk))
+
+        temp_path, sha256_hex = await manager.complete_session(session.upload_id)
+        assert temp_path.read_bytes() == payload
+        assert sha256_hex == hashlib.sha256(payload).hexdigest()
+
+    @pytest.mark.asyncio
+    async def test_chunk_digest_recorded(self, manager):
+        import hashlib
+        session = await self._session(manager, b"aaaabbbb", 4)
+        await manager.write_chunk(session.upload_id, 1, b"bbbb")
+        assert session.chunk_digests[1] == hashlib.sha256(b"bbbb").hexdigest()
+
+    @pytest.mark.asyncio
+    async def test_duplicate_chunk_is_idempotent(self, manager):
+        session = await self._session(manager, b"aaaabbbb", 4)
+        await manager.write_chunk(session.upload_id, 0, b"aaaa")
+        received = await manager.write_chunk(session.upload_id, 0, b"aaaa")
+        assert received == 4
+
+    @pytest.mark.asyncio
+    async def test_complete_with_missing_chunks_keeps_session(self, manager):
+        session = await self._session(manager, b"aaaabbbbcc", 4)
+        await manager.write_chunk(session.upload_id, 0, b"aaaa")
+        await manager.write_chunk(session.upload_id, 2, b"cc")
+
+        with pytest.raises(ValueError, match="1 chunk\\(s\\) missing"):
+            await manager.complete_session(session.upload_id)
+        assert manager.get_session(session.upload_id) is not None
+        assert session.missing_chunks() == [1]
+
+    @pytest.mark.asyncio
+    async def test_wrong_chunk_length_rejected(self, manager):
+        session = await self._session(manager, b"aaaabbbb", 4)
+        with pytest.raises(ValueError, match="must be 4 bytes"):
+            await manager.write_chunk(session.upload_id, 0, b"aaa")
+        assert manager.get_session(session.upload_id) is not None
+
+    @pytest.mark.asyncio
+    async def test_index_out_of_range_rejected(self, manager):
+        session = await self._session(manager, b"aaaabbbb", 4)
+        with pytest.raises(ValueError, match="out of range"):
+            await manager.write_chunk(session.upload_id, 2, b"cccc")
+
+    @pytest.mark.asyncio
+    async def test_oversized_last_chunk_aborts(self, manager):
+        session = await self._session(manager, b"aaaabb", 4)
+        with pytest.raises(ValueError, match="exceeds declared total_size"):
+            await manager.write_chunk(session.upload_id, 1, b"bbbb")
+        assert manager.get_session(session.upload_id) is None
+
+
+# ============================================================================
+# Bounded streaming pipeline
+# ============================================================================
+
+class TestStreamingPipeline:
+    """write_chunk_stream packs fragments into a small buffer ring."""
+
+    @staticmethod
+    async def _fragments(data: bytes, size: int, fail_after: int | None = None):
+        sent = 0
+        for i in range(0, len(data), size):
+            if fail_after is not None and sent >= fail_after:
+                raise ConnectionError("client disconnected")
+            yield data[i:i + size]
+            sent += size
+
+    @pytest.mark.asyncio
+    async def test_fragments_cross_buffer_boundaries(self, manager):
+        import hashlib
+        manager.STREAM_BUFFER_SIZE = 7
+        manager.STREAM_BUFFER_COUNT = 2
+        payload = bytes(range(200)) * 3
+        session = await manager.create_session(
+            target_path="uploads", filename="s.bin", total_size=len(payload),
+            user_id=1, username="testuser",
+        )
+
+        await manager.write_chunk_stream(session.upload_id, 0, self._fragments(payload[:300], 13))
+        await manager.write_chunk_stream(session.upload_id, 1, self._fragments(payload[300:], 5))
+
+        temp_path, sha256_hex = await manager.complete_session(session.upload_id)
+        assert temp_path.read_bytes() == payload
+        assert sha256_hex == hashlib.sha256(payload).hexdigest()
+
+    @pytest.mark.asyncio
+    async def test_disconnect_truncates_and_allows_retry(self, manager):
+        import hashlib
+        manager.STREAM_BUFFER_SIZE = 4
+        payload = b"0123456789abcdef"
+        session = await manager.create_session(
+            target_path="uploads", filename="s.bin", total_size=len(payload),
+            user_id=1, username="testuser",
+        )
+        await manager.write_chunk_stream(session.upload_id, 0, self._fragments(payload[:8], 3))
+
+        with pytest.raises(ConnectionError):
+            await manager.write_chunk_stream(
+                session.upload_id, 1, self._fragments(payload[8:], 3, fail_after=6),
+            )
+        assert session.temp_file_path.stat().st_size == 8
+        assert session.next_chunk_index == 1
+
+        await manager.write_chunk_stream(session.upload_id, 1, self._fragments(payload[8:], 3))
+        temp_path, sha256_hex = await manager.complete_session(session.upload_id)
+        assert temp_path.read_bytes() == payload
+        assert sha256_hex == hashlib.sha256(payload).hexdigest()
+
+    @pytest.mark.asyncio
+    async def test_overflow_detected_incrementally(self, manager):
+        consumed = []
+
+        async def _endless():
+            while True:
+                consumed.append(1)
+                yield b"x" * 10
+
+        session = await manager.create_session(
+            target_path="uploads", filename="s.bin", total_size=25,
+            user_id=1, username="testuser",
+        )
+        with pytest.raises(ValueError, match="exceeds declared total_size"):
+            await manager.write_chunk_stream(session.upload_id, 0, _endless())
+        assert len(consumed) == 3
+
+    @pytest.mark.asyncio
+    async def test_concurrent_sequential_chunk_rejected(self, manager):
+        gate = asyncio.Event()
+
+        async def _slow():
+            yield b"ab"
+            await gate.wait()
+            yield b"cd"
+
+        session = await manager.create_session(
+            target_path="uploads", filename="s.bin", total_size=8,
+            user_id=1, username="testuser",
+        )
+        first = asyncio.create_task(manager.write_chunk_stream(session.upload_id, 0, _slow()))
+        await asyncio.sleep(0.01)
+        with pytest.raises(ValueError, match="already being written"):
+            await manager.write_chunk_stream(session.upload_id, 0, self._fragments(b"abcd", 2))
+        gate.set()
+        assert await first == 4
+
+    @pytest.mark.asyncio
+    async def test_parallel_stream_hashes_frontier_without_readback(self, manager, monkeypatch):
+        import hashlib
+        payload = b"aaaabbbbcccc"
+        session = await manager.create_session(
+            target_path="uploads", filename="p.bin", total_size=len(payload),
+            user_id=1, username="testuser", chunk_size=4, parallel=True,
+        )
+        reads = []
+        real_pread = os.pread
+        monkeypatch.setattr(os, "pread", lambda *a: reads.append(a) or real_pread(*a))
+
+        for idx in range(3):
+            chunk = payload[idx * 4:(idx + 1) * 4]
+            await manager.write_chunk_stream(session.upload_id, idx, self._fragments(chunk, 3))
+
+        _, sha256_hex = await manager.complete_session(session.upload_id)
+        assert sha256_hex == hashlib.sha256(payload).hexdigest()
+        assert reads == []
@@ -0,0 +1,152 @@
+"""Tests for keyset-paginated and streamed directory listings."""
+import json
+import os
+
+import pytest
+
+import app.services.files.operations as file_ops
+import app.services.files.path_utils as path_utils
+from app.models.user import User
+from app.schemas.user import UserPublic
+from app.services import users as user_service
+from app.services.files import listing
+from app.services.files.listing import (
+    InvalidCursorError,
+    iter_directory_pages,
+    list_directory_page,
+    open_directory_listing,
+)
+
+
+@pytest.fixture(autouse=True)
+def _patch_session_local(db_session, monkeypatch):
+    from sqlalchemy.orm import sessionmaker
+    TestSessionLocal = sessionmaker(autocommit=False, autoflush=False, bind=db_session.get_bind())
+    monkeypatch.setattr("app.core.database.SessionLocal", TestSessionLocal)
+    monkeypatch.setattr("app.services.files.metadata_db.SessionLocal", TestSessionLocal)
+    monkeypatch.setattr("app.services.files.ownership.SessionLocal", TestSessionLocal)
+
+
+@pytest.fixture
+def storage_root(tmp_path, monkeypatch):
+    storage = tmp_path / "storage"
+    storage.mkdir()
+    monkeypatch.setattr(path_utils, "ROOT_DIR", storage)
+    monkeypatch.setattr(file_ops, "ROOT_DIR", storage)
+    return storage
+
+
+@pytest.fixture
+def admin_public(admin_user: User) -> UserPublic:
+    return user_service.serialize_user(admin_user)
+
+
+@pytest.fixture
+def big_dir(storage_root):
+    d = storage_root / "photos"
+    d.mkdir()
+    for i in range(25):
+        (d / f"IMG_{i:04d}.jpg").write_bytes(b"x" * (i + 1))
+        os.utime(d / f"IMG_{i:04d}.jpg", (1_000_000 + i, 1_000_000 + i))
+    for name in ("albums", "Raw"):
+        (d / name).mkdir()
+    return d
+
+
+def _all_pages(user, db, **kwargs):
+    names, cursor = [], None
+    while True:
+        items, cursor = list_directory_page("photos", user, db, cursor=cursor, **kwargs)
+        names.extend(item.name for item in items)
+        if cursor is None:
+            return names
+
+
+class TestListDirectoryPage:
+    def test_pages_match_full_listing(self, big_dir, db_session, admin_public):
+        full = [i.name for i in file_ops.list_directory("photos", user=admin_public, db=db_session)]
+        assert _all_pages(admin_public, db_session, limit=7) == full
+
+    def test_directories_first(self, big_dir, db_session, admin_public):
+        items, cursor = list_directory_page("photos", admin_public, db_session, limit=3)
+        assert [i.name for i in items] == ["albums", "Raw", "IMG_0000.jpg"]
+        assert cursor is not None
+
+    def test_sort_by_size_desc(self, big_dir, db_session, admin_public):
+        names = _all_pages(admin_public, db_session, limit=10, sort="size", order="desc",
+                           entry_type="file")
+        assert names[0] == "IMG_0024.jpg" and names[-1] == "IMG_0000.jpg"
+        assert len(names) == 25
+
+    def test_sort_by_modified(self, big_dir, db_session, admin_public):
+        items, _ = list_directory_page("photos", admin_public, db_session, limit=2,
+                                       sort="modified", entry_type="file")
+        assert [i.name for i in items] == ["IMG_0000.jpg", "IMG_0001.jpg"]
+
+    def test_name_filter(self, big_dir, db_session, admin_public):
+        items, cursor = list_directory_page("photos", admin_public, db_session, query="img_001")
+        assert sorted(i.name for i in items) == [f"IMG_001{i}.jpg" for i in range(10)]
+        assert cursor is None
+
+    def test_cursor_survives_inserts(self, big_dir, db_session, admin_public):
+        items, cursor = list_directory_page("photos", admin_public, db_session, limit=5)
+        (big_dir / "AAA_new.jpg").write_bytes(b"new")  # sorts before the cursor
+        more, _ = list_directory_page("photos", admin_public, db_session, limit=5, cursor=cursor)
+        assert more[0].name == "IMG_0003.jpg"
+
+    def test_cursor_bound_to_sort(self, big_dir, db_session, admin_public):
+        _, cursor = list_directory_page("photos", admin_public, db_session, limit=5)
+        with pytest.raises(InvalidCursorError):
+            list_directory_page("photos", admin_public, db_session, cursor=cursor, sort="size")
+        with pytest.raises(InvalidCursorError):
+            list_directory_page("photos", admin_public, db_session, cursor="not-a-cursor")
+
+    def test_only_page_is_built(self, big_dir, db_session, admin_public, monkeypatch):
+        built = []
+        real = listing._build_file_items
+
+        def _spy(entries, user, db):
+            built.append(len(entries))
+            return real(entries, user, db)
+
+        monkeypatch.setattr(listing, "_build_file_items", _spy)
+        list_directory_page("photos", admin_public, db_session, limit=4)
+        assert built == [4]
+
+    def test_iter_pages_respects_limit(self, big_dir, db_session, admin_public):
+        opened = open_directory_listing("photos", admin_public, db_session)
+        pages = list(iter_directory_pages(opened, admin_public, db_session, page_size=10, limit=15))
+        assert [len(items) for items, _ in pages] == [10, 5]
+        assert pages[-1][1] is not None
+
+    def test_missing_directory(self, storage_root, db_session, admin_public):
+        assert list_directory_page("nope", admin_public, db_session) == ([], None)
+
+
+class TestListRoutes:
+    def test_paginated_list(self, client, admin_headers, big_dir):
+        resp = client.get("/api/files/list", params={"path": "photos", "limit": 10}, headers=admin_headers)
+        assert resp.status_code == 200
+        body = resp.json()
+        assert len(body["files"]) == 10
+        assert body["total"] == 27
+        nxt = client.get(
+            "/api/files/list",
+            params={"path": "photos", "limit": 10, "cursor": body["next_cursor"]},
+            headers=admin_headers,
+        ).json()
+        assert nxt["files"][0]["name"] == "IMG_0008.jpg"
+
+    def test_bad_cursor(self, client, admin_headers, big_dir):
+        resp = client.get("/api/files/list", params={"path": "photos", "cursor": "zz"}, headers=admin_headers)
+        assert resp.status_code == 400
+
+    def test_stream_ndjson(self, client, admin_headers, big_dir):
+        resp = client.get("/api/files/list/stream", params={"path": "photos", "page_size": 4},
+                          headers=admin_headers)
+        assert resp.status_code == 200
+        assert resp.headers["content-type"].startswith("application/x-ndjson")
+        lines = [json.loads(line) for line in resp.text.splitlines()]
+        assert len(lines) == 28
+        assert lines[-1] == {"next_cursor": None, "total": 27}
+        assert lines[0]["name"] == "albums"
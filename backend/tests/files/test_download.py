@@ -0,0 +1,261 @@
+"""
+Tests for the download engine (services/files/download.py).
+
+Covers:
+- Range header parsing (single, suffix, open-ended, multi, coalescing, invalid)
+- Conditional GET (If-None-Match, If-Modified-Since, If-Match, If-Range)
+- ETag selection (stored SHA-256 vs weak mtime/size validator)
+- Response bodies for 200 / 206 single-range / 206 multipart / 304 / 416
+- X-Accel-Redirect hand-off to nginx
+"""
+
+import asyncio
+import email.utils
+import os
+from datetime import datetime, timedelta, timezone
+
+import pytest
+
+from app.services.files import download
+from app.services.files.download import (
+    build_download_response,
+    evaluate_preconditions,
+    if_range_allows,
+    is_initial_request,
+    make_etag,
+    parse_range_header,
+)
+
+
+def _run(response, method="GET", extensions=None):
+    """Drive an ASGI response and return (status, headers, body)."""
+    messages = []
+
+    async def _send(message):
+        messages.append(message)
+
+    async def _receive():
+        return {"type": "http.request"}
+
+    scope = {"type": "http", "method": method, "extensions": extensions or {}}
+    asyncio.run(response(scope, _receive, _send))
+    start = messages[0]
+    headers = {k.decode(): v.decode() for k, v in start["headers"]}
+    body = b"".join(m.get("body", b"") for m in messages[1:] if m["type"] == "http.response.body")
+    return start["status"], headers, body
+
+
+@pytest.fixture
+def sample_file(tmp_path):
+    path = tmp_path / "video.mp4"
+    path.write_bytes(bytes(range(256)) * 4)  # 1024 bytes
+    return path
+
+
+# ============================================================================
+# Range parsing
+# ============================================================================
+
+class TestParseRange:
+    def test_absent_header(self):
+        assert parse_range_header(None, 100) is None
+
+    def test_single_range(self):
+        assert parse_range_header("bytes=0-9", 100) == [(0, 9)]
+
+    def test_open_ended(self):
+        assert parse_range_header("bytes=90-", 100) == [(90, 99)]
+
+    def test_suffix(self):
+        assert parse_range_header("bytes=-10", 100) == [(90, 99)]
+
+    def test_suffix_longer_than_file(self):
+        assert parse_range_header("bytes=-500", 100) == [(0, 99)]
+
+    def test_last_clamped(self):
+        assert parse_range_header("bytes=50-1000", 100) == [(50, 99)]
+
+    def test_multi_range_sorted_and_coalesced(self):
+        assert parse_range_header("bytes=50-59, 0-9, 5-20, 21-30", 100) == [(0, 30), (50, 59)]
+
+    def test_unsatisfiable(self):
+        assert parse_range_header("bytes=200-300", 100) == []
+
+    def test_malformed_is_ignored(self):
+        assert parse_range_header("bytes=abc", 100) is None
+        assert parse_range_header("bytes=9-1", 100) is None
+        assert parse_range_header("items=0-1", 100) is None
+
+    def test_too_many_ranges_ignored(self):
+        spec = ",".join(f"{i * 2}-{i * 2}" for i in range(download.MAX_RANGES + 1))
+        assert parse_range_header(f"bytes={spec}", 1000) is None
+
+
+# ============================================================================
+# Validators / preconditions
+# ============================================================================
+
+class TestPreconditions:
+    def test_checksum_etag_when_metadata_current(self, sample_file):
+        st = sample_file.stat()
+        written = datetime.fromtimestamp(st.st_mtime, tz=timezone.utc)
+        assert make_etag(st, "abc", st.st_size, written) == '"abc"'
+
+    def test_weak_etag_when_metadata_stale(self, sample_file):
+        st = sample_file.stat()
+        old = datetime.fromtimestamp(st.st_mtime, tz=timezone.utc) - timedelta(minutes=5)
+        assert make_etag(st, "abc", st.st_size, old).startswith('W/"')
+        assert make_etag(st, "abc", st.st_size + 1, datetime.now(timezone.utc)).startswith('W/"')
+
+    def test_if_none_match_hit(self):
+        assert evaluate_preconditions({"if-none-match": '"x", "abc"'}, '"abc"', 0) == 304
+
+    def test_if_none_match_weak_comparison(self):
+        assert evaluate_preconditions({"if-none-match": 'W/"abc"'}, '"abc"', 0) == 304
+
+    def test_if_none_match_miss(self):
+        assert evaluate_preconditions({"if-none-match": '"nope"'}, '"abc"', 0) is None
+
+    def test_if_none_match_overrides_if_modified_since(self):
+        headers = {
+            "if-none-match": '"nope"',
+            "if-modified-since": email.utils.formatdate(10_000, usegmt=True),
+        }
+        assert evaluate_preconditions(headers, '"abc"', 5_000) is None
+
+    def test_if_modified_since(self):
+        headers = {"if-modified-since": email.utils.formatdate(10_000, usegmt=True)}
+        assert evaluate_preconditions(headers, '"abc"', 9_999.5) == 304
+        assert evaluate_preconditions(headers, '"abc"', 10_001) is None
+
+    def test_if_match_failure(self):
+        assert evaluate_preconditions({"if-match": '"other"'}, '"abc"', 0) == 412
+
+    def test_if_range_etag(self):
+        assert if_range_allows({"if-range": '"abc"'}, '"abc"', 0)
+        assert not if_range_allows({"if-range": '"old"'}, '"abc"', 0)
+        assert not if_range_allows({"if-range": 'W/"abc"'}, 'W/"abc"', 0)
+
+    def test_if_range_date(self):
+        date = email.utils.formatdate(10_000, usegmt=True)
+        assert if_range_allows({"if-range": date}, '"abc"', 10_000.3)
+        assert not if_range_allows({"if-range": date}, '"abc"', 20_000)
+
+    def test_is_initial_request(self):
+        assert is_initial_request({})
+        assert is_initial_request({"range": "bytes=0-99"})
+        assert not is_initial_request({"range": "bytes=500-"})
+
+
+# ============================================================================
+# Responses
+# ============================================================================
+
+class TestResponses:
+    def test_full_body(self, sample_file):
+        status, headers, body = _run(build_download_response({}, sample_file, "video.mp4"))
+        assert status == 200
+        assert body == sample_file.read_bytes()
+        assert headers["content-length"] == "1024"
+        assert headers["accept-ranges"] == "bytes"
+        assert headers["content-type"] == "video/mp4"
+        assert 'filename="video.mp4"' in headers["content-disposition"]
+
+    def test_single_range(self, sample_file):
+        resp = build_download_response({"range": "bytes=10-19"}, sample_file, "video.mp4")
+        status, headers, body = _run(resp)
+        assert status == 206
+        assert body == sample_file.read_bytes()[10:20]
+        assert headers["content-range"] == "bytes 10-19/1024"
+        assert headers["content-length"] == "10"
+
+    def test_multi_range(self, sample_file):
+        data = sample_file.read_bytes()
+        resp = build_download_response({"range": "bytes=0-3,100-103"}, sample_file, "video.mp4")
+        status, headers, body = _run(resp)
+        assert status == 206
+        assert headers["content-type"].startswith("multipart/byteranges; boundary=")
+        boundary = headers["content-type"].split("boundary=")[1]
+        assert int(headers["content-length"]) == len(body)
+        assert f"--{boundary}--".encode() in body
+        assert b"Content-Range: bytes 0-3/1024\r\n\r\n" + data[0:4] in body
+        assert b"Content-Range: bytes 100-103/1024\r\n\r\n" + data[100:104] in body
+
+    def test_unsatisfiable_range(self, sample_file):
+        resp = build_download_response({"range": "bytes=5000-"}, sample_file, "video.mp4")
+        status, headers, _ = _run(resp)
+        assert status == 416
+        assert headers["content-range"] == "bytes */1024"
+
+    def test_not_modified(self, sample_file):
+        st = sample_file.stat()
+        written = datetime.fromtimestamp(st.st_mtime, tz=timezone.utc)
+        resp = build_download_response(
+            {"if-none-match": '"deadbeef"'}, sample_file, "video.mp4",
+            checksum="deadbeef", metadata_size=st.st_size, metadata_timestamp=written,
+        )
+        status, headers, body = _run(resp)
+        assert status == 304
+        assert headers["etag"] == '"deadbeef"'
+        assert body == b""
+
+    def test_validators_come_from_source_stat(self, sample_file, tmp_path):
+        cached = tmp_path / "cached-copy"
+        cached.write_bytes(sample_file.read_bytes())
+        os.utime(cached, (1, 1))
+        source_stat = sample_file.stat()
+
+        resp = build_download_response({}, cached, "video.mp4", source_stat=source_stat)
+        _, headers, body = _run(resp)
+        assert headers["etag"] == make_etag(source_stat)
+        assert body == sample_file.read_bytes()
+
+    def test_head_sends_no_body(self, sample_file):
+        resp = build_download_response({}, sample_file, "video.mp4", method="HEAD")
+        status, headers, body = _run(resp, method="HEAD")
+        assert status == 200
+        assert headers["content-length"] == "1024"
+        assert body == b""
+
+    def test_zerocopysend_extension_used(self, sample_file):
+        messages = []
+
+        async def _send(message):
+            messages.append(message)
+
+        resp = build_download_response({"range": "bytes=4-7"}, sample_file, "video.mp4")
+        scope = {"type": "http", "method": "GET", "extensions": {"http.response.zerocopysend": {}}}
+        asyncio.run(resp(scope, None, _send))
+        zc = [m for m in messages if m["type"] == "http.response.zerocopysend"]
+        assert len(zc) == 1
+        assert (zc[0]["offset"], zc[0]["count"]) == (4, 4)
+
+    def test_accel_redirect(self, sample_file, monkeypatch):
+        from app.services.files import path_utils
+
+        monkeypatch.setattr(download.settings, "download_accel_redirect_prefix", "/_baluhost_accel")
+        monkeypatch.setattr(path_utils, "ROOT_DIR", sample_file.parent.resolve())
+        resp = build_download_response({"range": "bytes=0-1"}, sample_file, "video.mp4")
+        assert resp.status_code == 200
+        assert resp.headers["x-accel-redirect"] == "/_baluhost_accel/storage/video.mp4"
+        # nginx sends (and checks) its own validators for the file
+        assert "etag" not in resp.headers and "last-modified" not in resp.headers
+
+    def test_accel_redirect_leaves_preconditions_to_nginx(self, sample_file, monkeypatch):
+        from app.services.files import path_utils
+
+        monkeypatch.setattr(download.settings, "download_accel_redirect_prefix", "/_baluhost_accel")
+        monkeypatch.setattr(path_utils, "ROOT_DIR", sample_file.parent.resolve())
+        resp = build_download_response({"if-match": '"nginx-etag"'}, sample_file, "video.mp4")
+        assert resp.status_code == 200
+        assert "x-accel-redirect" in resp.headers
+
+    def test_accel_redirect_only_below_served_roots(self, sample_file, monkeypatch):
+        from app.services.files import path_utils
+
+        monkeypatch.setattr(download.settings, "download_accel_redirect_prefix", "/_baluhost_accel")
+        monkeypatch.setattr(path_utils, "ROOT_DIR", sample_file.parent.resolve() / "storage")
+        resp = build_download_response({}, sample_file, "video.mp4")
+        assert "x-accel-redirect" not in resp.headers
+        status, _, body = _run(resp)
+        assert status == 200 and len(body) == 1024
@@ -0,0 +1,169 @@
+"""Tests for the file search index (services/files/search.py)."""
+from app.models.file_search import FileSearchEntry
+from app.models.file_share import FileShare
+from app.schemas.user import UserPublic
+from app.services import users as user_service
+from app.services.files import metadata_db, search
+from app.services.files.search import SearchQuery, extension_of, search_files
+from app.services.sync.progressive import ProgressiveSyncService
+
+
+def _public(user) -> UserPublic:
+    return user_service.serialize_user(user)
+
+
+def _paths(db, user, **query) -> list[str]:
+    return [hit.path for hit in search_files(db, _public(user), SearchQuery(entry_type="file", **query)).hits]
+
+
+def _create(db, path, owner, size=0, is_directory=False):
+    return metadata_db.create_metadata(
+        path, path.rsplit("/", 1)[-1], owner.id, size_bytes=size, is_directory=is_directory, db=db,
+    )
+
+
+class TestIndexMaintenance:
+    def test_metadata_hooks_keep_the_index_in_sync(self, db_session, regular_user):
+        _create(db_session, "docs/Report.PDF", regular_user, size=10)
+        metadata_db.update_metadata("docs/Report.PDF", size_bytes=20, db=db_session)
+        metadata_db.rename_metadata("docs/Report.PDF", "docs/Summary.pdf", "Summary.pdf", db=db_session)
+
+        entry = db_session.query(FileSearchEntry).filter(FileSearchEntry.path == "docs/Summary.pdf").one()
+        assert (entry.name_folded, entry.extension, entry.size_bytes) == ("summary.pdf", "pdf", 20)
+
+        metadata_db.delete_metadata("docs/Summary.pdf", db=db_session)
+        assert db_session.query(FileSearchEntry).filter(FileSearchEntry.path == "docs/Summary.pdf").count() == 0
+
+    def test_owner_change_moves_visibility(self, db_session, regular_user, another_user):
+        _create(db_session, "notes.txt", regular_user)
+        metadata_db.set_owner_id("notes.txt", another_user.id, db=db_session)
+
+        assert _paths(db_session, regular_user, text="notes") == []
+        assert _paths(db_session, another_user, text="notes") == ["notes.txt"]
+
+    def test_rebuild_restores_missing_rows_and_keeps_text(self, db_session, regular_user):
+        meta = _create(db_session, "a.md", regular_user)
+        search.set_content(db_session, meta.id, "quarterly numbers")
+        db_session.commit()
+        _create(db_session, "b.md", regular_user)
+        db_session.query(FileSearchEntry).filter(FileSearchEntry.path == "b.md").delete()
+        db_session.commit()
+
+        assert search.rebuild_index(db_session, batch_size=1) >= 2
+
+        assert _paths(db_session, regular_user, extensions=["md"]) == ["a.md", "b.md"]
+        assert _paths(db_session, regular_user, text="quarterly", content=True) == ["a.md"]
+
+    def test_modified_at_is_the_rows_timestamp(self, db_session, regular_user):
+        meta = _create(db_session, "t.txt", regular_user)
+        entry = db_session.query(FileSearchEntry).filter(FileSearchEntry.file_id == meta.id).one()
+        assert entry.modified_at == meta.created_at
+
+        metadata_db.update_metadata("t.txt", size_bytes=5, db=db_session)
+        db_session.refresh(meta)
+        db_session.refresh(entry)
+        assert entry.modified_at == meta.updated_at
+
+        search.rebuild_index(db_session)
+        rebuilt = db_session.query(FileSearchEntry).filter(FileSearchEntry.file_id == meta.id).one()
+        assert rebuilt.modified_at == meta.updated_at
+
+    def test_progressive_uploads_are_indexed(self, db_session, regular_user):
+        ProgressiveSyncService(db_session).start_chunked_upload(
+            user_id=regular_user.id, device_id="dev", file_path="big/video.mkv",
+            file_name="video.mkv", total_size=10,
+        )
+        db_session.commit()
+
+        assert _paths(db_session, regular_user, extensions=["mkv"]) == ["big/video.mkv"]
+
+    def test_home_rename_reindexes_descendants(self, db_session, regular_user):
+        home = regular_user.username
+        if metadata_db.get_metadata(home, db=db_session) is None:
+            _create(db_session, home, regular_user, is_directory=True)
+        _create(db_session, f"{home}/docs/plan.odt", regular_user)
+
+        user_service._rename_home_directory(home, "renamed", db=db_session)
+
+        db_session.expire_all()
+        assert _paths(db_session, regular_user, extensions=["odt"]) == ["renamed/docs/plan.odt"]
+
+    def test_extension_of(self):
+        assert extension_of("Movie.MKV") == "mkv"
+        assert extension_of(".bashrc") is None
+        assert extension_of("archive.tar.gz") == "gz"
+        assert extension_of("photos.d", is_directory=True) is None
+
+
+class TestQueries:
+    def test_prefix_contains_and_ranking(self, db_session, regular_user):
+        for path in ("holiday.jpg", "my holiday.jpg", "docs/holiday-plan.txt", "other.jpg"):
+            _create(db_session, path, regular_user)
+
+        assert _paths(db_session, regular_user, text="Holi", mode="prefix") == ["holiday.jpg", "docs/holiday-plan.txt"]
+        # Names starting with the query rank first, shorter names before longer
+        assert _paths(db_session, regular_user, text="holiday") == [
+            "holiday.jpg", "docs/holiday-plan.txt", "my holiday.jpg",
+        ]
+        assert _paths(db_session, regular_user, text="my jpg") == ["my holiday.jpg"]
+
+    def test_like_wildcards_are_literal(self, db_session, regular_user):
+        _create(db_session, "100%_done.txt", regular_user)
+        _create(db_session, "1000 done.txt", regular_user)
+
+        assert _paths(db_session, regular_user, text="100%_") == ["100%_done.txt"]
+
+    def test_attribute_filters(self, db_session, regular_user):
+        _create(db_session, "media/a.mkv", regular_user, size=5 << 30)
+        _create(db_session, "media/b.mkv", regular_user, size=10)
+        _create(db_session, "media/c.srt", regular_user, size=10)
+        _create(db_session, "other/d.mkv", regular_user, size=5 << 30)
+
+        assert _paths(db_session, regular_user, folder="media", extensions=[".MKV"]) == ["media/a.mkv", "media/b.mkv"]
+        assert _paths(db_session, regular_user, min_size=1 << 30, sort="name") == ["media/a.mkv", "other/d.mkv"]
+        assert _paths(db_session, regular_user, text="media", scope="path", max_size=100) == ["media/b.mkv", "media/c.srt"]
+
+    def test_pages_and_facets(self, db_session, regular_user):
+        for i in range(5):
+            _create(db_session, f"f{i}.log", regular_user, size=2 << 20)
+        _create(db_session, "f5.txt", regular_user)
+
+        first = search_files(db_session, _public(regular_user), SearchQuery(text="f", sort="name", limit=4, facets=True))
+        second = search_files(db_session, _public(regular_user), SearchQuery(text="f", sort="name", limit=4, offset=4))
+
+        assert first.has_more and not second.has_more
+        assert [h.path for h in first.hits + second.hits] == [f"f{i}.log" for i in range(5)] + ["f5.txt"]
+        assert first.facets["extension"] == {"log": 5, "txt": 1}
+        assert first.facets["size"] == {"<1MB": 1, "1MB-100MB": 5}
+        assert not first.facets["truncated"]
+
+
+class TestVisibility:
+    def test_users_see_own_shared_dir_and_granted_subtrees(self, db_session, regular_user, another_user, admin_user):
+        folder = _create(db_session, "anotheruser/projects", another_user, is_directory=True)
+        _create(db_session, "anotheruser/projects/plan.txt", another_user)
+        _create(db_session, "anotheruser/projects2/plan.txt", another_user)
+        _create(db_session, "anotheruser/private/plan.txt", another_user)
+        _create(db_session, "Shared/team/plan.txt", admin_user)
+        _create(db_session, "testuser/plan.txt", regular_user)
+        db_session.add(FileShare(
+            file_id=folder.id, owner_id=another_user.id, shared_with_user_id=regular_user.id, can_read=True,
+        ))
+        db_session.commit()
+
+        assert sorted(_paths(db_session, regular_user, text="plan")) == [
+            "Shared/team/plan.txt", "anotheruser/projects/plan.txt", "testuser/plan.txt",
+        ]
+        assert len(_paths(db_session, admin_user, text="plan")) == 5
+
+    def test_expired_share_is_not_visible(self, db_session, regular_user, another_user):
+        from datetime import datetime, timedelta, timezone
+
+        meta = _create(db_session, "anotheruser/old.txt", another_user)
+        db_session.add(FileShare(
+            file_id=meta.id, owner_id=another_user.id, shared_with_user_id=regular_user.id, can_read=True,
+            expires_at=datetime.now(timezone.utc) - timedelta(days=1),
+        ))
+        db_session.commit()
+
+        assert _paths(db_session, regular_user, text="old") == []
@@ -0,0 +1,270 @@
+"""Tests for the persistent folder-size index and its inotify watcher."""
+import os
+import shutil
+import time
+from pathlib import Path
+
+import pytest
+
+import app.services.files.path_utils as path_utils
+from app.services.files import folder_size
+from app.services.files.folder_size import FolderSizeIndex, _scan_size
+from app.services.files.folder_size_watcher import FolderSizeWatcher, inotify_available
+
+
+def _write(path: Path, size: int) -> None:
+    path.parent.mkdir(parents=True, exist_ok=True)
+    path.write_bytes(b"x" * size)
+
+
+@pytest.fixture
+def tree(tmp_path: Path) -> Path:
+    root = tmp_path / "storage"
+    _write(root / "a" / "f1", 100)
+    _write(root / "a" / "b" / "f2", 20)
+    _write(root / "a" / "b" / "c" / "f3", 3)
+    _write(root / "d" / "f4", 7)
+    _write(root / ".system" / "junk", 1000)
+    return root
+
+
+@pytest.fixture
+def index(tree: Path):
+    idx = FolderSizeIndex(
+        tree, tree / ".system" / "sizes.sqlite3", is_excluded=path_utils.is_system_directory,
+    )
+    yield idx
+    idx.close()
+
+
+def _assert_consistent(index: FolderSizeIndex) -> None:
+    """Every indexed row matches a fresh recursive scan."""
+    for rel in index.indexed_paths():
+        if rel:
+            assert index.get(index.root / rel) == _scan_size(index.root / rel), rel
+
+
+class TestIndex:
+    def test_lazy_build_records_subtree(self, index, tree):
+        assert index.get(tree / "a") == 123
+        assert set(index.indexed_paths()) == {"a", "a/b", "a/b/c"}
+        assert index.get(tree / "a" / "b") == 23
+
+    def test_answers_from_index(self, index, tree, monkeypatch):
+        index.get(tree / "a")
+        monkeypatch.setattr(folder_size, "_scan_direct", lambda p: pytest.fail("rescanned"))
+        assert index.get(tree / "a" / "b" / "c") == 3
+
+    def test_root_excludes_system_dirs(self, index, tree):
+        assert index.get(tree) == 130
+        assert not any(p.startswith(".system") for p in index.indexed_paths())
+
+    def test_touch_propagates_to_ancestors(self, index, tree):
+        index.get(tree)
+        _write(tree / "a" / "b" / "c" / "big", 1000)
+        index.touch(tree / "a" / "b" / "c")
+        assert index.get(tree / "a") == 1123
+        assert index.get(tree) == 1130
+        _assert_consistent(index)
+
+    def test_touch_new_directory_under_indexed_parent(self, index, tree):
+        index.get(tree / "a")
+        _write(tree / "a" / "new" / "deep" / "f", 50)
+        index.touch(tree / "a" / "new" / "deep")
+        assert index.get(tree / "a") == 173
+        assert "a/new/deep" in index.indexed_paths()
+        _assert_consistent(index)
+
+    def test_touch_deleted_directory(self, index, tree):
+        index.get(tree / "a")
+        shutil.rmtree(tree / "a" / "b")
+        index.touch(tree / "a" / "b")
+        assert index.get(tree / "a") == 100
+        assert set(index.indexed_paths()) == {"a"}
+
+    def test_touch_unindexed_is_noop(self, index, tree):
+        _write(tree / "d" / "f5", 5)
+        index.touch(tree / "d")
+        assert index.indexed_paths() == []
+
+    def test_file_delta_is_applied_without_scanning(self, index, tree, monkeypatch):
+        index.get(tree)
+        _write(tree / "a" / "b" / "c" / "big", 1000)
+        monkeypatch.setattr(folder_size, "_scan_direct", lambda p: pytest.fail("rescanned"))
+        assert index.apply_delta(tree / "a" / "b" / "c" / "big", 1000)
+        (tree / "a" / "f1").unlink()
+        assert index.apply_delta(tree / "a" / "f1", -100)
+        monkeypatch.undo()
+        assert index.get(tree / "a") == 1023
+        assert index.get(tree) == 1030
+        _assert_consistent(index)
+
+    def test_file_delta_in_new_directory_falls_back_to_rescan(self, index, tree):
+        index.get(tree / "a")
+        _write(tree / "a" / "new" / "f", 5)
+        _write(tree / "a" / "new" / "g", 6)
+        assert not index.apply_delta(tree / "a" / "new" / "f", 5)
+        index.touch(tree / "a" / "new")
+        assert index.get(tree / "a") == 134
+        _assert_consistent(index)
+
+    def test_file_delta_after_rescan_is_not_counted_twice(self, index, tree):
+        index.get(tree)
+        token = index.scan_token()
+        _write(tree / "d" / "new", 50)
+        index.touch(tree / "d")  # the watcher rescans before the writer reports
+        assert not index.apply_delta(tree / "d" / "new", 50, since=token)
+        index.touch(tree / "d")
+        assert index.get(tree / "d") == 57
+        assert index.get(tree) == 180
+        _assert_consistent(index)
+
+    def test_file_delta_after_older_rescan_is_applied(self, index, tree, monkeypatch):
+        index.get(tree)
+        index.touch(tree / "d")
+        token = index.scan_token()
+        _write(tree / "d" / "new", 50)
+        monkeypatch.setattr(folder_size, "_scan_direct", lambda p: pytest.fail("rescanned"))
+        assert index.apply_delta(tree / "d" / "new", 50, since=token)
+        monkeypatch.undo()
+        assert index.get(tree / "d") == 57
+        _assert_consistent(index)
+
+    def test_move_carries_rows(self, index, tree, monkeypatch):
+        index.get(tree)
+        (tree / "a" / "b").rename(tree / "d" / "b2")
+        index.move(tree / "a" / "b", tree / "d" / "b2")
+        index.touch(tree / "a")
+        index.touch(tree / "d")
+        assert index.get(tree / "a") == 100
+        assert index.get(tree / "d") == 30
+        assert index.get(tree / "d" / "b2" / "c") == 3
+        assert index.get(tree) == 130
+        _assert_consistent(index)
+
+    def test_shared_between_instances(self, index, tree):
+        index.get(tree / "a")
+        other = FolderSizeIndex(tree, index.db_path)
+        try:
+            _write(tree / "a" / "f9", 9)
+            other.touch(tree / "a")
+            assert index.get(tree / "a") == 132
+        finally:
+            other.close()
+
+    def test_get_many(self, index, tree):
+        sizes = index.get_many([tree / "a", tree / "d", tree / ".system"])
+        assert sizes == {tree / "a": 123, tree / "d": 7, tree / ".system": _scan_size(tree / ".system")}
+
+    def test_clear(self, index, tree):
+        index.get(tree / "a")
+        index.clear()
+        assert index.indexed_paths() == []
+
+
+class TestChangeLog:
+    def test_touch_move_and_clear_are_logged(self, index, tree):
+        cursor = index.change_cursor()
+        index.touch(tree / "d")  # logged even though nothing is indexed
+        index.get(tree)
+        (tree / "a" / "b").rename(tree / "d" / "b2")
+        index.move(tree / "a" / "b", tree / "d" / "b2")
+        index.clear()
+        cursor, changed = index.changes_since(cursor)
+        assert changed == ["d", "a/b", "d/b2", None]
+        assert index.changes_since(cursor) == (cursor, [])
+
+    def test_system_paths_are_not_logged(self, index, tree):
+        cursor = index.change_cursor()
+        index.touch(tree / ".system")
+        assert index.changes_since(cursor) == (cursor, [])
+
+    def test_pruned_log_reports_everything_changed(self, index, tree, monkeypatch):
+        monkeypatch.setattr(folder_size, "_CHANGE_LOG_KEEP", 10)
+        cursor = index.change_cursor()
+        for _ in range(1000):
+            index.touch(tree / "a")
+        newest, changed = index.changes_since(cursor)
+        assert changed is None
+        assert newest == index.change_cursor()
+
+    def test_recreated_index_reports_everything_changed(self, index, tree):
+        index.touch(tree / "a")
+        cursor = index.change_cursor()
+        index.close()
+        for suffix in ("", "-wal", "-shm"):
+            Path(f"{index.db_path}{suffix}").unlink(missing_ok=True)
+        assert index.changes_since(cursor) == (0, None)
+
+
+class TestModuleApi:
+    def test_follows_root_dir(self, tree, monkeypatch):
+        monkeypatch.setattr(path_utils, "ROOT_DIR", tree)
+        assert folder_size.get_folder_size(tree / "a") == 123
+        _write(tree / "a" / "b" / "more", 7)
+        folder_size.invalidate_folder_sizes_for_path(tree / "a" / "b", tree)
+        assert folder_size.get_folder_size(tree / "a") == 130
+        assert (tree / path_utils.SYSTEM_DIR_NAME / folder_size.INDEX_FILENAME).exists()
+
+    def test_batch_of_file_changes(self, tree, monkeypatch):
+        monkeypatch.setattr(path_utils, "ROOT_DIR", tree)
+        assert folder_size.get_folder_size(tree) == 130
+        _write(tree / "d" / "f4", 10)  # overwritten: 7 -> 10
+        _write(tree / "d" / "new" / "x", 4)
+        _write(tree / "d" / "new" / "y", 5)
+        folder_size.record_file_size_changes([
+            (tree / "d" / "f4", 3),
+            (tree / "d" / "new" / "x", 4),
+            (tree / "d" / "new" / "y", 5),
+        ])
+        assert folder_size.get_folder_size(tree / "d") == 19
+        assert folder_size.get_folder_size(tree) == 142
+
+    def test_batch_interleaved_with_rescan(self, tree, monkeypatch):
+        monkeypatch.setattr(path_utils, "ROOT_DIR", tree)
+        assert folder_size.get_folder_size(tree) == 130
+        token = folder_size.folder_size_token()
+        _write(tree / "a" / "up1", 10)
+        folder_size.invalidate_folder_sizes_for_path(tree / "a", tree)  # watcher, mid-batch
+        _write(tree / "a" / "up2", 20)
+        _write(tree / "d" / "up3", 30)
+        folder_size.record_file_size_changes([
+            (tree / "a" / "up1", 10),
+            (tree / "a" / "up2", 20),
+            (tree / "d" / "up3", 30),
+        ], since=token)
+        assert folder_size.get_folder_size(tree / "a") == 153
+        assert folder_size.get_folder_size(tree / "d") == 37
+        assert folder_size.get_folder_size(tree) == 190
+
+    def test_recreated_storage_tree(self, tree, monkeypatch):
+        monkeypatch.setattr(path_utils, "ROOT_DIR", tree)
+        assert folder_size.get_folder_size(tree / "a") == 123
+        shutil.rmtree(tree)
+        _write(tree / "a" / "f", 1)
+        assert folder_size.get_folder_size(tree / "a") == 1
+
+
+@pytest.mark.skipif(not inotify_available(), reason="inotify not available")
+class TestWatcher:
+    def test_external_write_updates_index(self, index, tree):
+        index.get(tree)
+        watcher = FolderSizeWatcher(index, debounce_seconds=0.05)
+        assert watcher.start()
+        try:
+            assert watcher.watch_count >= 4
+            _write(tree / "a" / "b" / "c" / "external", 500)
+            os.makedirs(tree / "d" / "fresh")
+            deadline = time.monotonic() + 5
+            while time.monotonic() < deadline and index.get(tree / "a") != 623:
+                time.sleep(0.05)
+            assert index.get(tree / "a") == 623
+            assert index.get(tree) == 630
+        finally:
+            watcher.stop()
+
+    def test_overflow_drops_index(self, index, tree):
+        index.get(tree)
+        watcher = FolderSizeWatcher(index)
+        watcher._overflow()
+        assert index.indexed_paths() == []
@@ -147,6 +147,57 @@ class TestTransferOwnership:
         assert updated_meta is not None
         assert updated_meta.owner_id == second_user.id
 
+    def test_transfer_is_journaled_for_both_owners(
+        self,
+        db_session: Session,
+        user_with_file: tuple[User, FileMetadata, Path],
+        second_user: User,
+        storage_root: Path,
+        monkeypatch,
+    ):
+        """Sync clients of both owners learn about a transferred directory."""
+        from app.models.sync_state import SyncChange
+
+        monkeypatch.setattr(ownership, "ROOT_DIR", storage_root)
+        old_owner, _, _ = user_with_file
+        (storage_root / old_owner.username / "docs").mkdir()
+        (storage_root / old_owner.username / "docs" / "a.txt").write_text("a")
+        for rel, is_dir in (("docs", True), ("docs/a.txt", False)):
+            file_metadata_db.create_metadata(
+                relative_path=f"{old_owner.username}/{rel}",
+                name=Path(rel).name,
+                owner_id=old_owner.id,
+                is_directory=is_dir,
+                db=db_session,
+            )
+        (storage_root / second_user.username).mkdir(parents=True, exist_ok=True)
+        if not file_metadata_db.get_metadata(second_user.username, db=db_session):
+            file_metadata_db.create_metadata(
+                relative_path=second_user.username,
+                name=second_user.username,
+                owner_id=second_user.id,
+                is_directory=True,
+                db=db_session,
+            )
+        before = db_session.query(SyncChange.id).count()
+
+        result = ownership.transfer_ownership(
+            path=f"{old_owner.username}/docs",
+            new_owner_id=second_user.id,
+            requesting_user_id=old_owner.id,
+            requesting_user_is_admin=False,
+            db=db_session,
+        )
+
+        assert result.success
+        rows = db_session.query(SyncChange).order_by(SyncChange.id).offset(before).all()
+        entries = {(r.owner_id, r.action, r.path) for r in rows}
+        assert entries == {
+            (old_owner.id, "delete", f"{old_owner.username}/docs"),
+            (second_user.id, "upsert", f"{second_user.username}/docs"),
+            (second_user.id, "upsert", f"{second_user.username}/docs/a.txt"),
+        }
+
     def test_transfer_same_owner_noop(
         self,
         db_session: Session,
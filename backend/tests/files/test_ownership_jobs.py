@@ -0,0 +1,301 @@
+"""
+Tests for set-based subtree rewrites and bulk (batched, resumable) ownership transfers.
+"""
+from pathlib import Path
+
+import pytest
+from sqlalchemy.orm import Session, sessionmaker
+
+from app.models.file_metadata import FileMetadata
+from app.models.file_search import FileSearchEntry
+from app.models.user import User
+from app.services.files import metadata_db as file_metadata_db
+from app.services.files import ownership, ownership_jobs
+
+
+@pytest.fixture
+def second_user(db_session: Session) -> User:
+    user = User(
+        username="seconduser",
+        email="second@test.com",
+        hashed_password="hashed",
+        role="user",
+        is_active=True,
+    )
+    db_session.add(user)
+    db_session.commit()
+    db_session.refresh(user)
+    return user
+
+
+@pytest.fixture
+def storage_root(tmp_path: Path, monkeypatch) -> Path:
+    monkeypatch.setattr(ownership, "ROOT_DIR", tmp_path)
+    return tmp_path
+
+
+@pytest.fixture
+def job_sessions(db_session: Session, monkeypatch) -> None:
+    """Background jobs open their own sessions on the test database."""
+    factory = sessionmaker(autocommit=False, autoflush=False, bind=db_session.get_bind())
+    monkeypatch.setattr(ownership_jobs, "SessionLocal", factory)
+
+
+def _ensure_home(db: Session, root: Path, user: User) -> None:
+    (root / user.username).mkdir(parents=True, exist_ok=True)
+    if not file_metadata_db.get_metadata(user.username, db=db):
+        file_metadata_db.create_metadata(
+            relative_path=user.username,
+            name=user.username,
+            owner_id=user.id,
+            is_directory=True,
+            db=db,
+        )
+
+
+def _make_tree(db: Session, root: Path, owner: User, files: int) -> str:
+    """``<owner>/Project`` with a ``sub`` directory and *files* files spread over both."""
+    base = f"{owner.username}/Project"
+    (root / base / "sub").mkdir(parents=True)
+    for rel, is_dir in ((base, True), (f"{base}/sub", True)):
+        file_metadata_db.create_metadata(
+            relative_path=rel, name=Path(rel).name, owner_id=owner.id,
+            is_directory=is_dir, db=db,
+        )
+    for i in range(files):
+        rel = f"{base}/sub/f{i}.txt" if i % 2 else f"{base}/f{i}.txt"
+        (root / rel).write_text("x")
+        file_metadata_db.create_metadata(
+            relative_path=rel, name=Path(rel).name, owner_id=owner.id,
+            size_bytes=1, is_directory=False, db=db,
+        )
+    return base
+
+
+def _paths_owned_by(db: Session, user: User) -> set[str]:
+    db.expire_all()
+    return {
+        path for (path,) in db.query(FileMetadata.path).filter(FileMetadata.owner_id == user.id)
+    }
+
+
+class TestSetBasedTransfer:
+    def test_subtree_paths_parents_and_index_rewritten(
+        self, db_session: Session, regular_user: User, second_user: User, storage_root: Path
+    ):
+        _ensure_home(db_session, storage_root, regular_user)
+        _ensure_home(db_session, storage_root, second_user)
+        base = _make_tree(db_session, storage_root, regular_user, files=4)
+
+        result = ownership.transfer_ownership(
+            path=base,
+            new_owner_id=second_user.id,
+            requesting_user_id=regular_user.id,
+            requesting_user_is_admin=False,
+            db=db_session,
+        )
+
+        assert result.success
+        assert result.transferred_count == 6
+        db_session.expire_all()
+        child = file_metadata_db.get_metadata("seconduser/Project/sub/f1.txt", db=db_session)
+        assert child is not None
+        assert child.owner_id == second_user.id
+        assert child.parent_path == "seconduser/Project/sub"
+        sub = file_metadata_db.get_metadata("seconduser/Project/sub", db=db_session)
+        assert sub is not None and sub.parent_path == "seconduser/Project"
+        entry = db_session.get(FileSearchEntry, child.id)
+        assert entry is not None
+        assert entry.path == "seconduser/Project/sub/f1.txt"
+        assert entry.path_folded == "seconduser/project/sub/f1.txt"
+        assert entry.owner_id == second_user.id
+        assert (storage_root / "seconduser/Project/sub/f1.txt").exists()
+
+    def test_like_wildcards_in_path_are_literal(
+        self, db_session: Session, regular_user: User, second_user: User, storage_root: Path
+    ):
+        """``Pro_ect/%`` must not match the sibling ``ProXect/``."""
+        _ensure_home(db_session, storage_root, regular_user)
+        _ensure_home(db_session, storage_root, second_user)
+        home = regular_user.username
+        (storage_root / home / "Pro_ect").mkdir()
+        for rel, is_dir in ((f"{home}/Pro_ect", True), (f"{home}/Pro_ect/a.txt", False),
+                            (f"{home}/ProXect/keep.txt", False)):
+            file_metadata_db.create_metadata(
+                relative_path=rel, name=Path(rel).name, owner_id=regular_user.id,
+                is_directory=is_dir, db=db_session,
+            )
+
+        result = ownership.transfer_ownership(
+            path=f"{home}/Pro_ect",
+            new_owner_id=second_user.id,
+            requesting_user_id=regular_user.id,
+            requesting_user_is_admin=False,
+            db=db_session,
+        )
+
+        assert result.transferred_count == 2
+        assert f"{home}/ProXect/keep.txt" in _paths_owned_by(db_session, regular_user)
+
+
+class TestResidencyScan:
+    def test_username_prefix_is_not_home(
+        self, db_session: Session, regular_user: User, second_user: User, storage_root: Path
+    ):
+        """A file in ``seconduser2/`` is a violation for ``seconduser``."""
+        file_metadata_db.create_metadata(
+            relative_path="seconduser2/file.txt", name="file.txt",
+            owner_id=second_user.id, db=db_session,
+        )
+        file_metadata_db.create_metadata(
+            relative_path="seconduser/ok.txt", name="ok.txt",
+            owner_id=second_user.id, db=db_session,
+        )
+
+        violations = ownership.scan_residency_violations(db=db_session, scope="seconduser")
+
+        assert [v.path for v in violations] == ["seconduser2/file.txt"]
+        assert violations[0].actual_directory == "seconduser2"
+
+    def test_scan_pages_through_all_rows(
+        self, db_session: Session, regular_user: User, second_user: User, storage_root: Path
+    ):
+        for i in range(7):
+            file_metadata_db.create_metadata(
+                relative_path=f"{regular_user.username}/stray{i}.txt", name=f"stray{i}.txt",
+                owner_id=second_user.id, db=db_session,
+            )
+
+        violations = list(ownership.iter_residency_violations(db_session, batch_size=3))
+
+        assert len(violations) == 7
+
+
+class TestBulkTransfer:
+    def _start(self, db: Session, base: str, old: User, new: User, batch_size: int):
+        return ownership_jobs.start_bulk_transfer(
+            path=base,
+            new_owner_id=new.id,
+            requesting_user_id=old.id,
+            requesting_user_is_admin=False,
+            db=db,
+            batch_size=batch_size,
+        )
+
+    def test_small_tree_transfers_inline(
+        self, db_session: Session, regular_user: User, second_user: User, storage_root: Path
+    ):
+        _ensure_home(db_session, storage_root, regular_user)
+        _ensure_home(db_session, storage_root, second_user)
+        base = _make_tree(db_session, storage_root, regular_user, files=2)
+
+        result, job = self._start(db_session, base, regular_user, second_user, batch_size=100)
+
+        assert job is None
+        assert result.success
+        assert result.transferred_count == 4
+
+    def test_batched_job_completes(
+        self, db_session: Session, regular_user: User, second_user: User,
+        storage_root: Path, job_sessions,
+    ):
+        _ensure_home(db_session, storage_root, regular_user)
+        _ensure_home(db_session, storage_root, second_user)
+        base = _make_tree(db_session, storage_root, regular_user, files=9)
+
+        result, job = self._start(db_session, base, regular_user, second_user, batch_size=3)
+        assert result.success and job is not None
+        assert job.total_items == 11
+
+        ownership_jobs.run_bulk_transfer(job.id, batch_size=3)
+
+        db_session.expire_all()
+        job = ownership_jobs.get_job(db_session, job.id)
+        assert job.status == "completed"
+        assert job.processed_items == 11
+        moved = _paths_owned_by(db_session, second_user)
+        assert "seconduser/Project" in moved
+        assert "seconduser/Project/sub/f7.txt" in moved
+        assert not any(p.startswith(f"{regular_user.username}/Project") for p in _paths_owned_by(db_session, regular_user))
+        assert (storage_root / "seconduser/Project/f8.txt").exists()
+
+    def test_interrupted_job_resumes_from_cursor(
+        self, db_session: Session, regular_user: User, second_user: User,
+        storage_root: Path, job_sessions, monkeypatch,
+    ):
+        _ensure_home(db_session, storage_root, regular_user)
+        _ensure_home(db_session, storage_root, second_user)
+        base = _make_tree(db_session, storage_root, regular_user, files=9)
+        _, job = self._start(db_session, base, regular_user, second_user, batch_size=3)
+        assert job is not None
+
+        real_next_batch = ownership_jobs._next_batch
+        calls = {"n": 0}
+
+        def flaky_next_batch(db, job, batch_size):
+            calls["n"] += 1
+            if calls["n"] == 2:
+                raise RuntimeError("worker killed")
+            return real_next_batch(db, job, batch_size)
+
+        monkeypatch.setattr(ownership_jobs, "_next_batch", flaky_next_batch)
+        ownership_jobs.run_bulk_transfer(job.id, batch_size=3)
+
+        db_session.expire_all()
+        failed = ownership_jobs.get_job(db_session, job.id)
+        assert failed.status == "failed"
+        assert failed.processed_items == 4  # root + first batch
+        cursor = failed.last_file_id
+
+        resumed = ownership_jobs.resume_job(db_session, job.id)
+        assert resumed is not None and resumed.status == "running"
+        ownership_jobs.run_bulk_transfer(job.id, batch_size=3)
+
+        db_session.expire_all()
+        done = ownership_jobs.get_job(db_session, job.id)
+        assert done.status == "completed"
+        assert done.processed_items == 11
+        assert done.last_file_id > cursor
+        assert len([p for p in _paths_owned_by(db_session, second_user) if p.startswith("seconduser/Project")]) == 11
+
+    def test_files_created_at_old_path_during_job_are_left_alone(
+        self, db_session: Session, regular_user: User, second_user: User,
+        storage_root: Path, job_sessions, monkeypatch,
+    ):
+        _ensure_home(db_session, storage_root, regular_user)
+        _ensure_home(db_session, storage_root, second_user)
+        base = _make_tree(db_session, storage_root, regular_user, files=9)
+        _, job = self._start(db_session, base, regular_user, second_user, batch_size=3)
+        assert job is not None
+
+        real_move_root = ownership_jobs._move_root
+
+        def move_root_then_upload(db, job):
+            real_move_root(db, job)
+            db.add(FileMetadata(
+                path=f"{base}/late.txt", name="late.txt", owner_id=regular_user.id,
+                size_bytes=1, is_directory=False,
+            ))
+            db.flush()
+
+        monkeypatch.setattr(ownership_jobs, "_move_root", move_root_then_upload)
+        ownership_jobs.run_bulk_transfer(job.id, batch_size=3)
+
+        db_session.expire_all()
+        assert ownership_jobs.get_job(db_session, job.id).processed_items == 11
+        assert f"{base}/late.txt" in _paths_owned_by(db_session, regular_user)
+        assert "seconduser/Project/late.txt" not in _paths_owned_by(db_session, second_user)
+
+    def test_overlapping_job_rejected(
+        self, db_session: Session, regular_user: User, second_user: User, storage_root: Path
+    ):
+        _ensure_home(db_session, storage_root, regular_user)
+        _ensure_home(db_session, storage_root, second_user)
+        base = _make_tree(db_session, storage_root, regular_user, files=9)
+        _, job = self._start(db_session, base, regular_user, second_user, batch_size=3)
+        assert job is not None
+
+        result, second = self._start(db_session, f"{base}/sub", regular_user, second_user, batch_size=1)
+
+        assert second is None
+        assert result.error == "TRANSFER_IN_PROGRESS"
@@ -0,0 +1,163 @@
+"""Tests for the batched audit writer (services/audit/writer.py).
+
+Tests:
+- Routine events are queued and written in batches; timestamps are kept
+- Security events and caller sessions stay synchronous
+- A full batch is written without waiting for the interval
+- Backpressure: a full queue makes the caller write synchronously
+- Failed batches are retried; stop() drains the queue
+"""
+import time
+from datetime import datetime, timedelta, timezone
+
+import pytest
+from sqlalchemy.orm import sessionmaker
+
+from app.models.audit_log import AuditLog
+from app.services.audit import logger_db, writer as audit_writer
+from app.services.audit.logger_db import AuditLoggerDB
+from app.services.audit.writer import AuditWriter
+
+
+def _wait_for(predicate, timeout=5.0):
+    deadline = time.monotonic() + timeout
+    while time.monotonic() < deadline:
+        if predicate():
+            return True
+        time.sleep(0.01)
+    return False
+
+
+@pytest.fixture
+def factory(db_session):
+    return sessionmaker(bind=db_session.get_bind())
+
+
+@pytest.fixture
+def writer(factory, monkeypatch):
+    """A started writer that only flushes on a full batch or stop()."""
+    w = AuditWriter(factory, batch_size=5, interval=60.0)
+    monkeypatch.setattr(logger_db, "get_audit_writer", lambda: w)
+    w.start()
+    yield w
+    w.stop(timeout=1.0)
+
+
+def _count(db_session):
+    db_session.expire_all()
+    return db_session.query(AuditLog).count()
+
+
+class TestBuffering:
+    def test_routine_event_is_queued_until_stop(self, writer, db_session):
+        before = datetime.now(timezone.utc)
+        result = AuditLoggerDB().log_file_access(user="alice", action="download", file_path="/a.txt")
+
+        assert result is None
+        assert writer.get_status()["queue_depth"] == 1
+        assert _count(db_session) == 0
+
+        assert writer.stop() == 1
+        row = db_session.query(AuditLog).one()
+        assert (row.event_type, row.user, row.action, row.resource) == (
+            "FILE_ACCESS", "alice", "download", "/a.txt",
+        )
+        # Stamped when logged, not when written
+        assert row.timestamp.replace(tzinfo=timezone.utc) >= before - timedelta(seconds=1)
+
+    def test_full_batch_is_written_without_waiting(self, writer, db_session):
+        audit = AuditLoggerDB()
+        for i in range(5):
+            audit.log_file_access(user="bob", action="upload", file_path=f"/f{i}")
+
+        assert _wait_for(lambda: writer.get_status()["written_total"] == 5)
+        assert _count(db_session) == 5
+        assert writer.get_status()["batches_total"] == 1
+
+    def test_security_event_is_synchronous(self, writer, db_session):
+        entry = AuditLoggerDB().log_security_event(action="login_attempt", user="eve")
+
+        assert entry is not None and entry.id is not None
+        assert writer.get_status()["enqueued_total"] == 0
+        assert _count(db_session) == 1
+
+    def test_caller_session_is_synchronous(self, writer, db_session):
+        entry = AuditLoggerDB().log_file_access(
+            user="carol", action="delete", file_path="/x", db=db_session,
+        )
+
+        assert entry is not None
+        assert writer.get_status()["enqueued_total"] == 0
+
+    def test_stopped_writer_writes_inline(self, factory, db_session, monkeypatch):
+        w = AuditWriter(factory)
+        monkeypatch.setattr(logger_db, "get_audit_writer", lambda: w)
+        monkeypatch.setattr("app.core.database.SessionLocal", factory)
+
+        entry = AuditLoggerDB().log_file_access(user="dave", action="read", file_path="/r")
+
+        assert entry is not None
+        assert _count(db_session) == 1
+
+
+class TestBackpressure:
+    def test_full_queue_falls_back_to_synchronous_write(self, factory, db_session, monkeypatch):
+        w = AuditWriter(factory, max_queue=2, batch_size=100, interval=60.0)
+        monkeypatch.setattr(logger_db, "get_audit_writer", lambda: w)
+        monkeypatch.setattr("app.core.database.SessionLocal", factory)
+        w.start()
+        try:
+            audit = AuditLoggerDB()
+            results = [
+                audit.log_file_access(user="u", action="read", file_path=f"/{i}") for i in range(3)
+            ]
+
+            assert results[:2] == [None, None]
+            assert results[2] is not None  # written by the caller
+            status = w.get_status()
+            assert (status["queue_depth"], status["overflow_sync_total"]) == (2, 1)
+            assert status["queue_high_water"] == 2
+        finally:
+            w.stop()
+        assert _count(db_session) == 3
+
+    def test_failed_batch_is_retried(self, factory, db_session, monkeypatch):
+        w = AuditWriter(factory, batch_size=100, interval=60.0)
+        w.start()
+        real = audit_writer.write_rows
+        calls = []
+
+        def flaky(rows, session_factory=None):
+            calls.append(len(rows))
+            if len(calls) == 1:
+                raise RuntimeError("database is locked")
+            real(rows, session_factory)
+
+        monkeypatch.setattr(audit_writer, "write_rows", flaky)
+        try:
+            for i in range(3):
+                assert w.submit({
+                    "timestamp": datetime.now(timezone.utc), "event_type": "SYNC", "user": "u",
+                    "action": f"a{i}", "resource": None, "success": True, "error_message": None,
+                    "details": None, "ip_address": None, "user_agent": None,
+                })
+
+            assert w.flush() == -1
+            status = w.get_status()
+            assert (status["queue_depth"], status["error_count"]) == (3, 1)
+            assert status["last_error"] == "database is locked"
+
+            assert w.flush() == 3
+        finally:
+            w.stop()
+
+        db_session.expire_all()
+        assert [r.action for r in db_session.query(AuditLog).order_by(AuditLog.id)] == ["a0", "a1", "a2"]
+
+    def test_submit_after_stop_is_refused(self, factory):
+        w = AuditWriter(factory)
+        w.start()
+        w.stop()
+
+        assert not w.submit({"event_type": "SYNC"})
+        assert not w.get_status()["is_running"]
@@ -0,0 +1,138 @@
+"""Tests for event-driven process tracking (proc_events.py + ProcessTracker event mode)."""
+import os
+import struct
+import subprocess
+import sys
+import threading
+
+import pytest
+
+from app.services.monitoring import proc_events
+from app.services.monitoring.proc_events import (
+    PROC_EVENT_EXEC,
+    PROC_EVENT_FORK,
+    ProcessWatcher,
+    parse_proc_events,
+    read_identity,
+    read_stat,
+)
+from app.services.monitoring.process_tracker import ProcessTracker
+
+linux_only = pytest.mark.skipif(not ProcessWatcher.supported(), reason="needs Linux pidfd")
+
+
+def _message(what: int, detail: bytes) -> bytes:
+    body = (
+        struct.pack("=IIIIHH", proc_events.CN_IDX_PROC, proc_events.CN_VAL_PROC, 0, 0, 16 + len(detail), 0)
+        + struct.pack("=IIQ", what, 0, 0)
+        + detail
+    )
+    return struct.pack("=IHHII", 16 + len(body), proc_events.NLMSG_DONE, 0, 0, 0) + body
+
+
+class TestParsing:
+    def test_fork_exec_and_thread_events(self):
+        data = (
+            _message(PROC_EVENT_FORK, struct.pack("=IIII", 10, 10, 11, 11))    # process fork
+            + _message(PROC_EVENT_FORK, struct.pack("=IIII", 10, 10, 12, 10))  # thread: skipped
+            + _message(PROC_EVENT_EXEC, struct.pack("=II", 11, 11))
+            + _message(0x80000000, struct.pack("=IIII", 11, 11, 0, 0))        # exit: pidfds handle it
+        )
+
+        assert list(parse_proc_events(data)) == [(PROC_EVENT_FORK, 11, 10), (PROC_EVENT_EXEC, 11, 0)]
+
+    def test_truncated_datagram_is_ignored(self):
+        data = _message(PROC_EVENT_EXEC, struct.pack("=II", 11, 11))
+        assert list(parse_proc_events(data[:-6])) == []
+
+    def test_stat_with_odd_comm(self, tmp_path, monkeypatch):
+        monkeypatch.setattr(proc_events, "PROC_ROOT", str(tmp_path))
+        (tmp_path / "42").mkdir()
+        fields = ["S", "1"] + ["0"] * 9 + ["150", "50"] + ["0"] * 8 + ["256"]
+        (tmp_path / "42" / "stat").write_text(f"42 (a) (b c) {' '.join(fields)} 0 0\n")
+        (tmp_path / "42" / "comm").write_text("Uvicorn\n")
+        (tmp_path / "42" / "cmdline").write_bytes(b"python\0-m\0uvicorn\0app.main\0")
+
+        stat = read_stat(42)
+
+        assert stat.status == "sleeping"
+        assert stat.cpu_seconds == pytest.approx(200 / os.sysconf("SC_CLK_TCK"))
+        assert stat.rss_bytes == 256 * os.sysconf("SC_PAGE_SIZE")
+        assert read_identity(42) == ("uvicorn", "python -m uvicorn app.main")
+        assert read_stat(43) is None
+
+
+@linux_only
+class TestWatcher:
+    def test_exit_is_reported_immediately(self):
+        child = subprocess.Popen([sys.executable, "-c", "import time; time.sleep(30)"])
+        exited = threading.Event()
+        reports = []
+
+        def on_exit(pid, name):
+            reports.append((pid, name))
+            exited.set()
+
+        watcher = ProcessWatcher(lambda pid: "sleeper" if pid == child.pid else None, on_exit)
+        try:
+            assert watcher.start()
+            assert watcher.tracked() == {child.pid: "sleeper"}
+
+            child.kill()
+
+            assert exited.wait(5)
+            assert reports == [(child.pid, "sleeper")]
+            assert watcher.tracked() == {}
+        finally:
+            watcher.stop()
+            child.wait()
+
+
+class _FakeWatcher:
+    source = "rescan"
+
+    def __init__(self, tracked):
+        self._tracked = tracked
+
+    def tracked(self):
+        return dict(self._tracked)
+
+
+@linux_only
+class TestTrackerEventMode:
+    def test_samples_read_only_tracked_pids(self):
+        tracker = ProcessTracker()
+        tracker._watcher = _FakeWatcher({os.getpid(): "baluhost-monitoring"})
+
+        samples = tracker.collect_samples()
+
+        assert [(s.process_name, s.pid) for s in samples] == [("baluhost-monitoring", os.getpid())]
+        assert samples[0].memory_mb > 0
+        assert tracker.tracking_mode == "rescan"
+
+    def test_exit_is_a_crash_before_the_next_sample(self):
+        tracker = ProcessTracker()
+        watcher = _FakeWatcher({os.getpid(): "baluhost-scheduler"})
+        tracker._watcher = watcher
+        tracker.collect_samples()
+
+        watcher._tracked = {}
+        tracker._on_process_exit(os.getpid(), "baluhost-scheduler")
+
+        crashes = tracker.detect_crashes()
+        assert [(c.process_name, c.is_alive) for c in crashes] == [("baluhost-scheduler", False)]
+        # Returned once by the next collect (for the DB), not duplicated
+        stopped = [s for s in tracker.collect_samples() if not s.is_alive]
+        assert len(stopped) == 1
+        assert tracker.collect_samples() == []
+
+    def test_exit_of_one_worker_keeps_the_unit_alive(self):
+        tracker = ProcessTracker()
+        watcher = _FakeWatcher({os.getpid(): "baluhost-backend", os.getppid(): "baluhost-backend"})
+        tracker._watcher = watcher
+        tracker.collect_samples()
+
+        watcher._tracked = {os.getpid(): "baluhost-backend"}
+        tracker._on_process_exit(os.getppid(), "baluhost-backend")
+
+        assert tracker.detect_crashes() == []
@@ -0,0 +1,187 @@
+"""
+Tests for monitoring rollup tiers.
+
+Tests:
+- Bucket alignment and p95
+- On-write aggregation into 1m/15m/1h buckets (per disk for disk I/O)
+- Merge of partially flushed buckets
+- Resolution selection by range and retention
+- Sample reconstruction for history endpoints
+- Retention (DELETE on SQLite) and partition bounds
+"""
+from datetime import datetime, timedelta, timezone
+
+from app.models.monitoring import MetricRollup15m, MetricRollup1h, MetricRollup1m
+from app.schemas.monitoring import CpuSampleSchema, DiskIoSampleSchema
+from app.services.monitoring import rollups
+from app.services.monitoring.rollups import RollupAggregator
+
+
+def _cpu(ts: datetime, usage: float) -> CpuSampleSchema:
+    return CpuSampleSchema(timestamp=ts, usage_percent=usage, frequency_mhz=None)
+
+
+def _disk(ts: datetime, name: str, read: float) -> DiskIoSampleSchema:
+    return DiskIoSampleSchema(
+        timestamp=ts, disk_name=name,
+        read_mbps=read, write_mbps=0.0, read_iops=0.0, write_iops=0.0,
+    )
+
+
+class TestBuckets:
+    """Pure helpers."""
+
+    def test_bucket_start_aligns_to_resolution(self):
+        ts = datetime(2026, 10, 14, 12, 34, 56, tzinfo=timezone.utc)
+
+        assert rollups.bucket_start(ts, 60) == datetime(2026, 10, 14, 12, 34)
+        assert rollups.bucket_start(ts, 900) == datetime(2026, 10, 14, 12, 30)
+        assert rollups.bucket_start(ts, 3600) == datetime(2026, 10, 14, 12, 0)
+
+    def test_percentile_95_nearest_rank(self):
+        assert rollups.percentile_95([5.0]) == 5.0
+        assert rollups.percentile_95([float(i) for i in range(1, 101)]) == 95.0
+        assert rollups.percentile_95([float(i) for i in range(1, 13)]) == 12.0
+
+    def test_partition_bounds(self):
+        assert rollups.partition_bounds(60, datetime(2026, 10, 14, 5)) == (
+            "p20261014", datetime(2026, 10, 14), datetime(2026, 10, 15),
+        )
+        assert rollups.partition_bounds(3600, datetime(2026, 12, 31, 23)) == (
+            "p202612", datetime(2026, 12, 1), datetime(2027, 1, 1),
+        )
+
+    def test_choose_resolution_by_range(self):
+        now = datetime.now(timezone.utc)
+
+        assert rollups.choose_resolution(now - timedelta(hours=6), max_points=1000) == 60
+        assert rollups.choose_resolution(now - timedelta(days=7), max_points=1000) == 900
+        assert rollups.choose_resolution(now - timedelta(days=30), max_points=1000) == 3600
+        # Fewer points wanted -> coarser tier
+        assert rollups.choose_resolution(now - timedelta(hours=6), max_points=100) == 900
+
+    def test_choose_resolution_skips_expired_tiers(self, monkeypatch):
+        monkeypatch.setattr(rollups.settings, "monitoring_rollup_retention_days_1m", 1)
+        now = datetime.now(timezone.utc)
+
+        assert rollups.choose_resolution(now - timedelta(days=2), max_points=10000) == 900
+
+
+class TestAggregation:
+    """RollupAggregator against the test database."""
+
+    def test_flush_writes_only_closed_buckets(self, db_session):
+        agg = RollupAggregator()
+        base = datetime(2026, 10, 14, 12, 0, tzinfo=timezone.utc)
+        for i, usage in enumerate([10.0, 20.0, 30.0, 40.0]):
+            agg.add("cpu", _cpu(base + timedelta(seconds=15 * i), usage))
+
+        # Still inside the first minute: nothing closed
+        assert agg.flush(db_session, now=base + timedelta(seconds=59)) == 0
+
+        written = agg.flush(db_session, now=base + timedelta(minutes=1))
+        assert written == 1  # usage_percent 1m bucket (frequency_mhz is None)
+        row = db_session.query(MetricRollup1m).one()
+        assert (row.metric, row.series, row.field) == ("cpu", "", "usage_percent")
+        assert row.sample_count == 4
+        assert (row.value_min, row.value_max, row.value_sum, row.value_p95) == (10.0, 40.0, 100.0, 40.0)
+
+        # 15m and 1h buckets are still open
+        assert db_session.query(MetricRollup15m).count() == 0
+        assert agg.pending() == 2
+
+    def test_disks_are_separate_series(self, db_session):
+        agg = RollupAggregator()
+        ts = datetime(2026, 10, 14, 12, 0, tzinfo=timezone.utc)
+        agg.add("disk_io", _disk(ts, "sda", 5.0), series="sda")
+        agg.add("disk_io", _disk(ts, "nvme0n1", 50.0), series="nvme0n1")
+        agg.flush(db_session, now=ts + timedelta(hours=1))
+
+        rows = db_session.query(MetricRollup1h).filter_by(field="read_mbps").all()
+        assert {r.series: r.value_max for r in rows} == {"sda": 5.0, "nvme0n1": 50.0}
+
+    def test_partial_buckets_are_merged(self, db_session):
+        ts = datetime(2026, 10, 14, 12, 0, tzinfo=timezone.utc)
+
+        first = RollupAggregator()
+        first.add("cpu", _cpu(ts, 10.0))
+        first.flush(db_session, include_open=True)  # shutdown mid-hour
+
+        second = RollupAggregator()
+        second.add("cpu", _cpu(ts + timedelta(minutes=30), 90.0))
+        second.flush(db_session, now=ts + timedelta(hours=1))
+
+        row = db_session.query(MetricRollup1h).filter_by(field="usage_percent").one()
+        assert row.sample_count == 2
+        assert (row.value_min, row.value_max, row.value_sum) == (10.0, 90.0, 100.0)
+        assert row.value_p95 == 90.0
+
+    def test_failed_flush_keeps_buckets(self, db_session, monkeypatch):
+        agg = RollupAggregator()
+        ts = datetime(2026, 10, 14, 12, 0, tzinfo=timezone.utc)
+        agg.add("cpu", _cpu(ts, 10.0))
+
+        def boom(*args, **kwargs):
+            raise RuntimeError("db down")
+
+        monkeypatch.setattr(rollups, "_upsert", boom)
+        assert agg.flush(db_session, include_open=True) == 0
+        assert agg.pending() == 3
+
+
+class TestHistory:
+    """Reading rollups back."""
+
+    def test_history_samples_use_bucket_averages(self, db_session):
+        agg = RollupAggregator()
+        start = datetime.now(timezone.utc).replace(minute=0, second=0, microsecond=0) - timedelta(hours=3)
+        for minute in range(120):
+            agg.add("cpu", _cpu(start + timedelta(minutes=minute), float(minute % 2) * 100))
+        agg.flush(db_session, now=start + timedelta(hours=3))
+
+        resolution, by_series = rollups.history_samples(db_session, "cpu", start, max_points=10)
+        samples = by_series[""]
+        assert resolution == 3600
+        assert len(samples) == 2
+        assert all(s.usage_percent == 50.0 for s in samples)
+        assert samples[0].timestamp < samples[1].timestamp
+
+    def test_query_filters_field_and_series(self, db_session):
+        agg = RollupAggregator()
+        ts = datetime.now(timezone.utc) - timedelta(hours=2)
+        agg.add("disk_io", _disk(ts, "sda", 5.0), series="sda")
+        agg.add("disk_io", _disk(ts, "sdb", 7.0), series="sdb")
+        agg.flush(db_session)
+
+        resolution, rows = rollups.query_rollups(
+            db_session, "disk_io", ts - timedelta(hours=1),
+            fields=("read_mbps",), series="sdb", resolution=60,
+        )
+        assert resolution == 60
+        assert [(r.series, r.value_max) for r in rows] == [("sdb", 7.0)]
+
+
+class TestRetention:
+    """Tier retention (SQLite: DELETE)."""
+
+    def test_old_buckets_are_removed(self, db_session):
+        now = datetime(2026, 10, 14, tzinfo=timezone.utc)
+        agg = RollupAggregator()
+        agg.add("cpu", _cpu(now - timedelta(days=30), 1.0))
+        agg.add("cpu", _cpu(now - timedelta(hours=2), 2.0))
+        agg.flush(db_session, now=now)
+
+        results = rollups.apply_rollup_retention(db_session, now=now)
+
+        assert results["rollups_1m"] == 1  # 14 day retention
+        assert results["rollups_15m"] == 0
+        assert results["rollups_1h"] == 0
+        assert db_session.query(MetricRollup1m).count() == 1
+        assert db_session.query(MetricRollup1h).count() == 2
+
+    def test_run_all_cleanup_includes_rollups(self, db_session):
+        from app.services.monitoring.retention_manager import RetentionManager
+
+        results = RetentionManager().run_all_cleanup(db_session)
+
+        assert {"rollups_1m", "rollups_15m", "rollups_1h"} <= set(results)
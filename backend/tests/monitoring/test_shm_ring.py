@@ -0,0 +1,234 @@
+"""
+Tests for the binary monitoring sample rings (shm_ring).
+
+Tests:
+- Roundtrip of every metric kind through the mapped file
+- Ring wrap-around and history limits
+- Labelled rings (disks, power devices, network interface type)
+- Stale data and missing files degrade to "no data"
+- Single-writer lock
+- Orchestrator getters reading the rings
+"""
+import time
+from datetime import datetime, timedelta, timezone
+
+import pytest
+
+from app.schemas.monitoring import (
+    CpuSampleSchema,
+    DiskIoSampleSchema,
+    GpuSampleSchema,
+    MemorySampleSchema,
+    NetworkSampleSchema,
+)
+from app.services.monitoring.shm_ring import MAX_DISKS, SLOT_COUNT, MetricRings
+
+
+def _now():
+    return datetime.now(timezone.utc)
+
+
+def _cpu(usage: float, timestamp=None) -> CpuSampleSchema:
+    return CpuSampleSchema(
+        timestamp=timestamp or _now(),
+        usage_percent=usage,
+        frequency_mhz=3200.0,
+        temperature_celsius=None,
+        core_count=4,
+        thread_count=8,
+        thread_usages=[10.0, 20.5, 30.0],
+    )
+
+
+def _disk(name: str) -> DiskIoSampleSchema:
+    return DiskIoSampleSchema(
+        timestamp=_now(),
+        disk_name=name,
+        read_mbps=1.5,
+        write_mbps=2.5,
+        read_iops=10.0,
+        write_iops=20.0,
+        avg_response_ms=None,
+        active_time_percent=5.0,
+    )
+
+
+@pytest.fixture
+def rings(tmp_path):
+    writer = MetricRings(tmp_path / "metrics.ring")
+    reader = MetricRings(tmp_path / "metrics.ring")
+    yield writer, reader
+    writer.close()
+    reader.close()
+
+
+class TestRoundtrip:
+    """Samples come back as published."""
+
+    def test_cpu(self, rings):
+        writer, reader = rings
+        sample = _cpu(42.5)
+        writer.publish("cpu", sample)
+
+        latest = reader.latest("cpu")
+        assert latest.usage_percent == 42.5
+        assert latest.frequency_mhz == 3200.0
+        assert latest.temperature_celsius is None
+        assert latest.thread_usages == [10.0, 20.5, 30.0]
+        assert abs((latest.timestamp - sample.timestamp).total_seconds()) < 0.001
+
+    def test_memory(self, rings):
+        writer, reader = rings
+        writer.publish("memory", MemorySampleSchema(
+            timestamp=_now(), used_bytes=4, total_bytes=16, percent=25.0,
+            available_bytes=None, baluhost_memory_bytes=2,
+        ))
+
+        latest = reader.latest("memory")
+        assert (latest.used_bytes, latest.total_bytes, latest.percent) == (4, 16, 25.0)
+        assert latest.available_bytes is None
+        assert latest.baluhost_memory_bytes == 2
+
+    def test_network_with_interface_type(self, rings):
+        writer, reader = rings
+        writer.publish("network", NetworkSampleSchema(
+            timestamp=_now(), download_mbps=12.0, upload_mbps=3.0,
+        ), label="wifi")
+
+        assert reader.latest("network").download_mbps == 12.0
+        assert reader.label("network") == "wifi"
+
+    def test_gpu(self, rings):
+        writer, reader = rings
+        writer.publish("gpu", GpuSampleSchema(
+            timestamp=_now(), vendor="amd", device_name="Radeon",
+            usage_percent=50.0, vram_used_bytes=1024, vram_total_bytes=4096,
+        ))
+
+        latest = reader.latest("gpu")
+        assert (latest.vendor, latest.device_name) == ("amd", "Radeon")
+        assert latest.vram_total_bytes == 4096
+        assert latest.power_watts is None
+
+    def test_power(self, rings):
+        writer, reader = rings
+        writer.publish("power", {"watts": 12.5, "voltage": 230.0, "timestamp": _now()}, label="7")
+
+        latest = reader.latest("power", "7")
+        assert latest["watts"] == 12.5
+        assert latest["voltage"] == 230.0
+        assert latest["current"] is None
+        assert reader.latest("power", "8") is None
+
+
+class TestRing:
+    """Ring semantics: wrap-around, limits, labels."""
+
+    def test_history_is_oldest_first_and_wraps(self, rings):
+        writer, reader = rings
+        for i in range(SLOT_COUNT + 20):
+            writer.publish("cpu", _cpu(float(i)))
+
+        history = reader.history("cpu")
+        assert len(history) == SLOT_COUNT
+        assert history[0].usage_percent == 20.0
+        assert history[-1].usage_percent == float(SLOT_COUNT + 19)
+        assert [s.usage_percent for s in reader.history("cpu", limit=3)] == [
+            float(SLOT_COUNT + 17), float(SLOT_COUNT + 18), float(SLOT_COUNT + 19),
+        ]
+
+    def test_disks_get_separate_rings(self, rings):
+        writer, reader = rings
+        writer.publish("disk_io", _disk("sda"), label="sda")
+        writer.publish("disk_io", _disk("nvme0n1"), label="nvme0n1")
+        writer.publish("disk_io", _disk("sda"), label="sda")
+
+        assert reader.labels("disk_io") == ["sda", "nvme0n1"]
+        assert len(reader.history("disk_io", "sda")) == 2
+        assert reader.latest("disk_io", "nvme0n1").disk_name == "nvme0n1"
+
+    def test_extra_disks_are_dropped(self, rings):
+        writer, reader = rings
+        for i in range(MAX_DISKS + 2):
+            writer.publish("disk_io", _disk(f"sd{i}"), label=f"sd{i}")
+
+        assert len(reader.labels("disk_io")) == MAX_DISKS
+        assert reader.latest("disk_io", f"sd{MAX_DISKS}") is None
+
+
+class TestDegradation:
+    """Failures read as "no data"."""
+
+    def test_missing_file(self, tmp_path):
+        reader = MetricRings(tmp_path / "missing.ring")
+        assert reader.latest("cpu") is None
+        assert reader.history("cpu") == []
+        assert reader.labels("disk_io") == []
+
+    def test_stale_samples_are_ignored(self, rings):
+        writer, reader = rings
+        writer.publish("cpu", _cpu(1.0, timestamp=_now() - timedelta(minutes=5)))
+
+        assert reader.latest("cpu") is None
+        assert reader.history("cpu") == []
+        assert reader.latest("cpu", max_age=3600) is not None
+
+    def test_publish_never_raises(self, rings):
+        writer, reader = rings
+        writer.publish("cpu", None)
+        writer.publish("cpu", object())
+        writer.publish("disk_io", _disk("sda"))  # no label
+
+        assert reader.latest("cpu") is None
+
+    def test_second_writer_is_rejected(self, rings, tmp_path):
+        writer, reader = rings
+        writer.publish("cpu", _cpu(1.0))
+
+        intruder = MetricRings(tmp_path / "metrics.ring")
+        intruder.publish("cpu", _cpu(99.0))
+        intruder.close()
+
+        assert reader.latest("cpu").usage_percent == 1.0
+
+    def test_reader_follows_new_writer_file(self, tmp_path):
+        path = tmp_path / "metrics.ring"
+        writer = MetricRings(path)
+        writer.publish("cpu", _cpu(1.0))
+        reader = MetricRings(path)
+        assert reader.latest("cpu").usage_percent == 1.0
+
+        # Worker restart: file removed by cleanup_shm and recreated
+        writer.close()
+        path.unlink()
+        time.sleep(0.01)
+        writer = MetricRings(path)
+        writer.publish("cpu", _cpu(2.0))
+        reader._next_open = 0.0
+
+        assert reader.latest("cpu").usage_percent == 2.0
+        writer.close()
+        reader.close()
+
+
+class TestOrchestratorFallback:
+    """Web-worker orchestrators without local samples read the rings."""
+
+    def test_getters_read_rings(self, isolated_metric_rings):
+        from app.services.monitoring.orchestrator import MonitoringOrchestrator
+
+        isolated_metric_rings.publish("cpu", _cpu(33.0))
+        isolated_metric_rings.publish("disk_io", _disk("sda"), label="sda")
+        isolated_metric_rings.publish("network", NetworkSampleSchema(
+            timestamp=_now(), download_mbps=1.0, upload_mbps=1.0,
+        ), label="ethernet")
+
+        orchestrator = MonitoringOrchestrator()
+        orchestrator.network_collector.get_active_interface_type = lambda: "unknown"
+        assert orchestrator.get_cpu_current().usage_percent == 33.0
+        assert len(orchestrator.get_cpu_history(limit=10)) == 1
+        assert orchestrator.get_memory_current() is None
+        assert orchestrator.get_network_interface_type() == "ethernet"
+        assert orchestrator.get_disk_io_available_disks() == ["sda"]
+        assert list(orchestrator.get_disk_io_current()) == ["sda"]
+        assert len(orchestrator.get_disk_io_history("sda")) == 1
@@ -165,6 +165,7 @@ class TestPluginBaseDashboardDefaults:
 
 
 import asyncio
+import json
 from unittest.mock import MagicMock, AsyncMock
 
 from app.services.websocket_manager import WebSocketManager
@@ -176,7 +177,6 @@ class TestBroadcastTyped:
         manager = WebSocketManager()
 
         mock_ws = AsyncMock()
-        mock_ws.send_json = AsyncMock()
         await manager.connect(mock_ws, user_id=1, is_admin=False)
 
         count = await manager.broadcast_typed(
@@ -185,22 +185,25 @@ class TestBroadcastTyped:
         )
 
         assert count == 1
-        mock_ws.send_json.assert_called_once_with({
+        assert await manager.drain()
+        mock_ws.send_text.assert_called_once()
+        assert json.loads(mock_ws.send_text.call_args.args[0]) == {
             "type": "dashboard_panel_update",
             "payload": {"panel_type": "gauge", "data": {"value": "120 W"}},
-        })
+        }
 
     @pytest.mark.asyncio
     async def test_broadcast_typed_cleans_up_dead_connections(self):
         manager = WebSocketManager()
 
         mock_ws = AsyncMock()
-        mock_ws.send_json = AsyncMock(side_effect=Exception("disconnected"))
+        mock_ws.send_text = AsyncMock(side_effect=Exception("disconnected"))
         await manager.connect(mock_ws, user_id=1, is_admin=False)
 
         count = await manager.broadcast_typed("test", {"key": "val"})
 
-        assert count == 0
+        assert count == 1  # queued; the writer task finds out
+        assert await manager.drain()
         # Connection should be cleaned up
         assert manager.get_connection_count() == 0
 
@@ -625,8 +628,9 @@ class TestAdminOnlyBroadcast:
         )
 
         assert count == 1
-        admin_ws.send_json.assert_called_once()
-        user_ws.send_json.assert_not_called()
+        assert await manager.drain()
+        admin_ws.send_text.assert_called_once()
+        user_ws.send_text.assert_not_called()
 
     @pytest.mark.asyncio
     async def test_bridge_payload_carries_the_admin_only_flag(self):
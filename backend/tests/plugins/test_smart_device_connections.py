@@ -0,0 +1,57 @@
+"""Tests for the shared smart-device connections (smart_device/connections.py)."""
+import asyncio
+
+import pytest
+
+from app.plugins.smart_device.connections import DeviceConnections, DeviceSessionCache
+
+
+@pytest.mark.asyncio
+class TestDeviceSessionCache:
+    async def test_concurrent_callers_share_one_login(self):
+        cache = DeviceSessionCache()
+        logins = []
+
+        async def login():
+            logins.append(1)
+            await asyncio.sleep(0.01)
+            return object()
+
+        clients = await asyncio.gather(*(cache.get_or_create("1:10.0.0.2", login) for _ in range(5)))
+
+        assert len(logins) == 1
+        assert all(c is clients[0] for c in clients)
+
+    async def test_failed_login_is_not_cached(self):
+        cache = DeviceSessionCache()
+
+        async def failing():
+            raise ConnectionError("refused")
+
+        with pytest.raises(ConnectionError):
+            await cache.get_or_create("k", failing)
+
+        async def working():
+            return "client"
+
+        assert await cache.get_or_create("k", working) == "client"
+
+    async def test_evict_prefix_drops_one_device(self):
+        cache = DeviceSessionCache()
+
+        async def client():
+            return object()
+
+        for key in ("1:10.0.0.2", "1:10.0.0.3", "12:10.0.0.4"):
+            await cache.get_or_create(key, client)
+
+        assert cache.evict_prefix("1:") == 2
+        assert cache.get("12:10.0.0.4") is not None
+
+
+class TestDeviceConnections:
+    def test_session_cache_per_plugin(self):
+        connections = DeviceConnections()
+
+        assert connections.sessions("tapo") is connections.sessions("tapo")
+        assert connections.sessions("tapo") is not connections.sessions("shelly")
@@ -8,7 +8,7 @@ import pytest
 from sqlalchemy.orm import Session
 
 from app.models.smart_device import SmartDevice, SmartDeviceSample
-from app.plugins.smart_device.poller import PollerDevice, SmartDevicePoller
+from app.plugins.smart_device.poller import PollerDevice, SmartDevicePoller, _next_deadline
 
 
 # =============================================================================
@@ -334,9 +334,11 @@ class TestUpdateDeviceOnline:
 
         pd = _make_poller_device(id=dev.id)
         poller._update_device_online(pd, online=True, error=None)
+        poller._flush_db(persist_samples=False)
 
         db_session.refresh(dev)
         assert dev.is_online is True
+        assert dev.last_seen is not None
         assert dev.last_error is None
 
     def test_sets_device_offline_with_error(self, db_session):
@@ -346,6 +348,7 @@ class TestUpdateDeviceOnline:
 
         pd = _make_poller_device(id=dev.id)
         poller._update_device_online(pd, online=False, error="Connection refused")
+        poller._flush_db(persist_samples=False)
 
         db_session.refresh(dev)
         assert dev.is_online is False
@@ -358,6 +361,73 @@ class TestUpdateDeviceOnline:
         pd = _make_poller_device(id=999)
         poller._update_device_online(pd, online=True, error=None)  # No exception
 
+    def test_status_is_buffered_until_flush(self, db_session):
+        dev = _create_device_row(db_session)
+        poller = SmartDevicePoller()
+        poller._db_session_factory = lambda: _NoCloseSession(db_session)
+
+        pd = _make_poller_device(id=dev.id)
+        poller._update_device_online(pd, online=False, error="first")
+        poller._update_device_online(pd, online=True, error=None)
+
+        db_session.refresh(dev)
+        assert dev.is_online is False  # nothing written yet
+        poller._flush_db(persist_samples=False)
+        db_session.refresh(dev)
+        assert dev.is_online is True  # latest status wins
+        assert poller._pending_status == {}
+
+    def test_failed_flush_keeps_status_for_the_next_one(self, db_session):
+        dev = _create_device_row(db_session)
+        poller = SmartDevicePoller()
+        session = _NoCloseSession(db_session)
+
+        def _fail():
+            raise RuntimeError("database locked")
+
+        session.commit = _fail
+        poller._db_session_factory = lambda: session
+        poller._update_device_online(_make_poller_device(id=dev.id), online=False, error="old")
+        poller._flush_db(persist_samples=False)
+        db_session.rollback()
+
+        assert poller._pending_status[dev.id][1] == "old"
+        # A status queued meanwhile is newer than the restored one
+        poller._update_device_online(_make_poller_device(id=dev.id), online=True, error=None)
+        poller._restore_pending_status({dev.id: (False, "stale", None)})
+        assert poller._pending_status[dev.id][0] is True
+
+        poller._db_session_factory = lambda: _NoCloseSession(db_session)
+        poller._flush_db(persist_samples=False)
+        db_session.refresh(dev)
+        assert dev.is_online is True
+        assert poller._pending_status == {}
+
+    def test_flush_covers_all_plugins_in_one_commit(self, db_session):
+        alpha = _create_device_row(db_session, name="A", plugin_name="alpha")
+        beta = _create_device_row(db_session, name="B", plugin_name="beta")
+        poller = SmartDevicePoller()
+        session = _NoCloseSession(db_session)
+        commits = []
+        session.commit = lambda: commits.append(1) or db_session.commit()
+        poller._db_session_factory = lambda: session
+        poller._snapshot = {
+            str(alpha.id): {"plugin_name": "alpha", "state": {"switch": {"is_on": True}}},
+            str(beta.id): {"plugin_name": "beta", "state": {"switch": {"is_on": False}}},
+            "9999": {"plugin_name": "beta", "state": {"switch": {"is_on": True}}},  # deleted
+        }
+        poller._update_device_online(_make_poller_device(id=alpha.id), online=True, error=None)
+        poller._update_device_online(_make_poller_device(id=beta.id), online=False, error="down")
+
+        poller._flush_db(persist_samples=True)
+
+        assert len(commits) == 1
+        samples = db_session.query(SmartDeviceSample).all()
+        assert {s.device_id for s in samples} == {alpha.id, beta.id}
+        db_session.refresh(alpha)
+        db_session.refresh(beta)
+        assert (alpha.is_online, beta.is_online, beta.last_error) == (True, False, "down")
+
 
 # =============================================================================
 # SmartDevicePoller: get_status
@@ -435,3 +505,71 @@ class TestPersistSamplesToDb:
         poller = SmartDevicePoller()
         poller._db_session_factory = None
         await poller._persist_samples_to_db("any")  # No exception
+
+
+# =============================================================================
+# SmartDevicePoller: scheduling and concurrency
+# =============================================================================
+
+
+class TestNextDeadline:
+    def test_on_time_round_keeps_the_grid(self):
+        assert _next_deadline(100.0, 5.0, now=103.0) == 105.0
+
+    def test_overrun_skips_missed_deadlines(self):
+        assert _next_deadline(100.0, 5.0, now=112.0) == 115.0
+
+    def test_exact_deadline_is_in_the_past(self):
+        assert _next_deadline(100.0, 5.0, now=105.0) == 110.0
+
+
+class _SlowPlugin:
+    """Fake SmartDevicePlugin whose polls take a while."""
+
+    def __init__(self, max_concurrent: int) -> None:
+        self.metadata = MagicMock()
+        self.metadata.name = "mock_plugin"
+        self._max = max_concurrent
+        self.active = 0
+        self.peak = 0
+        self.polled = []
+
+    def get_poll_interval_seconds(self) -> float:
+        return 60.0
+
+    def get_max_concurrent_polls(self) -> int:
+        return self._max
+
+    async def poll_device(self, device_id: str):
+        import asyncio
+
+        self.active += 1
+        self.peak = max(self.peak, self.active)
+        await asyncio.sleep(0.01)
+        self.active -= 1
+        self.polled.append(device_id)
+        return {}
+
+    poll_device_mock = poll_device
+
+
+@pytest.mark.asyncio
+class TestPollLoop:
+    async def test_round_polls_devices_concurrently_within_limit(self):
+        poller = SmartDevicePoller()
+        poller._running = True
+        plugin = _SlowPlugin(max_concurrent=3)
+        devices = [_make_poller_device(id=i) for i in range(1, 9)]
+
+        def end_after_first_round():
+            poller._running = False
+
+        with patch.object(poller, "_get_active_devices", return_value=devices), \
+                patch.object(poller, "_write_shm_snapshot", side_effect=end_after_first_round), \
+                patch.object(poller, "_write_shm_changes"):
+            await poller._poll_loop(plugin)
+
+        assert sorted(plugin.polled, key=int) == [str(d.id) for d in devices]
+        assert plugin.peak == 3
+        assert poller._round_stats["mock_plugin"]["devices"] == 8
+        assert set(poller._pending_status) == {d.id for d in devices}
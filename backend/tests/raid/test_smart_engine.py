@@ -0,0 +1,156 @@
+"""Tests for the per-device SMART engine (hardware/smart/engine.py)."""
+import time
+from datetime import datetime, timezone
+from types import SimpleNamespace
+
+import pytest
+
+from app.schemas.system import SmartAttribute, SmartDevice
+from app.services.hardware.smart import engine as engine_module
+from app.services.hardware.smart.collector import SmartDeviceStandby
+from app.services.hardware.smart.engine import SmartEngine
+from app.services.monitoring import shm
+
+
+class _InlinePool:
+    def submit(self, fn, *args):
+        fn(*args)
+
+
+def _device(name: str, temperature: int = 35, status: str = "PASSED", realloc: str = "0") -> SmartDevice:
+    return SmartDevice(
+        name=name, model="disk", serial=name, temperature=temperature, status=status,
+        attributes=[SmartAttribute(
+            id=5, name="Reallocated_Sector_Ct", value=100, worst=100, threshold=10, raw=realloc, status="OK",
+        )],
+    )
+
+
+@pytest.fixture
+def disks(monkeypatch):
+    """Fake smartctl: ``disks.results[name]`` is a SmartDevice, ``"standby"`` or an exception."""
+    fake = SimpleNamespace(results={}, reads=[], notified=[])
+
+    def read_device(_smartctl, info, skip_standby=False):
+        assert skip_standby
+        fake.reads.append(info["name"])
+        result = fake.results[info["name"]]
+        if result == "standby":
+            raise SmartDeviceStandby(info["name"])
+        if isinstance(result, Exception):
+            raise result
+        return result
+
+    monkeypatch.setattr(engine_module, "scan_devices", lambda _s: [{"name": n, "type": "sat"} for n in fake.results])
+    monkeypatch.setattr(engine_module, "read_device", read_device)
+    monkeypatch.setattr(engine_module, "_enrich_with_filesystem_usage", lambda devices: None)
+    monkeypatch.setattr(SmartEngine, "_notify", lambda self, device: fake.notified.append(device.name))
+    return fake
+
+
+def _engine(published=None) -> SmartEngine:
+    engine = SmartEngine("smartctl", interval=60, publish=published.append if published is not None else lambda p: None)
+    engine._pool = _InlinePool()
+    engine._rescan(0.0)
+    return engine
+
+
+def test_standby_disk_keeps_last_reading_and_is_not_woken(disks):
+    disks.results["/dev/sda"] = _device("/dev/sda", temperature=40)
+    disks.results["/dev/sdb"] = _device("/dev/sdb")
+    engine = _engine()
+    engine._dispatch(0.0)
+
+    disks.results["/dev/sda"] = "standby"
+    engine.refresh()
+    engine._dispatch(0.0)
+
+    snapshot = engine.snapshot()
+    assert [(d.name, d.temperature) for d in snapshot.devices] == [("/dev/sda", 40), ("/dev/sdb", 35)]
+    assert engine.get_status()["standby"] == ["/dev/sda"]
+    assert engine.standby_skips == 1
+
+
+def test_devices_are_read_on_their_own_schedule_and_failures_back_off(disks):
+    disks.results["/dev/sda"] = _device("/dev/sda")
+    disks.results["/dev/sdb"] = RuntimeError("timeout")
+    engine = _engine()
+
+    engine._dispatch(0.0)
+    engine._dispatch(1.0)  # nothing due yet
+    assert disks.reads == ["/dev/sda", "/dev/sdb"]
+
+    sdb = engine._devices["/dev/sdb"]
+    sdb.next_due = 0.0
+    engine._dispatch(0.0)
+    assert sdb.failures == 2
+    assert sdb.next_due - time.monotonic() > 100  # 2x the interval
+    assert engine.get_status()["failing"] == ["/dev/sdb"]
+
+
+def test_resume_reads_every_device_again(disks):
+    disks.results["/dev/sda"] = _device("/dev/sda")
+    engine = _engine()
+    engine._dispatch(0.0)
+
+    engine.pause()
+    engine.resume()
+    engine._dispatch(1.0)
+
+    assert disks.reads == ["/dev/sda", "/dev/sda"]
+
+
+def test_notifications_only_on_first_reading_or_health_change(disks):
+    disks.results["/dev/sda"] = _device("/dev/sda")
+    engine = _engine()
+    engine._dispatch(0.0)
+    disks.results["/dev/sda"] = _device("/dev/sda", temperature=50)
+    engine.refresh()
+    engine._dispatch(0.0)
+    disks.results["/dev/sda"] = _device("/dev/sda", realloc="8")
+    engine.refresh()
+    engine._dispatch(0.0)
+
+    assert disks.notified == ["/dev/sda", "/dev/sda"]
+
+
+def test_published_snapshot_is_served_to_other_processes(disks, monkeypatch, tmp_path):
+    monkeypatch.setattr(shm, "SHM_DIR", tmp_path)
+    monkeypatch.setattr(engine_module, "_published", (0.0, None))
+    disks.results["/dev/sda"] = _device("/dev/sda", temperature=41)
+    disks.results["/dev/sdb"] = _device("/dev/sdb", temperature=None)
+    published: list[dict] = []
+    engine = _engine(published)
+    engine._dispatch(0.0)
+    engine._publish()
+
+    payload = published[-1]
+    assert payload["devices"] == [{"name": "/dev/sda", "temperature_celsius": 41.0}]
+    shm.write_shm(shm.SMART_SUMMARY_FILE, payload)
+
+    status = engine_module.read_published_status()
+    assert [d.name for d in status.devices] == ["/dev/sda", "/dev/sdb"]
+    assert status.checked_at <= datetime.now(timezone.utc)
+    assert engine_module.read_published_status() is status
+
+
+def test_temperature_only_summary_is_not_a_published_status(monkeypatch, tmp_path):
+    monkeypatch.setattr(shm, "SHM_DIR", tmp_path)
+    monkeypatch.setattr(engine_module, "_published", (0.0, None))
+    shm.write_shm(shm.SMART_SUMMARY_FILE, {"devices": [], "timestamp": 0})
+
+    assert engine_module.read_published_status() is None
+
+
+def test_refresh_request_from_another_process(disks, monkeypatch, tmp_path):
+    monkeypatch.setattr(shm, "SHM_DIR", tmp_path)
+    disks.results["/dev/sda"] = _device("/dev/sda")
+    disks.results["/dev/sdb"] = _device("/dev/sdb")
+    engine = _engine()
+    engine._dispatch(0.0)
+
+    engine_module.request_smart_refresh(["/dev/sdb"])
+    engine._check_refresh_request()
+    engine._dispatch(1.0)
+
+    assert disks.reads == ["/dev/sda", "/dev/sdb", "/dev/sdb"]
@@ -46,6 +46,10 @@ def test_create_backup_success(backup_service: BackupService, temp_backup_dir: P
                         mock_settings.nas_storage_path = str(storage_path)
                         mock_settings.nas_backup_max_count = 10
                         mock_settings.nas_backup_retention_days = 30
+                        mock_settings.backup_format = "chunked"
+                        mock_settings.backup_reader_threads = 2
+                        mock_settings.backup_compression_threads = 2
+                        mock_settings.backup_zstd_level = 3
                         
                         # Create backup
                         backup_data = BackupCreate(
@@ -70,16 +74,44 @@ def test_create_backup_success(backup_service: BackupService, temp_backup_dir: P
                         assert backup.includes_config is False
                         assert backup.creator_id == 1
                         
-                        # Check file exists
+                        # Check manifest exists and lists the storage file
                         backup_file = Path(backup.filepath)
                         assert backup_file.exists()
-                        assert backup_file.suffix == ".gz"
+                        assert backup_file.suffix == ".manifest"
+                        entries = backup_service.list_backup_files(backup.id, prefix="files/")
+                        assert [e["path"] for e in entries] == ["files/test.txt"]
         finally:
             # Cleanup
             if tmp_db_path.exists():
                 tmp_db_path.unlink()
 
 
+def test_create_backup_legacy_tar_format(
+    backup_service: BackupService, temp_backup_dir: Path, monkeypatch
+):
+    """backup_format=tar keeps writing the original .tar.gz archives."""
+    import tarfile
+    from app.services.backup import service as backup_module
+
+    monkeypatch.setattr(backup_module.settings, "backup_format", "tar")
+    monkeypatch.setattr(backup_service, "backup_dir", temp_backup_dir)
+
+    backup = backup_service.create_backup(
+        backup_data=BackupCreate(
+            backup_type="full",
+            includes_database=False,
+            includes_files=False,
+            includes_config=True,
+        ),
+        creator_id=1,
+        creator_username="test_user",
+    )
+
+    assert backup.filename.endswith(".tar.gz")
+    with tarfile.open(backup.filepath, "r:gz") as tar:
+        assert "backup/config/settings.snapshot.json" in tar.getnames()
+
+
 def test_list_backups(backup_service: BackupService, db_session: Session):
     """Test listing backups."""
     # Create test backups directly in database
@@ -345,7 +377,6 @@ class TestConfigBackup:
         self, backup_service: BackupService, temp_backup_dir: Path, monkeypatch
     ):
         import json
-        import tarfile
         from app.services.backup import service as backup_module
 
         sentinel = "SUPER-SECRET-SENTINEL-9f3a2c"
@@ -364,12 +395,11 @@ class TestConfigBackup:
         )
 
         assert backup.status == "completed"
-        archive = Path(backup.filepath)
-        with tarfile.open(archive, "r:gz") as tar:
-            assert "backup/config/settings.snapshot.json" in tar.getnames()
-            text = tar.extractfile(
-                "backup/config/settings.snapshot.json"
-            ).read().decode("utf-8")
+        entry, content = backup_service.open_backup_file(
+            backup.id, "config/settings.snapshot.json"
+        )
+        text = b"".join(content).decode("utf-8")
+        assert entry["size"] == len(text.encode("utf-8"))
 
         snapshot = json.loads(text)
         # Non-secret value preserved, secret redacted by name
@@ -0,0 +1,247 @@
+"""Tests for the chunked backup format (services/backup/archive.py, chunkstore.py).
+
+Tests:
+- Round trip: build a manifest, extract a prefix, extract a single file
+- Dedupe across backups; incrementals reuse unchanged files without reading them
+- Files that change while they are read are re-read or marked, never truncated
+- Unsafe manifest paths are refused
+- The streamed tar is readable by tarfile
+- GC removes packs no manifest references; unsealed packs are discarded
+"""
+import builtins
+import io
+import os
+import tarfile
+
+import pytest
+
+from app.services.backup import archive, chunkstore
+from app.services.backup.archive import ManifestBuilder, open_store
+
+
+@pytest.fixture
+def small_chunks(monkeypatch):
+    """Small chunk bounds so a few KiB of test data spans several chunks."""
+    monkeypatch.setattr(archive, "CHUNK_MIN_SIZE", 1024)
+    monkeypatch.setattr(archive, "CHUNK_MAX_SIZE", 4096)
+
+
+@pytest.fixture
+def tree(tmp_path):
+    root = tmp_path / "storage"
+    (root / "docs" / "empty").mkdir(parents=True)
+    (root / "docs" / "a.txt").write_bytes(b"alpha\n" * 2000)
+    (root / "b.bin").write_bytes(os.urandom(10_000))
+    return root
+
+
+def _backup(backup_dir, root, parent=None):
+    store = open_store(backup_dir)
+    with store.writing(), ManifestBuilder(store, readers=2, compressors=2, parent=parent) as builder:
+        builder.add_tree(root, "files")
+        manifest = builder.finish()
+        store.seal()
+    return store, manifest, builder.stats
+
+
+class TestRoundTrip:
+    def test_extract_prefix_restores_files_and_dirs(self, tmp_path, tree, small_chunks):
+        store, manifest, stats = _backup(tmp_path / "backups", tree)
+
+        assert stats.files == 2 and stats.chunks_new > 2
+        dest = tmp_path / "restore"
+        assert archive.extract_prefix(store, manifest, "files", dest, workers=2) == 2
+        assert (dest / "docs" / "a.txt").read_bytes() == (tree / "docs" / "a.txt").read_bytes()
+        assert (dest / "b.bin").read_bytes() == (tree / "b.bin").read_bytes()
+        assert (dest / "docs" / "empty").is_dir()
+        assert os.stat(dest / "b.bin").st_mtime_ns == os.stat(tree / "b.bin").st_mtime_ns
+
+    def test_manifest_survives_write_and_read(self, tmp_path, tree):
+        _, manifest, _ = _backup(tmp_path / "backups", tree)
+        path = tmp_path / "backups" / f"b{archive.MANIFEST_SUFFIX}"
+
+        archive.write_manifest(path, manifest)
+
+        assert archive.read_manifest(path) == manifest
+        assert archive.is_chunked_archive(path)
+
+    def test_single_file_reads_only_its_chunks(self, tmp_path, tree, small_chunks, monkeypatch):
+        store, manifest, _ = _backup(tmp_path / "backups", tree)
+        entry = archive.find_entry(manifest, "files/docs/a.txt")
+        reads = []
+        real_read = store.read
+        monkeypatch.setattr(store, "read", lambda d: reads.append(d) or real_read(d))
+
+        data = b"".join(archive.iter_entry(store, entry))
+
+        assert data == (tree / "docs" / "a.txt").read_bytes()
+        assert {d.hex() for d in reads} == set(entry["chunks"])
+        assert archive.find_entry(manifest, "files/missing") is None
+
+
+class TestIncremental:
+    def test_identical_backup_stores_nothing_new(self, tmp_path, tree, small_chunks):
+        backup_dir = tmp_path / "backups"
+        _, first, _ = _backup(backup_dir, tree)
+        store, second, stats = _backup(backup_dir, tree)
+
+        assert stats.chunks_new == 0
+        assert store.bytes_written == 0
+        assert archive.manifest_digests(first) == archive.manifest_digests(second)
+
+    def test_unchanged_files_are_not_opened(self, tmp_path, tree, small_chunks, monkeypatch):
+        backup_dir = tmp_path / "backups"
+        _, parent, _ = _backup(backup_dir, tree)
+        (tree / "b.bin").write_bytes(os.urandom(5000))
+
+        opened = []
+        real_open = open
+
+        def tracking_open(path, *args, **kwargs):
+            opened.append(str(path))
+            return real_open(path, *args, **kwargs)
+
+        monkeypatch.setattr(builtins, "open", tracking_open)
+        _, manifest, stats = _backup(backup_dir, tree, parent=parent)
+
+        assert stats.files_unchanged == 1
+        assert not any(p.endswith("a.txt") for p in opened)
+        assert any(p.endswith("b.bin") for p in opened)
+        assert archive.find_entry(manifest, "files/docs/a.txt")["chunks"] == \
+            archive.find_entry(parent, "files/docs/a.txt")["chunks"]
+
+
+class TestLiveFiles:
+    @staticmethod
+    def _grow_on_read(monkeypatch, target, times):
+        """Append to *target* after it was opened, before its chunks are read."""
+        real_iter_chunks = archive.iter_chunks
+        grown = []
+
+        def growing(f, **kwargs):
+            if f.name == str(target) and len(grown) < times:
+                grown.append(1)
+                with open(target, "ab") as out:
+                    out.write(b"grown" * 100)
+            return real_iter_chunks(f, **kwargs)
+
+        monkeypatch.setattr(archive, "iter_chunks", growing)
+
+    def test_file_changed_during_read_is_read_again(self, tmp_path, tree, small_chunks, monkeypatch):
+        target = tree / "b.bin"
+        self._grow_on_read(monkeypatch, target, times=1)
+
+        store, manifest, stats = _backup(tmp_path / "backups", tree)
+
+        entry = archive.find_entry(manifest, "files/b.bin")
+        assert entry["size"] == target.stat().st_size == 10_500
+        assert "changed" not in entry and stats.files_changed == 0
+        data = b"".join(archive.iter_tar(store, manifest))
+        with tarfile.open(fileobj=io.BytesIO(data), mode="r:") as tar:
+            assert tar.extractfile("backup/files/b.bin").read() == target.read_bytes()
+
+    def test_file_that_keeps_changing_is_marked(self, tmp_path, tree, small_chunks, monkeypatch):
+        target = tree / "b.bin"
+        self._grow_on_read(monkeypatch, target, times=archive.READ_ATTEMPTS)
+        backup_dir = tmp_path / "backups"
+
+        store, manifest, stats = _backup(backup_dir, tree)
+
+        entry = archive.find_entry(manifest, "files/b.bin")
+        assert entry["changed"] and stats.files_changed == 1
+        assert entry["size"] == len(b"".join(archive.iter_entry(store, entry)))
+        assert stats.bytes_read > entry["size"]
+        b"".join(archive.iter_tar(store, manifest))  # sizes agree, no truncation
+
+        # The next incremental does not trust the stat of a marked entry
+        _, _, stats = _backup(backup_dir, tree, parent=manifest)
+        assert stats.files_unchanged == 1
+
+
+class TestSafety:
+    @pytest.mark.parametrize("name", ["/etc/passwd", "../escape", "a/../../b", ""])
+    def test_unsafe_paths_are_refused(self, tmp_path, name):
+        with pytest.raises(ValueError):
+            archive.safe_target(tmp_path, name)
+
+    def test_tampered_manifest_is_not_extracted(self, tmp_path, tree):
+        store, manifest, _ = _backup(tmp_path / "backups", tree)
+        manifest["entries"][0]["path"] = "files/../../evil"
+
+        with pytest.raises(ValueError):
+            archive.extract_prefix(store, manifest, "files", tmp_path / "restore")
+        assert not (tmp_path / "evil").exists()
+
+
+class TestTarStream:
+    def test_stream_is_a_valid_tar(self, tmp_path, tree, small_chunks):
+        store, manifest, _ = _backup(tmp_path / "backups", tree)
+
+        data = b"".join(archive.iter_tar(store, manifest))
+
+        with tarfile.open(fileobj=io.BytesIO(data), mode="r:") as tar:
+            assert "backup/files/docs/empty" in tar.getnames()
+            member = tar.extractfile("backup/files/b.bin")
+            assert member.read() == (tree / "b.bin").read_bytes()
+
+
+class TestGarbageCollection:
+    def test_unreferenced_packs_are_removed(self, tmp_path, tree):
+        backup_dir = tmp_path / "backups"
+        _, first, _ = _backup(backup_dir, tree)
+        (tree / "b.bin").write_bytes(os.urandom(10_000))
+        store, second, _ = _backup(backup_dir, tree)
+        packs_before = sorted(store.packs_dir.glob("*.pack"))
+        assert len(packs_before) == 2
+
+        # Dropping the second backup frees its pack; the first stays intact
+        freed = store.gc(lambda: archive.manifest_digests(first))
+
+        assert freed > 0
+        assert len(list(store.packs_dir.glob("*.pack"))) == 1
+        dest = tmp_path / "restore"
+        archive.extract_prefix(store, first, "files", dest)
+        assert (dest / "docs" / "a.txt").exists()
+
+    def test_live_set_is_computed_under_the_store_lock(self, tmp_path, tree):
+        fcntl = pytest.importorskip("fcntl")
+        backup_dir = tmp_path / "backups"
+        store, first, _ = _backup(backup_dir, tree)
+        held = []
+
+        def _live():
+            fd = os.open(store.root / "lock", os.O_RDWR)
+            try:
+                fcntl.flock(fd, fcntl.LOCK_EX | fcntl.LOCK_NB)
+                held.append(False)
+            except BlockingIOError:
+                held.append(True)
+            finally:
+                os.close(fd)
+            return archive.manifest_digests(first)
+
+        assert store.gc(_live) == 0
+        assert held == [True]
+
+    def test_unsealed_pack_is_discarded_by_next_writer(self, tmp_path, tree):
+        backup_dir = tmp_path / "backups"
+        store = open_store(backup_dir)
+        with pytest.raises(RuntimeError):
+            with store.writing(), ManifestBuilder(store, readers=1, compressors=1) as builder:
+                builder.add_tree(tree, "files")
+                raise RuntimeError("disk full")
+        assert list(store.packs_dir.glob("*.pack")) == []
+
+        # A crash leaves a pack without an index behind
+        (store.packs_dir / "pack-crashed.pack").write_bytes(b"partial")
+        with open_store(backup_dir).writing():
+            pass
+        assert not (store.packs_dir / "pack-crashed.pack").exists()
+
+
+class TestReaderSizing:
+    def test_configured_value_wins(self, tmp_path):
+        assert chunkstore.reader_threads(tmp_path, 6) == 6
+
+    def test_auto_is_at_least_one(self, tmp_path):
+        assert 1 <= chunkstore.reader_threads(tmp_path) <= 8
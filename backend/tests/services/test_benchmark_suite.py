@@ -0,0 +1,133 @@
+"""Tests for the end-to-end workload benchmark suite (services/benchmark/suite.py)."""
+import contextlib
+
+import pytest
+from sqlalchemy.orm import sessionmaker
+
+from app.models.benchmark import BenchmarkStatus, WorkloadBenchmark, WorkloadResult
+from app.services.benchmark import suite
+from app.services.benchmark.state import _active_workload_runs
+from app.services.benchmark.workloads import Measurement, WorkloadSkipped
+
+
+def _result(workload: str, **metrics) -> WorkloadResult:
+    return WorkloadResult(workload=workload, status="ok", samples=10, errors=0, **metrics)
+
+
+def test_measurement_summary_uses_nearest_rank_percentiles():
+    m = Measurement(elapsed=2.0)
+    for i in range(1, 101):
+        m.add(i / 1000, nbytes=1024 * 1024)
+
+    summary = m.summary()
+
+    assert summary["samples"] == 100
+    assert summary["latency_p50_ms"] == 50.0
+    assert summary["latency_p99_ms"] == 99.0
+    assert summary["latency_max_ms"] == 100.0
+    assert summary["throughput_mbps"] == 50.0
+    assert summary["ops_per_second"] == 50.0
+
+
+def test_compare_flags_regressions_beyond_threshold():
+    baseline = WorkloadBenchmark(results=[
+        _result("download", throughput_mbps=100.0, latency_p50_ms=20.0, latency_p99_ms=40.0),
+        _result("api_latency", ops_per_second=500.0, latency_p50_ms=0.5, latency_p99_ms=2.0),
+    ])
+    current = WorkloadBenchmark(results=[
+        _result("download", throughput_mbps=85.0, latency_p50_ms=21.0, latency_p99_ms=60.0),
+        # +60% p50 but only 0.3 ms: below the latency noise floor
+        _result("api_latency", ops_per_second=520.0, latency_p50_ms=0.8, latency_p99_ms=2.1),
+    ])
+
+    deltas = {(d["workload"], d["metric"]): d for d in suite.compare_runs(current, baseline)}
+
+    assert deltas[("download", "throughput_mbps")]["regression"]
+    assert deltas[("download", "throughput_mbps")]["change_percent"] == -15.0
+    assert not deltas[("download", "latency_p50_ms")]["regression"]
+    assert deltas[("download", "latency_p99_ms")]["regression"]
+    assert not deltas[("api_latency", "latency_p50_ms")]["regression"]
+    assert deltas[("api_latency", "ops_per_second")]["change_percent"] == 4.0
+
+
+def test_skipped_workloads_are_not_compared():
+    baseline = WorkloadBenchmark(results=[_result("webdav_download", throughput_mbps=80.0)])
+    current = WorkloadBenchmark(results=[
+        WorkloadResult(workload="webdav_download", status="skipped", detail="no password"),
+    ])
+
+    assert suite.compare_runs(current, baseline) == []
+
+
+def test_hardware_fingerprint_ignores_software_versions():
+    env = {"cpu_model": "Ryzen", "cpu_count": 8, "memory_gb": 32, "block_devices": ["nvme0n1:SSD"],
+           "kernel": "6.8.0", "python": "3.11.9"}
+    upgraded = {**env, "kernel": "6.11.0", "python": "3.12.1"}
+    new_disk = {**env, "block_devices": ["nvme0n1:SSD", "sda:HDD"]}
+
+    assert suite.hardware_fingerprint(env) == suite.hardware_fingerprint(upgraded)
+    assert suite.hardware_fingerprint(env) != suite.hardware_fingerprint(new_disk)
+
+
+@pytest.fixture
+def fake_suite(monkeypatch, db_session):
+    """Replace the workload registry and API client; runs use the test database."""
+    speed = {"mbps": 100.0}
+
+    async def transfer(ctx):
+        m = Measurement(elapsed=1.0)
+        m.add(0.01, nbytes=int(speed["mbps"] * 1024 * 1024))
+        return m
+
+    async def unavailable(ctx):
+        raise WorkloadSkipped("not configured")
+
+    @contextlib.asynccontextmanager
+    async def client_factory(user):
+        yield None
+
+    monkeypatch.setattr(suite, "WORKLOADS", {"transfer": transfer, "unavailable": unavailable})
+    monkeypatch.setattr(suite, "collect_environment", lambda: {"cpu_model": "test"})
+
+    async def no_version():
+        return "1.0.0", None
+
+    monkeypatch.setattr(suite, "_current_version", no_version)
+    session_factory = sessionmaker(bind=db_session.get_bind(), autoflush=False)
+
+    async def run(user_id: int, profile: str = "quick") -> WorkloadBenchmark:
+        started = await suite.start_workload_benchmark(
+            db_session, user_id, profile,
+            client_factory=client_factory, session_factory=session_factory,
+        )
+        await _active_workload_runs[started.id]
+        db_session.expire_all()
+        return db_session.get(WorkloadBenchmark, started.id)
+
+    run.speed = speed
+    return run
+
+
+async def test_suite_records_results_and_compares_with_previous_run(fake_suite, admin_user):
+    first = await fake_suite(admin_user.id)
+    fake_suite.speed["mbps"] = 50.0
+    second = await fake_suite(admin_user.id)
+
+    assert first.status == BenchmarkStatus.COMPLETED
+    assert {r.workload: r.status for r in first.results} == {"transfer": "ok", "unavailable": "skipped"}
+    assert first.baseline_id is None
+    assert second.baseline_id == first.id
+    assert second.regressions == 1
+    assert not _active_workload_runs
+
+
+async def test_runs_are_only_compared_within_a_profile(fake_suite, admin_user):
+    await fake_suite(admin_user.id, "quick")
+    standard = await fake_suite(admin_user.id, "standard")
+
+    assert standard.baseline_id is None
+
+
+async def test_start_rejects_unknown_workloads(db_session, admin_user):
+    with pytest.raises(ValueError, match="Unknown workload"):
+        await suite.start_workload_benchmark(db_session, admin_user.id, "quick", ["smb_copy"])
@@ -0,0 +1,286 @@
+"""Tests for the parallel, resumable cloud transfer engine (services/cloud/transfer.py)."""
+import os
+from datetime import datetime, timezone
+from pathlib import Path
+
+import pytest
+from sqlalchemy.orm import Session
+
+from app.models.cloud import CloudConnection, CloudTransferCheckpoint
+from app.models.sync_progress import SyncBandwidthLimit
+from app.services.cloud import transfer
+from app.services.cloud.adapters.base import CloudAdapter
+from app.services.cloud.transfer import (
+    StreamController,
+    TransferEngine,
+    TransferItem,
+    TransferJournal,
+    bandwidth_limit,
+)
+
+PART = 4096
+
+
+class _MemoryAdapter(CloudAdapter):
+    """Ranged streaming from in-memory files; selected offsets fail."""
+
+    supports_streaming = True
+    supports_ranges = True
+
+    def __init__(self, files: dict[str, bytes], fail_offsets=()):
+        self.files = files
+        self.fail_offsets = set(fail_offsets)
+        self.requests: list[tuple[str, int, object]] = []
+        self.uploaded: dict[str, bytes] = {}
+
+    async def list_files(self, path="/"):
+        return []
+
+    async def download_file(self, remote_path, local_path, progress_callback=None):
+        raise NotImplementedError
+
+    async def download_folder(self, remote_path, local_path, progress_callback=None):
+        raise NotImplementedError
+
+    async def get_total_size(self, remote_path):
+        return None
+
+    async def stream_range(self, remote_path, offset=0, length=None):
+        self.requests.append((remote_path, offset, length))
+        if offset in self.fail_offsets:
+            raise ConnectionError("connection reset")
+        data = self.files[remote_path]
+        end = len(data) if length is None else offset + length
+        for start in range(offset, end, 1000):
+            yield data[start:min(start + 1000, end)]
+
+    async def upload_stream(self, remote_path, size, chunks):
+        self.uploaded[remote_path] = b"".join([chunk async for chunk in chunks])
+
+
+@pytest.fixture(autouse=True)
+def _no_retry_delay(monkeypatch):
+    monkeypatch.setattr(transfer, "RETRY_BASE_DELAY", 0.0)
+
+
+def _engine(adapter, journal, direction="download") -> TransferEngine:
+    return TransferEngine(
+        adapter, journal, direction=direction,
+        max_streams=3, initial_streams=3, part_size=PART, multipart_cutoff=2 * PART,
+    )
+
+
+def _item(tmp_path: Path, name: str, data: bytes, **kwargs) -> TransferItem:
+    return TransferItem(
+        rel_path=name, remote_path=f"/remote/{name}", local_path=tmp_path / name,
+        size=len(data), **kwargs,
+    )
+
+
+def test_controller_adds_streams_while_throughput_grows():
+    c = StreamController(initial=2, maximum=4)
+    c.adjust(10.0)  # first window probes upwards
+    assert c.limit == 3
+    c.adjust(15.0)
+    assert c.limit == 4
+    c.adjust(30.0)  # at the maximum
+    assert c.limit == 4
+
+
+def test_controller_takes_back_a_stream_that_hurt():
+    c = StreamController(initial=2, maximum=8)
+    c.adjust(10.0)
+    c.adjust(8.0)  # adding the third stream made it slower
+    assert c.limit == 2
+    c.adjust(5.0)  # no increase to undo: hold
+    assert c.limit == 2
+
+
+def test_controller_holds_when_capped_and_halves_on_errors():
+    c = StreamController(initial=4, maximum=8)
+    c.adjust(10.0, capped=True)
+    assert c.limit == 4
+    c.on_error()
+    assert c.limit == 2
+
+
+def test_bandwidth_limit_applies_inside_throttle_window(db_session: Session, regular_user):
+    db_session.add(SyncBandwidthLimit(
+        user_id=regular_user.id, download_speed_limit=1_000_000, upload_speed_limit=None,
+        throttle_enabled=True, throttle_start_hour=22, throttle_end_hour=6,
+    ))
+    db_session.commit()
+
+    assert bandwidth_limit(db_session, regular_user.id, "download", datetime(2026, 1, 1, 23)) == 1_000_000
+    assert bandwidth_limit(db_session, regular_user.id, "download", datetime(2026, 1, 1, 3)) == 1_000_000
+    assert bandwidth_limit(db_session, regular_user.id, "download", datetime(2026, 1, 1, 12)) is None
+    assert bandwidth_limit(db_session, regular_user.id, "upload", datetime(2026, 1, 1, 23)) is None
+
+
+async def test_large_file_is_downloaded_in_parts(db_session: Session, tmp_path: Path):
+    data = os.urandom(5 * PART + 100)
+    small = b"small file"
+    adapter = _MemoryAdapter({"/remote/big.bin": data, "/remote/small.txt": small})
+    journal = TransferJournal(db_session, "import", 1).load()
+
+    result = await _engine(adapter, journal).run(
+        [_item(tmp_path, "big.bin", data), _item(tmp_path, "small.txt", small)]
+    )
+
+    assert (tmp_path / "big.bin").read_bytes() == data
+    assert (tmp_path / "small.txt").read_bytes() == small
+    assert result.files_transferred == 2
+    assert result.bytes_transferred == len(data) + len(small)
+    assert sorted(offset for path, offset, _ in adapter.requests if path.endswith("big.bin")) == [
+        i * PART for i in range(6)
+    ]
+    assert not list(tmp_path.glob(".*" + transfer.PART_SUFFIX))
+
+
+async def test_interrupted_download_resumes_missing_parts_only(db_session: Session, tmp_path: Path):
+    data = os.urandom(5 * PART + 100)
+    item = _item(tmp_path, "big.bin", data)
+
+    failing = _MemoryAdapter({item.remote_path: data}, fail_offsets={2 * PART})
+    first = await _engine(failing, TransferJournal(db_session, "import", 7).load()).run([item])
+    assert first.files_transferred == 0
+    assert "connection reset" in first.errors[0]
+    assert not item.local_path.exists()
+
+    healthy = _MemoryAdapter({item.remote_path: data})
+    journal = TransferJournal(db_session, "import", 7).load()
+    second = await _engine(healthy, journal).run([item])
+
+    refetched = sorted(offset for _, offset, _ in healthy.requests)
+    assert refetched[0] == 2 * PART  # parts 0 and 1 landed in the first run
+    assert refetched == sorted(set(refetched))
+    assert item.local_path.read_bytes() == data
+    assert second.files_transferred == 1
+    assert second.bytes_transferred == len(data)
+    assert journal.get("big.bin").completed
+
+
+async def test_completed_and_unchanged_files_are_skipped(db_session: Session, tmp_path: Path):
+    data = b"x" * 100
+    modified = datetime(2026, 3, 1, tzinfo=timezone.utc)
+    existing = _item(tmp_path, "synced.txt", data, modified_at=modified)
+    existing.local_path.write_bytes(data)
+    os.utime(existing.local_path, (modified.timestamp(), modified.timestamp()))
+    adapter = _MemoryAdapter({existing.remote_path: data})
+
+    result = await _engine(adapter, TransferJournal(db_session, "import", 3).load()).run([existing])
+
+    assert adapter.requests == []
+    assert result.files_skipped == 1
+
+
+async def test_uploads_are_journaled_per_file(db_session: Session, tmp_path: Path):
+    a = tmp_path / "a.txt"
+    a.write_bytes(b"aaa")
+    item = TransferItem(rel_path="a.txt", remote_path="/share/a.txt", local_path=a, size=3)
+    adapter = _MemoryAdapter({})
+
+    await _engine(adapter, TransferJournal(db_session, "export", 5).load(), "upload").run([item])
+    again = _MemoryAdapter({})
+    result = await _engine(again, TransferJournal(db_session, "export", 5).load(), "upload").run([item])
+
+    assert adapter.uploaded == {"/share/a.txt": b"aaa"}
+    assert again.uploaded == {}
+    assert result.files_skipped == 1
+
+
+async def test_tick_keeps_db_work_off_the_event_loop(db_session: Session, tmp_path: Path, monkeypatch):
+    import asyncio
+    import threading
+
+    monkeypatch.setattr(transfer, "TICK_INTERVAL", 0.01)
+    loop_thread = threading.get_ident()
+    callers: list[int] = []
+
+    class _SlowAdapter(_MemoryAdapter):
+        async def stream_range(self, remote_path, offset=0, length=None):
+            async for chunk in super().stream_range(remote_path, offset, length):
+                await asyncio.sleep(0.01)
+                yield chunk
+
+    checks = 0
+
+    def is_cancelled() -> bool:
+        nonlocal checks
+        checks += 1
+        callers.append(threading.get_ident())
+        return checks > 10  # a part (5 chunks) has landed by then
+
+    data = os.urandom(5 * PART)
+    item = _item(tmp_path, "big.bin", data)
+    journal = TransferJournal(db_session, "import", 9).load()
+    engine = TransferEngine(
+        _SlowAdapter({item.remote_path: data}), journal, direction="download",
+        is_cancelled=is_cancelled, progress=lambda *_: callers.append(threading.get_ident()),
+        max_streams=1, initial_streams=1, part_size=PART, multipart_cutoff=2 * PART,
+    )
+
+    with pytest.raises(asyncio.CancelledError):
+        await engine.run([item])
+
+    assert callers and loop_thread not in callers
+    # Parts finished before the cancel were journaled by the final flush
+    row = db_session.query(CloudTransferCheckpoint).filter_by(job_id=9).one()
+    assert row.parts_done
+
+
+async def test_import_job_downloads_folder_and_clears_journal(
+    db_session: Session, regular_user, tmp_path: Path, monkeypatch
+):
+    from app.core.config import settings
+    from app.services.cloud.import_job import CloudImportJobService
+
+    monkeypatch.setattr(settings, "nas_storage_path", str(tmp_path))
+    connection = CloudConnection(
+        user_id=regular_user.id, provider="google_drive", display_name="Drive",
+        encrypted_config="encrypted-data", is_active=True,
+    )
+    db_session.add(connection)
+    db_session.commit()
+    service = CloudImportJobService(db_session)
+    job = service.start_import(connection.id, regular_user.id, "/Documents", "imports")
+
+    await service.execute_import(job.id)
+
+    db_session.refresh(job)
+    assert job.status == "completed"
+    assert job.files_transferred == job.files_total == 4
+    assert job.progress_bytes == 2_500_000 + 8_192 + 150_000 + 50_000
+    assert (tmp_path / "imports" / "Projects" / "plan.docx").stat().st_size == 150_000
+    assert db_session.query(CloudTransferCheckpoint).filter_by(job_id=job.id).count() == 0
+
+
+def test_import_cancel_is_seen_through_the_job_row(db_session: Session, regular_user):
+    from sqlalchemy.orm import sessionmaker
+
+    from app.models.cloud import CloudImportJob
+    from app.services.cloud.import_job import CloudImportJobService
+
+    connection = CloudConnection(
+        user_id=regular_user.id, provider="google_drive", display_name="Drive",
+        encrypted_config="encrypted-data", is_active=True,
+    )
+    db_session.add(connection)
+    db_session.commit()
+    runner = CloudImportJobService(db_session)
+    job = runner.start_import(connection.id, regular_user.id, "/Documents", "imports")
+    job.status = "running"
+    db_session.commit()
+
+    # The cancel route may be served by another worker with its own session
+    other = sessionmaker(bind=db_session.get_bind())()
+    try:
+        assert CloudImportJobService(other).cancel_job(job.id, regular_user.id) is True
+        assert CloudImportJobService(other).cancel_job(job.id, regular_user.id) is False
+    finally:
+        other.close()
+
+    assert runner._cancel_requested(job.id) is True
+    row = db_session.query(CloudImportJob).filter_by(id=job.id).one()
+    db_session.refresh(row)
+    assert row.error_message == "Cancelled by user"
@@ -0,0 +1,251 @@
+"""Tests for the batched, coalescing notification dispatcher.
+
+A RAID degrade or a mass file operation emits hundreds of near-identical
+events; each used to cost its own insert, WebSocket frames and FCM calls.
+"""
+from unittest.mock import AsyncMock, MagicMock, patch
+
+import pytest
+from sqlalchemy.orm import Session, sessionmaker
+
+from app.models.mobile import MobileDevice
+from app.models.notification import Notification, NotificationPreferences
+from app.models.user import User
+from app.services.notifications import dispatcher as dispatcher_mod
+from app.services.notifications.dispatcher import (
+    NotificationDispatcher,
+    PendingNotification,
+    coalesce,
+)
+from app.services.notifications.events import EventEmitter, EventType
+from app.services.notifications.firebase import FirebaseService
+
+
+def _pending(user_id=None, title="RAID Array md0 degradiert", message="md0", **extra):
+    return PendingNotification(
+        user_id=user_id,
+        category="raid",
+        notification_type="critical",
+        title=title,
+        message=message,
+        extra_data={"event_type": "raid.degraded", **extra},
+        priority=3,
+    )
+
+
+@pytest.fixture
+def factory(db_session: Session):
+    return sessionmaker(autocommit=False, autoflush=False, bind=db_session.get_bind())
+
+
+@pytest.fixture
+def ws():
+    manager = MagicMock()
+    manager.broadcast_to_admins = AsyncMock(return_value=1)
+    manager.broadcast_to_user = AsyncMock(return_value=1)
+    manager.send_unread_count = AsyncMock(return_value=1)
+    with patch(
+        "app.services.websocket_manager.get_websocket_manager", return_value=manager
+    ):
+        yield manager
+
+
+class TestCoalesce:
+    def test_duplicates_become_one_notification_with_a_count(self):
+        merged = coalesce([_pending() for _ in range(4)])
+
+        assert len(merged) == 1
+        assert merged[0].extra_data["coalesced_count"] == 4
+        assert merged[0].message == "md0"
+
+    def test_related_events_become_a_summary(self):
+        items = [
+            _pending(title=f"RAID Array md{i} degradiert", message=f"md{i}", array_name=f"md{i}")
+            for i in range(8)
+        ]
+
+        merged = coalesce(items)
+
+        assert len(merged) == 1
+        summary = merged[0]
+        assert summary.title == "RAID Array md0 degradiert (+7 weitere)"
+        assert summary.message.splitlines()[:5] == ["md0", "md1", "md2", "md3", "md4"]
+        assert "3 weitere" in summary.message
+        assert summary.extra_data["coalesced_count"] == 8
+        assert [i["array_name"] for i in summary.extra_data["items"]] == [f"md{i}" for i in range(8)]
+
+    def test_different_recipients_and_types_stay_apart(self):
+        merged = coalesce([
+            _pending(user_id=1),
+            _pending(user_id=2),
+            _pending(user_id=1, event_type="smart.warning"),
+        ])
+
+        assert len(merged) == 3
+
+    def test_different_links_stay_apart(self):
+        a = _pending()
+        b = _pending()
+        b.action_url = "/raid/md1"
+
+        merged = coalesce([a, a, b])
+
+        assert [m.action_url for m in merged] == [None, "/raid/md1"]
+
+
+class TestDispatcher:
+    async def test_submit_is_refused_while_stopped(self):
+        assert NotificationDispatcher().submit(_pending()) is False
+
+    async def test_storm_is_written_once_with_one_unread_update_per_user(
+        self, db_session: Session, admin_user: User, regular_user: User, factory, ws
+    ):
+        dispatcher = NotificationDispatcher(window=60)  # flushed by hand below
+        dispatcher.start(factory)
+        try:
+            for i in range(200):
+                assert dispatcher.submit(_pending(message=f"disk {i}"))
+            for _ in range(3):
+                dispatcher.submit(_pending(
+                    user_id=regular_user.id, title="Sync fertig", message="ok",
+                    event_type="sync.completed",
+                ))
+
+            handled = await dispatcher.flush()
+        finally:
+            await dispatcher.stop()
+
+        assert handled == 203
+        db_session.expire_all()
+        system_rows = db_session.query(Notification).filter(Notification.user_id.is_(None)).all()
+        assert len(system_rows) == 1
+        assert system_rows[0].extra_data["coalesced_count"] == 200
+        user_rows = db_session.query(Notification).filter(
+            Notification.user_id == regular_user.id
+        ).all()
+        assert len(user_rows) == 1
+
+        ws.broadcast_to_admins.assert_awaited_once()
+        counts = {call.args[0]: call.args[1] for call in ws.send_unread_count.await_args_list}
+        assert ws.send_unread_count.await_count == len(counts)
+        assert counts[admin_user.id] >= 1
+        assert counts[regular_user.id] >= 1
+
+    async def test_push_is_one_multicast_and_clears_unregistered_tokens(
+        self, db_session: Session, admin_user: User, factory, ws
+    ):
+        for token in ("tok-a", "tok-b"):
+            db_session.add(MobileDevice(
+                user_id=admin_user.id, device_name=token, device_type="android",
+                push_token=token, is_active=True,
+            ))
+        db_session.commit()
+
+        multicast = MagicMock(return_value={
+            "success_count": 1, "failure_count": 1,
+            "unregistered": ["tok-b"], "error": None,
+        })
+        dispatcher = NotificationDispatcher(window=60)
+        dispatcher.start(factory)
+        try:
+            with patch.object(FirebaseService, "is_available", return_value=True), \
+                 patch.object(FirebaseService, "send_multicast", multicast):
+                for i in range(5):
+                    dispatcher.submit(_pending(message=f"disk {i}"))
+                await dispatcher.flush()
+        finally:
+            await dispatcher.stop()
+
+        multicast.assert_called_once()
+        assert sorted(multicast.call_args.args[0]) == ["tok-a", "tok-b"]
+        db_session.expire_all()
+        tokens = {d.device_name: d.push_token for d in db_session.query(MobileDevice)}
+        assert tokens == {"tok-a": "tok-a", "tok-b": None}
+
+    async def test_system_push_reaches_admins_regardless_of_mobile_preference(
+        self, db_session: Session, admin_user: User, factory, ws
+    ):
+        db_session.add(MobileDevice(
+            user_id=admin_user.id, device_name="tok-a", device_type="android",
+            push_token="tok-a", is_active=True,
+        ))
+        db_session.add(NotificationPreferences(
+            user_id=admin_user.id,
+            category_preferences={"raid": {"mobile": False, "in_app": True}},
+        ))
+        db_session.commit()
+
+        multicast = MagicMock(return_value={
+            "success_count": 1, "failure_count": 0, "unregistered": [], "error": None,
+        })
+        dispatcher = NotificationDispatcher(window=60)
+        dispatcher.start(factory)
+        try:
+            with patch.object(FirebaseService, "is_available", return_value=True), \
+                 patch.object(FirebaseService, "send_multicast", multicast):
+                dispatcher.submit(_pending())
+                await dispatcher.flush()
+        finally:
+            await dispatcher.stop()
+
+        multicast.assert_called_once()
+        assert multicast.call_args.args[0] == ["tok-a"]
+
+    async def test_failed_insert_requeues_the_batch(self, ws):
+        def _broken_session():
+            raise RuntimeError("database down")
+
+        dispatcher = NotificationDispatcher(window=60)
+        dispatcher.start(_broken_session)
+        try:
+            dispatcher.submit(_pending())
+            dispatcher.submit(_pending(message="second"))
+
+            assert await dispatcher.flush() == -1
+            assert [p.message for p in dispatcher._queue] == ["md0", "second"]
+            assert dispatcher.get_status()["error_count"] == 1
+        finally:
+            dispatcher._queue.clear()
+            await dispatcher.stop()
+
+
+class TestEmitterUsesDispatcher:
+    async def test_emit_queues_instead_of_creating(self):
+        dispatcher = MagicMock()
+        dispatcher.submit.return_value = True
+        db_factory = MagicMock()
+        emitter = EventEmitter()
+        emitter.set_db_session_factory(db_factory)
+
+        with patch.object(dispatcher_mod, "get_notification_dispatcher", return_value=dispatcher):
+            await emitter.emit(EventType.RAID_DEGRADED, array_name="md0", details="")
+
+        queued = dispatcher.submit.call_args.args[0]
+        assert queued.category == "raid"
+        assert queued.extra_data["event_type"] == EventType.RAID_DEGRADED
+        db_factory.assert_not_called()
+
+    async def test_emit_falls_back_to_direct_delivery_when_not_queued(self):
+        dispatcher = MagicMock()
+        dispatcher.submit.return_value = False
+        db_factory = MagicMock()
+        emitter = EventEmitter()
+        emitter.set_db_session_factory(db_factory)
+        service = MagicMock()
+        service.create = AsyncMock()
+
+        with patch.object(dispatcher_mod, "get_notification_dispatcher", return_value=dispatcher), \
+             patch("app.services.notifications.service.get_notification_service", return_value=service):
+            await emitter.emit(EventType.RAID_DEGRADED, array_name="md0", details="")
+
+        service.create.assert_awaited_once()
+
+    async def test_emit_without_session_factory_does_nothing(self):
+        dispatcher = MagicMock()
+        dispatcher.submit.return_value = True
+        emitter = EventEmitter()
+
+        with patch.object(dispatcher_mod, "get_notification_dispatcher", return_value=dispatcher):
+            await emitter.emit(EventType.RAID_DEGRADED, array_name="md0", details="")
+
+        dispatcher.submit.assert_not_called()
@@ -0,0 +1,200 @@
+"""
+Tests for the scheduler worker's job pool and request pickup.
+
+Tests:
+- Per-resource concurrency limits and worker slots
+- Coalescing of scheduled runs, queued interactive duplicates
+- Priority and resource reservation for interactive requests
+- Worker queues "requested" rows once and marks them running on start
+"""
+import threading
+import time
+from datetime import datetime, timezone
+
+import pytest
+from sqlalchemy.orm import Session, sessionmaker
+
+from app.models.scheduler_history import SchedulerExecution, SchedulerStatus, TriggerType
+from app.services.scheduler import worker as worker_module
+from app.services.scheduler.execution import notify_execution_requested
+from app.services.scheduler.pool import JobPool, Resource
+
+
+def _wait_for(predicate, timeout: float = 2.0) -> None:
+    deadline = time.monotonic() + timeout
+    while not predicate():
+        if time.monotonic() > deadline:
+            raise AssertionError("condition not reached")
+        time.sleep(0.005)
+
+
+class _Gates:
+    """Job bodies that block until released, recording the start order."""
+
+    def __init__(self):
+        self.started: list[str] = []
+        self._events: dict[str, threading.Event] = {}
+
+    def job(self, name: str):
+        event = self._events.setdefault(name, threading.Event())
+
+        def run():
+            self.started.append(name)
+            event.wait(5)
+            event.clear()
+
+        return run
+
+    def release(self, name: str) -> None:
+        self._events[name].set()
+
+
+@pytest.fixture
+def pool():
+    p = JobPool(4, {Resource.ARRAY_IO: 1, Resource.CPU: 1, Resource.NETWORK: 2})
+    yield p
+    p.shutdown()
+
+
+@pytest.fixture
+def gates(pool):
+    g = _Gates()
+    yield g
+    for name in g._events:
+        g.release(name)
+
+
+def test_array_jobs_never_overlap(pool, gates):
+    pool.submit("raid_scrub", gates.job("raid_scrub"))
+    pool.submit("backup", gates.job("backup"))
+    pool.submit("notification_check", gates.job("notification_check"))
+
+    _wait_for(lambda: pool.running() == {"raid_scrub", "notification_check"})
+    assert pool.queued() == ["backup"]
+
+    gates.release("raid_scrub")
+    _wait_for(lambda: "backup" in pool.running())
+    assert "raid_scrub" not in pool.running()
+
+
+def test_network_jobs_run_up_to_their_limit(pool, gates):
+    for name in ("sync_check", "cloud_sync", "plugin_update_check"):
+        pool.submit(name, gates.job(name))
+
+    _wait_for(lambda: len(pool.running()) == 2)
+    assert pool.queued() == ["plugin_update_check"]
+
+
+def test_scheduled_runs_coalesce_but_interactive_runs_queue(pool, gates):
+    assert pool.submit("smart_scan", gates.job("smart_scan"))
+    assert not pool.submit("smart_scan", gates.job("smart_scan"))
+    assert pool.submit("smart_scan", gates.job("smart_scan"), interactive=True)
+
+    _wait_for(lambda: pool.running() == {"smart_scan"})
+    assert pool.queued() == ["smart_scan"]
+
+    gates.release("smart_scan")
+    _wait_for(lambda: pool.queued() == [])
+    assert gates.started == ["smart_scan", "smart_scan"]
+
+
+def test_interactive_request_gets_the_reserved_slot():
+    pool = JobPool(2, {})
+    gates = _Gates()
+    try:
+        pool.submit("upload_cleanup", gates.job("upload_cleanup"))
+        pool.submit("file_activity_cleanup", gates.job("file_activity_cleanup"))
+        pool.submit("notification_check", gates.job("notification_check"), interactive=True)
+
+        _wait_for(lambda: pool.running() == {"upload_cleanup", "notification_check"})
+        assert pool.queued() == ["file_activity_cleanup"]
+    finally:
+        for name in ("upload_cleanup", "file_activity_cleanup", "notification_check"):
+            gates.release(name)
+        pool.shutdown(wait=True, timeout=2)
+
+
+def test_interactive_request_goes_first(pool, gates):
+    pool.submit("raid_scrub", gates.job("raid_scrub"))
+    _wait_for(lambda: "raid_scrub" in pool.running())
+    pool.submit("backup", gates.job("backup"))
+    pool.submit("archive", gates.job("archive"), interactive=True, resources=(Resource.ARRAY_IO,))
+
+    assert pool.queued() == ["archive", "backup"]
+    gates.release("raid_scrub")
+    _wait_for(lambda: "archive" in pool.running())
+    assert "backup" not in pool.running()
+
+
+def test_blocked_request_reserves_its_free_resources(pool, gates):
+    pool.submit("hashing", gates.job("hashing"), resources=(Resource.CPU,))
+    _wait_for(lambda: "hashing" in pool.running())
+
+    # backup waits for the CPU; the idle array stays reserved for it
+    pool.submit("backup", gates.job("backup"), interactive=True)
+    pool.submit("raid_scrub", gates.job("raid_scrub"))
+
+    assert pool.running() == {"hashing"}
+    assert pool.queued() == ["backup", "raid_scrub"]
+    gates.release("hashing")
+    _wait_for(lambda: "backup" in pool.running())
+    assert pool.queued() == ["raid_scrub"]
+
+
+def test_shutdown_drops_queue_and_rejects_new_jobs(pool, gates):
+    pool.submit("raid_scrub", gates.job("raid_scrub"))
+    pool.submit("backup", gates.job("backup"))
+
+    assert pool.shutdown() == ["backup"]
+    assert not pool.submit("smart_scan", gates.job("smart_scan"), interactive=True)
+
+
+def test_failing_job_frees_its_resources(pool):
+    def boom():
+        raise RuntimeError("disk gone")
+
+    pool.submit("raid_scrub", boom)
+    _wait_for(lambda: not pool.running())
+    ran = threading.Event()
+    pool.submit("backup", ran.set)
+    assert ran.wait(2)
+
+
+def test_notify_is_a_noop_on_sqlite(db_session: Session):
+    notify_execution_requested(db_session, 1)  # must not raise without pg_notify
+
+
+def test_worker_queues_requested_rows_once(db_session: Session, monkeypatch):
+    monkeypatch.setattr(
+        worker_module, "SessionLocal", sessionmaker(bind=db_session.get_bind(), autoflush=False)
+    )
+    execution = SchedulerExecution(
+        scheduler_name="smart_scan",
+        trigger_type=TriggerType.MANUAL.value,
+        started_at=datetime.now(timezone.utc),
+        status=SchedulerStatus.REQUESTED.value,
+    )
+    db_session.add(execution)
+    db_session.commit()
+
+    worker = worker_module.SchedulerWorker()
+    release = threading.Event()
+    dispatched = []
+
+    def fake_execute(execution_id, name):
+        dispatched.append((execution_id, name))
+        release.wait(5)
+
+    monkeypatch.setattr(worker, "_execute_job", fake_execute)
+    try:
+        worker._poll_requested_executions()
+        _wait_for(lambda: dispatched)
+        worker._poll_requested_executions()  # already running -> not queued again
+
+        db_session.expire_all()
+        assert db_session.get(SchedulerExecution, execution.id).status == SchedulerStatus.RUNNING.value
+        assert dispatched == [(execution.id, "smart_scan")]
+        assert worker.pool.queued() == []
+    finally:
+        release.set()
+        worker.pool.shutdown(wait=True, timeout=2)
@@ -0,0 +1,48 @@
+"""Tests for the TinyLFU frequency sketch used for SSD cache admission."""
+import pytest
+
+from app.services.cache.admission import MAX_COUNT, FrequencySketch
+
+
+@pytest.fixture
+def sketch(tmp_path):
+    s = FrequencySketch(tmp_path / "sketch.bin", width=1024)
+    yield s
+    s.close()
+
+
+class TestFrequencySketch:
+    def test_unseen_is_zero(self, sketch):
+        assert sketch.estimate("md0", "a.txt") == 0
+
+    def test_counts_increments(self, sketch):
+        for _ in range(3):
+            sketch.increment("md0", "a.txt")
+        assert sketch.estimate("md0", "a.txt") == 3
+        assert sketch.estimate("md1", "a.txt") == 0
+
+    def test_saturates(self, sketch):
+        for _ in range(MAX_COUNT + 10):
+            sketch.increment("md0", "a.txt")
+        assert sketch.estimate("md0", "a.txt") == MAX_COUNT
+
+    def test_aging_halves_counters(self, sketch):
+        for _ in range(8):
+            sketch.increment("md0", "a.txt")
+        for i in range(sketch.sample_size - 8):
+            sketch.increment("md0", f"filler-{i % 50}")
+        assert sketch.estimate("md0", "a.txt") == 4
+
+    def test_shared_between_mappings(self, sketch, tmp_path):
+        other = FrequencySketch(tmp_path / "sketch.bin", width=1024)
+        try:
+            sketch.increment("md0", "a.txt")
+            other.increment("md0", "a.txt")
+            assert sketch.estimate("md0", "a.txt") == 2
+        finally:
+            other.close()
+
+    def test_clear(self, sketch):
+        sketch.increment("md0", "a.txt")
+        sketch.clear()
+        assert sketch.estimate("md0", "a.txt") == 0
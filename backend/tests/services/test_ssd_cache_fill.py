@@ -0,0 +1,183 @@
+"""Tests for the SSD cache-fill pipeline and copy primitives."""
+import asyncio
+import os
+from pathlib import Path
+
+import pytest
+
+from app.services.cache import fill_io
+from app.services.cache.fill import CacheFillPipeline, FillJob, next_in_series
+from app.services.cache.fill_io import ByteBudget, copy_file_budgeted
+
+try:
+    import fcntl
+except ImportError:  # pragma: no cover - Windows
+    fcntl = None
+
+
+class TestCopy:
+    def test_copies_content_and_mtime(self, tmp_path: Path):
+        src = tmp_path / "src.bin"
+        src.write_bytes(os.urandom(3 * 1024 * 1024 + 17))
+        os.utime(src, (1_000_000, 1_000_000))
+        dst = tmp_path / "dst.bin"
+
+        assert copy_file_budgeted(src, dst) is True
+        assert dst.read_bytes() == src.read_bytes()
+        assert dst.stat().st_mtime == 1_000_000
+        assert not (tmp_path / "dst.bin.part").exists()
+
+    def test_small_slices(self, tmp_path: Path, monkeypatch):
+        monkeypatch.setattr(fill_io, "COPY_SLICE_BYTES", 4096)
+        src = tmp_path / "src.bin"
+        src.write_bytes(os.urandom(50_000))
+        dst = tmp_path / "dst.bin"
+        assert copy_file_budgeted(src, dst)
+        assert dst.read_bytes() == src.read_bytes()
+
+    @pytest.mark.skipif(fcntl is None, reason="flock not available")
+    def test_concurrent_fill_is_skipped(self, tmp_path: Path):
+        src = tmp_path / "src.bin"
+        src.write_bytes(b"x" * 1024)
+        dst = tmp_path / "dst.bin"
+        holder = os.open(tmp_path / "dst.bin.part", os.O_WRONLY | os.O_CREAT)
+        try:
+            fcntl.flock(holder, fcntl.LOCK_EX)
+            assert copy_file_budgeted(src, dst) is False
+            assert not dst.exists()
+        finally:
+            os.close(holder)
+
+    def test_digest_covers_the_copied_bytes(self, tmp_path: Path, monkeypatch):
+        import hashlib
+
+        monkeypatch.setattr(fill_io, "COPY_SLICE_BYTES", 4096)
+        src = tmp_path / "src.bin"
+        src.write_bytes(os.urandom(50_000))
+        dst = tmp_path / "dst.bin"
+        digest = hashlib.sha256()
+
+        assert copy_file_budgeted(src, dst, digest=digest)
+        assert digest.hexdigest() == hashlib.sha256(src.read_bytes()).hexdigest()
+        assert dst.read_bytes() == src.read_bytes()
+
+    @pytest.mark.skipif(not hasattr(os, "copy_file_range"), reason="copy_file_range not available")
+    def test_digest_keeps_the_in_kernel_copy(self, tmp_path: Path, monkeypatch):
+        import hashlib
+
+        calls = []
+        real = os.copy_file_range
+        monkeypatch.setattr(os, "copy_file_range", lambda *a: calls.append(a) or real(*a))
+        monkeypatch.setattr(os, "pread", lambda *a: pytest.fail("source read through user space"))
+        src = tmp_path / "src.bin"
+        src.write_bytes(os.urandom(50_000))
+        dst = tmp_path / "dst.bin"
+        digest = hashlib.sha256()
+
+        assert copy_file_budgeted(src, dst, digest=digest)
+        assert calls
+        assert digest.hexdigest() == hashlib.sha256(src.read_bytes()).hexdigest()
+
+    @pytest.mark.skipif(fcntl is None, reason="flock not available")
+    def test_part_renamed_away_before_our_lock_is_not_truncated(self, tmp_path: Path, monkeypatch):
+        src = tmp_path / "src.bin"
+        src.write_bytes(b"new" * 100)
+        dst = tmp_path / "dst.bin"
+        part = tmp_path / "dst.bin.part"
+        part.write_bytes(b"finished fill")
+        real_flock = fill_io.fcntl.flock
+        raced = []
+
+        def _flock(fd, op):
+            # The previous holder finishes between our open and our flock
+            if not raced:
+                raced.append(True)
+                os.replace(part, dst)
+            return real_flock(fd, op)
+
+        monkeypatch.setattr(fill_io.fcntl, "flock", _flock)
+
+        assert copy_file_budgeted(src, dst) is True
+        assert dst.read_bytes() == b"new" * 100
+
+    def test_budget_paces(self, monkeypatch):
+        sleeps = []
+        monkeypatch.setattr(fill_io.time, "sleep", sleeps.append)
+        budget = ByteBudget(rate=1000, burst=1000)
+        budget.consume(1000)
+        assert not sleeps
+        budget.consume(500)
+        assert sleeps and sleeps[0] == pytest.approx(0.5, abs=0.05)
+
+    def test_unlimited_budget(self, monkeypatch):
+        monkeypatch.setattr(fill_io.time, "sleep", lambda _s: pytest.fail("slept"))
+        ByteBudget(rate=0).consume(10 ** 12)
+
+
+class TestReadahead:
+    def test_natural_order(self, tmp_path: Path):
+        for n in (1, 2, 10):
+            (tmp_path / f"Show S01E{n} x.mkv").write_bytes(b"")
+        (tmp_path / "notes.txt").write_bytes(b"")
+        assert next_in_series(tmp_path / "Show S01E2 x.mkv") == tmp_path / "Show S01E10 x.mkv"
+        assert next_in_series(tmp_path / "Show S01E10 x.mkv") is None
+
+    def test_non_media_ignored(self, tmp_path: Path):
+        (tmp_path / "a1.pdf").write_bytes(b"")
+        (tmp_path / "a2.pdf").write_bytes(b"")
+        assert next_in_series(tmp_path / "a1.pdf") is None
+
+
+class TestPipeline:
+    @pytest.mark.asyncio
+    async def test_dedup_and_process(self, tmp_path: Path, monkeypatch):
+        pipeline = CacheFillPipeline(max_queue=8)
+        seen = []
+        monkeypatch.setattr(pipeline, "_fill", lambda job: seen.append(job.resource_path))
+
+        assert pipeline.submit("u/a.bin", tmp_path / "a.bin") is True
+        assert pipeline.submit("u/a.bin", tmp_path / "a.bin") is False
+        await pipeline.join()
+        assert seen == ["u/a.bin"]
+        # Finished fills can be queued again
+        assert pipeline.submit("u/a.bin", tmp_path / "a.bin") is True
+        await pipeline.join()
+        await pipeline.shutdown()
+
+    @pytest.mark.asyncio
+    async def test_queue_full_drops(self, tmp_path: Path, monkeypatch):
+        pipeline = CacheFillPipeline(max_queue=1, concurrency=0)
+        assert pipeline.submit("u/a.bin", tmp_path / "a.bin") is True
+        assert pipeline.submit("u/b.bin", tmp_path / "b.bin") is False
+        # The dropped job must not stay claimed
+        assert ("md0", "u/b.bin") not in pipeline._pending
+        await pipeline.shutdown()
+
+    def test_readahead_job_resolves_successor(self, tmp_path: Path, monkeypatch):
+        (tmp_path / "ep01.mkv").write_bytes(b"")
+        (tmp_path / "ep02.mkv").write_bytes(b"")
+        pipeline = CacheFillPipeline()
+        filled = []
+        monkeypatch.setattr(pipeline, "_fill", lambda job: filled.append(job) or None)
+
+        pipeline.run_job(FillJob("md0", "u/show/ep01.mkv", tmp_path / "ep01.mkv", prefetch_next=True))
+        assert [(j.resource_path, j.file_path) for j in filled] == [
+            ("u/show/ep02.mkv", tmp_path / "ep02.mkv"),
+        ]
+        assert not pipeline._pending
+
+    def test_no_loop_no_submit(self, tmp_path: Path):
+        assert CacheFillPipeline().submit("u/a.bin", tmp_path / "a.bin") is False
+
+
+def test_pipeline_runs_on_fresh_loops(tmp_path: Path, monkeypatch):
+    """The singleton outlives event loops (each TestClient has its own)."""
+    pipeline = CacheFillPipeline()
+    monkeypatch.setattr(pipeline, "_fill", lambda job: None)
+
+    async def _once(name):
+        assert pipeline.submit(name, tmp_path / name)
+        await pipeline.join()
+
+    asyncio.run(_once("a"))
+    asyncio.run(_once("b"))
@@ -0,0 +1,124 @@
+"""Tests for the shared SSD cache hot index and batched access stats."""
+import time
+
+import pytest
+
+from app.services.cache import hot_index as hot_index_mod
+from app.services.cache.access_stats import CacheAccessStats
+from app.services.cache.hot_index import SSDCacheHotIndex
+
+
+@pytest.fixture
+def index(tmp_path):
+    idx = SSDCacheHotIndex(tmp_path / "index.bin", slot_count=64)
+    yield idx
+    idx.close()
+
+
+class TestHotIndex:
+    def test_unknown_key(self, index):
+        assert index.lookup("md0", "a/b.txt") is None
+
+    def test_hit_roundtrip(self, index):
+        index.put_hit(
+            "md0", "a/b.txt", cache_path="/ssd/a/b.txt",
+            source_mtime=12.5, entry_id=7, file_size=4096,
+        )
+        record = index.lookup("md0", "a/b.txt")
+        assert record.is_hit
+        assert (record.cache_path, record.source_mtime, record.entry_id, record.file_size) == (
+            "/ssd/a/b.txt", 12.5, 7, 4096,
+        )
+        assert index.lookup("md1", "a/b.txt") is None
+
+    def test_miss_then_hit_overwrites(self, index):
+        index.put_miss("md0", "x", 1.0)
+        assert index.lookup("md0", "x").is_miss
+        index.put_hit("md0", "x", cache_path="/ssd/x", source_mtime=1.0, entry_id=1, file_size=1)
+        assert index.lookup("md0", "x").is_hit
+
+    def test_remove(self, index):
+        index.put_hit("md0", "x", cache_path="/ssd/x", source_mtime=1.0, entry_id=1, file_size=1)
+        index.remove("md0", "x")
+        assert index.lookup("md0", "x") is None
+
+    def test_visible_across_mappings(self, index, tmp_path):
+        """Another worker mapping the same file sees writes and removals."""
+        other = SSDCacheHotIndex(tmp_path / "index.bin", slot_count=64)
+        try:
+            index.put_hit("md0", "x", cache_path="/ssd/x", source_mtime=1.0, entry_id=1, file_size=1)
+            assert other.lookup("md0", "x").is_hit
+            other.remove("md0", "x")
+            assert index.lookup("md0", "x") is None
+        finally:
+            other.close()
+
+    def test_bounded_table_evicts(self, index):
+        for i in range(500):
+            index.put_miss("md0", f"file{i}", 1.0)
+        assert index.lookup("md0", "file499").is_miss
+
+    def test_overlong_path_not_indexed(self, index):
+        index.put_hit("md0", "x", cache_path="/ssd/x", source_mtime=1.0, entry_id=1, file_size=1)
+        index.put_hit(
+            "md0", "x", cache_path="/" + "p" * 1000, source_mtime=1.0, entry_id=1, file_size=1,
+        )
+        assert index.lookup("md0", "x") is None
+
+    def test_miss_expires(self, index, monkeypatch):
+        index.put_miss("md0", "x", 1.0)
+        real = time.time
+        monkeypatch.setattr(
+            hot_index_mod.time, "time", lambda: real() + hot_index_mod.MISS_TTL_SECONDS + 1,
+        )
+        assert index.lookup("md0", "x") is None
+
+    def test_enabled_flag(self, index):
+        assert index.get_enabled("md0") is None
+        index.put_enabled("md0", True)
+        assert index.get_enabled("md0") is True
+        index.remove_config("md0")
+        assert index.get_enabled("md0") is None
+
+    def test_clear(self, index):
+        index.put_miss("md0", "x", 1.0)
+        index.clear()
+        assert index.lookup("md0", "x") is None
+
+    def test_geometry_change_reinitialises(self, index, tmp_path):
+        index.put_miss("md0", "x", 1.0)
+        index.close()
+        resized = SSDCacheHotIndex(tmp_path / "index.bin", slot_count=128)
+        try:
+            assert resized.lookup("md0", "x") is None
+        finally:
+            resized.close()
+
+    def test_unavailable_index_degrades(self, tmp_path):
+        blocker = tmp_path / "not-a-dir"
+        blocker.write_text("")
+        idx = SSDCacheHotIndex(blocker / "index.bin", slot_count=64)
+        assert not idx.available
+        idx.put_miss("md0", "x", 1.0)
+        assert idx.lookup("md0", "x") is None
+
+
+class TestAccessStats:
+    def test_noop_flush(self):
+        assert CacheAccessStats().flush() == 0
+
+    def test_failed_flush_keeps_counts(self):
+        stats = CacheAccessStats()
+        stats.record_hit("md0", 1, 100)
+        stats.record_hit("md0", 1, 100)
+        stats.record_miss("md0")
+
+        class _BrokenSession:
+            def execute(self, *args, **kwargs):
+                raise RuntimeError("db down")
+
+        with pytest.raises(RuntimeError):
+            stats.flush(_BrokenSession())
+        assert stats._pending.entries[1][0] == 2
+        assert stats._pending.arrays["md0"].misses == 1
+        assert stats._pending.arrays["md0"].bytes_served == 200
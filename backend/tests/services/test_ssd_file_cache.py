@@ -6,7 +6,8 @@ from unittest.mock import patch, MagicMock
 
 from sqlalchemy.orm import Session
 
-from app.models.ssd_file_cache import SSDCacheEntry, SSDCacheConfig
+from app.models.ssd_file_cache import SSDCacheEntry, SSDCacheConfig, lfru_priority
+from app.services.cache.admission import get_frequency_sketch
 from app.services.cache.ssd_file_cache import SSDFileCacheService
 from app.services.cache.eviction import EvictionManager
 
@@ -146,7 +147,7 @@ class TestSSDFileCacheService:
         """Cache miss returns None and increments miss counter."""
         result = cache_service.get_cached_path("nonexistent/file.txt", 123.0)
         assert result is None
-        db.flush()
+        cache_service.flush_access_stats()
         config = cache_service.get_config()
         assert int(config.total_misses) >= 1
 
@@ -178,9 +179,56 @@ class TestSSDFileCacheService:
             str(entry.source_path), float(entry.source_mtime)
         )
         assert result == cache_file
+        cache_service.flush_access_stats()
         db.refresh(entry)
         assert int(entry.access_count) > 0
 
+    def test_get_cached_path_hit_served_from_hot_index(
+        self, cache_service: SSDFileCacheService, sample_entries: list, db: Session, tmp_path: Path
+    ):
+        """A repeat hit needs no DB query; counts are batched until flush."""
+        entry = sample_entries[0]
+        cache_file = tmp_path / "cached.pdf"
+        cache_file.write_bytes(b"cached content")
+        entry.cache_path = str(cache_file)
+        db.commit()
+        source, mtime = str(entry.source_path), float(entry.source_mtime)
+
+        assert cache_service.get_cached_path(source, mtime) == cache_file
+        with patch.object(db, "query", side_effect=AssertionError("DB queried")):
+            assert cache_service.get_cached_path(source, mtime) == cache_file
+            assert cache_service.get_cached_path(source, mtime) == cache_file
+
+        db.refresh(entry)
+        assert int(entry.access_count) == 0  # nothing written on the hot path
+        cache_service.flush_access_stats()
+        db.refresh(entry)
+        config = cache_service.get_config()
+        db.refresh(config)
+        assert int(entry.access_count) == 3
+        assert int(config.total_hits) == 3
+
+    def test_invalidate_entry_drops_hot_index_hit(
+        self, cache_service: SSDFileCacheService, sample_entries: list, db: Session, tmp_path: Path
+    ):
+        """Invalidation is visible immediately (no 60s TTL window)."""
+        entry = sample_entries[0]
+        cache_file = tmp_path / "cached.pdf"
+        cache_file.write_bytes(b"cached content")
+        entry.cache_path = str(cache_file)
+        db.commit()
+        source, mtime = str(entry.source_path), float(entry.source_mtime)
+
+        assert cache_service.get_cached_path(source, mtime) == cache_file
+        cache_service.invalidate_entry(source)
+        assert cache_service.get_cached_path(source, mtime) is None
+
+    def test_update_config_refreshes_enabled_flag(self, cache_service: SSDFileCacheService):
+        """is_cache_enabled is cached in the hot index but reset by update_config."""
+        assert cache_service.is_cache_enabled() is True
+        cache_service.update_config({"is_enabled": False})
+        assert cache_service.is_cache_enabled() is False
+
     def test_get_cached_path_missing_file(
         self, cache_service: SSDFileCacheService, sample_entries: list, db: Session
     ):
@@ -320,6 +368,94 @@ class TestEvictionManager:
         candidates = em.get_eviction_candidates("lfru", needed)
         assert len(candidates) > 0
 
+    def test_lfru_priority_set_on_insert(self, sample_entries: list):
+        """eviction_priority is derived from access_count/last_accessed on insert."""
+        for e in sample_entries:
+            assert e.eviction_priority == pytest.approx(
+                lfru_priority(int(e.access_count), e.last_accessed)
+            )
+
+    def test_get_eviction_candidates_lfru_index_order(
+        self, db: Session, cache_config: SSDCacheConfig, sample_entries: list
+    ):
+        """LFRU candidates come back lowest-priority first, across batches."""
+        em = EvictionManager(db, ARRAY_NAME)
+        em.BATCH_SIZE = 2
+        candidates = em.get_eviction_candidates("lfru", 10 ** 12)
+        assert len(candidates) == len(sample_entries)
+        priorities = [c.eviction_priority for c in candidates]
+        assert priorities == sorted(priorities)
+        assert candidates[0].id == sample_entries[0].id  # never hit
+
+    def test_get_eviction_candidates_ties_across_batches(
+        self, db: Session, cache_config: SSDCacheConfig, sample_entries: list
+    ):
+        """Entries with equal sort keys are neither skipped nor repeated at batch edges."""
+        stamp = datetime(2026, 1, 1)
+        for e in sample_entries:
+            e.access_count = 1
+            e.last_accessed = stamp
+        db.commit()
+        em = EvictionManager(db, ARRAY_NAME)
+        em.BATCH_SIZE = 2
+        for policy in ("lru", "lfu"):
+            ids = [c.id for c in em.get_eviction_candidates(policy, 10 ** 12)]
+            assert ids == sorted(e.id for e in sample_entries), policy
+
+    def test_access_flush_refreshes_priority(
+        self, db: Session, cache_service: SSDFileCacheService, sample_entries: list
+    ):
+        """Batched hits raise an entry's priority so it stops being the first victim."""
+        cold = sample_entries[0]
+        before = cold.eviction_priority
+        for _ in range(20):
+            cache_service._record_hit(int(cold.id), int(cold.file_size_bytes))
+        cache_service.flush_access_stats()
+        db.refresh(cold)
+        assert int(cold.access_count) == 20
+        assert cold.eviction_priority > before
+        first = EvictionManager(db, ARRAY_NAME).get_eviction_candidates("lfru", 1)[0]
+        assert first.id != cold.id
+
+    def test_admit_rejects_one_off_read(
+        self, db: Session, cache_config: SSDCacheConfig, sample_entries: list
+    ):
+        """A file nobody has read before can't displace read entries."""
+        cache_config.current_size_bytes = int(cache_config.max_size_bytes)
+        db.commit()
+        sketch = get_frequency_sketch()
+        for e in sample_entries:
+            sketch.increment(ARRAY_NAME, str(e.source_path))
+
+        svc = SSDFileCacheService(db, ARRAY_NAME)
+        em = EvictionManager(db, ARRAY_NAME)
+        assert em.admit(svc, "user1/one-off.iso", 1024 * 1024) is False
+        assert db.query(SSDCacheEntry).count() == len(sample_entries)
+
+    def test_admit_popular_file_evicts_victims(
+        self, db: Session, cache_config: SSDCacheConfig, sample_entries: list
+    ):
+        """A file read more often than the victims is admitted and they are evicted."""
+        cache_config.current_size_bytes = int(cache_config.max_size_bytes)
+        db.commit()
+        sketch = get_frequency_sketch()
+        for _ in range(3):
+            sketch.increment(ARRAY_NAME, "user1/popular.mkv")
+
+        svc = SSDFileCacheService(db, ARRAY_NAME)
+        em = EvictionManager(db, ARRAY_NAME)
+        assert em.admit(svc, "user1/popular.mkv", 1024 * 1024) is True
+        db.flush()
+        remaining = {e.id for e in db.query(SSDCacheEntry).all()}
+        assert sample_entries[0].id not in remaining
+
+    def test_admit_file_larger_than_cache(
+        self, db: Session, cache_config: SSDCacheConfig, sample_entries: list
+    ):
+        em = EvictionManager(db, ARRAY_NAME)
+        svc = SSDFileCacheService(db, ARRAY_NAME)
+        assert em.admit(svc, "huge.bin", int(cache_config.max_size_bytes) + 1) is False
+
     def test_eviction_prefers_invalid_entries(
         self, db: Session, cache_config: SSDCacheConfig, sample_entries: list
     ):
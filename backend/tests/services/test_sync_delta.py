@@ -0,0 +1,99 @@
+"""Tests for the rsync-style block delta used by delta sync."""
+import io
+import random
+
+import pytest
+
+from app.services.sync.delta import (
+    BaseMismatchError,
+    DeltaError,
+    DeltaLimitError,
+    apply_delta,
+    compute_delta,
+    compute_signature,
+)
+
+
+def _random_bytes(size: int, seed: int = 1) -> bytes:
+    return random.Random(seed).randbytes(size)
+
+
+def _delta(base: bytes, new: bytes) -> bytes:
+    signature = compute_signature(io.BytesIO(base), len(base))
+    return b"".join(compute_delta(signature, new))
+
+
+def _apply(base: bytes, delta: bytes) -> bytes:
+    out = io.BytesIO()
+    size, _ = apply_delta(io.BytesIO(base), io.BytesIO(delta), out, len(base))
+    assert size == len(out.getvalue())
+    return out.getvalue()
+
+
+BASE = _random_bytes(2 * 1024 * 1024 + 123)
+
+
+@pytest.mark.parametrize("new", [
+    BASE,
+    BASE[:1_000_000] + b"inserted" + BASE[1_000_000:],
+    BASE[:500] + BASE[70_000:],
+    BASE + b"appended",
+    BASE[:-50],
+    b"",
+    _random_bytes(50_000, seed=2),
+])
+def test_roundtrip(new):
+    assert _apply(BASE, _delta(BASE, new)) == new
+
+
+def test_small_edit_sends_little():
+    edited = BASE[:1_000_000] + b"inserted" + BASE[1_000_000:]
+    assert len(_delta(BASE, edited)) < 8 * 1024
+
+
+def test_empty_base():
+    assert _apply(b"", _delta(b"", b"new content")) == b"new content"
+
+
+def test_wrong_base_is_rejected():
+    delta = _delta(BASE, BASE[:-10] + b"0123456789")
+    other = BASE[:100] + b"X" + BASE[101:]
+    with pytest.raises(BaseMismatchError):
+        _apply(other, delta)
+    with pytest.raises(BaseMismatchError):
+        _apply(BASE[:-1], delta)
+
+
+def test_malformed_delta_is_rejected():
+    delta = _delta(BASE, BASE)
+    with pytest.raises(DeltaError):
+        _apply(BASE, delta[:-5])
+    with pytest.raises(DeltaError):
+        _apply(BASE, b"nope" + delta[4:])
+
+
+def test_invalid_signature_is_rejected():
+    signature = compute_signature(io.BytesIO(BASE), len(BASE))
+    signature["blocks"] = signature["blocks"][:-1]
+    with pytest.raises(DeltaError):
+        list(compute_delta(signature, BASE))
+
+
+def test_rolling_budget_falls_back_to_literal_data():
+    shifted = b"x" * 100 + BASE
+    signature = compute_signature(io.BytesIO(BASE), len(BASE))
+
+    capped = b"".join(compute_delta(signature, shifted, max_rolled=10))
+
+    assert len(capped) > 1024 * 1024  # no match found within the budget
+    assert _apply(BASE, capped) == shifted
+    assert len(_delta(BASE, shifted)) < 8 * 1024
+
+
+def test_result_size_limit():
+    delta = _delta(BASE, BASE + b"appended")
+    with pytest.raises(DeltaLimitError):
+        apply_delta(io.BytesIO(BASE), io.BytesIO(delta), io.BytesIO(), len(BASE), max_size=len(BASE))
+    out = io.BytesIO()
+    size, _ = apply_delta(io.BytesIO(BASE), io.BytesIO(delta), out, len(BASE), max_size=len(BASE) + 8)
+    assert size == len(BASE) + 8
@@ -0,0 +1,98 @@
+"""Tests for the sync change journal and cursor-based change detection."""
+from datetime import datetime, timedelta, timezone
+
+from app.models.sync_state import SyncChange
+from app.services.files import metadata_db
+from app.services.sync.file_sync import FileSyncService
+from app.services.sync.journal import Cursor, changes_since, current_cursor, parse_cursor, prune_journal
+
+
+def _register(db_session, user):
+    service = FileSyncService(db_session)
+    service.register_device(user.id, "laptop", "Laptop")
+    return service
+
+
+def test_metadata_changes_are_journaled(db_session, regular_user):
+    metadata_db.create_metadata("docs/a.txt", "a.txt", regular_user.id, size_bytes=3, db=db_session)
+    metadata_db.update_metadata("docs/a.txt", size_bytes=5, checksum="abc", db=db_session)
+    metadata_db.rename_metadata("docs/a.txt", "docs/b.txt", "b.txt", db=db_session)
+    metadata_db.delete_metadata("docs/b.txt", db=db_session)
+
+    rows = db_session.query(SyncChange).order_by(SyncChange.id).all()
+    assert [(r.action, r.path, r.old_path) for r in rows] == [
+        ("upsert", "docs/a.txt", None),
+        ("upsert", "docs/a.txt", None),
+        ("move", "docs/b.txt", "docs/a.txt"),
+        ("delete", "docs/b.txt", None),
+    ]
+    assert rows[1].size_bytes == 5 and rows[1].checksum == "abc"
+
+
+def test_changes_since_cursor(db_session, regular_user, admin_user):
+    service = _register(db_session, regular_user)
+    metadata_db.create_metadata("a.txt", "a.txt", regular_user.id, db=db_session)
+    token = service.detect_changes(regular_user.id, "laptop", [])["change_token"]
+
+    metadata_db.create_metadata("b.txt", "b.txt", regular_user.id, db=db_session)
+    metadata_db.create_metadata("other.txt", "other.txt", admin_user.id, db=db_session)
+    result = service.get_changes_since(regular_user.id, "laptop", token, limit=100)
+
+    assert not result["reset_required"] and not result["has_more"]
+    assert [c["path"] for c in result["changes"]] == ["b.txt"]
+    # Not past the last returned entry, even though other.txt came later
+    assert result["cursor"] == str(result["changes"][-1]["cursor"])
+
+    again = service.get_changes_since(regular_user.id, "laptop", result["cursor"], limit=100)
+    assert again["changes"] == []
+
+
+def test_changes_since_pages(db_session, regular_user):
+    for i in range(5):
+        metadata_db.create_metadata(f"f{i}.txt", f"f{i}.txt", regular_user.id, db=db_session)
+    first = changes_since(db_session, regular_user.id, Cursor(0), limit=3)
+    assert first["has_more"] and len(first["changes"]) == 3
+    second = changes_since(db_session, regular_user.id, first["cursor"], limit=3)
+    assert not second["has_more"]
+    assert [c["path"] for c in first["changes"] + second["changes"]] == [f"f{i}.txt" for i in range(5)]
+
+
+def test_unknown_or_pruned_cursor_requires_reset(db_session, regular_user):
+    service = _register(db_session, regular_user)
+    assert service.get_changes_since(regular_user.id, "laptop", None, 100)["reset_required"]
+    assert service.get_changes_since(regular_user.id, "laptop", "3f2c-uuid-token", 100)["reset_required"]
+
+    for i in range(3):
+        metadata_db.create_metadata(f"f{i}.txt", f"f{i}.txt", regular_user.id, db=db_session)
+    db_session.query(SyncChange).update(
+        {SyncChange.created_at: datetime.now(timezone.utc) - timedelta(days=60)}
+    )
+    db_session.commit()
+    assert prune_journal(db_session, retention_days=30) == 2  # newest entry is kept
+
+    assert changes_since(db_session, regular_user.id, Cursor(0), 100)["reset_required"]
+    assert not changes_since(db_session, regular_user.id, current_cursor(db_session), 100)["reset_required"]
+
+
+def test_detect_changes_uses_journal_cursor(db_session, regular_user):
+    service = _register(db_session, regular_user)
+    metadata_db.create_metadata("a.txt", "a.txt", regular_user.id, size_bytes=1, db=db_session)
+    metadata_db.create_metadata("b.txt", "b.txt", regular_user.id, size_bytes=2, db=db_session)
+
+    changes = service.detect_changes(
+        regular_user.id, "laptop",
+        [{"path": "b.txt", "hash": "x", "size": 2, "modified_at": "2026-01-01T00:00:00"},
+         {"path": "gone.txt", "hash": "y", "size": 1, "modified_at": "2026-01-01T00:00:00"}],
+    )
+    assert [c["path"] for c in changes["to_download"]] == ["a.txt"]
+    assert changes["to_delete"] == [{"path": "gone.txt"}]
+    assert changes["change_token"] == str(current_cursor(db_session))
+
+
+def test_cursor_wire_form_round_trips():
+    assert parse_cursor("42") == Cursor(42)
+    assert str(Cursor(42)) == "42"
+    pending = Cursor(42, 50, 57, 9001)
+    assert parse_cursor(str(pending)) == pending
+    for token in ("", "1:2", "-1", "1:2:3:x"):
+        assert parse_cursor(token) is None
@@ -0,0 +1,187 @@
+"""Tests for content-defined chunking and the VCL chunk store."""
+import hashlib
+import random
+
+import pytest
+from sqlalchemy.orm import Session
+
+from app.core.config import settings
+from app.models.file_metadata import FileMetadata
+from app.models.user import User
+from app.models.vcl import FileVersion, VersionBlob, VersionBlobChunk, VersionChunk
+from app.services.versioning.chunking import MAX_CHUNK_SIZE, MIN_CHUNK_SIZE, chunk_bytes
+from app.services.versioning.vcl import VCLService
+
+
+def _random_bytes(size: int, seed: int = 1) -> bytes:
+    return random.Random(seed).randbytes(size)
+
+
+def _hashes(chunks):
+    return [hashlib.sha256(c).hexdigest() for c in chunks]
+
+
+class TestChunker:
+    def test_roundtrip_and_bounds(self):
+        data = _random_bytes(3 * 1024 * 1024)
+        chunks = chunk_bytes(data)
+        assert b"".join(chunks) == data
+        assert all(len(c) <= MAX_CHUNK_SIZE for c in chunks)
+        assert all(len(c) >= MIN_CHUNK_SIZE for c in chunks[:-1])
+
+    def test_independent_of_read_size(self):
+        data = _random_bytes(2 * 1024 * 1024, seed=2)
+        assert chunk_bytes(data) == chunk_bytes(data, read_size=4099)
+
+    def test_insert_only_changes_nearby_chunks(self):
+        data = _random_bytes(4 * 1024 * 1024, seed=3)
+        edited = data[:2_000_000] + b"inserted" + data[2_000_000:]
+        before, after = set(_hashes(chunk_bytes(data))), _hashes(chunk_bytes(edited))
+        assert sum(1 for h in after if h not in before) <= 2
+
+    def test_empty_and_small(self):
+        assert chunk_bytes(b"") == []
+        assert chunk_bytes(b"abc") == [b"abc"]
+
+
+@pytest.fixture
+def vcl_service(db: Session, tmp_path, monkeypatch):
+    monkeypatch.setattr(settings, "vcl_storage_path", str(tmp_path / "versions"))
+    return VCLService(db)
+
+
+@pytest.fixture
+def test_user(db: Session):
+    user = User(username="chunkuser", email="chunk@example.com", hashed_password="hashed",
+                role="user", is_active=True)
+    db.add(user)
+    db.commit()
+    return user
+
+
+@pytest.fixture
+def test_file(db: Session, test_user: User):
+    file = FileMetadata(path="/test/disk.img", name="disk.img", owner_id=test_user.id,
+                        size_bytes=4 * 1024 * 1024, is_directory=False,
+                        mime_type="application/octet-stream")
+    db.add(file)
+    db.commit()
+    return file
+
+
+class TestChunkStore:
+    def test_small_content_uses_single_blob(self, vcl_service, db, test_file, test_user):
+        version = vcl_service.create_version(test_file, b"tiny", test_user.id)
+        assert version.blob.storage_format == "gzip"
+
+    def test_large_content_is_chunked(self, vcl_service, db, test_file, test_user):
+        content = _random_bytes(3 * 1024 * 1024)
+        version = vcl_service.create_version(test_file, content, test_user.id)
+        db.commit()
+        assert version.blob.storage_format == "chunked"
+        assert db.query(VersionBlobChunk).filter_by(blob_id=version.blob_id).count() > 1
+        assert vcl_service.get_version_content(version) == content
+        assert b"".join(vcl_service.iter_version_content(version)) == content
+
+    def test_edit_writes_only_changed_chunks(self, vcl_service, db, test_file, test_user):
+        content = _random_bytes(4 * 1024 * 1024, seed=5)
+        first = vcl_service.create_version(test_file, content, test_user.id)
+        chunks_before = db.query(VersionChunk).count()
+        edited = content[:1_000_000] + b"patch" + content[1_000_005:]
+        second = vcl_service.create_version(test_file, edited, test_user.id)
+        db.commit()
+
+        assert db.query(VersionChunk).count() - chunks_before <= 2
+        assert second.blob.compressed_size < first.blob.compressed_size / 4
+        assert vcl_service.get_version_content(second) == edited
+        assert vcl_service.get_version_content(first) == content
+
+    def test_delete_frees_only_unshared_chunks(self, vcl_service, db, test_file, test_user):
+        content = _random_bytes(4 * 1024 * 1024, seed=6)
+        first = vcl_service.create_version(test_file, content, test_user.id)
+        second = vcl_service.create_version(test_file, content[:-10] + b"0123456789", test_user.id)
+        db.commit()
+        first_size = first.compressed_size
+
+        freed = vcl_service.delete_version(first)
+        db.commit()
+        assert 0 < freed < first_size
+        assert vcl_service.get_version_content(second).endswith(b"0123456789")
+
+        blob_id = second.blob_id
+        vcl_service.delete_version(second)
+        db.commit()
+        assert db.query(VersionChunk).count() == 0
+        assert db.query(VersionBlobChunk).count() == 0
+        assert db.query(VersionBlob).filter_by(id=blob_id).first() is None
+        assert not list(vcl_service.blobs_path.glob("chunk-*.gz"))
+
+    def test_missing_chunk_detected_up_front(self, vcl_service, db, test_file, test_user):
+        version = vcl_service.create_version(test_file, _random_bytes(2 * 1024 * 1024), test_user.id)
+        db.commit()
+        next(vcl_service.blobs_path.glob("chunk-*.gz")).unlink()
+        with pytest.raises(FileNotFoundError):
+            vcl_service.iter_version_content(version)
+
+    def test_rolled_back_delete_keeps_chunk_files(self, vcl_service, db, test_file, test_user):
+        content = _random_bytes(2 * 1024 * 1024, seed=7)
+        version = vcl_service.create_version(test_file, content, test_user.id)
+        db.commit()
+        version_id = version.id
+
+        vcl_service.delete_version(version)
+        assert list(vcl_service.blobs_path.glob("chunk-*"))  # nothing unlinked yet
+        db.rollback()
+
+        restored = db.get(FileVersion, version_id)
+        assert vcl_service.get_version_content(restored) == content
+
+    def test_chunk_inserted_concurrently_is_reused(self, vcl_service, db, test_file, test_user, monkeypatch):
+        content = _random_bytes(2 * 1024 * 1024, seed=8)
+        first = vcl_service.create_version(test_file, content, test_user.id)
+        db.commit()
+        chunks_before = db.query(VersionChunk).count()
+
+        # Another upload inserted the chunks between our lookup and our insert
+        real_lookup = vcl_service._chunk_ids
+        calls = []
+
+        def _stale_lookup(checksums):
+            calls.append(checksums)
+            return {} if len(calls) % 2 else real_lookup(checksums)
+
+        monkeypatch.setattr(vcl_service, "_chunk_ids", _stale_lookup)
+        second = vcl_service.create_version(test_file, content + b"tail", test_user.id)
+        db.commit()
+
+        assert db.query(VersionChunk).count() - chunks_before <= 2
+        assert second.blob.compressed_size < first.blob.compressed_size / 4
+        assert vcl_service.get_version_content(second) == content + b"tail"
+
+    def test_version_from_file_streams_the_content(self, vcl_service, db, test_file, test_user, tmp_path):
+        content = _random_bytes(3 * 1024 * 1024, seed=9)
+        source = tmp_path / "disk.img"
+        source.write_bytes(content)
+
+        version = vcl_service.create_version_from_file(test_file, source, test_user.id)
+        db.commit()
+
+        assert version.blob.storage_format == "chunked"
+        assert version.file_size == version.blob.original_size == len(content)
+        assert version.checksum == hashlib.sha256(content).hexdigest()
+        assert vcl_service.get_version_content(version) == content
+
+    def test_usage_returns_to_zero_whichever_version_frees_shared_chunks(
+        self, vcl_service, db, test_file, test_user
+    ):
+        content = _random_bytes(4 * 1024 * 1024, seed=10)
+        first = vcl_service.create_version(test_file, content, test_user.id)
+        second = vcl_service.create_version(test_file, content[:-10] + b"0123456789", test_user.id)
+        db.commit()
+
+        vcl_service.delete_version(first)
+        vcl_service.delete_version(second)
+        db.commit()
+
+        assert vcl_service.get_user_settings(test_user.id).current_usage_bytes == 0
+        assert vcl_service.get_stats().total_compressed_bytes == 0
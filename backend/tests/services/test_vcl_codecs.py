@@ -0,0 +1,127 @@
+"""Tests for VCL blob codecs, incompressible detection and streaming reads."""
+import json
+import random
+from pathlib import Path
+
+import pytest
+from sqlalchemy.orm import Session
+
+from app.core.config import settings
+from app.models.vcl import VersionChunk
+from app.services.versioning import codecs
+from app.services.versioning.codecs import (
+    DictionaryStore,
+    GzipCodec,
+    RawCodec,
+    ZstdCodec,
+    is_incompressible,
+    sample_entropy,
+)
+from app.services.versioning.vcl import VCLService
+
+needs_zstd = pytest.mark.skipif(not codecs.zstd_available(), reason="zstandard not installed")
+
+TEXT = b"".join(b"line %d: the quick brown fox jumps over the lazy dog\n" % i for i in range(4000))
+
+
+def _random_bytes(size: int, seed: int = 1) -> bytes:
+    return random.Random(seed).randbytes(size)
+
+
+class TestEntropy:
+    def test_random_data_is_incompressible(self):
+        assert sample_entropy(_random_bytes(256 * 1024)) > 7.9
+        assert is_incompressible(_random_bytes(256 * 1024))
+
+    def test_text_is_compressible(self):
+        assert sample_entropy(TEXT) < 6
+        assert not is_incompressible(TEXT)
+
+    def test_small_data_is_always_compressed(self):
+        assert not is_incompressible(_random_bytes(1024))
+
+
+def _roundtrip(codec, tmp_path: Path):
+    assert codec.decompress(codec.compress(TEXT)) == TEXT
+    path = tmp_path / f"blob{codec.suffix}"
+    size = codec.write(TEXT, path)
+    assert size == path.stat().st_size
+    with codec.open_reader(path) as f:
+        assert f.read(100) == TEXT[:100]
+        assert TEXT[:100] + f.read() == TEXT
+    streamed = tmp_path / f"streamed{codec.suffix}"
+    with codec.open_writer(streamed) as f:
+        f.write(TEXT[:1000])
+        f.write(TEXT[1000:])
+    with codec.open_reader(streamed) as f:
+        assert f.read() == TEXT
+
+
+class TestCodecs:
+    def test_gzip(self, tmp_path):
+        _roundtrip(GzipCodec(), tmp_path)
+
+    def test_raw(self, tmp_path):
+        _roundtrip(RawCodec(), tmp_path)
+        assert RawCodec().compress(b"abc") == b"abc"
+
+    @needs_zstd
+    def test_zstd(self, tmp_path):
+        _roundtrip(ZstdCodec(threads=2), tmp_path)
+
+    @needs_zstd
+    def test_zstd_dictionary_roundtrip(self, tmp_path):
+        rng = random.Random(7)
+        samples = [
+            json.dumps({"id": i, "name": f"user{i}", "tags": rng.sample(range(100), 5)}).encode()
+            for i in range(500)
+        ]
+        store = DictionaryStore(tmp_path)
+        dict_id = store.train(samples, dict_size=8 * 1024)
+        assert (tmp_path / f"dict-{dict_id}.zdict").exists()
+
+        codec = ZstdCodec(dictionaries=store)
+        payload = codec.compress(samples[0])
+        assert len(payload) < len(ZstdCodec().compress(samples[0]))
+        # A fresh store (another worker) finds the dictionary by frame id
+        assert ZstdCodec(dictionaries=DictionaryStore(tmp_path)).decompress(payload) == samples[0]
+
+
+@pytest.fixture
+def vcl_service(db: Session, tmp_path, monkeypatch):
+    monkeypatch.setattr(settings, "vcl_storage_path", str(tmp_path / "versions"))
+    return VCLService(db)
+
+
+class TestServiceCodecs:
+    def test_incompressible_blob_stored_raw(self, vcl_service):
+        content = _random_bytes(128 * 1024)
+        blob = vcl_service.create_blob(content, vcl_service.calculate_checksum(content))
+        assert blob.storage_format == "raw"
+        assert blob.storage_path.endswith(".raw")
+        assert blob.compressed_size == len(content)
+
+    def test_text_blob_uses_default_codec(self, vcl_service):
+        blob = vcl_service.create_blob(TEXT, vcl_service.calculate_checksum(TEXT))
+        assert blob.storage_format == vcl_service.codec.name
+        assert blob.compressed_size < len(TEXT) / 4
+
+    def test_chunks_record_codec(self, vcl_service, db):
+        content = TEXT * 8 + _random_bytes(2 * 1024 * 1024)
+        blob = vcl_service.create_blob(content, vcl_service.calculate_checksum(content))
+        chunk_codecs = {c for (c,) in db.query(VersionChunk.codec)}
+        assert chunk_codecs == {"raw", vcl_service.codec.name}
+        assert blob.storage_format == "chunked"
+
+    def test_legacy_gzip_blob_still_readable(self, vcl_service, db, tmp_path):
+        vcl_service.codec = vcl_service.codecs["gzip"]
+        blob = vcl_service.create_blob(TEXT, vcl_service.calculate_checksum(TEXT))
+        db.commit()
+        assert blob.storage_format == "gzip"
+        reader = VCLService(db)
+        with reader.get_codec(blob.storage_format).open_reader(Path(blob.storage_path)) as f:
+            assert f.read() == TEXT
+
+    def test_unknown_codec_is_an_error(self, vcl_service):
+        with pytest.raises(ValueError):
+            vcl_service.get_codec("lzma")
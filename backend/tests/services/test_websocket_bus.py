@@ -0,0 +1,116 @@
+"""Tests for services/websocket_bus.py — cross-worker WebSocket fan-out."""
+
+import asyncio
+import json
+import socket
+from unittest.mock import AsyncMock, MagicMock
+
+import pytest
+
+from app.services.websocket_bus import MAX_DATAGRAM_BYTES, WebSocketBus
+from app.services.websocket_manager import WebSocketManager
+
+
+def _make_ws() -> MagicMock:
+    ws = MagicMock()
+    ws.send_text = AsyncMock()
+    ws.close = AsyncMock()
+    return ws
+
+
+async def _settle() -> None:
+    for _ in range(5):
+        await asyncio.sleep(0.01)
+
+
+@pytest.fixture
+def bus_dir(tmp_path):
+    return tmp_path / "ws_bus"
+
+
+@pytest.mark.asyncio
+class TestBus:
+    async def test_publish_reaches_other_workers_only(self, bus_dir):
+        got_a, got_b = [], []
+        a = WebSocketBus(lambda h, f: got_a.append((h, f)), bus_dir, name="1001")
+        b = WebSocketBus(lambda h, f: got_b.append((h, f)), bus_dir, name="1002")
+        assert a.start() and b.start()
+        try:
+            assert a.publish({"u": 7, "a": False, "p": "notification"}, '{"type":"x"}') == 1
+            await _settle()
+
+            assert got_a == []
+            [(header, frame)] = got_b
+            assert header == {"u": 7, "a": False, "p": "notification", "o": "1001"}
+            assert frame == '{"type":"x"}'
+        finally:
+            a.stop()
+            b.stop()
+        assert not any(bus_dir.iterdir())
+
+    async def test_dead_peer_socket_is_removed(self, bus_dir):
+        bus = WebSocketBus(lambda h, f: None, bus_dir)
+        assert bus.start()
+        dead = socket.socket(socket.AF_UNIX, socket.SOCK_DGRAM)
+        dead.bind(str(bus_dir / "999999.sock"))
+        dead.close()  # bound path left behind, nobody listening
+        try:
+            assert bus.publish({"p": "notification"}, "{}") == 0
+            assert not (bus_dir / "999999.sock").exists()
+        finally:
+            bus.stop()
+
+    async def test_oversized_frame_stays_local(self, bus_dir):
+        bus = WebSocketBus(lambda h, f: None, bus_dir)
+        assert bus.start()
+        try:
+            assert bus.publish({"p": "notification"}, "x" * MAX_DATAGRAM_BYTES) == 0
+        finally:
+            bus.stop()
+
+    async def test_publish_without_start_is_noop(self, bus_dir):
+        assert WebSocketBus(lambda h, f: None, bus_dir).publish({}, "{}") == 0
+
+
+@pytest.mark.asyncio
+class TestManagerOverBus:
+    async def test_remote_frame_is_delivered_to_local_targets(self):
+        manager = WebSocketManager()
+        user, admin, other = _make_ws(), _make_ws(), _make_ws()
+        await manager.connect(user, user_id=1)
+        await manager.connect(admin, user_id=2, is_admin=True)
+        await manager.connect(other, user_id=3)
+
+        frame = json.dumps({"type": "notification", "payload": {"n": 1}})
+        manager._deliver_remote({"u": 1, "a": False, "p": "notification", "o": "1002"}, frame)
+        manager._deliver_remote({"u": None, "a": True, "p": "notification"}, frame)
+        assert await manager.drain()
+
+        user.send_text.assert_awaited_once_with(frame)
+        admin.send_text.assert_awaited_once_with(frame)
+        other.send_text.assert_not_called()
+
+    async def test_broadcast_is_published_with_target(self):
+        manager = WebSocketManager()
+        bus = MagicMock()
+        bus.running = True
+        manager._bus = bus
+
+        await manager.broadcast_typed("dashboard_panel_update", {"v": 1}, admins_only=True)
+        await manager.send_unread_count(5, 2)
+
+        (h1, f1), (h2, f2) = [c.args for c in bus.publish.call_args_list]
+        assert h1 == {"u": None, "a": True, "p": "dashboard_panel_update"}
+        assert json.loads(f1) == {"type": "dashboard_panel_update", "payload": {"v": 1}}
+        assert h2 == {"u": 5, "a": False, "p": "unread_count"}
+        assert json.loads(f2)["payload"] == {"count": 2}
+
+    async def test_shutdown_leaves_bus(self, bus_dir):
+        manager = WebSocketManager()
+        assert manager.start_bus(WebSocketBus(manager._deliver_remote, bus_dir))
+        assert any(bus_dir.iterdir())
+
+        await manager.shutdown()
+
+        assert manager._bus is None
+        assert not any(bus_dir.iterdir())
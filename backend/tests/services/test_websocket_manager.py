@@ -1,5 +1,7 @@
 """Tests for services/websocket_manager.py — WebSocketManager with mock WebSockets."""
 
+import asyncio
+import json
 from unittest.mock import AsyncMock, MagicMock
 
 import pytest
@@ -7,13 +9,19 @@ import pytest
 from app.services.websocket_manager import Connection, WebSocketManager, get_websocket_manager
 
 
-def _make_ws(send_json_side_effect=None) -> MagicMock:
+def _make_ws(send_side_effect=None) -> MagicMock:
     """Create a mock WebSocket object."""
     ws = MagicMock()
-    ws.send_json = AsyncMock(side_effect=send_json_side_effect)
+    ws.send_text = AsyncMock(side_effect=send_side_effect)
+    ws.close = AsyncMock()
     return ws
 
 
+def _sent(ws: MagicMock) -> list[dict]:
+    """Frames the writer task sent, decoded."""
+    return [json.loads(call.args[0]) for call in ws.send_text.call_args_list]
+
+
 @pytest.fixture
 def manager() -> WebSocketManager:
     return WebSocketManager()
@@ -74,8 +82,9 @@ class TestBroadcastToUser:
         await manager.connect(ws, user_id=1)
         count = await manager.broadcast_to_user(1, {"msg": "hello"})
         assert count == 1
-        ws.send_json.assert_called_once()
-        payload = ws.send_json.call_args[0][0]
+        assert await manager.drain()
+        ws.send_text.assert_called_once()
+        payload = _sent(ws)[0]
         assert payload["type"] == "notification"
         assert payload["payload"] == {"msg": "hello"}
 
@@ -84,10 +93,11 @@ class TestBroadcastToUser:
         assert count == 0
 
     async def test_cleans_up_failed_connection(self, manager: WebSocketManager):
-        ws = _make_ws(send_json_side_effect=Exception("connection lost"))
+        ws = _make_ws(send_side_effect=Exception("connection lost"))
         await manager.connect(ws, user_id=1)
         count = await manager.broadcast_to_user(1, {"msg": "hello"})
-        assert count == 0
+        assert count == 1  # queued; the writer finds out
+        assert await manager.drain()
         assert not manager.is_user_connected(1)
 
 
@@ -101,8 +111,9 @@ class TestBroadcastToAdmins:
 
         count = await manager.broadcast_to_admins({"alert": "disk full"})
         assert count == 1
-        ws_admin.send_json.assert_called_once()
-        ws_user.send_json.assert_not_called()
+        assert await manager.drain()
+        ws_admin.send_text.assert_called_once()
+        ws_user.send_text.assert_not_called()
 
 
 @pytest.mark.asyncio
@@ -127,7 +138,8 @@ class TestSendUnreadCount:
         await manager.connect(ws, user_id=1)
         count = await manager.send_unread_count(1, 5)
         assert count == 1
-        payload = ws.send_json.call_args[0][0]
+        assert await manager.drain()
+        payload = _sent(ws)[0]
         assert payload["type"] == "unread_count"
         assert payload["payload"]["count"] == 5
 
@@ -203,3 +215,123 @@ async def test_connect_caps_connections_per_user():
     await mgr.connect(_FakeWS(), user_id=8)
     assert mgr.get_connection_count(7) == MAX_CONNECTIONS_PER_USER
     assert mgr.get_connection_count(8) == 1
+
+
+# ---------------------------------------------------------------------------
+# Fan-out: per-connection send queues, pre-serialised frames, topic policies
+# ---------------------------------------------------------------------------
+
+from app.services import websocket_manager as wsm
+
+
+async def _never(_):
+    await asyncio.Event().wait()
+
+
+@pytest.mark.asyncio
+class TestFanOut:
+    async def test_slow_client_does_not_stall_others(self, manager: WebSocketManager):
+        release = asyncio.Event()
+
+        async def stuck(_):
+            await release.wait()
+
+        slow, fast = _make_ws(send_side_effect=stuck), _make_ws()
+        await manager.connect(slow, user_id=1)
+        await manager.connect(fast, user_id=2)
+
+        assert await manager.broadcast_to_all({"event": "update"}) == 2
+        await asyncio.sleep(0.01)
+
+        assert _sent(fast) == [{"type": "notification", "payload": {"event": "update"}}]
+        release.set()
+        assert await manager.drain()
+        slow.send_text.assert_called_once()
+
+    async def test_frame_is_serialised_once(self, manager: WebSocketManager, monkeypatch):
+        calls = []
+        real = wsm.encode_frame
+        monkeypatch.setattr(wsm, "encode_frame", lambda *a: calls.append(a) or real(*a))
+        sockets = [_make_ws() for _ in range(4)]
+        for i, ws in enumerate(sockets):
+            await manager.connect(ws, user_id=i)
+
+        await manager.broadcast_typed("dashboard_panel_update", {"value": 1})
+        assert await manager.drain()
+
+        assert len(calls) == 1
+        texts = {ws.send_text.call_args.args[0] for ws in sockets}
+        assert len(texts) == 1
+
+    async def test_coalesced_topic_keeps_latest(self, manager: WebSocketManager):
+        release = asyncio.Event()
+
+        async def gated(_):
+            await release.wait()
+
+        ws = _make_ws(send_side_effect=gated)
+        await manager.connect(ws, user_id=1)
+        await manager.send_unread_count(1, 1)  # picked up by the writer
+        await asyncio.sleep(0)
+        for n in (2, 3, 4):
+            await manager.send_unread_count(1, n)
+
+        release.set()
+        assert await manager.drain()
+        assert [f["payload"]["count"] for f in _sent(ws)] == [1, 4]
+
+    async def test_full_queue_drops_telemetry_before_disconnecting(
+        self, manager: WebSocketManager, monkeypatch
+    ):
+        monkeypatch.setattr(wsm, "SEND_QUEUE_SIZE", 3)
+        ws = _make_ws(send_side_effect=_never)
+        conn = await manager.connect(ws, user_id=1)
+        await manager.broadcast_to_all({"n": 0}, topic="smart_device_update")
+        await asyncio.sleep(0)  # writer takes the first frame and blocks
+
+        for n in range(1, 4):
+            await manager.broadcast_to_all({"n": n}, topic="smart_device_update")
+        assert conn.pending == 3
+
+        # A notification evicts the oldest telemetry frame...
+        assert await manager.broadcast_to_user(1, {"msg": "hi"}) == 1
+        assert conn.pending == 3
+        assert conn.dropped == 1
+
+        # ...and once only reliable frames are left the client is cut off.
+        await manager.broadcast_to_user(1, {"msg": "a"})
+        await manager.broadcast_to_user(1, {"msg": "b"})
+        assert manager.is_user_connected(1)
+        assert await manager.broadcast_to_user(1, {"msg": "c"}) == 0
+        assert not manager.is_user_connected(1)
+        await asyncio.sleep(0.01)
+        ws.close.assert_awaited_once_with(code=1013)
+
+    async def test_send_timeout_marks_client_dead(self, manager: WebSocketManager, monkeypatch):
+        monkeypatch.setattr(wsm, "SEND_TIMEOUT_SECONDS", 0.01)
+        ws = _make_ws(send_side_effect=_never)
+        await manager.connect(ws, user_id=1)
+
+        await manager.broadcast_to_user(1, {"msg": "hello"})
+        await asyncio.sleep(0.05)
+
+        assert not manager.is_user_connected(1)
+
+    async def test_direct_send_uses_the_queue(self, manager: WebSocketManager):
+        ws = _make_ws()
+        conn = await manager.connect(ws, user_id=1)
+
+        assert conn.send_typed("pong", {})
+        assert await manager.drain()
+        assert _sent(ws) == [{"type": "pong", "payload": {}}]
+
+    async def test_disconnect_stops_writer(self, manager: WebSocketManager):
+        ws = _make_ws()
+        conn = await manager.connect(ws, user_id=1)
+        await manager.broadcast_to_user(1, {"msg": "hello"})
+        assert await manager.drain()
+
+        await manager.disconnect(ws)
+
+        assert conn.closed and conn._writer is None
+        assert await manager.broadcast_to_user(1, {"msg": "late"}) == 0
@@ -0,0 +1,267 @@
+"""Tests for Pi-hole query ingestion: full-drain paging, bulk load, rollups.
+
+Tests:
+- Paging until the watermark (with cursor, dedupe without one, gap cap)
+- COPY payload encoding (NULL vs empty string, quoting)
+- Incremental hourly stats and per-hour domain/client counters
+- Top domains/blocked/clients served from the counters
+- End-to-end _fetch_and_store and retention
+"""
+import asyncio
+import time
+from datetime import datetime, timedelta, timezone
+
+import pytest
+from sqlalchemy.orm import sessionmaker
+
+from app.models.dns_queries import (
+    DnsQuery,
+    DnsQueryClientHourly,
+    DnsQueryCollectorState,
+    DnsQueryDomainHourly,
+    DnsQueryHourlyStat,
+)
+from app.services.pihole import query_analytics, query_collector
+from app.services.pihole.query_collector import DnsQueryCollector
+from app.services.pihole.query_ingest import (
+    apply_batch_rollups,
+    bulk_insert_queries,
+    copy_payload,
+    hour_of,
+    normalize_query,
+)
+
+
+def _run(coro):
+    """Run an async coroutine from sync test code."""
+    loop = asyncio.new_event_loop()
+    try:
+        return loop.run_until_complete(coro)
+    finally:
+        loop.close()
+
+
+def _q(ts, domain="example.com", client="192.168.1.10", status="FORWARDED", rt=10.0, **extra):
+    return {
+        "timestamp": ts, "domain": domain, "client": client, "query_type": "A",
+        "status": status, "reply_type": "IP", "response_time": rt, **extra,
+    }
+
+
+class FakeBackend:
+    """Newest-first query log with offset paging and an optional cursor."""
+
+    def __init__(self, queries, cursor=True):
+        self.log = sorted(queries, key=lambda q: q["timestamp"], reverse=True)
+        self.cursor = cursor
+        self.calls = []
+
+    async def get_queries(self, limit=100, offset=0, *, since=None, cursor=None):
+        self.calls.append({"offset": offset, "since": since, "cursor": cursor})
+        rows = [q for q in self.log if since is None or q["timestamp"] >= int(since)]
+        return {
+            "queries": rows[offset:offset + limit],
+            "total": len(rows),
+            "cursor": 42 if self.cursor else None,
+        }
+
+
+class TestPaging:
+    def test_drains_past_the_first_page(self):
+        now = time.time()
+        backend = FakeBackend([_q(now - i) for i in range(2500)])
+
+        got, drained = _run(DnsQueryCollector()._fetch_new(backend, now - 2400.5, 0))
+
+        assert drained
+        assert len(got) == 2401
+        assert [c["offset"] for c in backend.calls] == [0, 1000, 2000]
+        assert [c["cursor"] for c in backend.calls] == [None, 42, 42]
+
+    def test_duplicates_from_shifting_offsets_are_skipped(self):
+        now = time.time()
+        backend = FakeBackend([_q(now - i) for i in range(1500)], cursor=False)
+        original = backend.get_queries
+
+        async def shifting(limit=100, offset=0, **kw):
+            # A new query arrived between the pages: page 2 repeats one row
+            return await original(limit, max(0, offset - 1), **kw)
+
+        backend.get_queries = shifting
+        got, drained = _run(DnsQueryCollector()._fetch_new(backend, 0, 0))
+
+        assert drained
+        assert len(got) == 1500
+
+    def test_backlog_beyond_the_cap_is_reported(self, monkeypatch):
+        monkeypatch.setattr(query_collector, "_MAX_PAGES_PER_POLL", 2)
+        now = time.time()
+        backend = FakeBackend([_q(now - i) for i in range(3000)])
+
+        got, drained = _run(DnsQueryCollector()._fetch_new(backend, 0, 0))
+
+        assert not drained
+        assert len(got) == 2000
+
+
+class TestCopyPayload:
+    def test_null_empty_and_quotes(self):
+        row = normalize_query(_q(0, domain='we"ird', rt=None))
+        row["reply_type"] = None
+        line = copy_payload([row]).getvalue()
+
+        assert line == '1970-01-01 00:00:00,"we""ird","192.168.1.10","A","FORWARDED",,\n'
+
+    def test_normalize_truncates_and_strips_tz(self):
+        row = normalize_query(_q(1_700_000_000.5, domain="x" * 300))
+        assert len(row["domain"]) == 253
+        assert row["timestamp"].tzinfo is None
+        assert row["response_time_ms"] == 10.0
+
+
+class TestRollups:
+    def test_batches_merge_into_hourly_stats(self, db_session):
+        base = datetime(2026, 10, 14, 12, 0, tzinfo=timezone.utc).timestamp()
+        first = [normalize_query(q) for q in (
+            _q(base + 1, "a.com", rt=10.0),
+            _q(base + 2, "ads.com", status="BLOCKED", rt=None),
+        )]
+        second = [normalize_query(q) for q in (
+            _q(base + 3, "a.com", client="10.0.0.2", rt=40.0),
+            _q(base + 4, "b.com", status="CACHED", rt=40.0),
+        )]
+        for batch in (first, second):
+            bulk_insert_queries(db_session, batch)
+            apply_batch_rollups(db_session, batch)
+        db_session.commit()
+
+        stat = db_session.query(DnsQueryHourlyStat).one()
+        assert stat.hour == datetime(2026, 10, 14, 12)
+        assert (stat.total_queries, stat.blocked_queries, stat.cached_queries, stat.forwarded_queries) == (4, 1, 1, 2)
+        assert (stat.unique_domains, stat.unique_clients) == (3, 2)
+        assert stat.timed_queries == 3
+        assert stat.avg_response_time_ms == 30.0
+        assert db_session.query(DnsQuery).count() == 4
+
+        a = db_session.get(DnsQueryDomainHourly, (datetime(2026, 10, 14, 12), "a.com"))
+        assert (a.total_queries, a.blocked_queries) == (2, 0)
+
+    def test_hours_are_separate_buckets(self, db_session):
+        base = datetime(2026, 10, 14, 12, 59, 59, tzinfo=timezone.utc).timestamp()
+        rows = [normalize_query(_q(base)), normalize_query(_q(base + 1))]
+
+        assert apply_batch_rollups(db_session, rows) == {
+            datetime(2026, 10, 14, 12), datetime(2026, 10, 14, 13),
+        }
+
+    def test_legacy_average_keeps_its_weight(self, db_session):
+        hour = datetime(2026, 10, 14, 12)
+        db_session.add(DnsQueryHourlyStat(
+            hour=hour, total_queries=3, blocked_queries=0, cached_queries=0,
+            forwarded_queries=3, avg_response_time_ms=20.0, timed_queries=0,
+        ))
+        db_session.flush()
+
+        ts = hour.replace(tzinfo=timezone.utc).timestamp() + 5
+        apply_batch_rollups(db_session, [normalize_query(_q(ts, rt=60.0))])
+
+        stat = db_session.query(DnsQueryHourlyStat).one()
+        assert stat.avg_response_time_ms == 30.0
+        assert stat.total_queries == 4
+
+
+class TestTopFromRollups:
+    def test_top_domains_blocked_and_clients(self, db_session):
+        now = time.time()
+        rows = [normalize_query(q) for q in (
+            [_q(now - 60, "a.com")] * 3
+            + [_q(now - 60, "ads.com", status="BLOCKED", client="10.0.0.9")] * 2
+            + [_q(now - 60, "b.com")]
+            + [_q(now - 3 * 86400, "old.com")] * 10
+        )]
+        apply_batch_rollups(db_session, rows)
+        db_session.commit()
+
+        top = query_analytics.get_stored_top_domains(db_session, count=2, period="24h")
+        assert [(r.domain, r.cnt) for r in top] == [("a.com", 3), ("ads.com", 2)]
+
+        blocked = query_analytics.get_stored_top_blocked(db_session, count=10, period="24h")
+        assert [(r.domain, r.cnt) for r in blocked] == [("ads.com", 2)]
+
+        clients = query_analytics.get_stored_top_clients(db_session, count=10, period="7d")
+        assert [(r.client, r.cnt) for r in clients] == [("192.168.1.10", 14), ("10.0.0.9", 2)]
+
+    def test_raw_table_is_not_read(self, db_session):
+        # Counters without raw rows (raw retention is independent)
+        db_session.add(DnsQueryClientHourly(
+            hour=hour_of(datetime.now(timezone.utc)), client="10.0.0.1",
+            total_queries=5, blocked_queries=0,
+        ))
+        db_session.commit()
+
+        rows = query_analytics.get_stored_top_clients(db_session, count=5, period="24h")
+        assert [(r.client, r.cnt) for r in rows] == [("10.0.0.1", 5)]
+
+
+class TestFetchAndStore:
+    @pytest.fixture
+    def collector(self, db_session, monkeypatch):
+        collector = DnsQueryCollector()
+        collector._db_factory = sessionmaker(bind=db_session.get_bind())
+        db_session.add(DnsQueryCollectorState(id=1, last_fetched_timestamp=0.0, retention_days=30))
+        db_session.commit()
+        return collector
+
+    def _use_backend(self, monkeypatch, backend):
+        from app.services.pihole import service as pihole_service
+
+        class _Service:
+            def _get_backend(self):
+                return backend
+
+        monkeypatch.setattr(pihole_service, "get_pihole_service", lambda db: _Service())
+
+    def test_stores_everything_and_advances_watermark(self, collector, db_session, monkeypatch):
+        now = time.time()
+        backend = FakeBackend([_q(now - i) for i in range(1200)] + [_q(now - 40 * 86400)])
+        self._use_backend(monkeypatch, backend)
+
+        _run(collector._fetch_and_store())
+
+        db_session.expire_all()
+        state = db_session.get(DnsQueryCollectorState, 1)
+        assert db_session.query(DnsQuery).count() == 1200  # 40 days old: past retention
+        assert state.total_queries_stored == 1200
+        assert state.last_fetched_timestamp == pytest.approx(now)
+        assert sum(s.total_queries for s in db_session.query(DnsQueryHourlyStat)) == 1200
+        assert backend.calls[0]["since"] == pytest.approx(now - 30 * 86400, abs=5)
+
+        # Next poll: nothing new
+        _run(collector._fetch_and_store())
+        db_session.expire_all()
+        assert db_session.query(DnsQuery).count() == 1200
+
+    def test_failed_load_keeps_the_watermark(self, collector, db_session, monkeypatch):
+        self._use_backend(monkeypatch, FakeBackend([_q(time.time())]))
+
+        def boom(db, rows):
+            raise RuntimeError("copy failed")
+
+        monkeypatch.setattr(query_collector, "apply_batch_rollups", boom)
+        with pytest.raises(RuntimeError):
+            _run(collector._fetch_and_store())
+
+        db_session.expire_all()
+        assert db_session.get(DnsQueryCollectorState, 1).last_fetched_timestamp == 0.0
+        assert db_session.query(DnsQuery).count() == 0
+
+    def test_retention_drops_old_counters(self, collector, db_session):
+        old = datetime.now(timezone.utc) - timedelta(days=45)
+        apply_batch_rollups(db_session, [normalize_query(_q(old.timestamp()))])
+        db_session.commit()
+
+        collector._run_retention()
+
+        db_session.expire_all()
+        assert db_session.query(DnsQueryDomainHourly).count() == 0
+        assert db_session.query(DnsQueryClientHourly).count() == 0
@@ -0,0 +1,230 @@
+"""Tests for the WebDAV worker fast paths (compat/webdav_fastpath.py)."""
+import io
+import os
+from pathlib import Path
+
+import pytest
+
+import app.services.files.path_utils as path_utils
+from app.compat.webdav_fastpath import (
+    FileRange,
+    WebdavFastPath,
+    _parse_range,
+    _ReadAheadInput,
+)
+from app.compat.webdav_provider import BaluHostDAVProvider
+from app.services.files import folder_size
+
+ADMIN_ENV = {"baluhost.user_role": "admin", "wsgidav.auth.user_name": "root"}
+USER_ENV = {"baluhost.user_role": "user", "wsgidav.auth.user_name": "bob"}
+
+
+class _Downstream:
+    """Stands in for WsgiDAV's request handling and records what reached it."""
+
+    def __init__(self):
+        self.calls: list[tuple[str, str]] = []
+        self.propfind_body = b"<D:multistatus/>"
+
+    def __call__(self, environ, start_response):
+        method = environ["REQUEST_METHOD"]
+        self.calls.append((method, environ["PATH_INFO"]))
+        environ["wsgi.input"].read()
+        if method == "PROPFIND":
+            start_response("207 Multi-Status", [
+                ("Content-Type", "application/xml"), ("Date", "Thu, 01 Jan 2026 00:00:00 GMT"),
+            ])
+            return [self.propfind_body]
+        start_response("204 No Content", [])
+        return [b""]
+
+
+@pytest.fixture
+def storage(tmp_path: Path, monkeypatch) -> Path:
+    root = tmp_path / "storage"
+    (root / "docs").mkdir(parents=True)
+    (root / "docs" / "a.txt").write_bytes(b"0123456789")
+    monkeypatch.setattr(path_utils, "ROOT_DIR", root)
+    return root
+
+
+@pytest.fixture
+def fast_path(storage: Path):
+    downstream = _Downstream()
+    mw = WebdavFastPath(None, downstream, {"provider_mapping": {"/": BaluHostDAVProvider(str(storage))}})
+    yield mw, downstream
+    folder_size.get_folder_size_index().close()
+
+
+def _call(mw, method: str, path: str, env=ADMIN_ENV, body: bytes = b"", **headers):
+    environ = {
+        "REQUEST_METHOD": method,
+        "PATH_INFO": path,
+        "wsgi.input": io.BytesIO(body),
+        "CONTENT_LENGTH": str(len(body)),
+        **env,
+        **{f"HTTP_{name.upper()}": value for name, value in headers.items()},
+    }
+    response: dict = {}
+
+    def start_response(status, response_headers, exc_info=None):
+        response["status"], response["headers"] = status, dict(response_headers)
+
+    result = mw(environ, start_response)
+    response["result"] = result
+    response["body"] = b"".join(result)
+    if hasattr(result, "close"):
+        result.close()
+    return response
+
+
+def _propfind(mw, path="/docs", env=ADMIN_ENV):
+    return _call(mw, "PROPFIND", path, env, body=b"<propfind><allprop/></propfind>", depth="1")
+
+
+class TestPropfindCache:
+    def test_repeated_propfind_is_served_from_cache(self, fast_path):
+        mw, downstream = fast_path
+        first = _propfind(mw)
+        second = _propfind(mw)
+
+        assert downstream.calls == [("PROPFIND", "/docs")]
+        assert second["status"] == "207 Multi-Status"
+        assert second["body"] == first["body"]
+        assert second["headers"]["Date"] != "Thu, 01 Jan 2026 00:00:00 GMT"
+        assert mw.cache.hits == 1
+
+    def test_cache_is_per_user_and_depth(self, fast_path, storage):
+        mw, downstream = fast_path
+        (storage / "bob" / "docs").mkdir(parents=True)
+        _propfind(mw)
+        _propfind(mw, env=USER_ENV)
+        _call(mw, "PROPFIND", "/docs", depth="0")
+        _call(mw, "PROPFIND", "/docs", depth="infinity")
+        assert len(downstream.calls) == 4
+
+    def test_new_member_invalidates_listing(self, fast_path, storage):
+        mw, downstream = fast_path
+        _propfind(mw)
+        (storage / "docs" / "b.txt").write_bytes(b"new")
+        _propfind(mw)
+        assert len(downstream.calls) == 2
+
+    def test_change_log_invalidates_listing(self, fast_path, storage):
+        mw, downstream = fast_path
+        _propfind(mw)  # also starts following the change log
+        # Content change: the folder's mtime stays, the index reports it
+        (storage / "docs" / "a.txt").write_bytes(b"changed over SMB")
+        folder_size.invalidate_folder_sizes_for_path(storage / "docs", storage)
+        mw.cache._last_sync = 0.0
+        _propfind(mw)
+        assert len(downstream.calls) == 2
+
+    def test_own_writes_invalidate_and_update_folder_sizes(self, fast_path, storage):
+        mw, downstream = fast_path
+        index = folder_size.get_folder_size_index()
+        _propfind(mw)
+        cursor = index.change_cursor()
+
+        _call(mw, "PUT", "/docs/a.txt", body=b"new content")
+        _propfind(mw)
+
+        assert [c[0] for c in downstream.calls] == ["PROPFIND", "PUT", "PROPFIND"]
+        assert "docs" in index.changes_since(cursor)[1]
+
+    def test_move_invalidates_source_and_destination(self, fast_path, storage):
+        mw, downstream = fast_path
+        (storage / "other").mkdir()
+        _propfind(mw, "/docs")
+        _propfind(mw, "/other")
+        _call(mw, "MOVE", "/docs/a.txt", destination="http://nas:8080/other/a.txt")
+        _propfind(mw, "/docs")
+        _propfind(mw, "/other")
+        assert len(downstream.calls) == 5
+
+    def test_active_locks_are_not_cached(self, fast_path):
+        mw, downstream = fast_path
+        downstream.propfind_body = b"<D:multistatus><D:activelock/></D:multistatus>"
+        _propfind(mw)
+        _propfind(mw)
+        assert len(downstream.calls) == 2
+
+
+class TestGet:
+    def test_get_returns_file_range(self, fast_path):
+        mw, downstream = fast_path
+        response = _call(mw, "GET", "/docs/a.txt")
+
+        assert isinstance(response["result"], FileRange)
+        assert response["status"] == "200 OK"
+        assert response["body"] == b"0123456789"
+        assert response["headers"]["Content-Length"] == "10"
+        assert response["headers"]["ETag"].startswith('"')
+        assert downstream.calls == []
+
+    def test_single_range(self, fast_path):
+        mw, _ = fast_path
+        response = _call(mw, "GET", "/docs/a.txt", range="bytes=2-5")
+        assert response["status"] == "206 Partial Content"
+        assert response["body"] == b"2345"
+        assert response["headers"]["Content-Range"] == "bytes 2-5/10"
+
+    def test_head_sends_no_body(self, fast_path):
+        mw, _ = fast_path
+        response = _call(mw, "HEAD", "/docs/a.txt")
+        assert response["headers"]["Content-Length"] == "10"
+        assert response["body"] == b""
+
+    @pytest.mark.parametrize("headers", [
+        {"range": "bytes=0-1,4-5"},
+        {"if_none_match": '"abc"'},
+        {"if_modified_since": "Thu, 01 Jan 2026 00:00:00 GMT"},
+    ])
+    def test_unusual_requests_go_to_wsgidav(self, fast_path, headers):
+        mw, downstream = fast_path
+        _call(mw, "GET", "/docs/a.txt", **headers)
+        assert downstream.calls == [("GET", "/docs/a.txt")]
+
+    def test_collections_and_traversal_go_to_wsgidav(self, fast_path):
+        mw, downstream = fast_path
+        _call(mw, "GET", "/docs")
+        _call(mw, "GET", "/../etc/passwd", env=USER_ENV)
+        assert len(downstream.calls) == 2
+
+
+def test_parse_range():
+    assert _parse_range("bytes=0-3", 10) == (0, 4)
+    assert _parse_range("bytes=7-", 10) == (7, 3)
+    assert _parse_range("bytes=-4", 10) == (6, 4)
+    assert _parse_range("bytes=5-100", 10) == (5, 5)
+    assert _parse_range("bytes=10-12", 10) is None
+    assert _parse_range("bytes=0-1,3-4", 10) is None
+    assert _parse_range("items=0-1", 10) is None
+
+
+def test_read_ahead_input_reads_in_large_blocks():
+    data = os.urandom(3 * 1024 * 1024 + 17)
+    reads = []
+
+    class _Raw(io.BytesIO):
+        def read(self, size=-1):
+            reads.append(size)
+            return super().read(size)
+
+    stream = _ReadAheadInput(_Raw(data), len(data))
+    out = bytearray()
+    while chunk := stream.read(8192):
+        out += chunk
+    assert bytes(out) == data
+    assert len(reads) == 4
+
+
+def test_member_list_skips_broken_symlinks(storage):
+    try:
+        (storage / "docs" / "dangling").symlink_to(storage / "missing")
+    except (OSError, NotImplementedError):
+        pytest.skip("symlink creation not permitted on this platform")
+    provider = BaluHostDAVProvider(str(storage))
+    environ = {"wsgidav.provider": provider, **ADMIN_ENV}
+    folder = provider.get_resource_inst("/docs", environ)
+    assert [m.name for m in folder.get_member_list()] == ["a.txt"]
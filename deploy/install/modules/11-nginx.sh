@@ -11,6 +11,10 @@ SITES_AVAILABLE="/etc/nginx/sites-available/baluhost"
 SITES_ENABLED="/etc/nginx/sites-enabled/baluhost"
 DEFAULT_SITE="/etc/nginx/sites-enabled/default"
 SERVER_NAME="${SERVER_NAME:-baluhost.local localhost _}"
+# Roots of the X-Accel-Redirect download locations (backend settings
+# nas_storage_path and the SSD file cache base)
+STORAGE_ROOT="${NAS_STORAGE_PATH:-$INSTALL_DIR/backend/storage}"
+CACHE_ROOT="${SSD_CACHE_ROOT:-/mnt/cache-vcl/filecache}"
 
 # ─── Main ───────────────────────────────────────────────────────────
 
@@ -38,10 +42,13 @@ log_step "Generating Nginx Config"
 
 log_info "Server name: $SERVER_NAME"
 log_info "Frontend root: $FRONTEND_STATIC_DIR"
+log_info "Download roots: $STORAGE_ROOT, $CACHE_ROOT"
 
 process_template "$TEMPLATE" "$SITES_AVAILABLE" \
     "FRONTEND_ROOT=$FRONTEND_STATIC_DIR" \
-    "SERVER_NAME=$SERVER_NAME"
+    "SERVER_NAME=$SERVER_NAME" \
+    "STORAGE_ROOT=${STORAGE_ROOT%/}" \
+    "CACHE_ROOT=${CACHE_ROOT%/}"
 
 log_info "Config written to $SITES_AVAILABLE."
 